@@ -29,6 +29,11 @@
 /* #define JANET_NO_PEG */
 /* #define JANET_NO_NET */
 /* #define JANET_NO_INT_TYPES */
+/* #define JANET_NO_TYPED_ARRAY */
+/* #define JANET_NO_PERSISTENT */
+/* #define JANET_NO_JSON */
+/* #define JANET_NO_MMAP */
+/* #define JANET_NO_SIMD */
 /* #define JANET_NO_EV */
 /* #define JANET_NO_FILEWATCH */
 /* #define JANET_NO_REALPATH */
@@ -41,6 +46,11 @@
 /* Other settings */
 /* #define JANET_DEBUG */
 /* #define JANET_PRF */
+/* #define JANET_GC_SLAB */
+/* #define JANET_GC_THREADS 4 */
+/* #define JANET_JIT */
+/* #define JANET_JIT_THRESHOLD 1000 */
+/* #define JANET_PROFILE */
 /* #define JANET_NO_UTC_MKTIME */
 /* #define JANET_OUT_OF_MEMORY do { printf("janet out of memory\n"); exit(1); } while (0) */
 /* #define JANET_EXIT(msg) do { printf("C assert failed executing janet: %s\n", msg); exit(1); } while (0) */
@@ -48,10 +58,14 @@
 /* #define JANET_RECURSION_GUARD 1024 */
 /* #define JANET_MAX_PROTO_DEPTH 200 */
 /* #define JANET_MAX_MACRO_EXPAND 200 */
+/* #define JANET_INLINE_MAX 12 */
 /* #define JANET_STACK_MAX 16384 */
+/* #define JANET_FIBER_POOL_MAX 1024 */
 /* #define JANET_OS_NAME my-custom-os */
 /* #define JANET_ARCH_NAME pdp-8 */
 /* #define JANET_EV_NO_EPOLL */
+/* #define JANET_EV_IO_URING */
+/* #define JANET_EV_TIMER_WHEEL */
 /* #define JANET_EV_NO_KQUEUE */
 /* #define JANET_NO_INTERPRETER_INTERRUPT */
 /* #define JANET_NO_IPV6 */
@@ -26,6 +26,7 @@
 #include "gc.h"
 #include "util.h"
 #include "state.h"
+#include "compile.h"
 #endif
 
 #include <string.h>
@@ -111,6 +112,7 @@ void janet_array_push(JanetArray *array, Janet x) {
     janet_array_ensure(array, newcount, 2);
     array->data[array->count] = x;
     array->count = newcount;
+    janet_gc_barrier(array);
 }
 
 /* Pop a value from the top of the array */
@@ -176,6 +178,7 @@ JANET_CORE_FN(cfun_array_fill,
     for (int32_t i = 0; i < array->count; i++) {
         array->data[i] = x;
     }
+    janet_gc_barrier(array);
     return argv[0];
 }
 
@@ -208,6 +211,7 @@ JANET_CORE_FN(cfun_array_push,
     janet_array_ensure(array, newcount, 2);
     if (argc > 1) memcpy(array->data + array->count, argv + 1, (size_t)(argc - 1) * sizeof(Janet));
     array->count = newcount;
+    janet_gc_barrier(array);
     return argv[0];
 }
 
@@ -328,6 +332,7 @@ JANET_CORE_FN(cfun_array_insert,
     }
     safe_memcpy(array->data + at, argv + 2, chunksize);
     array->count += (argc - 2);
+    janet_gc_barrier(array);
     return argv[0];
 }
 
@@ -393,6 +398,157 @@ JANET_CORE_FN(cfun_array_clear,
     return argv[0];
 }
 
+/* Stable merge sort. Elements are sorted as key/value pairs so that key
+ * functions are called once per element rather than once per comparison.
+ * The comparisons against the core `<` and `>` functions go straight to
+ * janet_compare without entering the VM. */
+
+#define JANET_SORT_RUN 16
+
+typedef enum {
+    JANET_SORT_ASC,
+    JANET_SORT_DESC,
+    JANET_SORT_CALL
+} JanetSortMode;
+
+typedef struct {
+    JanetSortMode mode;
+    Janet before;
+} JanetSorter;
+
+static JanetSorter sort_sorter(int32_t argc, Janet *argv, int32_t n) {
+    JanetSorter sorter;
+    sorter.mode = JANET_SORT_ASC;
+    sorter.before = janet_wrap_nil();
+    if (argc > n && !janet_checktype(argv[n], JANET_NIL)) {
+        sorter.before = argv[n];
+        sorter.mode = JANET_SORT_CALL;
+        if (janet_checktype(argv[n], JANET_FUNCTION)) {
+            int32_t tag = janet_unwrap_function(argv[n])->def->flags & JANET_FUNCDEF_FLAG_TAG;
+            if (tag == JANET_FUN_LT) sorter.mode = JANET_SORT_ASC;
+            if (tag == JANET_FUN_GT) sorter.mode = JANET_SORT_DESC;
+        }
+    }
+    return sorter;
+}
+
+static int sort_before(const JanetSorter *sorter, Janet x, Janet y) {
+    switch (sorter->mode) {
+        case JANET_SORT_ASC:
+            if (janet_checktype(x, JANET_NUMBER) && janet_checktype(y, JANET_NUMBER)) {
+                return janet_unwrap_number(x) < janet_unwrap_number(y);
+            }
+            return janet_compare(x, y) < 0;
+        case JANET_SORT_DESC:
+            if (janet_checktype(x, JANET_NUMBER) && janet_checktype(y, JANET_NUMBER)) {
+                return janet_unwrap_number(x) > janet_unwrap_number(y);
+            }
+            return janet_compare(x, y) > 0;
+        default: {
+            Janet args[2] = {x, y};
+            Janet result = janet_method_invoke(sorter->before, 2, args);
+            return janet_truthy(result);
+        }
+    }
+}
+
+static void sort_insertion(const JanetSorter *sorter, JanetKV *items, int32_t lo, int32_t hi) {
+    for (int32_t i = lo + 1; i < hi; i++) {
+        JanetKV item = items[i];
+        int32_t j = i;
+        while (j > lo && sort_before(sorter, item.key, items[j - 1].key)) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = item;
+    }
+}
+
+static void sort_merge(const JanetSorter *sorter, JanetKV *items, JanetKV *tmp,
+                       int32_t lo, int32_t mid, int32_t hi) {
+    /* Already in order, common for presorted input */
+    if (!sort_before(sorter, items[mid].key, items[mid - 1].key)) return;
+    int32_t left = mid - lo;
+    memcpy(tmp, items + lo, sizeof(JanetKV) * (size_t) left);
+    int32_t i = 0, j = mid, k = lo;
+    while (i < left && j < hi) {
+        /* Take from the right only when strictly before, keeping the sort stable */
+        if (sort_before(sorter, items[j].key, tmp[i].key)) {
+            items[k++] = items[j++];
+        } else {
+            items[k++] = tmp[i++];
+        }
+    }
+    while (i < left) {
+        items[k++] = tmp[i++];
+    }
+}
+
+static void sort_items(const JanetSorter *sorter, JanetKV *items, int32_t n) {
+    for (int32_t lo = 0; lo < n; lo += JANET_SORT_RUN) {
+        int32_t hi = lo + JANET_SORT_RUN;
+        sort_insertion(sorter, items, lo, hi < n ? hi : n);
+    }
+    if (n <= JANET_SORT_RUN) return;
+    JanetKV *tmp = janet_smalloc(sizeof(JanetKV) * (size_t) n);
+    for (int32_t width = JANET_SORT_RUN; width < n; width *= 2) {
+        for (int32_t lo = 0; lo + width < n; lo += 2 * width) {
+            int32_t mid = lo + width;
+            int32_t hi = (n - mid > width) ? mid + width : n;
+            sort_merge(sorter, items, tmp, lo, mid, hi);
+        }
+        if (width > INT32_MAX / 2) break;
+    }
+    janet_sfree(tmp);
+}
+
+/* Sort the array in place. When keyfn is not nil, compare the results of
+ * calling it on each element instead of the elements themselves. Calling
+ * back into the VM may move the fiber stack, so argv must not be used
+ * after sorting. */
+static void sort_array(JanetArray *array, const JanetSorter *sorter, Janet keyfn) {
+    int32_t n = array->count;
+    if (n < 2) return;
+    JanetKV *items = janet_smalloc(sizeof(JanetKV) * (size_t) n);
+    for (int32_t i = 0; i < n; i++) {
+        Janet x = array->data[i];
+        items[i].value = x;
+        items[i].key = janet_checktype(keyfn, JANET_NIL) ? x : janet_method_invoke(keyfn, 1, &x);
+    }
+    sort_items(sorter, items, n);
+    /* The comparator or key function may have changed the array; only write
+     * back over elements that still exist. */
+    if (array->count < n) n = array->count;
+    for (int32_t i = 0; i < n; i++) {
+        array->data[i] = items[i].value;
+    }
+    janet_sfree(items);
+}
+
+JANET_CORE_FN(cfun_array_sort,
+              "(array/sort arr &opt before?)",
+              "Sorts `arr` in place with a stable merge sort, and returns it. If a `before?` "
+              "comparator is provided, sorts elements using that, otherwise uses `<`. "
+              "Comparing with `<` or `>` does not call into the VM.") {
+    janet_arity(argc, 1, 2);
+    JanetArray *array = janet_getarray(argv, 0);
+    JanetSorter sorter = sort_sorter(argc, argv, 1);
+    sort_array(array, &sorter, janet_wrap_nil());
+    return janet_wrap_array(array);
+}
+
+JANET_CORE_FN(cfun_array_sort_by,
+              "(array/sort-by arr f &opt before?)",
+              "Sorts `arr` in place with a stable merge sort by comparing `(f x)` for each element "
+              "`x`, and returns it. `f` is called exactly once per element. If a `before?` "
+              "comparator is provided, compares keys using that, otherwise uses `<`.") {
+    janet_arity(argc, 2, 3);
+    JanetArray *array = janet_getarray(argv, 0);
+    JanetSorter sorter = sort_sorter(argc, argv, 2);
+    sort_array(array, &sorter, argv[1]);
+    return janet_wrap_array(array);
+}
+
 /* Load the array module */
 void janet_lib_array(JanetTable *env) {
     JanetRegExt array_cfuns[] = {
@@ -411,6 +567,8 @@ void janet_lib_array(JanetTable *env) {
         JANET_CORE_REG("array/trim", cfun_array_trim),
         JANET_CORE_REG("array/clear", cfun_array_clear),
         JANET_CORE_REG("array/join", cfun_array_join),
+        JANET_CORE_REG("array/sort", cfun_array_sort),
+        JANET_CORE_REG("array/sort-by", cfun_array_sort_by),
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, array_cfuns);
@@ -79,12 +79,17 @@ static const JanetInstructionDef janet_ops[] = {
     {"divim", JOP_DIVIDE_IMMEDIATE},
     {"eq", JOP_EQUALS},
     {"eqim", JOP_EQUALS_IMMEDIATE},
+    {"eqimjmpno", JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT},
+    {"eqjmpno", JOP_EQUALS_JUMP_IF_NOT},
     {"err", JOP_ERROR},
     {"get", JOP_GET},
     {"geti", JOP_GET_INDEX},
     {"gt", JOP_GREATER_THAN},
     {"gte", JOP_GREATER_THAN_EQUAL},
+    {"gtejmpno", JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT},
     {"gtim", JOP_GREATER_THAN_IMMEDIATE},
+    {"gtimjmpno", JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT},
+    {"gtjmpno", JOP_GREATER_THAN_JUMP_IF_NOT},
     {"in", JOP_IN},
     {"jmp", JOP_JUMP},
     {"jmpif", JOP_JUMP_IF},
@@ -92,8 +97,11 @@ static const JanetInstructionDef janet_ops[] = {
     {"jmpnn", JOP_JUMP_IF_NOT_NIL},
     {"jmpno", JOP_JUMP_IF_NOT},
     {"ldc", JOP_LOAD_CONSTANT},
+    {"ldcpush", JOP_LOAD_CONSTANT_PUSH},
     {"ldf", JOP_LOAD_FALSE},
     {"ldi", JOP_LOAD_INTEGER},
+    {"ldiget", JOP_LOAD_INTEGER_GET},
+    {"ldiin", JOP_LOAD_INTEGER_IN},
     {"ldn", JOP_LOAD_NIL},
     {"lds", JOP_LOAD_SELF},
     {"ldt", JOP_LOAD_TRUE},
@@ -101,7 +109,10 @@ static const JanetInstructionDef janet_ops[] = {
     {"len", JOP_LENGTH},
     {"lt", JOP_LESS_THAN},
     {"lte", JOP_LESS_THAN_EQUAL},
+    {"ltejmpno", JOP_LESS_THAN_EQUAL_JUMP_IF_NOT},
     {"ltim", JOP_LESS_THAN_IMMEDIATE},
+    {"ltimjmpno", JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT},
+    {"ltjmpno", JOP_LESS_THAN_JUMP_IF_NOT},
     {"mkarr", JOP_MAKE_ARRAY},
     {"mkbtp", JOP_MAKE_BRACKET_TUPLE},
     {"mkbuf", JOP_MAKE_BUFFER},
@@ -116,6 +127,8 @@ static const JanetInstructionDef janet_ops[] = {
     {"mulim", JOP_MULTIPLY_IMMEDIATE},
     {"neq", JOP_NOT_EQUALS},
     {"neqim", JOP_NOT_EQUALS_IMMEDIATE},
+    {"neqimjmpno", JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT},
+    {"neqjmpno", JOP_NOT_EQUALS_JUMP_IF_NOT},
     {"next", JOP_NEXT},
     {"noop", JOP_NOOP},
     {"prop", JOP_PROPAGATE},
@@ -139,6 +152,7 @@ static const JanetInstructionDef janet_ops[] = {
     {"sruim", JOP_SHIFT_RIGHT_UNSIGNED_IMMEDIATE},
     {"sub", JOP_SUBTRACT},
     {"subim", JOP_SUBTRACT_IMMEDIATE},
+    {"switch", JOP_SWITCH},
     {"tcall", JOP_TAILCALL},
     {"tchck", JOP_TYPECHECK}
 };
@@ -823,6 +837,12 @@ static const JanetInstructionDef *janet_asm_reverse_lookup(uint32_t instr) {
     return NULL;
 }
 
+/* Get the assembler name of an opcode, or NULL */
+const char *janet_opcode_name(uint32_t opcode) {
+    const JanetInstructionDef *def = janet_asm_reverse_lookup(opcode);
+    return NULL == def ? NULL : def->name;
+}
+
 /* Create some constant sized tuples */
 static const Janet *tup1(Janet x) {
     Janet *tup = janet_tuple_begin(1);
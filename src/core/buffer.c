@@ -250,6 +250,32 @@ JANET_CORE_FN(cfun_buffer_fill,
     return argv[0];
 }
 
+JANET_CORE_FN(cfun_buffer_map_bytes,
+              "(buffer/map-bytes buffer from to)",
+              "Translate the bytes of a buffer in place. Every byte that occurs in `from` is replaced "
+              "by the byte at the same index in `to`; other bytes are left unchanged. `from` and `to` "
+              "must have the same length. Returns the modified buffer.") {
+    janet_fixarity(argc, 3);
+    JanetBuffer *buffer = janet_getbuffer(argv, 0);
+    JanetByteView from = janet_getbytes(argv, 1);
+    JanetByteView to = janet_getbytes(argv, 2);
+    if (from.len != to.len) {
+        janet_panicf("expected from and to to have the same length, got %d and %d", from.len, to.len);
+    }
+    uint8_t table[256];
+    for (int i = 0; i < 256; i++) {
+        table[i] = (uint8_t) i;
+    }
+    for (int32_t i = 0; i < from.len; i++) {
+        table[from.bytes[i]] = to.bytes[i];
+    }
+    uint8_t *data = buffer->data;
+    for (int32_t i = 0; i < buffer->count; i++) {
+        data[i] = table[data[i]];
+    }
+    return argv[0];
+}
+
 JANET_CORE_FN(cfun_buffer_trim,
               "(buffer/trim buffer)",
               "Set the backing capacity of the buffer to the current length of the buffer. Returns the "
@@ -666,12 +692,150 @@ JANET_CORE_FN(cfun_buffer_format_at,
     return argv[0];
 }
 
+/* Byte slices - zero copy views into a string, buffer, or any other value
+ * with a byte view. The parent is fetched again on each access, so a slice
+ * of a buffer sees later writes, and is clamped if the buffer shrinks. */
+
+static int byteslice_gcmark(void *p, size_t s) {
+    (void) s;
+    JanetByteSlice *slice = p;
+    janet_mark(slice->parent);
+    return 0;
+}
+
+static JanetByteView byteslice_bytes(void *p, size_t s) {
+    (void) s;
+    JanetByteSlice *slice = p;
+    JanetByteView view;
+    const uint8_t *data = NULL;
+    int32_t len = 0;
+    janet_bytes_view(slice->parent, &data, &len);
+    int32_t start = slice->offset < len ? slice->offset : len;
+    int32_t end = slice->offset + slice->length < len ? slice->offset + slice->length : len;
+    view.bytes = data + start;
+    view.len = end - start;
+    return view;
+}
+
+static size_t byteslice_length(void *p, size_t s) {
+    return (size_t) byteslice_bytes(p, s).len;
+}
+
+static int byteslice_get(void *p, Janet key, Janet *out) {
+    if (!janet_checkint(key)) return 0;
+    int32_t index = janet_unwrap_integer(key);
+    JanetByteView view = byteslice_bytes(p, 0);
+    if (index < 0 || index >= view.len) return 0;
+    *out = janet_wrap_integer(view.bytes[index]);
+    return 1;
+}
+
+static Janet byteslice_next(void *p, Janet key) {
+    int32_t index = 0;
+    if (!janet_checktype(key, JANET_NIL)) {
+        if (!janet_checkint(key)) janet_panicf("expected integer key, got %v", key);
+        index = janet_unwrap_integer(key) + 1;
+    }
+    if (index < 0 || index >= byteslice_bytes(p, 0).len) return janet_wrap_nil();
+    return janet_wrap_integer(index);
+}
+
+static void byteslice_tostring(void *p, JanetBuffer *buffer) {
+    JanetByteView view = byteslice_bytes(p, 0);
+    janet_buffer_push_bytes(buffer, view.bytes, view.len);
+}
+
+static void byteslice_marshal(void *p, JanetMarshalContext *ctx) {
+    JanetByteSlice *slice = p;
+    janet_marshal_abstract(ctx, p);
+    janet_marshal_janet(ctx, slice->parent);
+    janet_marshal_int(ctx, slice->offset);
+    janet_marshal_int(ctx, slice->length);
+}
+
+static void *byteslice_unmarshal(JanetMarshalContext *ctx) {
+    JanetByteSlice *slice = janet_unmarshal_abstract(ctx, sizeof(JanetByteSlice));
+    slice->parent = janet_wrap_nil();
+    slice->offset = 0;
+    slice->length = 0;
+    Janet parent = janet_unmarshal_janet(ctx);
+    const uint8_t *data;
+    int32_t len;
+    if (!janet_bytes_view(parent, &data, &len)) {
+        janet_panicf("expected bytes for byte slice parent, got %v", parent);
+    }
+    int32_t offset = janet_unmarshal_int(ctx);
+    int32_t length = janet_unmarshal_int(ctx);
+    if (offset < 0 || length < 0) janet_panic("invalid byte slice");
+    slice->parent = parent;
+    slice->offset = offset;
+    slice->length = length;
+    return slice;
+}
+
+const JanetAbstractType janet_byteslice_type = {
+    "core/byte-slice",
+    NULL,
+    byteslice_gcmark,
+    byteslice_get,
+    NULL,
+    byteslice_marshal,
+    byteslice_unmarshal,
+    byteslice_tostring,
+    NULL,
+    NULL,
+    byteslice_next,
+    NULL,
+    byteslice_length,
+    byteslice_bytes,
+    NULL
+};
+
+JanetByteSlice *janet_byteslice(Janet parent, int32_t offset, int32_t length) {
+    const uint8_t *data;
+    int32_t len;
+    if (!janet_bytes_view(parent, &data, &len)) {
+        janet_panicf("expected bytes, got %v", parent);
+    }
+    if (offset < 0 || length < 0 || offset > len - length) {
+        janet_panicf("byte slice [%d, %d) out of range for %v", offset, offset + length, parent);
+    }
+    /* Don't nest slices, point straight at the original parent */
+    if (janet_checkabstract(parent, &janet_byteslice_type)) {
+        JanetByteSlice *inner = janet_unwrap_abstract(parent);
+        parent = inner->parent;
+        offset += inner->offset;
+    }
+    JanetByteSlice *slice = janet_abstract(&janet_byteslice_type, sizeof(JanetByteSlice));
+    slice->parent = parent;
+    slice->offset = offset;
+    slice->length = length;
+    return slice;
+}
+
+JANET_CORE_FN(cfun_bytes_view,
+              "(bytes/view bytes &opt start end)",
+              "Create a view of a byte sequence from `start` to `end` without copying. "
+              "The range is half open and indexes can be negative, as with `buffer/slice`. "
+              "The view keeps `bytes` alive and can be used anywhere a string or buffer is "
+              "accepted, such as `peg/match`, `string/find`, `file/write`, and `net/write`. "
+              "A view of a buffer sees later changes to the buffer, and shrinks if the "
+              "buffer does. Use `string` to copy the contents out of a view.") {
+    janet_arity(argc, 1, 3);
+    JanetByteView view = janet_getbytes(argv, 0);
+    int32_t start = janet_getstartrange(argv, argc, 1, view.len);
+    int32_t end = janet_getendrange(argv, argc, 2, view.len);
+    if (end < start) end = start;
+    return janet_wrap_abstract(janet_byteslice(argv[0], start, end - start));
+}
+
 void janet_lib_buffer(JanetTable *env) {
     JanetRegExt buffer_cfuns[] = {
         JANET_CORE_REG("buffer/new", cfun_buffer_new),
         JANET_CORE_REG("buffer/new-filled", cfun_buffer_new_filled),
         JANET_CORE_REG("buffer/from-bytes", cfun_buffer_frombytes),
         JANET_CORE_REG("buffer/fill", cfun_buffer_fill),
+        JANET_CORE_REG("buffer/map-bytes", cfun_buffer_map_bytes),
         JANET_CORE_REG("buffer/trim", cfun_buffer_trim),
         JANET_CORE_REG("buffer/push-byte", cfun_buffer_u8),
         JANET_CORE_REG("buffer/push-word", cfun_buffer_word),
@@ -693,7 +857,9 @@ void janet_lib_buffer(JanetTable *env) {
         JANET_CORE_REG("buffer/blit", cfun_buffer_blit),
         JANET_CORE_REG("buffer/format", cfun_buffer_format),
         JANET_CORE_REG("buffer/format-at", cfun_buffer_format_at),
+        JANET_CORE_REG("bytes/view", cfun_bytes_view),
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, buffer_cfuns);
+    janet_register_abstract_type(&janet_byteslice_type);
 }
@@ -106,9 +106,202 @@ enum JanetInstructionType janet_instructions[JOP_INSTRUCTION_COUNT] = {
     JINT_SSS, /* JOP_NEXT */
     JINT_SSS, /* JOP_NOT_EQUALS, */
     JINT_SSI, /* JOP_NOT_EQUALS_IMMEDIATE, */
-    JINT_SSS /* JOP_CANCEL, */
+    JINT_SSS, /* JOP_CANCEL, */
+    JINT_SSS, /* JOP_LESS_THAN_JUMP_IF_NOT */
+    JINT_SSS, /* JOP_LESS_THAN_EQUAL_JUMP_IF_NOT */
+    JINT_SSI, /* JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT */
+    JINT_SSS, /* JOP_GREATER_THAN_JUMP_IF_NOT */
+    JINT_SSS, /* JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT */
+    JINT_SSI, /* JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT */
+    JINT_SSS, /* JOP_EQUALS_JUMP_IF_NOT */
+    JINT_SSI, /* JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT */
+    JINT_SSS, /* JOP_NOT_EQUALS_JUMP_IF_NOT */
+    JINT_SSI, /* JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT */
+    JINT_SC, /* JOP_LOAD_CONSTANT_PUSH */
+    JINT_SI, /* JOP_LOAD_INTEGER_GET */
+    JINT_SI, /* JOP_LOAD_INTEGER_IN */
+    JINT_SC /* JOP_SWITCH */
 };
 
+/* Superinstructions. A fused opcode replaces the first instruction of a
+ * common pair and executes both, skipping over the second. The second
+ * instruction is kept in place, so jumps to it, the sourcemap, and
+ * breakpoints all keep working without rewriting anything. */
+typedef struct {
+    enum JanetOpCode first;
+    enum JanetOpCode second;
+    enum JanetOpCode fused;
+} JanetFusion;
+
+static const JanetFusion janet_fusions[] = {
+    {JOP_LESS_THAN, JOP_JUMP_IF_NOT, JOP_LESS_THAN_JUMP_IF_NOT},
+    {JOP_LESS_THAN_EQUAL, JOP_JUMP_IF_NOT, JOP_LESS_THAN_EQUAL_JUMP_IF_NOT},
+    {JOP_LESS_THAN_IMMEDIATE, JOP_JUMP_IF_NOT, JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT},
+    {JOP_GREATER_THAN, JOP_JUMP_IF_NOT, JOP_GREATER_THAN_JUMP_IF_NOT},
+    {JOP_GREATER_THAN_EQUAL, JOP_JUMP_IF_NOT, JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT},
+    {JOP_GREATER_THAN_IMMEDIATE, JOP_JUMP_IF_NOT, JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT},
+    {JOP_EQUALS, JOP_JUMP_IF_NOT, JOP_EQUALS_JUMP_IF_NOT},
+    {JOP_EQUALS_IMMEDIATE, JOP_JUMP_IF_NOT, JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT},
+    {JOP_NOT_EQUALS, JOP_JUMP_IF_NOT, JOP_NOT_EQUALS_JUMP_IF_NOT},
+    {JOP_NOT_EQUALS_IMMEDIATE, JOP_JUMP_IF_NOT, JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT},
+    {JOP_LOAD_CONSTANT, JOP_PUSH, JOP_LOAD_CONSTANT_PUSH},
+    {JOP_LOAD_INTEGER, JOP_GET, JOP_LOAD_INTEGER_GET},
+    {JOP_LOAD_INTEGER, JOP_IN, JOP_LOAD_INTEGER_IN}
+};
+
+#define JANET_FUSION_COUNT ((int32_t) (sizeof(janet_fusions) / sizeof(JanetFusion)))
+
+/* Get the instruction that must follow a fused instruction, or -1 if
+ * the opcode is not fused. */
+static int32_t janet_fusion_second(uint32_t opcode) {
+    for (int32_t i = 0; i < JANET_FUSION_COUNT; i++) {
+        if (janet_fusions[i].fused == opcode) return janet_fusions[i].second;
+    }
+    return -1;
+}
+
+/* Turn a fused instruction back into the first instruction of its pair. */
+uint32_t janet_bytecode_unfuse(uint32_t instr) {
+    for (int32_t i = 0; i < JANET_FUSION_COUNT; i++) {
+        if (janet_fusions[i].fused == (instr & 0x7F))
+            return (instr & ~0x7FU) | janet_fusions[i].first;
+    }
+    return instr;
+}
+
+/* Check if a slot may be captured by a closure, in which case stores to it
+ * must be kept even right before a return. */
+static int janet_slot_captured(JanetFuncDef *def, int32_t slot) {
+    if (!(def->flags & JANET_FUNCDEF_FLAG_NEEDSENV)) return 0;
+    if (NULL == def->closure_bitset) return 1;
+    return (def->closure_bitset[slot >> 5] >> (slot & 31)) & 1;
+}
+
+/* Peephole pass that rewrites common instruction pairs into superinstructions.
+ * A comparison only fuses with a jump that tests the comparison result, and a
+ * move that is immediately returned becomes a return of the source slot, unless
+ * a closure can see the destination. Does not change the length of the
+ * bytecode. Input is assumed valid bytecode. */
+void janet_bytecode_fuse(JanetFuncDef *def) {
+    for (int32_t i = 0; i + 1 < def->bytecode_length; i++) {
+        uint32_t instr = def->bytecode[i];
+        uint32_t next = def->bytecode[i + 1];
+        uint32_t first = instr & 0x7F;
+        uint32_t second = next & 0x7F;
+        if (first == JOP_MOVE_NEAR && second == JOP_RETURN && ((instr >> 8) & 0xFF) == (next >> 8) &&
+                !janet_slot_captured(def, (int32_t)((instr >> 8) & 0xFF))) {
+            def->bytecode[i] = JOP_RETURN | ((instr >> 16) << 8);
+            i++;
+            continue;
+        }
+        if (second == JOP_JUMP_IF_NOT && ((instr >> 8) & 0xFF) != ((next >> 8) & 0xFF)) {
+            continue;
+        }
+        for (int32_t j = 0; j < JANET_FUSION_COUNT; j++) {
+            if (janet_fusions[j].first == first && janet_fusions[j].second == second) {
+                def->bytecode[i] = (instr & ~0x7FU) | janet_fusions[j].fused;
+                i++;
+                break;
+            }
+        }
+    }
+}
+
+/* Get the number of jumps in the table after the default jump of a switch
+ * instruction, or -1 if its constant is not a valid key to index struct. A
+ * switch that finds the key at index i goes to the jump at pc + 2 + i, and
+ * goes on to the default jump at pc + 1 otherwise. */
+int32_t janet_switch_length(JanetFuncDef *def, uint32_t instr) {
+    int32_t cindex = (int32_t)(instr >> 16);
+    if (cindex >= def->constants_length) return -1;
+    Janet x = def->constants[cindex];
+    if (!janet_checktype(x, JANET_STRUCT)) return -1;
+    JanetStruct st = janet_unwrap_struct(x);
+    int32_t n = 0;
+    for (int32_t i = 0; i < janet_struct_capacity(st); i++) {
+        if (janet_checktype(st[i].key, JANET_NIL)) continue;
+        if (!janet_checkint(st[i].value)) return -1;
+        int32_t index = janet_unwrap_integer(st[i].value);
+        if (index < 0 || index >= INT32_MAX / 2) return -1;
+        if (index >= n) n = index + 1;
+    }
+    return n;
+}
+
+/* Turn instructions that can't be reached from the start of the function into
+ * noops, such as code after a break or return. Run before remove_noops. */
+void janet_bytecode_remove_unreachable(JanetFuncDef *def) {
+    int32_t len = def->bytecode_length;
+    if (len == 0) return;
+    uint8_t *reached = janet_smalloc(len);
+    int32_t *todo = janet_smalloc(sizeof(int32_t) * len);
+    int32_t ntodo = 0;
+    memset(reached, 0, len);
+    reached[0] = 1;
+    todo[ntodo++] = 0;
+    while (ntodo) {
+        int32_t pc = todo[--ntodo];
+        uint32_t instr = def->bytecode[pc];
+        int32_t next[2];
+        int32_t nnext = 0;
+        switch (instr & 0x7F) {
+            case JOP_RETURN:
+            case JOP_RETURN_NIL:
+            case JOP_TAILCALL:
+            case JOP_ERROR:
+                break;
+            case JOP_JUMP:
+                next[nnext++] = pc + (((int32_t) instr) >> 8);
+                break;
+            case JOP_JUMP_IF:
+            case JOP_JUMP_IF_NOT:
+            case JOP_JUMP_IF_NIL:
+            case JOP_JUMP_IF_NOT_NIL:
+                next[nnext++] = pc + (((int32_t) instr) >> 16);
+                next[nnext++] = pc + 1;
+                break;
+            case JOP_SWITCH: {
+                /* All of the jump table is reached */
+                int32_t n = janet_switch_length(def, instr);
+                for (int32_t i = pc + 1; i < pc + 2 + n && i < len; i++) {
+                    if (!reached[i]) {
+                        reached[i] = 1;
+                        todo[ntodo++] = i;
+                    }
+                }
+                break;
+            }
+            default:
+                next[nnext++] = pc + 1;
+                break;
+        }
+        for (int32_t i = 0; i < nnext; i++) {
+            int32_t target = next[i];
+            if (target >= 0 && target < len && !reached[target]) {
+                reached[target] = 1;
+                todo[ntodo++] = target;
+            }
+        }
+    }
+    for (int32_t i = 0; i < len; i++) {
+        uint32_t instr = def->bytecode[i];
+        if (!reached[i]) {
+            def->bytecode[i] = JOP_NOOP;
+        } else if ((instr & 0x7F) == JOP_SWITCH) {
+            /* Keep every jump of the table in place */
+            i += 1 + janet_switch_length(def, instr);
+        } else if ((instr & 0x7F) == JOP_JUMP) {
+            /* A jump over nothing but dead code is removed as well */
+            int32_t target = i + (((int32_t) instr) >> 8);
+            int32_t j = i + 1;
+            while (j < target && !reached[j]) j++;
+            if (j == target && target > i) def->bytecode[i] = JOP_NOOP;
+        }
+    }
+    janet_sfree(todo);
+    janet_sfree(reached);
+}
+
 /* Remove all noops while preserving jumps and debugging information.
  * Useful as part of a filtering compiler pass. */
 void janet_bytecode_remove_noops(JanetFuncDef *def) {
@@ -246,6 +439,7 @@ void janet_bytecode_movopt(JanetFuncDef *def) {
                 case JOP_JUMP_IF_NIL:
                 case JOP_JUMP_IF_NOT_NIL:
                 case JOP_SET_UPVALUE:
+                case JOP_SWITCH:
                 /* Write E, Read A */
                 case JOP_MOVE_FAR:
                     janetc_regalloc_touch(&ra, AA);
@@ -415,6 +609,18 @@ int janet_verify(JanetFuncDef *def) {
         if ((instr & 0x7F) >= JOP_INSTRUCTION_COUNT) {
             return 3;
         }
+        /* Fused instructions also run the instruction after them */
+        int32_t second = janet_fusion_second(instr & 0x7F);
+        if (second >= 0) {
+            if (i + 1 >= def->bytecode_length) return 10;
+            if ((int32_t)(def->bytecode[i + 1] & 0x7F) != second) return 10;
+        }
+        /* The jump table of a switch must be in bounds */
+        if ((instr & 0x7F) == JOP_SWITCH) {
+            int32_t n = janet_switch_length(def, instr);
+            if (n < 0) return 11;
+            if (i + 1 + n >= def->bytecode_length) return 11;
+        }
         enum JanetInstructionType type = janet_instructions[instr & 0x7F];
         switch (type) {
             case JINT_0:
@@ -510,6 +716,13 @@ JanetFuncDef *janet_funcdef_alloc(void) {
     def->flags = 0;
     def->slotcount = 0;
     def->symbolmap = NULL;
+    def->method_cache = NULL;
+    def->profile = NULL;
+#ifdef JANET_JIT
+    def->jit = NULL;
+    def->jit_size = 0;
+    def->jit_calls = JANET_JIT_THRESHOLD;
+#endif
     def->arity = 0;
     def->min_arity = 0;
     def->max_arity = INT32_MAX;
@@ -110,6 +110,141 @@ static int can_slot_be_imm(JanetSlot s, int8_t *out) {
     return can_be_imm(s.constant, out);
 }
 
+/* Check if a constant can take part in compile time evaluation. Only values
+ * that the operators handle without method calls, and that cannot change
+ * between compile time and runtime, are folded. */
+static int can_fold(JanetSlot s) {
+    if (!(s.flags & JANET_SLOT_CONSTANT)) return 0;
+    switch (janet_type(s.constant)) {
+        case JANET_NIL:
+        case JANET_BOOLEAN:
+        case JANET_NUMBER:
+        case JANET_KEYWORD:
+        case JANET_SYMBOL:
+        case JANET_STRING:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Evaluate a binary instruction on constants the same way the VM does. Returns 0 if
+ * the instruction can't be folded or would raise an error, which is left for runtime. */
+static int fold_op(int op, Janet a, Janet b, Janet *out) {
+    int numbers = janet_checktype(a, JANET_NUMBER) && janet_checktype(b, JANET_NUMBER);
+    double x = numbers ? janet_unwrap_number(a) : 0.0;
+    double y = numbers ? janet_unwrap_number(b) : 0.0;
+    switch (op) {
+        case JOP_EQUALS:
+            *out = janet_wrap_boolean(janet_equals(a, b));
+            return 1;
+        case JOP_NOT_EQUALS:
+            *out = janet_wrap_boolean(!janet_equals(a, b));
+            return 1;
+        case JOP_COMPARE:
+            *out = janet_wrap_integer(janet_compare(a, b));
+            return 1;
+        case JOP_GREATER_THAN:
+            *out = janet_wrap_boolean(numbers ? x > y : janet_compare(a, b) > 0);
+            return 1;
+        case JOP_LESS_THAN:
+            *out = janet_wrap_boolean(numbers ? x < y : janet_compare(a, b) < 0);
+            return 1;
+        case JOP_GREATER_THAN_EQUAL:
+            *out = janet_wrap_boolean(numbers ? x >= y : janet_compare(a, b) >= 0);
+            return 1;
+        case JOP_LESS_THAN_EQUAL:
+            *out = janet_wrap_boolean(numbers ? x <= y : janet_compare(a, b) <= 0);
+            return 1;
+        default:
+            break;
+    }
+    if (!numbers) return 0;
+    switch (op) {
+        default:
+            return 0;
+        case JOP_ADD:
+            *out = janet_wrap_number(x + y);
+            return 1;
+        case JOP_SUBTRACT:
+            *out = janet_wrap_number(x - y);
+            return 1;
+        case JOP_MULTIPLY:
+            *out = janet_wrap_number(x * y);
+            return 1;
+        case JOP_DIVIDE:
+            *out = janet_wrap_number(x / y);
+            return 1;
+        case JOP_DIVIDE_FLOOR:
+            *out = janet_wrap_number(floor(x / y));
+            return 1;
+        case JOP_MODULO:
+            *out = janet_wrap_number(y == 0 ? x : x - y * floor(x / y));
+            return 1;
+        case JOP_REMAINDER:
+            *out = janet_wrap_number(fmod(x, y));
+            return 1;
+        case JOP_BAND:
+        case JOP_BOR:
+        case JOP_BXOR:
+        case JOP_SHIFT_LEFT:
+        case JOP_SHIFT_RIGHT:
+            if (!janet_checkintrange(x) || !janet_checkintrange(y)) return 0;
+            break;
+        case JOP_SHIFT_RIGHT_UNSIGNED:
+            if (!janet_checkuintrange(x) || !janet_checkintrange(y)) return 0;
+            break;
+    }
+    int32_t ix = (int32_t) x;
+    int32_t iy = (int32_t) y;
+    switch (op) {
+        case JOP_BAND:
+            *out = janet_wrap_number(ix & iy);
+            return 1;
+        case JOP_BOR:
+            *out = janet_wrap_number(ix | iy);
+            return 1;
+        case JOP_BXOR:
+            *out = janet_wrap_number(ix ^ iy);
+            return 1;
+        default:
+            break;
+    }
+    /* Shifts by a negative amount or the full width are left to the VM */
+    if (iy < 0 || iy > 31) return 0;
+    switch (op) {
+        case JOP_SHIFT_LEFT:
+            *out = janet_wrap_number((int32_t)((uint32_t) ix << iy));
+            return 1;
+        case JOP_SHIFT_RIGHT:
+            *out = janet_wrap_number(ix >> iy);
+            return 1;
+        default:
+            *out = janet_wrap_number((uint32_t) x >> iy);
+            return 1;
+    }
+}
+
+/* Fold a reduction over constant arguments, following the same order of
+ * operations as opreduce. */
+static int fold_reduce(JanetSlot *args, int op, Janet unary, Janet *out) {
+    int32_t len = janet_v_count(args);
+    for (int32_t i = 0; i < len; i++) {
+        if (!can_fold(args[i])) return 0;
+    }
+    if (len == 1) {
+        if (op == JOP_SUBTRACT)
+            return fold_op(JOP_MULTIPLY, args[0].constant, janet_wrap_integer(-1), out);
+        return fold_op(op, unary, args[0].constant, out);
+    }
+    Janet acc = args[0].constant;
+    for (int32_t i = 1; i < len; i++) {
+        if (!fold_op(op, acc, args[i].constant, &acc)) return 0;
+    }
+    *out = acc;
+    return 1;
+}
+
 /* Emit a series of instructions instead of a function call to a math op */
 static JanetSlot opreduce(
     JanetFopts opts,
@@ -123,8 +258,11 @@ static JanetSlot opreduce(
     int8_t imm = 0;
     len = janet_v_count(args);
     JanetSlot t;
+    Janet folded;
     if (len == 0) {
         return janetc_cslot(nullary);
+    } else if (fold_reduce(args, op, unary, &folded)) {
+        return janetc_cslot(folded);
     } else if (len == 1) {
         t = janetc_gettarget(opts);
         /* Special case subtract to be times -1 */
@@ -294,6 +432,11 @@ static JanetSlot do_rshiftu(JanetFopts opts, JanetSlot *args) {
     return opreduce(opts, args, JOP_SHIFT_RIGHT_UNSIGNED, JOP_SHIFT_RIGHT_UNSIGNED_IMMEDIATE, janet_wrap_integer(1), janet_wrap_integer(1));
 }
 static JanetSlot do_bnot(JanetFopts opts, JanetSlot *args) {
+    if ((args[0].flags & JANET_SLOT_CONSTANT) && janet_checktype(args[0].constant, JANET_NUMBER)) {
+        double x = janet_unwrap_number(args[0].constant);
+        if (x >= INT32_MIN && x <= INT32_MAX)
+            return janetc_cslot(janet_wrap_integer(~((int32_t) x)));
+    }
     return genericSS(opts, JOP_BNOT, args[0]);
 }
 
@@ -315,6 +458,16 @@ static JanetSlot compreduce(
                ? janetc_cslot(janet_wrap_false())
                : janetc_cslot(janet_wrap_true());
     }
+    for (i = 0; i < len && can_fold(args[i]); i++);
+    if (i == len) {
+        /* All constant, stop at the first comparison that would jump to the end */
+        Janet result = janet_wrap_nil();
+        for (i = 1; i < len; i++) {
+            fold_op(op, args[i - 1].constant, args[i].constant, &result);
+            if (janet_truthy(result) == invert) break;
+        }
+        return janetc_cslot(result);
+    }
     t = janetc_gettarget(opts);
     for (i = 1; i < len; i++) {
         if (opim && can_slot_be_imm(args[i], &imm)) {
@@ -525,6 +525,194 @@ void janetc_throwaway(JanetFopts opts, Janet x) {
     }
 }
 
+/* Get the size limit in instructions for inlining calls to a function, from
+ * the :inline dynamic binding. By default only core functions are inlined, and
+ * not when *debug* is set, so that breakpoints, the profiler and stack traces
+ * see every call to user code. */
+static int32_t janetc_inline_limit(JanetCompiler *c, JanetFuncDef *def) {
+    Janet setting = janet_table_get(c->env, janet_ckeywordv("inline"));
+    if (janet_checkint(setting)) return janet_unwrap_integer(setting);
+    if (!janet_checktype(setting, JANET_NIL)) return janet_truthy(setting) ? JANET_INLINE_MAX : 0;
+    if (!(def->flags & JANET_FUNCDEF_FLAG_INLINE)) return 0;
+    if (janet_truthy(janet_table_get(c->env, janet_ckeywordv("debug")))) return 0;
+    return JANET_INLINE_MAX;
+}
+
+/* Check if an instruction writes to the slot in its first operand */
+static int janetc_inline_writes(uint32_t op) {
+    switch (op) {
+        case JOP_NOOP:
+        case JOP_ERROR:
+        case JOP_TYPECHECK:
+        case JOP_RETURN:
+        case JOP_RETURN_NIL:
+        case JOP_MOVE_FAR:
+        case JOP_JUMP:
+        case JOP_JUMP_IF:
+        case JOP_JUMP_IF_NOT:
+        case JOP_JUMP_IF_NIL:
+        case JOP_JUMP_IF_NOT_NIL:
+        case JOP_SWITCH:
+        case JOP_SET_UPVALUE:
+        case JOP_PUSH:
+        case JOP_PUSH_2:
+        case JOP_PUSH_3:
+        case JOP_PUSH_ARRAY:
+        case JOP_TAILCALL:
+        case JOP_PUT:
+        case JOP_PUT_INDEX:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+/* Inline a call to a small function by copying its bytecode into the caller.
+ * Only functions that don't create closures, use upvalues, reference
+ * themselves or make tail calls qualify, so the copy behaves like the call
+ * without pushing a stack frame. Parameters the function never assigns use
+ * the argument registers directly. Returns 0 if the call was not inlined. */
+static int janetc_inline(JanetFopts opts, JanetSlot *slots, JanetFuncDef *def, JanetSlot *ret) {
+    JanetCompiler *c = opts.compiler;
+    int32_t argc = janet_v_count(slots);
+    int32_t len = def->bytecode_length;
+    if (len == 0 || def->slotcount > 0xFF) return 0;
+    if (def->flags & (JANET_FUNCDEF_FLAG_VARARG | JANET_FUNCDEF_FLAG_STRUCTARG | JANET_FUNCDEF_FLAG_NEEDSENV)) return 0;
+    if (def->environments_length || def->defs_length) return 0;
+    if (argc < def->min_arity || argc > def->arity) return 0;
+    if (len > janetc_inline_limit(c, def)) return 0;
+
+    /* Find parameters that are assigned to */
+    uint8_t written[256] = {0};
+    for (int32_t i = 0; i < len; i++) {
+        uint32_t instr = janet_bytecode_unfuse(def->bytecode[i]);
+        uint32_t op = instr & 0x7F;
+        switch (op) {
+            case JOP_CLOSURE:
+            case JOP_LOAD_UPVALUE:
+            case JOP_SET_UPVALUE:
+            case JOP_LOAD_SELF:
+            case JOP_TAILCALL:
+                return 0;
+            case JOP_MOVE_FAR:
+                written[(instr >> 16) & 0xFF] = 1;
+                break;
+            default:
+                if (janet_instructions[op] != JINT_0 && janet_instructions[op] != JINT_L && janetc_inline_writes(op))
+                    written[(instr >> 8) & 0xFF] = 1;
+                break;
+        }
+    }
+
+    JanetSlot target = janetc_gettarget(opts);
+    int target_is_hint = (opts.flags & JANET_FOPTS_HINT) && janetc_sequal(target, opts.hint);
+    if (target.index > 0xFF) {
+        if (!target_is_hint) janetc_freeslot(c, target);
+        return 0;
+    }
+
+    /* Map the callee's registers to the caller's */
+    uint32_t regmap[256];
+    int32_t fresh[256];
+    int32_t nfresh = 0;
+    for (int32_t r = 0; r < def->slotcount; r++) {
+        JanetSlot arg = r < argc ? slots[r] : janetc_cslot(janet_wrap_nil());
+        if (r < argc && !written[r] &&
+                !(arg.flags & (JANET_SLOT_CONSTANT | JANET_SLOT_REF)) &&
+                arg.envindex < 0 && arg.index >= 0 && arg.index <= 0xFF) {
+            regmap[r] = (uint32_t) arg.index;
+            continue;
+        }
+        int32_t reg = janetc_regalloc_1(&c->scope->ra);
+        fresh[nfresh++] = reg;
+        regmap[r] = (uint32_t) reg;
+        if (reg > 0xFF) {
+            for (int32_t i = 0; i < nfresh; i++) janetc_regalloc_free(&c->scope->ra, fresh[i]);
+            if (!target_is_hint) janetc_freeslot(c, target);
+            return 0;
+        }
+        if (r < def->arity) {
+            JanetSlot param = janetc_cslot(janet_wrap_nil());
+            param.flags = JANET_SLOTTYPE_ANY;
+            param.index = reg;
+            janetc_copy(c, param, arg);
+        }
+    }
+
+    /* Returns become a move to the target and a jump to the end */
+    int32_t *newpc = janet_smalloc(sizeof(int32_t) * (len + 1));
+    int32_t count = 0;
+    for (int32_t i = 0; i < len; i++) {
+        uint32_t op = def->bytecode[i] & 0x7F;
+        newpc[i] = count;
+        count += (op == JOP_RETURN || op == JOP_RETURN_NIL) ? 2 : 1;
+    }
+    newpc[len] = count;
+
+#define REG_A (regmap[(instr >> 8) & 0xFF] << 8)
+#define REG_B (regmap[(instr >> 16) & 0xFF] << 16)
+#define REG_C (regmap[instr >> 24] << 24)
+    uint32_t end_jump;
+    for (int32_t i = 0; i < len; i++) {
+        uint32_t instr = janet_bytecode_unfuse(def->bytecode[i]) & ~0x80U;
+        uint32_t op = instr & 0x7F;
+        switch (op) {
+            case JOP_RETURN:
+            case JOP_RETURN_NIL:
+                if (op == JOP_RETURN) {
+                    janetc_emit(c, JOP_MOVE_NEAR | ((uint32_t) target.index << 8) | (regmap[instr >> 8] << 16));
+                } else {
+                    janetc_emit(c, JOP_LOAD_NIL | ((uint32_t) target.index << 8));
+                }
+                end_jump = (uint32_t)(count - (newpc[i] + 1));
+                janetc_emit(c, JOP_JUMP | (end_jump << 8));
+                continue;
+            default:
+                break;
+        }
+        switch (janet_instructions[op]) {
+            default:
+                break;
+            case JINT_S:
+                instr = op | (regmap[instr >> 8] << 8);
+                break;
+            case JINT_L:
+                instr = op | ((uint32_t)(newpc[i + (((int32_t) instr) >> 8)] - newpc[i]) << 8);
+                break;
+            case JINT_SL:
+                instr = op | REG_A | ((uint32_t)(newpc[i + (((int32_t) instr) >> 16)] - newpc[i]) << 16);
+                break;
+            case JINT_SS:
+                instr = op | REG_A | (regmap[instr >> 16] << 16);
+                break;
+            case JINT_ST:
+            case JINT_SI:
+            case JINT_SU:
+                instr = (instr & 0xFFFF00FFU) | REG_A;
+                break;
+            case JINT_SSS:
+                instr = op | REG_A | REG_B | REG_C;
+                break;
+            case JINT_SSI:
+            case JINT_SSU:
+                instr = (instr & 0xFF0000FFU) | REG_A | REG_B;
+                break;
+            case JINT_SC:
+                instr = op | REG_A | ((uint32_t) janetc_const(c, def->constants[instr >> 16]) << 16);
+                break;
+        }
+        janetc_emit(c, instr);
+    }
+#undef REG_A
+#undef REG_B
+#undef REG_C
+
+    janet_sfree(newpc);
+    for (int32_t i = 0; i < nfresh; i++) janetc_regalloc_free(&c->scope->ra, fresh[i]);
+    *ret = target;
+    return 1;
+}
+
 /* Compile a call or tailcall instruction */
 static JanetSlot janetc_call(JanetFopts opts, JanetSlot *slots, JanetSlot fun) {
     JanetSlot retslot;
@@ -537,9 +725,10 @@ static JanetSlot janetc_call(JanetFopts opts, JanetSlot *slots, JanetSlot fun) {
             if (o && (!o->can_optimize || o->can_optimize(opts, slots))) {
                 specialized = 1;
                 retslot = o->optimize(opts, slots);
+            } else if (!o) {
+                specialized = janetc_inline(opts, slots, f->def, &retslot);
             }
         }
-        /* TODO janet function inlining (no c functions)*/
     }
     if (!specialized) {
         int32_t min_arity = janetc_pushslots(c, slots);
@@ -924,6 +1113,10 @@ JanetFuncDef *janetc_pop_funcdef(JanetCompiler *c) {
     def->arity = 0;
     def->min_arity = 0;
     def->flags = 0;
+#ifdef JANET_BOOTSTRAP
+    /* Functions in the core library may be inlined by default */
+    def->flags |= JANET_FUNCDEF_FLAG_INLINE;
+#endif
     if (scope->flags & JANET_SCOPE_ENV) {
         def->flags |= JANET_FUNCDEF_FLAG_NEEDSENV;
     }
@@ -1001,8 +1194,10 @@ JanetFuncDef *janetc_pop_funcdef(JanetCompiler *c) {
     janetc_popscope(c);
 
     /* Do basic optimization */
+    janet_bytecode_remove_unreachable(def);
     janet_bytecode_movopt(def);
     janet_bytecode_remove_noops(def);
+    janet_bytecode_fuse(def);
 
     return def;
 }
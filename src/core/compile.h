@@ -36,6 +36,11 @@ typedef enum {
     JANET_C_LINT_STRICT
 } JanetCompileLintLevel;
 
+/* Largest function, in instructions, whose calls are inlined by default */
+#ifndef JANET_INLINE_MAX
+#define JANET_INLINE_MAX 12
+#endif
+
 /* Tags for some functions for the prepared inliner */
 #define JANET_FUN_DEBUG 1
 #define JANET_FUN_ERROR 2
@@ -269,7 +274,10 @@ JanetSlot janetc_cslot(Janet x);
 JanetSlot janetc_resolve(JanetCompiler *c, const uint8_t *sym);
 
 /* Bytecode optimization */
+void janet_bytecode_remove_unreachable(JanetFuncDef *def);
+uint32_t janet_bytecode_unfuse(uint32_t instr);
 void janet_bytecode_movopt(JanetFuncDef *def);
 void janet_bytecode_remove_noops(JanetFuncDef *def);
+void janet_bytecode_fuse(JanetFuncDef *def);
 
 #endif
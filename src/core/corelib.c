@@ -530,11 +530,35 @@ JANET_CORE_FN(janet_core_gensym,
     return janet_wrap_symbol(janet_symbol_gen());
 }
 
+JANET_CORE_FN(janet_core_gensym_counter,
+              "(gensym/counter &opt counter)",
+              "Get the counter that `gensym` makes the next symbol from, a string such as \"_00001a\". "
+              "If `counter` is given, continue counting from it. Symbols that already exist are still "
+              "skipped, so this does not make `gensym` return a symbol that is in use. Setting the counter "
+              "before compiling some code makes the names of its generated symbols independent of what was "
+              "compiled before it. Returns the previous counter.") {
+    janet_arity(argc, 0, 1);
+    int32_t len = (int32_t) sizeof(janet_vm.gensym_counter) - 1;
+    Janet old = janet_stringv(janet_vm.gensym_counter, len);
+    if (argc > 0) {
+        JanetByteView counter = janet_getbytes(argv, 0);
+        int valid = counter.len == len && counter.bytes[0] == '_';
+        for (int32_t i = 1; valid && i < len; i++) {
+            uint8_t c = counter.bytes[i];
+            valid = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+        if (!valid) janet_panicf("expected _ followed by %d letters or digits, got %v", len - 1, argv[0]);
+        memcpy(janet_vm.gensym_counter, counter.bytes, len);
+    }
+    return old;
+}
+
 JANET_CORE_FN(janet_core_gccollect,
               "(gccollect)",
               "Run garbage collection. You should probably not call this manually.") {
     (void) argv;
     (void) argc;
+    janet_vm.gc_major_due = 1;
     janet_collect();
     return janet_wrap_nil();
 }
@@ -543,7 +567,8 @@ JANET_CORE_FN(janet_core_gcsetinterval,
               "(gcsetinterval interval)",
               "Set an integer number of bytes to allocate before running garbage collection. "
               "Low values for interval will be slower but use less memory. "
-              "High values will be faster but use more memory.") {
+              "High values will be faster but use more memory. "
+              "This turns off the adaptive interval set by `gcsetpause`.") {
     janet_fixarity(argc, 1);
     size_t s = janet_getsize(argv, 0);
     /* limit interval to 48 bits */
@@ -553,6 +578,7 @@ JANET_CORE_FN(janet_core_gcsetinterval,
     }
 #endif
     janet_vm.gc_interval = s;
+    janet_vm.gc_pause = 0;
     return janet_wrap_nil();
 }
 
@@ -565,6 +591,174 @@ JANET_CORE_FN(janet_core_gcinterval,
     return janet_wrap_number((double) janet_vm.gc_interval);
 }
 
+static const char *janet_gc_mode_names[] = {
+    "full",
+    "generational",
+    "incremental"
+};
+
+JANET_CORE_FN(janet_core_gcsetpause,
+              "(gcsetpause percent)",
+              "Pick the garbage collection interval from the size of the heap instead of "
+              "using a fixed interval. After each collection, the next one is scheduled "
+              "once the heap has grown to `percent` percent of the memory that survived. "
+              "For example, 200 waits for the heap to double. `percent` must be greater "
+              "than 100, or 0 to go back to the fixed interval from `gcsetinterval`.") {
+    janet_fixarity(argc, 1);
+    int32_t pause = janet_getnat(argv, 0);
+    if (pause != 0 && pause <= 100) {
+        janet_panicf("expected 0 or a percentage greater than 100, got %d", pause);
+    }
+    janet_vm.gc_pause = (uint32_t) pause;
+    return janet_wrap_nil();
+}
+
+JANET_CORE_FN(janet_core_gcpause,
+              "(gcpause)",
+              "Returns the percentage set by `gcsetpause`, or 0 if a fixed interval is used.") {
+    (void) argv;
+    janet_fixarity(argc, 0);
+    return janet_wrap_number((double) janet_vm.gc_pause);
+}
+
+JANET_CORE_FN(janet_core_gcsetmode,
+              "(gcsetmode mode)",
+              "Set the garbage collection strategy. `mode` is one of:\n\n"
+              "* :full - every collection traces and sweeps the whole heap. This is the default.\n\n"
+              "* :generational - objects that survive a collection become old and are only "
+              "traced again by major collections, which run when the old generation has doubled "
+              "in size. Minor collections only trace new objects and old objects that were "
+              "mutated since the last collection. Native code that stores values directly into "
+              "array or table memory must call `janet_gcbarrier` on the container.\n\n"
+              "* :incremental - marking is split into slices that each run for at most the "
+              "pause budget set with `gcsetbudget`, interleaved with the program and run by the "
+              "event loop between fibers. The same write barrier as :generational applies.\n\n"
+              "Returns the previous mode.") {
+    janet_fixarity(argc, 1);
+    JanetGCMode old = janet_gcmode();
+    for (size_t i = 0; i < sizeof(janet_gc_mode_names) / sizeof(janet_gc_mode_names[0]); i++) {
+        if (janet_keyeq(argv[0], janet_gc_mode_names[i])) {
+            janet_gcsetmode((JanetGCMode) i);
+            return janet_ckeywordv(janet_gc_mode_names[old]);
+        }
+    }
+    janet_panicf("expected :full, :generational, or :incremental, got %v", argv[0]);
+}
+
+JANET_CORE_FN(janet_core_gcmode,
+              "(gcmode)",
+              "Returns the current garbage collection strategy, one of :full, :generational, or :incremental.") {
+    (void) argv;
+    janet_fixarity(argc, 0);
+    return janet_ckeywordv(janet_gc_mode_names[janet_gcmode()]);
+}
+
+JANET_CORE_FN(janet_core_gcsetbudget,
+              "(gcsetbudget usec)",
+              "Set the maximum number of microseconds a single slice of incremental marking "
+              "may run for. A budget of 0 means each slice runs until marking is done. The "
+              "final slice of a cycle also sweeps the heap, which is not bounded by the budget.") {
+    janet_fixarity(argc, 1);
+    janet_vm.gc_pause_budget = (uint32_t) janet_getnat(argv, 0);
+    return janet_wrap_nil();
+}
+
+JANET_CORE_FN(janet_core_gcbudget,
+              "(gcbudget)",
+              "Returns the maximum number of microseconds a single slice of incremental marking may run for.") {
+    (void) argv;
+    janet_fixarity(argc, 0);
+    return janet_wrap_number((double) janet_vm.gc_pause_budget);
+}
+
+/* Names for the gc memory types, in the order of enum JanetMemoryType */
+static const char *janet_gc_memory_names[JANET_GC_MEMORY_TYPES] = {
+    NULL,
+    "string",
+    "symbol",
+    "array",
+    "tuple",
+    "table",
+    "struct",
+    "fiber",
+    "buffer",
+    "function",
+    "abstract",
+    "funcenv",
+    "funcdef",
+    NULL, /* threaded abstracts are not on the gc heap */
+    "table-weak-keys",
+    "table-weak-values",
+    "table-weak",
+    "array-weak"
+};
+
+static Janet janet_gc_cycle_stats(const JanetGCCycleStats *cs) {
+    JanetTable *t = janet_table(6);
+    janet_table_put(t, janet_ckeywordv("mark-time"), janet_wrap_number(cs->mark_time));
+    janet_table_put(t, janet_ckeywordv("sweep-time"), janet_wrap_number(cs->sweep_time));
+    janet_table_put(t, janet_ckeywordv("bytes-freed"), janet_wrap_number((double) cs->bytes_freed));
+    janet_table_put(t, janet_ckeywordv("blocks-freed"), janet_wrap_number((double) cs->blocks_freed));
+    janet_table_put(t, janet_ckeywordv("weak-cleared"), janet_wrap_number((double) cs->weak_cleared));
+    janet_table_put(t, janet_ckeywordv("threaded-decrefs"), janet_wrap_number((double) cs->threaded_decrefs));
+    return janet_wrap_table(t);
+}
+
+JANET_CORE_FN(janet_core_gcstats,
+              "(gcstats)",
+              "Get statistics about garbage collection as a table with the following keys:\n\n"
+              "* :collections - number of completed collections\n\n"
+              "* :last - statistics for the last collection\n\n"
+              "* :total - statistics summed over all collections\n\n"
+              "* :live-bytes - approximate bytes used by live objects of each memory type "
+              "after the last sweep\n\n"
+              "* :blocks - number of objects currently allocated\n\n"
+              "Statistics for collections are tables with :mark-time and :sweep-time in seconds, "
+              ":bytes-freed, :blocks-freed, :weak-cleared for entries dropped from weak "
+              "containers, and :threaded-decrefs for references to threaded abstract values "
+              "released by this thread.") {
+    (void) argv;
+    janet_fixarity(argc, 0);
+    const JanetGCStats *stats = janet_gcstats();
+    JanetTable *live = janet_table(JANET_GC_MEMORY_TYPES);
+    for (int i = 0; i < JANET_GC_MEMORY_TYPES; i++) {
+        if (NULL == janet_gc_memory_names[i]) continue;
+        janet_table_put(live, janet_ckeywordv(janet_gc_memory_names[i]),
+                        janet_wrap_number((double) stats->live_bytes[i]));
+    }
+    JanetTable *t = janet_table(5);
+    janet_table_put(t, janet_ckeywordv("collections"), janet_wrap_number((double) stats->collections));
+    janet_table_put(t, janet_ckeywordv("last"), janet_gc_cycle_stats(&stats->last));
+    janet_table_put(t, janet_ckeywordv("total"), janet_gc_cycle_stats(&stats->total));
+    janet_table_put(t, janet_ckeywordv("live-bytes"), janet_wrap_table(live));
+    janet_table_put(t, janet_ckeywordv("blocks"), janet_wrap_number((double) janet_vm.block_count));
+    return janet_wrap_table(t);
+}
+
+JANET_CORE_FN(janet_core_symcache_stats,
+              "(symcache/stats)",
+              "Get statistics about the symbol cache, which interns all symbols and keywords "
+              "for the current thread, as a table with the following keys:\n\n"
+              "* :capacity - number of buckets\n\n"
+              "* :count - number of interned symbols and keywords\n\n"
+              "* :deleted - number of buckets holding a tombstone for a freed symbol\n\n"
+              "* :average-probe - average number of buckets checked to find an interned symbol\n\n"
+              "* :max-probe - most buckets checked to find an interned symbol\n\n"
+              "The cache is shrunk or rehashed after a collection once it is mostly empty or "
+              "mostly tombstones.") {
+    (void) argv;
+    janet_fixarity(argc, 0);
+    JanetSymcacheStats stats;
+    janet_symcache_stats(&stats);
+    JanetTable *t = janet_table(5);
+    janet_table_put(t, janet_ckeywordv("capacity"), janet_wrap_number(stats.capacity));
+    janet_table_put(t, janet_ckeywordv("count"), janet_wrap_number(stats.count));
+    janet_table_put(t, janet_ckeywordv("deleted"), janet_wrap_number(stats.deleted));
+    janet_table_put(t, janet_ckeywordv("average-probe"), janet_wrap_number(stats.average_probe));
+    janet_table_put(t, janet_ckeywordv("max-probe"), janet_wrap_number(stats.max_probe));
+    return janet_wrap_table(t);
+}
+
 JANET_CORE_FN(janet_core_type,
               "(type x)",
               "Returns the type of `x` as a keyword. `x` is one of:\n\n"
@@ -1082,9 +1276,18 @@ static void janet_load_libs(JanetTable *env) {
         JANET_CORE_REG("tuple", janet_core_tuple),
         JANET_CORE_REG("struct", janet_core_struct),
         JANET_CORE_REG("gensym", janet_core_gensym),
+        JANET_CORE_REG("gensym/counter", janet_core_gensym_counter),
         JANET_CORE_REG("gccollect", janet_core_gccollect),
         JANET_CORE_REG("gcsetinterval", janet_core_gcsetinterval),
         JANET_CORE_REG("gcinterval", janet_core_gcinterval),
+        JANET_CORE_REG("gcsetpause", janet_core_gcsetpause),
+        JANET_CORE_REG("gcpause", janet_core_gcpause),
+        JANET_CORE_REG("gcsetmode", janet_core_gcsetmode),
+        JANET_CORE_REG("gcmode", janet_core_gcmode),
+        JANET_CORE_REG("gcsetbudget", janet_core_gcsetbudget),
+        JANET_CORE_REG("gcbudget", janet_core_gcbudget),
+        JANET_CORE_REG("gcstats", janet_core_gcstats),
+        JANET_CORE_REG("symcache/stats", janet_core_symcache_stats),
         JANET_CORE_REG("type", janet_core_type),
         JANET_CORE_REG("hash", janet_core_hash),
         JANET_CORE_REG("getline", janet_core_getline),
@@ -1131,8 +1334,18 @@ static void janet_load_libs(JanetTable *env) {
 #ifdef JANET_INT_TYPES
     janet_lib_inttypes(env);
 #endif
+#ifdef JANET_TYPED_ARRAY
+    janet_lib_tarray(env);
+#endif
+#ifdef JANET_PERSISTENT
+    janet_lib_persistent(env);
+#endif
+#ifdef JANET_JSON
+    janet_lib_json(env);
+#endif
 #ifdef JANET_EV
     janet_lib_ev(env);
+    janet_lib_shared(env);
 #ifdef JANET_FILEWATCH
     janet_lib_filewatch(env);
 #endif
@@ -1325,42 +1538,134 @@ JanetTable *janet_core_env(JanetTable *replacements) {
 
 #else
 
+/* The core image is a table that maps each name in the core environment to a
+ * chunk, and an array of chunks. Each chunk is a marshalled table of
+ * environment entries. A chunk is unmarshalled the first time one of its names
+ * is missed in the environment or in load-image-dict, so short lived programs
+ * only pay for the parts of the core they use. */
+
+static void janet_core_lazy_chunk(int32_t i) {
+    JanetArray *chunks = janet_vm.core_lazy_chunks;
+    Janet chunk = chunks->data[i];
+    if (!janet_checktype(chunk, JANET_STRING)) return;
+    chunks->data[i] = janet_wrap_nil();
+    JanetTable *env = janet_vm.core_env;
+    JanetTable *lid = janet_vm.core_lazy_lid;
+    JanetTable *mid = janet_vm.core_lazy_mid;
+    const uint8_t *bytes = janet_unwrap_string(chunk);
+    Janet out = janet_unmarshal(bytes, janet_string_length(bytes), JANET_MARSHAL_ZEROCOPY, lid, NULL);
+    JanetTable *entries = janet_unwrap_table(out);
+    for (int32_t j = 0; j < entries->capacity; j++) {
+        const JanetKV *kv = entries->data + j;
+        if (janet_checktype(kv->key, JANET_NIL)) continue;
+        /* Keep anything that was put in the environment in the meantime */
+        if (janet_checktype(janet_table_rawget(env, kv->key), JANET_NIL)) {
+            janet_table_put(env, kv->key, kv->value);
+        }
+        if (!janet_checktype(kv->key, JANET_SYMBOL)) continue;
+        Janet value = janet_wrap_nil();
+        if (janet_checktype(kv->value, JANET_TABLE)) {
+            JanetTable *entry = janet_unwrap_table(kv->value);
+            value = janet_table_get(entry, janet_ckeywordv("value"));
+            if (janet_checktype(value, JANET_NIL)) {
+                value = janet_table_get(entry, janet_ckeywordv("ref"));
+            }
+        }
+        if (janet_checktype(value, JANET_NIL) || janet_checktype(value, JANET_NUMBER)) continue;
+        if (janet_checktype(janet_table_rawget(lid, kv->key), JANET_NIL)) {
+            janet_table_put(lid, kv->key, value);
+        }
+        janet_table_put(mid, value, kv->key);
+    }
+    if (--janet_vm.core_lazy_pending == 0) {
+        env->gc.flags &= ~JANET_TABLE_FLAG_LAZY;
+        lid->gc.flags &= ~JANET_TABLE_FLAG_LAZY;
+        mid->gc.flags &= ~JANET_TABLE_FLAG_LAZY;
+    }
+}
+
+/* Load the chunk that defines key, if it is not loaded yet. Returns
+ * non-zero if a chunk was loaded. */
+int janet_core_lazy_load(JanetTable *t, Janet key) {
+    int32_t pending = janet_vm.core_lazy_pending;
+    if (t == janet_vm.core_lazy_mid) {
+        /* A value can't be traced to the chunk that defines it, so load
+         * everything. Otherwise images would depend on which parts of the
+         * core the program happened to use. */
+        janet_core_lazy_load_all();
+        return pending != janet_vm.core_lazy_pending;
+    }
+    Janet index = janet_table_rawget(janet_vm.core_lazy_index, key);
+    if (!janet_checkint(index)) return 0;
+    janet_core_lazy_chunk(janet_unwrap_integer(index));
+    return pending != janet_vm.core_lazy_pending;
+}
+
+/* Load every chunk, before something looks at the whole environment */
+void janet_core_lazy_load_all(void) {
+    JanetArray *chunks = janet_vm.core_lazy_chunks;
+    for (int32_t i = 0; i < chunks->count && janet_vm.core_lazy_pending; i++) {
+        janet_core_lazy_chunk(i);
+    }
+}
+
 JanetTable *janet_core_env(JanetTable *replacements) {
     /* Memoize core env, ignoring replacements the second time around. */
     if (NULL != janet_vm.core_env) {
         return janet_vm.core_env;
     }
 
-    JanetTable *dict = janet_core_lookup_table(replacements);
+    /* The lookup table becomes load-image-dict, and chunks add their
+     * bindings to it as they are loaded */
+    JanetTable *lid = janet_core_lookup_table(replacements);
 
-    /* Unmarshal bytecode */
+    /* Unmarshal the index */
     Janet marsh_out = janet_unmarshal(
                           janet_core_image,
                           janet_core_image_size,
-                          0,
-                          dict,
+                          JANET_MARSHAL_ZEROCOPY,
+                          lid,
                           NULL);
-
-    /* Memoize */
-    janet_gcroot(marsh_out);
-    JanetTable *env = janet_unwrap_table(marsh_out);
-    janet_vm.core_env = env;
+    const Janet *image = janet_unwrap_tuple(marsh_out);
+    JanetTable *index = janet_unwrap_table(image[0]);
+    JanetArray *chunks = janet_unwrap_array(image[1]);
 
     /* Invert image dict manually here. We can't do this in boot.janet as it
      * breaks deterministic builds */
-    Janet lidv, midv;
-    lidv = midv = janet_wrap_nil();
-    janet_resolve(env, janet_csymbol("load-image-dict"), &lidv);
-    janet_resolve(env, janet_csymbol("make-image-dict"), &midv);
-    JanetTable *lid = janet_unwrap_table(lidv);
-    JanetTable *mid = janet_unwrap_table(midv);
+    JanetTable *env = janet_table(index->count);
+    JanetTable *mid = janet_table(lid->count + index->count);
     for (int32_t i = 0; i < lid->capacity; i++) {
         const JanetKV *kv = lid->data + i;
-        if (!janet_checktype(kv->key, JANET_NIL)) {
+        if (!janet_checktype(kv->key, JANET_NIL) && !janet_checktype(kv->value, JANET_NUMBER)) {
             janet_table_put(mid, kv->value, kv->key);
         }
     }
 
+    /* The image refers to these by name */
+    janet_table_put(lid, janet_csymbolv("root-env"), janet_wrap_table(env));
+    janet_table_put(lid, janet_csymbolv("load-image-dict"), janet_wrap_table(lid));
+    janet_table_put(lid, janet_csymbolv("make-image-dict"), janet_wrap_table(mid));
+    janet_table_put(mid, janet_wrap_table(env), janet_csymbolv("root-env"));
+    janet_table_put(mid, janet_wrap_table(lid), janet_csymbolv("load-image-dict"));
+    janet_table_put(mid, janet_wrap_table(mid), janet_csymbolv("make-image-dict"));
+
+    /* Memoize */
+    janet_gcroot(janet_wrap_table(env));
+    janet_gcroot(janet_wrap_table(lid));
+    janet_gcroot(janet_wrap_table(mid));
+    janet_gcroot(marsh_out);
+    janet_vm.core_env = env;
+    janet_vm.core_lazy_index = index;
+    janet_vm.core_lazy_chunks = chunks;
+    janet_vm.core_lazy_lid = lid;
+    janet_vm.core_lazy_mid = mid;
+    janet_vm.core_lazy_pending = chunks->count;
+    if (chunks->count) {
+        env->gc.flags |= JANET_TABLE_FLAG_LAZY;
+        lid->gc.flags |= JANET_TABLE_FLAG_LAZY;
+        mid->gc.flags |= JANET_TABLE_FLAG_LAZY;
+    }
+
     return env;
 }
 
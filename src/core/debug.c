@@ -33,18 +33,42 @@
  * The repl should also be able to serve as pretty featured debugger
  * out of the box. */
 
+/* Bytecode loaded in place from an image is read only, so take a copy
+ * before patching in break points. */
+static void janet_debug_own_bytecode(JanetFuncDef *def) {
+    if (!(def->flags & JANET_FUNCDEF_FLAG_MAPPED)) return;
+    size_t size = sizeof(uint32_t) * (size_t) def->bytecode_length;
+    uint32_t *bytecode = janet_malloc(size);
+    if (NULL == bytecode) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memcpy(bytecode, def->bytecode, size);
+    def->bytecode = bytecode;
+    def->flags &= ~JANET_FUNCDEF_FLAG_MAPPED;
+}
+
 /* Add a break point to a function */
 void janet_debug_break(JanetFuncDef *def, int32_t pc) {
     if (pc >= def->bytecode_length || pc < 0)
         janet_panic("invalid bytecode offset");
+    janet_debug_own_bytecode(def);
     def->bytecode[pc] |= 0x80;
+#ifdef JANET_JIT
+    janet_jit_free(def);
+    def->jit_calls = JANET_JIT_THRESHOLD;
+#endif
 }
 
 /* Remove a break point from a function */
 void janet_debug_unbreak(JanetFuncDef *def, int32_t pc) {
     if (pc >= def->bytecode_length || pc < 0)
         janet_panic("invalid bytecode offset");
+    janet_debug_own_bytecode(def);
     def->bytecode[pc] &= ~((uint32_t)0x80);
+#ifdef JANET_JIT
+    janet_jit_free(def);
+    def->jit_calls = JANET_JIT_THRESHOLD;
+#endif
 }
 
 /*
@@ -428,6 +452,337 @@ JANET_CORE_FN(cfun_debug_step,
     return out;
 }
 
+/*
+ * Built in profiler. Counts calls (and, with JANET_PROFILE, instructions) per
+ * funcdef, and periodically samples the stack of the running fiber into a
+ * table of folded stacks. Counters outlive their funcdefs so that short lived
+ * code still shows up in the report.
+ */
+
+static char *profile_strdup(JanetString str) {
+    if (NULL == str) return NULL;
+    size_t len = (size_t) janet_string_length(str);
+    char *out = janet_malloc(len + 1);
+    if (NULL == out) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memcpy(out, str, len);
+    out[len] = '\0';
+    return out;
+}
+
+static JanetFuncProfile *profile_entry(JanetFuncDef *def) {
+    JanetFuncProfile *p = def->profile;
+    if (NULL != p) return p;
+    p = janet_malloc(sizeof(JanetFuncProfile));
+    if (NULL == p) {
+        JANET_OUT_OF_MEMORY;
+    }
+    p->def = def;
+    p->name = profile_strdup(def->name);
+    p->source = profile_strdup(def->source);
+    p->line = (NULL != def->sourcemap && def->bytecode_length > 0) ? def->sourcemap[0].line : 0;
+    p->calls = 0;
+    p->instructions = 0;
+    p->next = janet_vm.profile_funcs;
+    janet_vm.profile_funcs = p;
+    def->profile = p;
+    return p;
+}
+
+/* Write the name of a stack frame for a folded stack */
+static void profile_frame_name(JanetBuffer *buf, JanetStackFrame *frame) {
+    if (frame->func) {
+        JanetFuncDef *def = frame->func->def;
+        if (def->name) {
+            janet_buffer_push_string(buf, def->name);
+        } else {
+            janet_buffer_push_cstring(buf, "<anonymous>");
+        }
+        if (def->source) {
+            int32_t line = (NULL != def->sourcemap && def->bytecode_length > 0) ? def->sourcemap[0].line : 0;
+            janet_formatb(buf, " [%S:%d]", def->source, line);
+        }
+    } else {
+        JanetCFunction cfun = (JanetCFunction)(frame->pc);
+        JanetCFunRegistry *reg = cfun ? janet_registry_get(cfun) : NULL;
+        if (NULL != reg && NULL != reg->name) {
+            if (reg->name_prefix) {
+                janet_formatb(buf, "%s/%s", reg->name_prefix, reg->name);
+            } else {
+                janet_buffer_push_cstring(buf, reg->name);
+            }
+        } else {
+            janet_buffer_push_cstring(buf, "<cfunction>");
+        }
+    }
+}
+
+/* Get the stack of a fiber as a folded stack, from the bottom frame up, or
+ * nil if the fiber has no frames */
+Janet janet_profile_stack(JanetFiber *fiber) {
+    int32_t depth = 0;
+    for (int32_t i = fiber->frame; i > 0; i = ((JanetStackFrame *)(fiber->data + i - JANET_FRAME_SIZE))->prevframe) {
+        depth++;
+    }
+    if (depth == 0) return janet_wrap_nil();
+    int32_t *frames = janet_smalloc(sizeof(int32_t) * (size_t) depth);
+    int32_t d = depth;
+    for (int32_t i = fiber->frame; i > 0; i = ((JanetStackFrame *)(fiber->data + i - JANET_FRAME_SIZE))->prevframe) {
+        frames[--d] = i;
+    }
+    JanetBuffer buf;
+    janet_buffer_init(&buf, 128);
+    for (d = 0; d < depth; d++) {
+        if (d) janet_buffer_push_u8(&buf, ';');
+        profile_frame_name(&buf, (JanetStackFrame *)(fiber->data + frames[d] - JANET_FRAME_SIZE));
+    }
+    janet_sfree(frames);
+    Janet key = janet_stringv(buf.data, buf.count);
+    janet_buffer_deinit(&buf);
+    return key;
+}
+
+/* Record the stack of a fiber */
+static void profile_sample(JanetFiber *fiber) {
+    Janet key = janet_profile_stack(fiber);
+    if (janet_checktype(key, JANET_NIL)) return;
+    Janet count = janet_table_get(janet_vm.profile_stacks, key);
+    double n = janet_checktype(count, JANET_NUMBER) ? janet_unwrap_number(count) : 0.0;
+    janet_table_put(janet_vm.profile_stacks, key, janet_wrap_number(n + 1.0));
+    janet_vm.profile_samples++;
+}
+
+static void profile_tick(JanetFiber *fiber) {
+    if (--janet_vm.profile_countdown <= 0) {
+        janet_vm.profile_countdown = janet_vm.profile_interval;
+        profile_sample(fiber);
+    }
+}
+
+void janet_profile_call(JanetFiber *fiber, JanetFuncDef *def) {
+    profile_entry(def)->calls++;
+#ifdef JANET_PROFILE
+    (void) fiber;
+#else
+    profile_tick(fiber);
+#endif
+}
+
+#ifdef JANET_PROFILE
+void janet_profile_step(JanetFiber *fiber, JanetFuncDef *def, uint32_t instr) {
+    JanetFuncProfile *p = def->profile;
+    if (NULL == p) p = profile_entry(def);
+    p->instructions++;
+    janet_vm.profile_ops[instr & 0x7F]++;
+    profile_tick(fiber);
+}
+#endif
+
+void janet_profile_clear(void) {
+    JanetFuncProfile *p = janet_vm.profile_funcs;
+    while (NULL != p) {
+        JanetFuncProfile *next = p->next;
+        if (NULL != p->def) p->def->profile = NULL;
+        janet_free(p->name);
+        janet_free(p->source);
+        janet_free(p);
+        p = next;
+    }
+    janet_vm.profile_funcs = NULL;
+    if (NULL != janet_vm.profile_stacks) {
+        janet_gcunroot(janet_wrap_table(janet_vm.profile_stacks));
+        janet_vm.profile_stacks = NULL;
+    }
+    janet_vm.profile_samples = 0;
+#ifdef JANET_PROFILE
+    memset(janet_vm.profile_ops, 0, sizeof(janet_vm.profile_ops));
+#endif
+}
+
+JANET_CORE_FN(cfun_debug_profile,
+              "(debug/profile enable &opt interval)",
+              "Turn the built in profiler on or off. Turning it on throws away the data from any "
+              "earlier run. While on, the profiler counts calls to each function, and records the "
+              "stack of the running fiber once every `interval` steps (default 1000). In builds with "
+              "`JANET_PROFILE` defined, a step is one virtual instruction, and instructions are also "
+              "counted per function and per opcode. Otherwise, a step is one function call. "
+              "Use `debug/profile-report` to get the data. Returns the previous state of the profiler.") {
+    janet_arity(argc, 1, 2);
+    int was_on = janet_vm.profiling;
+    int32_t interval = janet_optnat(argv, argc, 1, 1000);
+    if (interval < 1) janet_panic("expected positive interval");
+    if (janet_truthy(argv[0])) {
+        janet_profile_clear();
+        janet_vm.profile_interval = interval;
+        janet_vm.profile_countdown = interval;
+        janet_vm.profile_stacks = janet_table(0);
+        janet_gcroot(janet_wrap_table(janet_vm.profile_stacks));
+        janet_vm.profiling = 1;
+    } else {
+        janet_vm.profiling = 0;
+    }
+    return janet_wrap_boolean(was_on);
+}
+
+JANET_CORE_FN(cfun_debug_profile_report,
+              "(debug/profile-report &opt format)",
+              "Get the data collected by `debug/profile`. If `format` is :table, the default, returns "
+              "a table with the following keys:\n\n"
+              "* :functions - an array with a table for each function that ran, with its :name, "
+              ":source, :line, :calls, and :instructions\n\n"
+              "* :opcodes - a table of opcode names to the number of times they ran\n\n"
+              "* :stacks - a table of folded stacks to the number of times they were sampled\n\n"
+              "* :samples - the total number of samples\n\n"
+              "If `format` is :folded, returns a buffer with one `frame;frame;frame count` line per "
+              "sampled stack, which is the input format of most flame graph tools.") {
+    janet_arity(argc, 0, 1);
+    int folded = 0;
+    if (argc > 0) {
+        JanetKeyword format = janet_getkeyword(argv, 0);
+        if (!janet_cstrcmp(format, "folded")) {
+            folded = 1;
+        } else if (janet_cstrcmp(format, "table")) {
+            janet_panicf("expected :table or :folded, got %v", argv[0]);
+        }
+    }
+    JanetTable *stacks = janet_vm.profile_stacks;
+    if (folded) {
+        JanetBuffer *buf = janet_buffer(0);
+        if (NULL != stacks && stacks->count > 0) {
+            int32_t *index = janet_smalloc(sizeof(int32_t) * (size_t) stacks->capacity);
+            int32_t n = janet_sorted_keys(stacks->data, stacks->capacity, index);
+            for (int32_t i = 0; i < n; i++) {
+                JanetKV *kv = stacks->data + index[i];
+                janet_formatb(buf, "%S %.0f\n", janet_unwrap_string(kv->key), janet_unwrap_number(kv->value));
+            }
+            janet_sfree(index);
+        }
+        return janet_wrap_buffer(buf);
+    }
+    JanetTable *out = janet_table(4);
+    JanetArray *functions = janet_array(0);
+    for (JanetFuncProfile *p = janet_vm.profile_funcs; NULL != p; p = p->next) {
+        JanetTable *t = janet_table(5);
+        if (p->name) janet_table_put(t, janet_ckeywordv("name"), janet_cstringv(p->name));
+        if (p->source) janet_table_put(t, janet_ckeywordv("source"), janet_cstringv(p->source));
+        janet_table_put(t, janet_ckeywordv("line"), janet_wrap_integer(p->line));
+        janet_table_put(t, janet_ckeywordv("calls"), janet_wrap_number((double) p->calls));
+        janet_table_put(t, janet_ckeywordv("instructions"), janet_wrap_number((double) p->instructions));
+        janet_array_push(functions, janet_wrap_table(t));
+    }
+    JanetTable *opcodes = janet_table(0);
+#ifdef JANET_PROFILE
+    for (uint32_t op = 0; op < 128; op++) {
+        if (janet_vm.profile_ops[op] == 0) continue;
+#ifdef JANET_ASSEMBLER
+        const char *name = janet_opcode_name(op);
+        Janet key = name ? janet_ckeywordv(name) : janet_wrap_integer(op);
+#else
+        Janet key = janet_wrap_integer(op);
+#endif
+        janet_table_put(opcodes, key, janet_wrap_number((double) janet_vm.profile_ops[op]));
+    }
+#endif
+    janet_table_put(out, janet_ckeywordv("functions"), janet_wrap_array(functions));
+    janet_table_put(out, janet_ckeywordv("opcodes"), janet_wrap_table(opcodes));
+    janet_table_put(out, janet_ckeywordv("stacks"), NULL == stacks ? janet_wrap_table(janet_table(0)) : janet_wrap_table(janet_table_clone(stacks)));
+    janet_table_put(out, janet_ckeywordv("samples"), janet_wrap_number((double) janet_vm.profile_samples));
+    return janet_wrap_table(out);
+}
+
+JANET_CORE_FN(cfun_debug_heap_profile,
+              "(debug/heap-profile enable &opt interval)",
+              "Turn the heap profiler on or off. Turning it on throws away the data from any earlier "
+              "run. While on, the profiler samples one allocation for every `interval` bytes allocated "
+              "(default 524288), and records the stack of the running fiber for it. Each sample stands "
+              "for the bytes allocated since the previous sample, and they are counted as live until "
+              "the sampled value is collected. The interval is also used to estimate the live bytes "
+              "of memory groups, see `fiber/memory-group`. Use `debug/heap-profile-report` to get "
+              "the data. Returns the previous state of the profiler.") {
+    janet_arity(argc, 1, 2);
+    int was_on = janet_vm.heap_profiling;
+    if (argc > 1) {
+        double interval = janet_getnumber(argv, 1);
+        if (interval < 1) janet_panic("expected positive interval");
+        janet_vm.heap_sample_interval = (size_t) interval;
+        janet_vm.heap_countdown = (int64_t) interval;
+    }
+    if (janet_truthy(argv[0])) {
+        janet_heap_profile_clear();
+        janet_vm.heap_stack_index = janet_table(0);
+        janet_gcroot(janet_wrap_table(janet_vm.heap_stack_index));
+        janet_vm.heap_profiling = 1;
+    } else {
+        janet_vm.heap_profiling = 0;
+    }
+    return janet_wrap_boolean(was_on);
+}
+
+JANET_CORE_FN(cfun_debug_heap_profile_report,
+              "(debug/heap-profile-report &opt format)",
+              "Get the data collected by `debug/heap-profile`. Live bytes are as of the last "
+              "collection, so call `gccollect` first for an up to date picture. If `format` is "
+              ":table, the default, returns a table with the following keys:\n\n"
+              "* :stacks - a table of folded stacks to tables with the number of `:samples` taken "
+              "there, the estimated `:bytes` allocated there, and the `:live-samples` and "
+              "`:live-bytes` that have not been collected yet\n\n"
+              "* :samples - the total number of samples\n\n"
+              "* :interval - the sampling interval in bytes\n\n"
+              "If `format` is :folded, returns a buffer with one `frame;frame;frame bytes` line per "
+              "stack with live bytes, which flame graph tools can draw. Use :folded-allocated for the "
+              "bytes allocated instead.") {
+    janet_arity(argc, 0, 1);
+    int folded = 0;
+    if (argc > 0) {
+        JanetKeyword format = janet_getkeyword(argv, 0);
+        if (!janet_cstrcmp(format, "folded")) {
+            folded = 1;
+        } else if (!janet_cstrcmp(format, "folded-allocated")) {
+            folded = 2;
+        } else if (janet_cstrcmp(format, "table")) {
+            janet_panicf("expected :table, :folded or :folded-allocated, got %v", argv[0]);
+        }
+    }
+    JanetTable *index = janet_vm.heap_stack_index;
+    if (folded) {
+        JanetBuffer *buf = janet_buffer(0);
+        if (NULL != index && index->count > 0) {
+            int32_t *order = janet_smalloc(sizeof(int32_t) * (size_t) index->capacity);
+            int32_t n = janet_sorted_keys(index->data, index->capacity, order);
+            for (int32_t i = 0; i < n; i++) {
+                JanetKV *kv = index->data + order[i];
+                JanetHeapStack *stack = janet_vm.heap_stacks + janet_unwrap_integer(kv->value);
+                uint64_t bytes = folded == 1 ? stack->live_bytes : stack->bytes;
+                if (bytes) janet_formatb(buf, "%S %d\n", janet_unwrap_string(kv->key), (int64_t) bytes);
+            }
+            janet_sfree(order);
+        }
+        return janet_wrap_buffer(buf);
+    }
+    JanetTable *stacks = janet_table(index ? index->count : 0);
+    if (NULL != index) {
+        /* Allocations below can be sampled and add new stacks to the index */
+        index = janet_table_clone(index);
+        for (int32_t i = 0; i < index->capacity; i++) {
+            JanetKV *kv = index->data + i;
+            if (janet_checktype(kv->key, JANET_NIL)) continue;
+            JanetHeapStack *stack = janet_vm.heap_stacks + janet_unwrap_integer(kv->value);
+            JanetTable *t = janet_table(4);
+            janet_table_put(t, janet_ckeywordv("samples"), janet_wrap_number((double) stack->samples));
+            janet_table_put(t, janet_ckeywordv("bytes"), janet_wrap_number((double) stack->bytes));
+            janet_table_put(t, janet_ckeywordv("live-samples"), janet_wrap_number((double) stack->live_samples));
+            janet_table_put(t, janet_ckeywordv("live-bytes"), janet_wrap_number((double) stack->live_bytes));
+            janet_table_put(stacks, kv->key, janet_wrap_table(t));
+        }
+    }
+    JanetTable *out = janet_table(3);
+    janet_table_put(out, janet_ckeywordv("stacks"), janet_wrap_table(stacks));
+    janet_table_put(out, janet_ckeywordv("samples"), janet_wrap_number((double) janet_vm.heap_sample_total));
+    janet_table_put(out, janet_ckeywordv("interval"), janet_wrap_number((double) janet_vm.heap_sample_interval));
+    return janet_wrap_table(out);
+}
+
 /* Module entry point */
 void janet_lib_debug(JanetTable *env) {
     JanetRegExt debug_cfuns[] = {
@@ -440,6 +795,10 @@ void janet_lib_debug(JanetTable *env) {
         JANET_CORE_REG("debug/stacktrace", cfun_debug_stacktrace),
         JANET_CORE_REG("debug/lineage", cfun_debug_lineage),
         JANET_CORE_REG("debug/step", cfun_debug_step),
+        JANET_CORE_REG("debug/profile", cfun_debug_profile),
+        JANET_CORE_REG("debug/profile-report", cfun_debug_profile_report),
+        JANET_CORE_REG("debug/heap-profile", cfun_debug_heap_profile),
+        JANET_CORE_REG("debug/heap-profile-report", cfun_debug_heap_profile_report),
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, debug_cfuns);
@@ -36,6 +36,7 @@
 #ifdef JANET_WINDOWS
 #include <winsock2.h>
 #include <windows.h>
+#include <mswsock.h>
 #include <io.h>
 #else
 #include <pthread.h>
@@ -50,16 +51,38 @@
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
+#include <sys/uio.h>
+#include <poll.h>
+#ifdef JANET_LINUX
+#include <sys/sendfile.h>
+#endif
 #ifdef JANET_EV_EPOLL
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
 #endif
+#ifdef JANET_EV_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 #ifdef JANET_EV_KQUEUE
 #include <sys/event.h>
 #endif
-#ifdef JANET_EV_POLL
-#include <poll.h>
 #endif
+
+#ifdef JANET_EV_IO_URING
+/* Header at the start of the state of any operation that can be submitted
+ * to io_uring. Completions point back to it. */
+typedef struct {
+    JanetFiber *fiber; /* NULL once the waiting fiber has given up */
+    Janet keep; /* Value the kernel may still read from */
+    uint8_t *scratch; /* Memory the kernel may still write to */
+    int32_t scratch_size;
+    int32_t res;
+    int active;
+    int polling;
+} JanetURingOp;
+static void janet_uring_orphan(JanetFiber *fiber);
 #endif
 
 typedef struct {
@@ -71,8 +94,10 @@ typedef struct {
         JANET_CP_MODE_WRITE,
         JANET_CP_MODE_CHOICE_READ,
         JANET_CP_MODE_CHOICE_WRITE,
-        JANET_CP_MODE_CLOSE
+        JANET_CP_MODE_CLOSE,
+        JANET_CP_MODE_READ_MANY
     } mode;
+    int32_t limit; /* Most values a JANET_CP_MODE_READ_MANY reader will take */
 } JanetChannelPending;
 
 struct JanetChannel {
@@ -105,11 +130,12 @@ typedef struct {
 
 /* Structure used to initialize threads in the thread pool
  * (same head structure as self pipe event)*/
-typedef struct {
+typedef struct JanetEVThreadInit {
     JanetEVGenericMessage msg;
     JanetThreadedCallback cb;
     JanetThreadedSubroutine subr;
     JanetHandle write_pipe;
+    struct JanetEVThreadInit *next; /* for the threaded call pool */
 } JanetEVThreadInit;
 
 /* Structure used to initialize threads that run timeouts */
@@ -202,6 +228,264 @@ static JanetTimestamp ts_delta(JanetTimestamp ts, double delta) {
     return ts;
 }
 
+static void handle_timeout_worker(JanetTimeout to, int cancel);
+
+/* Check if a timeout no longer needs to fire, either because the fiber was
+ * resumed by something else, or because the deadline's fiber is done. Cleans
+ * up after stale timeouts. */
+static int timeout_stale(JanetTimeout to) {
+    if (to.curr_fiber != NULL) {
+        if (janet_fiber_can_resume(to.curr_fiber)) return 0;
+        janet_table_remove(&janet_vm.active_tasks, janet_wrap_fiber(to.curr_fiber));
+    } else if (to.fiber->sched_id == to.sched_id) {
+        return 0;
+    }
+    handle_timeout_worker(to, 1);
+    return 1;
+}
+
+#ifdef JANET_EV_TIMER_WHEEL
+
+/*
+ * Hierarchical timer wheel. Level L has 64 slots of 64^L milliseconds. A timeout
+ * goes in the level of the highest bit where its time differs from the wheel's
+ * current time, so adding one is O(1). As time advances, slots that are reached
+ * are moved to lower levels or to the batch of expired timeouts. Timeouts more than
+ * 64^4 ms (about 4.6 hours) out wait in an overflow list. Stale timeouts are only
+ * removed when they are reached or when looking for the next timeout to wait on.
+ */
+
+static int tw_ctz(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int) index;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+static int tw_clz(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - (int) index;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+static void tw_init(void) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    memset(tw, 0, sizeof(JanetTimerWheel));
+    for (int l = 0; l < JANET_TW_LEVELS; l++) {
+        for (int s = 0; s < JANET_TW_SLOTS; s++) {
+            tw->slots[l][s] = -1;
+        }
+    }
+    tw->overflow = -1;
+    tw->free = -1;
+    tw->now = ts_now();
+}
+
+static int32_t tw_alloc(JanetTimeout to) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    if (tw->free < 0) {
+        int32_t newcap = 2 * tw->capacity + 16;
+        JanetTimerNode *nodes = janet_realloc(tw->nodes, newcap * sizeof(JanetTimerNode));
+        if (NULL == nodes) {
+            JANET_OUT_OF_MEMORY;
+        }
+        for (int32_t i = tw->capacity; i < newcap; i++) {
+            nodes[i].to.fiber = NULL;
+            nodes[i].next = i + 1 < newcap ? i + 1 : -1;
+        }
+        tw->free = tw->capacity;
+        tw->nodes = nodes;
+        tw->capacity = newcap;
+    }
+    int32_t i = tw->free;
+    tw->free = tw->nodes[i].next;
+    tw->nodes[i].to = to;
+    janet_vm.tq_count++;
+    return i;
+}
+
+static void tw_release(int32_t i) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    tw->nodes[i].to.fiber = NULL;
+    tw->nodes[i].next = tw->free;
+    tw->free = i;
+    janet_vm.tq_count--;
+}
+
+static void tw_push_expired(int32_t i) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    if (tw->expired_count == tw->expired_capacity) {
+        int32_t newcap = 2 * tw->expired_capacity + 16;
+        int32_t *expired = janet_realloc(tw->expired, newcap * sizeof(int32_t));
+        if (NULL == expired) {
+            JANET_OUT_OF_MEMORY;
+        }
+        tw->expired = expired;
+        tw->expired_capacity = newcap;
+    }
+    tw->expired[tw->expired_count++] = i;
+}
+
+static void tw_place(int32_t i) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    JanetTimestamp when = tw->nodes[i].to.when;
+    if (when <= tw->now) {
+        tw_push_expired(i);
+        return;
+    }
+    int level = (63 - tw_clz((uint64_t) when ^ (uint64_t) tw->now)) / JANET_TW_BITS;
+    if (level >= JANET_TW_LEVELS) {
+        tw->nodes[i].next = tw->overflow;
+        tw->overflow = i;
+        return;
+    }
+    int slot = (int)(((uint64_t) when >> (level * JANET_TW_BITS)) & (JANET_TW_SLOTS - 1));
+    tw->nodes[i].next = tw->slots[level][slot];
+    tw->slots[level][slot] = i;
+    tw->pending[level] |= (uint64_t) 1 << slot;
+}
+
+/* Advance the wheel to now, moving every timeout that is due to the expired batch */
+static void tw_advance(JanetTimestamp now) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    if (now <= tw->now) return;
+    uint64_t old = (uint64_t) tw->now;
+    uint64_t cur = (uint64_t) now;
+    int32_t todo = -1;
+    int level;
+    tw->now = now;
+    for (level = 0; level < JANET_TW_LEVELS; level++) {
+        int shift = level * JANET_TW_BITS;
+        if ((old >> shift) == (cur >> shift)) break;
+        uint64_t mask;
+        if ((old >> (shift + JANET_TW_BITS)) != (cur >> (shift + JANET_TW_BITS))) {
+            mask = ~(uint64_t) 0;
+        } else {
+            int oi = (int)((old >> shift) & (JANET_TW_SLOTS - 1));
+            int ni = (int)((cur >> shift) & (JANET_TW_SLOTS - 1));
+            mask = (((uint64_t) 2 << ni) - 1) & ~(((uint64_t) 2 << oi) - 1);
+        }
+        uint64_t reached = tw->pending[level] & mask;
+        tw->pending[level] &= ~reached;
+        while (reached) {
+            int slot = tw_ctz(reached);
+            reached &= reached - 1;
+            int32_t i = tw->slots[level][slot];
+            tw->slots[level][slot] = -1;
+            while (i >= 0) {
+                int32_t next = tw->nodes[i].next;
+                tw->nodes[i].next = todo;
+                todo = i;
+                i = next;
+            }
+        }
+    }
+    if (level == JANET_TW_LEVELS) {
+        int32_t i = tw->overflow;
+        tw->overflow = -1;
+        while (i >= 0) {
+            int32_t next = tw->nodes[i].next;
+            tw->nodes[i].next = todo;
+            todo = i;
+            i = next;
+        }
+    }
+    while (todo >= 0) {
+        int32_t next = tw->nodes[todo].next;
+        tw_place(todo);
+        todo = next;
+    }
+}
+
+static int tw_expired_cmp(const void *a, const void *b) {
+    JanetTimerNode *nodes = janet_vm.tw.nodes;
+    JanetTimestamp x = nodes[*(const int32_t *) a].to.when;
+    JanetTimestamp y = nodes[*(const int32_t *) b].to.when;
+    return (x > y) - (x < y);
+}
+
+/* Add a timeout to the timer wheel */
+static void add_timeout(JanetTimeout to) {
+    tw_place(tw_alloc(to));
+}
+
+/* Remove the next timeout that is due by now, if any */
+static int pop_expired_timeout(JanetTimestamp now, JanetTimeout *out) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    if (tw->expired_head == tw->expired_count) {
+        tw->expired_head = 0;
+        tw->expired_count = 0;
+        tw_advance(now);
+        /* Fire in the same order as the heap would */
+        qsort(tw->expired, tw->expired_count, sizeof(int32_t), tw_expired_cmp);
+    }
+    if (tw->expired_head == tw->expired_count) return 0;
+    int32_t i = tw->expired[tw->expired_head++];
+    *out = tw->nodes[i].to;
+    tw_release(i);
+    return 1;
+}
+
+/* Unlink stale timeouts from the front of a list. Returns 1 if a live timeout is left. */
+static int tw_trim(int32_t *link) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    while (*link >= 0) {
+        int32_t i = *link;
+        if (!timeout_stale(tw->nodes[i].to)) return 1;
+        *link = tw->nodes[i].next;
+        tw_release(i);
+    }
+    return 0;
+}
+
+/* Get a time to wake up for the next live timeout, dropping stale timeouts along
+ * the way. The time is exact for the next 64 ms; further out, it is the start of
+ * the slot the timeout is in, and the loop wakes up early to move the slot down. */
+static int next_timeout(JanetTimestamp *when) {
+    JanetTimerWheel *tw = &janet_vm.tw;
+    while (tw->expired_head < tw->expired_count) {
+        int32_t i = tw->expired[tw->expired_head];
+        if (!timeout_stale(tw->nodes[i].to)) {
+            *when = tw->nodes[i].to.when;
+            return 1;
+        }
+        tw->expired_head++;
+        tw_release(i);
+    }
+    uint64_t now = (uint64_t) tw->now;
+    for (int level = 0; level < JANET_TW_LEVELS; level++) {
+        int shift = level * JANET_TW_BITS;
+        int index = (int)((now >> shift) & (JANET_TW_SLOTS - 1));
+        uint64_t ahead = tw->pending[level] & ~(((uint64_t) 2 << index) - 1);
+        while (ahead) {
+            int slot = tw_ctz(ahead);
+            ahead &= ahead - 1;
+            if (tw_trim(&tw->slots[level][slot])) {
+                uint64_t base = (now >> (shift + JANET_TW_BITS)) << (shift + JANET_TW_BITS);
+                *when = (JanetTimestamp)(base | ((uint64_t) slot << shift));
+                if (level == 0) *when = tw->nodes[tw->slots[level][slot]].to.when;
+                return 1;
+            }
+            tw->pending[level] &= ~((uint64_t) 1 << slot);
+        }
+    }
+    if (tw_trim(&tw->overflow)) {
+        int shift = JANET_TW_LEVELS * JANET_TW_BITS;
+        *when = (JanetTimestamp)(((now >> shift) + 1) << shift);
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
 /* Look at the next timeout value without removing it. */
 static int peek_timeout(JanetTimeout *out) {
     if (janet_vm.tq_count == 0) return 0;
@@ -261,6 +545,28 @@ static void add_timeout(JanetTimeout to) {
     }
 }
 
+/* Remove the next timeout that is due by now, if any */
+static int pop_expired_timeout(JanetTimestamp now, JanetTimeout *out) {
+    if (!peek_timeout(out) || out->when > now) return 0;
+    pop_timeout(0);
+    return 1;
+}
+
+/* Get the time of the next live timeout, dropping stale timeouts along the way */
+static int next_timeout(JanetTimestamp *when) {
+    JanetTimeout to;
+    while (peek_timeout(&to)) {
+        if (!timeout_stale(to)) {
+            *when = to.when;
+            return 1;
+        }
+        pop_timeout(0);
+    }
+    return 0;
+}
+
+#endif
+
 void janet_async_end(JanetFiber *fiber) {
     if (fiber->ev_callback) {
         if (fiber->ev_stream->read_fiber == fiber) {
@@ -279,11 +585,17 @@ void janet_async_end(JanetFiber *fiber) {
             }
             janet_ev_dec_refcount();
         }
+#ifdef JANET_EV_IO_URING
+        else {
+            /* The kernel still owns the state, the completion will free it */
+            janet_uring_orphan(fiber);
+        }
+#endif
     }
 }
 
 void janet_async_in_flight(JanetFiber *fiber) {
-#ifdef JANET_WINDOWS
+#if defined(JANET_WINDOWS) || defined(JANET_EV_IO_URING)
     fiber->flags |= JANET_FIBER_EV_FLAG_IN_FLIGHT;
 #else
     (void) fiber;
@@ -344,6 +656,7 @@ JanetStream *janet_stream_ext(JanetHandle handle, uint32_t flags, const JanetMet
     stream->methods = methods;
     stream->index = 0;
     janet_register_stream(stream);
+    janet_vm.ev_stats.streams++;
     return stream;
 }
 
@@ -352,6 +665,7 @@ JanetStream *janet_stream(JanetHandle handle, uint32_t flags, const JanetMethod
 }
 
 static void janet_stream_close_impl(JanetStream *stream) {
+    if (!(stream->flags & JANET_STREAM_CLOSED)) janet_vm.ev_stats.streams--;
     stream->flags |= JANET_STREAM_CLOSED;
     int canclose = !(stream->flags & JANET_STREAM_NOT_CLOSEABLE);
 #ifdef JANET_WINDOWS
@@ -565,12 +879,31 @@ void janet_ev_mark(void) {
     }
 
     /* Pending timeouts */
+#ifdef JANET_EV_TIMER_WHEEL
+    JanetTimerNode *nodes = janet_vm.tw.nodes;
+    for (int32_t i = 0; i < janet_vm.tw.capacity; i++) {
+        if (NULL == nodes[i].to.fiber) continue;
+        janet_mark(janet_wrap_fiber(nodes[i].to.fiber));
+        if (nodes[i].to.curr_fiber != NULL) {
+            janet_mark(janet_wrap_fiber(nodes[i].to.curr_fiber));
+        }
+    }
+#else
     for (size_t i = 0; i < janet_vm.tq_count; i++) {
         janet_mark(janet_wrap_fiber(janet_vm.tq[i].fiber));
         if (janet_vm.tq[i].curr_fiber != NULL) {
             janet_mark(janet_wrap_fiber(janet_vm.tq[i].curr_fiber));
         }
     }
+#endif
+
+    /* Slow iteration handler */
+    if (NULL != janet_vm.ev_stats.slow_handler) {
+        janet_mark(janet_wrap_function(janet_vm.ev_stats.slow_handler));
+        if (NULL != janet_vm.ev_stats.slow_env) {
+            janet_mark(janet_wrap_table(janet_vm.ev_stats.slow_env));
+        }
+    }
 }
 
 static int janet_channel_push(JanetChannel *channel, Janet x, int mode);
@@ -591,13 +924,19 @@ static Janet make_supervisor_event(const char *name, JanetFiber *fiber, int thre
 /* Common init code */
 void janet_ev_init_common(void) {
     janet_q_init(&janet_vm.spawn);
-    janet_vm.tq = NULL;
     janet_vm.tq_count = 0;
+#ifdef JANET_EV_TIMER_WHEEL
+    tw_init();
+#else
+    janet_vm.tq = NULL;
     janet_vm.tq_capacity = 0;
+#endif
     janet_table_init_raw(&janet_vm.threaded_abstracts, 0);
     janet_table_init_raw(&janet_vm.active_tasks, 0);
     janet_table_init_raw(&janet_vm.signal_handlers, 0);
     janet_rng_seed(&janet_vm.ev_rng, 0);
+    janet_vm.pool_worker = NULL;
+    memset(&janet_vm.ev_stats, 0, sizeof(janet_vm.ev_stats));
 #ifndef JANET_WINDOWS
     pthread_attr_init(&janet_vm.new_thread_attr);
     pthread_attr_setdetachstate(&janet_vm.new_thread_attr, PTHREAD_CREATE_DETACHED);
@@ -637,13 +976,23 @@ static void handle_timeout_worker(JanetTimeout to, int cancel) {
 
 /* Common deinit code */
 void janet_ev_deinit_common(void) {
+#ifdef JANET_EV_TIMER_WHEEL
+    for (int32_t i = 0; i < janet_vm.tw.capacity; i++) {
+        if (NULL != janet_vm.tw.nodes[i].to.fiber) {
+            handle_timeout_worker(janet_vm.tw.nodes[i].to, 1);
+        }
+    }
+    janet_free(janet_vm.tw.nodes);
+    janet_free(janet_vm.tw.expired);
+#else
     JanetTimeout to;
     while (peek_timeout(&to)) {
         handle_timeout_worker(to, 1);
         pop_timeout(0);
     }
-    janet_q_deinit(&janet_vm.spawn);
     janet_free(janet_vm.tq);
+#endif
+    janet_q_deinit(&janet_vm.spawn);
     janet_table_deinit(&janet_vm.threaded_abstracts);
     janet_table_deinit(&janet_vm.active_tasks);
     janet_table_deinit(&janet_vm.signal_handlers);
@@ -921,6 +1270,8 @@ static Janet make_close_result(JanetChannel *channel) {
     return janet_wrap_tuple(janet_tuple_end(tup));
 }
 
+static int janet_channel_deliver_with_lock(JanetChannel *channel, const Janet *xs, int32_t n);
+
 /* Callback to use for scheduling a fiber from another thread. */
 static void janet_thread_chan_cb(JanetEVGenericMessage msg) {
     uint32_t sched_id = (uint32_t) msg.argi;
@@ -935,7 +1286,7 @@ static void janet_thread_chan_cb(JanetEVGenericMessage msg) {
             janet_schedule(fiber, make_read_result(channel, x));
         } else if (mode == JANET_CP_MODE_CHOICE_WRITE) {
             janet_schedule(fiber, make_write_result(channel));
-        } else if (mode == JANET_CP_MODE_READ) {
+        } else if (mode == JANET_CP_MODE_READ || mode == JANET_CP_MODE_READ_MANY) {
             janet_assert(!janet_chan_unpack(channel, &x, 0), "packing error");
             janet_schedule(fiber, x);
         } else if (mode == JANET_CP_MODE_WRITE) {
@@ -946,20 +1297,17 @@ static void janet_thread_chan_cb(JanetEVGenericMessage msg) {
     } else if (mode != JANET_CP_MODE_CLOSE) {
         /* Fiber has already been cancelled or resumed. */
         /* Resend event to another waiting thread, depending on mode */
-        int is_read = (mode == JANET_CP_MODE_CHOICE_READ) || (mode == JANET_CP_MODE_READ);
+        int is_read = (mode == JANET_CP_MODE_CHOICE_READ) ||
+                      (mode == JANET_CP_MODE_READ) ||
+                      (mode == JANET_CP_MODE_READ_MANY);
         if (is_read) {
-            JanetChannelPending reader;
-            while (!janet_q_pop(&channel->read_pending, &reader, sizeof(reader))) {
-                JanetVM *vm = reader.thread;
-                if (!vm) continue;
-                JanetEVGenericMessage msg;
-                msg.tag = reader.mode;
-                msg.fiber = reader.fiber;
-                msg.argi = (int32_t) reader.sched_id;
-                msg.argp = channel;
-                msg.argj = x;
-                janet_ev_post_event(vm, janet_thread_chan_cb, msg);
-                break;
+            /* Values are handed to the next reader, or put back in the queue if there is none. */
+            janet_assert(!janet_chan_unpack(channel, &x, 0), "packing error");
+            if (mode == JANET_CP_MODE_READ_MANY) {
+                JanetArray *batch = janet_unwrap_array(x);
+                janet_channel_deliver_with_lock(channel, batch->data, batch->count);
+            } else {
+                janet_channel_deliver_with_lock(channel, &x, 1);
             }
         } else {
             JanetChannelPending writer;
@@ -980,65 +1328,46 @@ static void janet_thread_chan_cb(JanetEVGenericMessage msg) {
     janet_chan_unlock(channel);
 }
 
-/* Push a value to a channel, and return 1 if channel should block, zero otherwise.
- * If the push would block, will add to the write_pending queue in the channel.
- * Handles both threaded and unthreaded channels. */
-static int janet_channel_push_with_lock(JanetChannel *channel, Janet x, int mode) {
-    JanetChannelPending reader;
-    int is_empty;
-    if (janet_chan_pack(channel, &x)) {
-        janet_chan_unlock(channel);
-        janet_panicf("failed to pack value for channel: %v", x);
-    }
-    if (channel->closed) {
-        janet_chan_unlock(channel);
-        janet_panic("cannot write to closed channel");
-    }
+/* Hand values to waiting readers, and queue the values left over. A reader taking many
+ * values gets as many as it asked for in a single array. Expects the lock to be held,
+ * and returns 1 if the queue overflowed. */
+static int janet_channel_deliver_with_lock(JanetChannel *channel, const Janet *xs, int32_t n) {
     int is_threaded = janet_chan_is_threaded(channel);
-    if (is_threaded) {
-        /* don't dereference fiber from another thread */
-        is_empty = janet_q_pop(&channel->read_pending, &reader, sizeof(reader));
-    } else {
-        do {
+    int32_t i = 0;
+    while (i < n) {
+        JanetChannelPending reader;
+        int is_empty;
+        if (is_threaded) {
+            /* don't dereference fiber from another thread */
             is_empty = janet_q_pop(&channel->read_pending, &reader, sizeof(reader));
-        } while (!is_empty && (reader.sched_id != reader.fiber->sched_id));
-    }
-    if (is_empty) {
-        /* No pending reader */
-        if (janet_q_push(&channel->items, &x, sizeof(Janet))) {
-            janet_chan_unlock(channel);
-            janet_panicf("channel overflow: %v", x);
-        } else if (janet_q_count(&channel->items) > channel->limit) {
-            /* No root fiber, we are in completion on a root fiber. Don't block. */
-            if (mode == 2) {
-                janet_chan_unlock(channel);
-                return 1;
-            }
-            /* Pushed successfully, but should block. */
-            JanetChannelPending pending;
-            pending.thread = &janet_vm;
-            pending.fiber = janet_vm.root_fiber,
-            pending.sched_id = janet_vm.root_fiber->sched_id,
-            pending.mode = mode ? JANET_CP_MODE_CHOICE_WRITE : JANET_CP_MODE_WRITE;
-            janet_q_push(&channel->write_pending, &pending, sizeof(pending));
-            janet_chan_unlock(channel);
-            if (is_threaded) {
-                janet_gcroot(janet_wrap_fiber(pending.fiber));
-            }
-            return 1;
+        } else {
+            do {
+                is_empty = janet_q_pop(&channel->read_pending, &reader, sizeof(reader));
+            } while (!is_empty && (reader.sched_id != reader.fiber->sched_id));
+        }
+        if (is_empty) break;
+        Janet x = xs[i];
+        if (reader.mode == JANET_CP_MODE_READ_MANY) {
+            int32_t count = n - i;
+            if (count > reader.limit) count = reader.limit;
+            x = janet_wrap_array(janet_array_n(xs + i, count));
+            i += count;
+        } else {
+            i++;
         }
-    } else {
-        /* Pending reader */
         if (is_threaded) {
             JanetVM *vm = reader.thread;
-            JanetEVGenericMessage msg;
-            msg.tag = reader.mode;
-            msg.fiber = reader.fiber;
-            msg.argi = (int32_t) reader.sched_id;
-            msg.argp = channel;
-            msg.argj = x;
+            janet_chan_pack(channel, &x);
             if (vm) {
+                JanetEVGenericMessage msg;
+                msg.tag = reader.mode;
+                msg.fiber = reader.fiber;
+                msg.argi = (int32_t) reader.sched_id;
+                msg.argp = channel;
+                msg.argj = x;
                 janet_ev_post_event(vm, janet_thread_chan_cb, msg);
+            } else {
+                janet_chan_unpack(channel, &x, 1);
             }
         } else {
             if (reader.mode == JANET_CP_MODE_CHOICE_READ) {
@@ -1048,45 +1377,84 @@ static int janet_channel_push_with_lock(JanetChannel *channel, Janet x, int mode
             }
         }
     }
-    janet_chan_unlock(channel);
+    for (; i < n; i++) {
+        Janet x = xs[i];
+        janet_chan_pack(channel, &x);
+        if (janet_q_push(&channel->items, &x, sizeof(Janet))) {
+            janet_chan_unpack(channel, &x, 1);
+            return 1;
+        }
+    }
     return 0;
 }
 
-static int janet_channel_push(JanetChannel *channel, Janet x, int mode) {
-    janet_chan_lock(channel);
-    return janet_channel_push_with_lock(channel, x, mode);
-}
-
-/* Pop from a channel - returns 1 if item was obtained, 0 otherwise. The item
- * is returned by reference. If the pop would block, will add to the read_pending
- * queue in the channel. */
-static int janet_channel_pop_with_lock(JanetChannel *channel, Janet *item, int is_choice) {
-    JanetChannelPending writer;
+/* Push values to a channel, and return 1 if channel should block, zero otherwise.
+ * If the push would block, will add to the write_pending queue in the channel.
+ * Handles both threaded and unthreaded channels. */
+static int janet_channel_push_many_with_lock(JanetChannel *channel, const Janet *xs, int32_t n, int mode) {
     if (channel->closed) {
         janet_chan_unlock(channel);
-        *item = janet_wrap_nil();
-        return 1;
+        janet_panic("cannot write to closed channel");
     }
     int is_threaded = janet_chan_is_threaded(channel);
-    if (janet_q_pop(&channel->items, item, sizeof(Janet))) {
-        /* Queue empty */
-        if (is_choice == 2) return 0; // Skip pending read
+    int overflow = 0;
+    if (is_threaded) {
+        /* Packing values can fail, so don't leave the channel locked */
+        JanetTryState tstate;
+        JanetSignal signal = janet_try(&tstate);
+        if (!signal) {
+            overflow = janet_channel_deliver_with_lock(channel, xs, n);
+        }
+        janet_restore(&tstate);
+        if (signal) {
+            janet_chan_unlock(channel);
+            janet_panicv(tstate.payload);
+        }
+    } else {
+        overflow = janet_channel_deliver_with_lock(channel, xs, n);
+    }
+    if (overflow) {
+        janet_chan_unlock(channel);
+        janet_panic("channel overflow");
+    }
+    if (janet_q_count(&channel->items) > channel->limit) {
+        /* No root fiber, we are in completion on a root fiber. Don't block. */
+        if (mode == 2) {
+            janet_chan_unlock(channel);
+            return 1;
+        }
+        /* Pushed successfully, but should block. */
         JanetChannelPending pending;
         pending.thread = &janet_vm;
         pending.fiber = janet_vm.root_fiber,
-        pending.sched_id = janet_vm.root_fiber->sched_id;
-        pending.mode = is_choice ? JANET_CP_MODE_CHOICE_READ : JANET_CP_MODE_READ;
-        janet_q_push(&channel->read_pending, &pending, sizeof(pending));
+        pending.sched_id = janet_vm.root_fiber->sched_id,
+        pending.mode = mode ? JANET_CP_MODE_CHOICE_WRITE : JANET_CP_MODE_WRITE;
+        janet_q_push(&channel->write_pending, &pending, sizeof(pending));
         janet_chan_unlock(channel);
         if (is_threaded) {
             janet_gcroot(janet_wrap_fiber(pending.fiber));
         }
-        return 0;
+        return 1;
     }
-    janet_assert(!janet_chan_unpack(channel, item, 0), "bad channel packing");
+    janet_chan_unlock(channel);
+    return 0;
+}
+
+static int janet_channel_push_with_lock(JanetChannel *channel, Janet x, int mode) {
+    return janet_channel_push_many_with_lock(channel, &x, 1, mode);
+}
+
+static int janet_channel_push(JanetChannel *channel, Janet x, int mode) {
+    janet_chan_lock(channel);
+    return janet_channel_push_with_lock(channel, x, mode);
+}
+
+/* Let one pending writer know that a value was taken. Expects the lock to be held. */
+static void janet_channel_wake_writer(JanetChannel *channel) {
+    JanetChannelPending writer;
     if (!janet_q_pop(&channel->write_pending, &writer, sizeof(writer))) {
         /* Pending writer */
-        if (is_threaded) {
+        if (janet_chan_is_threaded(channel)) {
             JanetVM *vm = writer.thread;
             JanetEVGenericMessage msg;
             msg.tag = writer.mode;
@@ -1105,6 +1473,40 @@ static int janet_channel_pop_with_lock(JanetChannel *channel, Janet *item, int i
             }
         }
     }
+}
+
+/* Add the current fiber to the readers waiting on a channel, and unlock it. */
+static void janet_channel_wait_read(JanetChannel *channel, int mode, int32_t limit) {
+    JanetChannelPending pending;
+    pending.thread = &janet_vm;
+    pending.fiber = janet_vm.root_fiber,
+    pending.sched_id = janet_vm.root_fiber->sched_id;
+    pending.mode = mode;
+    pending.limit = limit;
+    janet_q_push(&channel->read_pending, &pending, sizeof(pending));
+    janet_chan_unlock(channel);
+    if (janet_chan_is_threaded(channel)) {
+        janet_gcroot(janet_wrap_fiber(pending.fiber));
+    }
+}
+
+/* Pop from a channel - returns 1 if item was obtained, 0 otherwise. The item
+ * is returned by reference. If the pop would block, will add to the read_pending
+ * queue in the channel. */
+static int janet_channel_pop_with_lock(JanetChannel *channel, Janet *item, int is_choice) {
+    if (channel->closed) {
+        janet_chan_unlock(channel);
+        *item = janet_wrap_nil();
+        return 1;
+    }
+    if (janet_q_pop(&channel->items, item, sizeof(Janet))) {
+        /* Queue empty */
+        if (is_choice == 2) return 0; // Skip pending read
+        janet_channel_wait_read(channel, is_choice ? JANET_CP_MODE_CHOICE_READ : JANET_CP_MODE_READ, 1);
+        return 0;
+    }
+    janet_assert(!janet_chan_unpack(channel, item, 0), "bad channel packing");
+    janet_channel_wake_writer(channel);
     janet_chan_unlock(channel);
     return 1;
 }
@@ -1114,6 +1516,35 @@ static int janet_channel_pop(JanetChannel *channel, Janet *item, int is_choice)
     return janet_channel_pop_with_lock(channel, item, is_choice);
 }
 
+/* Pop up to limit items from a channel into an array - returns 1 if items were obtained,
+ * 0 if the current fiber should wait. */
+static int janet_channel_pop_many(JanetChannel *channel, int32_t limit, Janet *out) {
+    janet_chan_lock(channel);
+    if (channel->closed) {
+        janet_chan_unlock(channel);
+        *out = janet_wrap_nil();
+        return 1;
+    }
+    int32_t count = janet_q_count(&channel->items);
+    if (count == 0) {
+        janet_channel_wait_read(channel, JANET_CP_MODE_READ_MANY, limit);
+        return 0;
+    }
+    if (count > limit) count = limit;
+    JanetArray *array = janet_array(count);
+    for (int32_t i = 0; i < count; i++) {
+        Janet item;
+        janet_q_pop(&channel->items, &item, sizeof(Janet));
+        janet_assert(!janet_chan_unpack(channel, &item, 0), "bad channel packing");
+        array->data[i] = item;
+        janet_channel_wake_writer(channel);
+    }
+    array->count = count;
+    janet_chan_unlock(channel);
+    *out = janet_wrap_array(array);
+    return 1;
+}
+
 JanetChannel *janet_channel_unwrap(void *abstract) {
     return abstract;
 }
@@ -1145,12 +1576,462 @@ JanetChannel *janet_channel_make(uint32_t limit) {
     return channel;
 }
 
-JanetChannel *janet_channel_make_threaded(uint32_t limit) {
-    janet_assert(limit <= INT32_MAX, "bad limit");
-    JanetChannel *channel = janet_abstract_threaded(&janet_channel_type, sizeof(JanetChannel));
-    janet_chan_init(channel, (int32_t) limit, 0);
-    return channel;
-}
+/*
+ * Ring channels. Bounded lock-free queues between threads, with one consumer and
+ * either one producer (spsc) or many (mpsc). Each slot has a sequence number, as in
+ * Vyukov's bounded queue. Values are packed like for threaded channels, except that
+ * strings, symbols, keywords and buffers are copied as raw bytes. A waiting reader
+ * is woken by a single event no matter how many values arrive before it runs.
+ * Writers only take a lock when the ring is full.
+ */
+
+#ifdef _MSC_VER
+#define janet_ring_load(p) InterlockedOr((p), 0)
+#define janet_ring_store(p, v) InterlockedExchange((p), (v))
+#define janet_ring_exchange(p, v) InterlockedExchange((p), (v))
+#define janet_ring_cas(p, old, new) (InterlockedCompareExchange((p), (new), (old)) == (old))
+#define janet_ring_fence() MemoryBarrier()
+#elif defined(JANET_USE_STDATOMIC)
+#define janet_ring_load(p) atomic_load_explicit((_Atomic JanetAtomicInt *)(p), memory_order_acquire)
+#define janet_ring_store(p, v) atomic_store_explicit((_Atomic JanetAtomicInt *)(p), (v), memory_order_release)
+#define janet_ring_exchange(p, v) atomic_exchange((_Atomic JanetAtomicInt *)(p), (v))
+#define janet_ring_cas(p, old, new) atomic_compare_exchange_weak((_Atomic JanetAtomicInt *)(p), &(old), (new))
+#define janet_ring_fence() atomic_thread_fence(memory_order_seq_cst)
+#else
+#define janet_ring_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define janet_ring_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define janet_ring_exchange(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define janet_ring_cas(p, old, new) __atomic_compare_exchange_n((p), &(old), (new), 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#define janet_ring_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/* Positions wrap around, so do arithmetic on them unsigned */
+#define janet_ring_add(x, n) ((JanetAtomicInt)((uint32_t)(x) + (uint32_t)(n)))
+#define janet_ring_diff(x, y) ((int32_t)((uint32_t)(x) - (uint32_t)(y)))
+
+#define JANET_RING_MAX_CAPACITY 0x1000000
+
+typedef enum {
+    JANET_RING_RAW,
+    JANET_RING_BYTES,
+    JANET_RING_MARSHAL
+} JanetRingItemKind;
+
+typedef struct {
+    Janet value; /* Pointer to a JanetRingBytes or JanetBuffer unless kind is JANET_RING_RAW */
+    JanetRingItemKind kind;
+} JanetRingItem;
+
+typedef struct {
+    JanetType type;
+    int32_t length;
+    uint8_t data[];
+} JanetRingBytes;
+
+typedef struct {
+    JanetAtomicInt seq;
+    JanetRingItem item;
+} JanetRingSlot;
+
+typedef struct JanetRingWriter {
+    struct JanetRing *ring;
+    JanetVM *vm;
+    JanetFiber *fiber;
+    uint32_t sched_id;
+    JanetRingItem item;
+    struct JanetRingWriter *next;
+} JanetRingWriter;
+
+typedef struct JanetRing {
+    JanetRingSlot *slots;
+    int32_t capacity; /* power of 2 */
+    int single_producer;
+    JanetAtomicInt head; /* Only moved by the consumer */
+    JanetAtomicInt tail;
+    JanetAtomicInt closed;
+    /* Waiting reader. Only touched from the consumer thread. */
+    JanetAtomicInt reader_waiting;
+    JanetFiber *reader_fiber;
+    uint32_t reader_sched_id;
+    JanetVM *reader_vm;
+    /* Writers waiting for space */
+    JanetAtomicInt writers_waiting;
+    JanetRingWriter *writers;
+    JanetRingWriter *writers_tail;
+#ifdef JANET_WINDOWS
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} JanetRing;
+
+static JanetRingItem janet_ring_pack(Janet x) {
+    JanetRingItem item;
+    item.value = x;
+    item.kind = JANET_RING_RAW;
+    switch (janet_type(x)) {
+        case JANET_NIL:
+        case JANET_NUMBER:
+        case JANET_POINTER:
+        case JANET_BOOLEAN:
+        case JANET_CFUNCTION:
+            break;
+        case JANET_STRING:
+        case JANET_SYMBOL:
+        case JANET_KEYWORD:
+        case JANET_BUFFER: {
+            JanetByteView view;
+            janet_bytes_view(x, &view.bytes, &view.len);
+            JanetRingBytes *bytes = janet_malloc(sizeof(JanetRingBytes) + view.len);
+            if (NULL == bytes) {
+                JANET_OUT_OF_MEMORY;
+            }
+            bytes->type = janet_type(x);
+            bytes->length = view.len;
+            if (view.len) memcpy(bytes->data, view.bytes, view.len);
+            item.value = janet_wrap_pointer(bytes);
+            item.kind = JANET_RING_BYTES;
+            break;
+        }
+        default: {
+            JanetBuffer *buf = janet_malloc(sizeof(JanetBuffer));
+            if (NULL == buf) {
+                JANET_OUT_OF_MEMORY;
+            }
+            janet_buffer_init(buf, 10);
+            JanetTryState tstate;
+            JanetSignal signal = janet_try(&tstate);
+            if (!signal) {
+                janet_marshal(buf, x, NULL, JANET_MARSHAL_UNSAFE);
+            }
+            janet_restore(&tstate);
+            if (signal) {
+                janet_buffer_deinit(buf);
+                janet_free(buf);
+                janet_panicv(tstate.payload);
+            }
+            item.value = janet_wrap_pointer(buf);
+            item.kind = JANET_RING_MARSHAL;
+            break;
+        }
+    }
+    return item;
+}
+
+/* Unpack an item, or free it if is_cleanup is set */
+static Janet janet_ring_unpack(JanetRingItem item, int is_cleanup) {
+    switch (item.kind) {
+        default:
+            return item.value;
+        case JANET_RING_BYTES: {
+            JanetRingBytes *bytes = janet_unwrap_pointer(item.value);
+            Janet x = janet_wrap_nil();
+            if (!is_cleanup) {
+                switch (bytes->type) {
+                    default:
+                        x = janet_stringv(bytes->data, bytes->length);
+                        break;
+                    case JANET_SYMBOL:
+                        x = janet_symbolv(bytes->data, bytes->length);
+                        break;
+                    case JANET_KEYWORD:
+                        x = janet_keywordv(bytes->data, bytes->length);
+                        break;
+                    case JANET_BUFFER: {
+                        JanetBuffer *buf = janet_buffer(bytes->length);
+                        janet_buffer_push_bytes(buf, bytes->data, bytes->length);
+                        x = janet_wrap_buffer(buf);
+                        break;
+                    }
+                }
+            }
+            janet_free(bytes);
+            return x;
+        }
+        case JANET_RING_MARSHAL: {
+            JanetBuffer *buf = janet_unwrap_pointer(item.value);
+            int flags = is_cleanup ? (JANET_MARSHAL_UNSAFE | JANET_MARSHAL_DECREF) : JANET_MARSHAL_UNSAFE;
+            Janet x = janet_unmarshal(buf->data, buf->count, flags, NULL, NULL);
+            janet_buffer_deinit(buf);
+            janet_free(buf);
+            return x;
+        }
+    }
+}
+
+static int32_t janet_ring_count(JanetRing *ring) {
+    int32_t count = janet_ring_diff(janet_ring_load(&ring->tail), janet_ring_load(&ring->head));
+    if (count < 0) return 0;
+    return count > ring->capacity ? ring->capacity : count;
+}
+
+static int janet_ring_gc(void *p, size_t s);
+
+/* Drop a reference held by a posted event */
+static void janet_ring_release(JanetRing *ring) {
+    if (0 == janet_abstract_decref(ring)) {
+        janet_ring_gc(ring, sizeof(JanetRing));
+        janet_free(janet_abstract_head(ring));
+    }
+}
+
+static void janet_ring_reader_cb(JanetEVGenericMessage msg);
+static void janet_ring_writer_cb(JanetEVGenericMessage msg);
+
+static void janet_ring_wake_reader(JanetRing *ring) {
+    if (janet_ring_exchange(&ring->reader_waiting, 0)) {
+        JanetEVGenericMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.argp = ring;
+        janet_abstract_incref(ring);
+        janet_ev_post_event(ring->reader_vm, janet_ring_reader_cb, msg);
+    }
+}
+
+static void janet_ring_wake_writer(JanetRing *ring) {
+    JanetRingWriter *writer = NULL;
+    janet_os_mutex_lock((JanetOSMutex *) &ring->lock);
+    writer = ring->writers;
+    if (NULL != writer) {
+        ring->writers = writer->next;
+        if (NULL == ring->writers) {
+            ring->writers_tail = NULL;
+            janet_ring_store(&ring->writers_waiting, 0);
+        }
+    }
+    janet_os_mutex_unlock((JanetOSMutex *) &ring->lock);
+    if (NULL != writer) {
+        JanetEVGenericMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.argp = writer;
+        janet_abstract_incref(ring);
+        janet_ev_post_event(writer->vm, janet_ring_writer_cb, msg);
+    }
+}
+
+/* Returns 0 if the ring is full */
+static int janet_ring_try_push(JanetRing *ring, JanetRingItem item) {
+    JanetAtomicInt pos = janet_ring_load(&ring->tail);
+    JanetRingSlot *slot;
+    for (;;) {
+        slot = ring->slots + (pos & (ring->capacity - 1));
+        int32_t diff = janet_ring_diff(janet_ring_load(&slot->seq), pos);
+        if (diff == 0) {
+            if (ring->single_producer) {
+                janet_ring_store(&ring->tail, janet_ring_add(pos, 1));
+                break;
+            }
+            JanetAtomicInt expected = pos;
+            if (janet_ring_cas(&ring->tail, expected, janet_ring_add(pos, 1))) break;
+        } else if (diff < 0) {
+            return 0;
+        }
+        pos = janet_ring_load(&ring->tail);
+    }
+    slot->item = item;
+    janet_ring_store(&slot->seq, janet_ring_add(pos, 1));
+    /* Pairs with the fence in janet_ring_wait_reader */
+    janet_ring_fence();
+    janet_ring_wake_reader(ring);
+    return 1;
+}
+
+/* Only called from the consumer thread. Returns 0 if the ring is empty. */
+static int janet_ring_try_pop(JanetRing *ring, JanetRingItem *out) {
+    JanetAtomicInt pos = ring->head;
+    JanetRingSlot *slot = ring->slots + (pos & (ring->capacity - 1));
+    if (janet_ring_diff(janet_ring_load(&slot->seq), janet_ring_add(pos, 1)) < 0) return 0;
+    *out = slot->item;
+    janet_ring_store(&slot->seq, janet_ring_add(pos, ring->capacity));
+    janet_ring_store(&ring->head, janet_ring_add(pos, 1));
+    /* Pairs with the fence in janet_ring_wait_writer */
+    janet_ring_fence();
+    if (janet_ring_load(&ring->writers_waiting)) janet_ring_wake_writer(ring);
+    return 1;
+}
+
+static int janet_ring_has_data(JanetRing *ring) {
+    JanetAtomicInt pos = ring->head;
+    JanetRingSlot *slot = ring->slots + (pos & (ring->capacity - 1));
+    return janet_ring_diff(janet_ring_load(&slot->seq), janet_ring_add(pos, 1)) >= 0;
+}
+
+/* Try to take a value, or register the current fiber as the waiting reader. Returns 1
+ * with a value, or 0 if the fiber should wait. */
+static int janet_ring_take_or_wait(JanetRing *ring, Janet *out, JanetFiber *fiber, uint32_t sched_id) {
+    JanetRingItem item;
+    for (;;) {
+        if (janet_ring_try_pop(ring, &item)) {
+            *out = janet_ring_unpack(item, 0);
+            return 1;
+        }
+        if (janet_ring_load(&ring->closed)) {
+            *out = janet_wrap_nil();
+            return 1;
+        }
+        ring->reader_fiber = fiber;
+        ring->reader_sched_id = sched_id;
+        ring->reader_vm = janet_local_vm();
+        janet_ring_exchange(&ring->reader_waiting, 1);
+        janet_ring_fence();
+        if (!janet_ring_has_data(ring) && !janet_ring_load(&ring->closed)) return 0;
+        /* Raced with a writer - if it already claimed the wakeup, let the event handle it */
+        if (!janet_ring_exchange(&ring->reader_waiting, 0)) return 0;
+        ring->reader_fiber = NULL;
+    }
+}
+
+static void janet_ring_reader_cb(JanetEVGenericMessage msg) {
+    JanetRing *ring = (JanetRing *) msg.argp;
+    JanetFiber *fiber = ring->reader_fiber;
+    if (NULL != fiber && !janet_ring_load(&ring->reader_waiting)) {
+        ring->reader_fiber = NULL;
+        janet_gcunroot(janet_wrap_fiber(fiber));
+        if (fiber->sched_id == ring->reader_sched_id) {
+            Janet x;
+            if (janet_ring_take_or_wait(ring, &x, fiber, ring->reader_sched_id)) {
+                janet_schedule(fiber, x);
+            } else {
+                janet_gcroot(janet_wrap_fiber(fiber));
+            }
+        }
+    }
+    janet_ring_release(ring);
+}
+
+/* Try to give a value, or add the current fiber to the waiting writers. Returns 1 if the
+ * value was given, 0 if the fiber should wait. Takes ownership of writer. */
+static int janet_ring_give_or_wait(JanetRing *ring, JanetRingWriter *writer) {
+    if (janet_ring_try_push(ring, writer->item)) {
+        janet_free(writer);
+        return 1;
+    }
+    janet_os_mutex_lock((JanetOSMutex *) &ring->lock);
+    writer->next = NULL;
+    if (NULL == ring->writers_tail) {
+        ring->writers = writer;
+    } else {
+        ring->writers_tail->next = writer;
+    }
+    ring->writers_tail = writer;
+    janet_ring_exchange(&ring->writers_waiting, 1);
+    janet_ring_fence();
+    /* The reader may have made space before it could see that we are waiting */
+    int has_space = janet_ring_count(ring) < ring->capacity;
+    janet_os_mutex_unlock((JanetOSMutex *) &ring->lock);
+    if (has_space) janet_ring_wake_writer(ring);
+    return 0;
+}
+
+static void janet_ring_writer_cb(JanetEVGenericMessage msg) {
+    JanetRingWriter *writer = (JanetRingWriter *) msg.argp;
+    JanetRing *ring = writer->ring;
+    JanetFiber *fiber = writer->fiber;
+    if (fiber->sched_id != writer->sched_id) {
+        /* Fiber was canceled */
+        janet_gcunroot(janet_wrap_fiber(fiber));
+        janet_ring_unpack(writer->item, 1);
+        janet_free(writer);
+    } else if (janet_ring_load(&ring->closed)) {
+        janet_gcunroot(janet_wrap_fiber(fiber));
+        janet_ring_unpack(writer->item, 1);
+        janet_free(writer);
+        janet_schedule(fiber, janet_wrap_nil());
+    } else if (janet_ring_give_or_wait(ring, writer)) {
+        janet_gcunroot(janet_wrap_fiber(fiber));
+        janet_schedule(fiber, janet_wrap_abstract(ring));
+    }
+    janet_ring_release(ring);
+}
+
+static Janet janet_ring_give(JanetRing *ring, Janet x) {
+    if (janet_ring_load(&ring->closed)) janet_panic("cannot write to closed channel");
+    JanetRingItem item = janet_ring_pack(x);
+    if (janet_ring_try_push(ring, item)) return janet_wrap_abstract(ring);
+    JanetRingWriter *writer = janet_malloc(sizeof(JanetRingWriter));
+    if (NULL == writer) {
+        JANET_OUT_OF_MEMORY;
+    }
+    writer->ring = ring;
+    writer->vm = janet_local_vm();
+    writer->fiber = janet_vm.root_fiber;
+    writer->sched_id = janet_vm.root_fiber->sched_id;
+    writer->item = item;
+    if (janet_ring_give_or_wait(ring, writer)) return janet_wrap_abstract(ring);
+    janet_gcroot(janet_wrap_fiber(janet_vm.root_fiber));
+    janet_await();
+}
+
+static Janet janet_ring_take(JanetRing *ring) {
+    JanetFiber *fiber = ring->reader_fiber;
+    if (NULL != fiber) {
+        if (fiber->sched_id == ring->reader_sched_id) {
+            janet_panic("ring channel already has a waiting reader");
+        }
+        /* Previous reader was canceled */
+        ring->reader_fiber = NULL;
+        janet_gcunroot(janet_wrap_fiber(fiber));
+    }
+    Janet x;
+    if (janet_ring_take_or_wait(ring, &x, janet_vm.root_fiber, janet_vm.root_fiber->sched_id)) {
+        return x;
+    }
+    janet_gcroot(janet_wrap_fiber(janet_vm.root_fiber));
+    janet_await();
+}
+
+static void janet_ring_close(JanetRing *ring) {
+    if (janet_ring_exchange(&ring->closed, 1)) return;
+    janet_ring_fence();
+    janet_ring_wake_reader(ring);
+    while (janet_ring_load(&ring->writers_waiting)) {
+        janet_ring_wake_writer(ring);
+    }
+}
+
+static int janet_ring_gc(void *p, size_t s) {
+    (void) s;
+    JanetRing *ring = (JanetRing *) p;
+    JanetRingItem item;
+    while (NULL != ring->writers) {
+        JanetRingWriter *next = ring->writers->next;
+        janet_ring_unpack(ring->writers->item, 1);
+        janet_free(ring->writers);
+        ring->writers = next;
+    }
+    ring->writers_waiting = 0;
+    while (janet_ring_try_pop(ring, &item)) {
+        janet_ring_unpack(item, 1);
+    }
+    janet_free(ring->slots);
+    janet_os_mutex_deinit((JanetOSMutex *) &ring->lock);
+    return 0;
+}
+
+static int janet_ring_get(void *p, Janet key, Janet *out);
+static Janet janet_ring_next(void *p, Janet key);
+
+const JanetAbstractType janet_ring_channel_type = {
+    "core/ring-channel",
+    janet_ring_gc,
+    NULL,
+    janet_ring_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    janet_ring_next,
+    JANET_ATEND_NEXT
+};
+
+JanetChannel *janet_channel_make_threaded(uint32_t limit) {
+    janet_assert(limit <= INT32_MAX, "bad limit");
+    JanetChannel *channel = janet_abstract_threaded(&janet_channel_type, sizeof(JanetChannel));
+    janet_chan_init(channel, (int32_t) limit, 0);
+    return channel;
+}
 
 /* Channel Methods */
 
@@ -1159,10 +2040,12 @@ JANET_CORE_FN(cfun_channel_push,
               "Write a value to a channel, suspending the current fiber if the channel is full. "
               "Returns the channel if the write succeeded, nil otherwise.") {
     janet_fixarity(argc, 2);
-    JanetChannel *channel = janet_getchannel(argv, 0);
+    JanetRing *ring = janet_checkabstract(argv[0], &janet_ring_channel_type);
+    JanetChannel *channel = ring ? NULL : janet_getchannel(argv, 0);
     if (janet_vm.coerce_error) {
         janet_panic("cannot give to channel inside janet_call");
     }
+    if (ring) return janet_ring_give(ring, argv[1]);
     if (janet_channel_push(channel, argv[1], 0)) {
         janet_await();
     }
@@ -1173,17 +2056,56 @@ JANET_CORE_FN(cfun_channel_pop,
               "(ev/take channel)",
               "Read from a channel, suspending the current fiber if no value is available.") {
     janet_fixarity(argc, 1);
-    JanetChannel *channel = janet_getchannel(argv, 0);
+    JanetRing *ring = janet_checkabstract(argv[0], &janet_ring_channel_type);
+    JanetChannel *channel = ring ? NULL : janet_getchannel(argv, 0);
     Janet item;
     if (janet_vm.coerce_error) {
         janet_panic("cannot take from channel inside janet_call");
     }
+    if (ring) return janet_ring_take(ring);
     if (janet_channel_pop(channel, &item, 0)) {
         janet_schedule(janet_vm.root_fiber, item);
     }
     janet_await();
 }
 
+JANET_CORE_FN(cfun_channel_push_many,
+              "(ev/give-many channel values)",
+              "Write each of an indexed collection of values to a channel in order. Waiting readers are "
+              "handed values directly, and the rest are queued. Suspends the current fiber once "
+              "if the channel is over capacity afterwards. Returns the channel.") {
+    janet_fixarity(argc, 2);
+    JanetChannel *channel = janet_getchannel(argv, 0);
+    JanetView values = janet_getindexed(argv, 1);
+    if (janet_vm.coerce_error) {
+        janet_panic("cannot give to channel inside janet_call");
+    }
+    janet_chan_lock(channel);
+    if (janet_channel_push_many_with_lock(channel, values.items, values.len, 0)) {
+        janet_await();
+    }
+    return argv[0];
+}
+
+JANET_CORE_FN(cfun_channel_pop_many,
+              "(ev/take-many channel n)",
+              "Read up to `n` values from a channel into a new array, suspending the current fiber "
+              "only if no value is available. A writer using `ev/give-many` can fill the whole array "
+              "at once. Returns nil if the channel is closed.") {
+    janet_fixarity(argc, 2);
+    JanetChannel *channel = janet_getchannel(argv, 0);
+    int32_t limit = janet_getinteger(argv, 1);
+    if (limit < 1) janet_panicf("expected positive integer, got %d", limit);
+    Janet items;
+    if (janet_vm.coerce_error) {
+        janet_panic("cannot take from channel inside janet_call");
+    }
+    if (janet_channel_pop_many(channel, limit, &items)) {
+        janet_schedule(janet_vm.root_fiber, items);
+    }
+    janet_await();
+}
+
 static void chan_unlock_args(const Janet *argv, int32_t n) {
     for (int32_t i = 0; i < n; i++) {
         int32_t len;
@@ -1273,6 +2195,8 @@ JANET_CORE_FN(cfun_channel_full,
               "(ev/full channel)",
               "Check if a channel is full or not.") {
     janet_fixarity(argc, 1);
+    JanetRing *ring = janet_checkabstract(argv[0], &janet_ring_channel_type);
+    if (ring) return janet_wrap_boolean(janet_ring_count(ring) >= ring->capacity);
     JanetChannel *channel = janet_getchannel(argv, 0);
     janet_chan_lock(channel);
     Janet ret = janet_wrap_boolean(janet_q_count(&channel->items) >= channel->limit);
@@ -1284,6 +2208,8 @@ JANET_CORE_FN(cfun_channel_capacity,
               "(ev/capacity channel)",
               "Get the number of items a channel will store before blocking writers.") {
     janet_fixarity(argc, 1);
+    JanetRing *ring = janet_checkabstract(argv[0], &janet_ring_channel_type);
+    if (ring) return janet_wrap_integer(ring->capacity);
     JanetChannel *channel = janet_getchannel(argv, 0);
     janet_chan_lock(channel);
     Janet ret = janet_wrap_integer(channel->limit);
@@ -1295,6 +2221,8 @@ JANET_CORE_FN(cfun_channel_count,
               "(ev/count channel)",
               "Get the number of items currently waiting in a channel.") {
     janet_fixarity(argc, 1);
+    JanetRing *ring = janet_checkabstract(argv[0], &janet_ring_channel_type);
+    if (ring) return janet_wrap_integer(janet_ring_count(ring));
     JanetChannel *channel = janet_getchannel(argv, 0);
     janet_chan_lock(channel);
     Janet ret = janet_wrap_integer(janet_q_count(&channel->items));
@@ -1341,11 +2269,56 @@ JANET_CORE_FN(cfun_channel_new_threaded,
     return janet_wrap_abstract(tchan);
 }
 
+JANET_CORE_FN(cfun_channel_new_ring,
+              "(ev/ring-chan capacity &opt kind)",
+              "Create a ring channel, a bounded lock-free channel for passing values between threads. "
+              "`kind` is either :spsc (the default) for a single writing thread, or :mpsc for any number "
+              "of writing threads. Only one thread may take from a ring channel, and only one fiber "
+              "may wait on it at a time. `capacity` is rounded up to a power of 2. Writers only block "
+              "when the ring is full. Ring channels work with ev/give, ev/take, ev/count, ev/capacity, "
+              "ev/full and ev/chan-close, but not with ev/select. Closing a ring channel lets readers "
+              "drain the values already queued, after which takes return nil.") {
+    janet_arity(argc, 1, 2);
+    int32_t capacity = janet_getinteger(argv, 0);
+    if (capacity < 1 || capacity > JANET_RING_MAX_CAPACITY) {
+        janet_panicf("expected capacity in range [1, %d], got %d", JANET_RING_MAX_CAPACITY, capacity);
+    }
+    int single_producer = 1;
+    if (argc > 1 && !janet_checktype(argv[1], JANET_NIL)) {
+        JanetKeyword kind = janet_getkeyword(argv, 1);
+        if (!janet_cstrcmp(kind, "mpsc")) {
+            single_producer = 0;
+        } else if (janet_cstrcmp(kind, "spsc")) {
+            janet_panicf("expected :spsc or :mpsc, got %v", argv[1]);
+        }
+    }
+    int32_t size = 1;
+    while (size < capacity) size <<= 1;
+    JanetRing *ring = janet_abstract_threaded(&janet_ring_channel_type, sizeof(JanetRing));
+    memset(ring, 0, sizeof(JanetRing));
+    ring->slots = janet_malloc(sizeof(JanetRingSlot) * (size_t) size);
+    if (NULL == ring->slots) {
+        JANET_OUT_OF_MEMORY;
+    }
+    for (int32_t i = 0; i < size; i++) {
+        ring->slots[i].seq = i;
+    }
+    ring->capacity = size;
+    ring->single_producer = single_producer;
+    janet_os_mutex_init((JanetOSMutex *) &ring->lock);
+    return janet_wrap_abstract(ring);
+}
+
 JANET_CORE_FN(cfun_channel_close,
               "(ev/chan-close chan)",
               "Close a channel. A closed channel will cause all pending reads and writes to return nil. "
               "Returns the channel.") {
     janet_fixarity(argc, 1);
+    JanetRing *ring = janet_checkabstract(argv[0], &janet_ring_channel_type);
+    if (ring) {
+        janet_ring_close(ring);
+        return argv[0];
+    }
     JanetChannel *channel = janet_getchannel(argv, 0);
     janet_chan_lock(channel);
     if (!channel->closed) {
@@ -1407,6 +2380,8 @@ static const JanetMethod ev_chanat_methods[] = {
     {"count", cfun_channel_count},
     {"take", cfun_channel_pop},
     {"give", cfun_channel_push},
+    {"take-many", cfun_channel_pop_many},
+    {"give-many", cfun_channel_push_many},
     {"capacity", cfun_channel_capacity},
     {"full", cfun_channel_full},
     {"close", cfun_channel_close},
@@ -1424,6 +2399,27 @@ static Janet janet_chanat_next(void *p, Janet key) {
     return janet_nextmethod(ev_chanat_methods, key);
 }
 
+static const JanetMethod ev_ring_methods[] = {
+    {"count", cfun_channel_count},
+    {"take", cfun_channel_pop},
+    {"give", cfun_channel_push},
+    {"capacity", cfun_channel_capacity},
+    {"full", cfun_channel_full},
+    {"close", cfun_channel_close},
+    {NULL, NULL}
+};
+
+static int janet_ring_get(void *p, Janet key, Janet *out) {
+    (void) p;
+    if (!janet_checktype(key, JANET_KEYWORD)) return 0;
+    return janet_getmethod(janet_unwrap_keyword(key), ev_ring_methods, out);
+}
+
+static Janet janet_ring_next(void *p, Janet key) {
+    (void) p;
+    return janet_nextmethod(ev_ring_methods, key);
+}
+
 static void janet_chanat_marshal(void *p, JanetMarshalContext *ctx) {
     JanetChannel *channel = (JanetChannel *)p;
     janet_marshal_byte(ctx, channel->is_threaded);
@@ -1494,12 +2490,53 @@ int janet_loop_done(void) {
              janet_atomic_load(&janet_vm.listener_count));
 }
 
+static uint64_t ev_stats_now(void) {
+    struct timespec now;
+    janet_assert(-1 != janet_gettime(&now, JANET_TIME_MONOTONIC), "failed to get time");
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static void ev_stats_histogram_add(JanetEVHistogram *h, uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+    while (us && bucket < JANET_EV_HIST_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    h->count++;
+    h->total += ns;
+    if (ns > h->max) h->max = ns;
+    h->buckets[bucket]++;
+}
+
+/* Record one loop iteration, and call the slow iteration handler
+ * in a new fiber if the iteration took too long. */
+static void ev_stats_record(uint64_t start, uint64_t run_start, uint64_t end,
+                            JanetFiber *slowest, uint64_t slowest_time) {
+    JanetEVStats *stats = &janet_vm.ev_stats;
+    stats->iterations++;
+    ev_stats_histogram_add(&stats->latency, end - start);
+    ev_stats_histogram_add(&stats->run, end - run_start);
+    if (NULL != stats->slow_handler && end - start >= stats->slow_threshold) {
+        Janet args[3];
+        args[0] = janet_wrap_number((double)(end - start) / 1e9);
+        args[1] = slowest ? janet_wrap_fiber(slowest) : janet_wrap_nil();
+        args[2] = janet_wrap_number((double) slowest_time / 1e9);
+        JanetFiber *fiber = janet_fiber(stats->slow_handler, 64, 3, args);
+        fiber->env = stats->slow_env;
+        janet_schedule(fiber, janet_wrap_nil());
+    }
+}
+
 JanetFiber *janet_loop1(void) {
+    uint64_t start = ev_stats_now();
+    JanetFiber *slowest = NULL;
+    uint64_t slowest_time = 0;
+
     /* Schedule expired timers */
     JanetTimeout to;
     JanetTimestamp now = ts_now();
-    while (peek_timeout(&to) && to.when <= now) {
-        pop_timeout(0);
+    while (pop_expired_timeout(now, &to)) {
         if (to.curr_fiber != NULL) {
             if (janet_fiber_can_resume(to.curr_fiber)) {
                 janet_cancel(to.fiber, janet_cstringv("deadline expired"));
@@ -1518,6 +2555,7 @@ JanetFiber *janet_loop1(void) {
     }
 
     /* Run scheduled fibers unless interrupts need to be handled. */
+    uint64_t run_start = ev_stats_now();
     while (janet_vm.spawn.head != janet_vm.spawn.tail) {
         /* Don't run until all interrupts have been marked as handled by calling janet_interpreter_interrupt_handled */
         if (janet_atomic_load_relaxed(&janet_vm.auto_suspend)) break;
@@ -1527,7 +2565,16 @@ JanetFiber *janet_loop1(void) {
         task.fiber->gc.flags &= ~(JANET_FIBER_EV_FLAG_CANCELED | JANET_FIBER_EV_FLAG_SUSPENDED);
         if (task.expected_sched_id != task.fiber->sched_id) continue;
         Janet res;
+        int time_fiber = NULL != janet_vm.ev_stats.slow_handler;
+        uint64_t fiber_start = time_fiber ? ev_stats_now() : 0;
         JanetSignal sig = janet_continue_signal(task.fiber, task.value, &res, task.sig);
+        if (time_fiber) {
+            uint64_t fiber_time = ev_stats_now() - fiber_start;
+            if (fiber_time >= slowest_time) {
+                slowest = task.fiber;
+                slowest_time = fiber_time;
+            }
+        }
         if (!janet_fiber_can_resume(task.fiber)) {
             janet_table_remove(&janet_vm.active_tasks, janet_wrap_fiber(task.fiber));
         }
@@ -1551,32 +2598,21 @@ JanetFiber *janet_loop1(void) {
         if (sig == JANET_SIGNAL_INTERRUPT) {
             return task.fiber;
         }
+        /* Make progress on incremental collection between fibers */
+        if (janet_vm.gc_marking) janet_gc_step();
     }
+    ev_stats_record(start, run_start, ev_stats_now(), slowest, slowest_time);
 
     /* Poll for events */
     if (janet_vm.tq_count || janet_atomic_load(&janet_vm.listener_count)) {
-        JanetTimeout to;
-        memset(&to, 0, sizeof(to));
-        int has_timeout;
+        /* Use idle time to make progress on incremental collection */
+        if (janet_vm.gc_marking) janet_gc_step();
+        JanetTimestamp when = 0;
         /* Drop timeouts that are no longer needed */
-        while ((has_timeout = peek_timeout(&to))) {
-            if (to.curr_fiber != NULL) {
-                if (!janet_fiber_can_resume(to.curr_fiber)) {
-                    pop_timeout(0);
-                    janet_table_remove(&janet_vm.active_tasks, janet_wrap_fiber(to.curr_fiber));
-                    handle_timeout_worker(to, 1);
-                    continue;
-                }
-            } else if (to.fiber->sched_id != to.sched_id) {
-                pop_timeout(0);
-                handle_timeout_worker(to, 1);
-                continue;
-            }
-            break;
-        }
+        int has_timeout = next_timeout(&when);
         /* Run polling implementation only if pending timeouts or pending events */
         if (janet_vm.tq_count || janet_atomic_load(&janet_vm.listener_count)) {
-            janet_loop1_impl(has_timeout, to.when);
+            janet_loop1_impl(has_timeout, when);
         }
     }
 
@@ -1775,6 +2811,247 @@ void janet_stream_level_triggered(JanetStream *stream) {
     janet_register_stream_impl(stream, 1, 0);
 }
 
+#ifdef JANET_EV_IO_URING
+
+/*
+ * io_uring support. Reads and writes are submitted to a ring instead of
+ * waiting for readiness and then making a syscall. The ring's file descriptor
+ * is watched by epoll like any other stream, and all operations queued while
+ * running fibers are submitted together once per loop iteration. Everything
+ * else, and everything when the kernel refuses to create a ring, keeps using
+ * epoll.
+ */
+
+#define JANET_URING_ENTRIES 256
+
+struct JanetURing {
+    int fd;
+    unsigned sq_entries;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *ring;
+    size_t ring_size;
+    size_t sqes_size;
+    unsigned pending; /* Queued but not yet submitted */
+};
+
+static void janet_uring_init(void) {
+    janet_vm.uring = NULL;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int) syscall(__NR_io_uring_setup, JANET_URING_ENTRIES, &params);
+    if (fd < 0) return;
+    /* Older kernels need more bookkeeping than we want, just use epoll */
+    unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+    if ((params.features & needed) != needed) {
+        close(fd);
+        return;
+    }
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t ring_size = sq_size > cq_size ? sq_size : cq_size;
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    char *ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    void *sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        munmap(ring, ring_size);
+        close(fd);
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &janet_vm.uring;
+    if (-1 == epoll_ctl(janet_vm.epoll, EPOLL_CTL_ADD, fd, &ev)) {
+        munmap(sqes, sqes_size);
+        munmap(ring, ring_size);
+        close(fd);
+        return;
+    }
+    struct JanetURing *r = janet_malloc(sizeof(struct JanetURing));
+    if (NULL == r) {
+        JANET_OUT_OF_MEMORY;
+    }
+    r->fd = fd;
+    r->sq_entries = params.sq_entries;
+    r->sq_head = (unsigned *)(ring + params.sq_off.head);
+    r->sq_tail = (unsigned *)(ring + params.sq_off.tail);
+    r->sq_mask = (unsigned *)(ring + params.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(ring + params.sq_off.array);
+    r->cq_head = (unsigned *)(ring + params.cq_off.head);
+    r->cq_tail = (unsigned *)(ring + params.cq_off.tail);
+    r->cq_mask = (unsigned *)(ring + params.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(ring + params.cq_off.cqes);
+    r->sqes = sqes;
+    r->ring = ring;
+    r->ring_size = ring_size;
+    r->sqes_size = sqes_size;
+    r->pending = 0;
+    janet_vm.uring = r;
+}
+
+static void janet_uring_deinit(void) {
+    struct JanetURing *r = janet_vm.uring;
+    if (NULL == r) return;
+    munmap(r->sqes, r->sqes_size);
+    munmap(r->ring, r->ring_size);
+    close(r->fd);
+    janet_free(r);
+    janet_vm.uring = NULL;
+}
+
+/* Submit all queued entries */
+static void janet_uring_flush(void) {
+    struct JanetURing *r = janet_vm.uring;
+    while (r->pending) {
+        int status = (int) syscall(__NR_io_uring_enter, r->fd, r->pending, 0, 0, NULL, 0);
+        if (status == -1) {
+            if (errno == EINTR) continue;
+            /* EAGAIN or EBUSY - try again after reaping completions */
+            break;
+        }
+        r->pending -= (unsigned) status;
+    }
+}
+
+/* Get the next free submission entry, or NULL if the ring is full */
+static struct io_uring_sqe *janet_uring_sqe(void) {
+    struct JanetURing *r = janet_vm.uring;
+    if (NULL == r) return NULL;
+    unsigned tail = *r->sq_tail;
+    if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) {
+        janet_uring_flush();
+        if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) return NULL;
+    }
+    unsigned index = tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = r->sqes + index;
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[index] = index;
+    return sqe;
+}
+
+/* Make the entry from janet_uring_sqe visible to the kernel */
+static void janet_uring_push(void) {
+    struct JanetURing *r = janet_vm.uring;
+    __atomic_store_n(r->sq_tail, *r->sq_tail + 1, __ATOMIC_RELEASE);
+    r->pending++;
+}
+
+/* Queue an operation for the fiber waiting on op. Returns 0 if the ring is
+ * unavailable or full, in which case the caller should use readiness based IO. */
+static int janet_uring_submit(JanetFiber *fiber, JanetURingOp *op, uint8_t opcode,
+                              int fd, const void *addr, uint32_t len, uint64_t off, uint32_t flags) {
+    struct io_uring_sqe *sqe = janet_uring_sqe();
+    if (NULL == sqe) return 0;
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t) addr;
+    sqe->len = len;
+    sqe->off = off;
+    sqe->msg_flags = flags;
+    sqe->user_data = (uint64_t)(uintptr_t) op;
+    janet_uring_push();
+    op->fiber = fiber;
+    op->active = 1;
+    janet_async_in_flight(fiber);
+    return 1;
+}
+
+/* Older kernels return EAGAIN from non-blocking files instead of waiting, so
+ * wait for readiness on the ring and then retry the operation. */
+static int janet_uring_poll(JanetFiber *fiber, JanetURingOp *op, int fd, uint32_t events) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    events = (events << 16) | (events >> 16);
+#endif
+    if (!janet_uring_submit(fiber, op, IORING_OP_POLL_ADD, fd, NULL, 0, 0, events)) return 0;
+    op->polling = 1;
+    return 1;
+}
+
+/* Get scratch memory for the kernel to read into */
+static uint8_t *janet_uring_scratch(JanetURingOp *op, int32_t size) {
+    if (op->scratch_size < size) {
+        janet_free(op->scratch);
+        op->scratch = janet_malloc((size_t) size);
+        if (NULL == op->scratch) {
+            JANET_OUT_OF_MEMORY;
+        }
+        op->scratch_size = size;
+    }
+    return op->scratch;
+}
+
+static void janet_uring_op_init(JanetURingOp *op) {
+    op->fiber = NULL;
+    op->keep = janet_wrap_nil();
+    op->scratch = NULL;
+    op->scratch_size = 0;
+    op->res = 0;
+    op->active = 0;
+    op->polling = 0;
+}
+
+static void janet_uring_op_free(JanetURingOp *op) {
+    janet_free(op->scratch);
+    janet_free(op);
+}
+
+/* Detach an operation from a fiber that stopped waiting on it and ask the
+ * kernel to cancel it. The state is freed when the completion arrives. */
+static void janet_uring_orphan(JanetFiber *fiber) {
+    JanetURingOp *op = (JanetURingOp *) fiber->ev_state;
+    op->fiber = NULL;
+    if (!janet_checktype(op->keep, JANET_NIL)) janet_gcroot(op->keep);
+    struct io_uring_sqe *sqe = janet_uring_sqe();
+    if (NULL != sqe) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)(uintptr_t) op;
+        sqe->user_data = 0;
+        janet_uring_push();
+    }
+    fiber->ev_state = NULL;
+    fiber->flags &= ~JANET_FIBER_EV_FLAG_IN_FLIGHT;
+}
+
+/* Handle all available completions */
+static void janet_uring_reap(void) {
+    struct JanetURing *r = janet_vm.uring;
+    unsigned head = *r->cq_head;
+    while (head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = r->cqes + (head & *r->cq_mask);
+        JanetURingOp *op = (JanetURingOp *)(uintptr_t) cqe->user_data;
+        int32_t res = cqe->res;
+        __atomic_store_n(r->cq_head, ++head, __ATOMIC_RELEASE);
+        if (NULL == op) continue; /* Cancel request */
+        op->active = 0;
+        JanetFiber *fiber = op->fiber;
+        if (NULL == fiber) {
+            if (!janet_checktype(op->keep, JANET_NIL)) janet_gcunroot(op->keep);
+            janet_uring_op_free(op);
+            janet_ev_dec_refcount();
+            continue;
+        }
+        JanetStream *stream = fiber->ev_stream;
+        fiber->flags &= ~JANET_FIBER_EV_FLAG_IN_FLIGHT;
+        op->res = res;
+        fiber->ev_callback(fiber, JANET_ASYNC_EVENT_COMPLETE);
+        janet_stream_checktoclose(stream);
+    }
+}
+
+#endif
+
 #define JANET_EPOLL_MAX_EVENTS 64
 void janet_loop1_impl(int has_timeout, JanetTimestamp timeout) {
     struct itimerspec its;
@@ -1788,7 +3065,12 @@ void janet_loop1_impl(int has_timeout, JanetTimestamp timeout) {
     }
     janet_vm.timer_enabled = has_timeout;
 
-    /* Poll for events */
+#ifdef JANET_EV_IO_URING
+    /* Submit everything queued since the last iteration with one syscall */
+    if (NULL != janet_vm.uring) janet_uring_flush();
+#endif
+
+    /* Poll for events */
     struct epoll_event events[JANET_EPOLL_MAX_EVENTS];
     int ready;
     do {
@@ -1806,6 +3088,10 @@ void janet_loop1_impl(int has_timeout, JanetTimestamp timeout) {
         } else if (janet_vm.selfpipe == p) {
             /* Self-pipe handling */
             janet_ev_handle_selfpipe();
+#ifdef JANET_EV_IO_URING
+        } else if (&janet_vm.uring == p) {
+            janet_uring_reap();
+#endif
         } else {
             JanetStream *stream = p;
             int mask = events[i].events;
@@ -1854,6 +3140,9 @@ void janet_ev_init(void) {
     ev.events = EPOLLIN | EPOLLET;
     ev.data.ptr = janet_vm.selfpipe;
     if (-1 == epoll_ctl(janet_vm.epoll, EPOLL_CTL_ADD, janet_vm.selfpipe[0], &ev)) goto error;
+#ifdef JANET_EV_IO_URING
+    janet_uring_init();
+#endif
     return;
 error:
     JANET_EXIT("failed to initialize event loop");
@@ -1861,6 +3150,9 @@ error:
 
 void janet_ev_deinit(void) {
     janet_ev_deinit_common();
+#ifdef JANET_EV_IO_URING
+    janet_uring_deinit();
+#endif
     close(janet_vm.epoll);
     close(janet_vm.timerfd);
     janet_ev_cleanup_selfpipe();
@@ -2236,6 +3528,47 @@ void janet_ev_post_event(JanetVM *vm, JanetCallback cb, JanetEVGenericMessage ms
  * Threaded calls
  */
 
+/* Locks shared by the thread pools below */
+#ifdef JANET_WINDOWS
+typedef CRITICAL_SECTION JanetPoolMutex;
+typedef CONDITION_VARIABLE JanetPoolCond;
+#define janet_poolmutex_init(m) InitializeCriticalSection(m)
+#define janet_poolmutex_deinit(m) DeleteCriticalSection(m)
+#define janet_poolmutex_lock(m) EnterCriticalSection(m)
+#define janet_poolmutex_unlock(m) LeaveCriticalSection(m)
+#define janet_poolcond_init(c) InitializeConditionVariable(c)
+#define janet_poolcond_deinit(c) ((void) 0)
+#define janet_poolcond_wait(c, m) SleepConditionVariableCS((c), (m), INFINITE)
+#define janet_poolcond_signal(c) WakeConditionVariable(c)
+#define janet_poolcond_broadcast(c) WakeAllConditionVariable(c)
+static int janet_poolcond_timedwait(JanetPoolCond *c, JanetPoolMutex *m, int ms) {
+    return !SleepConditionVariableCS(c, m, ms);
+}
+#else
+typedef pthread_mutex_t JanetPoolMutex;
+typedef pthread_cond_t JanetPoolCond;
+#define janet_poolmutex_init(m) pthread_mutex_init((m), NULL)
+#define janet_poolmutex_deinit(m) pthread_mutex_destroy(m)
+#define janet_poolmutex_lock(m) pthread_mutex_lock(m)
+#define janet_poolmutex_unlock(m) pthread_mutex_unlock(m)
+#define janet_poolcond_init(c) pthread_cond_init((c), NULL)
+#define janet_poolcond_deinit(c) pthread_cond_destroy(c)
+#define janet_poolcond_wait(c, m) pthread_cond_wait((c), (m))
+#define janet_poolcond_signal(c) pthread_cond_signal(c)
+#define janet_poolcond_broadcast(c) pthread_cond_broadcast(c)
+static int janet_poolcond_timedwait(JanetPoolCond *c, JanetPoolMutex *m, int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(c, m, &ts) == ETIMEDOUT;
+}
+#endif
+
 #ifdef JANET_WINDOWS
 static DWORD WINAPI janet_thread_body(LPVOID ptr) {
     JanetEVThreadInit *init = (JanetEVThreadInit *)ptr;
@@ -2280,7 +3613,227 @@ static void *janet_thread_body(void *ptr) {
 }
 #endif
 
-void janet_ev_threaded_call(JanetThreadedSubroutine fp, JanetEVGenericMessage arguments, JanetThreadedCallback cb) {
+/*
+ * Reusable threads for threaded calls. Calls are pushed onto a lock-free
+ * stack, and the lock is only taken to wake or start a worker. Workers move
+ * the stack into a FIFO so calls start in the order they were submitted.
+ * Workers that stay idle for a while exit.
+ */
+
+#define JANET_THREADED_POOL_MAX 64
+#define JANET_THREADED_POOL_IDLE_MS 10000
+
+#ifdef _MSC_VER
+#define janet_tpool_load(p) (*(p))
+#define janet_tpool_exchange(p, v) InterlockedExchangePointer((PVOID volatile *)(p), (v))
+#define janet_tpool_cas(p, old, new) (InterlockedCompareExchangePointer((PVOID volatile *)(p), (new), (old)) == (old))
+#define janet_tpool_fence() MemoryBarrier()
+#elif defined(JANET_USE_STDATOMIC)
+#define janet_tpool_load(p) atomic_load((_Atomic(JanetEVThreadInit *) *)(p))
+#define janet_tpool_exchange(p, v) atomic_exchange((_Atomic(JanetEVThreadInit *) *)(p), (v))
+#define janet_tpool_cas(p, old, new) atomic_compare_exchange_weak((_Atomic(JanetEVThreadInit *) *)(p), &(old), (new))
+#define janet_tpool_fence() atomic_thread_fence(memory_order_seq_cst)
+#else
+#define janet_tpool_load(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define janet_tpool_exchange(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define janet_tpool_cas(p, old, new) __atomic_compare_exchange_n((p), &(old), (new), 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)
+#define janet_tpool_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+typedef struct {
+    JanetPoolMutex lock;
+    JanetPoolCond wake;
+    JanetEVThreadInit *volatile incoming; /* newest first */
+    JanetEVThreadInit *head; /* oldest first, guarded by lock */
+    JanetEVThreadInit *tail;
+    JanetAtomicInt threads;
+    JanetAtomicInt idle;
+    JanetAtomicInt queued;
+    JanetAtomicInt max_threads;
+} JanetThreadedPool;
+
+static JanetThreadedPool janet_threaded_pool;
+
+#ifdef JANET_WINDOWS
+static INIT_ONCE janet_threaded_pool_once = INIT_ONCE_STATIC_INIT;
+static BOOL CALLBACK janet_threaded_pool_init(PINIT_ONCE once, PVOID param, PVOID *ctx) {
+    (void) once;
+    (void) param;
+    (void) ctx;
+#else
+static pthread_once_t janet_threaded_pool_once = PTHREAD_ONCE_INIT;
+static void janet_threaded_pool_init(void) {
+#endif
+    janet_poolmutex_init(&janet_threaded_pool.lock);
+    janet_poolcond_init(&janet_threaded_pool.wake);
+    janet_threaded_pool.max_threads = JANET_THREADED_POOL_MAX;
+#ifdef JANET_WINDOWS
+    return TRUE;
+#endif
+}
+
+static JanetThreadedPool *janet_threaded_pool_get(void) {
+#ifdef JANET_WINDOWS
+    InitOnceExecuteOnce(&janet_threaded_pool_once, janet_threaded_pool_init, NULL, NULL);
+#else
+    pthread_once(&janet_threaded_pool_once, janet_threaded_pool_init);
+#endif
+    return &janet_threaded_pool;
+}
+
+/* Move new calls to the end of the FIFO. Must hold the lock. */
+static void janet_threaded_pool_drain(JanetThreadedPool *pool) {
+    JanetEVThreadInit *stack = janet_tpool_exchange(&pool->incoming, NULL);
+    JanetEVThreadInit *list = NULL;
+    JanetEVThreadInit *last = stack;
+    while (NULL != stack) {
+        JanetEVThreadInit *next = stack->next;
+        stack->next = list;
+        list = stack;
+        stack = next;
+    }
+    if (NULL == list) return;
+    if (NULL == pool->head) {
+        pool->head = list;
+    } else {
+        pool->tail->next = list;
+    }
+    pool->tail = last;
+}
+
+/* Must hold the lock. */
+static JanetEVThreadInit *janet_threaded_pool_pop(JanetThreadedPool *pool) {
+    if (NULL == pool->head) janet_threaded_pool_drain(pool);
+    JanetEVThreadInit *init = pool->head;
+    if (NULL != init) {
+        pool->head = init->next;
+        janet_atomic_dec(&pool->queued);
+    }
+    return init;
+}
+
+static void janet_threaded_pool_worker(void) {
+    JanetThreadedPool *pool = &janet_threaded_pool;
+    janet_poolmutex_lock(&pool->lock);
+    for (;;) {
+        JanetEVThreadInit *init = janet_threaded_pool_pop(pool);
+        if (NULL != init) {
+            janet_poolmutex_unlock(&pool->lock);
+            janet_thread_body(init);
+            janet_poolmutex_lock(&pool->lock);
+            continue;
+        }
+        if (janet_atomic_load(&pool->threads) > janet_atomic_load(&pool->max_threads)) {
+            /* The pool was made smaller */
+            janet_atomic_dec(&pool->threads);
+            break;
+        }
+        /* Pairs with the fence in janet_threaded_pool_submit - either we see
+         * the new call, or the submitter sees that we are idle and wakes us. */
+        janet_atomic_inc(&pool->idle);
+        janet_tpool_fence();
+        if (NULL != janet_tpool_load(&pool->incoming)) {
+            janet_atomic_dec(&pool->idle);
+            continue;
+        }
+        int timed_out = janet_poolcond_timedwait(&pool->wake, &pool->lock, JANET_THREADED_POOL_IDLE_MS);
+        if (timed_out && NULL == pool->head && NULL == janet_tpool_load(&pool->incoming)) {
+            /* Decrement threads before idle so that a submitter that sees
+             * this thread is no longer idle also sees that it is gone. */
+            janet_atomic_dec(&pool->threads);
+            janet_atomic_dec(&pool->idle);
+            break;
+        }
+        janet_atomic_dec(&pool->idle);
+    }
+    janet_poolmutex_unlock(&pool->lock);
+}
+
+#ifdef JANET_WINDOWS
+static DWORD WINAPI janet_threaded_pool_body(LPVOID ptr) {
+    (void) ptr;
+    janet_threaded_pool_worker();
+    return 0;
+}
+#else
+static void *janet_threaded_pool_body(void *ptr) {
+    (void) ptr;
+    janet_threaded_pool_worker();
+    return NULL;
+}
+#endif
+
+/* Start a worker. Must hold the lock. Returns 0 on success. */
+static int janet_threaded_pool_spawn(JanetThreadedPool *pool) {
+    janet_atomic_inc(&pool->threads);
+#ifdef JANET_WINDOWS
+    HANDLE thread_handle = CreateThread(NULL, 0, janet_threaded_pool_body, NULL, 0, NULL);
+    int err = NULL == thread_handle;
+    if (!err) CloseHandle(thread_handle); /* detach from thread */
+#else
+    pthread_t worker_thread;
+    int err = pthread_create(&worker_thread, &janet_vm.new_thread_attr, janet_threaded_pool_body, NULL);
+#endif
+    if (err) janet_atomic_dec(&pool->threads);
+    return err;
+}
+
+static void janet_threaded_pool_submit(JanetEVThreadInit *init) {
+    JanetThreadedPool *pool = janet_threaded_pool_get();
+    janet_atomic_inc(&pool->queued);
+    JanetEVThreadInit *top;
+    do {
+        top = janet_tpool_load(&pool->incoming);
+        init->next = top;
+    } while (!janet_tpool_cas(&pool->incoming, top, init));
+    janet_tpool_fence();
+    if (!janet_atomic_load(&pool->idle) &&
+            janet_atomic_load(&pool->threads) >= janet_atomic_load(&pool->max_threads)) {
+        /* Every worker is busy, one will take the call when it is done */
+        return;
+    }
+    janet_poolmutex_lock(&pool->lock);
+    int err = 0;
+    if (janet_atomic_load(&pool->queued) > janet_atomic_load(&pool->idle) &&
+            janet_atomic_load(&pool->threads) < janet_atomic_load(&pool->max_threads)) {
+        err = janet_threaded_pool_spawn(pool);
+    }
+    if (janet_atomic_load(&pool->idle)) {
+        janet_poolcond_signal(&pool->wake);
+    }
+    if (err && !janet_atomic_load(&pool->threads)) {
+        /* No worker will ever run the call, so take it back out */
+        janet_threaded_pool_drain(pool);
+        JanetEVThreadInit **prev = &pool->head;
+        JanetEVThreadInit *last = NULL;
+        while (*prev != init) {
+            last = *prev;
+            prev = &last->next;
+        }
+        *prev = init->next;
+        if (pool->tail == init) pool->tail = last;
+        janet_atomic_dec(&pool->queued);
+        janet_poolmutex_unlock(&pool->lock);
+        janet_free(init);
+#ifdef JANET_WINDOWS
+        janet_panic("failed to create thread");
+#else
+        janet_panicf("%s", janet_strerror(err));
+#endif
+    }
+    janet_poolmutex_unlock(&pool->lock);
+}
+
+void janet_ev_threaded_pool_size(int32_t max_threads) {
+    JanetThreadedPool *pool = janet_threaded_pool_get();
+    janet_poolmutex_lock(&pool->lock);
+    pool->max_threads = max_threads;
+    janet_poolcond_broadcast(&pool->wake);
+    janet_poolmutex_unlock(&pool->lock);
+}
+
+static void janet_ev_threaded_call_impl(JanetThreadedSubroutine fp, JanetEVGenericMessage arguments,
+                                        JanetThreadedCallback cb, int dedicated) {
     JanetEVThreadInit *init = janet_malloc(sizeof(JanetEVThreadInit));
     if (NULL == init) {
         JANET_OUT_OF_MEMORY;
@@ -2288,29 +3841,40 @@ void janet_ev_threaded_call(JanetThreadedSubroutine fp, JanetEVGenericMessage ar
     init->msg = arguments;
     init->subr = fp;
     init->cb = cb;
-
 #ifdef JANET_WINDOWS
     init->write_pipe = janet_vm.iocp;
-    HANDLE thread_handle = CreateThread(NULL, 0, janet_thread_body, init, 0, NULL);
-    if (NULL == thread_handle) {
-        janet_free(init);
-        janet_panic("failed to create thread");
-    }
-    CloseHandle(thread_handle); /* detach from thread */
 #else
     init->write_pipe = janet_vm.selfpipe[1];
-    pthread_t waiter_thread;
-    int err = pthread_create(&waiter_thread, &janet_vm.new_thread_attr, janet_thread_body, init);
-    if (err) {
-        janet_free(init);
-        janet_panicf("%s", janet_strerror(err));
-    }
 #endif
 
+    if (!dedicated) {
+        janet_threaded_pool_submit(init);
+    } else {
+#ifdef JANET_WINDOWS
+        HANDLE thread_handle = CreateThread(NULL, 0, janet_thread_body, init, 0, NULL);
+        if (NULL == thread_handle) {
+            janet_free(init);
+            janet_panic("failed to create thread");
+        }
+        CloseHandle(thread_handle); /* detach from thread */
+#else
+        pthread_t waiter_thread;
+        int err = pthread_create(&waiter_thread, &janet_vm.new_thread_attr, janet_thread_body, init);
+        if (err) {
+            janet_free(init);
+            janet_panicf("%s", janet_strerror(err));
+        }
+#endif
+    }
+
     /* Increment ev refcount so we don't quit while waiting for a subprocess */
     janet_ev_inc_refcount();
 }
 
+void janet_ev_threaded_call(JanetThreadedSubroutine fp, JanetEVGenericMessage arguments, JanetThreadedCallback cb) {
+    janet_ev_threaded_call_impl(fp, arguments, cb, 0);
+}
+
 /* Default callback for janet_ev_threaded_await. */
 void janet_ev_default_threaded_callback(JanetEVGenericMessage return_value) {
     if (return_value.fiber == NULL) {
@@ -2351,7 +3915,7 @@ void janet_ev_default_threaded_callback(JanetEVGenericMessage return_value) {
 
 /* Convenience method for common case */
 JANET_NO_RETURN
-void janet_ev_threaded_await(JanetThreadedSubroutine fp, int tag, int argi, void *argp) {
+static JANET_NO_RETURN void janet_ev_threaded_await_impl(JanetThreadedSubroutine fp, int tag, int argi, void *argp, int dedicated) {
     JanetEVGenericMessage arguments;
     memset(&arguments, 0, sizeof(arguments));
     arguments.tag = tag;
@@ -2359,10 +3923,14 @@ void janet_ev_threaded_await(JanetThreadedSubroutine fp, int tag, int argi, void
     arguments.argp = argp;
     arguments.fiber = janet_root_fiber();
     janet_gcroot(janet_wrap_fiber(arguments.fiber));
-    janet_ev_threaded_call(fp, arguments, janet_ev_default_threaded_callback);
+    janet_ev_threaded_call_impl(fp, arguments, janet_ev_default_threaded_callback, dedicated);
     janet_await();
 }
 
+void janet_ev_threaded_await(JanetThreadedSubroutine fp, int tag, int argi, void *argp) {
+    janet_ev_threaded_await_impl(fp, tag, argi, argp, 0);
+}
+
 /*
  * C API helpers for reading and writing from streams.
  * There is some networking code in here as well as generic
@@ -2416,6 +3984,113 @@ Janet janet_ev_lasterr(void) {
 }
 #endif
 
+#ifndef JANET_WINDOWS
+
+/*
+ * Regular files can't be waited on with epoll, so their streams are
+ * unregistered and a read or write would block every fiber while the disk
+ * catches up. Unless the ring takes the operation, do the syscall on the
+ * thread pool instead. Each job owns a duplicate of the file descriptor, so
+ * closing the stream while a job is running is safe, and moves up to
+ * JANET_EV_FILE_CHUNKSIZE bytes at once.
+ */
+
+#define JANET_EV_FILE_CHUNKSIZE 0x40000
+
+typedef struct {
+    JanetFiber *fiber; /* NULL once the fiber stopped waiting */
+    uint8_t *data;
+    size_t len;
+    ssize_t res;
+    int fd;
+    int err;
+    int is_write;
+    int done;
+} JanetFileJob;
+
+/* Runs in a separate thread */
+static JanetEVGenericMessage ev_file_job_subr(JanetEVGenericMessage args) {
+    JanetFileJob *job = (JanetFileJob *) args.argp;
+    ssize_t res;
+    do {
+        res = job->is_write ? write(job->fd, job->data, job->len) : read(job->fd, job->data, job->len);
+    } while (res == -1 && errno == EINTR);
+    job->res = res;
+    job->err = (res == -1) ? errno : 0;
+    close(job->fd);
+    return args;
+}
+
+/* Called in the main thread when the job is done */
+static void ev_file_job_cb(JanetEVGenericMessage args) {
+    JanetFileJob *job = (JanetFileJob *) args.argp;
+    JanetFiber *fiber = job->fiber;
+    job->done = 1;
+    if (NULL == fiber) {
+        janet_free(job);
+        return;
+    }
+    JanetStream *stream = fiber->ev_stream;
+    fiber->ev_callback(fiber, job->is_write ? JANET_ASYNC_EVENT_WRITE : JANET_ASYNC_EVENT_READ);
+    janet_stream_checktoclose(stream);
+}
+
+/* Make a job for len bytes, or return NULL to do the IO directly */
+static JanetFileJob *ev_file_job_new(JanetFiber *fiber, JanetStream *stream, int is_write, size_t len) {
+    if (!(stream->flags & JANET_STREAM_UNREGISTERED)) return NULL;
+#ifdef F_DUPFD_CLOEXEC
+    int fd = fcntl(stream->handle, F_DUPFD_CLOEXEC, 0);
+#else
+    int fd = dup(stream->handle);
+#endif
+    if (fd == -1) return NULL;
+    JanetFileJob *job = janet_malloc(sizeof(JanetFileJob) + len);
+    if (NULL == job) {
+        JANET_OUT_OF_MEMORY;
+    }
+    job->fiber = fiber;
+    job->data = (uint8_t *)(job + 1);
+    job->len = len;
+    job->res = 0;
+    job->fd = fd;
+    job->err = 0;
+    job->is_write = is_write;
+    job->done = 0;
+    return job;
+}
+
+static void ev_file_job_submit(JanetFileJob *job) {
+    JanetEVGenericMessage msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.argp = job;
+    janet_ev_threaded_call(ev_file_job_subr, msg, ev_file_job_cb);
+}
+
+/* Take the result of a finished job, setting errno on failure. Data that was
+ * read is appended to buffer without changing its count. */
+static ssize_t ev_file_job_finish(JanetFileJob **jobp, JanetBuffer *buffer) {
+    JanetFileJob *job = *jobp;
+    *jobp = NULL;
+    ssize_t res = job->res;
+    if (res > 0 && NULL != buffer) {
+        janet_buffer_extra(buffer, (int32_t) res);
+        memcpy(buffer->data + buffer->count, job->data, (size_t) res);
+    }
+    errno = job->err;
+    janet_free(job);
+    return res;
+}
+
+/* The fiber stopped waiting, let the callback free the job */
+static void ev_file_job_orphan(JanetFileJob **jobp) {
+    if (NULL != *jobp) {
+        (*jobp)->fiber = NULL;
+        *jobp = NULL;
+    }
+}
+
+#endif
+
 /* State machine for read/recv/recvfrom */
 
 typedef enum {
@@ -2435,6 +4110,10 @@ typedef struct {
 #endif
     uint8_t chunk_buf[JANET_EV_CHUNKSIZE];
 #else
+#ifdef JANET_EV_IO_URING
+    JanetURingOp op;
+#endif
+    JanetFileJob *job;
     int flags;
 #endif
     int32_t bytes_left;
@@ -2444,6 +4123,31 @@ typedef struct {
     JanetReadMode mode;
 } StateRead;
 
+#ifdef JANET_EV_IO_URING
+
+/* Reads on the ring can take longer to come back, so read more at once */
+#define JANET_URING_CHUNKSIZE 0x10000
+
+/* Start a read on the ring. Returns 0 to use readiness based IO instead. */
+static int ev_uring_read(JanetFiber *fiber, JanetStream *stream, StateRead *state) {
+    if (state->mode == JANET_ASYNC_READMODE_RECVFROM) return 0;
+    int32_t bytes_left = state->bytes_left;
+    int32_t read_limit = state->is_chunk
+                         ? (bytes_left > JANET_URING_CHUNKSIZE ? JANET_URING_CHUNKSIZE : bytes_left)
+                         : bytes_left;
+    if (NULL == janet_vm.uring) return 0;
+    uint8_t *scratch = janet_uring_scratch(&state->op, read_limit);
+    if (state->mode == JANET_ASYNC_READMODE_RECV) {
+        return janet_uring_submit(fiber, &state->op, IORING_OP_RECV, stream->handle,
+                                  scratch, (uint32_t) read_limit, 0, (uint32_t) state->flags);
+    }
+    /* An offset of -1 reads from, and advances, the current file position */
+    return janet_uring_submit(fiber, &state->op, IORING_OP_READ, stream->handle,
+                              scratch, (uint32_t) read_limit, (uint64_t) -1, 0);
+}
+
+#endif
+
 void ev_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
     JanetStream *stream = fiber->ev_stream;
     StateRead *state = (StateRead *) fiber->ev_state;
@@ -2457,6 +4161,56 @@ void ev_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
             janet_schedule(fiber, janet_wrap_nil());
             janet_async_end(fiber);
             break;
+#ifndef JANET_WINDOWS
+        case JANET_ASYNC_EVENT_DEINIT:
+            ev_file_job_orphan(&state->job);
+#ifdef JANET_EV_IO_URING
+            if (!(fiber->flags & JANET_FIBER_EV_FLAG_IN_FLIGHT)) {
+                janet_free(state->op.scratch);
+                state->op.scratch = NULL;
+            }
+#endif
+            break;
+#endif
+#ifdef JANET_EV_IO_URING
+        case JANET_ASYNC_EVENT_COMPLETE: {
+            /* Called when a read on the ring finished */
+            int32_t nread = state->op.res;
+            if (state->op.polling) {
+                state->op.polling = 0;
+                goto read_more;
+            }
+            if (nread == -EAGAIN) {
+                if (janet_uring_poll(fiber, &state->op, stream->handle, POLLIN)) break;
+                goto read_more;
+            }
+            if (nread < 0) {
+                /* In stream protocols, a pipe error is end of stream */
+                if (nread == -EPIPE) {
+                    nread = 0;
+                } else {
+                    errno = -nread;
+                    janet_cancel(fiber, janet_ev_lasterr());
+                    janet_async_end(fiber);
+                    break;
+                }
+            }
+            state->bytes_read += nread;
+            if (state->bytes_read == 0) {
+                janet_schedule(fiber, janet_wrap_nil());
+                janet_async_end(fiber);
+                break;
+            }
+            janet_buffer_push_bytes(state->buf, state->op.scratch, nread);
+            state->bytes_left -= nread;
+            if (!state->is_chunk || state->bytes_left == 0 || nread == 0) {
+                janet_schedule(fiber, janet_wrap_buffer(state->buf));
+                janet_async_end(fiber);
+                break;
+            }
+            goto read_more;
+        }
+#endif
 #ifdef JANET_WINDOWS
         case JANET_ASYNC_EVENT_FAILED:
         case JANET_ASYNC_EVENT_COMPLETE: {
@@ -2534,6 +4288,10 @@ void ev_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
         break;
 #else
         case JANET_ASYNC_EVENT_ERR: {
+#ifdef JANET_EV_IO_URING
+            /* The read on the ring will report the error */
+            if (state->op.active) break;
+#endif
             if (state->bytes_read) {
                 janet_schedule(fiber, janet_wrap_buffer(state->buf));
             } else {
@@ -2548,28 +4306,44 @@ void ev_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
         case JANET_ASYNC_EVENT_HUP:
         case JANET_ASYNC_EVENT_INIT:
         case JANET_ASYNC_EVENT_READ: {
+#ifdef JANET_EV_IO_URING
+            /* Readiness doesn't matter while the ring owns the read */
+            if (state->op.active) break;
+            if (ev_uring_read(fiber, stream, state)) break;
+#endif
             JanetBuffer *buffer = state->buf;
             int32_t bytes_left = state->bytes_left;
             int32_t read_limit = state->is_chunk ? (bytes_left > 4096 ? 4096 : bytes_left) : bytes_left;
-            janet_buffer_extra(buffer, read_limit);
             ssize_t nread;
 #ifdef JANET_NET
             char saddr[256];
             socklen_t socklen = sizeof(saddr);
 #endif
-            do {
+            if (NULL != state->job) {
+                /* A read on the thread pool */
+                if (!state->job->done) break;
+                nread = ev_file_job_finish(&state->job, buffer);
+            } else if (state->mode == JANET_ASYNC_READMODE_READ &&
+                       NULL != (state->job = ev_file_job_new(fiber, stream, 0,
+                                             bytes_left > JANET_EV_FILE_CHUNKSIZE ? JANET_EV_FILE_CHUNKSIZE : bytes_left))) {
+                ev_file_job_submit(state->job);
+                break;
+            } else {
+                janet_buffer_extra(buffer, read_limit);
+                do {
 #ifdef JANET_NET
-                if (state->mode == JANET_ASYNC_READMODE_RECVFROM) {
-                    nread = recvfrom(stream->handle, buffer->data + buffer->count, read_limit, state->flags,
-                                     (struct sockaddr *)&saddr, &socklen);
-                } else if (state->mode == JANET_ASYNC_READMODE_RECV) {
-                    nread = recv(stream->handle, buffer->data + buffer->count, read_limit, state->flags);
-                } else
+                    if (state->mode == JANET_ASYNC_READMODE_RECVFROM) {
+                        nread = recvfrom(stream->handle, buffer->data + buffer->count, read_limit, state->flags,
+                                         (struct sockaddr *)&saddr, &socklen);
+                    } else if (state->mode == JANET_ASYNC_READMODE_RECV) {
+                        nread = recv(stream->handle, buffer->data + buffer->count, read_limit, state->flags);
+                    } else
 #endif
-                {
-                    nread = read(stream->handle, buffer->data + buffer->count, read_limit);
-                }
-            } while (nread == -1 && errno == EINTR);
+                    {
+                        nread = read(stream->handle, buffer->data + buffer->count, read_limit);
+                    }
+                } while (nread == -1 && errno == EINTR);
+            }
 
             /* Check for errors - special case errors that can just be waited on to fix */
             if (nread == -1) {
@@ -2636,6 +4410,12 @@ static JANET_NO_RETURN void janet_ev_read_generic(JanetStream *stream, JanetBuff
     state->flags = (DWORD) flags;
 #else
     state->flags = flags;
+#endif
+#ifdef JANET_EV_IO_URING
+    janet_uring_op_init(&state->op);
+#endif
+#ifndef JANET_WINDOWS
+    state->job = NULL;
 #endif
     janet_async_start(stream, JANET_ASYNC_LISTEN_READ, ev_callback_read, state);
 }
@@ -2674,20 +4454,204 @@ typedef struct {
     DWORD flags;
 #ifdef JANET_NET
     WSABUF wbuf;
+    /* One entry per piece of a vectored send, allocated after the state */
+    WSABUF *wbufs;
+    int32_t nbufs;
 #endif
 #else
+#ifdef JANET_EV_IO_URING
+    JanetURingOp op;
+#endif
+    JanetFileJob *job;
     int flags;
     int32_t start;
+    /* The piece of a vectored write that start is an offset into */
+    int32_t piece;
 #endif
-    union {
-        JanetBuffer *buf;
-        const uint8_t *str;
-    } src;
-    int is_buffer;
+    /* Any value with a byte view, or an array or tuple of them for a vectored
+     * write. Buffers can change while the write is in progress, so views are
+     * fetched again for each write. */
+    Janet src;
     JanetWriteMode mode;
     void *dest_abst;
 } StateWrite;
 
+/* Check that a value can be written with ev/write or net/write */
+void janet_getwritable(const Janet *argv, int32_t n) {
+    const Janet *items;
+    int32_t len;
+    if (janet_indexed_view(argv[n], &items, &len)) {
+        for (int32_t i = 0; i < len; i++) {
+            const uint8_t *bytes;
+            int32_t blen;
+            if (!janet_bytes_view(items[i], &bytes, &blen)) {
+                janet_panicf("bad slot #%d, expected array or tuple of bytes, got %v", n, items[i]);
+            }
+        }
+    } else {
+        janet_getbytes(argv, n);
+    }
+}
+
+#ifndef JANET_WINDOWS
+
+/* Most pieces handed to a single writev */
+#define JANET_WRITEV_MAX 64
+
+/* Fill iov with the unwritten pieces of a vectored write. Pieces that are no
+ * longer bytes, because the array was changed during the write, are skipped. */
+static int ev_fill_iovec(StateWrite *state, struct iovec *iov, size_t *total) {
+    const Janet *items;
+    int32_t n;
+    int count = 0;
+    int32_t start = state->start;
+    *total = 0;
+    janet_indexed_view(state->src, &items, &n);
+    for (int32_t i = state->piece; i < n && count < JANET_WRITEV_MAX; i++) {
+        const uint8_t *bytes;
+        int32_t len;
+        if (janet_bytes_view(items[i], &bytes, &len) && start < len) {
+            iov[count].iov_base = (void *)(bytes + start);
+            iov[count].iov_len = (size_t)(len - start);
+            *total += iov[count].iov_len;
+            count++;
+        }
+        start = 0;
+    }
+    return count;
+}
+
+/* Move the position of a vectored write forward by nwrote bytes */
+static void ev_advance_pieces(StateWrite *state, size_t nwrote) {
+    const Janet *items;
+    int32_t n;
+    janet_indexed_view(state->src, &items, &n);
+    while (state->piece < n) {
+        const uint8_t *bytes;
+        int32_t len;
+        if (!janet_bytes_view(items[state->piece], &bytes, &len)) len = 0;
+        size_t left = len > state->start ? (size_t)(len - state->start) : 0;
+        if (nwrote < left) {
+            state->start += (int32_t) nwrote;
+            return;
+        }
+        nwrote -= left;
+        state->piece++;
+        state->start = 0;
+    }
+}
+
+/* Start a write on the thread pool of up to JANET_EV_FILE_CHUNKSIZE bytes.
+ * Returns 0 if there is nothing left to write or the stream is not a file. */
+static int ev_write_file_job(JanetFiber *fiber, JanetStream *stream, StateWrite *state) {
+    struct iovec iov[JANET_WRITEV_MAX];
+    size_t total = 0;
+    int count = 0;
+    if (state->mode != JANET_ASYNC_WRITEMODE_WRITE) return 0;
+    if (janet_checktypes(state->src, JANET_TFLAG_INDEXED)) {
+        count = ev_fill_iovec(state, iov, &total);
+    } else {
+        const uint8_t *bytes;
+        int32_t len;
+        janet_bytes_view(state->src, &bytes, &len);
+        if (state->start < len) {
+            iov[0].iov_base = (void *)(bytes + state->start);
+            iov[0].iov_len = (size_t)(len - state->start);
+            total = iov[0].iov_len;
+            count = 1;
+        }
+    }
+    if (count == 0) return 0;
+    size_t n = total > JANET_EV_FILE_CHUNKSIZE ? JANET_EV_FILE_CHUNKSIZE : total;
+    JanetFileJob *job = ev_file_job_new(fiber, stream, 1, n);
+    if (NULL == job) return 0;
+    size_t at = 0;
+    for (int i = 0; i < count && at < n; i++) {
+        size_t piece = iov[i].iov_len > n - at ? n - at : iov[i].iov_len;
+        memcpy(job->data + at, iov[i].iov_base, piece);
+        at += piece;
+    }
+    state->job = job;
+    ev_file_job_submit(job);
+    return 1;
+}
+
+/* Write as many pieces as the stream will take with writev or sendmsg */
+static void ev_write_vectored(JanetFiber *fiber, JanetStream *stream, StateWrite *state) {
+    for (;;) {
+        struct iovec iov[JANET_WRITEV_MAX];
+        size_t total;
+        int count = ev_fill_iovec(state, iov, &total);
+        if (count == 0) {
+            janet_schedule(fiber, janet_wrap_nil());
+            janet_async_end(fiber);
+            return;
+        }
+        ssize_t nwrote;
+        do {
+#ifdef JANET_NET
+            if (state->mode == JANET_ASYNC_WRITEMODE_SEND) {
+                struct msghdr msg;
+                memset(&msg, 0, sizeof(msg));
+                msg.msg_iov = iov;
+                msg.msg_iovlen = count;
+                nwrote = sendmsg(stream->handle, &msg, state->flags);
+            } else
+#endif
+            {
+                nwrote = writev(stream->handle, iov, count);
+            }
+        } while (nwrote == -1 && errno == EINTR);
+        if (nwrote == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            janet_cancel(fiber, janet_ev_lasterr());
+            janet_async_end(fiber);
+            return;
+        }
+        if (nwrote == 0) {
+            janet_cancel(fiber, janet_cstringv("disconnect"));
+            janet_async_end(fiber);
+            return;
+        }
+        ev_advance_pieces(state, (size_t) nwrote);
+        /* A short write means the stream is full, so wait to be woken */
+        if ((size_t) nwrote < total) return;
+    }
+}
+
+#endif
+
+#ifdef JANET_EV_IO_URING
+
+/* Start a write on the ring. Returns 0 to use readiness based IO instead. */
+static int ev_uring_write(JanetFiber *fiber, JanetStream *stream, StateWrite *state) {
+    if (state->mode == JANET_ASYNC_WRITEMODE_SENDTO) return 0;
+    /* Vectored writes use writev, which already saves the copy */
+    if (janet_checktypes(state->src, JANET_TFLAG_INDEXED)) return 0;
+    if (NULL == janet_vm.uring) return 0;
+    /* An empty write finishes right away without the ring */
+    const uint8_t *bytes;
+    int32_t len;
+    janet_bytes_view(state->src, &bytes, &len);
+    if (state->start >= len) return 0;
+    /* The kernel reads the bytes later, so they must not move or change */
+    if (!janet_checktype(state->src, JANET_STRING)) {
+        state->src = janet_stringv(bytes + state->start, len - state->start);
+        state->start = 0;
+    }
+    state->op.keep = state->src;
+    JanetString str = janet_unwrap_string(state->src);
+    uint32_t nbytes = (uint32_t)(janet_string_length(str) - state->start);
+    if (state->mode == JANET_ASYNC_WRITEMODE_SEND) {
+        return janet_uring_submit(fiber, &state->op, IORING_OP_SEND, stream->handle,
+                                  str + state->start, nbytes, 0, (uint32_t) state->flags);
+    }
+    return janet_uring_submit(fiber, &state->op, IORING_OP_WRITE, stream->handle,
+                              str + state->start, nbytes, (uint64_t) -1, 0);
+}
+
+#endif
+
 void ev_callback_write(JanetFiber *fiber, JanetAsyncEvent event) {
     JanetStream *stream = fiber->ev_stream;
     StateWrite *state = (StateWrite *) fiber->ev_state;
@@ -2695,9 +4659,7 @@ void ev_callback_write(JanetFiber *fiber, JanetAsyncEvent event) {
         default:
             break;
         case JANET_ASYNC_EVENT_MARK: {
-            janet_mark(state->is_buffer
-                       ? janet_wrap_buffer(state->src.buf)
-                       : janet_wrap_string(state->src.str));
+            janet_mark(state->src);
             if (state->mode == JANET_ASYNC_WRITEMODE_SENDTO) {
                 janet_mark(janet_wrap_abstract(state->dest_abst));
             }
@@ -2707,17 +4669,49 @@ void ev_callback_write(JanetFiber *fiber, JanetAsyncEvent event) {
             janet_cancel(fiber, janet_cstringv("stream closed"));
             janet_async_end(fiber);
             break;
-#ifdef JANET_WINDOWS
-        case JANET_ASYNC_EVENT_FAILED:
+#ifdef JANET_EV_IO_URING
         case JANET_ASYNC_EVENT_COMPLETE: {
-            /* Called when write finished */
-            uint32_t ev_bytes = (uint32_t) state->overlapped.InternalHigh;
-            if (ev_bytes == 0 && (state->mode != JANET_ASYNC_WRITEMODE_SENDTO)) {
-                janet_cancel(fiber, janet_cstringv("disconnect"));
-                janet_async_end(fiber);
-                return;
+            /* Called when a write on the ring finished */
+            int32_t nwrote = state->op.res;
+            if (state->op.polling) {
+                state->op.polling = 0;
+                goto write_more;
             }
-
+            if (nwrote == -EAGAIN) {
+                if (janet_uring_poll(fiber, &state->op, stream->handle, POLLOUT)) break;
+                goto write_more;
+            }
+            if (nwrote < 0) {
+                errno = -nwrote;
+                janet_cancel(fiber, janet_ev_lasterr());
+                janet_async_end(fiber);
+                break;
+            }
+            if (nwrote == 0) {
+                janet_cancel(fiber, janet_cstringv("disconnect"));
+                janet_async_end(fiber);
+                break;
+            }
+            state->start += nwrote;
+            if (state->start >= janet_string_length(janet_unwrap_string(state->src))) {
+                janet_schedule(fiber, janet_wrap_nil());
+                janet_async_end(fiber);
+                break;
+            }
+            goto write_more;
+        }
+#endif
+#ifdef JANET_WINDOWS
+        case JANET_ASYNC_EVENT_FAILED:
+        case JANET_ASYNC_EVENT_COMPLETE: {
+            /* Called when write finished */
+            uint32_t ev_bytes = (uint32_t) state->overlapped.InternalHigh;
+            if (ev_bytes == 0 && (state->mode != JANET_ASYNC_WRITEMODE_SENDTO)) {
+                janet_cancel(fiber, janet_cstringv("disconnect"));
+                janet_async_end(fiber);
+                return;
+            }
+
             janet_schedule(fiber, janet_wrap_nil());
             janet_async_end(fiber);
             return;
@@ -2727,22 +4721,60 @@ void ev_callback_write(JanetFiber *fiber, JanetAsyncEvent event) {
             /* Begin write */
             int32_t len;
             const uint8_t *bytes;
-            if (state->is_buffer) {
-                /* If buffer, convert to string. */
+            int status;
+#ifdef JANET_NET
+            if (state->nbufs) {
+                /* Vectored send, the pieces must not move while in flight */
+                const Janet *items;
+                int32_t n;
+                janet_indexed_view(state->src, &items, &n);
+                JanetArray *pieces = janet_array(n);
+                for (int32_t i = 0; i < n && i < state->nbufs; i++) {
+                    Janet piece = items[i];
+                    if (!janet_bytes_view(piece, &bytes, &len)) continue;
+                    if (!janet_checktype(piece, JANET_STRING)) piece = janet_stringv(bytes, len);
+                    bytes = janet_unwrap_string(piece);
+                    state->wbufs[pieces->count].buf = (char *) bytes;
+                    state->wbufs[pieces->count].len = (ULONG) janet_string_length(bytes);
+                    janet_array_push(pieces, piece);
+                }
+                state->src = janet_wrap_array(pieces);
+                memset(&(state->overlapped), 0, sizeof(WSAOVERLAPPED));
+                status = WSASend((SOCKET) stream->handle, state->wbufs, (DWORD) pieces->count, NULL,
+                                 state->flags, &state->overlapped, NULL);
+                if (status) {
+                    if (WSA_IO_PENDING == WSAGetLastError()) {
+                        janet_async_in_flight(fiber);
+                    } else {
+                        janet_cancel(fiber, janet_ev_lasterr());
+                        janet_async_end(fiber);
+                        return;
+                    }
+                }
+                break;
+            }
+#endif
+            if (janet_checktypes(state->src, JANET_TFLAG_INDEXED)) {
+                /* WriteFile takes a single buffer, so join the pieces */
+                const Janet *items;
+                int32_t n;
+                janet_indexed_view(state->src, &items, &n);
+                JanetBuffer *joined = janet_buffer(0);
+                for (int32_t i = 0; i < n; i++) {
+                    if (janet_bytes_view(items[i], &bytes, &len)) janet_buffer_push_bytes(joined, bytes, len);
+                }
+                state->src = janet_wrap_buffer(joined);
+            }
+            if (!janet_checktype(state->src, JANET_STRING)) {
+                /* If not a string, convert to string. */
                 /* TODO - be more efficient about this */
-                JanetBuffer *buffer = state->src.buf;
-                JanetString str = janet_string(buffer->data, buffer->count);
-                bytes = str;
-                len = buffer->count;
-                state->is_buffer = 0;
-                state->src.str = str;
-            } else {
-                bytes = state->src.str;
-                len = janet_string_length(bytes);
+                janet_bytes_view(state->src, &bytes, &len);
+                state->src = janet_stringv(bytes, len);
             }
+            bytes = janet_unwrap_string(state->src);
+            len = janet_string_length(bytes);
             memset(&(state->overlapped), 0, sizeof(WSAOVERLAPPED));
 
-            int status;
 #ifdef JANET_NET
             if (state->mode == JANET_ASYNC_WRITEMODE_SENDTO) {
                 SOCKET sock = (SOCKET) stream->handle;
@@ -2789,27 +4821,63 @@ void ev_callback_write(JanetFiber *fiber, JanetAsyncEvent event) {
         }
         break;
 #else
+        case JANET_ASYNC_EVENT_DEINIT:
+            ev_file_job_orphan(&state->job);
+            break;
         case JANET_ASYNC_EVENT_ERR:
+#ifdef JANET_EV_IO_URING
+            /* The write on the ring will report the error */
+            if (state->op.active) break;
+#endif
             janet_cancel(fiber, janet_cstringv("stream err"));
             janet_async_end(fiber);
             break;
         case JANET_ASYNC_EVENT_HUP:
+#ifdef JANET_EV_IO_URING
+            if (state->op.active) break;
+#endif
             janet_cancel(fiber, janet_cstringv("stream hup"));
             janet_async_end(fiber);
             break;
+#ifdef JANET_EV_IO_URING
+    write_more:
+#endif
         case JANET_ASYNC_EVENT_INIT:
         case JANET_ASYNC_EVENT_WRITE: {
+#ifdef JANET_EV_IO_URING
+            /* Readiness doesn't matter while the ring owns the write */
+            if (state->op.active) break;
+            if (ev_uring_write(fiber, stream, state)) break;
+#endif
+            if (NULL != state->job) {
+                /* A write on the thread pool */
+                if (!state->job->done) break;
+                ssize_t nwrote = ev_file_job_finish(&state->job, NULL);
+                if (nwrote == -1) {
+                    janet_cancel(fiber, janet_ev_lasterr());
+                    janet_async_end(fiber);
+                    break;
+                }
+                if (nwrote == 0) {
+                    janet_cancel(fiber, janet_cstringv("disconnect"));
+                    janet_async_end(fiber);
+                    break;
+                }
+                if (janet_checktypes(state->src, JANET_TFLAG_INDEXED)) {
+                    ev_advance_pieces(state, (size_t) nwrote);
+                } else {
+                    state->start += (int32_t) nwrote;
+                }
+            }
+            if (ev_write_file_job(fiber, stream, state)) break;
+            if (janet_checktypes(state->src, JANET_TFLAG_INDEXED)) {
+                ev_write_vectored(fiber, stream, state);
+                break;
+            }
             int32_t start, len;
             const uint8_t *bytes;
             start = state->start;
-            if (state->is_buffer) {
-                JanetBuffer *buffer = state->src.buf;
-                bytes = buffer->data;
-                len = buffer->count;
-            } else {
-                bytes = state->src.str;
-                len = janet_string_length(bytes);
-            }
+            janet_bytes_view(state->src, &bytes, &len);
             ssize_t nwrote = 0;
             if (start < len) {
                 int32_t nbytes = len - start;
@@ -2862,10 +4930,20 @@ void ev_callback_write(JanetFiber *fiber, JanetAsyncEvent event) {
     }
 }
 
-static JANET_NO_RETURN void janet_ev_write_generic(JanetStream *stream, void *buf, void *dest_abst, JanetWriteMode mode, int is_buffer, int flags) {
+static JANET_NO_RETURN void janet_ev_write_generic(JanetStream *stream, Janet src, void *dest_abst, JanetWriteMode mode, int flags) {
+#if defined(JANET_WINDOWS) && defined(JANET_NET)
+    /* Vectored sends keep one WSABUF per piece after the state */
+    int32_t nbufs = 0;
+    if (mode == JANET_ASYNC_WRITEMODE_SEND && janet_checktypes(src, JANET_TFLAG_INDEXED)) {
+        nbufs = janet_length(src);
+    }
+    StateWrite *state = janet_malloc(sizeof(StateWrite) + nbufs * sizeof(WSABUF));
+    state->wbufs = (WSABUF *)(state + 1);
+    state->nbufs = nbufs;
+#else
     StateWrite *state = janet_malloc(sizeof(StateWrite));
-    state->is_buffer = is_buffer;
-    state->src.buf = buf;
+#endif
+    state->src = src;
     state->dest_abst = dest_abst;
     state->mode = mode;
 #ifdef JANET_WINDOWS
@@ -2873,35 +4951,387 @@ static JANET_NO_RETURN void janet_ev_write_generic(JanetStream *stream, void *bu
 #else
     state->flags = flags;
     state->start = 0;
+    state->piece = 0;
+    state->job = NULL;
+#endif
+#ifdef JANET_EV_IO_URING
+    janet_uring_op_init(&state->op);
 #endif
     janet_async_start(stream, JANET_ASYNC_LISTEN_WRITE, ev_callback_write, state);
 }
 
 JANET_NO_RETURN void janet_ev_write_buffer(JanetStream *stream, JanetBuffer *buf) {
-    janet_ev_write_generic(stream, buf, NULL, JANET_ASYNC_WRITEMODE_WRITE, 1, 0);
+    janet_ev_write_generic(stream, janet_wrap_buffer(buf), NULL, JANET_ASYNC_WRITEMODE_WRITE, 0);
 }
 
 JANET_NO_RETURN void janet_ev_write_string(JanetStream *stream, JanetString str) {
-    janet_ev_write_generic(stream, (void *) str, NULL, JANET_ASYNC_WRITEMODE_WRITE, 0, 0);
+    janet_ev_write_generic(stream, janet_wrap_string(str), NULL, JANET_ASYNC_WRITEMODE_WRITE, 0);
+}
+
+/* Write any value that janet_bytes_view accepts, or an array or tuple of them */
+JANET_NO_RETURN void janet_ev_write_bytes(JanetStream *stream, Janet bytes) {
+    janet_ev_write_generic(stream, bytes, NULL, JANET_ASYNC_WRITEMODE_WRITE, 0);
 }
 
 #ifdef JANET_NET
 JANET_NO_RETURN void janet_ev_send_buffer(JanetStream *stream, JanetBuffer *buf, int flags) {
-    janet_ev_write_generic(stream, buf, NULL, JANET_ASYNC_WRITEMODE_SEND, 1, flags);
+    janet_ev_write_generic(stream, janet_wrap_buffer(buf), NULL, JANET_ASYNC_WRITEMODE_SEND, flags);
 }
 
 JANET_NO_RETURN void janet_ev_send_string(JanetStream *stream, JanetString str, int flags) {
-    janet_ev_write_generic(stream, (void *) str, NULL, JANET_ASYNC_WRITEMODE_SEND, 0, flags);
+    janet_ev_write_generic(stream, janet_wrap_string(str), NULL, JANET_ASYNC_WRITEMODE_SEND, flags);
+}
+
+JANET_NO_RETURN void janet_ev_send_bytes(JanetStream *stream, Janet bytes, int flags) {
+    janet_ev_write_generic(stream, bytes, NULL, JANET_ASYNC_WRITEMODE_SEND, flags);
 }
 
 JANET_NO_RETURN void janet_ev_sendto_buffer(JanetStream *stream, JanetBuffer *buf, void *dest, int flags) {
-    janet_ev_write_generic(stream, buf, dest, JANET_ASYNC_WRITEMODE_SENDTO, 1, flags);
+    janet_ev_write_generic(stream, janet_wrap_buffer(buf), dest, JANET_ASYNC_WRITEMODE_SENDTO, flags);
 }
 
 JANET_NO_RETURN void janet_ev_sendto_string(JanetStream *stream, JanetString str, void *dest, int flags) {
-    janet_ev_write_generic(stream, (void *) str, dest, JANET_ASYNC_WRITEMODE_SENDTO, 0, flags);
+    janet_ev_write_generic(stream, janet_wrap_string(str), dest, JANET_ASYNC_WRITEMODE_SENDTO, flags);
+}
+
+JANET_NO_RETURN void janet_ev_sendto_bytes(JanetStream *stream, Janet bytes, void *dest, int flags) {
+    janet_ev_write_generic(stream, bytes, dest, JANET_ASYNC_WRITEMODE_SENDTO, flags);
+}
+#endif
+
+/*
+ * State machine for sendfile and splice. The kernel moves bytes from a file or
+ * pipe to a stream without copying them through a buffer when it can. When it
+ * can't, bytes are copied through a small buffer that is reused for the whole
+ * transfer.
+ */
+
+#define JANET_TRANSFER_CHUNK 0x10000
+
+typedef struct {
+#ifdef JANET_WINDOWS
+    OVERLAPPED overlapped;
+    DWORD chunk;
+#else
+    uint8_t *buf; /* Only used when falling back to read and write */
+    int32_t buf_start;
+    int32_t buf_end;
+    int waiting_src;
+    int copy;
+#endif
+    JanetHandle src;
+    JanetStream *src_stream; /* Source of a splice, waited on when it is empty */
+    int64_t offset; /* Position in the source file, or -1 to read from a pipe */
+    int64_t remaining; /* -1 to transfer until end of file */
+    int64_t total;
+} StateTransfer;
+
+#ifndef JANET_WINDOWS
+
+#ifdef JANET_LINUX
+/* Unlike send, sendfile and splice can't be asked not to raise SIGPIPE, so hold
+ * the signal back while they run and drop it if they raised it. */
+static void janet_transfer_sigpipe_block(sigset_t *old) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, old);
+}
+
+static void janet_transfer_sigpipe_restore(sigset_t *old, int raised) {
+    int save_errno = errno;
+    if (raised && !sigismember(old, SIGPIPE)) {
+        sigset_t set;
+        struct timespec zero = {0, 0};
+        sigemptyset(&set);
+        sigaddset(&set, SIGPIPE);
+        while (sigtimedwait(&set, NULL, &zero) == -1 && errno == EINTR);
+    }
+    pthread_sigmask(SIG_SETMASK, old, NULL);
+    errno = save_errno;
+}
+#endif
+
+/* Move bytes with the kernel. Returns the number of bytes moved, 0 at the end of
+ * the source, -1 on error with errno set, or -2 if the kernel can't do this transfer. */
+static ssize_t ev_transfer_kernel(JanetStream *dest, StateTransfer *state, size_t nbytes) {
+#ifdef JANET_LINUX
+    sigset_t old;
+    ssize_t nwrote;
+    janet_transfer_sigpipe_block(&old);
+    do {
+        if (state->offset >= 0) {
+            off_t off = (off_t) state->offset;
+            nwrote = sendfile(dest->handle, state->src, &off, nbytes);
+        } else {
+            nwrote = splice(state->src, NULL, dest->handle, NULL, nbytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        }
+    } while (nwrote == -1 && errno == EINTR);
+    janet_transfer_sigpipe_restore(&old, nwrote == -1 && errno == EPIPE);
+    if (nwrote == -1 && (errno == EINVAL || errno == ENOSYS || errno == EOVERFLOW)) return -2;
+    return nwrote;
+#elif defined(JANET_BSD) || defined(JANET_APPLE)
+    if (state->offset < 0) return -2;
+    off_t sent = 0;
+    int status;
+    do {
+#ifdef JANET_APPLE
+        sent = (off_t) nbytes;
+        status = sendfile(state->src, dest->handle, (off_t) state->offset, &sent, NULL, 0);
+#else
+        status = sendfile(state->src, dest->handle, (off_t) state->offset, nbytes, NULL, &sent, 0);
+#endif
+    } while (status == -1 && errno == EINTR && sent == 0);
+    /* A partial transfer still reports how much was sent */
+    if (sent > 0) return (ssize_t) sent;
+    if (status == -1) {
+        if (errno == ENOTSOCK || errno == EOPNOTSUPP || errno == ENOTSUP || errno == EINVAL) return -2;
+        return -1;
+    }
+    return 0;
+#else
+    (void) dest;
+    (void) state;
+    (void) nbytes;
+    return -2;
+#endif
+}
+
+/* Move bytes through the copy buffer. Returns the number of bytes written, with the
+ * same meaning as ev_transfer_kernel otherwise, except that it never returns -2. */
+static ssize_t ev_transfer_copy(JanetStream *dest, StateTransfer *state, size_t nbytes) {
+    if (state->buf_start >= state->buf_end) {
+        ssize_t nread;
+        if (NULL == state->buf) {
+            state->buf = janet_malloc(JANET_TRANSFER_CHUNK);
+            if (NULL == state->buf) {
+                JANET_OUT_OF_MEMORY;
+            }
+        }
+        do {
+            if (state->offset >= 0) {
+                nread = pread(state->src, state->buf, nbytes, (off_t) state->offset);
+            } else {
+                nread = read(state->src, state->buf, nbytes);
+            }
+        } while (nread == -1 && errno == EINTR);
+        if (nread <= 0) return nread;
+        if (state->offset >= 0) state->offset += nread;
+        state->buf_start = 0;
+        state->buf_end = (int32_t) nread;
+    }
+    ssize_t nwrote;
+    do {
+#ifdef JANET_NET
+        if (dest->flags & JANET_STREAM_SOCKET) {
+            nwrote = send(dest->handle, state->buf + state->buf_start,
+                          state->buf_end - state->buf_start, MSG_NOSIGNAL);
+        } else
+#endif
+        {
+            nwrote = write(dest->handle, state->buf + state->buf_start, state->buf_end - state->buf_start);
+        }
+    } while (nwrote == -1 && errno == EINTR);
+    if (nwrote > 0) state->buf_start += (int32_t) nwrote;
+    if (nwrote == 0) {
+        errno = EPIPE;
+        return -1;
+    }
+    return nwrote;
+}
+
+/* Wait for the source of a splice to have data, or for the destination to have room. */
+static void ev_transfer_wait(JanetFiber *fiber, JanetStream *dest, StateTransfer *state, int on_src) {
+    state->waiting_src = on_src;
+    if (on_src) {
+        state->src_stream->read_fiber = fiber;
+        if (dest->write_fiber == fiber) dest->write_fiber = NULL;
+    } else {
+        if (state->src_stream && state->src_stream->read_fiber == fiber) state->src_stream->read_fiber = NULL;
+        dest->write_fiber = fiber;
+    }
 }
+
+/* Find out which side of a splice is blocking. Returns 1 for the source, 0 for the
+ * destination, or -1 if both are ready. */
+static int ev_transfer_blocked_side(JanetStream *dest, StateTransfer *state) {
+    if (NULL == state->src_stream) return 0;
+    if (state->copy && state->buf_start < state->buf_end) return 0;
+    struct pollfd fds[2];
+    fds[0].fd = state->src;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = dest->handle;
+    fds[1].events = POLLOUT;
+    fds[1].revents = 0;
+    int status;
+    do {
+        status = poll(fds, 2, 0);
+    } while (status == -1 && errno == EINTR);
+    if (status == -1) return 0;
+    if (!fds[0].revents) return 1;
+    if (!fds[1].revents) return 0;
+    return -1;
+}
+
+static void ev_transfer_step(JanetFiber *fiber, JanetStream *dest, StateTransfer *state) {
+    int retries = 0;
+    while (state->remaining != 0) {
+        size_t nbytes = JANET_TRANSFER_CHUNK;
+        if (state->remaining > 0 && state->remaining < (int64_t) nbytes) nbytes = (size_t) state->remaining;
+        ssize_t nmoved;
+        if (state->copy) {
+            nmoved = ev_transfer_copy(dest, state, nbytes);
+        } else {
+            nmoved = ev_transfer_kernel(dest, state, nbytes);
+            if (nmoved == -2) {
+                state->copy = 1;
+                continue;
+            }
+            if (nmoved > 0 && state->offset >= 0) state->offset += nmoved;
+        }
+        if (nmoved == 0) break; /* End of source */
+        if (nmoved < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                int side = ev_transfer_blocked_side(dest, state);
+                if (side < 0 && retries++ < 2) continue;
+                ev_transfer_wait(fiber, dest, state, side > 0);
+                return;
+            }
+            janet_cancel(fiber, janet_ev_lasterr());
+            janet_async_end(fiber);
+            return;
+        }
+        retries = 0;
+        state->total += nmoved;
+        if (state->remaining > 0) state->remaining -= nmoved;
+    }
+    janet_schedule(fiber, janet_wrap_number((double) state->total));
+    janet_async_end(fiber);
+}
+
+#endif
+
+static void ev_callback_transfer(JanetFiber *fiber, JanetAsyncEvent event) {
+    JanetStream *stream = fiber->ev_stream;
+    StateTransfer *state = (StateTransfer *) fiber->ev_state;
+    switch (event) {
+        default:
+            break;
+        case JANET_ASYNC_EVENT_MARK:
+            if (state->src_stream) janet_mark(janet_wrap_abstract(state->src_stream));
+            break;
+        case JANET_ASYNC_EVENT_DEINIT:
+            if (state->src_stream && state->src_stream->read_fiber == fiber) {
+                state->src_stream->read_fiber = NULL;
+            }
+#ifndef JANET_WINDOWS
+            janet_free(state->buf);
+            state->buf = NULL;
+#endif
+            break;
+        case JANET_ASYNC_EVENT_CLOSE:
+            janet_cancel(fiber, janet_cstringv("stream closed"));
+            janet_async_end(fiber);
+            break;
+#ifdef JANET_WINDOWS
+        case JANET_ASYNC_EVENT_FAILED:
+            janet_cancel(fiber, janet_ev_lasterr());
+            janet_async_end(fiber);
+            break;
+        case JANET_ASYNC_EVENT_COMPLETE: {
+            DWORD nwrote = (DWORD) state->overlapped.InternalHigh;
+            state->total += nwrote;
+            state->offset += nwrote;
+            if (state->remaining > 0) state->remaining -= nwrote;
+            if (state->remaining == 0 || nwrote < state->chunk) {
+                janet_schedule(fiber, janet_wrap_number((double) state->total));
+                janet_async_end(fiber);
+                break;
+            }
+        }
+        /* fallthrough */
+        case JANET_ASYNC_EVENT_INIT: {
+            /* TransmitFile sends at most 2^31 - 2 bytes at once */
+            int64_t chunk = state->remaining;
+            if (chunk > 0x40000000) chunk = 0x40000000;
+            state->chunk = (DWORD) chunk;
+            memset(&state->overlapped, 0, sizeof(OVERLAPPED));
+            state->overlapped.Offset = (DWORD)(state->offset & 0xFFFFFFFF);
+            state->overlapped.OffsetHigh = (DWORD)(state->offset >> 32);
+            if (!TransmitFile((SOCKET) stream->handle, state->src, state->chunk, 0, &state->overlapped, NULL, 0)) {
+                if (WSA_IO_PENDING == WSAGetLastError()) {
+                    janet_async_in_flight(fiber);
+                } else {
+                    janet_cancel(fiber, janet_ev_lasterr());
+                    janet_async_end(fiber);
+                }
+            }
+            break;
+        }
+#else
+        case JANET_ASYNC_EVENT_INIT:
+        case JANET_ASYNC_EVENT_READ:
+        case JANET_ASYNC_EVENT_WRITE:
+        case JANET_ASYNC_EVENT_ERR:
+        case JANET_ASYNC_EVENT_HUP:
+            /* Errors and hangups show up when the transfer is retried */
+            ev_transfer_step(fiber, stream, state);
+            break;
+#endif
+    }
+}
+
+JANET_NO_RETURN void janet_ev_sendfile(JanetStream *stream, JanetHandle file, int64_t offset, int64_t count) {
+    if (offset < 0) janet_panic("expected non-negative offset");
+    StateTransfer *state = janet_malloc(sizeof(StateTransfer));
+    if (NULL == state) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memset(state, 0, sizeof(StateTransfer));
+    state->src = file;
+    state->offset = offset;
+    state->remaining = count < 0 ? -1 : count;
+#ifdef JANET_WINDOWS
+    if (state->remaining < 0) {
+        /* TransmitFile needs to know how much to send */
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            janet_free(state);
+            janet_panicv(janet_ev_lasterr());
+        }
+        state->remaining = size.QuadPart > offset ? size.QuadPart - offset : 0;
+    }
+    if (state->remaining == 0) {
+        /* TransmitFile would take a count of 0 to mean the whole file */
+        janet_free(state);
+        janet_schedule(janet_vm.root_fiber, janet_wrap_number(0));
+        janet_await();
+    }
+#endif
+    janet_async_start(stream, JANET_ASYNC_LISTEN_WRITE, ev_callback_transfer, state);
+}
+
+JANET_NO_RETURN void janet_ev_splice(JanetStream *dest, JanetStream *src, int64_t count) {
+#ifdef JANET_WINDOWS
+    (void) dest;
+    (void) src;
+    (void) count;
+    janet_panic("splicing streams is not supported on windows");
+#else
+    if (src->read_fiber) janet_panic("source stream is already being read");
+    StateTransfer *state = janet_malloc(sizeof(StateTransfer));
+    if (NULL == state) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memset(state, 0, sizeof(StateTransfer));
+    state->src = src->handle;
+    state->src_stream = src;
+    state->offset = -1;
+    state->remaining = count < 0 ? -1 : count;
+    janet_async_start(dest, JANET_ASYNC_LISTEN_WRITE, ev_callback_transfer, state);
 #endif
+}
 
 /* For a pipe ID */
 #ifdef JANET_WINDOWS
@@ -3023,12 +5453,57 @@ JANET_CORE_FN(cfun_ev_go,
         fiber = janet_getfiber(argv, 0);
     }
     fiber->supervisor_channel = supervisor;
+    janet_gc_barrier(fiber);
     janet_schedule(fiber, value);
     return janet_wrap_fiber(fiber);
 }
 
 #define JANET_THREAD_SUPERVISOR_FLAG 0x100
 
+/* Copy the abstract type registry and cfunction registry of this thread so
+ * that a new thread can start with the same ones */
+static void janet_thread_marshal_aregistry(JanetBuffer *buffer) {
+    janet_marshal(buffer, janet_wrap_table(janet_vm.abstract_registry), NULL, JANET_MARSHAL_UNSAFE);
+}
+
+static void janet_thread_marshal_cregistry(JanetBuffer *buffer) {
+    janet_assert(janet_vm.registry_count <= INT32_MAX, "assert failed size check");
+    uint32_t temp = (uint32_t) janet_vm.registry_count;
+    janet_buffer_push_bytes(buffer, (uint8_t *) &temp, sizeof(temp));
+    janet_buffer_push_bytes(buffer, (uint8_t *) janet_vm.registry, (int32_t) janet_vm.registry_count * sizeof(JanetCFunRegistry));
+}
+
+static const uint8_t *janet_thread_unmarshal_aregistry(const uint8_t *nextbytes, const uint8_t *endbytes) {
+    Janet aregv = janet_unmarshal(nextbytes, endbytes - nextbytes,
+                                  JANET_MARSHAL_UNSAFE, NULL, &nextbytes);
+    if (!janet_checktype(aregv, JANET_TABLE)) janet_panic("expected table for abstract registry");
+    janet_vm.abstract_registry = janet_unwrap_table(aregv);
+    janet_gcroot(janet_wrap_table(janet_vm.abstract_registry));
+    return nextbytes;
+}
+
+static const uint8_t *janet_thread_unmarshal_cregistry(const uint8_t *nextbytes, const uint8_t *endbytes) {
+    uint32_t count1;
+    if (endbytes - nextbytes < (ptrdiff_t) sizeof(count1)) janet_panic("thread message invalid");
+    memcpy(&count1, nextbytes, sizeof(count1));
+    size_t count = (size_t) count1;
+    /* Use division to avoid overflowing size_t */
+    if (count > (endbytes - nextbytes - sizeof(count1)) / sizeof(JanetCFunRegistry)) {
+        janet_panic("thread message invalid");
+    }
+    janet_vm.registry_count = count;
+    janet_vm.registry_cap = count;
+    janet_vm.registry = janet_malloc(count * sizeof(JanetCFunRegistry));
+    if (janet_vm.registry == NULL) {
+        JANET_OUT_OF_MEMORY;
+    }
+    janet_vm.registry_dirty = 1;
+    nextbytes += sizeof(uint32_t);
+    memcpy(janet_vm.registry, nextbytes, count * sizeof(JanetCFunRegistry));
+    nextbytes += count * sizeof(JanetCFunRegistry);
+    return nextbytes;
+}
+
 /* For ev/thread - Run an interpreter in the new thread. */
 static JanetEVGenericMessage janet_go_thread_subr(JanetEVGenericMessage args) {
     JanetBuffer *buffer = (JanetBuffer *) args.argp;
@@ -3044,11 +5519,7 @@ static JanetEVGenericMessage janet_go_thread_subr(JanetEVGenericMessage args) {
 
         /* Set abstract registry */
         if (!(flags & 0x2)) {
-            Janet aregv = janet_unmarshal(nextbytes, endbytes - nextbytes,
-                                          JANET_MARSHAL_UNSAFE, NULL, &nextbytes);
-            if (!janet_checktype(aregv, JANET_TABLE)) janet_panic("expected table for abstract registry");
-            janet_vm.abstract_registry = janet_unwrap_table(aregv);
-            janet_gcroot(janet_wrap_table(janet_vm.abstract_registry));
+            nextbytes = janet_thread_unmarshal_aregistry(nextbytes, endbytes);
         }
 
         /* Get supervisor */
@@ -3062,23 +5533,7 @@ static JanetEVGenericMessage janet_go_thread_subr(JanetEVGenericMessage args) {
 
         /* Set cfunction registry */
         if (!(flags & 0x4)) {
-            uint32_t count1;
-            memcpy(&count1, nextbytes, sizeof(count1));
-            size_t count = (size_t) count1;
-            /* Use division to avoid overflowing size_t */
-            if (count > (endbytes - nextbytes - sizeof(count1)) / sizeof(JanetCFunRegistry)) {
-                janet_panic("thread message invalid");
-            }
-            janet_vm.registry_count = count;
-            janet_vm.registry_cap = count;
-            janet_vm.registry = janet_malloc(count * sizeof(JanetCFunRegistry));
-            if (janet_vm.registry == NULL) {
-                JANET_OUT_OF_MEMORY;
-            }
-            janet_vm.registry_dirty = 1;
-            nextbytes += sizeof(uint32_t);
-            memcpy(janet_vm.registry, nextbytes, count * sizeof(JanetCFunRegistry));
-            nextbytes += count * sizeof(JanetCFunRegistry);
+            nextbytes = janet_thread_unmarshal_cregistry(nextbytes, endbytes);
         }
 
         Janet fiberv = janet_unmarshal(nextbytes, endbytes - nextbytes,
@@ -3173,16 +5628,13 @@ JANET_CORE_FN(cfun_ev_thread,
     }
     janet_buffer_init(buffer, 0);
     if (!(flags & 0x2)) {
-        janet_marshal(buffer, janet_wrap_table(janet_vm.abstract_registry), NULL, JANET_MARSHAL_UNSAFE);
+        janet_thread_marshal_aregistry(buffer);
     }
     if (flags & JANET_THREAD_SUPERVISOR_FLAG) {
         janet_marshal(buffer, janet_wrap_abstract(supervisor), NULL, JANET_MARSHAL_UNSAFE);
     }
     if (!(flags & 0x4)) {
-        janet_assert(janet_vm.registry_count <= INT32_MAX, "assert failed size check");
-        uint32_t temp = (uint32_t) janet_vm.registry_count;
-        janet_buffer_push_bytes(buffer, (uint8_t *) &temp, sizeof(temp));
-        janet_buffer_push_bytes(buffer, (uint8_t *) janet_vm.registry, (int32_t) janet_vm.registry_count * sizeof(JanetCFunRegistry));
+        janet_thread_marshal_cregistry(buffer);
     }
     janet_marshal(buffer, argv[0], NULL, JANET_MARSHAL_UNSAFE);
     janet_marshal(buffer, value, NULL, JANET_MARSHAL_UNSAFE);
@@ -3194,39 +5646,448 @@ JANET_CORE_FN(cfun_ev_thread,
         arguments.argi = (uint32_t) janet_vm.sandbox_flags;
         arguments.argp = buffer;
         arguments.fiber = NULL;
-        janet_ev_threaded_call(janet_go_thread_subr, arguments, janet_ev_default_threaded_callback);
+        /* Threads can run for a long time, so don't tie up the threaded call pool */
+        janet_ev_threaded_call_impl(janet_go_thread_subr, arguments, janet_ev_default_threaded_callback, 1);
         return janet_wrap_nil();
     } else {
-        janet_ev_threaded_await(janet_go_thread_subr, (uint32_t) flags, (uint32_t) janet_vm.sandbox_flags, buffer);
+        janet_ev_threaded_await_impl(janet_go_thread_subr, (uint32_t) flags, (uint32_t) janet_vm.sandbox_flags, buffer, 1);
     }
 }
 
-JANET_CORE_FN(cfun_ev_give_supervisor,
-              "(ev/give-supervisor tag & payload)",
-              "Send a message to the current supervisor channel if there is one. The message will be a "
-              "tuple of all of the arguments combined into a single message, where the first element is tag. "
-              "By convention, tag should be a keyword indicating the type of message. Returns nil.") {
-    janet_arity(argc, 1, -1);
-    void *chanv = janet_vm.root_fiber->supervisor_channel;
-    if (NULL != chanv) {
-        JanetChannel *chan = janet_channel_unwrap(chanv);
-        if (janet_channel_push(chan, janet_wrap_tuple(janet_tuple_n(argv, argc)), 0)) {
-            janet_await();
+/*
+ * Thread pools. A fixed set of worker threads, each with its own interpreter
+ * that is created once and reused between tasks. Fibers cannot move between
+ * threads, so a task is a marshalled function that runs in a fresh fiber on
+ * whichever worker picks it up. Each worker has a deque of tasks - the worker
+ * takes new work from the back, while idle workers steal from the front.
+ * Tasks submitted from outside the pool go through a shared FIFO queue.
+ */
+
+typedef struct {
+    JanetBuffer *payload; /* marshalled [function channel] */
+    JanetVM *origin; /* notified when the task is done, or NULL */
+} JanetPoolTask;
+
+typedef struct {
+    JanetPoolTask *data;
+    int32_t head;
+    int32_t count;
+    int32_t capacity;
+} JanetPoolDeque;
+
+typedef struct JanetThreadPool JanetThreadPool;
+
+typedef struct {
+    JanetThreadPool *pool;
+    JanetPoolMutex lock;
+    JanetPoolDeque tasks;
+    int32_t index;
+} JanetPoolWorker;
+
+struct JanetThreadPool {
+    JanetPoolMutex lock;
+    JanetPoolCond wake;
+    JanetPoolDeque injector;
+    JanetPoolWorker *workers;
+    int32_t size;
+    int shutdown;
+    JanetAtomicInt queued; /* tasks in all queues */
+    JanetAtomicInt refcount; /* workers plus one for the abstract */
+    uint32_t sandbox_flags;
+    JanetBuffer registries;
+};
+
+static void janet_pool_deque_push(JanetPoolDeque *dq, JanetPoolTask task) {
+    if (dq->count == dq->capacity) {
+        int32_t newcap = 2 * dq->capacity + 8;
+        JanetPoolTask *newdata = janet_malloc(newcap * sizeof(JanetPoolTask));
+        if (NULL == newdata) {
+            JANET_OUT_OF_MEMORY;
+        }
+        for (int32_t i = 0; i < dq->count; i++) {
+            newdata[i] = dq->data[(dq->head + i) % dq->capacity];
         }
+        janet_free(dq->data);
+        dq->data = newdata;
+        dq->head = 0;
+        dq->capacity = newcap;
     }
-    return janet_wrap_nil();
+    dq->data[(dq->head + dq->count++) % dq->capacity] = task;
 }
 
-JANET_NO_RETURN void janet_sleep_await(double sec) {
-    JanetTimeout to;
-    to.when = ts_delta(ts_now(), sec);
-    to.fiber = janet_vm.root_fiber;
-    to.is_error = 0;
-    to.sched_id = to.fiber->sched_id;
-    to.curr_fiber = NULL;
-    to.has_worker = 0;
-    add_timeout(to);
-    janet_await();
+static int janet_pool_deque_pop_back(JanetPoolDeque *dq, JanetPoolTask *out) {
+    if (!dq->count) return 0;
+    *out = dq->data[(dq->head + --dq->count) % dq->capacity];
+    return 1;
+}
+
+static int janet_pool_deque_pop_front(JanetPoolDeque *dq, JanetPoolTask *out) {
+    if (!dq->count) return 0;
+    *out = dq->data[dq->head];
+    dq->head = (dq->head + 1) % dq->capacity;
+    dq->count--;
+    return 1;
+}
+
+static void janet_pool_deque_deinit(JanetPoolDeque *dq) {
+    JanetPoolTask task;
+    while (janet_pool_deque_pop_front(dq, &task)) {
+        janet_buffer_deinit(task.payload);
+        janet_free(task.payload);
+    }
+    janet_free(dq->data);
+}
+
+static void janet_pool_release(JanetThreadPool *pool) {
+    if (janet_atomic_dec(&pool->refcount)) return;
+    for (int32_t i = 0; i < pool->size; i++) {
+        janet_poolmutex_deinit(&pool->workers[i].lock);
+        janet_pool_deque_deinit(&pool->workers[i].tasks);
+    }
+    janet_pool_deque_deinit(&pool->injector);
+    janet_poolmutex_deinit(&pool->lock);
+    janet_poolcond_deinit(&pool->wake);
+    janet_buffer_deinit(&pool->registries);
+    janet_free(pool->workers);
+    janet_free(pool);
+}
+
+/* Wake a sleeping worker after adding a task. Taking the pool lock
+ * here means a worker can't miss the wakeup between checking the task
+ * count and going to sleep. */
+static void janet_pool_notify(JanetThreadPool *pool) {
+    janet_atomic_inc(&pool->queued);
+    janet_poolmutex_lock(&pool->lock);
+    janet_poolcond_signal(&pool->wake);
+    janet_poolmutex_unlock(&pool->lock);
+}
+
+/* Get a task without blocking - first from the back of our own deque, then from the
+ * shared queue, and finally from the front of other workers' deques. */
+static int janet_pool_take(JanetPoolWorker *worker, JanetPoolTask *out) {
+    JanetThreadPool *pool = worker->pool;
+    int found;
+    janet_poolmutex_lock(&worker->lock);
+    found = janet_pool_deque_pop_back(&worker->tasks, out);
+    janet_poolmutex_unlock(&worker->lock);
+    if (!found) {
+        janet_poolmutex_lock(&pool->lock);
+        found = janet_pool_deque_pop_front(&pool->injector, out);
+        janet_poolmutex_unlock(&pool->lock);
+    }
+    for (int32_t i = 1; !found && i < pool->size; i++) {
+        JanetPoolWorker *victim = pool->workers + (worker->index + i) % pool->size;
+        janet_poolmutex_lock(&victim->lock);
+        found = janet_pool_deque_pop_front(&victim->tasks, out);
+        janet_poolmutex_unlock(&victim->lock);
+    }
+    if (found) janet_atomic_dec(&pool->queued);
+    return found;
+}
+
+/* Sleep until there may be work. Returns 0 once the pool is shut down and drained. */
+static int janet_pool_wait(JanetThreadPool *pool) {
+    janet_poolmutex_lock(&pool->lock);
+    while (!janet_atomic_load(&pool->queued) && !pool->shutdown) {
+        janet_poolcond_wait(&pool->wake, &pool->lock);
+    }
+    int keep_going = !pool->shutdown || janet_atomic_load(&pool->queued);
+    janet_poolmutex_unlock(&pool->lock);
+    return keep_going;
+}
+
+static void janet_pool_task_done(JanetEVGenericMessage msg) {
+    (void) msg;
+    janet_ev_dec_refcount();
+}
+
+static void janet_pool_run(JanetPoolTask task) {
+    JanetChannel *volatile chan = NULL;
+    JanetTryState tstate;
+    JanetSignal signal = janet_try(&tstate);
+    if (!signal) {
+        Janet payload = janet_unmarshal(task.payload->data, task.payload->count,
+                                        JANET_MARSHAL_UNSAFE, NULL, NULL);
+        const Janet *parts = janet_unwrap_tuple(payload);
+        JanetFunction *func = janet_unwrap_function(parts[0]);
+        if (!janet_checktype(parts[1], JANET_NIL)) {
+            chan = janet_unwrap_abstract(parts[1]);
+        }
+        JanetFiber *fiber = janet_fiber(func, 64, 0, NULL);
+        if (NULL == fiber) {
+            janet_panic("pool task function must accept 0 arguments");
+        }
+        fiber->flags |=
+            JANET_FIBER_MASK_ERROR |
+            JANET_FIBER_MASK_USER0 |
+            JANET_FIBER_MASK_USER1 |
+            JANET_FIBER_MASK_USER2 |
+            JANET_FIBER_MASK_USER3 |
+            JANET_FIBER_MASK_USER4;
+        /* Errors are reported on the result channel instead of printed */
+        if (NULL != chan) fiber->supervisor_channel = janet_channel_make(0);
+        janet_schedule(fiber, janet_wrap_nil());
+        janet_loop();
+        if (NULL != chan) {
+            Janet result[2];
+            result[0] = janet_ckeywordv(janet_fiber_status(fiber) == JANET_STATUS_DEAD ? "ok" : "error");
+            result[1] = fiber->last_value;
+            janet_channel_give(chan, janet_wrap_tuple(janet_tuple_n(result, 2)));
+        }
+    } else if (NULL != chan) {
+        Janet result[2];
+        result[0] = janet_ckeywordv("error");
+        result[1] = janet_wrap_string(janet_formatc("pool task failure: %v", tstate.payload));
+        janet_channel_give(chan, janet_wrap_tuple(janet_tuple_n(result, 2)));
+    } else {
+        janet_eprintf("pool task failure: %v\n", tstate.payload);
+    }
+    janet_restore(&tstate);
+    janet_buffer_deinit(task.payload);
+    janet_free(task.payload);
+    if (NULL != task.origin) {
+        JanetEVGenericMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        janet_ev_post_event(task.origin, janet_pool_task_done, msg);
+    }
+}
+
+static void janet_pool_worker_main(JanetPoolWorker *worker) {
+    JanetThreadPool *pool = worker->pool;
+    janet_init();
+    janet_vm.sandbox_flags = pool->sandbox_flags;
+    janet_vm.pool_worker = worker;
+    JanetTryState tstate;
+    JanetSignal signal = janet_try(&tstate);
+    if (!signal) {
+        const uint8_t *nextbytes = pool->registries.data;
+        const uint8_t *endbytes = nextbytes + pool->registries.count;
+        nextbytes = janet_thread_unmarshal_aregistry(nextbytes, endbytes);
+        janet_thread_unmarshal_cregistry(nextbytes, endbytes);
+    } else {
+        janet_eprintf("pool worker failure: %v\n", tstate.payload);
+    }
+    janet_restore(&tstate);
+    for (;;) {
+        JanetPoolTask task;
+        if (janet_pool_take(worker, &task)) {
+            janet_pool_run(task);
+            continue;
+        }
+        /* Free garbage from finished tasks before going to sleep */
+        janet_collect();
+        if (!janet_pool_wait(pool)) break;
+    }
+    janet_deinit();
+    janet_pool_release(pool);
+}
+
+#ifdef JANET_WINDOWS
+static DWORD WINAPI janet_pool_worker_body(LPVOID ptr) {
+    janet_pool_worker_main((JanetPoolWorker *) ptr);
+    return 0;
+}
+#else
+static void *janet_pool_worker_body(void *ptr) {
+    janet_pool_worker_main((JanetPoolWorker *) ptr);
+    return NULL;
+}
+#endif
+
+static int janet_pool_gc(void *p, size_t s) {
+    (void) s;
+    JanetThreadPool *pool = *((JanetThreadPool **) p);
+    janet_poolmutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    janet_poolcond_broadcast(&pool->wake);
+    janet_poolmutex_unlock(&pool->lock);
+    janet_pool_release(pool);
+    return 0;
+}
+
+static int janet_pool_get(void *p, Janet key, Janet *out) {
+    JanetThreadPool *pool = *((JanetThreadPool **) p);
+    if (janet_keyeq(key, "size")) {
+        *out = janet_wrap_integer(pool->size);
+        return 1;
+    }
+    if (janet_keyeq(key, "queued")) {
+        *out = janet_wrap_integer(janet_atomic_load(&pool->queued));
+        return 1;
+    }
+    return 0;
+}
+
+const JanetAbstractType janet_thread_pool_type = {
+    "core/thread-pool",
+    janet_pool_gc,
+    NULL,
+    janet_pool_get,
+    JANET_ATEND_GET
+};
+
+JANET_CORE_FN(cfun_ev_pool,
+              "(ev/pool size)",
+              "Create a pool of `size` operating system threads for running tasks with `ev/pool-spawn`. "
+              "Each thread starts one interpreter up front and reuses it for every task it runs, "
+              "so tasks avoid the cost of starting a new thread. Idle threads take work from busy "
+              "ones. The abstract and cfunction registries of the current thread are copied to the "
+              "workers when the pool is created. The pool shuts down once it is garbage collected "
+              "and its queued tasks have finished. Use `(pool :size)` and `(pool :queued)` to get the number "
+              "of threads and the number of tasks waiting to run.") {
+    janet_fixarity(argc, 1);
+    int32_t size = janet_getinteger(argv, 0);
+    if (size < 1) janet_panicf("expected positive pool size, got %d", size);
+    JanetThreadPool *pool = janet_malloc(sizeof(JanetThreadPool));
+    JanetPoolWorker *workers = janet_malloc(size * sizeof(JanetPoolWorker));
+    if (NULL == pool || NULL == workers) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memset(pool, 0, sizeof(JanetThreadPool));
+    janet_poolmutex_init(&pool->lock);
+    janet_poolcond_init(&pool->wake);
+    pool->workers = workers;
+    pool->size = size;
+    pool->refcount = 1;
+    pool->sandbox_flags = janet_vm.sandbox_flags;
+    janet_buffer_init(&pool->registries, 0);
+    janet_thread_marshal_aregistry(&pool->registries);
+    janet_thread_marshal_cregistry(&pool->registries);
+    for (int32_t i = 0; i < size; i++) {
+        workers[i].pool = pool;
+        workers[i].index = i;
+        janet_poolmutex_init(&workers[i].lock);
+        memset(&workers[i].tasks, 0, sizeof(JanetPoolDeque));
+    }
+    JanetThreadPool **handle = janet_abstract_threaded(&janet_thread_pool_type, sizeof(JanetThreadPool *));
+    *handle = pool;
+    for (int32_t i = 0; i < size; i++) {
+        janet_atomic_inc(&pool->refcount);
+#ifdef JANET_WINDOWS
+        HANDLE thread_handle = CreateThread(NULL, 0, janet_pool_worker_body, workers + i, 0, NULL);
+        if (NULL == thread_handle) {
+            janet_atomic_dec(&pool->refcount);
+            janet_panic("failed to create thread");
+        }
+        CloseHandle(thread_handle); /* detach from thread */
+#else
+        pthread_t worker_thread;
+        int err = pthread_create(&worker_thread, &janet_vm.new_thread_attr, janet_pool_worker_body, workers + i);
+        if (err) {
+            janet_atomic_dec(&pool->refcount);
+            janet_panicf("%s", janet_strerror(err));
+        }
+#endif
+    }
+    return janet_wrap_abstract(handle);
+}
+
+JANET_CORE_FN(cfun_ev_pool_spawn,
+              "(ev/pool-spawn pool f &opt chan)",
+              "Queue the function `f` to be called with no arguments on one of the threads in `pool`. "
+              "`f` is marshalled like the main function of `ev/thread`. If a threaded channel `chan` is given, "
+              "a tuple of `[:ok result]` or `[:error err]` is given to it when the task finishes. "
+              "Tasks queued from inside a pool task run on the same thread unless another thread steals them, "
+              "so tasks should not wait on other tasks in the same pool. The current event loop is kept "
+              "running until the task finishes. Returns nil immediately.") {
+    janet_arity(argc, 2, 3);
+    JanetThreadPool *pool = *((JanetThreadPool **) janet_getabstract(argv, 0, &janet_thread_pool_type));
+    JanetFunction *func = janet_getfunction(argv, 1);
+    if (func->def->min_arity > 0) janet_panic("pool task function must accept 0 arguments");
+    Janet parts[2];
+    parts[0] = argv[1];
+    parts[1] = janet_wrap_nil();
+    if (argc > 2 && !janet_checktype(argv[2], JANET_NIL)) {
+        JanetChannel *chan = janet_getchannel(argv, 2);
+        if (!chan->is_threaded) janet_panic("expected threaded channel");
+        parts[1] = argv[2];
+    }
+    JanetBuffer *payload = janet_malloc(sizeof(JanetBuffer));
+    if (NULL == payload) {
+        JANET_OUT_OF_MEMORY;
+    }
+    janet_buffer_init(payload, 0);
+    JanetTryState tstate;
+    JanetSignal signal = janet_try(&tstate);
+    if (!signal) {
+        janet_marshal(payload, janet_wrap_tuple(janet_tuple_n(parts, 2)), NULL, JANET_MARSHAL_UNSAFE);
+    }
+    janet_restore(&tstate);
+    if (signal) {
+        janet_buffer_deinit(payload);
+        janet_free(payload);
+        janet_panicv(tstate.payload);
+    }
+    JanetPoolTask task;
+    task.payload = payload;
+    JanetPoolWorker *worker = janet_vm.pool_worker;
+    if (NULL != worker && worker->pool == pool) {
+        /* Spawned from a task in this pool - keep the task local so it stays cache-warm,
+         * and don't hold this worker's loop open for it. */
+        task.origin = NULL;
+        janet_poolmutex_lock(&worker->lock);
+        janet_pool_deque_push(&worker->tasks, task);
+        janet_poolmutex_unlock(&worker->lock);
+    } else {
+        task.origin = janet_local_vm();
+        janet_ev_inc_refcount();
+        janet_poolmutex_lock(&pool->lock);
+        janet_pool_deque_push(&pool->injector, task);
+        janet_poolmutex_unlock(&pool->lock);
+    }
+    janet_pool_notify(pool);
+    return janet_wrap_nil();
+}
+
+JANET_CORE_FN(cfun_ev_threaded_pool,
+              "(ev/threaded-pool &opt max-threads)",
+              "Get information about the pool of threads that runs blocking calls for the event loop, "
+              "such as `os/proc-wait` and DNS lookups in `net/address`. The pool is shared by every thread in "
+              "the process and starts threads as needed, up to `max-threads` (64 by default), which are reused "
+              "and exit after being idle for a while. Calls beyond that limit wait in a queue. "
+              "If `max-threads` is given, set the limit first. Returns a struct with the keys "
+              "`:threads`, `:idle`, `:queued`, and `:max-threads`.") {
+    janet_arity(argc, 0, 1);
+    if (argc > 0 && !janet_checktype(argv[0], JANET_NIL)) {
+        int32_t max_threads = janet_getinteger(argv, 0);
+        if (max_threads < 1) janet_panicf("expected positive thread count, got %d", max_threads);
+        janet_ev_threaded_pool_size(max_threads);
+    }
+    JanetThreadedPool *pool = janet_threaded_pool_get();
+    JanetKV *st = janet_struct_begin(4);
+    janet_struct_put(st, janet_ckeywordv("threads"), janet_wrap_integer(janet_atomic_load(&pool->threads)));
+    janet_struct_put(st, janet_ckeywordv("idle"), janet_wrap_integer(janet_atomic_load(&pool->idle)));
+    janet_struct_put(st, janet_ckeywordv("queued"), janet_wrap_integer(janet_atomic_load(&pool->queued)));
+    janet_struct_put(st, janet_ckeywordv("max-threads"), janet_wrap_integer(janet_atomic_load(&pool->max_threads)));
+    return janet_wrap_struct(janet_struct_end(st));
+}
+
+JANET_CORE_FN(cfun_ev_give_supervisor,
+              "(ev/give-supervisor tag & payload)",
+              "Send a message to the current supervisor channel if there is one. The message will be a "
+              "tuple of all of the arguments combined into a single message, where the first element is tag. "
+              "By convention, tag should be a keyword indicating the type of message. Returns nil.") {
+    janet_arity(argc, 1, -1);
+    void *chanv = janet_vm.root_fiber->supervisor_channel;
+    if (NULL != chanv) {
+        JanetChannel *chan = janet_channel_unwrap(chanv);
+        if (janet_channel_push(chan, janet_wrap_tuple(janet_tuple_n(argv, argc)), 0)) {
+            janet_await();
+        }
+    }
+    return janet_wrap_nil();
+}
+
+JANET_NO_RETURN void janet_sleep_await(double sec) {
+    JanetTimeout to;
+    to.when = ts_delta(ts_now(), sec);
+    to.fiber = janet_vm.root_fiber;
+    to.is_error = 0;
+    to.sched_id = to.fiber->sched_id;
+    to.curr_fiber = NULL;
+    to.has_worker = 0;
+    add_timeout(to);
+    janet_await();
 }
 
 JANET_CORE_FN(cfun_ev_sleep,
@@ -3348,113 +6209,847 @@ JANET_CORE_FN(janet_cfun_stream_chunk,
     janet_ev_readchunk(stream, buffer, n);
 }
 
+/*
+ * Buffered stream readers. A reader keeps the bytes it has read from a stream
+ * but not handed out yet, so line and record oriented protocols can scan for
+ * delimiters in C and only go back to the stream when more bytes are needed.
+ */
+
+#define JANET_READER_CHUNK 0x4000
+#define JANET_READER_MAX_LIMIT (INT32_MAX - JANET_READER_CHUNK)
+
+typedef struct {
+    JanetStream *stream;
+    uint8_t *data;
+    int32_t start; /* first byte not handed out yet */
+    int32_t end; /* one past the last buffered byte */
+    int32_t capacity;
+    int32_t limit; /* most bytes to buffer while scanning for a delimiter */
+    int eof;
+#ifdef JANET_WINDOWS
+    uint64_t position; /* bytes read from the stream so far */
+#endif
+} JanetStreamReader;
+
+typedef enum {
+    JANET_READER_LINE,
+    JANET_READER_UNTIL,
+    JANET_READER_EXACTLY
+} JanetReaderMode;
+
+typedef struct {
+#ifdef JANET_WINDOWS
+    OVERLAPPED overlapped;
+#endif
+    JanetStreamReader *reader;
+    JanetReaderMode mode;
+    JanetString delim;
+    int32_t n;
+    int32_t scanned; /* bytes after start already searched for delim */
+} StateReader;
+
+static int janet_reader_gc(void *p, size_t s) {
+    (void) s;
+    JanetStreamReader *reader = (JanetStreamReader *) p;
+    janet_free(reader->data);
+    return 0;
+}
+
+static int janet_reader_mark(void *p, size_t s) {
+    (void) s;
+    JanetStreamReader *reader = (JanetStreamReader *) p;
+    janet_mark(janet_wrap_abstract(reader->stream));
+    return 0;
+}
+
+static int janet_reader_get(void *p, Janet key, Janet *out);
+static Janet janet_reader_next(void *p, Janet key);
+
+const JanetAbstractType janet_stream_reader_type = {
+    "core/stream-reader",
+    janet_reader_gc,
+    janet_reader_mark,
+    janet_reader_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    janet_reader_next,
+    JANET_ATEND_NEXT
+};
+
+/* Hand out the next take bytes of the reader, minus the last drop bytes */
+static Janet janet_reader_consume(JanetStreamReader *reader, int32_t take, int32_t drop) {
+    Janet result = janet_stringv(reader->data + reader->start, take - drop);
+    reader->start += take;
+    if (reader->start == reader->end) {
+        reader->start = 0;
+        reader->end = 0;
+    }
+    return result;
+}
+
+/* Try to finish a read with the bytes already buffered. Returns 0 if more bytes
+ * are needed, 1 with the result in out, or -1 with an error in out. */
+static int janet_reader_try(StateReader *state, Janet *out) {
+    JanetStreamReader *reader = state->reader;
+    const uint8_t *base = reader->data + reader->start;
+    int32_t avail = reader->end - reader->start;
+    if (state->mode == JANET_READER_EXACTLY) {
+        if (avail >= state->n) {
+            *out = janet_reader_consume(reader, state->n, 0);
+            return 1;
+        }
+        if (!reader->eof) return 0;
+        if (avail == 0) {
+            *out = janet_wrap_nil();
+            return 1;
+        }
+        *out = janet_wrap_string(janet_formatc("end of stream after %d of %d bytes", avail, state->n));
+        return -1;
+    }
+    const uint8_t *delim = state->delim;
+    int32_t dlen = janet_string_length(delim);
+    int32_t i = state->scanned;
+    while (i <= avail - dlen) {
+        const uint8_t *hit = memchr(base + i, delim[0], (size_t)(avail - dlen - i + 1));
+        if (NULL == hit) break;
+        i = (int32_t)(hit - base);
+        if (!memcmp(hit, delim, dlen)) {
+            int32_t take = i + dlen;
+            int32_t drop = 0;
+            if (state->mode == JANET_READER_LINE) {
+                drop = dlen;
+                if (i > 0 && base[i - 1] == '\r') drop++;
+            }
+            *out = janet_reader_consume(reader, take, drop);
+            return 1;
+        }
+        i++;
+    }
+    state->scanned = avail - dlen + 1 > 0 ? avail - dlen + 1 : 0;
+    if (reader->eof) {
+        *out = avail ? janet_reader_consume(reader, avail, 0) : janet_wrap_nil();
+        return 1;
+    }
+    if (avail >= reader->limit) {
+        *out = janet_wrap_string(janet_formatc("delimiter not found in %d bytes", avail));
+        return -1;
+    }
+    return 0;
+}
+
+/* Make room for at least a chunk after the buffered bytes */
+static void janet_reader_reserve(JanetStreamReader *reader) {
+    if (reader->capacity - reader->end >= JANET_READER_CHUNK) return;
+    if (reader->start > 0) {
+        memmove(reader->data, reader->data + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->capacity - reader->end >= JANET_READER_CHUNK) return;
+    int64_t newcap = (int64_t) reader->capacity * 2;
+    if (newcap < (int64_t) reader->end + JANET_READER_CHUNK) newcap = (int64_t) reader->end + JANET_READER_CHUNK;
+    if (newcap > INT32_MAX) newcap = INT32_MAX;
+    uint8_t *data = janet_realloc(reader->data, (size_t) newcap);
+    if (NULL == data) {
+        JANET_OUT_OF_MEMORY;
+    }
+    reader->data = data;
+    reader->capacity = (int32_t) newcap;
+}
+
+/* Resume the fiber if the read can finish. Returns 1 if it did. */
+static int janet_reader_resume(JanetFiber *fiber, StateReader *state) {
+    Janet out;
+    int status = janet_reader_try(state, &out);
+    if (status == 0) return 0;
+    if (status > 0) {
+        janet_schedule(fiber, out);
+    } else {
+        janet_cancel(fiber, out);
+    }
+    janet_async_end(fiber);
+    return 1;
+}
+
+void ev_callback_reader(JanetFiber *fiber, JanetAsyncEvent event) {
+    JanetStream *stream = fiber->ev_stream;
+    StateReader *state = (StateReader *) fiber->ev_state;
+    JanetStreamReader *reader = state->reader;
+    switch (event) {
+        default:
+            break;
+        case JANET_ASYNC_EVENT_MARK:
+            janet_mark(janet_wrap_abstract(reader));
+            if (state->delim) janet_mark(janet_wrap_string(state->delim));
+            break;
+        case JANET_ASYNC_EVENT_CLOSE:
+            janet_schedule(fiber, janet_wrap_nil());
+            janet_async_end(fiber);
+            break;
+#ifdef JANET_WINDOWS
+        case JANET_ASYNC_EVENT_FAILED:
+        case JANET_ASYNC_EVENT_COMPLETE: {
+            uint32_t ev_bytes = (uint32_t) state->overlapped.InternalHigh;
+            if (ev_bytes == 0) reader->eof = 1;
+            reader->end += (int32_t) ev_bytes;
+            reader->position += ev_bytes;
+            if (janet_reader_resume(fiber, state)) return;
+        }
+        /* fallthrough */
+        case JANET_ASYNC_EVENT_INIT: {
+            janet_reader_reserve(reader);
+            memset(&(state->overlapped), 0, sizeof(OVERLAPPED));
+            /* Files read from the offset in lpOverlapped, other handles ignore it */
+            state->overlapped.Offset = (DWORD) reader->position;
+            state->overlapped.OffsetHigh = (DWORD)(reader->position >> 32);
+            BOOL status = ReadFile(stream->handle, reader->data + reader->end,
+                                   (DWORD)(reader->capacity - reader->end), NULL, &state->overlapped);
+            if (!status && (ERROR_IO_PENDING != GetLastError())) {
+                if (GetLastError() == ERROR_BROKEN_PIPE || GetLastError() == ERROR_HANDLE_EOF) {
+                    reader->eof = 1;
+                    janet_reader_resume(fiber, state);
+                } else {
+                    janet_cancel(fiber, janet_ev_lasterr());
+                    janet_async_end(fiber);
+                }
+                return;
+            }
+            janet_async_in_flight(fiber);
+        }
+        break;
+#else
+        case JANET_ASYNC_EVENT_ERR:
+            /* Like ev/read, an error ends the stream */
+            reader->eof = 1;
+            janet_reader_resume(fiber, state);
+            break;
+        case JANET_ASYNC_EVENT_HUP:
+        case JANET_ASYNC_EVENT_INIT:
+        case JANET_ASYNC_EVENT_READ:
+            while (!janet_reader_resume(fiber, state)) {
+                janet_reader_reserve(reader);
+                ssize_t nread;
+                do {
+                    nread = read(stream->handle, reader->data + reader->end,
+                                 (size_t)(reader->capacity - reader->end));
+                } while (nread == -1 && errno == EINTR);
+                if (nread == -1) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    /* In stream protocols, a pipe error is end of stream */
+                    if (errno != EPIPE) {
+                        janet_cancel(fiber, janet_ev_lasterr());
+                        janet_async_end(fiber);
+                        break;
+                    }
+                    nread = 0;
+                }
+                if (nread == 0) reader->eof = 1;
+                reader->end += (int32_t) nread;
+            }
+            break;
+#endif
+    }
+}
+
+/* Finish a read from the buffered bytes if possible, otherwise suspend until
+ * the stream has provided enough. */
+static Janet janet_reader_read(StateReader *state, int32_t argc, Janet *argv, int32_t timeout_index) {
+    double to = janet_optnumber(argv, argc, timeout_index, INFINITY);
+    Janet out;
+    int status = janet_reader_try(state, &out);
+    if (status > 0) return out;
+    if (status < 0) janet_panicv(out);
+    JanetStream *stream = state->reader->stream;
+    janet_stream_flags(stream, JANET_STREAM_READABLE);
+    if (to != INFINITY) janet_addtimeout(to);
+    StateReader *copy = janet_malloc(sizeof(StateReader));
+    if (NULL == copy) {
+        JANET_OUT_OF_MEMORY;
+    }
+    *copy = *state;
+    janet_async_start(stream, JANET_ASYNC_LISTEN_READ, ev_callback_reader, copy);
+}
+
+static StateReader janet_reader_state(const Janet *argv, JanetReaderMode mode) {
+    StateReader state;
+    memset(&state, 0, sizeof(state));
+    state.reader = janet_getabstract(argv, 0, &janet_stream_reader_type);
+    state.mode = mode;
+    return state;
+}
+
+JANET_CORE_FN(cfun_ev_reader,
+              "(ev/reader stream &opt limit)",
+              "Create a buffered reader over a readable stream for use with ev/read-line, ev/read-until "
+              "and ev/read-exactly. The reader reads from the stream in large chunks and finds delimiters "
+              "without going through the interpreter for each chunk. `limit` is the most bytes that will be "
+              "buffered while looking for a delimiter before raising an error, and defaults to no limit. "
+              "Bytes buffered by the reader are not seen by other reads from the stream.") {
+    janet_arity(argc, 1, 2);
+    JanetStream *stream = janet_getabstract(argv, 0, &janet_stream_type);
+    janet_stream_flags(stream, JANET_STREAM_READABLE);
+    int32_t limit = JANET_READER_MAX_LIMIT;
+    if (argc > 1 && !janet_checktype(argv[1], JANET_NIL)) {
+        limit = janet_getinteger(argv, 1);
+        if (limit < 1 || limit > JANET_READER_MAX_LIMIT) {
+            janet_panicf("expected limit in range [1, %d], got %d", JANET_READER_MAX_LIMIT, limit);
+        }
+    }
+    JanetStreamReader *reader = janet_abstract(&janet_stream_reader_type, sizeof(JanetStreamReader));
+    memset(reader, 0, sizeof(JanetStreamReader));
+    reader->stream = stream;
+    reader->limit = limit;
+    return janet_wrap_abstract(reader);
+}
+
+JANET_CORE_FN(cfun_ev_read_line,
+              "(ev/read-line reader &opt timeout)",
+              "Read the next line from a reader created with ev/reader. Returns the line as a string without "
+              "the trailing \"\\n\" or \"\\r\\n\". At the end of the stream, returns the remaining bytes, or nil "
+              "if there are none. Takes an optional timeout in seconds, after which will raise an error.") {
+    janet_arity(argc, 1, 2);
+    StateReader state = janet_reader_state(argv, JANET_READER_LINE);
+    state.delim = janet_cstring("\n");
+    return janet_reader_read(&state, argc, argv, 1);
+}
+
+JANET_CORE_FN(cfun_ev_read_until,
+              "(ev/read-until reader delim &opt timeout)",
+              "Read from a reader created with ev/reader up to and including the next occurrence of the bytes "
+              "`delim`. Returns a string that ends with `delim`. At the end of the stream, returns the remaining "
+              "bytes, or nil if there are none. Takes an optional timeout in seconds, after which will raise an error.") {
+    janet_arity(argc, 2, 3);
+    StateReader state = janet_reader_state(argv, JANET_READER_UNTIL);
+    if (janet_checktype(argv[1], JANET_STRING)) {
+        state.delim = janet_unwrap_string(argv[1]);
+    } else {
+        JanetByteView view = janet_getbytes(argv, 1);
+        state.delim = janet_string(view.bytes, view.len);
+    }
+    if (janet_string_length(state.delim) == 0) janet_panic("expected non-empty delimiter");
+    return janet_reader_read(&state, argc, argv, 2);
+}
+
+JANET_CORE_FN(cfun_ev_read_exactly,
+              "(ev/read-exactly reader n &opt timeout)",
+              "Read exactly `n` bytes from a reader created with ev/reader and return them as a string. Returns "
+              "nil at the end of the stream, and raises an error if the stream ends after fewer than `n` bytes. "
+              "Takes an optional timeout in seconds, after which will raise an error.") {
+    janet_arity(argc, 2, 3);
+    StateReader state = janet_reader_state(argv, JANET_READER_EXACTLY);
+    state.n = janet_getnat(argv, 1);
+    return janet_reader_read(&state, argc, argv, 2);
+}
+
+static const JanetMethod ev_reader_methods[] = {
+    {"read-line", cfun_ev_read_line},
+    {"read-until", cfun_ev_read_until},
+    {"read-exactly", cfun_ev_read_exactly},
+    {NULL, NULL}
+};
+
+static int janet_reader_get(void *p, Janet key, Janet *out) {
+    (void) p;
+    if (!janet_checktype(key, JANET_KEYWORD)) return 0;
+    return janet_getmethod(janet_unwrap_keyword(key), ev_reader_methods, out);
+}
+
+static Janet janet_reader_next(void *p, Janet key) {
+    (void) p;
+    return janet_nextmethod(ev_reader_methods, key);
+}
+
 JANET_CORE_FN(janet_cfun_stream_write,
               "(ev/write stream data &opt timeout)",
               "Write data to a stream, suspending the current fiber until the write "
-              "completes. Takes an optional timeout in seconds, after which will return nil. "
+              "completes. `data` can also be an array or tuple of byte sequences, which are written "
+              "in order with a single vectored write where possible, without joining them first. "
+              "Takes an optional timeout in seconds, after which will return nil. "
               "Returns nil, or raises an error if the write failed.") {
     janet_arity(argc, 2, 3);
     JanetStream *stream = janet_getabstract(argv, 0, &janet_stream_type);
     janet_stream_flags(stream, JANET_STREAM_WRITABLE);
     double to = janet_optnumber(argv, argc, 2, INFINITY);
-    if (janet_checktype(argv[1], JANET_BUFFER)) {
-        if (to != INFINITY) janet_addtimeout(to);
-        janet_ev_write_buffer(stream, janet_getbuffer(argv, 1));
-    } else {
-        JanetByteView bytes = janet_getbytes(argv, 1);
-        if (to != INFINITY) janet_addtimeout(to);
-        janet_ev_write_string(stream, bytes.bytes);
+    janet_getwritable(argv, 1);
+    if (to != INFINITY) janet_addtimeout(to);
+    janet_ev_write_bytes(stream, argv[1]);
+}
+
+JANET_CORE_FN(cfun_ev_splice,
+              "(ev/splice dest src &opt count timeout)",
+              "Move bytes from the stream `src` to the stream `dest` until `src` ends, or until `count` "
+              "bytes have been moved, suspending the current fiber until done. On Linux, when `src` is a "
+              "pipe, the bytes are moved by the kernel without being copied into userspace. Elsewhere "
+              "they are copied through a small reused buffer. Takes an optional timeout in seconds, "
+              "after which will raise an error. Returns the number of bytes moved. Not supported on Windows.") {
+    janet_arity(argc, 2, 4);
+    JanetStream *dest = janet_getabstract(argv, 0, &janet_stream_type);
+    JanetStream *src = janet_getabstract(argv, 1, &janet_stream_type);
+    janet_stream_flags(dest, JANET_STREAM_WRITABLE);
+    janet_stream_flags(src, JANET_STREAM_READABLE);
+    int64_t count = -1;
+    if (argc > 2 && !janet_checktype(argv[2], JANET_NIL)) {
+        count = janet_getinteger64(argv, 2);
+        if (count < 0) janet_panicf("expected non-negative count, got %v", argv[2]);
     }
+    double to = janet_optnumber(argv, argc, 3, INFINITY);
+    if (to != INFINITY) janet_addtimeout(to);
+    janet_ev_splice(dest, src, count);
+}
+
+/*
+ * Locks. Both ev/lock and ev/rwlock keep their state in a single atomic word, so
+ * uncontended acquires and releases are one compare-and-swap. A contended acquire
+ * spins briefly, then queues the current fiber and suspends it instead of blocking
+ * the thread. Releasing wakes the fibers at the head of the queue to try again, and
+ * a writer may take the lock ahead of them in the meantime, which avoids a thread
+ * switch for every acquisition when a lock is busy. Fibers that waited longer than
+ * JANET_LOCK_FAIR_NS, or that run on the releasing thread, are handed the lock
+ * directly instead so they cannot starve. A waiting writer makes new readers wait.
+ * Where the fiber can't be suspended, such as inside janet_call, the thread blocks
+ * on a condition variable instead, like a plain OS mutex would.
+ */
+
+#define JANET_LOCK_WRITER 1
+#define JANET_LOCK_WAITING 2
+#define JANET_LOCK_READER 4
+#define JANET_LOCK_SPIN 100
+#define JANET_LOCK_FAIR_NS 1000000
+
+/* Flag for posted events that hand over the lock rather than wake a fiber to retry */
+#define JANET_LOCK_GRANT 2
+
+#ifdef _MSC_VER
+#define janet_lock_load(p) InterlockedOr((p), 0)
+#define janet_lock_store(p, v) InterlockedExchange((p), (v))
+#define janet_lock_cas(p, old, new) (InterlockedCompareExchange((p), (new), (old)) == (old))
+#define janet_lock_count(p, n) InterlockedExchangeAdd64((p), (n))
+#define janet_lock_count_load(p) InterlockedCompareExchange64((p), 0, 0)
+#define janet_lock_count_store(p, v) InterlockedExchange64((p), (v))
+#define janet_lock_pause() YieldProcessor()
+#else
+#ifdef JANET_USE_STDATOMIC
+#define janet_lock_load(p) atomic_load_explicit((_Atomic JanetAtomicInt *)(p), memory_order_acquire)
+#define janet_lock_store(p, v) atomic_store_explicit((_Atomic JanetAtomicInt *)(p), (v), memory_order_release)
+#define janet_lock_cas(p, old, new) atomic_compare_exchange_strong((_Atomic JanetAtomicInt *)(p), &(old), (new))
+#define janet_lock_count(p, n) atomic_fetch_add_explicit((_Atomic int64_t *)(p), (n), memory_order_relaxed)
+#define janet_lock_count_load(p) atomic_load_explicit((_Atomic int64_t *)(p), memory_order_relaxed)
+#define janet_lock_count_store(p, v) atomic_store_explicit((_Atomic int64_t *)(p), (v), memory_order_relaxed)
+#else
+#define janet_lock_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define janet_lock_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define janet_lock_cas(p, old, new) __atomic_compare_exchange_n((p), &(old), (new), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define janet_lock_count(p, n) __atomic_fetch_add((p), (n), __ATOMIC_RELAXED)
+#define janet_lock_count_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define janet_lock_count_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define janet_lock_pause() __builtin_ia32_pause()
+#else
+#define janet_lock_pause() ((void) 0)
+#endif
+#endif
+
+typedef struct {
+    JanetVM *thread;
+    JanetFiber *fiber;
+    uint32_t sched_id;
+    int is_write;
+    uint64_t since;
+} JanetLockWaiter;
+
+typedef struct {
+    JanetAtomicInt state;
+    JanetQueue waiting; /* Guarded by lock->guard */
+    int64_t acquisitions;
+    int64_t contended;
+    int64_t parked;
+    int64_t wait_ns;
+    int32_t blocked; /* Threads blocked in janet_lock_block, guarded by lock->guard */
+    JanetPoolCond unblocked;
+#ifdef JANET_WINDOWS
+    CRITICAL_SECTION guard;
+#else
+    pthread_mutex_t guard;
+#endif
+} JanetLock;
+
+static void janet_lock_guard(JanetLock *lock) {
+    janet_os_mutex_lock((JanetOSMutex *) &lock->guard);
+}
+
+static void janet_lock_unguard(JanetLock *lock) {
+    janet_os_mutex_unlock((JanetOSMutex *) &lock->guard);
 }
 
-static int mutexgc(void *p, size_t size) {
+static void janet_lock_init(JanetLock *lock) {
+    lock->state = 0;
+    janet_q_init(&lock->waiting);
+    lock->acquisitions = 0;
+    lock->contended = 0;
+    lock->parked = 0;
+    lock->wait_ns = 0;
+    lock->blocked = 0;
+    janet_poolcond_init(&lock->unblocked);
+    janet_os_mutex_init((JanetOSMutex *) &lock->guard);
+}
+
+static int janet_lock_gc(void *p, size_t size) {
     (void) size;
-    janet_os_mutex_deinit(p);
+    JanetLock *lock = p;
+    janet_q_deinit(&lock->waiting);
+    janet_poolcond_deinit(&lock->unblocked);
+    janet_os_mutex_deinit((JanetOSMutex *) &lock->guard);
+    return 0;
+}
+
+/* Forget the fibers of a thread that no longer references the lock. Each waiting
+ * fiber holds a reference to the lock, which is dropped here. */
+static int janet_lock_gcperthread(void *p, size_t size) {
+    (void) size;
+    JanetLock *lock = p;
+    janet_lock_guard(lock);
+    JanetQueue *q = &lock->waiting;
+    JanetLockWaiter *waiters = q->data;
+    for (int32_t i = q->head; i != q->tail; i = (i + 1 < q->capacity) ? i + 1 : 0) {
+        if (waiters[i].thread == &janet_vm) {
+            waiters[i].thread = NULL;
+            janet_abstract_decref(lock);
+        }
+    }
+    janet_lock_unguard(lock);
     return 0;
 }
 
 const JanetAbstractType janet_mutex_type = {
     "core/lock",
-    mutexgc,
-    JANET_ATEND_GC
+    janet_lock_gc,
+    NULL, /* mark */
+    NULL, /* get */
+    NULL, /* put */
+    NULL, /* marshal */
+    NULL, /* unmarshal */
+    NULL, /* tostring */
+    NULL, /* compare */
+    NULL, /* hash */
+    NULL, /* next */
+    NULL, /* call */
+    NULL, /* length */
+    NULL, /* bytes */
+    janet_lock_gcperthread
+};
+
+const JanetAbstractType janet_rwlock_type = {
+    "core/rwlock",
+    janet_lock_gc,
+    NULL, /* mark */
+    NULL, /* get */
+    NULL, /* put */
+    NULL, /* marshal */
+    NULL, /* unmarshal */
+    NULL, /* tostring */
+    NULL, /* compare */
+    NULL, /* hash */
+    NULL, /* next */
+    NULL, /* call */
+    NULL, /* length */
+    NULL, /* bytes */
+    janet_lock_gcperthread
 };
 
+/* Drop a reference held by a waiting fiber or a posted event */
+static void janet_lock_unref(JanetLock *lock) {
+    if (0 == janet_abstract_decref(lock)) {
+        janet_lock_gc(lock, sizeof(JanetLock));
+        janet_free(janet_abstract_head(lock));
+    }
+}
+
+/* Whether the lock can be taken in state s. A writer may take a free lock while fibers
+ * are waiting, a reader only if it is one of the fibers woken to retry. */
+static int janet_lock_available(JanetAtomicInt s, int is_write, int is_woken) {
+    if (is_write) return (s & ~JANET_LOCK_WAITING) == 0;
+    return !(s & (is_woken ? JANET_LOCK_WRITER : (JANET_LOCK_WRITER | JANET_LOCK_WAITING)));
+}
+
+/* Try to take the lock once */
+static int janet_lock_try(JanetLock *lock, int is_write, int is_woken) {
+    JanetAtomicInt s = janet_lock_load(&lock->state);
+    if (!janet_lock_available(s, is_write, is_woken)) return 0;
+    return janet_lock_cas(&lock->state, s, s + (is_write ? JANET_LOCK_WRITER : JANET_LOCK_READER));
+}
+
+/* Take the lock, or queue the waiter and mark the lock as having waiters. Returns 1 if
+ * the lock was taken. Expects the guard to be held. */
+static int janet_lock_try_or_wait(JanetLock *lock, JanetLockWaiter *waiter, int is_woken) {
+    for (;;) {
+        JanetAtomicInt s = janet_lock_load(&lock->state);
+        if (janet_lock_available(s, waiter->is_write, is_woken)) {
+            JanetAtomicInt next = s + (waiter->is_write ? JANET_LOCK_WRITER : JANET_LOCK_READER);
+            if (janet_lock_cas(&lock->state, s, next)) return 1;
+        } else if ((s & JANET_LOCK_WAITING) || janet_lock_cas(&lock->state, s, s | JANET_LOCK_WAITING)) {
+            break;
+        }
+    }
+    /* A woken fiber keeps its place at the head of the queue */
+    if (is_woken ? janet_q_push_head(&lock->waiting, waiter, sizeof(*waiter))
+            : janet_q_push(&lock->waiting, waiter, sizeof(*waiter))) {
+        janet_lock_unguard(lock);
+        janet_panic("too many fibers waiting for lock");
+    }
+    return 0;
+}
+
+static void janet_lock_cb(JanetEVGenericMessage msg);
+static int janet_lock_release(JanetLock *lock, int is_write);
+
+/* Hand the lock to a waiting fiber, or wake it to try again. The reference to the
+ * lock held by the waiter moves to the posted event. */
+static void janet_lock_wake(JanetLock *lock, JanetLockWaiter *waiter, int grant) {
+    if (grant && waiter->thread == &janet_vm) {
+        janet_gcunroot(janet_wrap_fiber(waiter->fiber));
+        janet_schedule(waiter->fiber, janet_wrap_abstract(lock));
+        janet_abstract_decref(lock);
+    } else {
+        JanetEVGenericMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.tag = waiter->is_write | (grant ? JANET_LOCK_GRANT : 0);
+        msg.argi = (int32_t) waiter->sched_id;
+        msg.argp = lock;
+        msg.argj = janet_wrap_number((double) waiter->since);
+        msg.fiber = waiter->fiber;
+        janet_ev_post_event(waiter->thread, janet_lock_cb, msg);
+    }
+}
+
+/* Runs on the thread of a fiber that was handed the lock or woken to retry */
+static void janet_lock_cb(JanetEVGenericMessage msg) {
+    JanetLock *lock = msg.argp;
+    JanetLockWaiter waiter;
+    waiter.thread = &janet_vm;
+    waiter.fiber = msg.fiber;
+    waiter.sched_id = (uint32_t) msg.argi;
+    waiter.is_write = msg.tag & 1;
+    waiter.since = (uint64_t) janet_unwrap_number(msg.argj);
+    int is_live = waiter.fiber->sched_id == waiter.sched_id;
+    int acquired = msg.tag & JANET_LOCK_GRANT;
+    if (!acquired) {
+        janet_lock_guard(lock);
+        acquired = janet_lock_try_or_wait(lock, &waiter, 1);
+        janet_lock_unguard(lock);
+        /* Still waiting, the queue keeps the fiber rooted and the reference */
+        if (!acquired) return;
+        janet_lock_count(&lock->wait_ns, (int64_t)(ev_stats_now() - waiter.since));
+    }
+    janet_gcunroot(janet_wrap_fiber(waiter.fiber));
+    if (is_live) {
+        janet_schedule(waiter.fiber, janet_wrap_abstract(lock));
+    } else {
+        /* The fiber stopped waiting, pass the lock on */
+        janet_lock_release(lock, waiter.is_write);
+    }
+    janet_lock_unref(lock);
+}
+
+/* Wake the next fibers waiting for the lock - either one writer or all the readers at
+ * the head of the queue - and any blocked threads. Expects the guard to be held, and
+ * the lock to be held by the caller and no one else. */
+static void janet_lock_handoff(JanetLock *lock) {
+    JanetQueue woken;
+    JanetLockWaiter waiter;
+    JanetAtomicInt next = 0;
+    int grant = 0;
+    uint64_t now = ev_stats_now();
+    janet_q_init(&woken);
+    while (!janet_q_pop(&lock->waiting, &waiter, sizeof(waiter))) {
+        /* Skip fibers whose thread is gone, and fibers on this thread that stopped waiting */
+        if (NULL == waiter.thread) continue;
+        if (waiter.thread == &janet_vm && waiter.fiber->sched_id != waiter.sched_id) {
+            janet_gcunroot(janet_wrap_fiber(waiter.fiber));
+            janet_abstract_decref(lock);
+            continue;
+        }
+        if (janet_q_count(&woken) == 0) {
+            grant = waiter.thread == &janet_vm || now - waiter.since >= JANET_LOCK_FAIR_NS;
+        } else if (waiter.is_write) {
+            janet_q_push_head(&lock->waiting, &waiter, sizeof(waiter));
+            break;
+        }
+        if (grant) {
+            janet_lock_count(&lock->wait_ns, (int64_t)(now - waiter.since));
+            next += waiter.is_write ? JANET_LOCK_WRITER : JANET_LOCK_READER;
+        }
+        janet_q_push(&woken, &waiter, sizeof(waiter));
+        if (waiter.is_write) break;
+    }
+    if (janet_q_count(&lock->waiting) || lock->blocked) next |= JANET_LOCK_WAITING;
+    /* Publish the new state before waking anyone, a new holder may release right away. */
+    janet_lock_store(&lock->state, next);
+    while (!janet_q_pop(&woken, &waiter, sizeof(waiter))) {
+        janet_lock_wake(lock, &waiter, grant);
+    }
+    if (lock->blocked) janet_poolcond_broadcast(&lock->unblocked);
+    janet_q_deinit(&woken);
+}
+
+/* Returns 1 if the lock was not held in the given mode. */
+static int janet_lock_release(JanetLock *lock, int is_write) {
+    for (;;) {
+        JanetAtomicInt s = janet_lock_load(&lock->state);
+        JanetAtomicInt next;
+        if (is_write) {
+            if (!(s & JANET_LOCK_WRITER)) return 1;
+            next = s & ~JANET_LOCK_WRITER;
+        } else {
+            if (s < JANET_LOCK_READER) return 1;
+            next = s - JANET_LOCK_READER;
+        }
+        /* The last holder with fibers waiting hands the lock over */
+        if (next == JANET_LOCK_WAITING) break;
+        if (janet_lock_cas(&lock->state, s, next)) return 0;
+    }
+    janet_lock_guard(lock);
+    janet_lock_handoff(lock);
+    janet_lock_unguard(lock);
+    return 0;
+}
+
+/* Whether an await would reach the event loop. It would not inside janet_call, or in
+ * a fiber that was run from C rather than resumed by its parent. */
+static int janet_lock_can_park(void) {
+    if (janet_vm.coerce_error) return 0;
+    JanetFiber *f = janet_vm.root_fiber;
+    while (NULL != f && f != janet_vm.fiber) f = f->child;
+    return NULL != f;
+}
+
+/* Wait for the lock by blocking the thread. Blocked threads retry whenever the lock
+ * is handed over. */
+static void janet_lock_block(JanetLock *lock, int is_write) {
+    janet_lock_guard(lock);
+    lock->blocked++;
+    for (;;) {
+        JanetAtomicInt s = janet_lock_load(&lock->state);
+        if (janet_lock_available(s, is_write, 1)) {
+            JanetAtomicInt next = s + (is_write ? JANET_LOCK_WRITER : JANET_LOCK_READER);
+            if (janet_lock_cas(&lock->state, s, next)) break;
+        } else if ((s & JANET_LOCK_WAITING) || janet_lock_cas(&lock->state, s, s | JANET_LOCK_WAITING)) {
+            janet_poolcond_wait(&lock->unblocked, &lock->guard);
+        }
+    }
+    lock->blocked--;
+    janet_lock_unguard(lock);
+}
+
+static Janet janet_lock_acquire(JanetLock *lock, int is_write, Janet x) {
+    janet_lock_count(&lock->acquisitions, 1);
+    if (janet_lock_try(lock, is_write, 0)) return x;
+    janet_lock_count(&lock->contended, 1);
+    uint64_t start = ev_stats_now();
+    for (int i = 0; i < JANET_LOCK_SPIN; i++) {
+        janet_lock_pause();
+        if (janet_lock_try(lock, is_write, 0)) {
+            janet_lock_count(&lock->wait_ns, (int64_t)(ev_stats_now() - start));
+            return x;
+        }
+    }
+    if (!janet_lock_can_park()) {
+        janet_lock_block(lock, is_write);
+        janet_lock_count(&lock->wait_ns, (int64_t)(ev_stats_now() - start));
+        return x;
+    }
+    JanetLockWaiter waiter;
+    waiter.thread = &janet_vm;
+    waiter.fiber = janet_vm.root_fiber;
+    waiter.sched_id = janet_vm.root_fiber->sched_id;
+    waiter.is_write = is_write;
+    waiter.since = start;
+    janet_lock_guard(lock);
+    if (janet_lock_try_or_wait(lock, &waiter, 0)) {
+        janet_lock_unguard(lock);
+        janet_lock_count(&lock->wait_ns, (int64_t)(ev_stats_now() - start));
+        return x;
+    }
+    janet_abstract_incref(lock);
+    janet_lock_unguard(lock);
+    janet_lock_count(&lock->parked, 1);
+    janet_gcroot(janet_wrap_fiber(waiter.fiber));
+    janet_await();
+}
+
+static Janet janet_lock_new(const JanetAbstractType *at) {
+    JanetLock *lock = janet_abstract_threaded(at, sizeof(JanetLock));
+    janet_lock_init(lock);
+    return janet_wrap_abstract(lock);
+}
+
 JANET_CORE_FN(janet_cfun_mutex,
               "(ev/lock)",
               "Create a new lock to coordinate threads.") {
     janet_fixarity(argc, 0);
     (void) argv;
-    void *mutex = janet_abstract_threaded(&janet_mutex_type, janet_os_mutex_size());
-    janet_os_mutex_init(mutex);
-    return janet_wrap_abstract(mutex);
+    return janet_lock_new(&janet_mutex_type);
 }
 
 JANET_CORE_FN(janet_cfun_mutex_acquire,
               "(ev/acquire-lock lock)",
-              "Acquire a lock such that this operating system thread is the only thread with access to this resource."
-              " This will block this entire thread until the lock becomes available, and will not yield to other fibers "
-              "on this system thread.") {
+              "Acquire a lock such that the current fiber is the only one with access to this resource. "
+              "If another fiber holds the lock, spin for a short while, then suspend the current fiber until "
+              "the lock is handed to it. Other fibers on this thread keep running while it waits. Waiting "
+              "fibers are not served in strict order, as a fiber that has just arrived may take a lock that "
+              "was released, but one that has waited for about a millisecond is handed the lock directly. "
+              "Where the fiber can't be suspended, such as in a function called from C like a `sort` "
+              "comparator, the whole thread blocks until the lock is free.") {
     janet_fixarity(argc, 1);
-    void *mutex = janet_getabstract(argv, 0, &janet_mutex_type);
-    janet_os_mutex_lock(mutex);
-    return argv[0];
+    JanetLock *lock = janet_getabstract(argv, 0, &janet_mutex_type);
+    return janet_lock_acquire(lock, 1, argv[0]);
 }
 
 JANET_CORE_FN(janet_cfun_mutex_release,
               "(ev/release-lock lock)",
-              "Release a lock such that other threads may acquire it.") {
+              "Release a lock such that other fibers and threads may acquire it.") {
     janet_fixarity(argc, 1);
-    void *mutex = janet_getabstract(argv, 0, &janet_mutex_type);
-    janet_os_mutex_unlock(mutex);
+    JanetLock *lock = janet_getabstract(argv, 0, &janet_mutex_type);
+    if (janet_lock_release(lock, 1)) janet_panic("lock is not held");
     return argv[0];
 }
 
-static int rwlockgc(void *p, size_t size) {
-    (void) size;
-    janet_os_rwlock_deinit(p);
-    return 0;
-}
-
-const JanetAbstractType janet_rwlock_type = {
-    "core/rwlock",
-    rwlockgc,
-    JANET_ATEND_GC
-};
-
 JANET_CORE_FN(janet_cfun_rwlock,
               "(ev/rwlock)",
               "Create a new read-write lock to coordinate threads.") {
     janet_fixarity(argc, 0);
     (void) argv;
-    void *rwlock = janet_abstract_threaded(&janet_rwlock_type, janet_os_rwlock_size());
-    janet_os_rwlock_init(rwlock);
-    return janet_wrap_abstract(rwlock);
+    return janet_lock_new(&janet_rwlock_type);
 }
 
 JANET_CORE_FN(janet_cfun_rwlock_read_lock,
               "(ev/acquire-rlock rwlock)",
-              "Acquire a read lock an a read-write lock.") {
+              "Acquire a read lock an a read-write lock. Waits like `ev/acquire-lock` while a writer holds "
+              "the lock or is waiting for it.") {
     janet_fixarity(argc, 1);
-    void *rwlock = janet_getabstract(argv, 0, &janet_rwlock_type);
-    janet_os_rwlock_rlock(rwlock);
-    return argv[0];
+    JanetLock *lock = janet_getabstract(argv, 0, &janet_rwlock_type);
+    return janet_lock_acquire(lock, 0, argv[0]);
 }
 
 JANET_CORE_FN(janet_cfun_rwlock_write_lock,
               "(ev/acquire-wlock rwlock)",
-              "Acquire a write lock on a read-write lock.") {
+              "Acquire a write lock on a read-write lock. Waits like `ev/acquire-lock` while readers or "
+              "another writer hold the lock.") {
     janet_fixarity(argc, 1);
-    void *rwlock = janet_getabstract(argv, 0, &janet_rwlock_type);
-    janet_os_rwlock_wlock(rwlock);
-    return argv[0];
+    JanetLock *lock = janet_getabstract(argv, 0, &janet_rwlock_type);
+    return janet_lock_acquire(lock, 1, argv[0]);
 }
 
 JANET_CORE_FN(janet_cfun_rwlock_read_release,
               "(ev/release-rlock rwlock)",
               "Release a read lock on a read-write lock") {
     janet_fixarity(argc, 1);
-    void *rwlock = janet_getabstract(argv, 0, &janet_rwlock_type);
-    janet_os_rwlock_runlock(rwlock);
+    JanetLock *lock = janet_getabstract(argv, 0, &janet_rwlock_type);
+    if (janet_lock_release(lock, 0)) janet_panic("read lock is not held");
     return argv[0];
 }
 
@@ -3462,11 +7057,45 @@ JANET_CORE_FN(janet_cfun_rwlock_write_release,
               "(ev/release-wlock rwlock)",
               "Release a write lock on a read-write lock") {
     janet_fixarity(argc, 1);
-    void *rwlock = janet_getabstract(argv, 0, &janet_rwlock_type);
-    janet_os_rwlock_wunlock(rwlock);
+    JanetLock *lock = janet_getabstract(argv, 0, &janet_rwlock_type);
+    if (janet_lock_release(lock, 1)) janet_panic("write lock is not held");
     return argv[0];
 }
 
+JANET_CORE_FN(janet_cfun_lock_stats,
+              "(ev/lock-stats lock &opt reset)",
+              "Get a table of counters for a lock or read-write lock, shared by all threads using it:\n\n"
+              "* `:acquisitions` - number of times the lock was acquired or waited for\n\n"
+              "* `:contended` - number of acquisitions that found the lock held\n\n"
+              "* `:parked` - number of contended acquisitions that suspended their fiber\n\n"
+              "* `:wait-time` - total time in seconds that contended acquisitions waited\n\n"
+              "* `:waiting` - number of fibers waiting for the lock right now\n\n"
+              "If `reset` is truthy, the counters are cleared after being read.") {
+    janet_arity(argc, 1, 2);
+    JanetLock *lock = janet_checkabstract(argv[0], &janet_mutex_type);
+    if (NULL == lock) lock = janet_getabstract(argv, 0, &janet_rwlock_type);
+    janet_lock_guard(lock);
+    int32_t waiting = janet_q_count(&lock->waiting);
+    janet_lock_unguard(lock);
+    JanetTable *t = janet_table(5);
+    janet_table_put(t, janet_ckeywordv("acquisitions"),
+                    janet_wrap_number((double) janet_lock_count_load(&lock->acquisitions)));
+    janet_table_put(t, janet_ckeywordv("contended"),
+                    janet_wrap_number((double) janet_lock_count_load(&lock->contended)));
+    janet_table_put(t, janet_ckeywordv("parked"),
+                    janet_wrap_number((double) janet_lock_count_load(&lock->parked)));
+    janet_table_put(t, janet_ckeywordv("wait-time"),
+                    janet_wrap_number((double) janet_lock_count_load(&lock->wait_ns) / 1e9));
+    janet_table_put(t, janet_ckeywordv("waiting"), janet_wrap_integer(waiting));
+    if (argc > 1 && janet_truthy(argv[1])) {
+        janet_lock_count_store(&lock->acquisitions, 0);
+        janet_lock_count_store(&lock->contended, 0);
+        janet_lock_count_store(&lock->parked, 0);
+        janet_lock_count_store(&lock->wait_ns, 0);
+    }
+    return janet_wrap_table(t);
+}
+
 static JanetFile *get_file_for_stream(JanetStream *stream) {
     int32_t flags = 0;
     char fmt[4] = {0};
@@ -3539,9 +7168,93 @@ JANET_CORE_FN(janet_cfun_ev_all_tasks,
     return janet_wrap_array(array);
 }
 
+static Janet ev_stats_histogram(JanetEVHistogram *h) {
+    JanetTable *t = janet_table(4);
+    JanetArray *buckets = janet_array(JANET_EV_HIST_BUCKETS);
+    for (int i = 0; i < JANET_EV_HIST_BUCKETS; i++) {
+        buckets->data[i] = janet_wrap_number((double) h->buckets[i]);
+    }
+    buckets->count = JANET_EV_HIST_BUCKETS;
+    janet_table_put(t, janet_ckeywordv("count"), janet_wrap_number((double) h->count));
+    janet_table_put(t, janet_ckeywordv("total"), janet_wrap_number((double) h->total / 1e9));
+    janet_table_put(t, janet_ckeywordv("max"), janet_wrap_number((double) h->max / 1e9));
+    janet_table_put(t, janet_ckeywordv("buckets"), janet_wrap_array(buckets));
+    return janet_wrap_table(t);
+}
+
+JANET_CORE_FN(janet_cfun_ev_stats,
+              "(ev/stats &opt reset)",
+              "Get a table describing the health of the event loop on the current thread. "
+              "The table contains:\n\n"
+              "* `:spawn-queue` - number of fibers waiting to be resumed\n\n"
+              "* `:timeouts` - number of pending timeouts and sleeps\n\n"
+              "* `:streams` - number of open streams\n\n"
+              "* `:listeners` - number of pending events the loop is waiting on\n\n"
+              "* `:active-tasks` - number of fibers tracked by the scheduler, see `ev/all-tasks`\n\n"
+              "* `:iterations` - number of loop iterations so far\n\n"
+              "* `:latency` - histogram of the time from the start of each iteration until the loop "
+              "waits for events again, which is how long a ready event may go unhandled\n\n"
+              "* `:run` - histogram of the time spent running fibers in each iteration\n\n"
+              "Each histogram is a table with `:count`, `:total` and `:max` (in seconds), and "
+              "`:buckets`, an array where bucket i counts iterations shorter than 2^i microseconds "
+              "but not shorter than 2^(i-1) microseconds, and the last bucket counts all longer ones. "
+              "If `reset` is truthy, the iteration count and histograms are cleared after being read.") {
+    janet_arity(argc, 0, 1);
+    int reset = argc > 0 && janet_truthy(argv[0]);
+    JanetEVStats *stats = &janet_vm.ev_stats;
+    int32_t queued = janet_vm.spawn.tail - janet_vm.spawn.head;
+    if (queued < 0) queued += janet_vm.spawn.capacity;
+    JanetTable *t = janet_table(8);
+    janet_table_put(t, janet_ckeywordv("spawn-queue"), janet_wrap_integer(queued));
+    janet_table_put(t, janet_ckeywordv("timeouts"), janet_wrap_number((double) janet_vm.tq_count));
+    janet_table_put(t, janet_ckeywordv("streams"), janet_wrap_number((double) stats->streams));
+    janet_table_put(t, janet_ckeywordv("listeners"),
+                    janet_wrap_integer(janet_atomic_load(&janet_vm.listener_count)));
+    janet_table_put(t, janet_ckeywordv("active-tasks"), janet_wrap_integer(janet_vm.active_tasks.count));
+    janet_table_put(t, janet_ckeywordv("iterations"), janet_wrap_number((double) stats->iterations));
+    janet_table_put(t, janet_ckeywordv("latency"), ev_stats_histogram(&stats->latency));
+    janet_table_put(t, janet_ckeywordv("run"), ev_stats_histogram(&stats->run));
+    if (reset) {
+        stats->iterations = 0;
+        memset(&stats->latency, 0, sizeof(stats->latency));
+        memset(&stats->run, 0, sizeof(stats->run));
+    }
+    return janet_wrap_table(t);
+}
+
+JANET_CORE_FN(janet_cfun_ev_on_slow_loop,
+              "(ev/on-slow-loop threshold &opt handler)",
+              "Call `handler` whenever an iteration of the event loop on the current thread takes at least "
+              "`threshold` seconds, measured as for the `:latency` histogram of `ev/stats`. The handler is "
+              "called in a new fiber as `(handler elapsed fiber fiber-time)`, where `fiber` is the fiber that "
+              "ran the longest during the slow iteration (or nil) and `fiber-time` is how long it ran. "
+              "Timing individual fibers adds a small cost to every resume while a handler is set. "
+              "If `handler` is nil, removes the current handler. Returns the previous handler.") {
+    janet_arity(argc, 1, 2);
+    double threshold = janet_getnumber(argv, 0);
+    if (threshold < 0) janet_panicf("expected non-negative threshold, got %v", argv[0]);
+    JanetEVStats *stats = &janet_vm.ev_stats;
+    Janet previous = stats->slow_handler ? janet_wrap_function(stats->slow_handler) : janet_wrap_nil();
+    stats->slow_threshold = (uint64_t)(threshold * 1e9);
+    if (argc < 2 || janet_checktype(argv[1], JANET_NIL)) {
+        stats->slow_handler = NULL;
+        stats->slow_env = NULL;
+    } else {
+        JanetFunction *handler = janet_getfunction(argv, 1);
+        if (handler->def->min_arity > 3) {
+            janet_panicf("handler must accept 3 arguments");
+        }
+        stats->slow_handler = handler;
+        stats->slow_env = janet_vm.fiber->env;
+    }
+    return previous;
+}
+
 void janet_lib_ev(JanetTable *env) {
     JanetRegExt ev_cfuns_ext[] = {
         JANET_CORE_REG("ev/give", cfun_channel_push),
+        JANET_CORE_REG("ev/give-many", cfun_channel_push_many),
+        JANET_CORE_REG("ev/take-many", cfun_channel_pop_many),
         JANET_CORE_REG("ev/take", cfun_channel_pop),
         JANET_CORE_REG("ev/full", cfun_channel_full),
         JANET_CORE_REG("ev/capacity", cfun_channel_capacity),
@@ -3550,9 +7263,13 @@ void janet_lib_ev(JanetTable *env) {
         JANET_CORE_REG("ev/rselect", cfun_channel_rchoice),
         JANET_CORE_REG("ev/chan", cfun_channel_new),
         JANET_CORE_REG("ev/thread-chan", cfun_channel_new_threaded),
+        JANET_CORE_REG("ev/ring-chan", cfun_channel_new_ring),
         JANET_CORE_REG("ev/chan-close", cfun_channel_close),
         JANET_CORE_REG("ev/go", cfun_ev_go),
         JANET_CORE_REG("ev/thread", cfun_ev_thread),
+        JANET_CORE_REG("ev/pool", cfun_ev_pool),
+        JANET_CORE_REG("ev/pool-spawn", cfun_ev_pool_spawn),
+        JANET_CORE_REG("ev/threaded-pool", cfun_ev_threaded_pool),
         JANET_CORE_REG("ev/give-supervisor", cfun_ev_give_supervisor),
         JANET_CORE_REG("ev/sleep", cfun_ev_sleep),
         JANET_CORE_REG("ev/deadline", cfun_ev_deadline),
@@ -3560,7 +7277,12 @@ void janet_lib_ev(JanetTable *env) {
         JANET_CORE_REG("ev/close", janet_cfun_stream_close),
         JANET_CORE_REG("ev/read", janet_cfun_stream_read),
         JANET_CORE_REG("ev/chunk", janet_cfun_stream_chunk),
+        JANET_CORE_REG("ev/reader", cfun_ev_reader),
+        JANET_CORE_REG("ev/read-line", cfun_ev_read_line),
+        JANET_CORE_REG("ev/read-until", cfun_ev_read_until),
+        JANET_CORE_REG("ev/read-exactly", cfun_ev_read_exactly),
         JANET_CORE_REG("ev/write", janet_cfun_stream_write),
+        JANET_CORE_REG("ev/splice", cfun_ev_splice),
         JANET_CORE_REG("ev/lock", janet_cfun_mutex),
         JANET_CORE_REG("ev/acquire-lock", janet_cfun_mutex_acquire),
         JANET_CORE_REG("ev/release-lock", janet_cfun_mutex_release),
@@ -3569,16 +7291,22 @@ void janet_lib_ev(JanetTable *env) {
         JANET_CORE_REG("ev/acquire-wlock", janet_cfun_rwlock_write_lock),
         JANET_CORE_REG("ev/release-rlock", janet_cfun_rwlock_read_release),
         JANET_CORE_REG("ev/release-wlock", janet_cfun_rwlock_write_release),
+        JANET_CORE_REG("ev/lock-stats", janet_cfun_lock_stats),
         JANET_CORE_REG("ev/to-file", janet_cfun_to_file),
         JANET_CORE_REG("ev/all-tasks", janet_cfun_ev_all_tasks),
+        JANET_CORE_REG("ev/stats", janet_cfun_ev_stats),
+        JANET_CORE_REG("ev/on-slow-loop", janet_cfun_ev_on_slow_loop),
         JANET_REG_END
     };
 
     janet_core_cfuns_ext(env, NULL, ev_cfuns_ext);
     janet_register_abstract_type(&janet_stream_type);
     janet_register_abstract_type(&janet_channel_type);
+    janet_register_abstract_type(&janet_ring_channel_type);
+    janet_register_abstract_type(&janet_stream_reader_type);
     janet_register_abstract_type(&janet_mutex_type);
     janet_register_abstract_type(&janet_rwlock_type);
+    janet_register_abstract_type(&janet_thread_pool_type);
 }
 
 #endif
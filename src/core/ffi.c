@@ -38,13 +38,6 @@
 #define alloca __builtin_alloca
 #endif
 
-/* FFI jit includes */
-#ifdef JANET_FFI_JIT
-#ifndef JANET_WINDOWS
-#include <sys/mman.h>
-#endif
-#endif
-
 #define JANET_FFI_MAX_RECUR 64
 
 /* Compiler, OS, and arch detection. Used
@@ -180,12 +173,21 @@ typedef enum {
 
 #define JANET_FFI_MAX_ARGS 32
 
+/* Signatures whose arguments are all scalars passed in registers, and whose
+ * return value is a scalar or void, skip the generic marshaling in ffi/call. */
+typedef enum {
+    JANET_FFI_FAST_NONE,
+    JANET_FFI_FAST_REGS, /* Scalar arguments in integer and floating point registers */
+    JANET_FFI_FAST_INTS /* Scalar arguments in integer registers only */
+} JanetFFIFastPath;
+
 typedef struct {
     uint32_t frame_size;
     uint32_t arg_count;
     uint32_t word_count;
     uint32_t variant;
     uint32_t stack_count;
+    JanetFFIFastPath fast;
     JanetFFICallingConvention cc;
     JanetFFIMapping ret;
     JanetFFIMapping args[JANET_FFI_MAX_ARGS];
@@ -239,11 +241,7 @@ static int janet_ffijit_gc(void *p, size_t s) {
     JanetFFIJittedFn *fn = p;
     if (fn->function_pointer == NULL) return 0;
 #ifdef JANET_FFI_JIT
-#ifdef JANET_WINDOWS
-    VirtualFree(fn->function_pointer, fn->size, MEM_RELEASE);
-#else
-    munmap(fn->function_pointer, fn->size);
-#endif
+    janet_exec_unmap(fn->function_pointer, fn->size);
 #endif
     return 0;
 }
@@ -276,6 +274,21 @@ typedef struct {
     int is_self;
 } JanetAbstractNative;
 
+/* A function pointer bound to a signature with ffi/bind */
+typedef struct {
+    Janet callable; /* Keeps a jitted function alive */
+    void *function_pointer;
+    JanetFFISignature *signature;
+} JanetFFIBoundFn;
+
+static int janet_ffibound_mark(void *p, size_t s) {
+    (void) s;
+    JanetFFIBoundFn *fn = p;
+    janet_mark(fn->callable);
+    janet_mark(janet_wrap_abstract(fn->signature));
+    return 0;
+}
+
 static const JanetAbstractType janet_native_type = {
     "core/ffi-native",
     JANET_ATEND_NAME
@@ -1164,9 +1177,32 @@ JANET_CORE_FN(cfun_ffi_signature,
 #endif
     }
 
+    /* Check if calls can take the fast path */
+    JanetFFIFastPath fast = JANET_FFI_FAST_NONE;
+#ifdef JANET_FFI_SYSV64_ENABLED
+    if (cc == JANET_FFI_CC_SYSV_64 && stack_count == 0 &&
+            (ret.spec == JANET_SYSV64_NO_CLASS || ((ret.spec == JANET_SYSV64_INTEGER || ret.spec == JANET_SYSV64_SSE) &&
+                    ret.type.prim != JANET_FFI_TYPE_STRUCT && ret.type.array_count < 0))) {
+        fast = JANET_FFI_FAST_INTS;
+        for (uint32_t i = 0; i < arg_count; i++) {
+            if (mappings[i].type.prim == JANET_FFI_TYPE_STRUCT || mappings[i].type.array_count >= 0) {
+                fast = JANET_FFI_FAST_NONE;
+                break;
+            }
+            if (mappings[i].spec == JANET_SYSV64_SSE) {
+                fast = JANET_FFI_FAST_REGS;
+            } else if (mappings[i].spec != JANET_SYSV64_INTEGER) {
+                fast = JANET_FFI_FAST_NONE;
+                break;
+            }
+        }
+    }
+#endif
+
     /* Create signature abstract value */
     JanetFFISignature *abst = janet_abstract(&janet_signature_type, sizeof(JanetFFISignature));
     abst->frame_size = frame_size;
+    abst->fast = fast;
     abst->cc = cc;
     abst->ret = ret;
     abst->arg_count = arg_count;
@@ -1209,7 +1245,7 @@ typedef sysv64_intsse_return janet_sysv64_variant_3(uint64_t a, uint64_t b, uint
 typedef sysv64_sseint_return janet_sysv64_variant_4(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f,
         double r1, double r2, double r3, double r4, double r5, double r6, double r7, double r8);
 
-static Janet janet_ffi_sysv64(JanetFFISignature *signature, void *function_pointer, const Janet *argv) {
+static Janet janet_ffi_sysv64(JanetFFISignature *signature, void *function_pointer, const Janet *argv, int32_t first) {
     union {
         sysv64_int_return int_return;
         sysv64_sse_return sse_return;
@@ -1228,7 +1264,7 @@ static Janet janet_ffi_sysv64(JanetFFISignature *signature, void *function_point
     uint64_t *stack = alloca(sizeof(uint64_t) * signature->stack_count);
     for (uint32_t i = 0; i < signature->arg_count; i++) {
         uint64_t *to;
-        int32_t n = i + 2;
+        int32_t n = i + first;
         JanetFFIMapping arg = signature->args[i];
         switch (arg.spec) {
             default:
@@ -1296,6 +1332,132 @@ static Janet janet_ffi_sysv64(JanetFFISignature *signature, void *function_point
     return janet_ffi_read_one(ret_mem, signature->ret.type, JANET_FFI_MAX_RECUR);
 }
 
+/* Prototypes with an exact number of integer arguments, for calls that do not
+ * use floating point registers. */
+typedef uint64_t janet_sysv64_int_0(void);
+typedef uint64_t janet_sysv64_int_1(uint64_t a);
+typedef uint64_t janet_sysv64_int_2(uint64_t a, uint64_t b);
+typedef uint64_t janet_sysv64_int_3(uint64_t a, uint64_t b, uint64_t c);
+typedef uint64_t janet_sysv64_int_4(uint64_t a, uint64_t b, uint64_t c, uint64_t d);
+typedef uint64_t janet_sysv64_int_5(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e);
+typedef uint64_t janet_sysv64_int_6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f);
+typedef double janet_sysv64_sse_0(void);
+typedef double janet_sysv64_sse_1(uint64_t a);
+typedef double janet_sysv64_sse_2(uint64_t a, uint64_t b);
+typedef double janet_sysv64_sse_3(uint64_t a, uint64_t b, uint64_t c);
+typedef double janet_sysv64_sse_4(uint64_t a, uint64_t b, uint64_t c, uint64_t d);
+typedef double janet_sysv64_sse_5(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e);
+typedef double janet_sysv64_sse_6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f);
+
+/* Convert a scalar argument into a register word. Small integers are
+ * extended to the full word. */
+static uint64_t janet_ffi_scalar_word(const Janet *argv, int32_t n, JanetFFIPrimType prim) {
+    union {
+        uint64_t u;
+        double d;
+        float f;
+    } word;
+    switch (prim) {
+        default:
+        case JANET_FFI_TYPE_PTR:
+            return (uint64_t) janet_ffi_getpointer(argv, n);
+        case JANET_FFI_TYPE_DOUBLE:
+            word.d = janet_getnumber(argv, n);
+            return word.u;
+        case JANET_FFI_TYPE_FLOAT:
+            word.u = 0;
+            word.f = (float) janet_getnumber(argv, n);
+            return word.u;
+        case JANET_FFI_TYPE_STRING:
+            return (uint64_t) janet_getcstring(argv, n);
+        case JANET_FFI_TYPE_BOOL:
+            return (uint64_t) janet_getboolean(argv, n);
+        case JANET_FFI_TYPE_INT8:
+            return (uint64_t)(int8_t) janet_getinteger(argv, n);
+        case JANET_FFI_TYPE_INT16:
+            return (uint64_t)(int16_t) janet_getinteger(argv, n);
+        case JANET_FFI_TYPE_INT32:
+            return (uint64_t)(int32_t) janet_getinteger(argv, n);
+        case JANET_FFI_TYPE_INT64:
+            return (uint64_t) janet_getinteger64(argv, n);
+        case JANET_FFI_TYPE_UINT8:
+            return (uint8_t) janet_getuinteger64(argv, n);
+        case JANET_FFI_TYPE_UINT16:
+            return (uint16_t) janet_getuinteger64(argv, n);
+        case JANET_FFI_TYPE_UINT32:
+            return (uint32_t) janet_getuinteger64(argv, n);
+        case JANET_FFI_TYPE_UINT64:
+            return janet_getuinteger64(argv, n);
+    }
+}
+
+static Janet janet_ffi_sysv64_fast(JanetFFISignature *signature, void *function_pointer, const Janet *argv, int32_t first) {
+    union {
+        uint64_t u;
+        double d;
+        sysv64_int_return int_return;
+        sysv64_sse_return sse_return;
+    } retu;
+    uint64_t regs[6];
+    uint64_t fp_regs[8];
+    for (uint32_t i = 0; i < signature->arg_count; i++) {
+        const JanetFFIMapping *arg = signature->args + i;
+        uint64_t word = janet_ffi_scalar_word(argv, i + first, arg->type.prim);
+        if (arg->spec == JANET_SYSV64_SSE) {
+            fp_regs[arg->offset] = word;
+        } else {
+            regs[arg->offset] = word;
+        }
+    }
+    int sse = signature->ret.spec == JANET_SYSV64_SSE;
+    if (signature->fast == JANET_FFI_FAST_INTS) {
+        void *fp = function_pointer;
+        switch (signature->arg_count) {
+            default:
+            case 0:
+                if (sse) retu.d = ((janet_sysv64_sse_0 *) fp)();
+                else retu.u = ((janet_sysv64_int_0 *) fp)();
+                break;
+            case 1:
+                if (sse) retu.d = ((janet_sysv64_sse_1 *) fp)(regs[0]);
+                else retu.u = ((janet_sysv64_int_1 *) fp)(regs[0]);
+                break;
+            case 2:
+                if (sse) retu.d = ((janet_sysv64_sse_2 *) fp)(regs[0], regs[1]);
+                else retu.u = ((janet_sysv64_int_2 *) fp)(regs[0], regs[1]);
+                break;
+            case 3:
+                if (sse) retu.d = ((janet_sysv64_sse_3 *) fp)(regs[0], regs[1], regs[2]);
+                else retu.u = ((janet_sysv64_int_3 *) fp)(regs[0], regs[1], regs[2]);
+                break;
+            case 4:
+                if (sse) retu.d = ((janet_sysv64_sse_4 *) fp)(regs[0], regs[1], regs[2], regs[3]);
+                else retu.u = ((janet_sysv64_int_4 *) fp)(regs[0], regs[1], regs[2], regs[3]);
+                break;
+            case 5:
+                if (sse) retu.d = ((janet_sysv64_sse_5 *) fp)(regs[0], regs[1], regs[2], regs[3], regs[4]);
+                else retu.u = ((janet_sysv64_int_5 *) fp)(regs[0], regs[1], regs[2], regs[3], regs[4]);
+                break;
+            case 6:
+                if (sse) retu.d = ((janet_sysv64_sse_6 *) fp)(regs[0], regs[1], regs[2], regs[3], regs[4], regs[5]);
+                else retu.u = ((janet_sysv64_int_6 *) fp)(regs[0], regs[1], regs[2], regs[3], regs[4], regs[5]);
+                break;
+        }
+    } else {
+        double *d = (double *) fp_regs;
+        if (sse) {
+            retu.sse_return = ((janet_sysv64_variant_2 *)(function_pointer))(
+                                  regs[0], regs[1], regs[2], regs[3], regs[4], regs[5],
+                                  d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+        } else {
+            retu.int_return = ((janet_sysv64_variant_1 *)(function_pointer))(
+                                  regs[0], regs[1], regs[2], regs[3], regs[4], regs[5],
+                                  d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+        }
+    }
+    return janet_ffi_read_one((const uint8_t *) &retu, signature->ret.type, JANET_FFI_MAX_RECUR);
+}
+
 #endif
 
 #ifdef JANET_FFI_WIN64_ENABLED
@@ -1344,7 +1506,7 @@ typedef double (win64_variant_f_ffif)(double, double, uint64_t, double);
 typedef double (win64_variant_f_fffi)(double, double, double, uint64_t);
 typedef double (win64_variant_f_ffff)(double, double, double, double);
 
-static Janet janet_ffi_win64(JanetFFISignature *signature, void *function_pointer, const Janet *argv) {
+static Janet janet_ffi_win64(JanetFFISignature *signature, void *function_pointer, const Janet *argv, int32_t first) {
     union {
         uint64_t integer;
         double real;
@@ -1363,7 +1525,7 @@ static Janet janet_ffi_win64(JanetFFISignature *signature, void *function_pointe
     size_t stack_shift = 2;
     uint64_t *stack = alloca(stack_size);
     for (uint32_t i = 0; i < signature->arg_count; i++) {
-        int32_t n = i + 2;
+        int32_t n = i + first;
         JanetFFIMapping arg = signature->args[i];
         if (arg.spec == JANET_WIN64_STACK) {
             janet_ffi_write_one(stack + arg.offset, argv, n, arg.type, JANET_FFI_MAX_RECUR);
@@ -1510,7 +1672,7 @@ typedef Aapcs64Variant3ReturnPointer janet_aapcs64_variant_3(uint64_t x0, uint64
         double v0, double v1, double v2, double v3, double v4, double v5, double v6, double v7);
 
 
-static Janet janet_ffi_aapcs64(JanetFFISignature *signature, void *function_pointer, const Janet *argv) {
+static Janet janet_ffi_aapcs64(JanetFFISignature *signature, void *function_pointer, const Janet *argv, int32_t first) {
     union {
         Aapcs64Variant1ReturnGeneral general_return;
         Aapcs64Variant2ReturnSse sse_return;
@@ -1528,7 +1690,7 @@ static Janet janet_ffi_aapcs64(JanetFFISignature *signature, void *function_poin
     memset(stack, 0, signature->stack_count);
 #endif
     for (uint32_t i = 0; i < signature->arg_count; i++) {
-        int32_t n = i + 2;
+        int32_t n = i + first;
         JanetFFIMapping arg = signature->args[i];
         void *to = NULL;
 
@@ -1589,11 +1751,6 @@ static Janet janet_ffi_aapcs64(JanetFFISignature *signature, void *function_poin
 
 #endif
 
-/* Allocate executable memory chunks in sizes of a page. Ideally we would keep
- * an allocator around so that multiple JIT allocations would point to the same
- * region but it isn't really worth it. */
-#define FFI_PAGE_MASK 0xFFF
-
 JANET_CORE_FN(cfun_ffi_jitfn,
               "(ffi/jitfn bytes)",
               "Create an abstract type that can be used as the pointer argument to `ffi/call`. The content "
@@ -1602,9 +1759,6 @@ JANET_CORE_FN(cfun_ffi_jitfn,
     janet_fixarity(argc, 1);
     JanetByteView bytes = janet_getbytes(argv, 0);
 
-    /* Quick hack to align to page boundary, we should query OS. FIXME */
-    size_t alloc_size = ((size_t) bytes.len + FFI_PAGE_MASK) & ~FFI_PAGE_MASK;
-
 #ifdef JANET_FFI_JIT
 #ifdef JANET_EV
     JanetFFIJittedFn *fn = janet_abstract_threaded(&janet_type_ffijit, sizeof(JanetFFIJittedFn));
@@ -1613,32 +1767,11 @@ JANET_CORE_FN(cfun_ffi_jitfn,
 #endif
     fn->function_pointer = NULL;
     fn->size = 0;
-#ifdef JANET_WINDOWS
-    void *ptr = VirtualAlloc(NULL, alloc_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-#elif defined(MAP_ANONYMOUS)
-    void *ptr = mmap(0, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-#elif defined(MAP_ANON)
-    /* macos doesn't have MAP_ANONYMOUS */
-    void *ptr = mmap(0, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
-#else
-    /* -std=c99 gets in the way */
-    /* #define MAP_ANONYMOUS 0x20 should work, though. */
-    void *ptr = mmap(0, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, -1, 0);
-#endif
-    if (!ptr) {
-        janet_panic("failed to memory map writable memory");
-    }
-    memcpy(ptr, bytes.bytes, bytes.len);
-#ifdef JANET_WINDOWS
-    DWORD old = 0;
-    if (!VirtualProtect(ptr, alloc_size, PAGE_EXECUTE_READ, &old)) {
-        janet_panic("failed to make mapped memory executable");
-    }
-#else
-    if (mprotect(ptr, alloc_size, PROT_READ | PROT_EXEC) == -1) {
-        janet_panic("failed to make mapped memory executable");
+    size_t alloc_size = 0;
+    void *ptr = janet_exec_map(bytes.bytes, (size_t) bytes.len, &alloc_size);
+    if (NULL == ptr) {
+        janet_panic("failed to map executable memory");
     }
-#endif
     fn->size = alloc_size;
     fn->function_pointer = ptr;
     return janet_wrap_abstract(fn);
@@ -1647,35 +1780,73 @@ JANET_CORE_FN(cfun_ffi_jitfn,
 #endif
 }
 
-JANET_CORE_FN(cfun_ffi_call,
-              "(ffi/call pointer signature & args)",
-              "Call a raw pointer as a function pointer. The function signature specifies "
-              "how Janet values in `args` are converted to native machine types.") {
-    janet_sandbox_assert(JANET_SANDBOX_FFI_USE);
-    janet_arity(argc, 2, -1);
-    void *function_pointer = janet_ffi_get_callable_pointer(argv, 0);
-    JanetFFISignature *signature = janet_getabstract(argv, 1, &janet_signature_type);
-    janet_fixarity(argc - 2, signature->arg_count);
+/* Convert the arguments starting at argv[first] and call the function pointer */
+static Janet janet_ffi_call_signature(JanetFFISignature *signature, void *function_pointer, const Janet *argv, int32_t first) {
     switch (signature->cc) {
         default:
         case JANET_FFI_CC_NONE:
             (void) function_pointer;
+            (void) argv;
+            (void) first;
             janet_panic("calling convention not supported");
 #ifdef JANET_FFI_WIN64_ENABLED
         case JANET_FFI_CC_WIN_64:
-            return janet_ffi_win64(signature, function_pointer, argv);
+            return janet_ffi_win64(signature, function_pointer, argv, first);
 #endif
 #ifdef JANET_FFI_SYSV64_ENABLED
         case JANET_FFI_CC_SYSV_64:
-            return janet_ffi_sysv64(signature, function_pointer, argv);
+            if (signature->fast != JANET_FFI_FAST_NONE) {
+                return janet_ffi_sysv64_fast(signature, function_pointer, argv, first);
+            }
+            return janet_ffi_sysv64(signature, function_pointer, argv, first);
 #endif
 #ifdef JANET_FFI_AAPCS64_ENABLED
         case JANET_FFI_CC_AAPCS64:
-            return janet_ffi_aapcs64(signature, function_pointer, argv);
+            return janet_ffi_aapcs64(signature, function_pointer, argv, first);
 #endif
     }
 }
 
+JANET_CORE_FN(cfun_ffi_call,
+              "(ffi/call pointer signature & args)",
+              "Call a raw pointer as a function pointer. The function signature specifies "
+              "how Janet values in `args` are converted to native machine types.") {
+    janet_sandbox_assert(JANET_SANDBOX_FFI_USE);
+    janet_arity(argc, 2, -1);
+    void *function_pointer = janet_ffi_get_callable_pointer(argv, 0);
+    JanetFFISignature *signature = janet_getabstract(argv, 1, &janet_signature_type);
+    janet_fixarity(argc - 2, signature->arg_count);
+    return janet_ffi_call_signature(signature, function_pointer, argv, 2);
+}
+
+static Janet janet_ffibound_call(void *p, int32_t argc, Janet *argv) {
+    JanetFFIBoundFn *fn = p;
+    janet_sandbox_assert(JANET_SANDBOX_FFI_USE);
+    janet_fixarity(argc, fn->signature->arg_count);
+    return janet_ffi_call_signature(fn->signature, fn->function_pointer, argv, 0);
+}
+
+static const JanetAbstractType janet_bound_type = {
+    .name = "core/ffi-bound",
+    .gcmark = janet_ffibound_mark,
+    .call = janet_ffibound_call
+};
+
+JANET_CORE_FN(cfun_ffi_bind,
+              "(ffi/bind pointer signature)",
+              "Bind a raw function pointer to a signature. Returns a value that can be called like "
+              "a function, so `((ffi/bind pointer signature) & args)` is the same as "
+              "`(ffi/call pointer signature & args)`, but without looking up the pointer and signature "
+              "on every call. `ffi/defbind` uses this for bindings that are not lazy.") {
+    janet_sandbox_assert(JANET_SANDBOX_FFI_DEFINE);
+    janet_fixarity(argc, 2);
+    JanetFFIBoundFn *fn = janet_abstract(&janet_bound_type, sizeof(JanetFFIBoundFn));
+    fn->callable = argv[0];
+    fn->function_pointer = janet_ffi_get_callable_pointer(argv, 0);
+    fn->signature = janet_getabstract(argv, 1, &janet_signature_type);
+    return janet_wrap_abstract(fn);
+}
+
 JANET_CORE_FN(cfun_ffi_buffer_write,
               "(ffi/write ffi-type data &opt buffer index)",
               "Append a native type to a buffer such as it would appear in memory. This can be used "
@@ -1719,6 +1890,115 @@ JANET_CORE_FN(cfun_ffi_buffer_read,
     }
 }
 
+#ifdef JANET_TYPED_ARRAY
+/* Check if a typed array stores its elements exactly like a C array of type */
+static int janet_ffi_tarray_matches(JanetFFIType type, JanetTArrayType tt) {
+    if (type.array_count >= 0) return 0;
+    switch (type.prim) {
+        default:
+            return 0;
+        case JANET_FFI_TYPE_INT8:
+            return tt == JANET_TARRAY_S8;
+        case JANET_FFI_TYPE_UINT8:
+            return tt == JANET_TARRAY_U8;
+        case JANET_FFI_TYPE_INT16:
+            return tt == JANET_TARRAY_S16;
+        case JANET_FFI_TYPE_UINT16:
+            return tt == JANET_TARRAY_U16;
+        case JANET_FFI_TYPE_INT32:
+            return tt == JANET_TARRAY_S32;
+        case JANET_FFI_TYPE_UINT32:
+            return tt == JANET_TARRAY_U32;
+        case JANET_FFI_TYPE_FLOAT:
+            return tt == JANET_TARRAY_F32;
+        case JANET_FFI_TYPE_DOUBLE:
+            return tt == JANET_TARRAY_F64;
+    }
+}
+#endif
+
+JANET_CORE_FN(cfun_ffi_buffer_write_array,
+              "(ffi/write-array ffi-type xs &opt buffer index)",
+              "Append the elements of the indexed data structure `xs` to a buffer as a C array of "
+              "`ffi-type`. This is the same as calling `ffi/write` on each element, but the type is only "
+              "decoded once. `xs` can also be a typed array. Returns a modified buffer or a new buffer "
+              "if one is not supplied.") {
+    janet_sandbox_assert(JANET_SANDBOX_FFI_USE);
+    janet_arity(argc, 2, 4);
+    JanetFFIType type = decode_ffi_type(argv[0]);
+    size_t el_size = type_size(type);
+    JanetView view = {NULL, 0};
+#ifdef JANET_TYPED_ARRAY
+    JanetTArray *ta = janet_checkabstract(argv[1], &janet_tarray_type);
+    if (NULL != ta) {
+        view.len = ta->count;
+    } else {
+        view = janet_getindexed(argv, 1);
+    }
+#else
+    view = janet_getindexed(argv, 1);
+#endif
+    if (el_size && (size_t) view.len > INT32_MAX / el_size) janet_panic("buffer overflow");
+    int32_t total = (int32_t)(el_size * (size_t) view.len);
+    JanetBuffer *buffer = janet_optbuffer(argv, argc, 2, total);
+    int32_t index = janet_optnat(argv, argc, 3, buffer->count);
+    int32_t old_count = buffer->count;
+    if (index > old_count) janet_panic("index out of bounds");
+    buffer->count = index;
+    janet_buffer_extra(buffer, total);
+    buffer->count = old_count;
+    uint8_t *to = buffer->data + index;
+    memset(to, 0, total);
+#ifdef JANET_TYPED_ARRAY
+    if (NULL != ta && janet_ffi_tarray_matches(type, ta->type)) {
+        memcpy(to, ta->as.pointer, total);
+    } else if (NULL != ta) {
+        for (int32_t i = 0; i < view.len; i++) {
+            Janet x = janet_tarray_get(ta, i);
+            janet_ffi_write_one(to + el_size * i, &x, 0, type, JANET_FFI_MAX_RECUR);
+        }
+    } else
+#endif
+    {
+        for (int32_t i = 0; i < view.len; i++) {
+            janet_ffi_write_one(to + el_size * i, view.items, i, type, JANET_FFI_MAX_RECUR);
+        }
+    }
+    index += total;
+    if (buffer->count < index) buffer->count = index;
+    return janet_wrap_buffer(buffer);
+}
+
+JANET_CORE_FN(cfun_ffi_buffer_read_array,
+              "(ffi/read-array ffi-type bytes count &opt offset)",
+              "Parse a C array of `count` native values of `ffi-type` out of a buffer and return the "
+              "values in an array. This is the same as calling `ffi/read` on each element, but the type "
+              "is only decoded once. `bytes` can also be a raw pointer, although this is unsafe.") {
+    janet_sandbox_assert(JANET_SANDBOX_FFI_USE);
+    janet_arity(argc, 3, 4);
+    JanetFFIType type = decode_ffi_type(argv[0]);
+    int32_t count = janet_getnat(argv, 2);
+    size_t offset = (size_t) janet_optnat(argv, argc, 3, 0);
+    size_t el_size = type_size(type);
+    const uint8_t *from;
+    if (janet_checktype(argv[1], JANET_POINTER)) {
+        from = (const uint8_t *) janet_unwrap_pointer(argv[1]) + offset;
+    } else {
+        JanetByteView bytes = janet_getbytes(argv, 1);
+        size_t len = (size_t) bytes.len;
+        if (len < offset || (el_size && (size_t) count > (len - offset) / el_size)) {
+            janet_panic("read out of range");
+        }
+        from = bytes.bytes + offset;
+    }
+    JanetArray *array = janet_array(count);
+    for (int32_t i = 0; i < count; i++) {
+        array->data[i] = janet_ffi_read_one(from + el_size * i, type, JANET_FFI_MAX_RECUR);
+    }
+    array->count = count;
+    return janet_wrap_array(array);
+}
+
 JANET_CORE_FN(cfun_ffi_get_callback_trampoline,
               "(ffi/trampoline cc)",
               "Get a native function pointer that can be used as a callback and passed to C libraries. "
@@ -1879,9 +2159,12 @@ void janet_lib_ffi(JanetTable *env) {
         JANET_CORE_REG("ffi/close", janet_core_native_close),
         JANET_CORE_REG("ffi/signature", cfun_ffi_signature),
         JANET_CORE_REG("ffi/call", cfun_ffi_call),
+        JANET_CORE_REG("ffi/bind", cfun_ffi_bind),
         JANET_CORE_REG("ffi/struct", cfun_ffi_struct),
         JANET_CORE_REG("ffi/write", cfun_ffi_buffer_write),
         JANET_CORE_REG("ffi/read", cfun_ffi_buffer_read),
+        JANET_CORE_REG("ffi/write-array", cfun_ffi_buffer_write_array),
+        JANET_CORE_REG("ffi/read-array", cfun_ffi_buffer_read_array),
         JANET_CORE_REG("ffi/size", cfun_ffi_size),
         JANET_CORE_REG("ffi/align", cfun_ffi_align),
         JANET_CORE_REG("ffi/trampoline", cfun_ffi_get_callback_trampoline),
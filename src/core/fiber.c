@@ -29,6 +29,10 @@
 #include "util.h"
 #endif
 
+#ifdef JANET_FIBER_MREMAP
+#include <sys/mman.h>
+#endif
+
 static void fiber_reset(JanetFiber *fiber) {
     fiber->maxstack = JANET_STACK_MAX;
     fiber->frame = 0;
@@ -48,19 +52,150 @@ static void fiber_reset(JanetFiber *fiber) {
     janet_fiber_set_status(fiber, JANET_STATUS_NEW);
 }
 
+/* Whether or not a stack of the given capacity lives in its own mapping.
+ * This depends only on the capacity so that no extra state is needed to
+ * pick the matching free. */
+#ifdef JANET_FIBER_MREMAP
+#define fiber_data_mapped(capacity) ((capacity) >= JANET_FIBER_MREMAP_MIN)
+#else
+#define fiber_data_mapped(capacity) 0
+#endif
+
+/* Take a pooled stack with room for at least capacity slots. */
+static Janet *fiber_pool_take(int32_t *capacity) {
+    if (janet_vm.fiber_pool_count == 0) return NULL;
+    JanetFiberStack *top = janet_vm.fiber_pool + janet_vm.fiber_pool_count - 1;
+    if (top->capacity < *capacity) return NULL;
+    janet_vm.fiber_pool_count--;
+    *capacity = top->capacity;
+    return top->data;
+}
+
+/* Return a stack to the pool. Returns 0 if the pool is full. */
+static int fiber_pool_put(Janet *data, int32_t capacity) {
+    if (capacity > JANET_FIBER_POOL_STACK_MAX) return 0;
+    if (janet_vm.fiber_pool_count >= janet_vm.fiber_pool_limit) return 0;
+    if (NULL == janet_vm.fiber_pool) {
+        janet_vm.fiber_pool = janet_malloc(sizeof(JanetFiberStack) * (size_t) janet_vm.fiber_pool_limit);
+        if (NULL == janet_vm.fiber_pool) return 0;
+    }
+    JanetFiberStack *top = janet_vm.fiber_pool + janet_vm.fiber_pool_count++;
+    top->data = data;
+    top->capacity = capacity;
+    return 1;
+}
+
+/* Allocate the stack memory for a fiber. The capacity may be raised if a
+ * larger cached stack is reused. Returns NULL on failure. */
+Janet *janet_fiber_data_alloc(int32_t *capacity) {
+#ifdef JANET_FIBER_MREMAP
+    if (fiber_data_mapped(*capacity)) {
+        Janet *cached = janet_vm.fiber_stack_cache;
+        if (NULL != cached && janet_vm.fiber_stack_cache_capacity >= *capacity) {
+            *capacity = janet_vm.fiber_stack_cache_capacity;
+            janet_vm.fiber_stack_cache = NULL;
+            janet_vm.fiber_stack_cache_capacity = 0;
+            return cached;
+        }
+        size_t size = sizeof(Janet) * (size_t) *capacity;
+        void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(mem, size, MADV_HUGEPAGE);
+#endif
+        return (Janet *) mem;
+    }
+#endif
+    return janet_malloc(sizeof(Janet) * (size_t) *capacity);
+}
+
+/* Free memory from janet_fiber_data_alloc. The largest mapped stack is kept
+ * for the next deep fiber so its pages don't need to be faulted in again. */
+void janet_fiber_data_free(Janet *data, int32_t capacity) {
+#ifdef JANET_FIBER_MREMAP
+    if (fiber_data_mapped(capacity)) {
+        if (NULL == data) return;
+        if (capacity > janet_vm.fiber_stack_cache_capacity) {
+            Janet *old = janet_vm.fiber_stack_cache;
+            int32_t old_capacity = janet_vm.fiber_stack_cache_capacity;
+#ifdef MADV_FREE
+            /* Let the kernel reclaim the pages under memory pressure */
+            madvise(data, sizeof(Janet) * (size_t) capacity, MADV_FREE);
+#endif
+            janet_vm.fiber_stack_cache = data;
+            janet_vm.fiber_stack_cache_capacity = capacity;
+            data = old;
+            capacity = old_capacity;
+        }
+        if (NULL != data) munmap(data, sizeof(Janet) * (size_t) capacity);
+        return;
+    }
+#endif
+    if (NULL == data || fiber_pool_put(data, capacity)) return;
+    janet_free(data);
+}
+
+/* Release the cached fiber stack and all pooled stacks. */
+void janet_fiber_data_flush(void) {
+    for (int32_t i = 0; i < janet_vm.fiber_pool_count; i++) {
+        janet_free(janet_vm.fiber_pool[i].data);
+    }
+    janet_free(janet_vm.fiber_pool);
+    janet_vm.fiber_pool = NULL;
+    janet_vm.fiber_pool_count = 0;
+#ifdef JANET_FIBER_MREMAP
+    if (NULL != janet_vm.fiber_stack_cache) {
+        munmap(janet_vm.fiber_stack_cache,
+               sizeof(Janet) * (size_t) janet_vm.fiber_stack_cache_capacity);
+    }
+#endif
+    janet_vm.fiber_stack_cache = NULL;
+    janet_vm.fiber_stack_cache_capacity = 0;
+}
+
+/* Resize fiber stack memory to at least *n slots, keeping the live slots.
+ * Once a stack is large enough to be mapped, growing it never copies - the
+ * kernel moves the pages. Returns NULL on failure, leaving data unchanged. */
+static Janet *fiber_data_resize(Janet *data, int32_t old, int32_t *n) {
+    if (!fiber_data_mapped(old) && !fiber_data_mapped(*n)) {
+        return janet_realloc(data, sizeof(Janet) * (size_t) *n);
+    }
+#ifdef JANET_FIBER_MREMAP
+    if (fiber_data_mapped(old) && fiber_data_mapped(*n)) {
+        void *mem = mremap(data, sizeof(Janet) * (size_t) old,
+                           sizeof(Janet) * (size_t) *n, MREMAP_MAYMOVE);
+        return mem == MAP_FAILED ? NULL : (Janet *) mem;
+    }
+#endif
+    /* Crossing the threshold - copy once */
+    int32_t keep = old < *n ? old : *n;
+    Janet *newData = janet_fiber_data_alloc(n);
+    if (NULL == newData) return NULL;
+    safe_memcpy(newData, data, sizeof(Janet) * (size_t) keep);
+    janet_fiber_data_free(data, old);
+    return newData;
+}
+
 static JanetFiber *fiber_alloc(int32_t capacity) {
     Janet *data;
     JanetFiber *fiber = janet_gcalloc(JANET_MEMORY_FIBER, sizeof(JanetFiber));
     if (capacity < 32) {
         capacity = 32;
     }
-    fiber->capacity = capacity;
-    data = janet_malloc(sizeof(Janet) * (size_t) capacity);
+    /* A pooled stack is not new memory, so it doesn't count towards the
+     * next collection */
+    data = fiber_pool_take(&capacity);
     if (NULL == data) {
-        JANET_OUT_OF_MEMORY;
+        data = janet_fiber_data_alloc(&capacity);
+        if (NULL == data) {
+            JANET_OUT_OF_MEMORY;
+        }
+        janet_vm.next_collection += sizeof(Janet) * capacity;
     }
-    janet_vm.next_collection += sizeof(Janet) * capacity;
+    fiber->capacity = capacity;
     fiber->data = data;
+    /* New fibers are charged to the memory group of the fiber creating them */
+    fiber->memory_group = janet_vm.fiber ? janet_vm.fiber->memory_group : NULL;
     return fiber;
 }
 
@@ -68,6 +203,7 @@ static JanetFiber *fiber_alloc(int32_t capacity) {
 JanetFiber *janet_fiber_reset(JanetFiber *fiber, JanetFunction *callee, int32_t argc, const Janet *argv) {
     int32_t newstacktop;
     fiber_reset(fiber);
+    janet_gc_barrier(fiber);
     if (argc) {
         newstacktop = fiber->stacktop + argc;
         if (newstacktop >= fiber->capacity) {
@@ -102,13 +238,14 @@ JanetFiber *janet_fiber(JanetFunction *callee, int32_t capacity, int32_t argc, c
 static void janet_fiber_refresh_memory(JanetFiber *fiber) {
     int32_t n = fiber->capacity;
     if (n) {
-        Janet *newData = janet_malloc(sizeof(Janet) * n);
+        Janet *newData = janet_fiber_data_alloc(&n);
         if (NULL == newData) {
             JANET_OUT_OF_MEMORY;
         }
         memcpy(newData, fiber->data, fiber->capacity * sizeof(Janet));
-        janet_free(fiber->data);
+        janet_fiber_data_free(fiber->data, fiber->capacity);
         fiber->data = newData;
+        fiber->capacity = n;
     }
 }
 #endif
@@ -116,14 +253,13 @@ static void janet_fiber_refresh_memory(JanetFiber *fiber) {
 /* Ensure that the fiber has enough extra capacity */
 void janet_fiber_setcapacity(JanetFiber *fiber, int32_t n) {
     int32_t old_size = fiber->capacity;
-    int32_t diff = n - old_size;
-    Janet *newData = janet_realloc(fiber->data, sizeof(Janet) * n);
+    Janet *newData = fiber_data_resize(fiber->data, old_size, &n);
     if (NULL == newData) {
         JANET_OUT_OF_MEMORY;
     }
     fiber->data = newData;
     fiber->capacity = n;
-    janet_vm.next_collection += sizeof(Janet) * diff;
+    janet_vm.next_collection += sizeof(Janet) * (n - old_size);
 }
 
 /* Grow fiber if needed */
@@ -244,6 +380,8 @@ int janet_fiber_funcframe(JanetFiber *fiber, JanetFunction *func) {
         }
     }
 
+    if (janet_vm.profiling) janet_profile_call(fiber, func->def);
+
     /* Good return */
     return 0;
 }
@@ -277,6 +415,7 @@ static void janet_env_detach(JanetFuncEnv *env) {
         }
         env->offset = 0;
         env->as.values = vmem;
+        janet_gc_barrier(env);
     }
 }
 
@@ -307,20 +446,24 @@ int janet_env_valid(JanetFuncEnv *env) {
     }
 }
 
+/* Check if a fiber can no longer be resumed, so its stack will not change */
+int janet_fiber_finished(JanetFiber *fiber) {
+    JanetFiberStatus s = janet_fiber_status(fiber);
+    return s == JANET_STATUS_DEAD ||
+           s == JANET_STATUS_ERROR ||
+           s == JANET_STATUS_USER0 ||
+           s == JANET_STATUS_USER1 ||
+           s == JANET_STATUS_USER2 ||
+           s == JANET_STATUS_USER3 ||
+           s == JANET_STATUS_USER4;
+}
+
 /* Detach a fiber from the env if the target fiber has stopped mutating */
 void janet_env_maybe_detach(JanetFuncEnv *env) {
     /* Check for detachable closure envs */
     janet_env_valid(env);
     if (env->offset > 0) {
-        JanetFiberStatus s = janet_fiber_status(env->as.fiber);
-        int isFinished = s == JANET_STATUS_DEAD ||
-                         s == JANET_STATUS_ERROR ||
-                         s == JANET_STATUS_USER0 ||
-                         s == JANET_STATUS_USER1 ||
-                         s == JANET_STATUS_USER2 ||
-                         s == JANET_STATUS_USER3 ||
-                         s == JANET_STATUS_USER4;
-        if (isFinished) {
+        if (janet_fiber_finished(env->as.fiber)) {
             janet_env_detach(env);
         }
     }
@@ -392,6 +535,8 @@ int janet_fiber_funcframe_tail(JanetFiber *fiber, JanetFunction *func) {
     janet_fiber_frame(fiber)->pc = func->def->bytecode;
     janet_fiber_frame(fiber)->flags |= JANET_STACKFRAME_TAILCALL;
 
+    if (janet_vm.profiling) janet_profile_call(fiber, func->def);
+
     /* Good return */
     return 0;
 }
@@ -451,8 +596,106 @@ JanetFiber *janet_root_fiber(void) {
     return janet_vm.root_fiber;
 }
 
+/* Memory groups */
+
+static int memory_group_get(void *p, Janet key, Janet *out) {
+    JanetMemoryGroup *group = (JanetMemoryGroup *) p;
+    if (!janet_checktype(key, JANET_KEYWORD)) return 0;
+    const uint8_t *k = janet_unwrap_keyword(key);
+    if (!janet_cstrcmp(k, "allocated")) {
+        *out = janet_wrap_number((double) group->allocated);
+    } else if (!janet_cstrcmp(k, "live")) {
+        *out = janet_wrap_number((double) group->live);
+    } else if (!janet_cstrcmp(k, "limit")) {
+        *out = group->limit ? janet_wrap_number((double) group->limit) : janet_wrap_nil();
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static uint64_t memory_group_bytes(Janet x) {
+    if (!janet_checktype(x, JANET_NUMBER) || janet_unwrap_number(x) < 0) {
+        janet_panicf("expected non-negative number of bytes, got %v", x);
+    }
+    return (uint64_t) janet_unwrap_number(x);
+}
+
+static void memory_group_put(void *p, Janet key, Janet value) {
+    JanetMemoryGroup *group = (JanetMemoryGroup *) p;
+    if (janet_keyeq(key, "limit")) {
+        group->limit = janet_checktype(value, JANET_NIL) ? 0 : memory_group_bytes(value);
+    } else if (janet_keyeq(key, "allocated")) {
+        group->allocated = memory_group_bytes(value);
+    } else {
+        janet_panicf("cannot set %v of a memory group", key);
+    }
+}
+
+static void memory_group_tostring(void *p, JanetBuffer *buffer) {
+    JanetMemoryGroup *group = (JanetMemoryGroup *) p;
+    janet_formatb(buffer, "allocated=%d live=%d", (int64_t) group->allocated, (int64_t) group->live);
+    if (group->limit) janet_formatb(buffer, " limit=%d", (int64_t) group->limit);
+}
+
+const JanetAbstractType janet_memory_group_type = {
+    "core/memory-group",
+    NULL,
+    NULL,
+    memory_group_get,
+    memory_group_put,
+    NULL, /* marshal */
+    NULL, /* unmarshal */
+    memory_group_tostring,
+    JANET_ATEND_TOSTRING
+};
+
 /* CFuns */
 
+JANET_CORE_FN(cfun_fiber_memory_group,
+              "(fiber/memory-group &opt limit)",
+              "Create a memory group to account for the memory allocated by a fiber, or a group of "
+              "fibers such as the tasks serving one request. Use `fiber/set-memory-group` to put a "
+              "fiber in the group. Fibers created by a fiber in a group join the same group. "
+              "Get `:allocated` from the group for the total bytes allocated by its fibers, and "
+              "`:live` for an estimate of how many of those bytes were still in use at the last "
+              "collection. The estimate is made from the allocations sampled every "
+              "`debug/heap-profile` interval, 512 KiB by default, so it is coarse for small groups. "
+              "If `limit` is given (or `:limit` is put into the group later), a fiber of the group "
+              "raises an error shortly after the group has allocated more than `limit` bytes. The "
+              "error is raised the next time the fiber calls a function or jumps backwards, so it "
+              "may allocate a little more first. `:allocated` can be put to reset the count.") {
+    janet_arity(argc, 0, 1);
+    JanetMemoryGroup *group = janet_abstract(&janet_memory_group_type, sizeof(JanetMemoryGroup));
+    group->allocated = 0;
+    group->live = 0;
+    group->limit = (argc > 0 && !janet_checktype(argv[0], JANET_NIL)) ? memory_group_bytes(argv[0]) : 0;
+    return janet_wrap_abstract(group);
+}
+
+JANET_CORE_FN(cfun_fiber_set_memory_group,
+              "(fiber/set-memory-group fiber group)",
+              "Charge the memory allocated by a fiber from now on to a memory group created with "
+              "`fiber/memory-group`. Set to nil to stop accounting for the fiber. Returns the fiber.") {
+    janet_fixarity(argc, 2);
+    JanetFiber *fiber = janet_getfiber(argv, 0);
+    if (janet_checktype(argv[1], JANET_NIL)) {
+        fiber->memory_group = NULL;
+    } else {
+        fiber->memory_group = janet_getabstract(argv, 1, &janet_memory_group_type);
+        janet_gc_barrier(fiber);
+    }
+    return argv[0];
+}
+
+JANET_CORE_FN(cfun_fiber_get_memory_group,
+              "(fiber/get-memory-group fiber)",
+              "Get the memory group of a fiber, or nil if it has none.") {
+    janet_fixarity(argc, 1);
+    JanetFiber *fiber = janet_getfiber(argv, 0);
+    return fiber->memory_group ? janet_wrap_abstract(fiber->memory_group) : janet_wrap_nil();
+}
+
 JANET_CORE_FN(cfun_fiber_getenv,
               "(fiber/getenv fiber)",
               "Gets the environment for a fiber. Returns nil if no such table is "
@@ -474,6 +717,7 @@ JANET_CORE_FN(cfun_fiber_setenv,
         fiber->env = NULL;
     } else {
         fiber->env = janet_gettable(argv, 1);
+        janet_gc_barrier(fiber);
     }
     return argv[0];
 }
@@ -641,6 +885,36 @@ JANET_CORE_FN(cfun_fiber_setmaxstack,
     return argv[0];
 }
 
+JANET_CORE_FN(cfun_fiber_pool_limit,
+              "(fiber/pool-limit &opt limit)",
+              "Gets the number of stacks from collected fibers that are kept for reuse "
+              "by new fibers, and sets it if `limit` is given. Returns the old limit. "
+              "Pooling makes creating many short lived fibers, such as with `ev/go` or "
+              "`net/server`, cheaper. Only stacks of up to 1024 values are pooled. "
+              "Set to 0 to disable pooling.") {
+    janet_arity(argc, 0, 1);
+    int32_t old = janet_vm.fiber_pool_limit;
+    if (argc > 0) {
+        int32_t limit = janet_getnat(argv, 0);
+        while (janet_vm.fiber_pool_count > limit) {
+            janet_free(janet_vm.fiber_pool[--janet_vm.fiber_pool_count].data);
+        }
+        if (janet_vm.fiber_pool_count > 0) {
+            JanetFiberStack *pool = janet_realloc(janet_vm.fiber_pool, sizeof(JanetFiberStack) * (size_t) limit);
+            if (NULL == pool) {
+                JANET_OUT_OF_MEMORY;
+            }
+            janet_vm.fiber_pool = pool;
+        } else {
+            /* Allocated again at the new size on next use */
+            janet_free(janet_vm.fiber_pool);
+            janet_vm.fiber_pool = NULL;
+        }
+        janet_vm.fiber_pool_limit = limit;
+    }
+    return janet_wrap_integer(old);
+}
+
 int janet_fiber_can_resume(JanetFiber *fiber) {
     JanetFiberStatus s = janet_fiber_status(fiber);
     int isFinished = s == JANET_STATUS_DEAD ||
@@ -682,6 +956,10 @@ void janet_lib_fiber(JanetTable *env) {
         JANET_CORE_REG("fiber/setenv", cfun_fiber_setenv),
         JANET_CORE_REG("fiber/can-resume?", cfun_fiber_can_resume),
         JANET_CORE_REG("fiber/last-value", cfun_fiber_last_value),
+        JANET_CORE_REG("fiber/pool-limit", cfun_fiber_pool_limit),
+        JANET_CORE_REG("fiber/memory-group", cfun_fiber_memory_group),
+        JANET_CORE_REG("fiber/set-memory-group", cfun_fiber_set_memory_group),
+        JANET_CORE_REG("fiber/get-memory-group", cfun_fiber_get_memory_group),
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, fiber_cfuns);
@@ -70,6 +70,28 @@
 
 #define janet_stack_frame(s) ((JanetStackFrame *)((s) - JANET_FRAME_SIZE))
 #define janet_fiber_frame(f) janet_stack_frame((f)->data + (f)->frame)
+
+/* Fiber stacks of at least this many slots are mapped directly from the
+ * OS on Linux, so growing a deep stack remaps pages instead of copying. */
+#if defined(JANET_LINUX) && defined(JANET_MMAP)
+#define JANET_FIBER_MREMAP
+#endif
+#ifndef JANET_FIBER_MREMAP_MIN
+#define JANET_FIBER_MREMAP_MIN 0x10000
+#endif
+
+/* Stacks of collected fibers, up to this many slots each, are pooled and
+ * handed to new fibers so short lived tasks don't hit the allocator. */
+#ifndef JANET_FIBER_POOL_MAX
+#define JANET_FIBER_POOL_MAX 1024
+#endif
+#ifndef JANET_FIBER_POOL_STACK_MAX
+#define JANET_FIBER_POOL_STACK_MAX 0x400
+#endif
+
+Janet *janet_fiber_data_alloc(int32_t *capacity);
+void janet_fiber_data_free(Janet *data, int32_t capacity);
+void janet_fiber_data_flush(void);
 void janet_fiber_setcapacity(JanetFiber *fiber, int32_t n);
 void janet_fiber_push(JanetFiber *fiber, Janet x);
 void janet_fiber_push2(JanetFiber *fiber, Janet x, Janet y);
@@ -79,6 +101,7 @@ int janet_fiber_funcframe(JanetFiber *fiber, JanetFunction *func);
 int janet_fiber_funcframe_tail(JanetFiber *fiber, JanetFunction *func);
 void janet_fiber_cframe(JanetFiber *fiber, JanetCFunction cfun);
 void janet_fiber_popframe(JanetFiber *fiber);
+int janet_fiber_finished(JanetFiber *fiber);
 void janet_env_maybe_detach(JanetFuncEnv *env);
 int janet_env_valid(JanetFuncEnv *env);
 
@@ -31,6 +31,8 @@
 
 #ifdef JANET_LINUX
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
 #include <unistd.h>
 #endif
 
@@ -51,12 +53,150 @@ typedef struct {
     JanetChannel *channel;
     uint32_t default_flags;
     int is_watching;
+#ifdef JANET_LINUX
+    JanetTable *recursive; /* watch descriptor -> flags of recursive watches */
+#endif
+    /* Batched delivery, see filewatch/batch. A negative window means events
+     * are given to the channel one at a time. */
+    double batch_window;
+    double batch_max_wait;
+    double batch_start;
+    double batch_last;
+    JanetArray *batch; /* latest event for each path, in order of first event */
+    JanetArray *batch_types; /* distinct event types for each path */
+    JanetTable *batch_index; /* path -> index in batch */
+    JanetFunction *batch_thunk;
+    JanetFiber *batch_fiber; /* delivers the pending batch once it is due */
 } JanetWatcher;
 
+/* Batched delivery */
+
+/* Give the pending batch to the channel as a single array of events. Each
+ * event gets a :types tuple listing every type seen for its path. */
+static void janet_watcher_flush(JanetWatcher *watcher) {
+    int32_t count = watcher->batch->count;
+    if (count == 0) return;
+    JanetArray *out = janet_array(count);
+    Janet typesk = janet_ckeywordv("types");
+    for (int32_t i = 0; i < count; i++) {
+        const JanetKV *kvs = janet_unwrap_struct(watcher->batch->data[i]);
+        JanetArray *types = janet_unwrap_array(watcher->batch_types->data[i]);
+        JanetKV *event = janet_struct_begin(janet_struct_length(kvs) + 1);
+        for (int32_t j = 0; j < janet_struct_capacity(kvs); j++) {
+            if (janet_checktype(kvs[j].key, JANET_NIL)) continue;
+            janet_struct_put(event, kvs[j].key, kvs[j].value);
+        }
+        janet_struct_put(event, typesk, janet_wrap_tuple(janet_tuple_n(types->data, types->count)));
+        janet_array_push(out, janet_wrap_struct(janet_struct_end(event)));
+    }
+    watcher->batch->count = 0;
+    watcher->batch_types->count = 0;
+    janet_table_clear(watcher->batch_index);
+    janet_channel_give(watcher->channel, janet_wrap_array(out));
+}
+
+/* Only the platforms with a watcher backend produce events to batch */
+#if defined(JANET_LINUX) || defined(JANET_WINDOWS)
+
+static double watcher_now(void) {
+    struct timespec ts;
+    janet_gettime(&ts, JANET_TIME_MONOTONIC);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Run by the batch fiber. Returns true once the batch has been delivered,
+ * otherwise sleeps until the batch is due. */
+static Janet watcher_batch_step(int32_t argc, Janet *argv) {
+    janet_fixarity(argc, 1);
+    JanetWatcher *watcher = janet_unwrap_abstract(argv[0]);
+    if (watcher->batch_window >= 0 && watcher->is_watching && watcher->batch->count) {
+        double due = watcher->batch_last + watcher->batch_window;
+        double deadline = watcher->batch_start + watcher->batch_max_wait;
+        if (deadline < due) due = deadline;
+        double now = watcher_now();
+        if (now < due) janet_sleep_await(due - now);
+    }
+    janet_watcher_flush(watcher);
+    watcher->batch_fiber = NULL;
+    return janet_wrap_true();
+}
+
+static JanetFunction *watcher_batch_thunk(JanetWatcher *watcher) {
+    /* (while (not (step watcher))) - the step function suspends the fiber
+     * with ev/sleep semantics, so resuming it simply calls step again. */
+    static const uint32_t bytecode[] = {
+        JOP_LOAD_CONSTANT | (1 << 8) | (0 << 16),
+        JOP_LOAD_CONSTANT | (2 << 8) | (1 << 16),
+        JOP_PUSH | (2 << 8),
+        JOP_CALL | (0 << 8) | (1 << 16),
+        JOP_JUMP_IF | (0 << 8) | (2 << 16),
+        JOP_JUMP | ((uint32_t) -3 << 8),
+        JOP_RETURN_NIL
+    };
+    JanetFuncDef *def = janet_funcdef_alloc();
+    def->arity = 0;
+    def->min_arity = 0;
+    def->max_arity = INT32_MAX;
+    def->flags = JANET_FUNCDEF_FLAG_VARARG;
+    def->slotcount = 3;
+    def->bytecode = janet_malloc(sizeof(bytecode));
+    def->bytecode_length = (int32_t)(sizeof(bytecode) / sizeof(uint32_t));
+    def->constants = janet_malloc(2 * sizeof(Janet));
+    def->constants_length = 2;
+    def->name = NULL;
+    if (!def->bytecode || !def->constants) {
+        JANET_OUT_OF_MEMORY;
+    }
+    def->constants[0] = janet_wrap_cfunction(watcher_batch_step);
+    def->constants[1] = janet_wrap_abstract(watcher);
+    memcpy(def->bytecode, bytecode, sizeof(bytecode));
+    janet_def_addflags(def);
+    return janet_thunk(def);
+}
+
+/* Deliver an event, either directly or by merging it into the pending batch */
+static void janet_watcher_emit(JanetWatcher *watcher, Janet event) {
+    if (watcher->batch_window < 0) {
+        janet_channel_give(watcher->channel, event);
+        return;
+    }
+    Janet dir = janet_get(event, janet_ckeywordv("dir-name"));
+    Janet file = janet_get(event, janet_ckeywordv("file-name"));
+    Janet type = janet_get(event, janet_ckeywordv("type"));
+    Janet key = event;
+    if (janet_checktype(dir, JANET_STRING) && janet_checktype(file, JANET_STRING)) {
+        key = janet_wrap_string(janet_formatc("%S/%S", janet_unwrap_string(dir), janet_unwrap_string(file)));
+    }
+    double now = watcher_now();
+    Janet index = janet_table_get(watcher->batch_index, key);
+    if (janet_checktype(index, JANET_NIL)) {
+        if (watcher->batch->count == 0) watcher->batch_start = now;
+        janet_table_put(watcher->batch_index, key, janet_wrap_integer(watcher->batch->count));
+        janet_array_push(watcher->batch, event);
+        JanetArray *types = janet_array(1);
+        janet_array_push(types, type);
+        janet_array_push(watcher->batch_types, janet_wrap_array(types));
+    } else {
+        int32_t i = janet_unwrap_integer(index);
+        watcher->batch->data[i] = event;
+        JanetArray *types = janet_unwrap_array(watcher->batch_types->data[i]);
+        int32_t j = 0;
+        while (j < types->count && !janet_equals(types->data[j], type)) j++;
+        if (j == types->count) janet_array_push(types, type);
+    }
+    watcher->batch_last = now;
+    if (NULL == watcher->batch_fiber) {
+        if (NULL == watcher->batch_thunk) watcher->batch_thunk = watcher_batch_thunk(watcher);
+        watcher->batch_fiber = janet_fiber(watcher->batch_thunk, 64, 0, NULL);
+        janet_schedule(watcher->batch_fiber, janet_wrap_nil());
+    }
+}
+
+#endif
+
 #ifdef JANET_LINUX
 
-#include <sys/inotify.h>
-#include <unistd.h>
+#define WATCHFLAG_RECURSIVE 0x100000u
 
 static const JanetWatchFlagName watcher_flags_linux[] = {
     {"access", IN_ACCESS},
@@ -74,6 +214,7 @@ static const JanetWatchFlagName watcher_flags_linux[] = {
     {"moved-to", IN_MOVED_TO},
     {"open", IN_OPEN},
     {"q-overflow", IN_Q_OVERFLOW},
+    {"recursive", WATCHFLAG_RECURSIVE},
     {"unmount", IN_UNMOUNT},
 };
 
@@ -105,38 +246,111 @@ static void janet_watcher_init(JanetWatcher *watcher, JanetChannel *channel, uin
         janet_panicv(janet_ev_lasterr());
     }
     watcher->watch_descriptors = janet_table(0);
+    watcher->recursive = janet_table(0);
     watcher->channel = channel;
     watcher->default_flags = default_flags;
     watcher->is_watching = 0;
     watcher->stream = janet_stream(fd, JANET_STREAM_READABLE, NULL);
 }
 
-static void janet_watcher_add(JanetWatcher *watcher, const char *path, uint32_t flags) {
-    if (watcher->stream == NULL) janet_panic("watcher closed");
+/* Returns the watch descriptor, or -1 with errno set. */
+static int watcher_add_one(JanetWatcher *watcher, Janet name, uint32_t flags) {
+    uint32_t mask = flags & ~WATCHFLAG_RECURSIVE;
+    /* Recursive watches need to hear about new subdirectories */
+    if (flags & WATCHFLAG_RECURSIVE) mask |= IN_CREATE | IN_MOVED_TO;
     int result;
     do {
-        result = inotify_add_watch(watcher->stream->handle, path, flags);
+        result = inotify_add_watch(watcher->stream->handle, (const char *) janet_unwrap_string(name), mask);
     } while (result == -1 && errno == EINTR);
-    if (result == -1) {
-        janet_panicv(janet_ev_lasterr());
-    }
-    Janet name = janet_cstringv(path);
+    if (result == -1) return -1;
     Janet wd = janet_wrap_integer(result);
     janet_table_put(watcher->watch_descriptors, name, wd);
     janet_table_put(watcher->watch_descriptors, wd, name);
+    if (flags & WATCHFLAG_RECURSIVE) {
+        janet_table_put(watcher->recursive, wd, janet_wrap_number(flags));
+    }
+    return result;
+}
+
+static Janet watcher_join(JanetString dir, const char *name) {
+    int32_t len = janet_string_length(dir);
+    const char *sep = (len && dir[len - 1] == '/') ? "" : "/";
+    return janet_wrap_string(janet_formatc("%S%s%s", dir, sep, name));
+}
+
+/* Watch every directory below path. Directories that vanish or cannot be
+ * read while walking are skipped. Running out of watches is an error when
+ * strict is set. */
+static void watcher_add_subdirs(JanetWatcher *watcher, Janet path, uint32_t flags, int strict) {
+    JanetString spath = janet_unwrap_string(path);
+    JanetArray *subdirs = janet_array(0);
+    DIR *dir = opendir((const char *) spath);
+    if (NULL == dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) continue;
+        Janet child = watcher_join(spath, entry->d_name);
+        int isdir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isdir = !lstat((const char *) janet_unwrap_string(child), &st) && S_ISDIR(st.st_mode);
+        }
+        if (isdir) janet_array_push(subdirs, child);
+    }
+    closedir(dir);
+    for (int32_t i = 0; i < subdirs->count; i++) {
+        if (watcher_add_one(watcher, subdirs->data[i], flags) == -1) {
+            if (strict && (errno == ENOSPC || errno == ENOMEM)) janet_panicv(janet_ev_lasterr());
+            continue;
+        }
+        watcher_add_subdirs(watcher, subdirs->data[i], flags, strict);
+    }
+}
+
+static void janet_watcher_add(JanetWatcher *watcher, const char *path, uint32_t flags) {
+    if (watcher->stream == NULL) janet_panic("watcher closed");
+    Janet name = janet_cstringv(path);
+    if (watcher_add_one(watcher, name, flags) == -1) {
+        janet_panicv(janet_ev_lasterr());
+    }
+    if (flags & WATCHFLAG_RECURSIVE) {
+        watcher_add_subdirs(watcher, name, flags, 1);
+    }
 }
 
 static void janet_watcher_remove(JanetWatcher *watcher, const char *path) {
     if (watcher->stream == NULL) janet_panic("watcher closed");
-    Janet check = janet_table_get(watcher->watch_descriptors, janet_cstringv(path));
-    janet_assert(janet_checktype(check, JANET_NUMBER), "bad watch descriptor");
+    Janet pathv = janet_cstringv(path);
+    Janet check = janet_table_get(watcher->watch_descriptors, pathv);
+    if (!janet_checktype(check, JANET_NUMBER)) {
+        janet_panicf("path %v is not being watched", pathv);
+    }
     int watch_handle = janet_unwrap_integer(check);
-    int result;
-    do {
-        result = inotify_rm_watch(watcher->stream->handle, watch_handle);
-    } while (result != -1 && errno == EINTR);
-    if (result == -1) {
-        janet_panicv(janet_ev_lasterr());
+    /* Also remove the subdirectories added by a recursive watch */
+    JanetArray *handles = janet_array(1);
+    janet_array_push(handles, check);
+    if (!janet_checktype(janet_table_get(watcher->recursive, check), JANET_NIL)) {
+        size_t plen = strlen(path);
+        for (int32_t i = 0; i < watcher->recursive->capacity; i++) {
+            const JanetKV *kv = watcher->recursive->data + i;
+            if (!janet_checktype(kv->key, JANET_NUMBER) || watch_handle == janet_unwrap_integer(kv->key)) continue;
+            Janet subpath = janet_table_get(watcher->watch_descriptors, kv->key);
+            if (!janet_checktype(subpath, JANET_STRING)) continue;
+            JanetString sp = janet_unwrap_string(subpath);
+            if ((size_t) janet_string_length(sp) > plen && !memcmp(sp, path, plen) &&
+                    (sp[plen] == '/' || (plen && path[plen - 1] == '/'))) {
+                janet_array_push(handles, kv->key);
+            }
+        }
+    }
+    for (int32_t i = 0; i < handles->count; i++) {
+        int result;
+        do {
+            result = inotify_rm_watch(watcher->stream->handle, janet_unwrap_integer(handles->data[i]));
+        } while (result == -1 && errno == EINTR);
+        if (result == -1 && i == 0) {
+            janet_panicv(janet_ev_lasterr());
+        }
     }
 }
 
@@ -163,8 +377,6 @@ static void watcher_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
         case JANET_ASYNC_EVENT_HUP:
         case JANET_ASYNC_EVENT_INIT:
         case JANET_ASYNC_EVENT_READ: {
-            Janet name = janet_wrap_nil();
-
             /* Assumption - read will never return partial events *
              * From documentation:
              *
@@ -201,17 +413,49 @@ static void watcher_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
                 memcpy(&inevent, cursor, sizeof(inevent));
                 cursor += sizeof(inevent);
                 /* Read path of inevent */
+                Janet name = janet_wrap_nil();
                 if (inevent.len) {
                     name = janet_cstringv(cursor);
                     cursor += inevent.len;
                 }
 
                 /* Got an event */
-                Janet path = janet_table_get(watcher->watch_descriptors, janet_wrap_integer(inevent.wd));
+                Janet wdv = janet_wrap_integer(inevent.wd);
+                Janet path = janet_table_get(watcher->watch_descriptors, wdv);
+                if (!janet_checktype(path, JANET_STRING)) {
+                    /* Queue overflow, or an event for an already removed watch */
+                    path = janet_wrap_nil();
+                    if (!(inevent.mask & IN_Q_OVERFLOW)) continue;
+                }
+                Janet rflags = janet_table_get(watcher->recursive, wdv);
+                if (!janet_checktype(rflags, JANET_NIL)) {
+                    uint32_t flags = (uint32_t) janet_unwrap_number(rflags);
+                    /* Watch new subdirectories of recursive watches */
+                    if ((inevent.mask & IN_ISDIR) && (inevent.mask & (IN_CREATE | IN_MOVED_TO)) &&
+                            janet_checktype(name, JANET_STRING)) {
+                        Janet subdir = watcher_join(janet_unwrap_string(path), (const char *) janet_unwrap_string(name));
+                        if (watcher_add_one(watcher, subdir, flags) != -1) {
+                            watcher_add_subdirs(watcher, subdir, flags, 0);
+                        }
+                    }
+                    /* The watch is gone, forget about it */
+                    if (inevent.mask & IN_IGNORED) {
+                        janet_table_remove(watcher->recursive, wdv);
+                        janet_table_remove(watcher->watch_descriptors, wdv);
+                        if (janet_equals(janet_table_get(watcher->watch_descriptors, path), wdv)) {
+                            janet_table_remove(watcher->watch_descriptors, path);
+                        }
+                    }
+                    /* Skip events only requested to track subdirectories */
+                    if ((inevent.mask & IN_ALL_EVENTS) && !(inevent.mask & flags & IN_ALL_EVENTS)) continue;
+                }
                 JanetKV *event = janet_struct_begin(6);
                 janet_struct_put(event, janet_ckeywordv("wd"), janet_wrap_integer(inevent.wd));
                 janet_struct_put(event, janet_ckeywordv("wd-path"), path);
-                if (janet_checktype(name, JANET_NIL)) {
+                if (janet_checktype(path, JANET_NIL)) {
+                    janet_struct_put(event, janet_ckeywordv("dir-name"), path);
+                    janet_struct_put(event, janet_ckeywordv("file-name"), name);
+                } else if (janet_checktype(name, JANET_NIL)) {
                     /* We were watching a file directly, so path is the full path. Split into dirname / basename */
                     JanetString spath = janet_unwrap_string(path);
                     const uint8_t *cursor = spath + janet_string_length(spath);
@@ -238,7 +482,7 @@ static void watcher_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
                 }
                 Janet eventv = janet_wrap_struct(janet_struct_end(event));
 
-                janet_channel_give(watcher->channel, eventv);
+                janet_watcher_emit(watcher, eventv);
             }
 
             /* Read some more if possible */
@@ -411,7 +655,7 @@ static void watcher_callback_read(JanetFiber *fiber, JanetAsyncEvent event) {
                 janet_struct_put(event, janet_ckeywordv("dir-name"), janet_wrap_string(ow->dir_path));
                 Janet eventv = janet_wrap_struct(janet_struct_end(event));
 
-                janet_channel_give(watcher->channel, eventv);
+                janet_watcher_emit(watcher, eventv);
 
                 /* Next event */
                 if (!fni->NextEntryOffset) break;
@@ -559,9 +803,17 @@ static int janet_filewatch_mark(void *p, size_t s) {
     }
 #else
     janet_mark(janet_wrap_abstract(watcher->stream));
+#endif
+#ifdef JANET_LINUX
+    janet_mark(janet_wrap_table(watcher->recursive));
 #endif
     janet_mark(janet_wrap_abstract(watcher->channel));
     janet_mark(janet_wrap_table(watcher->watch_descriptors));
+    if (watcher->batch) janet_mark(janet_wrap_array(watcher->batch));
+    if (watcher->batch_types) janet_mark(janet_wrap_array(watcher->batch_types));
+    if (watcher->batch_index) janet_mark(janet_wrap_table(watcher->batch_index));
+    if (watcher->batch_thunk) janet_mark(janet_wrap_function(watcher->batch_thunk));
+    if (watcher->batch_fiber) janet_mark(janet_wrap_fiber(watcher->batch_fiber));
     return 0;
 }
 
@@ -591,6 +843,8 @@ JANET_CORE_FN(cfun_filewatch_make,
     janet_arity(argc, 1, -1);
     JanetChannel *channel = janet_getchannel(argv, 0);
     JanetWatcher *watcher = janet_abstract(&janet_filewatch_at, sizeof(JanetWatcher));
+    memset(watcher, 0, sizeof(JanetWatcher));
+    watcher->batch_window = -1;
     uint32_t default_flags = decode_watch_flags(argv + 1, argc - 1);
     janet_watcher_init(watcher, channel, default_flags);
     return janet_wrap_abstract(watcher);
@@ -625,7 +879,10 @@ JANET_CORE_FN(cfun_filewatch_add,
               "* `:moved-to` - `IN_MOVED_TO`\n\n"
               "* `:open` - `IN_OPEN`\n\n"
               "* `:q-overflow` - `IN_Q_OVERFLOW`\n\n"
-              "* `:unmount` - `IN_UNMOUNT`\n\n\n"
+              "* `:unmount` - `IN_UNMOUNT`\n\n"
+              "* `:recursive` - also watch all subdirectories, including ones created later. "
+              "Subdirectory events have the subdirectory as their `:dir-name` and `:wd-path`. "
+              "Removing the path also removes the watches on its subdirectories.\n\n\n"
               "On Windows, events will have the following possible types:\n\n"
               "* `:unknown`\n\n"
               "* `:added`\n\n"
@@ -671,6 +928,36 @@ JANET_CORE_FN(cfun_filewatch_unlisten,
     return janet_wrap_nil();
 }
 
+JANET_CORE_FN(cfun_filewatch_batch,
+              "(filewatch/batch watcher window &opt max-wait)",
+              "Coalesce the events of a watcher into batches. Instead of giving each event to the channel, "
+              "events are collected until no new event has arrived for `window` seconds, or until `max-wait` "
+              "seconds have passed since the first event of the batch (default 10 times `window`). The batch "
+              "is then given to the channel as a single array. Events for the same path are merged into one: "
+              "the array holds the latest event for each path in the order the paths were first seen, and each "
+              "event has an extra `:types` key with a tuple of the distinct event types seen for the path. "
+              "A nil `window` turns batching off again, delivering any pending batch right away. Returns the watcher.") {
+    janet_arity(argc, 2, 3);
+    JanetWatcher *watcher = janet_getabstract(argv, 0, &janet_filewatch_at);
+    if (janet_checktype(argv[1], JANET_NIL)) {
+        if (watcher->batch) janet_watcher_flush(watcher);
+        watcher->batch_window = -1;
+        return argv[0];
+    }
+    double window = janet_getnumber(argv, 1);
+    if (!(window >= 0)) janet_panicf("expected non-negative window, got %v", argv[1]);
+    double max_wait = janet_optnumber(argv, argc, 2, 10 * window);
+    if (!(max_wait >= 0)) janet_panicf("expected non-negative max-wait, got %v", argv[2]);
+    watcher->batch_window = window;
+    watcher->batch_max_wait = max_wait;
+    if (NULL == watcher->batch) {
+        watcher->batch = janet_array(0);
+        watcher->batch_types = janet_array(0);
+        watcher->batch_index = janet_table(0);
+    }
+    return argv[0];
+}
+
 /* Module entry point */
 void janet_lib_filewatch(JanetTable *env) {
     JanetRegExt cfuns[] = {
@@ -679,6 +966,7 @@ void janet_lib_filewatch(JanetTable *env) {
         JANET_CORE_REG("filewatch/remove", cfun_filewatch_remove),
         JANET_CORE_REG("filewatch/listen", cfun_filewatch_listen),
         JANET_CORE_REG("filewatch/unlisten", cfun_filewatch_unlisten),
+        JANET_CORE_REG("filewatch/batch", cfun_filewatch_batch),
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, cfuns);
@@ -43,10 +43,13 @@ static void janet_mark_buffer(JanetBuffer *buffer);
 static void janet_mark_string(const uint8_t *str);
 static void janet_mark_fiber(JanetFiber *fiber);
 static void janet_mark_abstract(void *adata);
+static JanetGCObject *janet_value_block(Janet x);
+static void janet_gc_push_gray(JanetGCObject *mem);
+static void janet_gc_track(JanetGCObject *mem);
 
 /* Local state that is only temporary for gc */
 static JANET_THREAD_LOCAL uint32_t depth = JANET_RECURSION_GUARD;
-static JANET_THREAD_LOCAL size_t orig_rootcount;
+static JANET_THREAD_LOCAL int minor_cycle;
 
 /* Hint to the GC that we may need to collect */
 void janet_gcpressure(size_t s) {
@@ -92,11 +95,18 @@ void janet_mark(Janet x) {
         }
         depth++;
     } else {
-        janet_gcroot(x);
+        /* Too deep, or tracing one block at a time - trace it later */
+        JanetGCObject *mem = janet_value_block(x);
+        if (NULL != mem && !janet_gc_reachable(mem)) {
+            janet_gc_push_gray(mem);
+        }
     }
 }
 
 static void janet_mark_string(const uint8_t *str) {
+    /* Don't write to marked strings, which may be shared with other threads */
+    if (janet_gc_reachable(janet_string_head(str)))
+        return;
     janet_gc_mark(janet_string_head(str));
 }
 
@@ -117,6 +127,7 @@ static void janet_mark_abstract(void *adata) {
         return;
     janet_gc_mark(janet_abstract_head(adata));
     if (janet_abstract_head(adata)->type->gcmark) {
+        janet_gc_track((JanetGCObject *) janet_abstract_head(adata));
         janet_abstract_head(adata)->type->gcmark(adata, janet_abstract_size(adata));
     }
 }
@@ -268,6 +279,7 @@ recur:
     if (janet_gc_reachable(fiber))
         return;
     janet_gc_mark(fiber);
+    janet_gc_track((JanetGCObject *) fiber);
 
     janet_mark(fiber->last_value);
 
@@ -292,6 +304,9 @@ recur:
     if (fiber->env)
         janet_mark_table(fiber->env);
 
+    if (fiber->memory_group)
+        janet_mark_abstract(fiber->memory_group);
+
 #ifdef JANET_EV
     if (fiber->supervisor_channel) {
         janet_mark_abstract(fiber->supervisor_channel);
@@ -311,8 +326,62 @@ recur:
     }
 }
 
+/* Approximate number of bytes owned by a block, for statistics */
+static size_t janet_block_size(JanetGCObject *mem) {
+    switch (mem->flags & JANET_MEM_TYPEBITS) {
+        default:
+            return sizeof(JanetGCObject);
+        case JANET_MEMORY_STRING:
+        case JANET_MEMORY_SYMBOL:
+            return sizeof(JanetStringHead) + (size_t)((JanetStringHead *) mem)->length + 1;
+        case JANET_MEMORY_ARRAY:
+        case JANET_MEMORY_ARRAY_WEAK:
+            return sizeof(JanetArray) + (size_t)((JanetArray *) mem)->capacity * sizeof(Janet);
+        case JANET_MEMORY_TUPLE:
+            return sizeof(JanetTupleHead) + (size_t)((JanetTupleHead *) mem)->length * sizeof(Janet);
+        case JANET_MEMORY_TABLE:
+        case JANET_MEMORY_TABLE_WEAKK:
+        case JANET_MEMORY_TABLE_WEAKV:
+        case JANET_MEMORY_TABLE_WEAKKV:
+            return sizeof(JanetTable) + (size_t)((JanetTable *) mem)->capacity * sizeof(JanetKV);
+        case JANET_MEMORY_STRUCT:
+            return sizeof(JanetStructHead) + (size_t)((JanetStructHead *) mem)->capacity * sizeof(JanetKV);
+        case JANET_MEMORY_FIBER:
+            return sizeof(JanetFiber) + (size_t)((JanetFiber *) mem)->capacity * sizeof(Janet);
+        case JANET_MEMORY_BUFFER:
+            return sizeof(JanetBuffer) + (size_t)((JanetBuffer *) mem)->capacity;
+        case JANET_MEMORY_FUNCTION:
+            /* The funcdef may already be freed in this sweep, so the
+             * environment pointers are not counted */
+            return sizeof(JanetFunction);
+        case JANET_MEMORY_ABSTRACT:
+            return sizeof(JanetAbstractHead) + ((JanetAbstractHead *) mem)->size;
+        case JANET_MEMORY_FUNCENV: {
+            JanetFuncEnv *env = (JanetFuncEnv *) mem;
+            return sizeof(JanetFuncEnv) + (env->offset ? 0 : (size_t) env->length * sizeof(Janet));
+        }
+        case JANET_MEMORY_FUNCDEF: {
+            JanetFuncDef *def = (JanetFuncDef *) mem;
+            return sizeof(JanetFuncDef) +
+                   (size_t) def->bytecode_length * (sizeof(uint32_t) + (def->sourcemap ? sizeof(JanetSourceMapping) : 0)) +
+                   (size_t) def->constants_length * sizeof(Janet) +
+                   (size_t) def->defs_length * sizeof(JanetFuncDef *) +
+                   (size_t) def->environments_length * sizeof(int32_t) +
+                   (size_t) def->symbolmap_length * sizeof(JanetSymbolMap);
+        }
+    }
+}
+
+/* Record a block that is about to be freed */
+static void janet_gc_count_free(JanetGCObject *mem) {
+    janet_vm.gc_stats.last.bytes_freed += janet_block_size(mem);
+    janet_vm.gc_stats.last.blocks_freed++;
+}
+
 /* Deinitialize a block of memory */
+static void janet_heap_sample_free(JanetGCObject *mem);
 static void janet_deinit_block(JanetGCObject *mem) {
+    if (mem->flags & JANET_MEM_SAMPLED) janet_heap_sample_free(mem);
     switch (mem->flags & JANET_MEM_TYPEBITS) {
         default:
         case JANET_MEMORY_FUNCTION:
@@ -338,7 +407,7 @@ static void janet_deinit_block(JanetGCObject *mem) {
                 janet_free(f->ev_state);
             }
 #endif
-            janet_free(f->data);
+            janet_fiber_data_free(f->data, f->capacity);
         }
         break;
         case JANET_MEMORY_BUFFER:
@@ -366,37 +435,664 @@ static void janet_deinit_block(JanetGCObject *mem) {
             janet_free(def->defs);
             janet_free(def->environments);
             janet_free(def->constants);
-            janet_free(def->bytecode);
+            if (!(def->flags & JANET_FUNCDEF_FLAG_MAPPED)) janet_free(def->bytecode);
             janet_free(def->sourcemap);
             janet_free(def->closure_bitset);
             janet_free(def->symbolmap);
+            janet_free(def->method_cache);
+            if (NULL != def->profile) def->profile->def = NULL;
+#ifdef JANET_JIT
+            janet_jit_free(def);
+#endif
         }
         break;
     }
 }
 
-/* Check that a value x has been visited in the mark phase */
-static int janet_check_liveref(Janet x) {
+/* Blocks that can be mutated without going through a write barrier. In
+ * generational mode, these stay in the remembered set for as long as they
+ * are alive so that minor collections always trace through them. */
+static int janet_gc_sticky(JanetGCObject *mem) {
+    switch (mem->flags & JANET_MEM_TYPEBITS) {
+        default:
+            return 0;
+        case JANET_MEMORY_FIBER:
+            return !janet_fiber_finished((JanetFiber *) mem);
+        case JANET_MEMORY_ABSTRACT:
+            return NULL != ((JanetAbstractHead *) mem)->type->gcmark;
+    }
+}
+
+/* Add a block to the remembered set */
+static void janet_gc_remember_block(JanetGCObject *mem) {
+    if (janet_vm.gc_remembered_count == janet_vm.gc_remembered_capacity) {
+        size_t newcap = 2 * janet_vm.gc_remembered_capacity + 16;
+        JanetGCObject **newmem = janet_realloc(janet_vm.gc_remembered, newcap * sizeof(JanetGCObject *));
+        if (NULL == newmem) {
+            JANET_OUT_OF_MEMORY;
+        }
+        janet_vm.gc_remembered = newmem;
+        janet_vm.gc_remembered_capacity = newcap;
+    }
+    mem->flags |= JANET_MEM_REMEMBERED;
+    janet_vm.gc_remembered[janet_vm.gc_remembered_count++] = mem;
+}
+
+/* Push a block on the gray stack */
+static void janet_gc_push_gray(JanetGCObject *mem) {
+    if (janet_vm.gc_gray_count == janet_vm.gc_gray_capacity) {
+        size_t newcap = 2 * janet_vm.gc_gray_capacity + 64;
+        JanetGCObject **newmem = janet_realloc(janet_vm.gc_gray, newcap * sizeof(JanetGCObject *));
+        if (NULL == newmem) {
+            JANET_OUT_OF_MEMORY;
+        }
+        janet_vm.gc_gray = newmem;
+        janet_vm.gc_gray_capacity = newcap;
+    }
+    janet_vm.gc_gray[janet_vm.gc_gray_count++] = mem;
+}
+
+/* Remember blocks that are mutated without a write barrier while an
+ * incremental mark cycle is running, so they can be rescanned at the end. */
+static void janet_gc_track(JanetGCObject *mem) {
+    if (janet_vm.gc_marking && !(mem->flags & JANET_MEM_REMEMBERED) && janet_gc_sticky(mem)) {
+        janet_gc_remember_block(mem);
+    }
+}
+
+/* Write barrier slow path - called when a reference is stored in a marked block. */
+void janet_gc_remember(JanetGCObject *mem) {
+    if (janet_vm.gc_mark_phase) return;
+    if (janet_vm.gc_mode == JANET_GC_MODE_INCREMENTAL) {
+        /* Block was already traced in this cycle, so make it gray again */
+        mem->flags &= ~JANET_MEM_REACHABLE;
+        janet_gc_push_gray(mem);
+        return;
+    }
+    janet_gc_remember_block(mem);
+}
+
+void janet_gcbarrier(void *mem) {
+    janet_gc_barrier(mem);
+}
+
+/* Handle a block that survived the mark phase. Generational collection keeps
+ * the mark bit so that the block is old from now on. */
+static void janet_gc_survive(JanetGCObject *mem) {
+    if (janet_vm.gc_mode == JANET_GC_MODE_GENERATIONAL) {
+        if (!(mem->flags & JANET_MEM_REMEMBERED) && janet_gc_sticky(mem)) {
+            janet_gc_remember_block(mem);
+        }
+    } else {
+        mem->flags &= ~JANET_MEM_REACHABLE;
+    }
+}
+
+/* Get the gc block of a value, or NULL if the value is not garbage collected */
+static JanetGCObject *janet_value_block(Janet x) {
     switch (janet_type(x)) {
         default:
-            return 1;
+            return NULL;
         case JANET_ARRAY:
         case JANET_TABLE:
         case JANET_FUNCTION:
         case JANET_BUFFER:
         case JANET_FIBER:
-            return janet_gc_reachable(janet_unwrap_pointer(x));
+            return (JanetGCObject *) janet_unwrap_pointer(x);
         case JANET_STRING:
         case JANET_SYMBOL:
         case JANET_KEYWORD:
-            return janet_gc_reachable(janet_string_head(janet_unwrap_string(x)));
+            return (JanetGCObject *) janet_string_head(janet_unwrap_string(x));
         case JANET_ABSTRACT:
-            return janet_gc_reachable(janet_abstract_head(janet_unwrap_abstract(x)));
+            return (JanetGCObject *) janet_abstract_head(janet_unwrap_abstract(x));
         case JANET_TUPLE:
-            return janet_gc_reachable(janet_tuple_head(janet_unwrap_tuple(x)));
+            return (JanetGCObject *) janet_tuple_head(janet_unwrap_tuple(x));
         case JANET_STRUCT:
-            return janet_gc_reachable(janet_struct_head(janet_unwrap_struct(x)));
+            return (JanetGCObject *) janet_struct_head(janet_unwrap_struct(x));
+    }
+}
+
+/* Mark a block of any type, tracing through it if it is not marked. */
+static void janet_mark_block(JanetGCObject *mem) {
+    switch (mem->flags & JANET_MEM_TYPEBITS) {
+        default:
+            janet_gc_mark(mem);
+            break;
+        case JANET_MEMORY_TUPLE:
+            janet_mark_tuple(((JanetTupleHead *) mem)->data);
+            break;
+        case JANET_MEMORY_STRUCT:
+            janet_mark_struct(((JanetStructHead *) mem)->data);
+            break;
+        case JANET_MEMORY_FUNCTION:
+            janet_mark_function((JanetFunction *) mem);
+            break;
+        case JANET_MEMORY_FUNCDEF:
+            janet_mark_funcdef((JanetFuncDef *) mem);
+            break;
+        case JANET_MEMORY_ARRAY:
+        case JANET_MEMORY_ARRAY_WEAK:
+            janet_mark_array((JanetArray *) mem);
+            break;
+        case JANET_MEMORY_TABLE:
+        case JANET_MEMORY_TABLE_WEAKK:
+        case JANET_MEMORY_TABLE_WEAKV:
+        case JANET_MEMORY_TABLE_WEAKKV:
+            janet_mark_table((JanetTable *) mem);
+            break;
+        case JANET_MEMORY_FIBER:
+            janet_mark_fiber((JanetFiber *) mem);
+            break;
+        case JANET_MEMORY_FUNCENV:
+            janet_mark_funcenv((JanetFuncEnv *) mem);
+            break;
+        case JANET_MEMORY_ABSTRACT:
+        case JANET_MEMORY_THREADED_ABSTRACT:
+            janet_mark_abstract(((JanetAbstractHead *) mem)->data);
+            break;
+    }
+}
+
+/* Drop blocks from the remembered set. If keep_sticky is set, blocks that
+ * need to stay remembered are kept. */
+static void janet_gc_forget(int keep_sticky) {
+    size_t j = 0;
+    for (size_t i = 0; i < janet_vm.gc_remembered_count; i++) {
+        JanetGCObject *mem = janet_vm.gc_remembered[i];
+        if (keep_sticky && janet_gc_sticky(mem)) {
+            janet_vm.gc_remembered[j++] = mem;
+        } else {
+            mem->flags &= ~JANET_MEM_REMEMBERED;
+        }
+    }
+    janet_vm.gc_remembered_count = j;
+}
+
+#ifdef JANET_GC_SLAB
+
+/* A page of equally sized slots for a single size class. Free slots are
+ * marked with JANET_MEM_SLAB_FREE and threaded through data.next. */
+typedef struct JanetSlabPage {
+    struct JanetSlabPage *next;
+    uint32_t slot_size;
+    uint32_t slot_count;
+    long long mem[]; /* for proper alignment */
+} JanetSlabPage;
+
+#define janet_slab_slot(page, i) \
+    ((JanetGCObject *)((char *)((page)->mem) + (size_t)(i) * (page)->slot_size))
+
+/* Get the size class for an allocation, or -1 if it should go on the
+ * block list. Funcdefs stay on the block list so the debugger can scan
+ * for them, and weak containers need to be visited by the weak sweep. */
+static int janet_slab_class(enum JanetMemoryType type, size_t size) {
+    if (size > JANET_SLAB_MAX) return -1;
+    if (type == JANET_MEMORY_FUNCDEF || type >= JANET_MEMORY_TABLE_WEAKK) return -1;
+    return (int)((size + JANET_SLAB_GRANULE - 1) / JANET_SLAB_GRANULE) - 1;
+}
+
+static JanetGCObject *janet_slab_alloc(int cls) {
+    JanetGCObject *mem = janet_vm.slab_free[cls];
+    if (NULL == mem) {
+        JanetSlabPage *page = janet_malloc(JANET_SLAB_PAGE_SIZE);
+        if (NULL == page) {
+            JANET_OUT_OF_MEMORY;
+        }
+        page->slot_size = (uint32_t)(cls + 1) * JANET_SLAB_GRANULE;
+        page->slot_count = (uint32_t)((JANET_SLAB_PAGE_SIZE - sizeof(JanetSlabPage)) / page->slot_size);
+        page->next = janet_vm.slab_pages[cls];
+        janet_vm.slab_pages[cls] = page;
+        /* Thread slots in reverse so allocation proceeds in address order */
+        for (uint32_t i = page->slot_count; i > 0; i--) {
+            JanetGCObject *slot = janet_slab_slot(page, i - 1);
+            slot->flags = JANET_MEM_SLAB_FREE;
+            slot->data.next = mem;
+            mem = slot;
+        }
+    }
+    janet_vm.slab_free[cls] = mem->data.next;
+    return mem;
+}
+
+/* Sweep all slab pages, rebuilding the free list of each size class
+ * and giving back pages that no longer hold any live objects. */
+static void janet_slab_sweep(void) {
+    for (int cls = 0; cls < JANET_SLAB_CLASSES; cls++) {
+        JanetSlabPage **prev = (JanetSlabPage **) &janet_vm.slab_pages[cls];
+        JanetSlabPage *page = *prev;
+        JanetGCObject *freelist = NULL;
+        while (NULL != page) {
+            JanetSlabPage *next = page->next;
+            JanetGCObject *page_start = freelist;
+            uint32_t live = 0;
+            for (uint32_t i = page->slot_count; i > 0; i--) {
+                JanetGCObject *slot = janet_slab_slot(page, i - 1);
+                if (slot->flags & JANET_MEM_SLAB_FREE) {
+                    /* Already free */
+                } else if (slot->flags & (JANET_MEM_REACHABLE | JANET_MEM_DISABLED)) {
+                    janet_vm.gc_stats.live_bytes[janet_gc_type(slot)] += janet_block_size(slot);
+                    janet_gc_survive(slot);
+                    live++;
+                    continue;
+                } else {
+                    janet_gc_count_free(slot);
+                    janet_vm.block_count--;
+                    janet_deinit_block(slot);
+                    slot->flags = JANET_MEM_SLAB_FREE;
+                }
+                slot->data.next = freelist;
+                freelist = slot;
+            }
+            if (live == 0) {
+                freelist = page_start;
+                *prev = next;
+                janet_free(page);
+            } else {
+                prev = &page->next;
+            }
+            page = next;
+        }
+        janet_vm.slab_free[cls] = freelist;
+    }
+}
+
+/* Free all slab pages and the objects in them */
+static void janet_slab_clear(void) {
+    for (int cls = 0; cls < JANET_SLAB_CLASSES; cls++) {
+        JanetSlabPage *page = janet_vm.slab_pages[cls];
+        while (NULL != page) {
+            JanetSlabPage *next = page->next;
+            for (uint32_t i = 0; i < page->slot_count; i++) {
+                JanetGCObject *slot = janet_slab_slot(page, i);
+                if (!(slot->flags & JANET_MEM_SLAB_FREE)) {
+                    janet_deinit_block(slot);
+                }
+            }
+            janet_free(page);
+            page = next;
+        }
+        janet_vm.slab_pages[cls] = NULL;
+        janet_vm.slab_free[cls] = NULL;
+    }
+}
+
+#endif
+
+/* Clear the mark bit on every block in the heap */
+static void janet_gc_clear_marks(void) {
+    JanetGCObject *current;
+    for (current = janet_vm.blocks; NULL != current; current = current->data.next)
+        current->flags &= ~JANET_MEM_REACHABLE;
+    for (current = janet_vm.weak_blocks; NULL != current; current = current->data.next)
+        current->flags &= ~JANET_MEM_REACHABLE;
+#ifdef JANET_GC_SLAB
+    for (int cls = 0; cls < JANET_SLAB_CLASSES; cls++) {
+        JanetSlabPage *page = janet_vm.slab_pages[cls];
+        for (; NULL != page; page = page->next) {
+            for (uint32_t i = 0; i < page->slot_count; i++) {
+                janet_slab_slot(page, i)->flags &= ~JANET_MEM_REACHABLE;
+            }
+        }
+    }
+#endif
+}
+
+#ifdef JANET_GC_THREADS
+
+/* Parallel marking. Helper threads are started the first time a large heap
+ * is collected. Blocks that can be traced without side effects are traced by
+ * all threads at once, with mark bits set atomically. Fibers, function
+ * environments and abstract types can run arbitrary code or touch thread local
+ * state when marked, so they are handed back to the main thread, which marks
+ * them between parallel phases. */
+
+/* Heaps with fewer blocks than this are marked on the main thread only */
+#define JANET_GC_PARALLEL_MIN_BLOCKS 0x10000
+
+#ifdef JANET_WINDOWS
+typedef CRITICAL_SECTION JanetGCMutex;
+typedef CONDITION_VARIABLE JanetGCCond;
+typedef HANDLE JanetGCThread;
+#define janet_gcmutex_init(m) InitializeCriticalSection(m)
+#define janet_gcmutex_deinit(m) DeleteCriticalSection(m)
+#define janet_gcmutex_lock(m) EnterCriticalSection(m)
+#define janet_gcmutex_unlock(m) LeaveCriticalSection(m)
+#define janet_gccond_init(c) InitializeConditionVariable(c)
+#define janet_gccond_deinit(c) ((void) 0)
+#define janet_gccond_wait(c, m) SleepConditionVariableCS((c), (m), INFINITE)
+#define janet_gccond_broadcast(c) WakeAllConditionVariable(c)
+#else
+typedef pthread_mutex_t JanetGCMutex;
+typedef pthread_cond_t JanetGCCond;
+typedef pthread_t JanetGCThread;
+#define janet_gcmutex_init(m) pthread_mutex_init((m), NULL)
+#define janet_gcmutex_deinit(m) pthread_mutex_destroy(m)
+#define janet_gcmutex_lock(m) pthread_mutex_lock(m)
+#define janet_gcmutex_unlock(m) pthread_mutex_unlock(m)
+#define janet_gccond_init(c) pthread_cond_init((c), NULL)
+#define janet_gccond_deinit(c) pthread_cond_destroy(c)
+#define janet_gccond_wait(c, m) pthread_cond_wait((c), (m))
+#define janet_gccond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+/* Atomic access to gc flags while several threads are marking */
+#ifdef _MSC_VER
+#define janet_gc_flags_load(m) (*(volatile int32_t *) &(m)->flags)
+#define janet_gc_flags_or(m, bits) _InterlockedOr((long volatile *) &(m)->flags, (bits))
+#elif defined(JANET_USE_STDATOMIC)
+#define janet_gc_flags_load(m) atomic_load_explicit((_Atomic int32_t *) &(m)->flags, memory_order_relaxed)
+#define janet_gc_flags_or(m, bits) atomic_fetch_or_explicit((_Atomic int32_t *) &(m)->flags, (bits), memory_order_relaxed)
+#else
+#define janet_gc_flags_load(m) __atomic_load_n(&(m)->flags, __ATOMIC_RELAXED)
+#define janet_gc_flags_or(m, bits) __atomic_fetch_or(&(m)->flags, (bits), __ATOMIC_RELAXED)
+#endif
+
+typedef struct {
+    JanetGCObject **items;
+    size_t count;
+    size_t capacity;
+} JanetGCWorkStack;
+
+typedef struct {
+    JanetGCMutex lock;
+    JanetGCCond wake;
+    JanetGCCond done;
+    JanetGCThread threads[JANET_GC_THREADS];
+    int phase;
+    int shutdown;
+    int active; /* workers that still hold work in this phase */
+    int running; /* helpers that have not left this phase */
+    JanetAtomicInt hungry; /* workers waiting for shared work */
+    JanetGCWorkStack shared;
+    JanetGCWorkStack deferred;
+} JanetGCPool;
+
+static void janet_gc_work_push(JanetGCWorkStack *stack, JanetGCObject *mem) {
+    if (stack->count == stack->capacity) {
+        size_t newcap = 2 * stack->capacity + 256;
+        JanetGCObject **newmem = janet_realloc(stack->items, newcap * sizeof(JanetGCObject *));
+        if (NULL == newmem) {
+            JANET_OUT_OF_MEMORY;
+        }
+        stack->items = newmem;
+        stack->capacity = newcap;
+    }
+    stack->items[stack->count++] = mem;
+}
+
+/* Move n items from the top of one stack to another */
+static void janet_gc_work_move(JanetGCWorkStack *to, JanetGCWorkStack *from, size_t n) {
+    for (size_t i = from->count - n; i < from->count; i++) {
+        janet_gc_work_push(to, from->items[i]);
+    }
+    from->count -= n;
+}
+
+/* Blocks that must be marked on the main thread */
+static int janet_pmark_deferred(int32_t flags) {
+    switch (flags & JANET_MEM_TYPEBITS) {
+        default:
+            return 0;
+        case JANET_MEMORY_FIBER:
+        case JANET_MEMORY_FUNCENV:
+        case JANET_MEMORY_ABSTRACT:
+        case JANET_MEMORY_THREADED_ABSTRACT:
+            return 1;
+    }
+}
+
+static void janet_pmark_push(JanetGCObject *mem, JanetGCWorkStack *local, JanetGCWorkStack *deferred) {
+    int32_t flags = janet_gc_flags_load(mem);
+    if (flags & JANET_MEM_REACHABLE) return;
+    switch (flags & JANET_MEM_TYPEBITS) {
+        case JANET_MEMORY_STRING:
+        case JANET_MEMORY_SYMBOL:
+        case JANET_MEMORY_BUFFER:
+            /* Nothing to trace */
+            janet_gc_flags_or(mem, JANET_MEM_REACHABLE);
+            return;
+        default:
+            break;
+    }
+    janet_gc_work_push(janet_pmark_deferred(flags) ? deferred : local, mem);
+}
+
+static void janet_pmark_value(Janet x, JanetGCWorkStack *local, JanetGCWorkStack *deferred) {
+    JanetGCObject *mem = janet_value_block(x);
+    if (NULL != mem) janet_pmark_push(mem, local, deferred);
+}
+
+static void janet_pmark_many(const Janet *values, int32_t n, JanetGCWorkStack *local, JanetGCWorkStack *deferred) {
+    if (NULL == values) return;
+    for (int32_t i = 0; i < n; i++) {
+        janet_pmark_value(values[i], local, deferred);
+    }
+}
+
+static void janet_pmark_kvs(const JanetKV *kvs, int32_t n, int keys, int values,
+                            JanetGCWorkStack *local, JanetGCWorkStack *deferred) {
+    for (int32_t i = 0; i < n; i++) {
+        if (keys) janet_pmark_value(kvs[i].key, local, deferred);
+        if (values) janet_pmark_value(kvs[i].value, local, deferred);
+    }
+}
+
+/* Claim a block and trace its children. Only reads the block, so it is safe
+ * to call from any thread while the heap is stopped. */
+static void janet_pmark_scan(JanetGCObject *mem, JanetGCWorkStack *local, JanetGCWorkStack *deferred) {
+    if (janet_pmark_deferred(janet_gc_flags_load(mem))) {
+        /* Gray blocks from the main thread can be of any type */
+        janet_pmark_push(mem, local, deferred);
+        return;
+    }
+    int32_t flags = janet_gc_flags_or(mem, JANET_MEM_REACHABLE);
+    if (flags & JANET_MEM_REACHABLE) return;
+    switch (flags & JANET_MEM_TYPEBITS) {
+        default:
+            break;
+        case JANET_MEMORY_ARRAY: {
+            JanetArray *array = (JanetArray *) mem;
+            janet_pmark_many(array->data, array->count, local, deferred);
+            break;
+        }
+        case JANET_MEMORY_TUPLE: {
+            JanetTupleHead *head = (JanetTupleHead *) mem;
+            janet_pmark_many(head->data, head->length, local, deferred);
+            break;
+        }
+        case JANET_MEMORY_TABLE:
+        case JANET_MEMORY_TABLE_WEAKK:
+        case JANET_MEMORY_TABLE_WEAKV:
+        case JANET_MEMORY_TABLE_WEAKKV: {
+            JanetTable *table = (JanetTable *) mem;
+            int32_t memtype = flags & JANET_MEM_TYPEBITS;
+            janet_pmark_kvs(table->data, table->capacity,
+                            memtype == JANET_MEMORY_TABLE || memtype == JANET_MEMORY_TABLE_WEAKV,
+                            memtype == JANET_MEMORY_TABLE || memtype == JANET_MEMORY_TABLE_WEAKK,
+                            local, deferred);
+            if (table->proto) janet_pmark_push((JanetGCObject *) table->proto, local, deferred);
+            break;
+        }
+        case JANET_MEMORY_STRUCT: {
+            JanetStructHead *head = (JanetStructHead *) mem;
+            janet_pmark_kvs(head->data, head->capacity, 1, 1, local, deferred);
+            if (head->proto) janet_pmark_push((JanetGCObject *) janet_struct_head(head->proto), local, deferred);
+            break;
+        }
+        case JANET_MEMORY_FUNCTION: {
+            JanetFunction *func = (JanetFunction *) mem;
+            if (NULL != func->def) {
+                for (int32_t i = 0; i < func->def->environments_length; i++) {
+                    janet_pmark_push((JanetGCObject *) func->envs[i], local, deferred);
+                }
+                janet_pmark_push((JanetGCObject *) func->def, local, deferred);
+            }
+            break;
+        }
+        case JANET_MEMORY_FUNCDEF: {
+            JanetFuncDef *def = (JanetFuncDef *) mem;
+            janet_pmark_many(def->constants, def->constants_length, local, deferred);
+            for (int32_t i = 0; i < def->defs_length; i++) {
+                janet_pmark_push((JanetGCObject *) def->defs[i], local, deferred);
+            }
+            if (def->source)
+                janet_pmark_push((JanetGCObject *) janet_string_head(def->source), local, deferred);
+            if (def->name)
+                janet_pmark_push((JanetGCObject *) janet_string_head(def->name), local, deferred);
+            for (int32_t i = 0; i < def->symbolmap_length; i++) {
+                janet_pmark_push((JanetGCObject *) janet_string_head(def->symbolmap[i].symbol), local, deferred);
+            }
+            break;
+        }
+    }
+}
+
+/* Mark work loop run by every thread in a parallel phase */
+static void janet_pmark_run(JanetGCPool *pool) {
+    JanetGCWorkStack local = {NULL, 0, 0};
+    JanetGCWorkStack deferred = {NULL, 0, 0};
+    uint32_t n = 0;
+    for (;;) {
+        if (local.count == 0) {
+            janet_gcmutex_lock(&pool->lock);
+            janet_gc_work_move(&pool->deferred, &deferred, deferred.count);
+            pool->active--;
+            while (pool->shared.count == 0 && pool->active > 0) {
+                janet_atomic_inc(&pool->hungry);
+                janet_gccond_wait(&pool->wake, &pool->lock);
+                janet_atomic_dec(&pool->hungry);
+            }
+            if (pool->shared.count == 0) {
+                /* No work left anywhere */
+                janet_gccond_broadcast(&pool->wake);
+                janet_gcmutex_unlock(&pool->lock);
+                break;
+            }
+            size_t take = pool->shared.count / (JANET_GC_THREADS + 1) + 1;
+            janet_gc_work_move(&local, &pool->shared, take);
+            pool->active++;
+            janet_gcmutex_unlock(&pool->lock);
+        }
+        janet_pmark_scan(local.items[--local.count], &local, &deferred);
+        /* Share half of our work if other threads are waiting for some */
+        if ((++n & 0xFF) == 0 && local.count > 16 && janet_atomic_load_relaxed(&pool->hungry)) {
+            janet_gcmutex_lock(&pool->lock);
+            janet_gc_work_move(&pool->shared, &local, local.count / 2);
+            janet_gccond_broadcast(&pool->wake);
+            janet_gcmutex_unlock(&pool->lock);
+        }
+    }
+    janet_free(local.items);
+    janet_free(deferred.items);
+}
+
+#ifdef JANET_WINDOWS
+static DWORD WINAPI janet_gc_helper(LPVOID arg) {
+#else
+static void *janet_gc_helper(void *arg) {
+#endif
+    JanetGCPool *pool = (JanetGCPool *) arg;
+    int phase = 0;
+    janet_gcmutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->phase == phase) {
+            janet_gccond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        phase = pool->phase;
+        janet_gcmutex_unlock(&pool->lock);
+        janet_pmark_run(pool);
+        janet_gcmutex_lock(&pool->lock);
+        if (--pool->running == 0) janet_gccond_broadcast(&pool->done);
+    }
+    janet_gcmutex_unlock(&pool->lock);
+    return 0;
+}
+
+static JanetGCPool *janet_gc_pool(void) {
+    if (NULL != janet_vm.gc_pool) return janet_vm.gc_pool;
+    JanetGCPool *pool = janet_malloc(sizeof(JanetGCPool));
+    if (NULL == pool) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memset(pool, 0, sizeof(JanetGCPool));
+    janet_gcmutex_init(&pool->lock);
+    janet_gccond_init(&pool->wake);
+    janet_gccond_init(&pool->done);
+    for (int i = 0; i < JANET_GC_THREADS; i++) {
+#ifdef JANET_WINDOWS
+        pool->threads[i] = CreateThread(NULL, 0, janet_gc_helper, pool, 0, NULL);
+        janet_assert(NULL != pool->threads[i], "failed to create gc thread");
+#else
+        int err = pthread_create(&pool->threads[i], NULL, janet_gc_helper, pool);
+        janet_assert(!err, "failed to create gc thread");
+#endif
     }
+    janet_vm.gc_pool = pool;
+    return pool;
+}
+
+static void janet_gc_pool_deinit(void) {
+    JanetGCPool *pool = janet_vm.gc_pool;
+    if (NULL == pool) return;
+    janet_gcmutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    janet_gccond_broadcast(&pool->wake);
+    janet_gcmutex_unlock(&pool->lock);
+    for (int i = 0; i < JANET_GC_THREADS; i++) {
+#ifdef JANET_WINDOWS
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+    janet_gccond_deinit(&pool->wake);
+    janet_gccond_deinit(&pool->done);
+    janet_gcmutex_deinit(&pool->lock);
+    janet_free(pool->shared.items);
+    janet_free(pool->deferred.items);
+    janet_free(pool);
+    janet_vm.gc_pool = NULL;
+}
+
+/* Drain the gray stack using every mark thread, alternating with the main
+ * thread marking deferred blocks until no work is left. */
+static void janet_gc_parallel_drain(void) {
+    JanetGCPool *pool = janet_gc_pool();
+    while (janet_vm.gc_gray_count) {
+        janet_gcmutex_lock(&pool->lock);
+        for (size_t i = 0; i < janet_vm.gc_gray_count; i++) {
+            janet_gc_work_push(&pool->shared, janet_vm.gc_gray[i]);
+        }
+        janet_vm.gc_gray_count = 0;
+        pool->active = JANET_GC_THREADS + 1;
+        pool->running = JANET_GC_THREADS;
+        pool->phase++;
+        janet_gccond_broadcast(&pool->wake);
+        janet_gcmutex_unlock(&pool->lock);
+        janet_pmark_run(pool);
+        janet_gcmutex_lock(&pool->lock);
+        while (pool->running) {
+            janet_gccond_wait(&pool->done, &pool->lock);
+        }
+        janet_gcmutex_unlock(&pool->lock);
+        /* Helpers are idle, so the deferred blocks can be marked here. Their
+         * children go back on the gray stack for the next phase. */
+        depth = 0;
+        for (size_t i = 0; i < pool->deferred.count; i++) {
+            janet_mark_block(pool->deferred.items[i]);
+        }
+        pool->deferred.count = 0;
+    }
+}
+
+#endif
+
+/* Check that a value x has been visited in the mark phase */
+static int janet_check_liveref(Janet x) {
+    JanetGCObject *mem = janet_value_block(x);
+    return NULL == mem || janet_gc_reachable(mem);
 }
 
 /* Iterate over all allocated memory, and free memory that is not
@@ -406,6 +1102,15 @@ void janet_sweep() {
     JanetGCObject *current = janet_vm.weak_blocks;
     JanetGCObject *next;
 
+    /* Freed tables and cleared weak entries invalidate inline method caches */
+    janet_vm.method_cache_epoch++;
+
+    /* Live sizes are measured again for every block visited by this sweep */
+    memset(janet_vm.gc_stats.live_bytes, 0, sizeof(janet_vm.gc_stats.live_bytes));
+    if (!minor_cycle) {
+        memset(janet_vm.gc_old_live, 0, sizeof(janet_vm.gc_old_live));
+    }
+
     /* Sweep weak heap to drop weak refs */
     while (NULL != current) {
         next = current->data.next;
@@ -417,6 +1122,7 @@ void janet_sweep() {
                 for (uint32_t i = 0; i < (uint32_t) array->count; i++) {
                     if (!janet_check_liveref(array->data[i])) {
                         array->data[i] = janet_wrap_nil();
+                        janet_vm.gc_stats.last.weak_cleared++;
                     }
                 }
             } else {
@@ -430,11 +1136,8 @@ void janet_sweep() {
                     if (check_keys && !janet_check_liveref(kvs->key)) drop = 1;
                     if (check_values && !janet_check_liveref(kvs->value)) drop = 1;
                     if (drop) {
-                        /* Inlined from janet_table_remove without search */
-                        table->count--;
-                        table->deleted++;
-                        kvs->key = janet_wrap_nil();
-                        kvs->value = janet_wrap_false();
+                        janet_table_erase(table, kvs);
+                        janet_vm.gc_stats.last.weak_cleared++;
                     }
                     kvs++;
                 }
@@ -450,8 +1153,10 @@ void janet_sweep() {
         next = current->data.next;
         if (current->flags & (JANET_MEM_REACHABLE | JANET_MEM_DISABLED)) {
             previous = current;
-            current->flags &= ~JANET_MEM_REACHABLE;
+            janet_vm.gc_stats.live_bytes[janet_gc_type(current)] += janet_block_size(current);
+            janet_gc_survive(current);
         } else {
+            janet_gc_count_free(current);
             janet_vm.block_count--;
             janet_deinit_block(current);
             if (NULL != previous) {
@@ -464,15 +1169,20 @@ void janet_sweep() {
         current = next;
     }
 
-    /* Sweep main heap to free blocks */
+    /* Sweep main heap to free blocks. Blocks are prepended on allocation, so
+     * in a minor collection only the blocks before the old generation need
+     * to be visited. */
+    JanetGCObject *boundary = minor_cycle ? janet_vm.gc_old_blocks : NULL;
     previous = NULL;
     current = janet_vm.blocks;
-    while (NULL != current) {
+    while (boundary != current) {
         next = current->data.next;
         if (current->flags & (JANET_MEM_REACHABLE | JANET_MEM_DISABLED)) {
             previous = current;
-            current->flags &= ~JANET_MEM_REACHABLE;
+            janet_vm.gc_old_live[janet_gc_type(current)] += janet_block_size(current);
+            janet_gc_survive(current);
         } else {
+            janet_gc_count_free(current);
             janet_vm.block_count--;
             janet_deinit_block(current);
             if (NULL != previous) {
@@ -485,10 +1195,30 @@ void janet_sweep() {
         current = next;
     }
 
+    janet_vm.gc_old_blocks = janet_vm.blocks;
+
+#ifdef JANET_GC_SLAB
+    /* Sweep slab pages */
+    janet_slab_sweep();
+#endif
+
+    /* Old blocks that were not visited keep their size from earlier sweeps */
+    for (int t = 0; t < JANET_GC_MEMORY_TYPES; t++) {
+        janet_vm.gc_stats.live_bytes[t] += janet_vm.gc_old_live[t];
+    }
+
 #ifdef JANET_EV
-    /* Sweep threaded abstract types for references to decrement */
+    /* Sweep threaded abstract types for references to decrement. Old blocks
+     * are not traced in a minor collection, so only a full traversal can
+     * tell that a threaded abstract is no longer referenced. */
     JanetKV *items = janet_vm.threaded_abstracts.data;
     for (int32_t i = 0; i < janet_vm.threaded_abstracts.capacity; i++) {
+        if (minor_cycle) {
+            if (janet_checktype(items[i].key, JANET_ABSTRACT)) {
+                items[i].value = janet_wrap_false();
+            }
+            continue;
+        }
         if (janet_checktype(items[i].key, JANET_ABSTRACT)) {
 
             /* If item was not visited during the mark phase, then this
@@ -504,7 +1234,9 @@ void janet_sweep() {
                 if (head->type->gcperthread) {
                     janet_assert(!head->type->gcperthread(head->data, head->size), "per-thread finalizer failed");
                 }
+                janet_vm.gc_stats.last.threaded_decrefs++;
                 if (0 == janet_abstract_decref(abst)) {
+                    janet_vm.gc_stats.last.bytes_freed += sizeof(JanetAbstractHead) + head->size;
                     /* Run finalizer */
                     if (head->type->gc) {
                         janet_assert(!head->type->gc(head->data, head->size), "finalizer failed");
@@ -513,11 +1245,8 @@ void janet_sweep() {
                     janet_free(janet_abstract_head(abst));
                 }
 
-                /* Mark as tombstone in place */
-                items[i].key = janet_wrap_nil();
-                items[i].value = janet_wrap_false();
-                janet_vm.threaded_abstracts.deleted++;
-                janet_vm.threaded_abstracts.count--;
+                janet_table_erase(&janet_vm.threaded_abstracts, items + i);
+                continue;
             }
 
             /* Reset for next sweep */
@@ -527,12 +1256,208 @@ void janet_sweep() {
 #endif
 }
 
+/*
+ * Heap profiler and memory groups. Every sample_interval bytes, the block
+ * being allocated is sampled: it stands for all bytes allocated since the
+ * previous sample, and is tagged so that freeing it removes that estimate
+ * from the live bytes of its stack and memory group again.
+ */
+
+static size_t janet_heap_slot(void *mem) {
+    uint64_t h = (uint64_t)(uintptr_t) mem;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t) h & (janet_vm.heap_sample_capacity - 1);
+}
+
+static void janet_heap_sample_put(JanetHeapSample sample) {
+    if (2 * (janet_vm.heap_sample_count + 1) > janet_vm.heap_sample_capacity) {
+        size_t old_capacity = janet_vm.heap_sample_capacity;
+        JanetHeapSample *old = janet_vm.heap_samples;
+        size_t capacity = old_capacity ? 2 * old_capacity : 64;
+        JanetHeapSample *samples = janet_calloc(capacity, sizeof(JanetHeapSample));
+        if (NULL == samples) {
+            JANET_OUT_OF_MEMORY;
+        }
+        janet_vm.heap_samples = samples;
+        janet_vm.heap_sample_capacity = capacity;
+        janet_vm.heap_sample_count = 0;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (NULL != old[i].mem) janet_heap_sample_put(old[i]);
+        }
+        janet_free(old);
+    }
+    size_t i = janet_heap_slot(sample.mem);
+    while (NULL != janet_vm.heap_samples[i].mem) {
+        i = (i + 1) & (janet_vm.heap_sample_capacity - 1);
+    }
+    janet_vm.heap_samples[i] = sample;
+    janet_vm.heap_sample_count++;
+}
+
+/* Get the index of a folded stack in janet_vm.heap_stacks */
+static int32_t janet_heap_stack(Janet key) {
+    Janet index = janet_table_get(janet_vm.heap_stack_index, key);
+    if (janet_checktype(index, JANET_NUMBER)) return janet_unwrap_integer(index);
+    if (janet_vm.heap_stack_count == janet_vm.heap_stack_capacity) {
+        int32_t capacity = janet_vm.heap_stack_capacity ? 2 * janet_vm.heap_stack_capacity : 16;
+        JanetHeapStack *stacks = janet_realloc(janet_vm.heap_stacks, (size_t) capacity * sizeof(JanetHeapStack));
+        if (NULL == stacks) {
+            JANET_OUT_OF_MEMORY;
+        }
+        janet_vm.heap_stacks = stacks;
+        janet_vm.heap_stack_capacity = capacity;
+    }
+    int32_t i = janet_vm.heap_stack_count++;
+    memset(janet_vm.heap_stacks + i, 0, sizeof(JanetHeapStack));
+    janet_table_put(janet_vm.heap_stack_index, key, janet_wrap_integer(i));
+    return i;
+}
+
+static void janet_heap_sample(JanetGCObject *mem, JanetMemoryGroup *group) {
+    size_t bytes = (size_t)((int64_t) janet_vm.heap_sample_interval - janet_vm.heap_countdown);
+    janet_vm.heap_countdown = (int64_t) janet_vm.heap_sample_interval;
+    JanetHeapSample sample;
+    sample.mem = mem;
+    sample.group = group;
+    sample.stack = -1;
+    sample.bytes = bytes;
+    if (janet_vm.heap_profiling) {
+        /* Allocations made while recording the stack are not counted or sampled */
+        janet_vm.heap_sampling = 1;
+        Janet key = janet_vm.fiber ? janet_profile_stack(janet_vm.fiber) : janet_wrap_nil();
+        if (janet_checktype(key, JANET_NIL)) key = janet_cstringv("<no stack>");
+        sample.stack = janet_heap_stack(key);
+        janet_vm.heap_sampling = 0;
+        JanetHeapStack *stack = janet_vm.heap_stacks + sample.stack;
+        stack->samples++;
+        stack->bytes += bytes;
+        stack->live_samples++;
+        stack->live_bytes += bytes;
+        janet_vm.heap_sample_total++;
+    }
+    if (NULL != group) group->live += bytes;
+    mem->flags |= JANET_MEM_SAMPLED;
+    janet_heap_sample_put(sample);
+}
+
+/* Remove the sample of a block that is being freed */
+static void janet_heap_sample_free(JanetGCObject *mem) {
+    if (0 == janet_vm.heap_sample_count) return;
+    size_t mask = janet_vm.heap_sample_capacity - 1;
+    size_t i = janet_heap_slot(mem);
+    while (janet_vm.heap_samples[i].mem != mem) {
+        if (NULL == janet_vm.heap_samples[i].mem) return;
+        i = (i + 1) & mask;
+    }
+    JanetHeapSample *sample = janet_vm.heap_samples + i;
+    if (sample->stack >= 0) {
+        JanetHeapStack *stack = janet_vm.heap_stacks + sample->stack;
+        stack->live_samples--;
+        stack->live_bytes -= sample->bytes;
+    }
+    if (NULL != sample->group) sample->group->live -= sample->bytes;
+    /* Shift later entries of the probe sequence back into the hole */
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (NULL == janet_vm.heap_samples[j].mem) break;
+        size_t home = janet_heap_slot(janet_vm.heap_samples[j].mem);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            janet_vm.heap_samples[i] = janet_vm.heap_samples[j];
+            i = j;
+        }
+    }
+    janet_vm.heap_samples[i].mem = NULL;
+    janet_vm.heap_sample_count--;
+}
+
+/* Memory groups stay alive while any of their sampled blocks are */
+static void janet_heap_profile_mark(void) {
+    for (size_t i = 0; i < janet_vm.heap_sample_capacity; i++) {
+        JanetHeapSample *sample = janet_vm.heap_samples + i;
+        if (NULL != sample->mem && NULL != sample->group) {
+            janet_mark(janet_wrap_abstract(sample->group));
+        }
+    }
+}
+
+/* Throw away the stacks recorded by the heap profiler */
+void janet_heap_profile_clear(void) {
+    for (size_t i = 0; i < janet_vm.heap_sample_capacity; i++) {
+        janet_vm.heap_samples[i].stack = -1;
+    }
+    janet_free(janet_vm.heap_stacks);
+    janet_vm.heap_stacks = NULL;
+    janet_vm.heap_stack_count = 0;
+    janet_vm.heap_stack_capacity = 0;
+    janet_vm.heap_sample_total = 0;
+    if (NULL != janet_vm.heap_stack_index) {
+        janet_gcunroot(janet_wrap_table(janet_vm.heap_stack_index));
+        janet_vm.heap_stack_index = NULL;
+    }
+}
+
+void janet_heap_profile_deinit(void) {
+    janet_vm.heap_profiling = 0;
+    janet_heap_profile_clear();
+    janet_free(janet_vm.heap_samples);
+    janet_vm.heap_samples = NULL;
+    janet_vm.heap_sample_count = 0;
+    janet_vm.heap_sample_capacity = 0;
+}
+
+/* Charge an allocation to the memory group of the running fiber, and
+ * sample it for the heap profiler */
+static void janet_gc_account(JanetGCObject *mem, size_t size) {
+    if (janet_vm.heap_sampling) return;
+    JanetMemoryGroup *group = janet_vm.fiber ? janet_vm.fiber->memory_group : NULL;
+    if (NULL != group) {
+        group->allocated += size;
+#ifndef JANET_NO_INTERPRETER_INTERRUPT
+        /* Allocation is not a safe place to raise an error, so interrupt the
+         * VM and raise it at the next safe point instead */
+        if (group->limit && group->allocated > group->limit && NULL == janet_vm.memory_limit_hit) {
+            janet_vm.memory_limit_hit = group;
+            janet_interpreter_interrupt(NULL);
+        }
+#endif
+    }
+    janet_vm.heap_countdown -= (int64_t) size;
+    if (janet_vm.heap_countdown <= 0) janet_heap_sample(mem, group);
+}
+
+/* Called by the VM at a safe point after a memory group went over its limit */
+void janet_memory_limit_check(JanetFiber *fiber) {
+    JanetMemoryGroup *group = janet_vm.memory_limit_hit;
+    if (NULL == group) return;
+    janet_vm.memory_limit_hit = NULL;
+    janet_interpreter_interrupt_handled(NULL);
+    if (fiber->memory_group == group) {
+        janet_panicf("memory limit of %d bytes exceeded", (int64_t) group->limit);
+    }
+}
+
+#define janet_gc_accounting() (janet_vm.heap_profiling || (janet_vm.fiber && janet_vm.fiber->memory_group))
+
 /* Allocate some memory that is tracked for garbage collection */
 void *janet_gcalloc(enum JanetMemoryType type, size_t size) {
     JanetGCObject *mem;
 
     /* Make sure everything is inited */
     janet_assert(NULL != janet_vm.cache, "please initialize janet before use");
+#ifdef JANET_GC_SLAB
+    int cls = janet_slab_class(type, size);
+    if (cls >= 0) {
+        mem = janet_slab_alloc(cls);
+        mem->flags = type;
+        janet_vm.next_collection += size;
+        janet_vm.block_count++;
+        if (janet_gc_accounting()) janet_gc_account(mem, size);
+        return (void *)mem;
+    }
+#endif
     mem = janet_malloc(size);
 
     /* Check for bad malloc */
@@ -555,6 +1480,7 @@ void *janet_gcalloc(enum JanetMemoryType type, size_t size) {
         janet_vm.weak_blocks = mem;
     }
     janet_vm.block_count++;
+    if (janet_gc_accounting()) janet_gc_account(mem, size);
 
     return (void *)mem;
 }
@@ -579,35 +1505,252 @@ static JanetScratch *janet_mem2scratch(void *mem) {
     return s - 1;
 }
 
-/* Run garbage collection */
-void janet_collect(void) {
-    uint32_t i;
-    if (janet_vm.gc_suspend) return;
-    depth = JANET_RECURSION_GUARD;
-    janet_vm.gc_mark_phase = 1;
-    /* Try to prevent many major collections back to back.
-     * A full collection will take O(janet_vm.block_count) time.
-     * If we have a large heap, make sure our interval is not too
-     * small so we won't make many collections over it. This is just a
-     * heuristic for automatically changing the gc interval */
+/* Try to prevent many major collections back to back.
+ * A full collection will take O(janet_vm.block_count) time.
+ * If we have a large heap, make sure our interval is not too
+ * small so we won't make many collections over it. This is just a
+ * heuristic for automatically changing the gc interval */
+static void janet_gc_adjust_interval(void) {
+    if (janet_vm.gc_pause) return;
     if (janet_vm.block_count * 8 > janet_vm.gc_interval) {
         janet_vm.gc_interval = janet_vm.block_count * sizeof(JanetGCObject);
     }
-    orig_rootcount = janet_vm.root_count;
+}
+
+/* Mark everything directly reachable from the VM */
+static void janet_heap_profile_mark(void);
+static void janet_gc_mark_roots(void) {
 #ifdef JANET_EV
     janet_ev_mark();
 #endif
-    janet_mark_fiber(janet_vm.root_fiber);
-    for (i = 0; i < orig_rootcount; i++)
+    janet_heap_profile_mark();
+    /* No root fiber when stepping from the event loop */
+    if (NULL != janet_vm.root_fiber)
+        janet_mark_fiber(janet_vm.root_fiber);
+    for (size_t i = 0; i < janet_vm.root_count; i++)
         janet_mark(janet_vm.roots[i]);
-    while (orig_rootcount < janet_vm.root_count) {
-        Janet x = janet_vm.roots[--janet_vm.root_count];
-        janet_mark(x);
+}
+
+/* Monotonic time in seconds */
+static double janet_gc_clock(void) {
+    struct timespec now;
+    janet_gettime(&now, JANET_TIME_MONOTONIC);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+/* Trace blocks on the gray stack. With a non-zero budget in microseconds,
+ * stop early once the budget is used up. Returns 1 if the stack is empty. */
+static int janet_gc_drain(uint32_t budget) {
+    double deadline = budget ? janet_gc_clock() + budget * 1e-6 : 0.0;
+    uint32_t n = 0;
+    while (janet_vm.gc_gray_count) {
+        janet_mark_block(janet_vm.gc_gray[--janet_vm.gc_gray_count]);
+        /* Checking the clock is slow, so only check every so often */
+        if (budget && (++n & 0x3F) == 0 && janet_gc_clock() >= deadline) {
+            return !janet_vm.gc_gray_count;
+        }
     }
-    janet_vm.gc_mark_phase = 0;
+    return 1;
+}
+
+/* Sweep once marking is done, then record statistics for the cycle */
+static void janet_gc_sweep_and_record(double sweep_start) {
+    JanetGCStats *stats = &janet_vm.gc_stats;
     janet_sweep();
+    janet_symcache_compact();
+    stats->last.sweep_time = janet_gc_clock() - sweep_start;
+    stats->collections++;
+    stats->total.mark_time += stats->last.mark_time;
+    stats->total.sweep_time += stats->last.sweep_time;
+    stats->total.bytes_freed += stats->last.bytes_freed;
+    stats->total.blocks_freed += stats->last.blocks_freed;
+    stats->total.weak_cleared += stats->last.weak_cleared;
+    stats->total.threaded_decrefs += stats->last.threaded_decrefs;
+    if (janet_vm.gc_pause) {
+        /* Adaptive pacing - wait until the heap has grown to gc_pause percent
+         * of what survived this collection. */
+        size_t live = 0;
+        for (int t = 0; t < JANET_GC_MEMORY_TYPES; t++) {
+            live += stats->live_bytes[t];
+        }
+        size_t interval = (size_t)((double) live * (janet_vm.gc_pause - 100) / 100.0);
+        janet_vm.gc_interval = interval < JANET_GC_MIN_INTERVAL ? JANET_GC_MIN_INTERVAL : interval;
+    }
+}
+
+/* Finish an incremental mark cycle and sweep. Blocks that are mutated
+ * without a write barrier are rescanned along with the roots, which
+ * traces any blocks they picked up since they were first marked. */
+static void janet_gc_finish_mark(void) {
+    double start = janet_gc_clock();
+    janet_vm.gc_marking = 0;
+    janet_vm.gc_mark_phase = 1;
+    depth = JANET_RECURSION_GUARD;
+    for (size_t j = 0; j < janet_vm.gc_remembered_count; j++) {
+        janet_vm.gc_remembered[j]->flags &= ~(JANET_MEM_REACHABLE | JANET_MEM_REMEMBERED);
+    }
+    for (size_t j = 0; j < janet_vm.gc_remembered_count; j++) {
+        janet_mark_block(janet_vm.gc_remembered[j]);
+    }
+    janet_vm.gc_remembered_count = 0;
+    janet_gc_mark_roots();
+    janet_gc_drain(0);
+    janet_vm.gc_mark_phase = 0;
+    double sweep_start = janet_gc_clock();
+    janet_vm.gc_stats.last.mark_time += sweep_start - start;
+    janet_gc_sweep_and_record(sweep_start);
+    janet_vm.gc_major_due = 0;
+    janet_vm.next_collection = 0;
+    janet_free_all_scratch();
+    if (janet_vm.gc_hook) janet_vm.gc_hook(&janet_vm.gc_stats);
+}
+
+/* Start an incremental mark cycle by shading the roots */
+static void janet_gc_begin_mark(void) {
+    memset(&janet_vm.gc_stats.last, 0, sizeof(janet_vm.gc_stats.last));
+    janet_gc_adjust_interval();
+    janet_vm.gc_marking = 1;
+    janet_vm.gc_mark_phase = 1;
+    depth = 0;
+    janet_gc_mark_roots();
+    janet_vm.gc_mark_phase = 0;
+}
+
+void janet_gc_step(void) {
+    if (janet_vm.gc_suspend) return;
+    double start = janet_gc_clock();
+    if (!janet_vm.gc_marking) janet_gc_begin_mark();
+    janet_vm.gc_mark_phase = 1;
+    depth = 0;
+    int done = janet_gc_drain(janet_vm.gc_pause_budget);
+    janet_vm.gc_mark_phase = 0;
+    janet_vm.gc_stats.last.mark_time += janet_gc_clock() - start;
+    if (done) {
+        janet_gc_finish_mark();
+    } else {
+        /* Run the next slice after a fraction of the interval is allocated */
+        janet_vm.next_collection = janet_vm.gc_interval - janet_vm.gc_interval / 8;
+    }
+}
+
+/* Abandon an incremental mark cycle */
+static void janet_gc_abort_mark(void) {
+    janet_vm.gc_marking = 0;
+    janet_vm.gc_gray_count = 0;
+    janet_gc_forget(0);
+    janet_gc_clear_marks();
+#ifdef JANET_EV
+    JanetKV *items = janet_vm.threaded_abstracts.data;
+    for (int32_t i = 0; i < janet_vm.threaded_abstracts.capacity; i++) {
+        if (janet_checktype(items[i].key, JANET_ABSTRACT)) {
+            items[i].value = janet_wrap_false();
+        }
+    }
+#endif
+}
+
+/* Run garbage collection */
+void janet_collect(void) {
+    if (janet_vm.gc_suspend) return;
+    if (janet_vm.gc_mode == JANET_GC_MODE_INCREMENTAL) {
+        if (janet_vm.gc_major_due) {
+            /* Complete collection requested. Restart any cycle in progress from the
+             * current roots, or blocks dropped since it began would survive. */
+            if (janet_vm.gc_marking) janet_gc_abort_mark();
+            janet_gc_begin_mark();
+            janet_gc_finish_mark();
+        } else {
+            janet_gc_step();
+        }
+        return;
+    }
+    double start = janet_gc_clock();
+    memset(&janet_vm.gc_stats.last, 0, sizeof(janet_vm.gc_stats.last));
+    depth = JANET_RECURSION_GUARD;
+    int generational = janet_vm.gc_mode == JANET_GC_MODE_GENERATIONAL;
+    minor_cycle = generational && !janet_vm.gc_major_due;
+    if (!minor_cycle) {
+        janet_gc_adjust_interval();
+        if (generational) {
+            /* Major collection - every block is young again */
+            janet_gc_forget(0);
+            janet_gc_clear_marks();
+        }
+    } else {
+        /* Remembered blocks are old, so unmark them to trace through them */
+        for (size_t j = 0; j < janet_vm.gc_remembered_count; j++) {
+            janet_vm.gc_remembered[j]->flags &= ~JANET_MEM_REACHABLE;
+        }
+    }
+    janet_vm.gc_mark_phase = 1;
+#ifdef JANET_GC_THREADS
+    /* Leave everything past the roots on the gray stack for the mark threads */
+    int parallel = !minor_cycle && janet_vm.block_count >= JANET_GC_PARALLEL_MIN_BLOCKS;
+    if (parallel) depth = 0;
+#endif
+    janet_gc_mark_roots();
+    if (minor_cycle) {
+        for (size_t j = 0; j < janet_vm.gc_remembered_count; j++) {
+            janet_mark_block(janet_vm.gc_remembered[j]);
+        }
+        janet_gc_forget(1);
+    }
+#ifdef JANET_GC_THREADS
+    if (parallel) {
+        janet_gc_parallel_drain();
+        depth = JANET_RECURSION_GUARD;
+    }
+#endif
+    janet_gc_drain(0);
+    janet_vm.gc_mark_phase = 0;
+    double sweep_start = janet_gc_clock();
+    janet_vm.gc_stats.last.mark_time = sweep_start - start;
+    janet_gc_sweep_and_record(sweep_start);
+    if (generational) {
+        if (minor_cycle) {
+            /* Schedule a major collection once the old generation has doubled */
+            if (janet_vm.block_count > 2 * janet_vm.gc_major_blocks) {
+                janet_vm.gc_major_due = 1;
+            }
+        } else {
+            janet_vm.gc_major_blocks = janet_vm.block_count;
+            janet_vm.gc_major_due = 0;
+        }
+    }
+    minor_cycle = 0;
     janet_vm.next_collection = 0;
     janet_free_all_scratch();
+    if (janet_vm.gc_hook) janet_vm.gc_hook(&janet_vm.gc_stats);
+}
+
+/* Switch between collection strategies */
+void janet_gcsetmode(JanetGCMode mode) {
+    if (janet_vm.gc_mode == (int) mode) return;
+    if (janet_vm.gc_marking) {
+        janet_gc_abort_mark();
+    } else if (janet_vm.gc_mode == JANET_GC_MODE_GENERATIONAL) {
+        /* Old blocks keep their mark bit, which full collections don't expect */
+        janet_gc_forget(0);
+        janet_gc_clear_marks();
+    }
+    janet_vm.gc_mode = mode;
+    janet_vm.gc_old_blocks = NULL;
+    janet_vm.gc_major_due = 1;
+}
+
+JanetGCMode janet_gcmode(void) {
+    return (JanetGCMode) janet_vm.gc_mode;
+}
+
+const JanetGCStats *janet_gcstats(void) {
+    return &janet_vm.gc_stats;
+}
+
+/* Set a function to call after each completed collection. Returns the previous hook. */
+JanetGCHook janet_gcsethook(JanetGCHook hook) {
+    JanetGCHook old = janet_vm.gc_hook;
+    janet_vm.gc_hook = hook;
+    return old;
 }
 
 /* Add a root value to the GC. This prevents the GC from removing a value
@@ -699,8 +1842,23 @@ void janet_clear_memory(void) {
         current = next;
     }
     janet_vm.blocks = NULL;
+#ifdef JANET_GC_SLAB
+    janet_slab_clear();
+#endif
     janet_free_all_scratch();
     janet_free(janet_vm.scratch_mem);
+    janet_free(janet_vm.gc_remembered);
+    janet_vm.gc_remembered = NULL;
+    janet_vm.gc_remembered_count = 0;
+    janet_vm.gc_remembered_capacity = 0;
+    janet_free(janet_vm.gc_gray);
+    janet_vm.gc_gray = NULL;
+#ifdef JANET_GC_THREADS
+    janet_gc_pool_deinit();
+#endif
+    janet_vm.gc_gray_count = 0;
+    janet_vm.gc_gray_capacity = 0;
+    janet_vm.gc_marking = 0;
 }
 
 /* Primitives for suspending GC. */
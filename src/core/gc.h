@@ -34,6 +34,10 @@
 #define JANET_MEM_TYPEBITS 0xFF
 #define JANET_MEM_REACHABLE 0x100
 #define JANET_MEM_DISABLED 0x200
+#define JANET_MEM_SLAB_FREE 0x400
+#define JANET_MEM_REMEMBERED 0x800
+#define JANET_MEM_FROZEN 0x1000
+#define JANET_MEM_SAMPLED 0x2000
 
 #define janet_gc_settype(m, t) ((janet_gc_header(m)->flags |= (0xFF & (t))))
 #define janet_gc_type(m) (janet_gc_header(m)->flags & 0xFF)
@@ -41,6 +45,15 @@
 #define janet_gc_mark(m) (janet_gc_header(m)->flags |= JANET_MEM_REACHABLE)
 #define janet_gc_reachable(m) (janet_gc_header(m)->flags & JANET_MEM_REACHABLE)
 
+/* Write barrier for generational and incremental collection. Old blocks keep
+ * their mark bit between collections, and black blocks keep it between
+ * incremental mark slices, so storing a reference into a marked block that is
+ * not yet remembered must add it to the remembered set, or turn it gray again. */
+#define janet_gc_barrier(m) do { \
+    if ((janet_gc_header(m)->flags & (JANET_MEM_REACHABLE | JANET_MEM_REMEMBERED)) == JANET_MEM_REACHABLE) \
+        janet_gc_remember(janet_gc_header(m)); \
+} while (0)
+
 /* Memory types for the GC. Different from JanetType to include funcenv and funcdef. */
 enum JanetMemoryType {
     JANET_MEMORY_NONE,
@@ -61,10 +74,20 @@ enum JanetMemoryType {
     JANET_MEMORY_TABLE_WEAKV,
     JANET_MEMORY_TABLE_WEAKKV,
     JANET_MEMORY_ARRAY_WEAK
+    /* Keep JANET_GC_MEMORY_TYPES in sync when adding types */
 };
 
 /* To allocate collectable memory, one must call janet_alloc, initialize the memory,
  * and then call when janet_enablegc when it is initialized and reachable by the gc (on the JANET stack) */
 void *janet_gcalloc(enum JanetMemoryType type, size_t size);
 
+/* Smallest interval used when the interval is set from the live heap size */
+#define JANET_GC_MIN_INTERVAL 0x40000
+
+/* Slow path of the write barrier */
+void janet_gc_remember(JanetGCObject *mem);
+
+/* Run a bounded slice of an incremental mark cycle */
+void janet_gc_step(void);
+
 #endif
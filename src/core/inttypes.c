@@ -31,6 +31,7 @@
 #include <limits.h>
 #include <inttypes.h>
 #include <math.h>
+#include <string.h>
 
 /* Conditional compilation */
 #ifdef JANET_INT_TYPES
@@ -585,6 +586,56 @@ OPMETHOD(uint64_t, u64, rshift, >>)
 #undef DIVMETHOD_SIGNED
 #undef COMPMETHOD
 
+/* Run the + - * & | ^ << and >> methods (op is the first character) of an
+ * int/s64 or int/u64 directly, for the VM. Picks the type the same way as
+ * method dispatch would: the left operand's type, or the right operand's if
+ * the left is a number and the method has a reversed version. Shift counts
+ * are taken modulo 64. Returns 0 if the method would not be one of these. */
+int janet_int64_binop(int op, Janet lhs, Janet rhs, Janet *out) {
+    const JanetAbstractType *at;
+    if (NULL == strchr("+-*&|^<>", op)) return 0;
+    if (janet_checktype(lhs, JANET_ABSTRACT)) {
+        at = janet_abstract_type(janet_unwrap_abstract(lhs));
+    } else if (janet_checktype(lhs, JANET_NUMBER) && janet_checktype(rhs, JANET_ABSTRACT) && op != '<' && op != '>') {
+        at = janet_abstract_type(janet_unwrap_abstract(rhs));
+    } else {
+        return 0;
+    }
+    if (at != &janet_s64_type && at != &janet_u64_type) return 0;
+    int s64 = at == &janet_s64_type;
+    uint64_t x = s64 ? (uint64_t) janet_unwrap_s64(lhs) : janet_unwrap_u64(lhs);
+    uint64_t y = s64 ? (uint64_t) janet_unwrap_s64(rhs) : janet_unwrap_u64(rhs);
+    switch (op) {
+        default:
+        case '+':
+            x += y;
+            break;
+        case '-':
+            x -= y;
+            break;
+        case '*':
+            x *= y;
+            break;
+        case '&':
+            x &= y;
+            break;
+        case '|':
+            x |= y;
+            break;
+        case '^':
+            x ^= y;
+            break;
+        case '<':
+            x <<= (y & 63);
+            break;
+        case '>':
+            x = s64 ? (uint64_t)((int64_t) x >> (y & 63)) : x >> (y & 63);
+            break;
+    }
+    *out = s64 ? janet_wrap_s64((int64_t) x) : janet_wrap_u64(x);
+    return 1;
+}
+
 static JanetMethod it_s64_methods[] = {
     {"+", cfun_it_s64_add},
     {"r+", cfun_it_s64_add},
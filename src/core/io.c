@@ -34,6 +34,14 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#ifdef JANET_MMAP
+#include <sys/mman.h>
+#endif
+#else
+#ifdef JANET_MMAP
+#include <windows.h>
+#include <io.h>
+#endif
 #endif
 
 static int cfun_io_gc(void *p, size_t len);
@@ -795,6 +803,295 @@ FILE *janet_unwrapfile(Janet j, int32_t *flags) {
     return iof->file;
 }
 
+#ifdef JANET_MMAP
+
+/*
+ * Memory mapped files. A mapping is a read-only byte sequence, so functions
+ * that take bytes read the file through the page cache without copying it onto
+ * the heap. Byte views are limited to 2GB, so larger files are mapped in
+ * windows with an offset and length.
+ */
+
+typedef struct {
+    const uint8_t *data; /* first byte of the view */
+    int32_t len;
+    void *base; /* start of the mapping, aligned to a page */
+    size_t base_len;
+    int pinned; /* values from a zero-copy unmarshal point into the mapping */
+    int released; /* the file was dropped by file/munmap */
+} JanetMMap;
+
+static void janet_mmap_unmap(JanetMMap *map) {
+    if (NULL == map->base) return;
+#ifdef JANET_WINDOWS
+    UnmapViewOfFile(map->base);
+#else
+    munmap(map->base, map->base_len);
+#endif
+    map->base = NULL;
+    map->data = NULL;
+    map->len = 0;
+}
+
+/* Drop the file from a mapping before it is collected. Byte views taken from the
+ * mapping may still be in use, for example by a pending write or by the function
+ * that called back into file/munmap, so the address range stays readable until
+ * the mapping is garbage collected. */
+static void janet_mmap_release(JanetMMap *map) {
+    if (NULL == map->base || map->released) return;
+#ifndef JANET_WINDOWS
+    /* Replace the file pages with zero pages in place */
+#ifdef MAP_ANONYMOUS
+    void *zeros = mmap(map->base, map->base_len, PROT_READ, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#else
+    void *zeros = mmap(map->base, map->base_len, PROT_READ, MAP_FIXED | MAP_PRIVATE | MAP_ANON, -1, 0);
+#endif
+    if (zeros == MAP_FAILED) janet_panicf("cannot release mapping: %s", janet_strerror(errno));
+#endif
+    /* On windows a view cannot be replaced in place, so the file stays mapped until collected */
+    map->released = 1;
+    map->len = 0;
+}
+
+static int janet_mmap_gc(void *p, size_t len) {
+    (void) len;
+    janet_mmap_unmap((JanetMMap *) p);
+    return 0;
+}
+
+static int janet_mmap_get(void *p, Janet key, Janet *out);
+static Janet janet_mmap_next(void *p, Janet key);
+
+static size_t janet_mmap_length(void *p, size_t len) {
+    (void) len;
+    return (size_t)((JanetMMap *) p)->len;
+}
+
+static JanetByteView janet_mmap_bytes(void *p, size_t len) {
+    (void) len;
+    JanetMMap *map = (JanetMMap *) p;
+    JanetByteView view;
+    view.bytes = (map->data && !map->released) ? map->data : (const uint8_t *) "";
+    view.len = map->len;
+    return view;
+}
+
+const JanetAbstractType janet_mmap_type = {
+    "core/mmap",
+    janet_mmap_gc,
+    NULL,
+    janet_mmap_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    janet_mmap_next,
+    NULL,
+    janet_mmap_length,
+    janet_mmap_bytes,
+    JANET_ATEND_BYTES
+};
+
+JANET_CORE_FN(cfun_io_mmap,
+              "(file/mmap file &opt offset length)",
+              "Map a file into memory read-only. `file` is a path or a core/file. Returns a core/mmap, "
+              "which works like a read-only byte sequence with functions such as `peg/match`, `string/find`, "
+              "`slice`, `unmarshal`, `get` and `length`, without reading the file onto the heap. Maps "
+              "`length` bytes starting at `offset`, by default the rest of the file. A single mapping can be "
+              "at most 2GB, so map larger files in windows. The mapping is released when the core/mmap "
+              "is garbage collected, or with `(:close m)`. Changing the size of the file while it is mapped "
+              "can crash the program.") {
+    janet_arity(argc, 1, 3);
+    int64_t offset = argc > 1 ? janet_getinteger64(argv, 1) : 0;
+    if (offset < 0) janet_panicf("expected non-negative offset, got %v", argv[1]);
+#ifdef JANET_WINDOWS
+    HANDLE handle;
+    int owned = 0;
+    if (janet_checkabstract(argv[0], &janet_file_type)) {
+        JanetFile *iof = janet_unwrap_abstract(argv[0]);
+        if (iof->flags & JANET_FILE_CLOSED) janet_panic("file is closed");
+        handle = (HANDLE) _get_osfhandle(_fileno(iof->file));
+    } else {
+        janet_sandbox_assert(JANET_SANDBOX_FS_READ);
+        const char *path = janet_getcstring(argv, 0);
+        handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle == INVALID_HANDLE_VALUE) janet_panicf("cannot open %s", path);
+        owned = 1;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        if (owned) CloseHandle(handle);
+        janet_panic("cannot get file size");
+    }
+    int64_t file_size = (int64_t) size.QuadPart;
+#else
+    int fd;
+    int owned = 0;
+    if (janet_checkabstract(argv[0], &janet_file_type)) {
+        JanetFile *iof = janet_unwrap_abstract(argv[0]);
+        if (iof->flags & JANET_FILE_CLOSED) janet_panic("file is closed");
+        fd = fileno(iof->file);
+    } else {
+        janet_sandbox_assert(JANET_SANDBOX_FS_READ);
+        const char *path = janet_getcstring(argv, 0);
+        do {
+#ifdef O_CLOEXEC
+            fd = open(path, O_RDONLY | O_CLOEXEC);
+#else
+            fd = open(path, O_RDONLY);
+#endif
+        } while (fd == -1 && errno == EINTR);
+        if (fd == -1) janet_panicf("cannot open %s: %s", path, janet_strerror(errno));
+        owned = 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st)) {
+        if (owned) close(fd);
+        janet_panicf("cannot get file size: %s", janet_strerror(errno));
+    }
+    int64_t file_size = (int64_t) st.st_size;
+#endif
+    int64_t length = argc > 2 ? janet_getinteger64(argv, 2) : file_size - offset;
+    const char *err = NULL;
+    if (offset > file_size) {
+        err = "offset is past the end of the file";
+    } else if (length < 0 || length > file_size - offset) {
+        err = "length is out of range";
+    } else if (length > INT32_MAX) {
+        err = "mapping is larger than 2GB, map the file in windows";
+    }
+    JanetMMap *map = NULL;
+    if (NULL == err) {
+        map = janet_abstract(&janet_mmap_type, sizeof(JanetMMap));
+        memset(map, 0, sizeof(JanetMMap));
+    }
+    if (NULL == err && length > 0) {
+#ifdef JANET_WINDOWS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        int64_t skip = offset % (int64_t) info.dwAllocationGranularity;
+        uint64_t start = (uint64_t)(offset - skip);
+        HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        void *base = NULL;
+        if (NULL != mapping) {
+            base = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD) start,
+                                 (SIZE_T)(length + skip));
+            CloseHandle(mapping);
+        }
+        if (NULL == base) err = "cannot map file";
+#else
+        int64_t skip = offset % (int64_t) sysconf(_SC_PAGESIZE);
+        void *base = mmap(NULL, (size_t)(length + skip), PROT_READ, MAP_SHARED, fd, (off_t)(offset - skip));
+        if (base == MAP_FAILED) {
+            base = NULL;
+            err = janet_strerror(errno);
+        }
+#endif
+        if (NULL != base) {
+            map->base = base;
+            map->base_len = (size_t)(length + skip);
+            map->data = (const uint8_t *) base + skip;
+            map->len = (int32_t) length;
+        }
+    }
+#ifdef JANET_WINDOWS
+    if (owned) CloseHandle(handle);
+#else
+    if (owned) close(fd);
+#endif
+    if (NULL != err) janet_panicf("cannot map file: %s", err);
+    return janet_wrap_abstract(map);
+}
+
+/* Keep a mapping alive and in place for the rest of the program */
+void janet_mmap_pin(Janet x) {
+    JanetMMap *map = janet_unwrap_abstract(x);
+    if (!map->pinned) {
+        map->pinned = 1;
+        janet_gcroot(x);
+    }
+}
+
+JANET_CORE_FN(cfun_io_madvise,
+              "(file/madvise m advice)",
+              "Tell the operating system how a core/mmap from `file/mmap` will be read, so it can read ahead "
+              "or drop pages. `advice` is one of :normal, :sequential, :random, :willneed or :dontneed. "
+              "This is only a hint, and does nothing on Windows. Returns `m`.") {
+    janet_fixarity(argc, 2);
+    JanetMMap *map = janet_getabstract(argv, 0, &janet_mmap_type);
+    JanetKeyword advice = janet_getkeyword(argv, 1);
+#ifdef JANET_WINDOWS
+    (void) map;
+    if (janet_cstrcmp(advice, "normal") && janet_cstrcmp(advice, "sequential") &&
+            janet_cstrcmp(advice, "random") && janet_cstrcmp(advice, "willneed") &&
+            janet_cstrcmp(advice, "dontneed")) {
+        janet_panicf("unknown advice %v", argv[1]);
+    }
+#else
+    int flag;
+    if (!janet_cstrcmp(advice, "normal")) {
+        flag = POSIX_MADV_NORMAL;
+    } else if (!janet_cstrcmp(advice, "sequential")) {
+        flag = POSIX_MADV_SEQUENTIAL;
+    } else if (!janet_cstrcmp(advice, "random")) {
+        flag = POSIX_MADV_RANDOM;
+    } else if (!janet_cstrcmp(advice, "willneed")) {
+        flag = POSIX_MADV_WILLNEED;
+    } else if (!janet_cstrcmp(advice, "dontneed")) {
+        flag = POSIX_MADV_DONTNEED;
+    } else {
+        janet_panicf("unknown advice %v", argv[1]);
+    }
+    if (NULL != map->base) {
+        int status = posix_madvise(map->base, map->base_len, flag);
+        if (status) janet_panicf("madvise failed: %s", janet_strerror(status));
+    }
+#endif
+    return argv[0];
+}
+
+JANET_CORE_FN(cfun_io_munmap,
+              "(file/munmap m)",
+              "Release the file of a core/mmap from `file/mmap` before it is garbage collected. Afterwards `m` "
+              "is an empty byte sequence. Byte sequences made from `m` earlier are copies and stay valid. "
+              "Operations still reading `m`, such as a pending write, see zero bytes, and the address space "
+              "is only freed when `m` is garbage collected. On windows the file stays mapped until then. "
+              "A mapping that `unmarshal` has loaded values from in place cannot be released. Returns nil.") {
+    janet_fixarity(argc, 1);
+    JanetMMap *map = janet_getabstract(argv, 0, &janet_mmap_type);
+    if (map->pinned) janet_panic("mapping is in use by unmarshalled values");
+    janet_mmap_release(map);
+    return janet_wrap_nil();
+}
+
+static JanetMethod janet_mmap_methods[] = {
+    {"close", cfun_io_munmap},
+    {"advise", cfun_io_madvise},
+    {NULL, NULL}
+};
+
+static int janet_mmap_get(void *p, Janet key, Janet *out) {
+    JanetMMap *map = (JanetMMap *) p;
+    if (janet_checktype(key, JANET_KEYWORD)) {
+        return janet_getmethod(janet_unwrap_keyword(key), janet_mmap_methods, out);
+    }
+    if (!janet_checkint(key)) return 0;
+    int32_t index = janet_unwrap_integer(key);
+    if (index < 0 || index >= map->len) return 0;
+    *out = janet_wrap_integer(map->data[index]);
+    return 1;
+}
+
+static Janet janet_mmap_next(void *p, Janet key) {
+    (void) p;
+    return janet_nextmethod(janet_mmap_methods, key);
+}
+
+#endif
+
 /* Module entry point */
 void janet_lib_io(JanetTable *env) {
     JanetRegExt io_cfuns[] = {
@@ -820,10 +1117,18 @@ void janet_lib_io(JanetTable *env) {
         JANET_CORE_REG("file/flush", cfun_io_fflush),
         JANET_CORE_REG("file/seek", cfun_io_fseek),
         JANET_CORE_REG("file/tell", cfun_io_ftell),
+#ifdef JANET_MMAP
+        JANET_CORE_REG("file/mmap", cfun_io_mmap),
+        JANET_CORE_REG("file/madvise", cfun_io_madvise),
+        JANET_CORE_REG("file/munmap", cfun_io_munmap),
+#endif
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, io_cfuns);
     janet_register_abstract_type(&janet_file_type);
+#ifdef JANET_MMAP
+    janet_register_abstract_type(&janet_mmap_type);
+#endif
     int default_flags = JANET_FILE_NOT_CLOSEABLE | JANET_FILE_SERIALIZABLE;
     /* stdout */
     JANET_CORE_DEF(env, "stdout",
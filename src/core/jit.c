@@ -0,0 +1,634 @@
+/*
+* Copyright (c) 2025 Calvin Rose
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef JANET_AMALG
+#include "features.h"
+#include <janet.h>
+#include "fiber.h"
+#include "state.h"
+#include "util.h"
+#include "vector.h"
+#include <stddef.h>
+#endif
+
+#ifdef JANET_JIT
+
+/* A baseline JIT that translates the bytecode of hot funcdefs into x86-64 machine
+ * code, one instruction at a time. The generated code works directly on the slots of
+ * the current stack frame, so it can hand control back to the interpreter before any
+ * instruction. It does this for instructions it does not understand, when an operand
+ * is not a number on a fast path, and when the interpreter should be interrupted on
+ * a backwards jump. The generated function returns the pc at which the interpreter
+ * should resume.
+ *
+ *   uint32_t *jitted(JanetFiber *fiber, volatile JanetAtomicInt *suspend);
+ *
+ * Registers used: rbx holds the stack frame, r12 the suspend flag, r13 the fiber.
+ * rax, rcx, rdx, xmm0, and xmm1 are scratch. */
+
+#define JIT_RAX 0
+#define JIT_RCX 1
+#define JIT_RDX 2
+#define JIT_RSI 6
+#define JIT_RDI 7
+
+/* Condition codes for jcc */
+#define JIT_ALWAYS 0
+#define JIT_JE 0x84
+#define JIT_JNE 0x85
+
+typedef struct {
+    int32_t at; /* Offset of the rel32 to patch */
+    int32_t index; /* Instruction index to jump to */
+    int exit; /* Jump to an exit for the instruction instead of its code */
+} JanetJitFixup;
+
+typedef struct {
+    JanetFuncDef *def;
+    uint8_t *code;
+    JanetJitFixup *fixups;
+    int32_t *labels;
+    int32_t loops; /* Number of compiled backwards jumps */
+} JanetJit;
+
+#define jit_here(j) ((int32_t) janet_v_count((j)->code))
+#define JIT(...) do { \
+    static const uint8_t _bytes[] = {__VA_ARGS__}; \
+    jit_bytes(j, _bytes, sizeof(_bytes)); \
+} while (0)
+
+static void jit_bytes(JanetJit *j, const uint8_t *bytes, size_t n) {
+    for (size_t i = 0; i < n; i++) janet_v_push(j->code, bytes[i]);
+}
+
+static void jit_byte(JanetJit *j, uint8_t b) {
+    janet_v_push(j->code, b);
+}
+
+static void jit_u32(JanetJit *j, uint32_t x) {
+    for (int i = 0; i < 4; i++) janet_v_push(j->code, (uint8_t)(x >> (8 * i)));
+}
+
+static void jit_u64(JanetJit *j, uint64_t x) {
+    for (int i = 0; i < 8; i++) janet_v_push(j->code, (uint8_t)(x >> (8 * i)));
+}
+
+static void jit_patch(JanetJit *j, int32_t at, int32_t dest) {
+    uint32_t rel = (uint32_t)(dest - (at + 4));
+    for (int i = 0; i < 4; i++) j->code[at + i] = (uint8_t)(rel >> (8 * i));
+}
+
+/* Emit a jump with a rel32 to be patched later. Returns the offset of the rel32. */
+static int32_t jit_jcc(JanetJit *j, uint8_t cc) {
+    if (cc == JIT_ALWAYS) {
+        jit_byte(j, 0xE9);
+    } else {
+        jit_byte(j, 0x0F);
+        jit_byte(j, cc);
+    }
+    int32_t at = jit_here(j);
+    jit_u32(j, 0);
+    return at;
+}
+
+static void jit_jcc_to(JanetJit *j, uint8_t cc, int32_t index, int exit) {
+    JanetJitFixup fixup;
+    fixup.at = jit_jcc(j, cc);
+    fixup.index = index;
+    fixup.exit = exit;
+    janet_v_push(j->fixups, fixup);
+}
+
+/* mov reg, [rbx + 8 * slot] */
+static void jit_load(JanetJit *j, int reg, int32_t slot) {
+    JIT(0x48, 0x8B);
+    jit_byte(j, (uint8_t)(0x83 | (reg << 3)));
+    jit_u32(j, (uint32_t) slot * sizeof(Janet));
+}
+
+/* mov [rbx + 8 * slot], rax */
+static void jit_store(JanetJit *j, int32_t slot) {
+    JIT(0x48, 0x89, 0x83);
+    jit_u32(j, (uint32_t) slot * sizeof(Janet));
+}
+
+/* mov reg, imm64 */
+static void jit_imm(JanetJit *j, int reg, uint64_t x) {
+    jit_byte(j, 0x48);
+    jit_byte(j, (uint8_t)(0xB8 + reg));
+    jit_u64(j, x);
+}
+
+/* movq xmm, rax */
+static void jit_xmm_from_rax(JanetJit *j, int xmm) {
+    JIT(0x66, 0x48, 0x0F, 0x6E);
+    jit_byte(j, (uint8_t)(0xC0 | (xmm << 3)));
+}
+
+/* Recompute rbx from the fiber */
+static void jit_reload_stack(JanetJit *j) {
+    /* mov rcx, [r13 + data] */
+    JIT(0x49, 0x8B, 0x8D);
+    jit_u32(j, (uint32_t) offsetof(JanetFiber, data));
+    /* movsxd rdx, dword [r13 + frame] */
+    JIT(0x49, 0x63, 0x95);
+    jit_u32(j, (uint32_t) offsetof(JanetFiber, frame));
+    /* lea rbx, [rcx + rdx * 8] */
+    JIT(0x48, 0x8D, 0x1C, 0xD1);
+}
+
+/* Return to the interpreter at instruction index */
+static void jit_exit(JanetJit *j, int32_t index) {
+    jit_imm(j, JIT_RAX, (uint64_t)(uintptr_t)(j->def->bytecode + index));
+    JIT(0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3); /* pop r13; pop r12; pop rbx; ret */
+}
+
+/* Load a slot into an xmm register, exiting to the interpreter at
+ * instruction index if the slot does not hold a number. Mirrors
+ * janet_checktype(x, JANET_NUMBER). Returns the rel32 of the failing jump
+ * if index is negative, so the caller can handle it. */
+static int32_t jit_load_number(JanetJit *j, int xmm, int32_t slot, int32_t index) {
+    jit_load(j, JIT_RAX, slot);
+    jit_xmm_from_rax(j, xmm);
+    /* ucomisd xmm, xmm; jnp is_number */
+    JIT(0x66, 0x0F, 0x2E);
+    jit_byte(j, (uint8_t)(0xC0 | (xmm << 3) | xmm));
+    JIT(0x7B, 0x10);
+    /* mov rcx, rax; shr rcx, 47; test cl, 0xF */
+    JIT(0x48, 0x89, 0xC1, 0x48, 0xC1, 0xE9, 0x2F, 0xF6, 0xC1, 0x0F);
+    if (index >= 0) {
+        jit_jcc_to(j, JIT_JNE, index, 1);
+        return -1;
+    }
+    return jit_jcc(j, JIT_JNE);
+}
+
+/* Load an immediate as a double into xmm1 */
+static void jit_load_immediate(JanetJit *j, int32_t x) {
+    jit_imm(j, JIT_RAX, janet_wrap_number((double) x).u64);
+    jit_xmm_from_rax(j, 1);
+}
+
+/* Jump to instruction target from instruction index. Backwards jumps
+ * exit at index first if the interpreter has been asked to suspend. */
+static void jit_goto(JanetJit *j, int32_t index, int32_t target) {
+    if (target <= index) {
+        j->loops++;
+        /* mov eax, [r12]; test eax, eax */
+        JIT(0x41, 0x8B, 0x04, 0x24, 0x85, 0xC0);
+        jit_jcc_to(j, JIT_JNE, index, 1);
+    }
+    jit_jcc_to(j, JIT_ALWAYS, target, 0);
+}
+
+/* Conditional version of jit_goto */
+static void jit_cond_goto(JanetJit *j, uint8_t cc, int32_t index, int32_t target) {
+    if (target > index) {
+        jit_jcc_to(j, cc, target, 0);
+    } else {
+        int32_t over = jit_jcc(j, cc ^ 1);
+        jit_goto(j, index, target);
+        jit_patch(j, over, jit_here(j));
+    }
+}
+
+/* Set ZF if the slot is not truthy. Mirrors janet_truthy. */
+static void jit_truthy(JanetJit *j, int32_t slot) {
+    jit_load(j, JIT_RAX, slot);
+    jit_imm(j, JIT_RCX, JANET_NANBOX_TAGBITS);
+    JIT(0x48, 0x21, 0xC1); /* and rcx, rax */
+    jit_imm(j, JIT_RDX, janet_nanbox_tag(JANET_NIL));
+    JIT(0x48, 0x39, 0xD1); /* cmp rcx, rdx */
+    int32_t falsy1 = jit_jcc(j, JIT_JE);
+    jit_imm(j, JIT_RDX, janet_nanbox_tag(JANET_BOOLEAN));
+    JIT(0x48, 0x39, 0xD1); /* cmp rcx, rdx */
+    int32_t truthy = jit_jcc(j, JIT_JNE);
+    JIT(0xA8, 0x01); /* test al, 1 */
+    int32_t falsy2 = jit_jcc(j, JIT_JE);
+    jit_patch(j, truthy, jit_here(j));
+    JIT(0xB8, 0x01, 0x00, 0x00, 0x00, 0xEB, 0x02); /* mov eax, 1; jmp done */
+    jit_patch(j, falsy1, jit_here(j));
+    jit_patch(j, falsy2, jit_here(j));
+    JIT(0x31, 0xC0); /* xor eax, eax */
+    JIT(0x85, 0xC0); /* done: test eax, eax */
+}
+
+/* Set ZF if the slot is nil */
+static void jit_isnil(JanetJit *j, int32_t slot) {
+    jit_load(j, JIT_RAX, slot);
+    jit_imm(j, JIT_RCX, JANET_NANBOX_TAGBITS);
+    JIT(0x48, 0x21, 0xC1); /* and rcx, rax */
+    jit_imm(j, JIT_RDX, janet_nanbox_tag(JANET_NIL));
+    JIT(0x48, 0x39, 0xD1); /* cmp rcx, rdx */
+}
+
+/* Store al as a boolean into a slot. If the next instruction is a jmpno on that same
+ * slot, also do the branch here so the fused pair runs as one compare and branch. */
+static int jit_boolean(JanetJit *j, int32_t index, int32_t slot) {
+    JIT(0x0F, 0xB6, 0xC0); /* movzx eax, al */
+    jit_imm(j, JIT_RCX, janet_wrap_false().u64);
+    JIT(0x48, 0x09, 0xC8); /* or rax, rcx */
+    jit_store(j, slot);
+    if (index + 2 < j->def->bytecode_length) {
+        uint32_t next = j->def->bytecode[index + 1];
+        if ((next & 0xFF) == JOP_JUMP_IF_NOT && (int32_t)((next >> 8) & 0xFF) == slot) {
+            int32_t target = index + 1 + (((int32_t) next) >> 16);
+            JIT(0xA8, 0x01); /* test al, 1 */
+            jit_cond_goto(j, JIT_JE, index + 1, target);
+            jit_jcc_to(j, JIT_ALWAYS, index + 2, 0);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Save the pc so that errors raised by a helper report the right location */
+static void jit_commit(JanetJit *j, int32_t index) {
+    jit_imm(j, JIT_RAX, (uint64_t)(uintptr_t)(j->def->bytecode + index));
+    JIT(0x48, 0x89, 0x83);
+    jit_u32(j, (uint32_t)(offsetof(JanetStackFrame, pc) - JANET_FRAME_SIZE * sizeof(Janet)));
+}
+
+/* Call a helper, then reload the stack in case it was reallocated */
+static void jit_call(JanetJit *j, void *fn) {
+    jit_imm(j, JIT_RAX, (uint64_t)(uintptr_t) fn);
+    JIT(0xFF, 0xD0); /* call rax */
+    jit_reload_stack(j);
+}
+
+/* Helpers for instructions that are not worth inlining */
+
+static uint64_t janet_jit_in(uint64_t ds, uint64_t key) {
+    return janet_in(janet_nanbox_from_bits(ds), janet_nanbox_from_bits(key)).u64;
+}
+
+static uint64_t janet_jit_get(uint64_t ds, uint64_t key) {
+    return janet_get(janet_nanbox_from_bits(ds), janet_nanbox_from_bits(key)).u64;
+}
+
+static uint64_t janet_jit_getindex(uint64_t ds, int32_t index) {
+    return janet_getindex(janet_nanbox_from_bits(ds), index).u64;
+}
+
+static uint64_t janet_jit_length(uint64_t x) {
+    return janet_lengthv(janet_nanbox_from_bits(x)).u64;
+}
+
+static int janet_jit_equals(uint64_t x, uint64_t y) {
+    return janet_equals(janet_nanbox_from_bits(x), janet_nanbox_from_bits(y));
+}
+
+/* Get how far a switch moves the pc, see vm_switch_offset */
+static int32_t janet_jit_switch(uint64_t st, uint64_t x) {
+    Janet index = janet_struct_get(janet_unwrap_struct(janet_nanbox_from_bits(st)), janet_nanbox_from_bits(x));
+    return janet_checktype(index, JANET_NIL) ? 1 : 2 + janet_unwrap_integer(index);
+}
+
+/* Superinstructions are compiled as their first half, followed by
+ * the second instruction which always comes right after. */
+static uint32_t jit_unfuse(uint32_t op) {
+    switch (op) {
+        default:
+            return op;
+        case JOP_LESS_THAN_JUMP_IF_NOT:
+            return JOP_LESS_THAN;
+        case JOP_LESS_THAN_EQUAL_JUMP_IF_NOT:
+            return JOP_LESS_THAN_EQUAL;
+        case JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT:
+            return JOP_LESS_THAN_IMMEDIATE;
+        case JOP_GREATER_THAN_JUMP_IF_NOT:
+            return JOP_GREATER_THAN;
+        case JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT:
+            return JOP_GREATER_THAN_EQUAL;
+        case JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT:
+            return JOP_GREATER_THAN_IMMEDIATE;
+        case JOP_EQUALS_JUMP_IF_NOT:
+            return JOP_EQUALS;
+        case JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT:
+            return JOP_EQUALS_IMMEDIATE;
+        case JOP_NOT_EQUALS_JUMP_IF_NOT:
+            return JOP_NOT_EQUALS;
+        case JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT:
+            return JOP_NOT_EQUALS_IMMEDIATE;
+        case JOP_LOAD_CONSTANT_PUSH:
+            return JOP_LOAD_CONSTANT;
+        case JOP_LOAD_INTEGER_GET:
+        case JOP_LOAD_INTEGER_IN:
+            return JOP_LOAD_INTEGER;
+    }
+}
+
+/* Compile one instruction. Returns 0 if the instruction just exits to the interpreter. */
+static int jit_instruction(JanetJit *j, int32_t i) {
+    uint32_t instr = j->def->bytecode[i];
+    int32_t a = (instr >> 8) & 0xFF;
+    int32_t b = (instr >> 16) & 0xFF;
+    int32_t c = instr >> 24;
+    int32_t d = instr >> 8;
+    int32_t e = instr >> 16;
+    int32_t cs = ((int32_t) instr) >> 24;
+    int32_t ds = ((int32_t) instr) >> 8;
+    int32_t es = ((int32_t) instr) >> 16;
+
+    /* Let the interpreter handle breakpoints */
+    if (instr & 0x80) {
+        jit_exit(j, i);
+        return 0;
+    }
+
+    switch (jit_unfuse(instr & 0x7F)) {
+        default:
+            jit_exit(j, i);
+            return 0;
+        case JOP_NOOP:
+            break;
+        case JOP_LOAD_NIL:
+            jit_imm(j, JIT_RAX, janet_wrap_nil().u64);
+            jit_store(j, d);
+            break;
+        case JOP_LOAD_TRUE:
+            jit_imm(j, JIT_RAX, janet_wrap_true().u64);
+            jit_store(j, d);
+            break;
+        case JOP_LOAD_FALSE:
+            jit_imm(j, JIT_RAX, janet_wrap_false().u64);
+            jit_store(j, d);
+            break;
+        case JOP_LOAD_INTEGER:
+            jit_imm(j, JIT_RAX, janet_wrap_integer(es).u64);
+            jit_store(j, a);
+            break;
+        case JOP_LOAD_CONSTANT:
+            if (e >= j->def->constants_length) {
+                jit_exit(j, i);
+                return 0;
+            }
+            jit_imm(j, JIT_RAX, j->def->constants[e].u64);
+            jit_store(j, a);
+            break;
+        case JOP_MOVE_NEAR:
+            jit_load(j, JIT_RAX, e);
+            jit_store(j, a);
+            break;
+        case JOP_MOVE_FAR:
+            jit_load(j, JIT_RAX, a);
+            jit_store(j, e);
+            break;
+        case JOP_ADD:
+        case JOP_SUBTRACT:
+        case JOP_MULTIPLY:
+        case JOP_DIVIDE:
+        case JOP_ADD_IMMEDIATE:
+        case JOP_SUBTRACT_IMMEDIATE:
+        case JOP_MULTIPLY_IMMEDIATE:
+        case JOP_DIVIDE_IMMEDIATE: {
+            uint32_t op = instr & 0x7F;
+            uint8_t sse;
+            jit_load_number(j, 0, b, i);
+            if (op == JOP_ADD || op == JOP_SUBTRACT || op == JOP_MULTIPLY || op == JOP_DIVIDE) {
+                jit_load_number(j, 1, c, i);
+            } else {
+                jit_load_immediate(j, cs);
+            }
+            switch (op) {
+                default:
+                case JOP_ADD:
+                case JOP_ADD_IMMEDIATE:
+                    sse = 0x58;
+                    break;
+                case JOP_SUBTRACT:
+                case JOP_SUBTRACT_IMMEDIATE:
+                    sse = 0x5C;
+                    break;
+                case JOP_MULTIPLY:
+                case JOP_MULTIPLY_IMMEDIATE:
+                    sse = 0x59;
+                    break;
+                case JOP_DIVIDE:
+                case JOP_DIVIDE_IMMEDIATE:
+                    sse = 0x5E;
+                    break;
+            }
+            /* addsd/subsd/mulsd/divsd xmm0, xmm1; movq rax, xmm0 */
+            JIT(0xF2, 0x0F);
+            jit_byte(j, sse);
+            JIT(0xC1, 0x66, 0x48, 0x0F, 0x7E, 0xC0);
+            jit_store(j, a);
+            break;
+        }
+        case JOP_LESS_THAN:
+        case JOP_LESS_THAN_EQUAL:
+        case JOP_GREATER_THAN:
+        case JOP_GREATER_THAN_EQUAL:
+        case JOP_LESS_THAN_IMMEDIATE:
+        case JOP_GREATER_THAN_IMMEDIATE: {
+            uint32_t op = jit_unfuse(instr & 0x7F);
+            jit_load_number(j, 0, b, i);
+            if (op == JOP_LESS_THAN_IMMEDIATE || op == JOP_GREATER_THAN_IMMEDIATE) {
+                jit_load_immediate(j, cs);
+            } else {
+                jit_load_number(j, 1, c, i);
+            }
+            /* Unordered comparisons are false, as they are in C */
+            if (op == JOP_LESS_THAN || op == JOP_LESS_THAN_EQUAL || op == JOP_LESS_THAN_IMMEDIATE) {
+                JIT(0x66, 0x0F, 0x2E, 0xC8); /* ucomisd xmm1, xmm0 */
+            } else {
+                JIT(0x66, 0x0F, 0x2E, 0xC1); /* ucomisd xmm0, xmm1 */
+            }
+            if (op == JOP_LESS_THAN_EQUAL || op == JOP_GREATER_THAN_EQUAL) {
+                JIT(0x0F, 0x93, 0xC0); /* setae al */
+            } else {
+                JIT(0x0F, 0x97, 0xC0); /* seta al */
+            }
+            jit_boolean(j, i, a);
+            break;
+        }
+        case JOP_EQUALS:
+        case JOP_NOT_EQUALS: {
+            int eq = jit_unfuse(instr & 0x7F) == JOP_EQUALS;
+            int32_t slow1 = jit_load_number(j, 0, b, -1);
+            int32_t slow2 = jit_load_number(j, 1, c, -1);
+            JIT(0x66, 0x0F, 0x2E, 0xC1); /* ucomisd xmm0, xmm1 */
+            if (eq) {
+                JIT(0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8); /* sete al; setnp cl; and al, cl */
+            } else {
+                JIT(0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8); /* setne al; setp cl; or al, cl */
+            }
+            int32_t done = jit_jcc(j, JIT_ALWAYS);
+            jit_patch(j, slow1, jit_here(j));
+            jit_patch(j, slow2, jit_here(j));
+            jit_commit(j, i);
+            jit_load(j, JIT_RDI, b);
+            jit_load(j, JIT_RSI, c);
+            jit_call(j, (void *) janet_jit_equals);
+            if (!eq) JIT(0x34, 0x01); /* xor al, 1 */
+            jit_patch(j, done, jit_here(j));
+            jit_boolean(j, i, a);
+            break;
+        }
+        case JOP_EQUALS_IMMEDIATE:
+        case JOP_NOT_EQUALS_IMMEDIATE: {
+            int eq = jit_unfuse(instr & 0x7F) == JOP_EQUALS_IMMEDIATE;
+            int32_t notnum = jit_load_number(j, 0, b, -1);
+            jit_load_immediate(j, cs);
+            JIT(0x66, 0x0F, 0x2E, 0xC1); /* ucomisd xmm0, xmm1 */
+            if (eq) {
+                JIT(0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8); /* sete al; setnp cl; and al, cl */
+            } else {
+                JIT(0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8); /* setne al; setp cl; or al, cl */
+            }
+            JIT(0xEB, 0x02); /* jmp done */
+            jit_patch(j, notnum, jit_here(j));
+            if (eq) {
+                JIT(0xB0, 0x00); /* mov al, 0 */
+            } else {
+                JIT(0xB0, 0x01); /* mov al, 1 */
+            }
+            jit_boolean(j, i, a);
+            break;
+        }
+        case JOP_JUMP:
+            jit_goto(j, i, i + ds);
+            break;
+        case JOP_JUMP_IF:
+            jit_truthy(j, a);
+            jit_cond_goto(j, JIT_JNE, i, i + es);
+            break;
+        case JOP_JUMP_IF_NOT:
+            jit_truthy(j, a);
+            jit_cond_goto(j, JIT_JE, i, i + es);
+            break;
+        case JOP_JUMP_IF_NIL:
+            jit_isnil(j, a);
+            jit_cond_goto(j, JIT_JE, i, i + es);
+            break;
+        case JOP_JUMP_IF_NOT_NIL:
+            jit_isnil(j, a);
+            jit_cond_goto(j, JIT_JNE, i, i + es);
+            break;
+        case JOP_IN:
+        case JOP_GET:
+            jit_commit(j, i);
+            jit_load(j, JIT_RDI, b);
+            jit_load(j, JIT_RSI, c);
+            jit_call(j, (instr & 0x7F) == JOP_IN ? (void *) janet_jit_in : (void *) janet_jit_get);
+            jit_store(j, a);
+            break;
+        case JOP_SWITCH: {
+            /* Compare the offset against each jump of the table */
+            int32_t n = janet_switch_length(j->def, instr);
+            jit_imm(j, JIT_RDI, j->def->constants[e].u64);
+            jit_load(j, JIT_RSI, a);
+            jit_call(j, (void *) janet_jit_switch);
+            for (int32_t k = 1; k <= n; k++) {
+                jit_byte(j, 0x3D); /* cmp eax, imm32 */
+                jit_u32(j, (uint32_t) k);
+                jit_jcc_to(j, JIT_JE, i + k, 0);
+            }
+            jit_jcc_to(j, JIT_ALWAYS, i + n + 1, 0);
+            break;
+        }
+        case JOP_GET_INDEX:
+            jit_commit(j, i);
+            jit_load(j, JIT_RDI, b);
+            jit_byte(j, 0xBE); /* mov esi, imm32 */
+            jit_u32(j, (uint32_t) c);
+            jit_call(j, (void *) janet_jit_getindex);
+            jit_store(j, a);
+            break;
+        case JOP_LENGTH:
+            jit_commit(j, i);
+            jit_load(j, JIT_RDI, e);
+            jit_call(j, (void *) janet_jit_length);
+            jit_store(j, a);
+            break;
+    }
+    return 1;
+}
+
+/* Compile a funcdef. On failure, the funcdef is marked so that it is not tried again. */
+void janet_jit_compile(JanetFuncDef *def) {
+    JanetJit jit;
+    JanetJit *j = &jit;
+    j->def = def;
+    j->code = NULL;
+    j->fixups = NULL;
+    j->loops = 0;
+    j->labels = janet_smalloc(sizeof(int32_t) * (size_t) def->bytecode_length);
+    int32_t *exits = janet_smalloc(sizeof(int32_t) * (size_t) def->bytecode_length);
+    int useful = 0;
+
+    /* push rbx; push r12; push r13; mov r13, rdi; mov r12, rsi */
+    JIT(0x53, 0x41, 0x54, 0x41, 0x55, 0x49, 0x89, 0xFD, 0x49, 0x89, 0xF4);
+    jit_reload_stack(j);
+
+    for (int32_t i = 0; i < def->bytecode_length; i++) {
+        j->labels[i] = jit_here(j);
+        exits[i] = -1;
+        int compiled = jit_instruction(j, i);
+        if (i == 0) useful = compiled;
+    }
+
+    /* Resolve jumps, adding exits as they are needed */
+    for (int32_t k = 0; k < janet_v_count(j->fixups); k++) {
+        JanetJitFixup fixup = j->fixups[k];
+        int32_t dest;
+        if (fixup.exit) {
+            if (exits[fixup.index] < 0) {
+                exits[fixup.index] = jit_here(j);
+                jit_exit(j, fixup.index);
+            }
+            dest = exits[fixup.index];
+        } else {
+            dest = j->labels[fixup.index];
+        }
+        jit_patch(j, fixup.at, dest);
+    }
+
+    /* Only install code that can stay out of the interpreter for a while. Functions
+     * that leave straight away, such as those that start with a call, run slower
+     * with the extra entry and exit. */
+    def->jit_calls = -1;
+    if (useful && j->loops > 0) {
+        size_t size = 0;
+        void *code = janet_exec_map(j->code, (size_t) janet_v_count(j->code), &size);
+        if (NULL != code) {
+            def->jit = code;
+            def->jit_size = size;
+        }
+    }
+
+    janet_v_free(j->code);
+    janet_v_free(j->fixups);
+    janet_sfree(j->labels);
+    janet_sfree(exits);
+}
+
+void janet_jit_free(JanetFuncDef *def) {
+    if (NULL != def->jit) {
+        janet_exec_unmap(def->jit, def->jit_size);
+        def->jit = NULL;
+        def->jit_size = 0;
+    }
+}
+
+#endif
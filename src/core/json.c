@@ -0,0 +1,586 @@
+/*
+* Copyright (c) 2025 Calvin Rose & contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/* JSON encoding and decoding. Both directions spend most of their time in
+ * string contents, so the bytes that need attention in a string - quotes,
+ * backslashes and control characters - are found 16 at a time where SIMD is
+ * available. The encoder also stops at non-ASCII bytes to check that they are
+ * valid UTF-8. The decoder passes string contents through unchanged. */
+
+#ifndef JANET_AMALG
+#include "features.h"
+#include <janet.h>
+#include "util.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+/* Conditional compilation */
+#ifdef JANET_JSON
+
+#if defined(JANET_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(JANET_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Get the length of the longest prefix of bytes that can be copied as is
+ * between the quotes of a JSON string. If ascii is set, bytes outside of
+ * ASCII end the prefix as well. */
+static int32_t json_plain_span(const uint8_t *bytes, int32_t len, int ascii) {
+    int32_t i = 0;
+#if defined(JANET_SIMD_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(bytes + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(x, control), x));
+        if (ascii) hit = _mm_or_si128(hit, x);
+        if (_mm_movemask_epi8(hit)) break;
+    }
+#elif defined(JANET_SIMD_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x1F);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t x = vld1q_u8(bytes + i);
+        uint8x16_t hit = vorrq_u8(vceqq_u8(x, quote), vceqq_u8(x, backslash));
+        hit = vorrq_u8(hit, vcleq_u8(x, control));
+        if (ascii) hit = vorrq_u8(hit, vcgtq_u8(x, vdupq_n_u8(0x7F)));
+        if (vmaxvq_u8(hit)) break;
+    }
+#endif
+    for (; i < len; i++) {
+        uint8_t c = bytes[i];
+        if (c == '"' || c == '\\' || c < 0x20 || (ascii && c >= 0x80)) return i;
+    }
+    return len;
+}
+
+/*
+ * Encoding
+ */
+
+typedef struct {
+    JanetBuffer *buffer;
+    const char *tab;
+    const char *newline;
+    int pretty;
+} JsonEncoder;
+
+/* Get the length of the UTF-8 sequence at the start of bytes, or 0 if it is
+ * not a valid encoding of a code point. Surrogates and code points above
+ * U+10FFFF are not valid. */
+static int32_t json_utf8_length(const uint8_t *bytes, int32_t len) {
+    uint8_t c = bytes[0];
+    int32_t k;
+    if ((c >> 5) == 0x06) k = 2;
+    else if ((c >> 4) == 0x0E) k = 3;
+    else if (c >= 0xF0 && c <= 0xF4) k = 4;
+    else return 0;
+    if (k > len || !janet_valid_utf8(bytes, k)) return 0;
+    if (c == 0xED && bytes[1] >= 0xA0) return 0;
+    if (c == 0xF4 && bytes[1] >= 0x90) return 0;
+    return k;
+}
+
+static void json_encode_string(JanetBuffer *buffer, const uint8_t *bytes, int32_t len) {
+    janet_buffer_push_u8(buffer, '"');
+    while (len > 0) {
+        int32_t n = json_plain_span(bytes, len, 1);
+        janet_buffer_push_bytes(buffer, bytes, n);
+        if (n == len) break;
+        uint8_t c = bytes[n];
+        if (c >= 0x80) {
+            int32_t k = json_utf8_length(bytes + n, len - n);
+            if (0 == k) janet_panic("cannot encode invalid utf-8 as json");
+            janet_buffer_push_bytes(buffer, bytes + n, k);
+            bytes += n + k;
+            len -= n + k;
+            continue;
+        }
+        switch (c) {
+            case '"':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\\"", 2);
+                break;
+            case '\\':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\\\", 2);
+                break;
+            case '\b':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\b", 2);
+                break;
+            case '\f':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\f", 2);
+                break;
+            case '\n':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\n", 2);
+                break;
+            case '\r':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\r", 2);
+                break;
+            case '\t':
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "\\t", 2);
+                break;
+            default: {
+                uint8_t esc[6] = {'\\', 'u', '0', '0', 0, 0};
+                esc[4] = (uint8_t) janet_base64[c >> 4];
+                esc[5] = (uint8_t) janet_base64[c & 0xF];
+                janet_buffer_push_bytes(buffer, esc, 6);
+                break;
+            }
+        }
+        bytes += n + 1;
+        len -= n + 1;
+    }
+    janet_buffer_push_u8(buffer, '"');
+}
+
+/* Print the shortest decimal that reads back as the same number */
+static void json_encode_number(JanetBuffer *buffer, double x) {
+    if (isnan(x) || isinf(x)) {
+        janet_panicf("cannot encode %f as json", x);
+    }
+    janet_buffer_extra(buffer, JANET_DTOA_SIZE);
+    buffer->count += janet_dtoa(x == 0.0 ? 0.0 : x, buffer->data + buffer->count);
+}
+
+static void json_newline(JsonEncoder *e, int depth) {
+    if (!e->pretty) return;
+    janet_buffer_push_cstring(e->buffer, e->newline);
+    for (int i = 0; i < depth; i++) {
+        janet_buffer_push_cstring(e->buffer, e->tab);
+    }
+}
+
+static void json_encode_one(JsonEncoder *e, Janet x, int depth) {
+    if (depth > JANET_RECURSION_GUARD) {
+        janet_panic("recursed too deeply");
+    }
+    JanetBuffer *buffer = e->buffer;
+    switch (janet_type(x)) {
+        case JANET_NIL:
+            janet_buffer_push_bytes(buffer, (const uint8_t *) "null", 4);
+            break;
+        case JANET_BOOLEAN:
+            if (janet_unwrap_boolean(x)) {
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "true", 4);
+            } else {
+                janet_buffer_push_bytes(buffer, (const uint8_t *) "false", 5);
+            }
+            break;
+        case JANET_NUMBER:
+            json_encode_number(buffer, janet_unwrap_number(x));
+            break;
+        case JANET_STRING:
+        case JANET_SYMBOL:
+        case JANET_KEYWORD:
+        case JANET_BUFFER: {
+            JanetByteView view;
+            janet_bytes_view(x, &view.bytes, &view.len);
+            json_encode_string(buffer, view.bytes, view.len);
+            break;
+        }
+        case JANET_ARRAY:
+        case JANET_TUPLE: {
+            const Janet *items = NULL;
+            int32_t len = 0;
+            janet_indexed_view(x, &items, &len);
+            janet_buffer_push_u8(buffer, '[');
+            for (int32_t i = 0; i < len; i++) {
+                if (i) janet_buffer_push_u8(buffer, ',');
+                json_newline(e, depth + 1);
+                json_encode_one(e, items[i], depth + 1);
+            }
+            if (len) json_newline(e, depth);
+            janet_buffer_push_u8(buffer, ']');
+            break;
+        }
+        case JANET_TABLE:
+        case JANET_STRUCT: {
+            const JanetKV *kvs = NULL;
+            int32_t count = 0, cap = 0;
+            janet_dictionary_view(x, &kvs, &count, &cap);
+            janet_buffer_push_u8(buffer, '{');
+            int first = 1;
+            for (int32_t i = 0; i < cap; i++) {
+                const JanetKV *kv = kvs + i;
+                if (janet_checktype(kv->key, JANET_NIL)) continue;
+                if (!janet_checktypes(kv->key, JANET_TFLAG_BYTES)) {
+                    janet_panicf("json object keys must be strings, buffers, symbols or keywords, got %v", kv->key);
+                }
+                if (!first) janet_buffer_push_u8(buffer, ',');
+                first = 0;
+                json_newline(e, depth + 1);
+                JanetByteView key;
+                janet_bytes_view(kv->key, &key.bytes, &key.len);
+                json_encode_string(buffer, key.bytes, key.len);
+                janet_buffer_push_u8(buffer, ':');
+                if (e->pretty) janet_buffer_push_u8(buffer, ' ');
+                json_encode_one(e, kv->value, depth + 1);
+            }
+            if (!first) json_newline(e, depth);
+            janet_buffer_push_u8(buffer, '}');
+            break;
+        }
+        default:
+            janet_panicf("cannot encode %t as json", x);
+    }
+}
+
+/*
+ * Decoding
+ */
+
+#define JSON_KEYWORDS 0x1
+#define JSON_NILS 0x2
+
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *end;
+    const uint8_t *p;
+    JanetBuffer *scratch;
+    int flags;
+} JsonDecoder;
+
+static void json_error(JsonDecoder *d, const char *msg) {
+    janet_panicf("%s at byte %d", msg, (int32_t)(d->p - d->start));
+}
+
+static void json_skip_ws(JsonDecoder *d) {
+    const uint8_t *p = d->p;
+    while (p < d->end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    d->p = p;
+}
+
+static int json_hex4(JsonDecoder *d, const uint8_t *p) {
+    int value = 0;
+    if (d->end - p < 4) return -1;
+    for (int i = 0; i < 4; i++) {
+        uint8_t c = p[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return -1;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+static void json_push_codepoint(JanetBuffer *buffer, uint32_t cp) {
+    uint8_t out[4];
+    int n;
+    if (cp < 0x80) {
+        out[0] = (uint8_t) cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        out[0] = (uint8_t)(0xC0 | (cp >> 6));
+        out[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        out[0] = (uint8_t)(0xE0 | (cp >> 12));
+        out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        out[0] = (uint8_t)(0xF0 | (cp >> 18));
+        out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = (uint8_t)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    janet_buffer_push_bytes(buffer, out, n);
+}
+
+/* Decode a string with d->p just after the opening quote. Strings without
+ * escapes are made straight from the input. */
+static Janet json_decode_string(JsonDecoder *d, int iskey) {
+    const uint8_t *p = d->p;
+    int32_t n = json_plain_span(p, (int32_t)(d->end - p), 0);
+    JanetBuffer *buffer = NULL;
+    while (p + n < d->end && p[n] == '\\') {
+        if (NULL == buffer) {
+            buffer = d->scratch;
+            buffer->count = 0;
+        }
+        janet_buffer_push_bytes(buffer, p, n);
+        p += n;
+        if (d->end - p < 2) break;
+        uint8_t c = p[1];
+        p += 2;
+        switch (c) {
+            case '"':
+            case '\\':
+            case '/':
+                janet_buffer_push_u8(buffer, c);
+                break;
+            case 'b':
+                janet_buffer_push_u8(buffer, '\b');
+                break;
+            case 'f':
+                janet_buffer_push_u8(buffer, '\f');
+                break;
+            case 'n':
+                janet_buffer_push_u8(buffer, '\n');
+                break;
+            case 'r':
+                janet_buffer_push_u8(buffer, '\r');
+                break;
+            case 't':
+                janet_buffer_push_u8(buffer, '\t');
+                break;
+            case 'u': {
+                int cp = json_hex4(d, p);
+                if (cp < 0) {
+                    d->p = p;
+                    json_error(d, "invalid unicode escape");
+                }
+                p += 4;
+                if (cp >= 0xD800 && cp < 0xDC00) {
+                    /* High surrogate, must be followed by a low surrogate */
+                    int lo = (d->end - p >= 6 && p[0] == '\\' && p[1] == 'u') ? json_hex4(d, p + 2) : -1;
+                    if (lo < 0xDC00 || lo > 0xDFFF) {
+                        d->p = p;
+                        json_error(d, "unpaired surrogate in unicode escape");
+                    }
+                    p += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp < 0xE000) {
+                    d->p = p;
+                    json_error(d, "unpaired surrogate in unicode escape");
+                }
+                json_push_codepoint(buffer, (uint32_t) cp);
+                break;
+            }
+            default:
+                d->p = p - 1;
+                json_error(d, "invalid escape");
+        }
+        n = json_plain_span(p, (int32_t)(d->end - p), 0);
+    }
+    if (p + n >= d->end) {
+        d->p = d->end;
+        json_error(d, "unterminated string");
+    }
+    if (p[n] != '"') {
+        d->p = p + n;
+        json_error(d, "control character in string");
+    }
+    d->p = p + n + 1;
+    const uint8_t *bytes = p;
+    int32_t len = n;
+    if (NULL != buffer) {
+        janet_buffer_push_bytes(buffer, p, n);
+        bytes = buffer->data;
+        len = buffer->count;
+    }
+    return (iskey && (d->flags & JSON_KEYWORDS))
+           ? janet_keywordv(bytes, len)
+           : janet_stringv(bytes, len);
+}
+
+/* Check the JSON number grammar, which is stricter than Janet's */
+static Janet json_decode_number(JsonDecoder *d) {
+    const uint8_t *p = d->p;
+    const uint8_t *end = d->end;
+    if (p < end && *p == '-') p++;
+    if (p < end && *p == '0') {
+        p++;
+    } else if (p < end && *p >= '1' && *p <= '9') {
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    } else {
+        json_error(d, "invalid number");
+    }
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || *p < '0' || *p > '9') {
+            d->p = p;
+            json_error(d, "invalid number");
+        }
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        if (p >= end || *p < '0' || *p > '9') {
+            d->p = p;
+            json_error(d, "invalid number");
+        }
+        while (p < end && *p >= '0' && *p <= '9') p++;
+    }
+    double x;
+    if (janet_scan_number(d->p, (int32_t)(p - d->p), &x)) {
+        json_error(d, "invalid number");
+    }
+    d->p = p;
+    return janet_wrap_number(x);
+}
+
+static int json_literal(JsonDecoder *d, const char *lit, int32_t len) {
+    if (d->end - d->p < len || memcmp(d->p, lit, (size_t) len)) return 0;
+    d->p += len;
+    return 1;
+}
+
+static Janet json_decode_one(JsonDecoder *d, int depth) {
+    if (depth > JANET_RECURSION_GUARD) {
+        json_error(d, "recursed too deeply");
+    }
+    json_skip_ws(d);
+    if (d->p >= d->end) {
+        json_error(d, "unexpected end of input");
+    }
+    switch (*d->p) {
+        case '{': {
+            JanetTable *table = janet_table(0);
+            d->p++;
+            json_skip_ws(d);
+            if (d->p < d->end && *d->p == '}') {
+                d->p++;
+                return janet_wrap_table(table);
+            }
+            for (;;) {
+                json_skip_ws(d);
+                if (d->p >= d->end || *d->p != '"') {
+                    json_error(d, "expected string key");
+                }
+                d->p++;
+                Janet key = json_decode_string(d, 1);
+                json_skip_ws(d);
+                if (d->p >= d->end || *d->p != ':') {
+                    json_error(d, "expected colon");
+                }
+                d->p++;
+                Janet value = json_decode_one(d, depth + 1);
+                janet_table_put(table, key, value);
+                json_skip_ws(d);
+                if (d->p < d->end && *d->p == ',') {
+                    d->p++;
+                } else if (d->p < d->end && *d->p == '}') {
+                    d->p++;
+                    return janet_wrap_table(table);
+                } else {
+                    json_error(d, "expected comma or closing brace");
+                }
+            }
+        }
+        case '[': {
+            JanetArray *array = janet_array(0);
+            d->p++;
+            json_skip_ws(d);
+            if (d->p < d->end && *d->p == ']') {
+                d->p++;
+                return janet_wrap_array(array);
+            }
+            for (;;) {
+                janet_array_push(array, json_decode_one(d, depth + 1));
+                json_skip_ws(d);
+                if (d->p < d->end && *d->p == ',') {
+                    d->p++;
+                } else if (d->p < d->end && *d->p == ']') {
+                    d->p++;
+                    return janet_wrap_array(array);
+                } else {
+                    json_error(d, "expected comma or closing bracket");
+                }
+            }
+        }
+        case '"':
+            d->p++;
+            return json_decode_string(d, 0);
+        case 't':
+            if (json_literal(d, "true", 4)) return janet_wrap_true();
+            break;
+        case 'f':
+            if (json_literal(d, "false", 5)) return janet_wrap_false();
+            break;
+        case 'n':
+            if (json_literal(d, "null", 4)) {
+                return (d->flags & JSON_NILS) ? janet_wrap_nil() : janet_ckeywordv("null");
+            }
+            break;
+        default:
+            if (*d->p == '-' || (*d->p >= '0' && *d->p <= '9')) {
+                return json_decode_number(d);
+            }
+            break;
+    }
+    json_error(d, "unexpected character");
+    return janet_wrap_nil();
+}
+
+JANET_CORE_FN(cfun_json_encode,
+              "(json/encode x &opt tab newline buf)",
+              "Encode a Janet value as JSON and push it to `buf`, or to a new buffer. "
+              "Returns the buffer. `nil` becomes `null`. Strings, buffers, symbols and keywords "
+              "become strings, arrays and tuples become arrays, and tables and structs become "
+              "objects. Object keys must be strings, buffers, symbols or keywords. If `tab` is "
+              "given, each value goes on its own line, indented by `tab` once per level of "
+              "nesting. Lines end with `newline`, which defaults to \"\\n\". Strings must be valid "
+              "UTF-8, or an error is raised.") {
+    janet_arity(argc, 1, 4);
+    JsonEncoder e;
+    e.tab = janet_optcbytes(argv, argc, 1, "");
+    e.newline = janet_optcbytes(argv, argc, 2, *e.tab ? "\n" : "");
+    e.pretty = *e.tab || *e.newline;
+    e.buffer = janet_optbuffer(argv, argc, 3, 10);
+    json_encode_one(&e, argv[0], 0);
+    return janet_wrap_buffer(e.buffer);
+}
+
+JANET_CORE_FN(cfun_json_decode,
+              "(json/decode json &opt keywords nils)",
+              "Decode a JSON string or buffer into a Janet value. Objects become tables and "
+              "arrays become arrays. If `keywords` is truthy, object keys are keywords instead "
+              "of strings. `null` becomes `:null`, or `nil` if `nils` is truthy - note that "
+              "a key with a `nil` value is left out of its table.") {
+    janet_arity(argc, 1, 3);
+    JanetByteView view = janet_getbytes(argv, 0);
+    JsonDecoder d;
+    d.start = view.bytes;
+    d.p = view.bytes;
+    d.end = view.bytes + view.len;
+    d.scratch = janet_buffer(0);
+    d.flags = 0;
+    if (argc > 1 && janet_truthy(argv[1])) d.flags |= JSON_KEYWORDS;
+    if (argc > 2 && janet_truthy(argv[2])) d.flags |= JSON_NILS;
+    Janet ret = json_decode_one(&d, 0);
+    json_skip_ws(&d);
+    if (d.p != d.end) {
+        json_error(&d, "unexpected text after value");
+    }
+    return ret;
+}
+
+void janet_lib_json(JanetTable *env) {
+    JanetRegExt json_cfuns[] = {
+        JANET_CORE_REG("json/encode", cfun_json_encode),
+        JANET_CORE_REG("json/decode", cfun_json_decode),
+        JANET_REG_END
+    };
+    janet_core_cfuns_ext(env, NULL, json_cfuns);
+}
+
+#endif
@@ -38,8 +38,22 @@ typedef struct {
     JanetFuncDef **seen_defs;
     int32_t nextid;
     int maybe_cycles;
+    JanetMarshalWriter writer; /* NULL unless streaming */
+    void *udata;
+    size_t flushed; /* bytes handed to the writer so far */
+#ifdef JANET_BOOTSTRAP
+    /* Used by marshal/partition to find what each root shares with others */
+    JanetArray *links;
+    int32_t root;
+    int32_t *root_ids;
+    int32_t *root_envs;
+    int32_t *root_defs;
+#endif
 } MarshalState;
 
+/* Streaming marshal hands the output to the writer in pieces of about this size */
+#define JANET_MARSHAL_CHUNK 0x10000
+
 /* Lead bytes in marshaling protocol */
 enum {
     LB_REAL = 200,
@@ -77,8 +91,32 @@ enum {
     LB_TABLE_WEAKV_PROTO, /* 230 */
     LB_TABLE_WEAKKV_PROTO, /* 231 */
     LB_ARRAY_WEAK, /* 232 */
+    LB_STRING_MAPPED, /* 233 */
 } LeadBytes;
 
+/* Zero-copy images (JANET_MARSHAL_ZEROCOPY) store a string with a ready made
+ * JanetStringHead, aligned relative to the start of the image, so a loader
+ * can use the string where it lies. The header layout and hash only make
+ * sense to a build with the same hash function and key, byte order and
+ * header size, which the fingerprint below summarizes. Any mismatch, or
+ * source bytes that end up misaligned in memory, falls back to copying. */
+#define JANET_MAPPED_ALIGN 8
+
+static int32_t janet_mapped_fingerprint(void) {
+    uint32_t probe[2] = {0x6a616e74, (uint32_t) sizeof(JanetStringHead)};
+    return janet_string_calchash((const uint8_t *) probe, (int32_t) sizeof(probe));
+}
+
+/* The only header a mapped string may carry. Loaders compare against it
+ * rather than trusting the flags and hash stored in the image. */
+static void janet_mapped_head(JanetStringHead *head, const uint8_t *str, int32_t length) {
+    memset(head, 0, sizeof(JanetStringHead));
+    head->hash = janet_string_calchash(str, length);
+    head->gc.flags = JANET_MEMORY_STRING | JANET_STRING_FLAG_HASHED |
+                     JANET_MEM_REACHABLE | JANET_MEM_REMEMBERED | JANET_MEM_FROZEN;
+    head->length = length;
+}
+
 /* Helper to look inside an entry in an environment */
 static Janet entry_getval(Janet env_entry) {
     if (janet_checktype(env_entry, JANET_TABLE)) {
@@ -103,6 +141,7 @@ static Janet entry_getval(Janet env_entry) {
 /* Merge values from an environment into an existing lookup table. */
 void janet_env_lookup_into(JanetTable *renv, JanetTable *env, const char *prefix, int recurse) {
     while (env) {
+        janet_table_materialize(env);
         for (int32_t i = 0; i < env->capacity; i++) {
             if (janet_checktype(env->data[i].key, JANET_SYMBOL)) {
                 if (prefix) {
@@ -157,7 +196,22 @@ static void pushbyte(MarshalState *st, uint8_t b) {
     janet_buffer_push_u8(st->buf, b);
 }
 
+static void marshal_flush(MarshalState *st) {
+    if (st->buf->count > 0) {
+        st->writer(st->udata, st->buf->data, (size_t) st->buf->count);
+        st->flushed += (size_t) st->buf->count;
+        st->buf->count = 0;
+    }
+}
+
 static void pushbytes(MarshalState *st, const uint8_t *bytes, int32_t len) {
+    if (NULL != st->writer && len >= JANET_MARSHAL_CHUNK) {
+        /* Large strings go straight to the writer */
+        marshal_flush(st);
+        st->writer(st->udata, bytes, (size_t) len);
+        st->flushed += (size_t) len;
+        return;
+    }
     janet_buffer_push_bytes(st->buf, bytes, len);
 }
 
@@ -183,6 +237,34 @@ static void push64(MarshalState *st, uint64_t x) {
     }
 }
 
+#ifdef JANET_BOOTSTRAP
+
+/* Find the root that was being marshalled when the nth object was first seen */
+static int32_t marshal_owner(const int32_t *starts, int32_t n) {
+    int32_t lo = 0;
+    int32_t hi = janet_v_count(starts);
+    while (hi - lo > 1) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (starts[mid] <= n) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Record that the current root refers to another root or to a registry name */
+static void marshal_link(MarshalState *st, Janet target) {
+    if (janet_checkint(target) && janet_unwrap_integer(target) == st->root) return;
+    Janet *link = janet_tuple_begin(2);
+    link[0] = janet_wrap_integer(st->root);
+    link[1] = target;
+    janet_array_push(st->links, janet_wrap_tuple(janet_tuple_end(link)));
+}
+
+#endif
+
 /* Forward declaration to enable mutual recursion. */
 static void marshal_one(MarshalState *st, Janet x, int flags);
 static void marshal_one_fiber(MarshalState *st, JanetFiber *fiber, int flags);
@@ -210,6 +292,9 @@ static void marshal_one_env(MarshalState *st, JanetFuncEnv *env, int flags) {
     MARSH_STACKCHECK;
     for (int32_t i = 0; i < janet_v_count(st->seen_envs); i++) {
         if (st->seen_envs[i] == env) {
+#ifdef JANET_BOOTSTRAP
+            if (NULL != st->links) marshal_link(st, janet_wrap_integer(marshal_owner(st->root_envs, i)));
+#endif
             pushbyte(st, LB_FUNCENV_REF);
             pushint(st, i);
             return;
@@ -246,6 +331,14 @@ static void marshal_one_env(MarshalState *st, JanetFuncEnv *env, int flags) {
     }
 }
 
+/* Pad the output so the next byte lands on a multiple of align, counting from
+ * the start of the buffer. */
+static void pushpadding(MarshalState *st, int32_t align) {
+    int32_t pad = (int32_t)((align - (st->flushed + (size_t) st->buf->count + 1) % align) % align);
+    pushbyte(st, (uint8_t) pad);
+    for (int32_t i = 0; i < pad; i++) pushbyte(st, 0);
+}
+
 /* Marshal a sequence of u32s */
 static void janet_marshal_u32s(MarshalState *st, const uint32_t *u32s, int32_t n) {
     for (int32_t i = 0; i < n; i++) {
@@ -261,6 +354,9 @@ static void marshal_one_def(MarshalState *st, JanetFuncDef *def, int flags) {
     MARSH_STACKCHECK;
     for (int32_t i = 0; i < janet_v_count(st->seen_defs); i++) {
         if (st->seen_defs[i] == def) {
+#ifdef JANET_BOOTSTRAP
+            if (NULL != st->links) marshal_link(st, janet_wrap_integer(marshal_owner(st->root_defs, i)));
+#endif
             pushbyte(st, LB_FUNCDEF_REF);
             pushint(st, i);
             return;
@@ -269,7 +365,11 @@ static void marshal_one_def(MarshalState *st, JanetFuncDef *def, int flags) {
     /* Add to lookup */
     janet_v_push(st->seen_defs, def);
 
-    pushint(st, def->flags);
+    if (flags & JANET_MARSHAL_ZEROCOPY) {
+        pushint(st, def->flags | JANET_FUNCDEF_FLAG_MAPPED);
+    } else {
+        pushint(st, def->flags & ~JANET_FUNCDEF_FLAG_MAPPED);
+    }
     pushint(st, def->slotcount);
     pushint(st, def->arity);
     pushint(st, def->min_arity);
@@ -299,7 +399,8 @@ static void marshal_one_def(MarshalState *st, JanetFuncDef *def, int flags) {
         marshal_one(st, janet_wrap_symbol(def->symbolmap[i].symbol), flags + 1);
     }
 
-    /* marshal the bytecode */
+    /* marshal the bytecode, aligned so a little endian loader can use it in place */
+    if (flags & JANET_MARSHAL_ZEROCOPY) pushpadding(st, (int32_t) sizeof(uint32_t));
     janet_marshal_u32s(st, def->bytecode, def->bytecode_length);
 
     /* marshal the environments if needed */
@@ -464,6 +565,7 @@ static void marshal_one_abstract(MarshalState *st, Janet x, int flags) {
 static void marshal_one(MarshalState *st, Janet x, int flags) {
     MARSH_STACKCHECK;
     JanetType type = janet_type(x);
+    if (NULL != st->writer && st->buf->count >= JANET_MARSHAL_CHUNK) marshal_flush(st);
 
     /* Check simple primitives (non reference types, no benefit from memoization) */
     switch (type) {
@@ -491,6 +593,17 @@ static void marshal_one(MarshalState *st, Janet x, int flags) {
         if (st->maybe_cycles) {
             check = janet_table_get(&st->seen, x);
             if (janet_checkint(check)) {
+#ifdef JANET_BOOTSTRAP
+                if (NULL != st->links && !janet_checktypes(x, JANET_TFLAG_STRING | JANET_TFLAG_SYMBOL | JANET_TFLAG_KEYWORD)) {
+                    /* Strings can be copied into each root that uses them.
+                     * Values that are in the registry now belong to a root
+                     * that has been marshalled already. */
+                    Janet name = st->rreg ? janet_table_get(st->rreg, x) : janet_wrap_nil();
+                    marshal_link(st, janet_checktype(name, JANET_SYMBOL)
+                                 ? name
+                                 : janet_wrap_integer(marshal_owner(st->root_ids, janet_unwrap_integer(check))));
+                }
+#endif
                 pushbyte(st, LB_REFERENCE);
                 pushint(st, janet_unwrap_integer(check));
                 return;
@@ -499,7 +612,17 @@ static void marshal_one(MarshalState *st, Janet x, int flags) {
         if (st->rreg) {
             check = janet_table_get(st->rreg, x);
             if (janet_checktype(check, JANET_SYMBOL)) {
+#ifdef JANET_BOOTSTRAP
+                /* Don't remember registry values when partitioning, as the
+                 * root that owns one may not have been marshalled yet */
+                if (NULL != st->links) {
+                    marshal_link(st, check);
+                } else {
+                    MARK_SEEN();
+                }
+#else
                 MARK_SEEN();
+#endif
                 const uint8_t *regname = janet_unwrap_symbol(check);
                 pushbyte(st, LB_REGISTRY);
                 pushint(st, janet_string_length(regname));
@@ -545,6 +668,19 @@ static void marshal_one(MarshalState *st, Janet x, int flags) {
             int32_t length = janet_string_length(str);
             /* Record reference */
             MARK_SEEN();
+            if (type == JANET_STRING && (flags & JANET_MARSHAL_ZEROCOPY)) {
+                JanetStringHead head;
+                janet_mapped_head(&head, str, length);
+                pushbyte(st, LB_STRING_MAPPED);
+                pushint(st, length);
+                pushint(st, janet_mapped_fingerprint());
+                pushbyte(st, (uint8_t) sizeof(head));
+                pushpadding(st, JANET_MAPPED_ALIGN);
+                pushbytes(st, (const uint8_t *) &head, (int32_t) sizeof(head));
+                pushbytes(st, str, length);
+                pushbyte(st, 0);
+                return;
+            }
             uint8_t lb = (type == JANET_STRING) ? LB_STRING :
                          (type == JANET_SYMBOL) ? LB_SYMBOL :
                          LB_KEYWORD;
@@ -599,6 +735,7 @@ static void marshal_one(MarshalState *st, Janet x, int flags) {
         }
         case JANET_TABLE: {
             JanetTable *t = janet_unwrap_table(x);
+            janet_table_materialize(t);
             MARK_SEEN();
             enum JanetMemoryType memtype = janet_gc_type(t);
             if (memtype == JANET_MEMORY_TABLE_WEAKK) {
@@ -695,6 +832,12 @@ void janet_marshal(
     st.seen_envs = NULL;
     st.rreg = rreg;
     st.maybe_cycles = !(flags & JANET_MARSHAL_NO_CYCLES);
+    st.writer = NULL;
+    st.udata = NULL;
+    st.flushed = 0;
+#ifdef JANET_BOOTSTRAP
+    st.links = NULL;
+#endif
     janet_table_init(&st.seen, 0);
     marshal_one(&st, x, flags);
     janet_table_deinit(&st.seen);
@@ -702,6 +845,45 @@ void janet_marshal(
     janet_v_free(st.seen_defs);
 }
 
+/* Marshal to a writer in bounded pieces instead of one buffer. The collector
+ * is paused while marshalling so that a writer may run janet code. Returns
+ * the number of bytes written. */
+size_t janet_marshal_stream(
+    Janet x,
+    JanetTable *rreg,
+    int flags,
+    JanetMarshalWriter writer,
+    void *udata) {
+    int lock = janet_gclock();
+    MarshalState st;
+    st.buf = janet_buffer(JANET_MARSHAL_CHUNK + 64);
+    st.nextid = 0;
+    st.seen_defs = NULL;
+    st.seen_envs = NULL;
+    st.rreg = rreg;
+    st.maybe_cycles = !(flags & JANET_MARSHAL_NO_CYCLES);
+    st.writer = writer;
+    st.udata = udata;
+    st.flushed = 0;
+#ifdef JANET_BOOTSTRAP
+    st.links = NULL;
+#endif
+    janet_table_init(&st.seen, 0);
+    JanetTryState tstate;
+    JanetSignal signal = janet_try(&tstate);
+    if (!signal) {
+        marshal_one(&st, x, flags);
+        marshal_flush(&st);
+    }
+    janet_restore(&tstate);
+    janet_gcunlock(lock);
+    janet_table_deinit(&st.seen);
+    janet_v_free(st.seen_envs);
+    janet_v_free(st.seen_defs);
+    if (signal) janet_panicv(tstate.payload);
+    return st.flushed;
+}
+
 typedef struct {
     jmp_buf err;
     Janet *lookup;
@@ -710,16 +892,52 @@ typedef struct {
     JanetFuncDef **lookup_defs;
     const uint8_t *start;
     const uint8_t *end;
+    int32_t fingerprint;
+    int32_t borrowed; /* number of values that point into the source bytes */
+    JanetUnmarshalReader reader; /* NULL unless streaming */
+    void *udata;
+    JanetBuffer *window; /* holds the unread part of a streamed source */
+    int eof;
 } UnmarshalState;
 
 #define MARSH_EOS(st, data) do { \
     if ((data) >= (st)->end) janet_panic("unexpected end of source");\
 } while (0)
 
+/* Make sure n bytes starting at data are in memory. Streamed sources are
+ * read into a window that is compacted first, so this may move data, and no
+ * other pointers into the source may be held across it. Coming up short is
+ * left to MARSH_EOS. */
+#define MARSH_NEED(st, data, n) do { \
+    if ((size_t)((st)->end - (data)) < (size_t)(n) && NULL != (st)->reader) \
+        (data) = unmarshal_refill((st), (data), (size_t)(n)); \
+} while (0)
+
+static const uint8_t *unmarshal_refill(UnmarshalState *st, const uint8_t *data, size_t n) {
+    JanetBuffer *window = st->window;
+    size_t have = (size_t)(st->end - data);
+    memmove(window->data, data, have);
+    size_t want = n > JANET_MARSHAL_CHUNK ? n : JANET_MARSHAL_CHUNK;
+    if (want > INT32_MAX) janet_panic("marshalled value too large");
+    janet_buffer_ensure(window, (int32_t) want, 1);
+    while (have < n && !st->eof) {
+        size_t got = st->reader(st->udata, window->data + have, (size_t) window->capacity - have);
+        if (got == 0) {
+            st->eof = 1;
+        }
+        have += got;
+    }
+    window->count = (int32_t) have;
+    st->start = window->data;
+    st->end = window->data + have;
+    return window->data;
+}
+
 /* Helper to read a 32 bit integer from an unmarshal state */
 static int32_t readint(UnmarshalState *st, const uint8_t **atdata) {
     const uint8_t *data = *atdata;
     int32_t ret;
+    MARSH_NEED(st, data, 5);
     MARSH_EOS(st, data);
     if (*data < 128) {
         ret = *data++;
@@ -761,6 +979,7 @@ static int32_t readnat(UnmarshalState *st, const uint8_t **atdata) {
 static uint64_t read64(UnmarshalState *st, const uint8_t **atdata) {
     uint64_t ret;
     const uint8_t *data = *atdata;
+    MARSH_NEED(st, data, 9);
     MARSH_EOS(st, data);
     if (*data <= 0xF0) {
         /* Single byte */
@@ -827,6 +1046,7 @@ static const uint8_t *unmarshal_one_env(
     const uint8_t *data,
     JanetFuncEnv **out,
     int flags) {
+    MARSH_NEED(st, data, 1);
     MARSH_EOS(st, data);
     if (*data == LB_FUNCENV_REF) {
         data++;
@@ -872,6 +1092,7 @@ static const uint8_t *unmarshal_one_env(
 /* Unmarshal a series of u32s */
 static const uint8_t *janet_unmarshal_u32s(UnmarshalState *st, const uint8_t *data, uint32_t *into, int32_t n) {
     for (int32_t i = 0; i < n; i++) {
+        MARSH_NEED(st, data, 4);
         MARSH_EOS(st, data + 3);
         into[i] =
             (uint32_t)(data[0]) |
@@ -889,6 +1110,7 @@ static const uint8_t *unmarshal_one_def(
     const uint8_t *data,
     JanetFuncDef **out,
     int flags) {
+    MARSH_NEED(st, data, 1);
     MARSH_EOS(st, data);
     if (*data == LB_FUNCDEF_REF) {
         data++;
@@ -913,6 +1135,13 @@ static const uint8_t *unmarshal_one_def(
         def->bytecode = NULL;
         def->sourcemap = NULL;
         def->symbolmap = NULL;
+        def->method_cache = NULL;
+        def->profile = NULL;
+#ifdef JANET_JIT
+        def->jit = NULL;
+        def->jit_size = 0;
+        def->jit_calls = JANET_JIT_THRESHOLD;
+#endif
         def->symbolmap_length = 0;
         janet_v_push(st->lookup_defs, def);
 
@@ -988,13 +1217,31 @@ static const uint8_t *unmarshal_one_def(
             def->symbolmap_length = (uint32_t) symbolmap_length;
         }
 
-        /* Unmarshal bytecode */
-        def->bytecode = janet_malloc(sizeof(uint32_t) * bytecode_length);
-        if (!def->bytecode) {
-            JANET_OUT_OF_MEMORY;
+        /* Unmarshal bytecode, in place if it was written for that */
+        if (def->flags & JANET_FUNCDEF_FLAG_MAPPED) {
+            MARSH_NEED(st, data, 1);
+            MARSH_EOS(st, data);
+            data += 1 + *data;
+#ifdef JANET_LITTLE_ENDIAN
+            if ((flags & JANET_MARSHAL_ZEROCOPY) &&
+                    ((uintptr_t) data % sizeof(uint32_t)) == 0 &&
+                    (size_t)(st->end - data) >= sizeof(uint32_t) * (size_t) bytecode_length) {
+                def->bytecode = (uint32_t *) data;
+                def->bytecode_length = bytecode_length;
+                data += sizeof(uint32_t) * (size_t) bytecode_length;
+                st->borrowed++;
+            }
+#endif
+        }
+        if (NULL == def->bytecode) {
+            def->flags &= ~JANET_FUNCDEF_FLAG_MAPPED;
+            def->bytecode = janet_malloc(sizeof(uint32_t) * bytecode_length);
+            if (!def->bytecode) {
+                JANET_OUT_OF_MEMORY;
+            }
+            data = janet_unmarshal_u32s(st, data, def->bytecode, bytecode_length);
+            def->bytecode_length = bytecode_length;
         }
-        data = janet_unmarshal_u32s(st, data, def->bytecode, bytecode_length);
-        def->bytecode_length = bytecode_length;
 
         /* Unmarshal environments */
         if (def->flags & JANET_FUNCDEF_FLAG_HASENVS) {
@@ -1079,6 +1326,7 @@ static const uint8_t *unmarshal_one_fiber(
     fiber->child = NULL;
     fiber->env = NULL;
     fiber->last_value = janet_wrap_nil();
+    fiber->memory_group = NULL;
 #ifdef JANET_EV
     fiber->sched_id = 0;
     fiber->supervisor_channel = NULL;
@@ -1107,7 +1355,7 @@ static const uint8_t *unmarshal_one_fiber(
 
     /* Allocate stack memory */
     fiber->capacity = fiber_stacktop + 10;
-    fiber->data = janet_malloc(sizeof(Janet) * fiber->capacity);
+    fiber->data = janet_fiber_data_alloc(&fiber->capacity);
     if (!fiber->data) {
         JANET_OUT_OF_MEMORY;
     }
@@ -1215,7 +1463,8 @@ static const uint8_t *unmarshal_one_fiber(
 
 void janet_unmarshal_ensure(JanetMarshalContext *ctx, size_t size) {
     UnmarshalState *st = (UnmarshalState *)(ctx->u_state);
-    MARSH_EOS(st, ctx->data + size);
+    MARSH_NEED(st, ctx->data, size);
+    if (size > 0) MARSH_EOS(st, ctx->data + size - 1);
 }
 
 int32_t janet_unmarshal_int(JanetMarshalContext *ctx) {
@@ -1238,6 +1487,7 @@ void *janet_unmarshal_ptr(JanetMarshalContext *ctx) {
     }
     UnmarshalState *st = (UnmarshalState *)(ctx->u_state);
     void *ptr;
+    MARSH_NEED(st, ctx->data, sizeof(void *));
     MARSH_EOS(st, ctx->data + sizeof(void *) - 1);
     memcpy((char *) &ptr, ctx->data, sizeof(void *));
     ctx->data += sizeof(void *);
@@ -1246,12 +1496,14 @@ void *janet_unmarshal_ptr(JanetMarshalContext *ctx) {
 
 uint8_t janet_unmarshal_byte(JanetMarshalContext *ctx) {
     UnmarshalState *st = (UnmarshalState *)(ctx->u_state);
+    MARSH_NEED(st, ctx->data, 1);
     MARSH_EOS(st, ctx->data);
     return *(ctx->data++);
 }
 
 void janet_unmarshal_bytes(JanetMarshalContext *ctx, uint8_t *dest, size_t len) {
     UnmarshalState *st = (UnmarshalState *)(ctx->u_state);
+    MARSH_NEED(st, ctx->data, len);
     MARSH_EOS(st, ctx->data + len - 1);
     safe_memcpy(dest, ctx->data, len);
     ctx->data += len;
@@ -1316,6 +1568,7 @@ static const uint8_t *unmarshal_one(
     int flags) {
     uint8_t lead;
     MARSH_STACKCHECK;
+    MARSH_NEED(st, data, 16);
     MARSH_EOS(st, data);
     lead = data[0];
     if (lead < LB_REAL) {
@@ -1373,6 +1626,7 @@ static const uint8_t *unmarshal_one(
         case LB_REGISTRY: {
             data++;
             int32_t len = readnat(st, &data);
+            MARSH_NEED(st, data, len);
             MARSH_EOS(st, data - 1 + len);
             if (lead == LB_STRING) {
                 const uint8_t *str = janet_string(data, len);
@@ -1399,6 +1653,39 @@ static const uint8_t *unmarshal_one(
             janet_v_push(st->lookup, *out);
             return data + len;
         }
+        case LB_STRING_MAPPED: {
+            data++;
+            int32_t len = readnat(st, &data);
+            int32_t fingerprint = readint(st, &data);
+            MARSH_NEED(st, data, 2);
+            MARSH_EOS(st, data + 1);
+            size_t headsize = data[0];
+            size_t pad = data[1];
+            data += 2;
+            MARSH_NEED(st, data, pad + headsize + (size_t) len + 1);
+            data += pad;
+            MARSH_EOS(st, data + headsize + len);
+            const uint8_t *str = data + headsize;
+            JanetStringHead *head = (JanetStringHead *) data;
+            int mapped = (flags & JANET_MARSHAL_ZEROCOPY) &&
+                         fingerprint == st->fingerprint &&
+                         headsize == sizeof(JanetStringHead) &&
+                         ((uintptr_t) data % JANET_MAPPED_ALIGN) == 0 &&
+                         str[len] == 0;
+            if (mapped) {
+                JanetStringHead expect;
+                janet_mapped_head(&expect, str, len);
+                mapped = !memcmp(head, &expect, sizeof(JanetStringHead));
+            }
+            if (mapped) {
+                *out = janet_wrap_string(head->data);
+                st->borrowed++;
+            } else {
+                *out = janet_wrap_string(janet_string(str, len));
+            }
+            janet_v_push(st->lookup, *out);
+            return str + len + 1;
+        }
         case LB_FIBER: {
             JanetFiber *fiber;
             data = unmarshal_one_fiber(st, data + 1, &fiber, flags + 1);
@@ -1452,6 +1739,7 @@ static const uint8_t *unmarshal_one(
             int32_t len = readnat(st, &data);
             /* DOS check */
             if (lead != LB_REFERENCE) {
+                MARSH_NEED(st, data, len);
                 MARSH_EOS(st, data - 1 + len);
             }
             if (lead == LB_ARRAY || lead == LB_ARRAY_WEAK) {
@@ -1546,6 +1834,7 @@ static const uint8_t *unmarshal_one(
             data++;
             int32_t count = readnat(st, &data);
             int32_t capacity = readnat(st, &data);
+            MARSH_NEED(st, data, sizeof(void *) + 1);
             MARSH_EOS(st, data + sizeof(void *));
             union {
                 void *ptr;
@@ -1627,12 +1916,13 @@ static const uint8_t *unmarshal_one(
     }
 }
 
-Janet janet_unmarshal(
+static Janet janet_unmarshal_impl(
     const uint8_t *bytes,
     size_t len,
     int flags,
     JanetTable *reg,
-    const uint8_t **next) {
+    const uint8_t **next,
+    int32_t *borrowed) {
     UnmarshalState st;
     st.start = bytes;
     st.end = bytes + len;
@@ -1640,12 +1930,70 @@ Janet janet_unmarshal(
     st.lookup_envs = NULL;
     st.lookup = NULL;
     st.reg = reg;
+    st.fingerprint = (flags & JANET_MARSHAL_ZEROCOPY) ? janet_mapped_fingerprint() : 0;
+    st.borrowed = 0;
+    st.reader = NULL;
+    st.udata = NULL;
+    st.window = NULL;
+    st.eof = 1;
     Janet out;
     const uint8_t *nextbytes = unmarshal_one(&st, bytes, &out, flags);
     if (next) *next = nextbytes;
+    if (borrowed) *borrowed = st.borrowed;
+    janet_v_free(st.lookup_defs);
+    janet_v_free(st.lookup_envs);
+    janet_v_free(st.lookup);
+    return out;
+}
+
+Janet janet_unmarshal(
+    const uint8_t *bytes,
+    size_t len,
+    int flags,
+    JanetTable *reg,
+    const uint8_t **next) {
+    return janet_unmarshal_impl(bytes, len, flags, reg, next, NULL);
+}
+
+/* Unmarshal from a reader, keeping only a window of the source in memory.
+ * The reader may be asked for more bytes than the value needs, and those
+ * bytes are dropped, so the count is stored in unused if it is not NULL. The
+ * collector is paused while unmarshalling so that a reader may run janet code. */
+Janet janet_unmarshal_stream(
+    JanetUnmarshalReader reader,
+    void *udata,
+    int flags,
+    JanetTable *reg,
+    size_t *unused) {
+    int lock = janet_gclock();
+    UnmarshalState st;
+    st.window = janet_buffer(JANET_MARSHAL_CHUNK);
+    st.start = st.window->data;
+    st.end = st.window->data;
+    st.lookup_defs = NULL;
+    st.lookup_envs = NULL;
+    st.lookup = NULL;
+    st.reg = reg;
+    st.fingerprint = 0;
+    st.borrowed = 0;
+    st.reader = reader;
+    st.udata = udata;
+    st.eof = 0;
+    Janet out = janet_wrap_nil();
+    const uint8_t *next = st.start;
+    JanetTryState tstate;
+    JanetSignal signal = janet_try(&tstate);
+    if (!signal) {
+        /* The window moves, so values must never point into it */
+        next = unmarshal_one(&st, st.start, &out, flags & ~JANET_MARSHAL_ZEROCOPY);
+    }
+    janet_restore(&tstate);
+    janet_gcunlock(lock);
     janet_v_free(st.lookup_defs);
     janet_v_free(st.lookup_envs);
     janet_v_free(st.lookup);
+    if (signal) janet_panicv(tstate.payload);
+    if (unused) *unused = (size_t)(st.end - next);
     return out;
 }
 
@@ -1662,14 +2010,16 @@ JANET_CORE_FN(cfun_env_lookup,
 }
 
 JANET_CORE_FN(cfun_marshal,
-              "(marshal x &opt reverse-lookup buffer no-cycles)",
+              "(marshal x &opt reverse-lookup buffer no-cycles zero-copy)",
               "Marshal a value into a buffer and return the buffer. The buffer "
               "can then later be unmarshalled to reconstruct the initial value. "
               "Optionally, one can pass in a reverse lookup table to not marshal "
               "aliased values that are found in the table. Then a forward "
               "lookup table can be used to recover the original value when "
-              "unmarshalling.") {
-    janet_arity(argc, 1, 4);
+              "unmarshalling. If `zero-copy` is truthy, strings and function bytecode "
+              "are laid out so that unmarshalling from a `file/mmap` of the output "
+              "can use them in place instead of copying them onto the heap.") {
+    janet_arity(argc, 1, 5);
     JanetBuffer *buffer;
     JanetTable *rreg = NULL;
     uint32_t flags = 0;
@@ -1684,6 +2034,9 @@ JANET_CORE_FN(cfun_marshal,
     if (argc > 3 && janet_truthy(argv[3])) {
         flags |= JANET_MARSHAL_NO_CYCLES;
     }
+    if (argc > 4 && janet_truthy(argv[4])) {
+        flags |= JANET_MARSHAL_ZEROCOPY;
+    }
     janet_marshal(buffer, argv[0], rreg, flags);
     return janet_wrap_buffer(buffer);
 }
@@ -1692,22 +2045,197 @@ JANET_CORE_FN(cfun_unmarshal,
               "(unmarshal buffer &opt lookup)",
               "Unmarshal a value from a buffer. An optional lookup table "
               "can be provided to allow for aliases to be resolved. Returns the value "
-              "unmarshalled from the buffer.") {
+              "unmarshalled from the buffer. If `buffer` is a core/mmap of data written with "
+              "`marshal` in zero-copy mode by the same build of janet, strings and function "
+              "bytecode point into the mapping rather than being copied, and the mapping is "
+              "kept open for the rest of the program. The file must not change while it is mapped.") {
     janet_arity(argc, 1, 2);
     JanetByteView view = janet_getbytes(argv, 0);
     JanetTable *reg = NULL;
     if (argc > 1) {
         reg = janet_gettable(argv, 1);
     }
+#ifdef JANET_MMAP
+    if (janet_checkabstract(argv[0], &janet_mmap_type)) {
+        int32_t borrowed = 0;
+        Janet out = janet_unmarshal_impl(view.bytes, (size_t) view.len, JANET_MARSHAL_ZEROCOPY,
+                                         reg, NULL, &borrowed);
+        if (borrowed) janet_mmap_pin(argv[0]);
+        return out;
+    }
+#endif
     return janet_unmarshal(view.bytes, (size_t) view.len, 0, reg, NULL);
 }
 
+/* A core/file or function that marshal-to writes to, or unmarshal-from reads from */
+typedef struct {
+    Janet target;
+    JanetFile *file;
+    JanetBuffer *chunk;
+} MarshalStreamTarget;
+
+static void marshal_stream_target(MarshalStreamTarget *t, const Janet *argv, int32_t n, int write) {
+    t->target = argv[n];
+    t->file = NULL;
+    t->chunk = NULL;
+    if (janet_checkabstract(argv[n], &janet_file_type)) {
+        t->file = janet_unwrap_abstract(argv[n]);
+        if (t->file->flags & JANET_FILE_CLOSED)
+            janet_panic("file is closed");
+        if (write && !(t->file->flags & (JANET_FILE_WRITE | JANET_FILE_APPEND | JANET_FILE_UPDATE)))
+            janet_panic("file is not writeable");
+        if (!write && !(t->file->flags & (JANET_FILE_READ | JANET_FILE_UPDATE)))
+            janet_panic("file is not readable");
+    } else if (janet_checktype(argv[n], JANET_FUNCTION)) {
+        t->chunk = janet_buffer(0);
+    } else {
+        janet_panic_type(argv[n], n, JANET_TFLAG_FUNCTION | JANET_TFLAG_ABSTRACT);
+    }
+}
+
+static void marshal_stream_write(void *udata, const uint8_t *bytes, size_t len) {
+    MarshalStreamTarget *t = (MarshalStreamTarget *) udata;
+    if (NULL != t->file) {
+        if (len && !fwrite(bytes, len, 1, t->file->file)) {
+            janet_panic("error writing to file");
+        }
+    } else {
+        t->chunk->count = 0;
+        janet_buffer_push_bytes(t->chunk, bytes, (int32_t) len);
+        Janet arg = janet_wrap_buffer(t->chunk);
+        janet_call(janet_unwrap_function(t->target), 1, &arg);
+    }
+}
+
+static size_t marshal_stream_read(void *udata, uint8_t *dest, size_t len) {
+    MarshalStreamTarget *t = (MarshalStreamTarget *) udata;
+    if (NULL != t->file) {
+        size_t nread = fread(dest, 1, len, t->file->file);
+        if (nread != len && ferror(t->file->file))
+            janet_panic("could not read file");
+        return nread;
+    }
+    if (len > INT32_MAX) len = INT32_MAX;
+    t->chunk->count = 0;
+    Janet args[2] = {janet_wrap_buffer(t->chunk), janet_wrap_integer((int32_t) len)};
+    janet_call(janet_unwrap_function(t->target), 2, args);
+    if ((size_t) t->chunk->count > len)
+        janet_panicf("source returned %d bytes, expected at most %d", t->chunk->count, (int32_t) len);
+    safe_memcpy(dest, t->chunk->data, t->chunk->count);
+    return (size_t) t->chunk->count;
+}
+
+JANET_CORE_FN(cfun_marshal_to,
+              "(marshal-to dest x &opt reverse-lookup no-cycles)",
+              "Marshal a value like `marshal`, but write the output to `dest` in pieces of about 64KB "
+              "instead of building it in one buffer, so large values can be saved with bounded memory. "
+              "`dest` is a core/file, or a function that is called with a buffer holding each piece. "
+              "The buffer is reused, so the function must consume it before returning, and it must not "
+              "yield. The garbage collector does not run until marshalling is done. Returns the number "
+              "of bytes written.") {
+    janet_arity(argc, 2, 4);
+    MarshalStreamTarget target;
+    marshal_stream_target(&target, argv, 0, 1);
+    JanetTable *rreg = NULL;
+    int flags = 0;
+    if (argc > 2 && !janet_checktype(argv[2], JANET_NIL)) {
+        rreg = janet_gettable(argv, 2);
+    }
+    if (argc > 3 && janet_truthy(argv[3])) {
+        flags |= JANET_MARSHAL_NO_CYCLES;
+    }
+    size_t written = janet_marshal_stream(argv[1], rreg, flags, marshal_stream_write, &target);
+    return janet_wrap_number((double) written);
+}
+
+JANET_CORE_FN(cfun_unmarshal_from,
+              "(unmarshal-from source &opt lookup)",
+              "Unmarshal a value like `unmarshal`, but read the input from `source` in pieces, keeping "
+              "only a small window of it in memory. `source` is a core/file, which is left just past "
+              "the value if it is seekable, or a function called as `(source buf n)` that should push "
+              "at most n bytes onto the empty buffer `buf`, and push nothing at the end of the input. "
+              "A function source may be asked for more bytes than the value needs, and those are "
+              "dropped. The function must not yield, and the garbage collector does not run until "
+              "unmarshalling is done.") {
+    janet_arity(argc, 1, 2);
+    MarshalStreamTarget source;
+    marshal_stream_target(&source, argv, 0, 0);
+    JanetTable *reg = NULL;
+    if (argc > 1 && !janet_checktype(argv[1], JANET_NIL)) {
+        reg = janet_gettable(argv, 1);
+    }
+    size_t unused = 0;
+    Janet out = janet_unmarshal_stream(marshal_stream_read, &source, 0, reg, &unused);
+    if (NULL != source.file && unused > 0) {
+        /* Give back what was read past the value, where the file allows it */
+        fseek(source.file->file, -(long) unused, SEEK_CUR);
+    }
+    return out;
+}
+
+#ifdef JANET_BOOTSTRAP
+
+JANET_CORE_FN(cfun_marshal_partition,
+              "(marshal/partition roots owns reverse-lookup)",
+              "Marshal each of `roots` in turn, sharing one reference table, and report what each "
+              "root uses from the others. While the nth root is marshalled, `(owns n)` is taken "
+              "out of `reverse-lookup` so that it is marshalled in full. Returns an array of "
+              "`[n m]` pairs, where `m` is the index of an earlier root that shares an object with "
+              "root `n`, or a name from `reverse-lookup` that root `n` refers to. Only available "
+              "while bootstrapping.") {
+    janet_fixarity(argc, 3);
+    JanetView roots = janet_getindexed(argv, 0);
+    JanetView owns = janet_getindexed(argv, 1);
+    JanetTable *rreg = janet_gettable(argv, 2);
+    if (owns.len != roots.len) janet_panic("expected one owned value per root");
+    MarshalState st;
+    st.buf = janet_buffer(0);
+    st.nextid = 0;
+    st.seen_defs = NULL;
+    st.seen_envs = NULL;
+    st.rreg = rreg;
+    st.maybe_cycles = 1;
+    st.writer = NULL;
+    st.udata = NULL;
+    st.flushed = 0;
+    st.links = janet_array(0);
+    st.root_ids = NULL;
+    st.root_envs = NULL;
+    st.root_defs = NULL;
+    janet_table_init(&st.seen, 0);
+    for (int32_t i = 0; i < roots.len; i++) {
+        Janet own = owns.items[i];
+        Janet name = janet_checktype(own, JANET_NIL) ? own : janet_table_remove(rreg, own);
+        st.root = i;
+        janet_v_push(st.root_ids, st.nextid);
+        janet_v_push(st.root_envs, janet_v_count(st.seen_envs));
+        janet_v_push(st.root_defs, janet_v_count(st.seen_defs));
+        marshal_one(&st, roots.items[i], 0);
+        st.buf->count = 0;
+        if (!janet_checktype(name, JANET_NIL)) janet_table_put(rreg, own, name);
+    }
+    janet_table_deinit(&st.seen);
+    janet_v_free(st.seen_envs);
+    janet_v_free(st.seen_defs);
+    janet_v_free(st.root_ids);
+    janet_v_free(st.root_envs);
+    janet_v_free(st.root_defs);
+    return janet_wrap_array(st.links);
+}
+
+#endif
+
 /* Module entry point */
 void janet_lib_marsh(JanetTable *env) {
     JanetRegExt marsh_cfuns[] = {
         JANET_CORE_REG("marshal", cfun_marshal),
         JANET_CORE_REG("unmarshal", cfun_unmarshal),
+        JANET_CORE_REG("marshal-to", cfun_marshal_to),
+        JANET_CORE_REG("unmarshal-from", cfun_unmarshal_from),
         JANET_CORE_REG("env-lookup", cfun_env_lookup),
+#ifdef JANET_BOOTSTRAP
+        JANET_CORE_REG("marshal/partition", cfun_marshal_partition),
+#endif
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, marsh_cfuns);
@@ -325,6 +325,186 @@ JANET_NO_RETURN static void janet_sched_accept(JanetStream *stream, JanetFunctio
 
 #endif
 
+/* State machine for receiving and sending many datagrams at once. Linux moves
+ * a whole batch per syscall with recvmmsg and sendmmsg, other systems loop over
+ * recvfrom and sendto until the socket would block. */
+
+#ifndef JANET_WINDOWS
+
+#ifdef JANET_LINUX
+#define JANET_NET_MMSG
+#endif
+
+/* Most datagrams moved by a single syscall */
+#define JANET_NET_BATCH 64
+
+typedef struct {
+    int flags;
+    int is_send;
+    int32_t nbytes;
+    int32_t done;
+    /* Tuple of buffers to receive into, or of byte sequences to send */
+    const Janet *items;
+    /* Tuple of destination addresses when sending */
+    const Janet *dests;
+    /* Source addresses of the received datagrams */
+    JanetArray *froms;
+} NetStateMany;
+
+/* Receive a batch of datagrams, returning how many arrived or -1 */
+static int net_recv_batch(JanetStream *stream, NetStateMany *state, int32_t count) {
+    struct sockaddr_storage addrs[JANET_NET_BATCH];
+    socklen_t addrlens[JANET_NET_BATCH];
+    int n;
+    for (int32_t i = 0; i < count; i++) {
+        janet_buffer_extra(janet_unwrap_buffer(state->items[state->done + i]), state->nbytes);
+    }
+#ifdef JANET_NET_MMSG
+    struct mmsghdr msgs[JANET_NET_BATCH];
+    struct iovec iovs[JANET_NET_BATCH];
+    memset(msgs, 0, count * sizeof(struct mmsghdr));
+    for (int32_t i = 0; i < count; i++) {
+        JanetBuffer *buf = janet_unwrap_buffer(state->items[state->done + i]);
+        iovs[i].iov_base = buf->data + buf->count;
+        iovs[i].iov_len = (size_t) state->nbytes;
+        msgs[i].msg_hdr.msg_iov = iovs + i;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = addrs + i;
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    }
+    do {
+        n = recvmmsg(stream->handle, msgs, (unsigned int) count, state->flags, NULL);
+    } while (n == -1 && errno == EINTR);
+    for (int i = 0; i < n; i++) {
+        janet_unwrap_buffer(state->items[state->done + i])->count += (int32_t) msgs[i].msg_len;
+        addrlens[i] = msgs[i].msg_hdr.msg_namelen;
+    }
+#else
+    for (n = 0; n < count; n++) {
+        JanetBuffer *buf = janet_unwrap_buffer(state->items[state->done + n]);
+        ssize_t nread;
+        addrlens[n] = sizeof(struct sockaddr_storage);
+        do {
+            nread = recvfrom(stream->handle, buf->data + buf->count, state->nbytes, state->flags,
+                             (struct sockaddr *)(addrs + n), addrlens + n);
+        } while (nread == -1 && errno == EINTR);
+        if (nread == -1) {
+            if (n == 0) return -1;
+            break;
+        }
+        buf->count += (int32_t) nread;
+    }
+#endif
+    for (int i = 0; i < n; i++) {
+        void *abst = janet_abstract(&janet_address_type, addrlens[i]);
+        memcpy(abst, addrs + i, addrlens[i]);
+        janet_array_push(state->froms, janet_wrap_abstract(abst));
+    }
+    return n;
+}
+
+/* Send a batch of datagrams, returning how many were sent or -1 */
+static int net_send_batch(JanetStream *stream, NetStateMany *state, int32_t count) {
+    int n;
+#ifdef JANET_NET_MMSG
+    struct mmsghdr msgs[JANET_NET_BATCH];
+    struct iovec iovs[JANET_NET_BATCH];
+    memset(msgs, 0, count * sizeof(struct mmsghdr));
+    for (int32_t i = 0; i < count; i++) {
+        JanetByteView view;
+        void *dest = janet_unwrap_abstract(state->dests[state->done + i]);
+        janet_bytes_view(state->items[state->done + i], &view.bytes, &view.len);
+        iovs[i].iov_base = (void *) view.bytes;
+        iovs[i].iov_len = (size_t) view.len;
+        msgs[i].msg_hdr.msg_iov = iovs + i;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = dest;
+        msgs[i].msg_hdr.msg_namelen = (socklen_t) janet_abstract_size(dest);
+    }
+    do {
+        n = sendmmsg(stream->handle, msgs, (unsigned int) count, state->flags);
+    } while (n == -1 && errno == EINTR);
+#else
+    for (n = 0; n < count; n++) {
+        JanetByteView view;
+        void *dest = janet_unwrap_abstract(state->dests[state->done + n]);
+        janet_bytes_view(state->items[state->done + n], &view.bytes, &view.len);
+        ssize_t nwrote;
+        do {
+            nwrote = sendto(stream->handle, view.bytes, view.len, state->flags,
+                            (struct sockaddr *) dest, janet_abstract_size(dest));
+        } while (nwrote == -1 && errno == EINTR);
+        if (nwrote == -1) {
+            if (n == 0) return -1;
+            break;
+        }
+    }
+#endif
+    return n;
+}
+
+void net_callback_many(JanetFiber *fiber, JanetAsyncEvent event) {
+    JanetStream *stream = fiber->ev_stream;
+    NetStateMany *state = (NetStateMany *) fiber->ev_state;
+    switch (event) {
+        default:
+            break;
+        case JANET_ASYNC_EVENT_MARK:
+            janet_mark(janet_wrap_tuple(state->items));
+            if (state->is_send) {
+                janet_mark(janet_wrap_tuple(state->dests));
+            } else {
+                janet_mark(janet_wrap_array(state->froms));
+            }
+            break;
+        case JANET_ASYNC_EVENT_CLOSE:
+            janet_cancel(fiber, janet_cstringv("stream closed"));
+            janet_async_end(fiber);
+            break;
+        /* On errors, the next syscall reports what went wrong */
+        case JANET_ASYNC_EVENT_ERR:
+        case JANET_ASYNC_EVENT_INIT:
+        case JANET_ASYNC_EVENT_READ:
+        case JANET_ASYNC_EVENT_WRITE: {
+            int32_t total = janet_tuple_length(state->items);
+            while (state->done < total) {
+                int32_t count = total - state->done;
+                if (count > JANET_NET_BATCH) count = JANET_NET_BATCH;
+                int n = state->is_send
+                        ? net_send_batch(stream, state, count)
+                        : net_recv_batch(stream, state, count);
+                if (n == -1) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        janet_cancel(fiber, janet_ev_lasterr());
+                        janet_async_end(fiber);
+                        return;
+                    }
+                    /* Receiving finishes with whatever has arrived */
+                    if (!state->is_send && state->done > 0) break;
+                    return;
+                }
+                state->done += n;
+                if (n < count) {
+                    if (!state->is_send) break;
+                    return;
+                }
+            }
+            janet_schedule(fiber, state->is_send ? janet_wrap_nil() : janet_wrap_array(state->froms));
+            janet_async_end(fiber);
+            break;
+        }
+    }
+}
+
+static JANET_NO_RETURN void net_sched_many(JanetStream *stream, NetStateMany *state) {
+    NetStateMany *copy = janet_malloc(sizeof(NetStateMany));
+    *copy = *state;
+    janet_async_start(stream, state->is_send ? JANET_ASYNC_LISTEN_WRITE : JANET_ASYNC_LISTEN_READ,
+                      net_callback_many, copy);
+}
+
+#endif
+
 /* Address info */
 
 static int janet_get_sockettype(Janet *argv, int32_t argc, int32_t n) {
@@ -957,23 +1137,136 @@ JANET_CORE_FN(cfun_stream_recv_from,
     janet_ev_recvfrom(stream, buffer, n, MSG_NOSIGNAL);
 }
 
+JANET_CORE_FN(cfun_stream_recv_many,
+              "(net/recv-many stream nbytes bufs &opt timeout)",
+              "Receives up to one datagram of at most `nbytes` into each buffer in the array or tuple `bufs`, "
+              "suspending until at least one datagram arrives. Returns an array of the socket-addresses the "
+              "datagrams came from, with one entry for each buffer that was filled, in order. On Linux, many "
+              "datagrams are received with a single syscall. Takes an optional timeout in seconds, after which "
+              "will raise an error. Not supported on Windows.") {
+    janet_arity(argc, 3, 4);
+#ifdef JANET_WINDOWS
+    janet_panic("net/recv-many is not supported on Windows");
+#else
+    JanetStream *stream = janet_getabstract(argv, 0, &janet_stream_type);
+    janet_stream_flags(stream, JANET_STREAM_UDPSERVER | JANET_STREAM_SOCKET);
+    int32_t nbytes = janet_getnat(argv, 1);
+    JanetView bufs = janet_getindexed(argv, 2);
+    for (int32_t i = 0; i < bufs.len; i++) {
+        if (!janet_checktype(bufs.items[i], JANET_BUFFER)) {
+            janet_panicf("bad slot #2, expected array or tuple of buffers, got %v", bufs.items[i]);
+        }
+    }
+    double to = janet_optnumber(argv, argc, 3, INFINITY);
+    NetStateMany state;
+    memset(&state, 0, sizeof(state));
+    state.flags = MSG_NOSIGNAL;
+    state.nbytes = nbytes;
+    /* Copy the buffers so changes to bufs don't affect the receive */
+    state.items = janet_tuple_n(bufs.items, bufs.len);
+    state.froms = janet_array(bufs.len);
+    if (to != INFINITY) janet_addtimeout(to);
+    net_sched_many(stream, &state);
+#endif
+}
+
+JANET_CORE_FN(cfun_stream_send_many,
+              "(net/send-many stream dest datagrams &opt timeout)",
+              "Writes each byte sequence in the array or tuple `datagrams` as a datagram. `dest` is either "
+              "one socket-address for every datagram, or an array or tuple of socket-addresses with one "
+              "entry per datagram. On Linux, many datagrams are sent with a single syscall. Takes an optional "
+              "timeout in seconds, after which will raise an error. Not supported on Windows.") {
+    janet_arity(argc, 3, 4);
+#ifdef JANET_WINDOWS
+    janet_panic("net/send-many is not supported on Windows");
+#else
+    JanetStream *stream = janet_getabstract(argv, 0, &janet_stream_type);
+    janet_stream_flags(stream, JANET_STREAM_UDPSERVER | JANET_STREAM_SOCKET);
+    JanetView datagrams = janet_getindexed(argv, 2);
+    for (int32_t i = 0; i < datagrams.len; i++) {
+        if (!janet_checktypes(datagrams.items[i], JANET_TFLAG_BYTES)) {
+            janet_panicf("bad slot #2, expected array or tuple of bytes, got %v", datagrams.items[i]);
+        }
+    }
+    Janet *dests = janet_tuple_begin(datagrams.len);
+    if (janet_checkabstract(argv[1], &janet_address_type)) {
+        for (int32_t i = 0; i < datagrams.len; i++) dests[i] = argv[1];
+    } else {
+        JanetView many = janet_getindexed(argv, 1);
+        if (many.len != datagrams.len) {
+            janet_panicf("expected %d destinations, got %d", datagrams.len, many.len);
+        }
+        for (int32_t i = 0; i < many.len; i++) {
+            if (!janet_checkabstract(many.items[i], &janet_address_type)) {
+                janet_panicf("bad slot #1, expected array or tuple of socket-addresses, got %v", many.items[i]);
+            }
+            dests[i] = many.items[i];
+        }
+    }
+    double to = janet_optnumber(argv, argc, 3, INFINITY);
+    NetStateMany state;
+    memset(&state, 0, sizeof(state));
+    state.flags = MSG_NOSIGNAL;
+    state.is_send = 1;
+    state.items = janet_tuple_n(datagrams.items, datagrams.len);
+    state.dests = janet_tuple_end(dests);
+    if (to != INFINITY) janet_addtimeout(to);
+    net_sched_many(stream, &state);
+#endif
+}
+
 JANET_CORE_FN(cfun_stream_write,
               "(net/write stream data &opt timeout)",
               "Write data to a stream, suspending the current fiber until the write "
-              "completes. Takes an optional timeout in seconds, after which will raise an error. "
+              "completes. `data` can also be an array or tuple of byte sequences, which are sent "
+              "in order with a single vectored send where possible, without joining them first. "
+              "Takes an optional timeout in seconds, after which will raise an error. "
               "Returns nil, or raises an error if the write failed.") {
     janet_arity(argc, 2, 3);
     JanetStream *stream = janet_getabstract(argv, 0, &janet_stream_type);
     janet_stream_flags(stream, JANET_STREAM_WRITABLE | JANET_STREAM_SOCKET);
     double to = janet_optnumber(argv, argc, 2, INFINITY);
-    if (janet_checktype(argv[1], JANET_BUFFER)) {
-        if (to != INFINITY) janet_addtimeout(to);
-        janet_ev_send_buffer(stream, janet_getbuffer(argv, 1), MSG_NOSIGNAL);
+    janet_getwritable(argv, 1);
+    if (to != INFINITY) janet_addtimeout(to);
+    janet_ev_send_bytes(stream, argv[1], MSG_NOSIGNAL);
+}
+
+JANET_CORE_FN(cfun_stream_sendfile,
+              "(net/sendfile stream file &opt offset count timeout)",
+              "Send the contents of a file to a stream, starting at byte `offset` (default 0), suspending "
+              "the current fiber until done. `file` can be a core/file or a stream opened with `os/open`. "
+              "Sends `count` bytes, or up to the end of the file if `count` is nil. The bytes are moved "
+              "by the kernel with sendfile, or TransmitFile on Windows, without being copied into "
+              "userspace. Does not move the file's position. Takes an optional timeout in seconds, after "
+              "which will raise an error. Returns the number of bytes sent.") {
+    janet_arity(argc, 2, 5);
+    JanetStream *stream = janet_getabstract(argv, 0, &janet_stream_type);
+    janet_stream_flags(stream, JANET_STREAM_WRITABLE | JANET_STREAM_SOCKET);
+    JanetHandle handle;
+    JanetStream *fstream = janet_checkabstract(argv[1], &janet_stream_type);
+    if (NULL != fstream) {
+        if (fstream->flags & JANET_STREAM_CLOSED) janet_panic("stream is closed");
+        handle = fstream->handle;
     } else {
-        JanetByteView bytes = janet_getbytes(argv, 1);
-        if (to != INFINITY) janet_addtimeout(to);
-        janet_ev_send_string(stream, bytes.bytes, MSG_NOSIGNAL);
+        int32_t flags;
+        FILE *f = janet_getfile(argv, 1, &flags);
+        if (flags & JANET_FILE_CLOSED) janet_panic("file is closed");
+#ifdef JANET_WINDOWS
+        handle = (HANDLE) _get_osfhandle(_fileno(f));
+#else
+        handle = fileno(f);
+#endif
+    }
+    int64_t offset = janet_optinteger64(argv, argc, 2, 0);
+    if (offset < 0) janet_panicf("expected non-negative offset, got %v", argv[2]);
+    int64_t count = -1;
+    if (argc > 3 && !janet_checktype(argv[3], JANET_NIL)) {
+        count = janet_getinteger64(argv, 3);
+        if (count < 0) janet_panicf("expected non-negative count, got %v", argv[3]);
     }
+    double to = janet_optnumber(argv, argc, 4, INFINITY);
+    if (to != INFINITY) janet_addtimeout(to);
+    janet_ev_sendfile(stream, handle, offset, count);
 }
 
 JANET_CORE_FN(cfun_stream_send_to,
@@ -986,14 +1279,9 @@ JANET_CORE_FN(cfun_stream_send_to,
     janet_stream_flags(stream, JANET_STREAM_UDPSERVER | JANET_STREAM_SOCKET);
     void *dest = janet_getabstract(argv, 1, &janet_address_type);
     double to = janet_optnumber(argv, argc, 3, INFINITY);
-    if (janet_checktype(argv[2], JANET_BUFFER)) {
-        if (to != INFINITY) janet_addtimeout(to);
-        janet_ev_sendto_buffer(stream, janet_getbuffer(argv, 2), dest, MSG_NOSIGNAL);
-    } else {
-        JanetByteView bytes = janet_getbytes(argv, 2);
-        if (to != INFINITY) janet_addtimeout(to);
-        janet_ev_sendto_string(stream, bytes.bytes, dest, MSG_NOSIGNAL);
-    }
+    janet_getbytes(argv, 2);
+    if (to != INFINITY) janet_addtimeout(to);
+    janet_ev_sendto_bytes(stream, argv[2], dest, MSG_NOSIGNAL);
 }
 
 JANET_CORE_FN(cfun_stream_flush,
@@ -1118,7 +1406,10 @@ static const JanetMethod net_stream_methods[] = {
     {"accept", cfun_stream_accept},
     {"accept-loop", cfun_stream_accept_loop},
     {"send-to", cfun_stream_send_to},
+    {"sendfile", cfun_stream_sendfile},
     {"recv-from", cfun_stream_recv_from},
+    {"send-many", cfun_stream_send_many},
+    {"recv-many", cfun_stream_recv_many},
     {"evread", janet_cfun_stream_read},
     {"evchunk", janet_cfun_stream_chunk},
     {"evwrite", janet_cfun_stream_write},
@@ -1142,7 +1433,10 @@ void janet_lib_net(JanetTable *env) {
         JANET_CORE_REG("net/chunk", cfun_stream_chunk),
         JANET_CORE_REG("net/write", cfun_stream_write),
         JANET_CORE_REG("net/send-to", cfun_stream_send_to),
+        JANET_CORE_REG("net/sendfile", cfun_stream_sendfile),
         JANET_CORE_REG("net/recv-from", cfun_stream_recv_from),
+        JANET_CORE_REG("net/send-many", cfun_stream_send_many),
+        JANET_CORE_REG("net/recv-many", cfun_stream_recv_many),
         JANET_CORE_REG("net/flush", cfun_stream_flush),
         JANET_CORE_REG("net/connect", cfun_net_connect),
         JANET_CORE_REG("net/shutdown", cfun_net_shutdown),
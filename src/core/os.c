@@ -47,6 +47,7 @@
 
 #ifdef JANET_LINUX
 #include <sched.h>
+#include <sys/syscall.h>
 #endif
 
 #ifdef JANET_WINDOWS
@@ -102,6 +103,13 @@ time_t timegm(struct tm *tm);
 #define timegm _mkgmtime
 #endif
 
+/* On Linux 5.3 and later, wait for subprocesses with a pidfd in the event
+ * loop rather than with a blocking waitpid on another thread. Older kernels
+ * fall back to the thread at runtime. Define JANET_NO_PIDFD to disable. */
+#if defined(JANET_EV) && defined(JANET_LINUX) && defined(SYS_pidfd_open) && !defined(JANET_NO_PIDFD)
+#define JANET_PROC_PIDFD
+#endif
+
 /* Access to some global variables should be synchronized if not in single threaded mode, as
  * setenv/getenv are not thread safe. */
 #ifdef JANET_THREADS
@@ -533,13 +541,8 @@ static JanetEVGenericMessage janet_proc_wait_subr(JanetEVGenericMessage args) {
 
 #else /* windows check */
 
-static int proc_get_status(JanetProc *proc) {
-    /* Use POSIX shell semantics for interpreting signals */
-    int status = 0;
-    pid_t result;
-    do {
-        result = waitpid(proc->pid, &status, 0);
-    } while (result == -1 && errno == EINTR);
+/* Use POSIX shell semantics for interpreting signals */
+static int proc_decode_status(int status) {
     if (WIFEXITED(status)) {
         status = WEXITSTATUS(status);
     } else if (WIFSTOPPED(status)) {
@@ -553,6 +556,15 @@ static int proc_get_status(JanetProc *proc) {
     return status;
 }
 
+static int proc_get_status(JanetProc *proc) {
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(proc->pid, &status, 0);
+    } while (result == -1 && errno == EINTR);
+    return proc_decode_status(status);
+}
+
 /* Function that is called in separate thread to wait on a pid */
 static JanetEVGenericMessage janet_proc_wait_subr(JanetEVGenericMessage args) {
     JanetProc *proc = (JanetProc *) args.argp;
@@ -562,28 +574,79 @@ static JanetEVGenericMessage janet_proc_wait_subr(JanetEVGenericMessage args) {
 
 #endif /* End windows check */
 
+/* Record the exit status of a process and resume the fiber waiting on it */
+static void janet_proc_finish(JanetProc *proc, JanetFiber *fiber, int status) {
+    proc->return_code = (int32_t) status;
+    proc->flags |= JANET_PROC_WAITED;
+    proc->flags &= ~JANET_PROC_WAITING;
+    if ((status != 0) && (proc->flags & JANET_PROC_ERROR_NONZERO)) {
+        JanetString s = janet_formatc("command failed with non-zero exit code %d", status);
+        janet_cancel(fiber, janet_wrap_string(s));
+    } else {
+        janet_schedule(fiber, janet_wrap_integer(status));
+    }
+}
+
 /* Callback that is called in main thread when subroutine completes. */
 static void janet_proc_wait_cb(JanetEVGenericMessage args) {
     JanetProc *proc = (JanetProc *) args.argp;
     if (NULL != proc) {
-        int status = args.tag;
-        proc->return_code = (int32_t) status;
-        proc->flags |= JANET_PROC_WAITED;
-        proc->flags &= ~JANET_PROC_WAITING;
         janet_gcunroot(janet_wrap_abstract(proc));
         janet_gcunroot(janet_wrap_fiber(args.fiber));
         uint32_t sched_id = (uint32_t) args.argi;
         if (janet_fiber_can_resume(args.fiber) && args.fiber->sched_id == sched_id) {
-            if ((status != 0) && (proc->flags & JANET_PROC_ERROR_NONZERO)) {
-                JanetString s = janet_formatc("command failed with non-zero exit code %d", status);
-                janet_cancel(args.fiber, janet_wrap_string(s));
+            janet_proc_finish(proc, args.fiber, args.tag);
+        } else {
+            proc->return_code = (int32_t) args.tag;
+            proc->flags |= JANET_PROC_WAITED;
+            proc->flags &= ~JANET_PROC_WAITING;
+        }
+    }
+}
+
+#ifdef JANET_PROC_PIDFD
+
+/* A pidfd becomes readable once its process exits */
+static void janet_proc_pidfd_cb(JanetFiber *fiber, JanetAsyncEvent event) {
+    JanetProc *proc = *((JanetProc **) fiber->ev_state);
+    JanetStream *stream = fiber->ev_stream;
+    switch (event) {
+        default:
+            break;
+        case JANET_ASYNC_EVENT_MARK:
+            janet_mark(janet_wrap_abstract(proc));
+            break;
+        case JANET_ASYNC_EVENT_DEINIT:
+            /* If the wait was canceled, the process can be waited on again */
+            proc->flags &= ~JANET_PROC_WAITING;
+            break;
+        case JANET_ASYNC_EVENT_CLOSE:
+        case JANET_ASYNC_EVENT_ERR:
+        case JANET_ASYNC_EVENT_HUP:
+        case JANET_ASYNC_EVENT_INIT:
+        case JANET_ASYNC_EVENT_READ: {
+            int status = 0;
+            pid_t result;
+            do {
+                result = waitpid(proc->pid, &status, WNOHANG);
+            } while (result == -1 && errno == EINTR);
+            if (result == 0) break; /* still running */
+            janet_async_end(fiber);
+            janet_stream_close(stream);
+            if (result == -1) {
+                proc->flags &= ~JANET_PROC_WAITING;
+                proc->flags |= JANET_PROC_WAITED;
+                janet_cancel(fiber, janet_ev_lasterr());
             } else {
-                janet_schedule(args.fiber, janet_wrap_integer(status));
+                janet_proc_finish(proc, fiber, proc_decode_status(status));
             }
+            break;
         }
     }
 }
 
+#endif
+
 #endif /* End ev check */
 
 static int janet_proc_gc(void *p, size_t s) {
@@ -629,8 +692,21 @@ os_proc_wait_impl(JanetProc *proc) {
         janet_panicf("cannot wait twice on a process");
     }
 #ifdef JANET_EV
-    /* Event loop implementation - threaded call */
     proc->flags |= JANET_PROC_WAITING;
+#ifdef JANET_PROC_PIDFD
+    /* Event loop implementation - pidfd */
+    int pidfd = (int) syscall(SYS_pidfd_open, proc->pid, 0);
+    if (pidfd >= 0) {
+        JanetStream *stream = janet_stream(pidfd, JANET_STREAM_READABLE, NULL);
+        JanetProc **state = janet_malloc(sizeof(JanetProc *));
+        if (NULL == state) {
+            JANET_OUT_OF_MEMORY;
+        }
+        *state = proc;
+        janet_async_start(stream, JANET_ASYNC_LISTEN_READ, janet_proc_pidfd_cb, state);
+    }
+#endif
+    /* Event loop implementation - threaded call */
     JanetEVGenericMessage targs;
     memset(&targs, 0, sizeof(targs));
     targs.argp = proc;
@@ -2364,17 +2440,28 @@ static const struct OsStatGetter os_stat_getters[] = {
     {NULL, NULL}
 };
 
+static Janet os_stat_get(const uint8_t *key, jstat_t *st) {
+    for (const struct OsStatGetter *sg = os_stat_getters; sg->name != NULL; sg++) {
+        if (janet_cstrcmp(key, sg->name)) continue;
+        return sg->fn(st);
+    }
+    janet_panicf("unexpected keyword %v", janet_wrap_keyword(key));
+}
+
 static Janet os_stat_or_lstat(int do_lstat, int32_t argc, Janet *argv) {
     janet_sandbox_assert(JANET_SANDBOX_FS_READ);
     janet_arity(argc, 1, 2);
     const char *path = janet_getcstring(argv, 0);
     JanetTable *tab = NULL;
     const uint8_t *key = NULL;
+    JanetView keys = {NULL, 0};
     if (argc == 2) {
         if (janet_checktype(argv[1], JANET_KEYWORD)) {
             key = janet_getkeyword(argv, 1);
-        } else {
+        } else if (janet_checktype(argv[1], JANET_TABLE)) {
             tab = janet_gettable(argv, 1);
+        } else {
+            keys = janet_getindexed(argv, 1);
         }
     } else {
         tab = janet_table(0);
@@ -2397,7 +2484,17 @@ static Janet os_stat_or_lstat(int do_lstat, int32_t argc, Janet *argv) {
         return janet_wrap_nil();
     }
 
-    if (NULL == key) {
+    if (NULL != keys.items) {
+        /* Get the selected results as a tuple */
+        Janet *values = janet_tuple_begin(keys.len);
+        for (int32_t i = 0; i < keys.len; i++) {
+            if (!janet_checktype(keys.items[i], JANET_KEYWORD)) {
+                janet_panicf("expected keyword, got %v", keys.items[i]);
+            }
+            values[i] = os_stat_get(janet_unwrap_keyword(keys.items[i]), &st);
+        }
+        return janet_wrap_tuple(janet_tuple_end(values));
+    } else if (NULL == key) {
         /* Put results in table */
         for (const struct OsStatGetter *sg = os_stat_getters; sg->name != NULL; sg++) {
             janet_table_put(tab, janet_ckeywordv(sg->name), sg->fn(&st));
@@ -2405,18 +2502,17 @@ static Janet os_stat_or_lstat(int do_lstat, int32_t argc, Janet *argv) {
         return janet_wrap_table(tab);
     } else {
         /* Get one result */
-        for (const struct OsStatGetter *sg = os_stat_getters; sg->name != NULL; sg++) {
-            if (janet_cstrcmp(key, sg->name)) continue;
-            return sg->fn(&st);
-        }
-        janet_panicf("unexpected keyword %v", janet_wrap_keyword(key));
+        return os_stat_get(key, &st);
     }
 }
 
 JANET_CORE_FN(os_stat,
-              "(os/stat path &opt tab|key)",
-              "Gets information about a file or directory. Returns a table if the second argument is a keyword, returns "
-              "only that information from stat. If the file or directory does not exist, returns nil. The keys are:\n\n"
+              "(os/stat path &opt tab|key|keys)",
+              "Gets information about a file or directory. Returns a table with all of the keys below, filling in `tab` "
+              "if it is given so that one table can be reused across calls. If the second argument is a keyword, returns "
+              "only that information from stat. If it is an array or tuple of keywords, returns a tuple with "
+              "those values in order, so several fields can be read with one call. "
+              "If the file or directory does not exist, returns nil. The keys are:\n\n"
               "* :dev - the device that the file is on\n\n"
               "* :mode - the type of file, one of :file, :directory, :block, :character, :fifo, :socket, :link, or :other\n\n"
               "* :int-permissions - A Unix permission integer like 8r744\n\n"
@@ -2435,7 +2531,7 @@ JANET_CORE_FN(os_stat,
 }
 
 JANET_CORE_FN(os_lstat,
-              "(os/lstat path &opt tab|key)",
+              "(os/lstat path &opt tab|key|keys)",
               "Like os/stat, but don't follow symlinks.\n") {
     return os_stat_or_lstat(1, argc, argv);
 }
@@ -2523,6 +2619,405 @@ JANET_CORE_FN(os_dir,
     return janet_wrap_array(paths);
 }
 
+/* Lazy directory listing */
+
+typedef struct {
+#ifdef JANET_WINDOWS
+    intptr_t handle;
+    struct _finddata_t afile;
+    int pending; /* afile holds an entry that has not been returned yet */
+#else
+    DIR *dfd;
+#endif
+    int open;
+    int with_mode;
+    int32_t index;
+    Janet current;
+    JanetString path;
+} JanetDirIter;
+
+static void os_dir_iter_close_impl(JanetDirIter *iter) {
+    if (!iter->open) return;
+    iter->open = 0;
+#ifdef JANET_WINDOWS
+    _findclose(iter->handle);
+#else
+    closedir(iter->dfd);
+#endif
+}
+
+static int os_dir_iter_gc(void *p, size_t s) {
+    (void) s;
+    os_dir_iter_close_impl((JanetDirIter *) p);
+    return 0;
+}
+
+static int os_dir_iter_mark(void *p, size_t s) {
+    (void) s;
+    JanetDirIter *iter = (JanetDirIter *) p;
+    janet_mark(iter->current);
+    if (NULL != iter->path) janet_mark(janet_wrap_string(iter->path));
+    return 0;
+}
+
+static Janet os_dir_iter_entry(JanetDirIter *iter, const char *name, const uint8_t *mode) {
+    Janet namev = janet_cstringv(name);
+    if (!iter->with_mode) return namev;
+    Janet pair[2] = {namev, janet_wrap_keyword(mode)};
+    return janet_wrap_tuple(janet_tuple_n(pair, 2));
+}
+
+/* Read the next entry into iter->current. Returns 0 at the end of the directory. */
+static int os_dir_iter_read(JanetDirIter *iter) {
+    if (!iter->open) return 0;
+#ifdef JANET_WINDOWS
+    for (;;) {
+        if (!iter->pending && _findnext(iter->handle, &iter->afile) == -1) {
+            os_dir_iter_close_impl(iter);
+            return 0;
+        }
+        iter->pending = 0;
+        const char *name = iter->afile.name;
+        if (!strcmp(".", name) || !strcmp("..", name)) continue;
+        const char *mode = (iter->afile.attrib & _A_SUBDIR) ? "directory" : "file";
+        iter->current = os_dir_iter_entry(iter, name, janet_ckeyword(mode));
+        return 1;
+    }
+#else
+    for (;;) {
+        errno = 0;
+        struct dirent *dp = readdir(iter->dfd);
+        if (dp == NULL) {
+            int olderr = errno;
+            os_dir_iter_close_impl(iter);
+            if (olderr) {
+                janet_panicf("failed to read directory %S: %s", iter->path, janet_strerror(olderr));
+            }
+            return 0;
+        }
+        if (!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, "..")) continue;
+        const uint8_t *mode = NULL;
+        if (iter->with_mode) {
+            const char *str = NULL;
+#ifdef DT_UNKNOWN
+            switch (dp->d_type) {
+                default:
+                    break;
+                case DT_REG:
+                    str = "file";
+                    break;
+                case DT_DIR:
+                    str = "directory";
+                    break;
+                case DT_LNK:
+                    str = "link";
+                    break;
+                case DT_FIFO:
+                    str = "fifo";
+                    break;
+                case DT_SOCK:
+                    str = "socket";
+                    break;
+                case DT_CHR:
+                    str = "character";
+                    break;
+                case DT_BLK:
+                    str = "block";
+                    break;
+            }
+#endif
+            if (NULL != str) {
+                mode = janet_ckeyword(str);
+            } else {
+                /* The file system did not say, fall back to lstat */
+                struct stat st;
+                JanetString full = janet_formatc("%S/%s", iter->path, dp->d_name);
+                mode = lstat((const char *) full, &st) ? janet_ckeyword("other") : janet_decode_mode(st.st_mode);
+            }
+        }
+        iter->current = os_dir_iter_entry(iter, dp->d_name, mode);
+        return 1;
+    }
+#endif
+}
+
+static Janet os_dir_iter_close(int32_t argc, Janet *argv);
+
+static const JanetMethod dir_iter_methods[] = {
+    {"close", os_dir_iter_close},
+    {NULL, NULL}
+};
+
+static int os_dir_iter_get(void *p, Janet key, Janet *out) {
+    JanetDirIter *iter = (JanetDirIter *) p;
+    if (janet_checktype(key, JANET_KEYWORD)) {
+        return janet_getmethod(janet_unwrap_keyword(key), dir_iter_methods, out);
+    }
+    /* Keys are handed out by next, the value is always the latest entry */
+    if (!janet_checkint(key) || janet_unwrap_integer(key) != iter->index) return 0;
+    *out = iter->current;
+    return 1;
+}
+
+static Janet os_dir_iter_next(void *p, Janet key) {
+    JanetDirIter *iter = (JanetDirIter *) p;
+    if (janet_checktype(key, JANET_NIL) && iter->index >= 0) {
+        janet_panic("directory iterator can only be traversed once");
+    }
+    if (!os_dir_iter_read(iter)) {
+        iter->current = janet_wrap_nil();
+        return janet_wrap_nil();
+    }
+    return janet_wrap_integer(++iter->index);
+}
+
+static const JanetAbstractType DirIterAT = {
+    "core/dir-iter",
+    os_dir_iter_gc,
+    os_dir_iter_mark,
+    os_dir_iter_get,
+    NULL, /* put */
+    NULL, /* marshal */
+    NULL, /* unmarshal */
+    NULL, /* tostring */
+    NULL, /* compare */
+    NULL, /* hash */
+    os_dir_iter_next,
+    JANET_ATEND_NEXT
+};
+
+static Janet os_dir_iter_close(int32_t argc, Janet *argv) {
+    janet_fixarity(argc, 1);
+    JanetDirIter *iter = janet_getabstract(argv, 0, &DirIterAT);
+    os_dir_iter_close_impl(iter);
+    iter->current = janet_wrap_nil();
+    return janet_wrap_nil();
+}
+
+JANET_CORE_FN(os_dir_iter,
+              "(os/dir-iter dir &opt with-mode)",
+              "Open a directory for lazy iteration with `each`, `loop` or `next`. Entries are read from the operating "
+              "system one at a time instead of building an array like `os/dir`. Each value is a file or directory name with "
+              "no prefix, or, if `with-mode` is truthy, a tuple `[name mode]` where mode is a keyword as returned by "
+              "`(os/lstat path :mode)`. The mode comes from the directory listing itself when the file system provides "
+              "it, so no extra stat call is needed. The iterator can be traversed once, and closes the directory when "
+              "it is exhausted, when it is garbage collected, or when `(:close iter)` is called.") {
+    janet_sandbox_assert(JANET_SANDBOX_FS_READ);
+    janet_arity(argc, 1, 2);
+    const char *dir = janet_getcstring(argv, 0);
+    JanetDirIter *iter = janet_abstract(&DirIterAT, sizeof(JanetDirIter));
+    iter->open = 0;
+    iter->with_mode = argc > 1 && janet_truthy(argv[1]);
+    iter->index = -1;
+    iter->current = janet_wrap_nil();
+    iter->path = janet_cstring(dir);
+#ifdef JANET_WINDOWS
+    char pattern[MAX_PATH + 1];
+    if (strlen(dir) > (sizeof(pattern) - 3))
+        janet_panicf("path too long: %s", dir);
+    sprintf(pattern, "%s/*", dir);
+    iter->handle = _findfirst(pattern, &iter->afile);
+    if (-1 == iter->handle) janet_panicf("cannot open directory %s: %s", dir, janet_strerror(errno));
+    iter->pending = 1;
+#else
+    iter->dfd = opendir(dir);
+    if (iter->dfd == NULL) janet_panicf("cannot open directory %s: %s", dir, janet_strerror(errno));
+#endif
+    iter->open = 1;
+    return janet_wrap_abstract(iter);
+}
+
+/* Recursive directory listing, done without the Janet VM so that it can run
+ * on the thread pool. Paths are collected NUL separated in one buffer. */
+
+#define OS_WALK_ALL 0
+#define OS_WALK_FILES 1
+#define OS_WALK_DIRECTORIES 2
+
+typedef struct {
+    char *root;
+    int filter;
+    int err;
+    int32_t count;
+    size_t len;
+    size_t cap;
+    char *data;
+} OsWalk;
+
+static int os_walk_push(OsWalk *w, const char *path, size_t n) {
+    if (w->count == INT32_MAX) return ENOMEM;
+    if (w->len + n + 1 > w->cap) {
+        size_t newcap = (w->len + n + 1) * 2;
+        char *newdata = janet_realloc(w->data, newcap);
+        if (NULL == newdata) return ENOMEM;
+        w->data = newdata;
+        w->cap = newcap;
+    }
+    memcpy(w->data + w->len, path, n + 1);
+    w->len += n + 1;
+    w->count++;
+    return 0;
+}
+
+/* Returns 0 or an errno value. Only failing to open the root or running out
+ * of memory are errors, unreadable subdirectories are skipped. */
+static int os_walk_dir(OsWalk *w, const char *dir, int is_root) {
+    size_t dlen = strlen(dir);
+    if (dlen && (dir[dlen - 1] == '/' || dir[dlen - 1] == '\\')) dlen--;
+    int err = 0;
+#ifdef JANET_WINDOWS
+    struct _finddata_t afile;
+    char *pattern = janet_malloc(dlen + 3);
+    if (NULL == pattern) return ENOMEM;
+    memcpy(pattern, dir, dlen);
+    memcpy(pattern + dlen, "/*", 3);
+    intptr_t handle = _findfirst(pattern, &afile);
+    janet_free(pattern);
+    if (-1 == handle) return is_root ? errno : 0;
+    do {
+        const char *name = afile.name;
+        int isdir = (afile.attrib & _A_SUBDIR) != 0;
+#else
+    DIR *dfd = opendir(dir);
+    if (NULL == dfd) return is_root ? errno : 0;
+    struct dirent *dp;
+    while ((dp = readdir(dfd)) != NULL) {
+        const char *name = dp->d_name;
+        int isdir = -1;
+#ifdef DT_UNKNOWN
+        if (dp->d_type != DT_UNKNOWN) isdir = dp->d_type == DT_DIR;
+#endif
+#endif
+        if (!strcmp(name, ".") || !strcmp(name, "..")) continue;
+        size_t nlen = strlen(name);
+        char *child = janet_malloc(dlen + nlen + 2);
+        if (NULL == child) {
+            err = ENOMEM;
+            break;
+        }
+        memcpy(child, dir, dlen);
+        child[dlen] = '/';
+        memcpy(child + dlen + 1, name, nlen + 1);
+#ifndef JANET_WINDOWS
+        if (isdir < 0) {
+            struct stat st;
+            isdir = !lstat(child, &st) && S_ISDIR(st.st_mode);
+        }
+#endif
+        if (w->filter != (isdir ? OS_WALK_FILES : OS_WALK_DIRECTORIES)) {
+            err = os_walk_push(w, child, dlen + nlen + 1);
+        }
+        if (!err && isdir) err = os_walk_dir(w, child, 0);
+        janet_free(child);
+        if (err) break;
+#ifdef JANET_WINDOWS
+    } while (_findnext(handle, &afile) != -1);
+    _findclose(handle);
+#else
+    }
+    closedir(dfd);
+#endif
+    return err;
+}
+
+static Janet os_walk_result(OsWalk *w) {
+    if (w->err) {
+        JanetString msg = janet_formatc("cannot walk directory %s: %s", w->root, janet_strerror(w->err));
+        janet_free(w->root);
+        janet_free(w->data);
+        janet_free(w);
+        return janet_wrap_string(msg);
+    }
+    JanetArray *paths = janet_array(w->count);
+    const char *cursor = w->data;
+    for (int32_t i = 0; i < w->count; i++) {
+        size_t n = strlen(cursor);
+        janet_array_push(paths, janet_stringv((const uint8_t *) cursor, (int32_t) n));
+        cursor += n + 1;
+    }
+    janet_free(w->root);
+    janet_free(w->data);
+    janet_free(w);
+    return janet_wrap_array(paths);
+}
+
+#ifdef JANET_EV
+
+/* Runs in a separate thread */
+static JanetEVGenericMessage os_walk_subr(JanetEVGenericMessage args) {
+    OsWalk *w = (OsWalk *) args.argp;
+    w->err = os_walk_dir(w, w->root, 1);
+    return args;
+}
+
+/* Called in the main thread when the walk completes */
+static void os_walk_cb(JanetEVGenericMessage args) {
+    OsWalk *w = (OsWalk *) args.argp;
+    int err = w->err;
+    Janet result = os_walk_result(w);
+    janet_gcunroot(janet_wrap_fiber(args.fiber));
+    uint32_t sched_id = (uint32_t) args.argi;
+    if (janet_fiber_can_resume(args.fiber) && args.fiber->sched_id == sched_id) {
+        if (err) {
+            janet_cancel(args.fiber, result);
+        } else {
+            janet_schedule(args.fiber, result);
+        }
+    }
+}
+
+#endif
+
+JANET_CORE_FN(os_walk,
+              "(os/walk dir &opt filter)",
+              "List all files and directories below `dir`, recursively, as an array of paths that start with `dir`. "
+              "A directory comes before its contents, and symbolic links are listed but not followed. `filter` "
+              "can be `:file` to only list things that are not directories, or `:directory` to only list directories. "
+              "Subdirectories that cannot be read are skipped. The walk runs on the thread pool used by "
+              "`ev/thread` and other blocking calls, so it does not block the event loop, and several walks, "
+              "for example of the subdirectories of a large tree, can run in parallel with `ev/gather`.") {
+    janet_sandbox_assert(JANET_SANDBOX_FS_READ);
+    janet_arity(argc, 1, 2);
+    const char *dir = janet_getcstring(argv, 0);
+    int filter = OS_WALK_ALL;
+    if (argc > 1 && !janet_checktype(argv[1], JANET_NIL)) {
+        const uint8_t *kw = janet_getkeyword(argv, 1);
+        if (!janet_cstrcmp(kw, "file")) {
+            filter = OS_WALK_FILES;
+        } else if (!janet_cstrcmp(kw, "directory")) {
+            filter = OS_WALK_DIRECTORIES;
+        } else {
+            janet_panicf("expected :file or :directory, got %v", argv[1]);
+        }
+    }
+    OsWalk *w = janet_malloc(sizeof(OsWalk));
+    if (NULL == w) {
+        JANET_OUT_OF_MEMORY;
+    }
+    memset(w, 0, sizeof(OsWalk));
+    w->filter = filter;
+    w->root = strdup(dir);
+    if (NULL == w->root) {
+        JANET_OUT_OF_MEMORY;
+    }
+#ifdef JANET_EV
+    JanetEVGenericMessage targs;
+    memset(&targs, 0, sizeof(targs));
+    targs.argp = w;
+    targs.fiber = janet_root_fiber();
+    targs.argi = (uint32_t) targs.fiber->sched_id;
+    janet_gcroot(janet_wrap_fiber(targs.fiber));
+    janet_ev_threaded_call(os_walk_subr, targs, os_walk_cb);
+    janet_await();
+#else
+    w->err = os_walk_dir(w, w->root, 1);
+    int err = w->err;
+    Janet result = os_walk_result(w);
+    if (err) janet_panicv(result);
+    return result;
+#endif
+}
+
 JANET_CORE_FN(os_rename,
               "(os/rename oldname newname)",
               "Rename a file on disk to a new path. Returns nil.") {
@@ -2843,6 +3338,8 @@ void janet_lib_os(JanetTable *env) {
 
         /* fs read */
         JANET_CORE_REG("os/dir", os_dir),
+        JANET_CORE_REG("os/dir-iter", os_dir_iter),
+        JANET_CORE_REG("os/walk", os_walk),
         JANET_CORE_REG("os/stat", os_stat),
         JANET_CORE_REG("os/lstat", os_lstat),
         JANET_CORE_REG("os/chmod", os_chmod),
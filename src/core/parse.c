@@ -140,6 +140,22 @@ DEF_PARSER_STACK(_pushstate, JanetParseState, states, statecount, statecap)
 
 #undef DEF_PARSER_STACK
 
+/* Push many bytes to the buffer at once */
+static void push_bufn(JanetParser *p, const uint8_t *bytes, size_t n) {
+    size_t newcount = p->bufcount + n;
+    if (newcount > p->bufcap) {
+        size_t newcap = 2 * newcount;
+        uint8_t *next = janet_realloc(p->buf, newcap);
+        if (NULL == next) {
+            JANET_OUT_OF_MEMORY;
+        }
+        p->buf = next;
+        p->bufcap = newcap;
+    }
+    memcpy(p->buf + p->bufcount, bytes, n);
+    p->bufcount = newcount;
+}
+
 #define PFLAG_CONTAINER 0x100
 #define PFLAG_BUFFER 0x200
 #define PFLAG_PARENS 0x400
@@ -723,6 +739,59 @@ void janet_parser_consume(JanetParser *parser, uint8_t c) {
     parser->lookback = c;
 }
 
+/* Find the length of the run of bytes at the start of bytes that the current
+ * state would consume without changing state, and feed the run to that state
+ * directly. Runs never contain newlines, so only the column moves. */
+static int32_t parser_consume_run(JanetParser *p, const uint8_t *bytes, int32_t len) {
+    JanetParseState *state = p->states + p->statecount - 1;
+    Consumer consumer = state->consumer;
+    int32_t n = 0;
+    if (consumer == tokenchar) {
+        int nonascii = 0;
+        while (n < len && janet_is_symbol_char(bytes[n])) {
+            nonascii |= bytes[n] > 127;
+            n++;
+        }
+        if (nonascii) state->argn = 1;
+    } else if (consumer == stringchar) {
+        const uint8_t *end = memchr(bytes, '"', (size_t) len);
+        int32_t limit = end ? (int32_t)(end - bytes) : len;
+        while (n < limit && bytes[n] != '\\' && bytes[n] != '\n' && bytes[n] != '\r') n++;
+    } else if (consumer == comment) {
+        while (n < len && bytes[n] != '\n' && bytes[n] != '\r') n++;
+    } else if (consumer == longstring && (state->flags & PFLAG_INSTRING)) {
+        while (n < len && bytes[n] != '`' && bytes[n] != '\n' && bytes[n] != '\r') n++;
+    } else if (consumer == root) {
+        while (n < len && (bytes[n] == ' ' || bytes[n] == '\t')) n++;
+        if (n) {
+            p->column += (size_t) n;
+            p->lookback = bytes[n - 1];
+        }
+        return n;
+    }
+    if (n) {
+        push_bufn(p, bytes, (size_t) n);
+        p->column += (size_t) n;
+        p->lookback = bytes[n - 1];
+    }
+    return n;
+}
+
+int32_t janet_parser_consume_bytes(JanetParser *parser, const uint8_t *bytes, int32_t len) {
+    janet_parser_checkdead(parser);
+    size_t pending = parser->pending;
+    int32_t i = 0;
+    while (i < len && !parser->error && parser->pending == pending) {
+        int32_t n = parser_consume_run(parser, bytes + i, len - i);
+        if (n) {
+            i += n;
+        } else {
+            janet_parser_consume(parser, bytes[i++]);
+        }
+    }
+    return i;
+}
+
 void janet_parser_eof(JanetParser *parser) {
     janet_parser_checkdead(parser);
     size_t oldcolumn = parser->column;
@@ -932,15 +1001,15 @@ JANET_CORE_FN(cfun_parse_consume,
         view.len -= offset;
         view.bytes += offset;
     }
-    int32_t i;
-    for (i = 0; i < view.len; i++) {
-        janet_parser_consume(p, view.bytes[i]);
+    int32_t i = 0;
+    while (i < view.len) {
+        i += janet_parser_consume_bytes(p, view.bytes + i, view.len - i);
         switch (janet_parser_status(p)) {
             case JANET_PARSE_ROOT:
             case JANET_PARSE_PENDING:
                 break;
             default:
-                return janet_wrap_integer(i + 1);
+                return janet_wrap_integer(i);
         }
     }
     return janet_wrap_integer(i);
@@ -44,20 +44,27 @@ typedef struct {
        input, which we need to generate a line mapping */
     const uint8_t *outer_text_end;
     const uint32_t *bytecode;
+    const uint32_t *first;
     const Janet *constants;
     JanetArray *captures;
     JanetBuffer *scratch;
     JanetBuffer *tags;
     JanetArray *tagged_captures;
+    JanetBuffer *memo;
+    JanetArray *memo_captures;
+    JanetBuffer *memo_scratch;
     const Janet *extrav;
     int32_t *linemap;
     int32_t extrac;
     int32_t depth;
     int32_t linemaplen;
     int32_t has_backref;
+    int32_t memo_count;
+    int32_t hit_end;
     enum {
         PEG_MODE_NORMAL,
-        PEG_MODE_ACCUMULATE
+        PEG_MODE_ACCUMULATE,
+        PEG_MODE_DISCARD
     } mode;
 } PegState;
 
@@ -96,6 +103,7 @@ static void cap_load_keept(PegState *s, CapState cs) {
 
 /* Add a capture */
 static void pushcap(PegState *s, Janet capture, uint32_t tag) {
+    if (s->mode == PEG_MODE_DISCARD) return;
     if (s->mode == PEG_MODE_ACCUMULATE) {
         janet_to_string_b(s->scratch, capture);
     }
@@ -165,6 +173,128 @@ static int64_t peg_convert_u64_s64(uint64_t from, int width) {
     return ((int64_t)(from << shift)) >> shift;
 }
 
+/* Results of memoized rules, keyed on rule, position, end of text and mode.
+ * Stored in an open addressing hash table in s->memo. The captures and
+ * accumulated bytes a rule produced are kept in s->memo_captures and
+ * s->memo_scratch so they can be replayed. */
+typedef struct {
+    uint32_t slot; /* slot + 1, or 0 for an empty entry */
+    int32_t position;
+    int32_t end;
+    int32_t mode;
+    int32_t result; /* offset after the match, or -1 if the rule failed */
+    int32_t cap;
+    int32_t ncap;
+    int32_t scratch;
+    int32_t nscratch;
+} PegMemo;
+
+static uint32_t peg_memo_hash(uint32_t slot, int32_t position) {
+    uint32_t h = slot * 0x9E3779B1u;
+    h ^= (uint32_t) position + 0x7F4A7C15u + (h << 6) + (h >> 2);
+    return h;
+}
+
+/* Find the entry for a key, or the empty entry where it belongs */
+static PegMemo *peg_memo_find(PegMemo *table, int32_t capacity, uint32_t slot, int32_t position, int32_t end, int32_t mode) {
+    uint32_t mask = (uint32_t) capacity - 1;
+    uint32_t i = peg_memo_hash(slot, position) & mask;
+    for (;;) {
+        PegMemo *m = table + i;
+        if (m->slot == 0) return m;
+        if (m->slot == slot + 1 && m->position == position && m->end == end && m->mode == mode) return m;
+        i = (i + 1) & mask;
+    }
+}
+
+static PegMemo *peg_memo_get(PegState *s, uint32_t slot, const uint8_t *text) {
+    if (NULL == s->memo) {
+        s->memo = janet_buffer(64 * sizeof(PegMemo));
+        s->memo->count = 64 * sizeof(PegMemo);
+        memset(s->memo->data, 0, s->memo->count);
+        s->memo_captures = janet_array(0);
+        s->memo_scratch = janet_buffer(0);
+        s->memo_count = 0;
+    }
+    return peg_memo_find((PegMemo *) s->memo->data, s->memo->count / (int32_t) sizeof(PegMemo),
+                         slot, (int32_t)(text - s->text_start), (int32_t)(s->text_end - s->text_start), s->mode);
+}
+
+/* Add a new entry, growing the table if needed. Returns the entry. */
+static PegMemo *peg_memo_put(PegState *s, uint32_t slot, const uint8_t *text) {
+    int32_t capacity = s->memo->count / (int32_t) sizeof(PegMemo);
+    if (2 * (s->memo_count + 1) > capacity) {
+        if (capacity > INT32_MAX / 2 / (int32_t) sizeof(PegMemo)) {
+            janet_panic("peg memo table too large");
+        }
+        JanetBuffer *old = s->memo;
+        s->memo = janet_buffer(2 * capacity * (int32_t) sizeof(PegMemo));
+        s->memo->count = 2 * capacity * (int32_t) sizeof(PegMemo);
+        memset(s->memo->data, 0, s->memo->count);
+        const PegMemo *olds = (const PegMemo *) old->data;
+        for (int32_t i = 0; i < capacity; i++) {
+            if (olds[i].slot == 0) continue;
+            *peg_memo_find((PegMemo *) s->memo->data, 2 * capacity, olds[i].slot - 1,
+                           olds[i].position, olds[i].end, olds[i].mode) = olds[i];
+        }
+    }
+    PegMemo *m = peg_memo_get(s, slot, text);
+    m->slot = slot + 1;
+    m->position = (int32_t)(text - s->text_start);
+    m->end = (int32_t)(s->text_end - s->text_start);
+    m->mode = s->mode;
+    s->memo_count++;
+    return m;
+}
+
+/* Note that a rule looked at the end of the input, so its result could
+ * change if the input were longer. peg/find-partial uses this to ask
+ * for more input. */
+#define peg_hit_end(s) do { \
+    if ((s)->text_end == (s)->outer_text_end) (s)->hit_end = 1; \
+} while (0)
+
+/* Check if a rule could match at text based on its first-byte set. */
+static int peg_first_check(PegState *s, uint32_t rule, const uint8_t *text) {
+    uint32_t index = s->first[rule];
+    if (!index) return 1;
+    if (text >= s->text_end) {
+        peg_hit_end(s);
+        return 0;
+    }
+    return (s->first[index + (*text >> 5)] >> (*text & 0x1F)) & 1;
+}
+
+/* Get the bytes matched by a single byte rule (see peg_span_ok) */
+static void peg_span_bitmap(const uint32_t *bytecode, const uint32_t *rule, uint32_t *bitmap) {
+    int negate = 0;
+    if (rule[0] == RULE_IFNOT) {
+        negate = 1;
+        rule = bytecode + rule[1];
+    }
+    switch (rule[0]) {
+        default:
+            memcpy(bitmap, rule + 1, 8 * sizeof(uint32_t));
+            break;
+        case RULE_RANGE: {
+            uint32_t lo = rule[1] & 0xFF;
+            uint32_t hi = (rule[1] >> 16) & 0xFF;
+            memset(bitmap, 0, 8 * sizeof(uint32_t));
+            for (uint32_t c = lo; c <= hi; c++)
+                bitmap[c >> 5] |= (uint32_t) 1 << (c & 0x1F);
+            break;
+        }
+        case RULE_LITERAL: {
+            uint8_t c = ((const uint8_t *)(rule + 2))[0];
+            memset(bitmap, 0, 8 * sizeof(uint32_t));
+            bitmap[c >> 5] |= (uint32_t) 1 << (c & 0x1F);
+            break;
+        }
+    }
+    if (negate)
+        for (int i = 0; i < 8; i++) bitmap[i] = ~bitmap[i];
+}
+
 /* Prevent stack overflow */
 #define down1(s) do { \
     if (0 == --((s)->depth)) janet_panic("peg/match recursed too deeply"); \
@@ -190,32 +320,49 @@ tail:
 
         case RULE_LITERAL: {
             uint32_t len = rule[1];
-            if (text + len > s->text_end) return NULL;
+            if (text + len > s->text_end) {
+                peg_hit_end(s);
+                return NULL;
+            }
             return memcmp(text, rule + 2, len) ? NULL : text + len;
         }
 
         case RULE_NCHAR: {
             uint32_t n = rule[1];
-            return (text + n > s->text_end) ? NULL : text + n;
+            if (text + n > s->text_end) {
+                peg_hit_end(s);
+                return NULL;
+            }
+            return text + n;
         }
 
         case RULE_NOTNCHAR: {
             uint32_t n = rule[1];
-            return (text + n > s->text_end) ? text : NULL;
+            if (text + n > s->text_end) {
+                peg_hit_end(s);
+                return text;
+            }
+            return NULL;
         }
 
         case RULE_RANGE: {
             uint8_t lo = rule[1] & 0xFF;
             uint8_t hi = (rule[1] >> 16) & 0xFF;
-            return (text < s->text_end &&
-                    text[0] >= lo &&
+            if (text >= s->text_end) {
+                peg_hit_end(s);
+                return NULL;
+            }
+            return (text[0] >= lo &&
                     text[0] <= hi)
                    ? text + 1
                    : NULL;
         }
 
         case RULE_SET: {
-            if (text >= s->text_end) return NULL;
+            if (text >= s->text_end) {
+                peg_hit_end(s);
+                return NULL;
+            }
             uint32_t word = rule[1 + (text[0] >> 5)];
             uint32_t mask = (uint32_t)1 << (text[0] & 0x1F);
             return (word & mask)
@@ -225,7 +372,11 @@ tail:
 
         case RULE_LOOK: {
             text += ((int32_t *)rule)[1];
-            if (text < s->text_start || text > s->text_end) return NULL;
+            if (text < s->text_start) return NULL;
+            if (text > s->text_end) {
+                peg_hit_end(s);
+                return NULL;
+            }
             down1(s);
             const uint8_t *result = peg_rule(s, s->bytecode + rule[2], text);
             up1(s);
@@ -240,6 +391,7 @@ tail:
             down1(s);
             CapState cs = cap_save(s);
             for (uint32_t i = 0; i < len - 1; i++) {
+                if (!peg_first_check(s, args[i], text)) continue;
                 const uint8_t *result = peg_rule(s, s->bytecode + args[i], text);
                 if (result) {
                     up1(s);
@@ -248,6 +400,7 @@ tail:
                 cap_load(s, cs);
             }
             up1(s);
+            if (!peg_first_check(s, args[len - 1], text)) return NULL;
             rule = s->bytecode + args[len - 1];
             goto tail;
         }
@@ -325,12 +478,52 @@ tail:
             }
             up1(s);
             if (text > s->text_end) {
+                peg_hit_end(s);
                 cap_load(s, cs);
                 return NULL;
             }
             return rule[0] == RULE_TO ? text : next_text;
         }
 
+        case RULE_SPAN: {
+            /* Specialized RULE_BETWEEN that matches its rule inline */
+            uint32_t lo = rule[1];
+            uint32_t hi = rule[2];
+            const uint32_t *rule_a = s->bytecode + rule[3];
+            uint32_t captured = 0;
+            if (rule_a[0] == RULE_LITERAL) {
+                uint32_t len = rule_a[1];
+                while (captured < hi) {
+                    if (text + len > s->text_end) {
+                        peg_hit_end(s);
+                        break;
+                    }
+                    if (memcmp(text, rule_a + 2, len)) break;
+                    text += len;
+                    captured++;
+                }
+            } else if (rule_a[0] == RULE_NCHAR) {
+                uint32_t n = rule_a[1];
+                uint32_t available = (uint32_t)(s->text_end - text) / n;
+                if (available < hi) peg_hit_end(s);
+                captured = available < hi ? available : hi;
+                text += (size_t) captured * n;
+            } else {
+                uint32_t bitmap[8];
+                peg_span_bitmap(s->bytecode, rule_a, bitmap);
+                while (captured < hi) {
+                    if (text >= s->text_end) {
+                        peg_hit_end(s);
+                        break;
+                    }
+                    if (!(bitmap[*text >> 5] & ((uint32_t) 1 << (*text & 0x1F)))) break;
+                    text++;
+                    captured++;
+                }
+            }
+            return captured < lo ? NULL : text;
+        }
+
         case RULE_BETWEEN: {
             uint32_t lo = rule[1];
             uint32_t hi = rule[2];
@@ -377,12 +570,14 @@ tail:
         }
 
         case RULE_LINE: {
+            if (s->mode == PEG_MODE_DISCARD) return text;
             LineCol lc = get_linecol_from_position(s, (int32_t)(text - s->text_start));
             pushcap(s, janet_wrap_number((double)(lc.line)), rule[1]);
             return text;
         }
 
         case RULE_COLUMN: {
+            if (s->mode == PEG_MODE_DISCARD) return text;
             LineCol lc = get_linecol_from_position(s, (int32_t)(text - s->text_start));
             pushcap(s, janet_wrap_number((double)(lc.col)), rule[1]);
             return text;
@@ -406,7 +601,9 @@ tail:
             up1(s);
             if (!result) return NULL;
             /* Specialized pushcap - avoid intermediate string creation */
-            if (!s->has_backref && s->mode == PEG_MODE_ACCUMULATE) {
+            if (s->mode == PEG_MODE_DISCARD) {
+                return result;
+            } else if (!s->has_backref && s->mode == PEG_MODE_ACCUMULATE) {
                 janet_buffer_push_bytes(s->scratch, text, (int32_t)(result - text));
             } else {
                 uint32_t tag = rule[2];
@@ -437,7 +634,7 @@ tail:
         case RULE_ACCUMULATE: {
             uint32_t tag = rule[2];
             int oldmode = s->mode;
-            if (!tag && oldmode == PEG_MODE_ACCUMULATE) {
+            if ((!tag && oldmode == PEG_MODE_ACCUMULATE) || oldmode == PEG_MODE_DISCARD) {
                 rule = s->bytecode + rule[1];
                 goto tail;
             }
@@ -478,6 +675,10 @@ tail:
         case RULE_GROUP: {
             uint32_t tag = rule[2];
             int oldmode = s->mode;
+            if (oldmode == PEG_MODE_DISCARD) {
+                rule = s->bytecode + rule[1];
+                goto tail;
+            }
             CapState cs = cap_save(s);
             s->mode = PEG_MODE_NORMAL;
             down1(s);
@@ -563,6 +764,7 @@ tail:
             up1(s);
 
             if (!terminus_end) {
+                peg_hit_end(s);
                 return NULL;
             }
 
@@ -581,6 +783,8 @@ tail:
         }
 
         case RULE_SPLIT: {
+            /* Always splits up to the end of the text */
+            peg_hit_end(s);
             const uint8_t *saved_end = s->text_end;
             const uint32_t *rule_separator = s->bytecode + rule[1];
             const uint32_t *rule_subpattern = s->bytecode + rule[2];
@@ -625,6 +829,11 @@ tail:
         case RULE_MATCHTIME: {
             uint32_t tag = rule[3];
             int oldmode = s->mode;
+            /* Replacements only change captures, so there is nothing to do */
+            if (rule[0] == RULE_REPLACE && oldmode == PEG_MODE_DISCARD) {
+                rule = s->bytecode + rule[1];
+                goto tail;
+            }
             CapState cs = cap_save(s);
             s->mode = PEG_MODE_NORMAL;
             down1(s);
@@ -697,8 +906,10 @@ tail:
                         return NULL;
                     const uint8_t *bytes = janet_unwrap_string(capture);
                     int32_t len = janet_string_length(bytes);
-                    if (text + len > s->text_end)
+                    if (text + len > s->text_end) {
+                        peg_hit_end(s);
                         return NULL;
+                    }
                     return memcmp(text, bytes, len) ? NULL : text + len;
                 }
             }
@@ -713,8 +924,8 @@ tail:
             down1(s);
             next_text = peg_rule(s, s->bytecode + rule[1], text);
             up1(s);
-            if (NULL == next_text) return NULL;
             s->mode = oldmode;
+            if (NULL == next_text) return NULL;
             int32_t num_sub_captures = s->captures->count - cs.cap;
             Janet lencap;
             if (num_sub_captures <= 0 ||
@@ -737,12 +948,51 @@ tail:
             return next_text;
         }
 
+        case RULE_MEMO: {
+            /* Earlier tagged captures can change what a rule matches */
+            if (s->has_backref) {
+                rule = s->bytecode + rule[1];
+                goto tail;
+            }
+            PegMemo *m = peg_memo_get(s, rule[2], text);
+            if (m->slot) {
+                if (m->result < 0) return NULL;
+                for (int32_t i = 0; i < m->ncap; i++)
+                    janet_array_push(s->captures, s->memo_captures->data[m->cap + i]);
+                janet_buffer_push_bytes(s->scratch, s->memo_scratch->data + m->scratch, m->nscratch);
+                return s->text_start + m->result;
+            }
+            CapState cs = cap_save(s);
+            down1(s);
+            const uint8_t *result = peg_rule(s, s->bytecode + rule[1], text);
+            up1(s);
+            /* The table may have moved while matching the rule */
+            m = peg_memo_put(s, rule[2], text);
+            if (!result) {
+                m->result = -1;
+                m->cap = m->ncap = m->scratch = m->nscratch = 0;
+                return NULL;
+            }
+            m->result = (int32_t)(result - s->text_start);
+            m->cap = s->memo_captures->count;
+            m->ncap = s->captures->count - cs.cap;
+            m->scratch = s->memo_scratch->count;
+            m->nscratch = s->scratch->count - cs.scratch;
+            for (int32_t i = 0; i < m->ncap; i++)
+                janet_array_push(s->memo_captures, s->captures->data[cs.cap + i]);
+            janet_buffer_push_bytes(s->memo_scratch, s->scratch->data + cs.scratch, m->nscratch);
+            return result;
+        }
+
         case RULE_READINT: {
             uint32_t tag = rule[2];
             uint32_t signedness = rule[1] & 0x10;
             uint32_t endianness = rule[1] & 0x20;
             int width = (int)(rule[1] & 0xF);
-            if (text + width > s->text_end) return NULL;
+            if (text + width > s->text_end) {
+                peg_hit_end(s);
+                return NULL;
+            }
             uint64_t accum = 0;
             if (endianness) {
                 /* BE */
@@ -819,6 +1069,8 @@ typedef struct {
     int depth;
     uint32_t nexttag;
     int has_backref;
+    int memo;
+    uint32_t nmemo;
 } Builder;
 
 /* Forward declaration to allow recursion */
@@ -1385,11 +1637,14 @@ static uint32_t peg_compile1(Builder *b, Janet peg) {
     JanetTable *old_grammar = b->grammar;
     b->form = peg;
 
-    /* Resolve keyword references */
+    /* Resolve keyword references. In memo mode, rules that are
+     * referenced by name from a grammar are memoized. */
     int i = JANET_RECURSION_GUARD;
+    int memoize = 0;
     JanetTable *grammar = old_grammar;
     for (; i > 0 && janet_checktype(peg, JANET_KEYWORD); --i) {
         Janet nextPeg = janet_table_get_ex(grammar, peg, &grammar);
+        memoize = b->memo;
         if (!grammar || janet_checktype(nextPeg, JANET_NIL)) {
             nextPeg = (b->default_grammar == NULL)
                       ? janet_wrap_nil()
@@ -1397,6 +1652,7 @@ static uint32_t peg_compile1(Builder *b, Janet peg) {
             if (janet_checktype(nextPeg, JANET_NIL)) {
                 peg_panic(b, "unknown rule");
             }
+            memoize = 0;
         }
         peg = nextPeg;
         b->form = peg;
@@ -1437,6 +1693,10 @@ static uint32_t peg_compile1(Builder *b, Janet peg) {
         janet_table_put(which_grammar, peg, janet_wrap_number(rule));
     }
 
+    /* The memoized rule follows the memo instruction */
+    memoize = memoize && janet_checktype(peg, JANET_TUPLE);
+    Reserve memo_reserve = reserve(b, memoize ? 3 : 0);
+
     switch (janet_type(peg)) {
         default:
             peg_panic(b, "unexpected peg source");
@@ -1528,6 +1788,10 @@ static uint32_t peg_compile1(Builder *b, Janet peg) {
         }
     }
 
+    if (memoize) {
+        emit_2(memo_reserve, RULE_MEMO, memo_reserve.index + 3, b->nmemo++);
+    }
+
     /* Increase depth again */
     b->depth++;
     b->form = old_form;
@@ -1535,10 +1799,305 @@ static uint32_t peg_compile1(Builder *b, Janet peg) {
     return rule;
 }
 
+/*
+ * First-byte analysis
+ *
+ * For each rule we compute the set of bytes that the rule can start
+ * a match with, and whether the rule is "open" - it might succeed
+ * without the next byte being in that set (for example, by matching
+ * the empty string). A rule that is not open cannot succeed, and has no
+ * side effects, when the next byte is not in its set. peg/find and
+ * friends use the set of the main rule to skip over hopeless offsets, and
+ * choices use the sets of their alternatives to avoid trying them.
+ */
+
+#define PEG_FIRST_VISITING 0x1
+#define PEG_FIRST_DONE 0x2
+#define PEG_FIRST_OPEN 0x4
+#define PEG_FIRST_MAXDEPTH 256
+
+typedef struct {
+    const uint32_t *bytecode;
+    uint32_t *sets;
+    uint8_t *flags;
+    int effects;
+} PegFirst;
+
+static int peg_first(PegFirst *f, uint32_t r, uint32_t *out, int depth);
+
+/* Conservative result - any byte, might not consume */
+static int peg_first_any(uint32_t *out) {
+    for (int i = 0; i < 8; i++) out[i] = 0xFFFFFFFFu;
+    return 1;
+}
+
+/* Result for rules that run sub rules somewhere other than the
+ * current position, and so only matter if they can have side effects. */
+static int peg_first_none(PegFirst *f, uint32_t *out) {
+    return f->effects ? peg_first_any(out) : 1;
+}
+
+static int peg_first_uncached(PegFirst *f, const uint32_t *rule, uint32_t *out, int depth) {
+    switch (rule[0]) {
+        default:
+            return peg_first_any(out);
+        case RULE_LITERAL:
+            if (rule[1] == 0) return 1;
+            {
+                uint8_t c = ((const uint8_t *)(rule + 2))[0];
+                out[c >> 5] |= 1u << (c & 0x1F);
+            }
+            return 0;
+        case RULE_NCHAR:
+            if (rule[1] == 0) return 1;
+            peg_first_any(out);
+            return 0;
+        case RULE_READINT:
+            if ((rule[1] & 0xF) == 0) return 1;
+            peg_first_any(out);
+            return 0;
+        case RULE_RANGE: {
+            uint32_t lo = rule[1] & 0xFFFF;
+            uint32_t hi = rule[1] >> 16;
+            for (uint32_t c = lo; c <= hi && c < 256; c++)
+                out[c >> 5] |= 1u << (c & 0x1F);
+            return 0;
+        }
+        case RULE_SET:
+            for (int i = 0; i < 8; i++) out[i] |= rule[1 + i];
+            return 0;
+        case RULE_NOTNCHAR:
+        case RULE_GETTAG:
+        case RULE_POSITION:
+        case RULE_LINE:
+        case RULE_COLUMN:
+        case RULE_ARGUMENT:
+        case RULE_CONSTANT:
+            /* Never consume anything */
+            return 1;
+        case RULE_LOOK:
+            if (rule[1] == 0) return peg_first(f, rule[2], out, depth);
+            return peg_first_none(f, out);
+        case RULE_NOT:
+        case RULE_IF:
+        case RULE_IFNOT:
+            if (f->effects) return peg_first_any(out);
+            if (rule[0] == RULE_NOT) return 1;
+            return peg_first(f, rule[2], out, depth);
+        case RULE_CHOICE: {
+            int open = 0;
+            for (uint32_t i = 0; i < rule[1]; i++)
+                open |= peg_first(f, rule[2 + i], out, depth);
+            return open;
+        }
+        case RULE_SEQUENCE:
+            for (uint32_t i = 0; i < rule[1]; i++)
+                if (!peg_first(f, rule[2 + i], out, depth)) return 0;
+            return 1;
+        case RULE_BETWEEN:
+        case RULE_SPAN:
+            return peg_first(f, rule[3], out, depth) || rule[1] == 0;
+        case RULE_CAPTURE:
+        case RULE_CAPTURE_NUM:
+        case RULE_ACCUMULATE:
+        case RULE_GROUP:
+        case RULE_UNREF:
+        case RULE_DROP:
+        case RULE_ONLY_TAGS:
+        case RULE_MEMO:
+            return peg_first(f, rule[1], out, depth);
+        case RULE_NTH:
+            return peg_first(f, rule[2], out, depth);
+        case RULE_REPLACE:
+        case RULE_MATCHTIME:
+        case RULE_ERROR:
+        case RULE_SUB: {
+            /* The first rule must match here before anything else runs */
+            int open = peg_first(f, rule[1], out, depth);
+            if (open && f->effects) return peg_first_any(out);
+            return open;
+        }
+        case RULE_LENPREFIX:
+            if (peg_first(f, rule[1], out, depth)) return peg_first_any(out);
+            return 0;
+    }
+}
+
+/* Add the first-byte set of a rule to out, and return if the rule is open. */
+static int peg_first(PegFirst *f, uint32_t r, uint32_t *out, int depth) {
+    uint32_t *set = f->sets + 8 * (size_t) r;
+    if (f->flags[r] & PEG_FIRST_DONE) {
+        for (int i = 0; i < 8; i++) out[i] |= set[i];
+        return !!(f->flags[r] & PEG_FIRST_OPEN);
+    }
+    if ((f->flags[r] & PEG_FIRST_VISITING) || depth <= 0) {
+        /* Recursive rules are not analyzed */
+        return peg_first_any(out);
+    }
+    f->flags[r] |= PEG_FIRST_VISITING;
+    uint32_t local[8] = {0};
+    int open = peg_first_uncached(f, f->bytecode + r, local, depth - 1);
+    for (int i = 0; i < 8; i++) {
+        set[i] = local[i];
+        out[i] |= local[i];
+    }
+    f->flags[r] = PEG_FIRST_DONE | (open ? PEG_FIRST_OPEN : 0);
+    return open;
+}
+
+/* Get the size of an instruction in words */
+static uint32_t peg_rule_size(const uint32_t *rule) {
+    switch (rule[0]) {
+        default:
+            return 2;
+        case RULE_LITERAL:
+            return 2 + ((rule[1] + 3) >> 2);
+        case RULE_SET:
+            return 9;
+        case RULE_CHOICE:
+        case RULE_SEQUENCE:
+            return 2 + rule[1];
+        case RULE_LOOK:
+        case RULE_IF:
+        case RULE_IFNOT:
+        case RULE_LENPREFIX:
+        case RULE_ARGUMENT:
+        case RULE_GETTAG:
+        case RULE_CONSTANT:
+        case RULE_ACCUMULATE:
+        case RULE_GROUP:
+        case RULE_CAPTURE:
+        case RULE_UNREF:
+        case RULE_SUB:
+        case RULE_TIL:
+        case RULE_SPLIT:
+        case RULE_READINT:
+        case RULE_MEMO:
+            return 3;
+        case RULE_BETWEEN:
+        case RULE_SPAN:
+        case RULE_CAPTURE_NUM:
+        case RULE_REPLACE:
+        case RULE_MATCHTIME:
+        case RULE_NTH:
+            return 4;
+    }
+}
+
+/* Returns an index that is non-zero if a rule has a useful first-byte set */
+static uint32_t peg_first_entry(PegFirst *f, uint32_t r, uint32_t *first, uint32_t *count) {
+    uint32_t set[8] = {0};
+    if (peg_first(f, r, set, PEG_FIRST_MAXDEPTH)) return 0;
+    uint32_t all = 0xFFFFFFFFu;
+    for (int i = 0; i < 8; i++) all &= set[i];
+    if (all == 0xFFFFFFFFu) return 0;
+    if (first[r]) return first[r];
+    uint32_t index = *count;
+    memcpy(first + index, set, sizeof(set));
+    *count += 8;
+    return first[r] = index;
+}
+
+/* Check if a rule always consumes a fixed, non-zero number of bytes
+ * and captures nothing, so RULE_SPAN can match it inline. */
+static int peg_span_ok(const uint32_t *bytecode, const uint32_t *rule) {
+    switch (rule[0]) {
+        default:
+            return 0;
+        case RULE_SET:
+        case RULE_RANGE:
+            return 1;
+        case RULE_LITERAL:
+        case RULE_NCHAR:
+            return rule[1] > 0;
+        case RULE_IFNOT: {
+            /* (if-not byte 1) */
+            const uint32_t *a = bytecode + rule[1];
+            const uint32_t *b = bytecode + rule[2];
+            if (b[0] != RULE_NCHAR || b[1] != 1) return 0;
+            return a[0] == RULE_SET || a[0] == RULE_RANGE || (a[0] == RULE_LITERAL && a[1] == 1);
+        }
+    }
+}
+
+/* Replace repetitions of simple rules with RULE_SPAN, which matches
+ * them in a loop instead of recursing into peg_rule for each one. */
+static void peg_specialize(uint32_t *bytecode, uint32_t blen) {
+    for (uint32_t i = 0; i < blen; i += peg_rule_size(bytecode + i)) {
+        uint32_t *rule = bytecode + i;
+        if (rule[0] == RULE_BETWEEN && peg_span_ok(bytecode, bytecode + rule[3])) {
+            rule[0] = RULE_SPAN;
+        }
+    }
+}
+
+/* Check if any rule looks at captures to decide whether it matches. Such
+ * pegs still need capture stacks when matching with PEG_MODE_DISCARD. */
+static int peg_needs_captures(const uint32_t *bytecode, uint32_t blen) {
+    for (uint32_t i = 0; i < blen; i += peg_rule_size(bytecode + i)) {
+        switch (bytecode[i]) {
+            default:
+                break;
+            case RULE_MATCHTIME:
+            case RULE_LENPREFIX:
+            case RULE_NTH:
+            case RULE_ERROR:
+            case RULE_BACKMATCH:
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* Build the first-byte table for bytecode. The table has one word per
+ * instruction that is the index of its set in the table, or 0 if the
+ * instruction may match with any next byte. Only the main rule and
+ * the alternatives of choices are filled in. */
+static uint32_t *peg_first_table(const uint32_t *bytecode, uint32_t blen, const Janet *constants) {
+    PegFirst f;
+    f.bytecode = bytecode;
+    f.effects = 0;
+    uint32_t nentries = 1;
+    for (uint32_t i = 0; i < blen; i += peg_rule_size(bytecode + i)) {
+        const uint32_t *rule = bytecode + i;
+        if (rule[0] == RULE_CHOICE) nentries += rule[1];
+        if (rule[0] == RULE_MATCHTIME || rule[0] == RULE_ERROR) f.effects = 1;
+        if (rule[0] == RULE_REPLACE) {
+            Janet constant = constants[rule[2]];
+            if (janet_checktypes(constant, JANET_TFLAG_FUNCTION | JANET_TFLAG_CFUNCTION)) f.effects = 1;
+        }
+    }
+    f.flags = janet_calloc(blen + 1, 1);
+    f.sets = janet_malloc(sizeof(uint32_t) * 8 * ((size_t) blen + 1));
+    uint32_t *first = janet_calloc(blen + 8 * (size_t) nentries, sizeof(uint32_t));
+    if (NULL == f.flags || NULL == f.sets || NULL == first) {
+        JANET_OUT_OF_MEMORY;
+    }
+    uint32_t count = blen;
+    if (blen) peg_first_entry(&f, 0, first, &count);
+    for (uint32_t i = 0; i < blen; i += peg_rule_size(bytecode + i)) {
+        const uint32_t *rule = bytecode + i;
+        if (rule[0] == RULE_CHOICE) {
+            for (uint32_t j = 0; j < rule[1]; j++)
+                peg_first_entry(&f, rule[2 + j], first, &count);
+        }
+    }
+    janet_free(f.flags);
+    janet_free(f.sets);
+    return first;
+}
+
 /*
  * Post-Compilation
  */
 
+static int peg_gc(void *p, size_t size) {
+    (void) size;
+    JanetPeg *peg = (JanetPeg *)p;
+    janet_free(peg->first);
+    return 0;
+}
+
 static int peg_mark(void *p, size_t size) {
     (void) size;
     JanetPeg *peg = (JanetPeg *)p;
@@ -1553,8 +2112,16 @@ static void peg_marshal(void *p, JanetMarshalContext *ctx) {
     janet_marshal_size(ctx, peg->bytecode_len);
     janet_marshal_int(ctx, (int32_t)peg->num_constants);
     janet_marshal_abstract(ctx, p);
-    for (size_t i = 0; i < peg->bytecode_len; i++)
-        janet_marshal_int(ctx, (int32_t) peg->bytecode[i]);
+    size_t next_rule = 0;
+    for (size_t i = 0; i < peg->bytecode_len; i++) {
+        uint32_t word = peg->bytecode[i];
+        if (i == next_rule) {
+            next_rule += peg_rule_size(peg->bytecode + i);
+            /* Spans are only an in memory form of RULE_BETWEEN */
+            if (word == RULE_SPAN) word = RULE_BETWEEN;
+        }
+        janet_marshal_int(ctx, (int32_t) word);
+    }
     for (uint32_t j = 0; j < peg->num_constants; j++)
         janet_marshal_janet(ctx, peg->constants[j]);
 }
@@ -1586,6 +2153,7 @@ static void *peg_unmarshal(JanetMarshalContext *ctx) {
     Janet *constants = (Janet *)(mem + constants_start);
     peg->bytecode = NULL;
     peg->constants = NULL;
+    peg->first = NULL;
     peg->bytecode_len = bytecode_len;
     peg->num_constants = num_constants;
 
@@ -1709,6 +2277,12 @@ static void *peg_unmarshal(JanetMarshalContext *ctx) {
                 op_flags[rule[1]] |= 0x01;
                 i += 4;
                 break;
+            case RULE_MEMO:
+                /* [rule, slot] */
+                if (rule[1] >= blen) goto bad;
+                op_flags[rule[1]] |= 0x01;
+                i += 3;
+                break;
             case RULE_SUB:
             case RULE_TIL:
             case RULE_SPLIT:
@@ -1759,6 +2333,9 @@ static void *peg_unmarshal(JanetMarshalContext *ctx) {
     peg->constants = constants;
     peg->has_backref = has_backref;
     janet_free(op_flags);
+    peg_specialize(bytecode, blen);
+    peg->needs_captures = peg_needs_captures(bytecode, blen);
+    peg->first = peg_first_table(bytecode, blen, constants);
     return peg;
 
 bad:
@@ -1771,7 +2348,7 @@ static Janet peg_next(void *p, Janet key);
 
 const JanetAbstractType janet_peg_type = {
     "core/peg",
-    NULL,
+    peg_gc,
     peg_mark,
     cfun_peg_getter,
     NULL, /* put */
@@ -1800,11 +2377,14 @@ static JanetPeg *make_peg(Builder *b) {
     safe_memcpy(peg->constants, b->constants, constants_size);
     peg->bytecode_len = janet_v_count(b->bytecode);
     peg->has_backref = b->has_backref;
+    peg_specialize(peg->bytecode, (uint32_t) peg->bytecode_len);
+    peg->needs_captures = peg_needs_captures(peg->bytecode, (uint32_t) peg->bytecode_len);
+    peg->first = peg_first_table(peg->bytecode, (uint32_t) peg->bytecode_len, peg->constants);
     return peg;
 }
 
 /* Compiler entry point */
-static JanetPeg *compile_peg(Janet x) {
+static JanetPeg *compile_peg(Janet x, int memo) {
     Builder builder;
     builder.grammar = janet_table(0);
     builder.default_grammar = NULL;
@@ -1821,6 +2401,8 @@ static JanetPeg *compile_peg(Janet x) {
     builder.form = x;
     builder.depth = JANET_RECURSION_GUARD;
     builder.has_backref = 0;
+    builder.memo = memo;
+    builder.nmemo = 0;
     peg_compile1(&builder, x);
     JanetPeg *peg = make_peg(&builder);
     builder_cleanup(&builder);
@@ -1832,12 +2414,24 @@ static JanetPeg *compile_peg(Janet x) {
  */
 
 JANET_CORE_FN(cfun_peg_compile,
-              "(peg/compile peg)",
+              "(peg/compile peg &opt mode)",
               "Compiles a peg source data structure into a <core/peg>. This will speed up matching "
               "if the same peg will be used multiple times. Will also use `(dyn :peg-grammar)` to supplement "
-              "the grammar of the peg for otherwise undefined peg keywords.") {
-    janet_fixarity(argc, 1);
-    JanetPeg *peg = compile_peg(argv[0]);
+              "the grammar of the peg for otherwise undefined peg keywords. If `mode` is `:memo`, the "
+              "result of each rule referenced by name in a grammar is remembered for each position, "
+              "so that matching takes time linear in the length of the text at the cost of memory. "
+              "Memoized rules call matchtime functions at most once per position, and pegs that use "
+              "`backref` or `backmatch` are not memoized.") {
+    janet_arity(argc, 1, 2);
+    int memo = 0;
+    if (argc > 1 && !janet_checktype(argv[1], JANET_NIL)) {
+        const uint8_t *mode = janet_getkeyword(argv, 1);
+        if (janet_cstrcmp(mode, "memo")) {
+            janet_panicf("expected :memo, got %v", argv[1]);
+        }
+        memo = 1;
+    }
+    JanetPeg *peg = compile_peg(argv[0], memo);
     return janet_wrap_abstract(peg);
 }
 
@@ -1848,10 +2442,19 @@ typedef struct {
     JanetByteView bytes;
     Janet subst;
     int32_t start;
+    int can_skip;
+    JanetByteSet skip; /* Bytes the main rule can start a match with */
+    /* Empty capture stacks for matching without captures */
+    JanetArray nocaps;
+    JanetBuffer noscratch;
+    Janet nocap;
+    uint8_t nobyte;
 } PegCall;
 
-/* Initialize state for peg cfunctions */
-static PegCall peg_cfun_init(int32_t argc, Janet *argv, int get_replace) {
+/* Initialize state for peg cfunctions. If discard is set, captures are
+ * not kept, and pegs that never look at their captures do not allocate
+ * capture stacks at all. */
+static void peg_call_init(PegCall *c, int32_t argc, Janet *argv, int get_replace, int discard) {
     PegCall ret;
     int32_t min = get_replace ? 3 : 2;
     janet_arity(argc, min, -1);
@@ -1859,7 +2462,7 @@ static PegCall peg_cfun_init(int32_t argc, Janet *argv, int get_replace) {
             janet_abstract_type(janet_unwrap_abstract(argv[0])) == &janet_peg_type) {
         ret.peg = janet_unwrap_abstract(argv[0]);
     } else {
-        ret.peg = compile_peg(argv[0]);
+        ret.peg = compile_peg(argv[0], 0);
     }
     if (get_replace) {
         ret.subst = argv[1];
@@ -1867,32 +2470,77 @@ static PegCall peg_cfun_init(int32_t argc, Janet *argv, int get_replace) {
     } else {
         ret.bytes = janet_getbytes(argv, 1);
     }
+    discard = discard && !ret.peg->has_backref;
+    int nocaps = discard && !ret.peg->needs_captures;
     if (argc > min) {
         ret.start = janet_gethalfrange(argv, min, ret.bytes.len, "offset");
         ret.s.extrac = argc - min - 1;
-        ret.s.extrav = janet_tuple_n(argv + min + 1, argc - min - 1);
+        /* Without captures, no function is called that could move argv */
+        ret.s.extrav = nocaps ? argv + min + 1 : janet_tuple_n(argv + min + 1, argc - min - 1);
     } else {
         ret.start = 0;
         ret.s.extrac = 0;
         ret.s.extrav = NULL;
     }
-    ret.s.mode = PEG_MODE_NORMAL;
+    ret.s.mode = discard ? PEG_MODE_DISCARD : PEG_MODE_NORMAL;
     ret.s.text_start = ret.bytes.bytes;
     ret.s.text_end = ret.bytes.bytes + ret.bytes.len;
     ret.s.outer_text_end = ret.s.text_end;
     ret.s.depth = JANET_RECURSION_GUARD;
-    ret.s.captures = janet_array(0);
-    ret.s.tagged_captures = janet_array(0);
-    ret.s.scratch = janet_buffer(10);
-    ret.s.tags = janet_buffer(10);
+    if (!nocaps) {
+        ret.s.captures = janet_array(0);
+        ret.s.tagged_captures = janet_array(0);
+        ret.s.scratch = janet_buffer(10);
+        ret.s.tags = janet_buffer(10);
+    }
     ret.s.constants = ret.peg->constants;
     ret.s.bytecode = ret.peg->bytecode;
+    ret.s.first = ret.peg->first;
     ret.s.linemap = NULL;
     ret.s.linemaplen = -1;
+    ret.s.memo = NULL;
+    ret.s.memo_captures = NULL;
+    ret.s.memo_scratch = NULL;
+    ret.s.memo_count = 0;
+    ret.s.hit_end = 0;
     ret.s.has_backref = ret.peg->has_backref;
+    ret.can_skip = 0;
+    if (ret.peg->first && ret.peg->first[0]) {
+        const uint32_t *set = ret.peg->first + ret.peg->first[0];
+        uint8_t members[256];
+        int32_t count = 0;
+        for (int32_t c = 0; c < 256; c++) {
+            if (set[c >> 5] & ((uint32_t) 1 << (c & 0x1F))) members[count++] = (uint8_t) c;
+        }
+        janet_byteset_init(&ret.skip, members, count);
+        ret.can_skip = 1;
+    }
+    *c = ret;
+    if (nocaps) {
+        /* The stacks stay empty, so only their counts are ever touched */
+        memset(&c->nocaps, 0, sizeof(c->nocaps));
+        memset(&c->noscratch, 0, sizeof(c->noscratch));
+        c->nocaps.data = &c->nocap;
+        c->noscratch.data = &c->nobyte;
+        c->s.captures = &c->nocaps;
+        c->s.tagged_captures = &c->nocaps;
+        c->s.scratch = &c->noscratch;
+        c->s.tags = &c->noscratch;
+    }
+}
+
+static PegCall peg_cfun_init(int32_t argc, Janet *argv, int get_replace) {
+    PegCall ret;
+    peg_call_init(&ret, argc, argv, get_replace, 0);
     return ret;
 }
 
+/* Get the next offset at or after i where the main rule could match */
+static int32_t peg_call_skip(PegCall *c, int32_t i) {
+    if (!c->can_skip || i >= c->bytes.len) return i;
+    return i + janet_byteset_cspan(&c->skip, c->bytes.bytes + i, c->bytes.len - i);
+}
+
 static void peg_call_reset(PegCall *c) {
     c->s.depth = JANET_RECURSION_GUARD;
     c->s.captures->count = 0;
@@ -1910,11 +2558,33 @@ JANET_CORE_FN(cfun_peg_match,
     return result ? janet_wrap_array(c.s.captures) : janet_wrap_nil();
 }
 
+JANET_CORE_FN(cfun_peg_test,
+              "(peg/test peg text &opt start & args)",
+              "Check if a Parsing Expression Grammar matches a byte string. Returns a boolean. "
+              "Works like `(truthy? (peg/match peg text start ;args))`, but does not build any captures, "
+              "and so does not call replacement functions. Compile the peg first with `peg/compile` "
+              "to avoid allocating while matching.") {
+    PegCall c;
+    peg_call_init(&c, argc, argv, 0, 1);
+    const uint8_t *result = peg_rule(&c.s, c.s.bytecode, c.bytes.bytes + c.start);
+    return janet_wrap_boolean(result != NULL);
+}
+
+JANET_CORE_FN(cfun_peg_span,
+              "(peg/span peg text &opt start & args)",
+              "Match a Parsing Expression Grammar to a byte string and return the index where the match "
+              "ends, or nil if the peg does not match. Like `peg/test`, no captures are built.") {
+    PegCall c;
+    peg_call_init(&c, argc, argv, 0, 1);
+    const uint8_t *result = peg_rule(&c.s, c.s.bytecode, c.bytes.bytes + c.start);
+    return result ? janet_wrap_integer((int32_t)(result - c.bytes.bytes)) : janet_wrap_nil();
+}
+
 JANET_CORE_FN(cfun_peg_find,
               "(peg/find peg text &opt start & args)",
               "Find first index where the peg matches in text. Returns an integer, or nil if not found.") {
     PegCall c = peg_cfun_init(argc, argv, 0);
-    for (int32_t i = c.start; i < c.bytes.len; i++) {
+    for (int32_t i = peg_call_skip(&c, c.start); i < c.bytes.len; i = peg_call_skip(&c, i + 1)) {
         peg_call_reset(&c);
         if (peg_rule(&c.s, c.s.bytecode, c.bytes.bytes + i))
             return janet_wrap_integer(i);
@@ -1927,7 +2597,7 @@ JANET_CORE_FN(cfun_peg_find_all,
               "Find all indexes where the peg matches in text. Returns an array of integers.") {
     PegCall c = peg_cfun_init(argc, argv, 0);
     JanetArray *ret = janet_array(0);
-    for (int32_t i = c.start; i < c.bytes.len; i++) {
+    for (int32_t i = peg_call_skip(&c, c.start); i < c.bytes.len; i = peg_call_skip(&c, i + 1)) {
         peg_call_reset(&c);
         if (peg_rule(&c.s, c.s.bytecode, c.bytes.bytes + i))
             janet_array_push(ret, janet_wrap_integer(i));
@@ -1935,11 +2605,36 @@ JANET_CORE_FN(cfun_peg_find_all,
     return janet_wrap_array(ret);
 }
 
+JANET_CORE_FN(cfun_peg_find_partial,
+              "(peg/find-partial peg eof text &opt start & args)",
+              "Find the first index at or after `start` where the peg matches in text, when text "
+              "may be followed by more input. Unless `eof` is truthy, a match is only reported if it "
+              "cannot change when more input arrives. Returns a tuple of the index and an array of "
+              "captures if there is a match. Returns an integer index if more input is needed before "
+              "matching can continue at that index, in which case bytes before the index are no longer "
+              "needed. Returns nil if `eof` is truthy and there are no more matches. "
+              "Used to build `peg/stream-find-all`.") {
+    PegCall c = peg_cfun_init(argc, argv, 1);
+    int eof = janet_truthy(c.subst);
+    for (int32_t i = peg_call_skip(&c, c.start); i < c.bytes.len; i = peg_call_skip(&c, i + 1)) {
+        peg_call_reset(&c);
+        const uint8_t *result = peg_rule(&c.s, c.s.bytecode, c.bytes.bytes + i);
+        if (c.s.hit_end && !eof) return janet_wrap_integer(i);
+        if (result) {
+            Janet tup[2] = {janet_wrap_integer(i), janet_wrap_array(c.s.captures)};
+            return janet_wrap_tuple(janet_tuple_n(tup, 2));
+        }
+    }
+    return eof ? janet_wrap_nil() : janet_wrap_integer(c.bytes.len);
+}
+
 static Janet cfun_peg_replace_generic(int32_t argc, Janet *argv, int only_one) {
     PegCall c = peg_cfun_init(argc, argv, 1);
     JanetBuffer *ret = janet_buffer(0);
     int32_t trail = 0;
     for (int32_t i = c.start; i < c.bytes.len;) {
+        i = peg_call_skip(&c, i);
+        if (i >= c.bytes.len) break;
         peg_call_reset(&c);
         const uint8_t *result = peg_rule(&c.s, c.s.bytecode, c.bytes.bytes + i);
         if (NULL != result) {
@@ -2009,8 +2704,11 @@ void janet_lib_peg(JanetTable *env) {
     JanetRegExt cfuns[] = {
         JANET_CORE_REG("peg/compile", cfun_peg_compile),
         JANET_CORE_REG("peg/match", cfun_peg_match),
+        JANET_CORE_REG("peg/test", cfun_peg_test),
+        JANET_CORE_REG("peg/span", cfun_peg_span),
         JANET_CORE_REG("peg/find", cfun_peg_find),
         JANET_CORE_REG("peg/find-all", cfun_peg_find_all),
+        JANET_CORE_REG("peg/find-partial", cfun_peg_find_partial),
         JANET_CORE_REG("peg/replace", cfun_peg_replace),
         JANET_CORE_REG("peg/replace-all", cfun_peg_replace_all),
         JANET_REG_END
@@ -0,0 +1,1061 @@
+/*
+* Copyright (c) 2025 Calvin Rose & contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/* Persistent maps and vectors. Both are tries of immutable nodes, so an
+ * update copies only the nodes on the path to the changed entry and shares
+ * everything else with the old value. Nodes are abstract values of internal
+ * types, which lets the garbage collector manage them. Updates never modify a
+ * node after it has been filled in, so no write barriers are needed. */
+
+#ifndef JANET_AMALG
+#include "features.h"
+#include <janet.h>
+#include "util.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+/* Conditional compilation */
+#ifdef JANET_PERSISTENT
+
+#define PTRIE_BITS 5
+#define PTRIE_WIDTH 32
+#define PTRIE_MASK 31
+
+#ifdef __GNUC__
+#define ptrie_popcount(x) __builtin_popcount(x)
+#else
+static int ptrie_popcount(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (int)((x * 0x01010101u) >> 24);
+}
+#endif
+
+/* Maps and vectors keep their hash up to date as they are updated. Each
+ * entry adds a well mixed value to the hash, so removing an entry is just a
+ * subtraction. */
+static uint32_t ptrie_mix(uint32_t a, uint32_t b) {
+    uint32_t h = a ^ (b * 0x9e3779b9u);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/*
+ * Hash array mapped trie
+ */
+
+/* Each node has a bitmap of which of its 32 slots are used, and the used
+ * slots packed in order. A slot with a nil key holds a child node in its
+ * value. Keys with the same 32 bit hash are kept in a collision node, which
+ * has an empty bitmap and its pairs in insertion order. */
+typedef struct {
+    uint32_t bitmap;
+    int32_t count;
+    JanetKV data[];
+} PMapNode;
+
+static int pmap_node_gcmark(void *p, size_t len) {
+    (void) len;
+    PMapNode *node = (PMapNode *) p;
+    for (int32_t i = 0; i < node->count; i++) {
+        janet_mark(node->data[i].key);
+        janet_mark(node->data[i].value);
+    }
+    return 0;
+}
+
+static const JanetAbstractType pmap_node_type = {
+    "core/pmap-node",
+    NULL,
+    pmap_node_gcmark,
+    JANET_ATEND_GCMARK
+};
+
+#define pmap_is_child(kv) janet_checktype((kv)->key, JANET_NIL)
+#define pmap_child(kv) ((const PMapNode *) janet_unwrap_abstract((kv)->value))
+
+static PMapNode *pmap_node(uint32_t bitmap, int32_t count) {
+    PMapNode *node = janet_abstract(&pmap_node_type, sizeof(PMapNode) + (size_t) count * sizeof(JanetKV));
+    node->bitmap = bitmap;
+    node->count = count;
+    return node;
+}
+
+static uint32_t pmap_slot(uint32_t hash, uint32_t shift) {
+    return 1u << ((hash >> shift) & PTRIE_MASK);
+}
+
+static int32_t pmap_index(const PMapNode *node, uint32_t bit) {
+    return ptrie_popcount(node->bitmap & (bit - 1));
+}
+
+static uint32_t pmap_entry_hash(uint32_t keyhash, Janet value) {
+    return ptrie_mix(keyhash, (uint32_t) janet_hash(value));
+}
+
+static const JanetKV *pmap_find(const PMapNode *node, Janet key, uint32_t hash) {
+    uint32_t shift = 0;
+    while (NULL != node) {
+        if (!node->bitmap) {
+            for (int32_t i = 0; i < node->count; i++) {
+                if (janet_equals(node->data[i].key, key)) return node->data + i;
+            }
+            return NULL;
+        }
+        uint32_t bit = pmap_slot(hash, shift);
+        if (!(node->bitmap & bit)) return NULL;
+        const JanetKV *kv = node->data + pmap_index(node, bit);
+        if (!pmap_is_child(kv)) {
+            return janet_equals(kv->key, key) ? kv : NULL;
+        }
+        node = pmap_child(kv);
+        shift += PTRIE_BITS;
+    }
+    return NULL;
+}
+
+/* Copy a node, leaving room for count entries */
+static PMapNode *pmap_copy(const PMapNode *node, uint32_t bitmap, int32_t count) {
+    PMapNode *copy = pmap_node(bitmap, count);
+    int32_t n = count < node->count ? count : node->count;
+    memcpy(copy->data, node->data, (size_t) n * sizeof(JanetKV));
+    return copy;
+}
+
+/* Make a node holding two pairs whose keys differ. Keys with equal hashes go
+ * into a collision node. Otherwise the hashes differ somewhere in their 32
+ * bits, so this recurses at most down to the last level. */
+static PMapNode *pmap_merge(uint32_t shift,
+                            Janet k1, Janet v1, uint32_t h1,
+                            Janet k2, Janet v2, uint32_t h2) {
+    if (h1 == h2) {
+        PMapNode *node = pmap_node(0, 2);
+        node->data[0].key = k1;
+        node->data[0].value = v1;
+        node->data[1].key = k2;
+        node->data[1].value = v2;
+        return node;
+    }
+    uint32_t b1 = pmap_slot(h1, shift);
+    uint32_t b2 = pmap_slot(h2, shift);
+    if (b1 == b2) {
+        PMapNode *node = pmap_node(b1, 1);
+        node->data[0].key = janet_wrap_nil();
+        node->data[0].value = janet_wrap_abstract(pmap_merge(shift + PTRIE_BITS, k1, v1, h1, k2, v2, h2));
+        return node;
+    }
+    PMapNode *node = pmap_node(b1 | b2, 2);
+    int first = b1 < b2 ? 0 : 1;
+    node->data[first].key = k1;
+    node->data[first].value = v1;
+    node->data[1 - first].key = k2;
+    node->data[1 - first].value = v2;
+    return node;
+}
+
+/* Return a copy of node with key set to value. If key was already in the
+ * map, set *replaced to its old pair. */
+static PMapNode *pmap_assoc(const PMapNode *node, uint32_t shift, Janet key, uint32_t hash,
+                            Janet value, const JanetKV **replaced) {
+    if (NULL == node) {
+        PMapNode *leaf = pmap_node(pmap_slot(hash, shift), 1);
+        leaf->data[0].key = key;
+        leaf->data[0].value = value;
+        return leaf;
+    }
+    if (!node->bitmap) {
+        uint32_t colhash = (uint32_t) janet_hash(node->data[0].key);
+        if (colhash != hash) {
+            /* Push the collision node down a level and add the key next to it */
+            PMapNode *wrap = pmap_node(pmap_slot(colhash, shift), 1);
+            wrap->data[0].key = janet_wrap_nil();
+            wrap->data[0].value = janet_wrap_abstract((void *) node);
+            return pmap_assoc(wrap, shift, key, hash, value, replaced);
+        }
+        for (int32_t i = 0; i < node->count; i++) {
+            if (janet_equals(node->data[i].key, key)) {
+                *replaced = node->data + i;
+                PMapNode *copy = pmap_copy(node, 0, node->count);
+                copy->data[i].value = value;
+                return copy;
+            }
+        }
+        PMapNode *copy = pmap_copy(node, 0, node->count + 1);
+        copy->data[node->count].key = key;
+        copy->data[node->count].value = value;
+        return copy;
+    }
+    uint32_t bit = pmap_slot(hash, shift);
+    int32_t index = pmap_index(node, bit);
+    if (!(node->bitmap & bit)) {
+        PMapNode *copy = pmap_node(node->bitmap | bit, node->count + 1);
+        memcpy(copy->data, node->data, (size_t) index * sizeof(JanetKV));
+        memcpy(copy->data + index + 1, node->data + index, (size_t)(node->count - index) * sizeof(JanetKV));
+        copy->data[index].key = key;
+        copy->data[index].value = value;
+        return copy;
+    }
+    const JanetKV *kv = node->data + index;
+    PMapNode *copy = pmap_copy(node, node->bitmap, node->count);
+    if (pmap_is_child(kv)) {
+        PMapNode *child = pmap_assoc(pmap_child(kv), shift + PTRIE_BITS, key, hash, value, replaced);
+        copy->data[index].value = janet_wrap_abstract(child);
+    } else if (janet_equals(kv->key, key)) {
+        *replaced = kv;
+        copy->data[index].value = value;
+    } else {
+        PMapNode *child = pmap_merge(shift + PTRIE_BITS,
+                                     kv->key, kv->value, (uint32_t) janet_hash(kv->key),
+                                     key, value, hash);
+        copy->data[index].key = janet_wrap_nil();
+        copy->data[index].value = janet_wrap_abstract(child);
+    }
+    return copy;
+}
+
+/* Copy a node without entry index */
+static PMapNode *pmap_without(const PMapNode *node, uint32_t bitmap, int32_t index) {
+    if (node->count == 1) return NULL;
+    PMapNode *copy = pmap_node(bitmap, node->count - 1);
+    memcpy(copy->data, node->data, (size_t) index * sizeof(JanetKV));
+    memcpy(copy->data + index, node->data + index + 1, (size_t)(node->count - index - 1) * sizeof(JanetKV));
+    return copy;
+}
+
+/* Return a copy of node without key, or node itself if key is not in it.
+ * Returns NULL once the node is empty. */
+static const PMapNode *pmap_dissoc(const PMapNode *node, uint32_t shift, Janet key, uint32_t hash,
+                                   const JanetKV **removed) {
+    if (NULL == node) return NULL;
+    if (!node->bitmap) {
+        for (int32_t i = 0; i < node->count; i++) {
+            if (janet_equals(node->data[i].key, key)) {
+                *removed = node->data + i;
+                return pmap_without(node, 0, i);
+            }
+        }
+        return node;
+    }
+    uint32_t bit = pmap_slot(hash, shift);
+    if (!(node->bitmap & bit)) return node;
+    int32_t index = pmap_index(node, bit);
+    const JanetKV *kv = node->data + index;
+    if (!pmap_is_child(kv)) {
+        if (!janet_equals(kv->key, key)) return node;
+        *removed = kv;
+        return pmap_without(node, node->bitmap & ~bit, index);
+    }
+    const PMapNode *child = pmap_child(kv);
+    const PMapNode *newchild = pmap_dissoc(child, shift + PTRIE_BITS, key, hash, removed);
+    if (newchild == child) return node;
+    if (NULL == newchild) return pmap_without(node, node->bitmap & ~bit, index);
+    PMapNode *copy = pmap_copy(node, node->bitmap, node->count);
+    if (newchild->count == 1 && !pmap_is_child(newchild->data)) {
+        /* Pull a lone pair up into this node */
+        copy->data[index] = newchild->data[0];
+    } else {
+        copy->data[index].value = janet_wrap_abstract((void *) newchild);
+    }
+    return copy;
+}
+
+/* Iteration follows the order of the slots, depth first */
+static const JanetKV *pmap_first(const PMapNode *node) {
+    while (NULL != node && node->count) {
+        const JanetKV *kv = node->data;
+        if (!pmap_is_child(kv)) return kv;
+        node = pmap_child(kv);
+    }
+    return NULL;
+}
+
+static const JanetKV *pmap_after(const PMapNode *node, uint32_t shift, Janet key, uint32_t hash) {
+    int32_t index;
+    if (!node->bitmap) {
+        for (index = 0; index < node->count; index++) {
+            if (janet_equals(node->data[index].key, key)) break;
+        }
+    } else {
+        uint32_t bit = pmap_slot(hash, shift);
+        if (!(node->bitmap & bit)) return NULL;
+        index = pmap_index(node, bit);
+        const JanetKV *kv = node->data + index;
+        if (pmap_is_child(kv)) {
+            const JanetKV *next = pmap_after(pmap_child(kv), shift + PTRIE_BITS, key, hash);
+            if (NULL != next) return next;
+        } else if (!janet_equals(kv->key, key)) {
+            return NULL;
+        }
+    }
+    if (index + 1 >= node->count) return NULL;
+    const JanetKV *next = node->data + index + 1;
+    return pmap_is_child(next) ? pmap_first(pmap_child(next)) : next;
+}
+
+/* Set a key in a map that has not been shared yet */
+static void pmap_set(JanetPMap *map, Janet key, Janet value) {
+    if (janet_checktype(key, JANET_NIL)) return;
+    if (janet_checktype(key, JANET_NUMBER) && isnan(janet_unwrap_number(key))) return;
+    uint32_t hash = (uint32_t) janet_hash(key);
+    uint32_t maphash = (uint32_t) map->hash;
+    const JanetKV *old = NULL;
+    if (janet_checktype(value, JANET_NIL)) {
+        map->root = (void *) pmap_dissoc(map->root, 0, key, hash, &old);
+        if (NULL == old) return;
+        map->count--;
+    } else {
+        map->root = pmap_assoc(map->root, 0, key, hash, value, &old);
+        maphash += pmap_entry_hash(hash, value);
+        if (NULL == old) map->count++;
+    }
+    if (NULL != old) maphash -= pmap_entry_hash(hash, old->value);
+    map->hash = (int32_t) maphash;
+}
+
+static JanetPMap *pmap_header(const JanetPMap *from) {
+    JanetPMap *map = janet_abstract(&janet_pmap_type, sizeof(JanetPMap));
+    if (NULL == from) {
+        map->count = 0;
+        map->hash = 0;
+        map->root = NULL;
+    } else {
+        *map = *from;
+    }
+    return map;
+}
+
+JanetPMap *janet_pmap(void) {
+    return pmap_header(NULL);
+}
+
+JanetPMap *janet_getpmap(const Janet *argv, int32_t n) {
+    return (JanetPMap *) janet_getabstract(argv, n, &janet_pmap_type);
+}
+
+Janet janet_pmap_get(const JanetPMap *map, Janet key) {
+    if (janet_checktype(key, JANET_NIL)) return janet_wrap_nil();
+    const JanetKV *kv = pmap_find(map->root, key, (uint32_t) janet_hash(key));
+    return NULL == kv ? janet_wrap_nil() : kv->value;
+}
+
+/* Returns a new map. A nil value removes the key. */
+JanetPMap *janet_pmap_put(const JanetPMap *map, Janet key, Janet value) {
+    JanetPMap *copy = pmap_header(map);
+    pmap_set(copy, key, value);
+    return copy;
+}
+
+JanetPMap *janet_pmap_remove(const JanetPMap *map, Janet key) {
+    return janet_pmap_put(map, key, janet_wrap_nil());
+}
+
+static int pmap_gcmark(void *p, size_t len) {
+    (void) len;
+    JanetPMap *map = (JanetPMap *) p;
+    if (NULL != map->root) janet_mark(janet_wrap_abstract(map->root));
+    return 0;
+}
+
+static int pmap_get(void *p, Janet key, Janet *out) {
+    JanetPMap *map = (JanetPMap *) p;
+    if (janet_checktype(key, JANET_NIL)) return 0;
+    const JanetKV *kv = pmap_find(map->root, key, (uint32_t) janet_hash(key));
+    if (NULL == kv) return 0;
+    *out = kv->value;
+    return 1;
+}
+
+static void pmap_put(void *p, Janet key, Janet value) {
+    (void) p;
+    (void) key;
+    (void) value;
+    janet_panic("persistent maps are immutable, use pmap/put");
+}
+
+static Janet pmap_next(void *p, Janet key) {
+    JanetPMap *map = (JanetPMap *) p;
+    const JanetKV *kv;
+    if (NULL == map->root) return janet_wrap_nil();
+    if (janet_checktype(key, JANET_NIL)) {
+        kv = pmap_first(map->root);
+    } else {
+        kv = pmap_after(map->root, 0, key, (uint32_t) janet_hash(key));
+    }
+    return NULL == kv ? janet_wrap_nil() : kv->key;
+}
+
+/* Check that every pair in node is also in other */
+static int pmap_subset(const PMapNode *node, const PMapNode *other) {
+    for (int32_t i = 0; i < node->count; i++) {
+        const JanetKV *kv = node->data + i;
+        if (pmap_is_child(kv)) {
+            if (!pmap_subset(pmap_child(kv), other)) return 0;
+        } else {
+            const JanetKV *okv = pmap_find(other, kv->key, (uint32_t) janet_hash(kv->key));
+            if (NULL == okv || !janet_equals(kv->value, okv->value)) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Maps with different contents are ordered by size, then hash. Maps that only
+ * differ in contents are ordered by address. */
+static int pmap_compare(void *lhs, void *rhs) {
+    JanetPMap *a = (JanetPMap *) lhs;
+    JanetPMap *b = (JanetPMap *) rhs;
+    if (a->count != b->count) return a->count < b->count ? -1 : 1;
+    if (a->hash != b->hash) return a->hash < b->hash ? -1 : 1;
+    if (a->root == b->root) return 0;
+    JanetTraversalState state;
+    janet_traversal_save(&state);
+    int same = pmap_subset(a->root, b->root);
+    janet_traversal_restore(&state);
+    if (same) return 0;
+    return a > b ? 1 : -1;
+}
+
+static int32_t pmap_hash(void *p, size_t len) {
+    (void) len;
+    JanetPMap *map = (JanetPMap *) p;
+    return (int32_t) ptrie_mix((uint32_t) map->hash, (uint32_t) map->count);
+}
+
+static void pmap_marshal_node(const PMapNode *node, JanetMarshalContext *ctx) {
+    for (int32_t i = 0; i < node->count; i++) {
+        const JanetKV *kv = node->data + i;
+        if (pmap_is_child(kv)) {
+            pmap_marshal_node(pmap_child(kv), ctx);
+        } else {
+            janet_marshal_janet(ctx, kv->key);
+            janet_marshal_janet(ctx, kv->value);
+        }
+    }
+}
+
+/* Marshalled as the number of pairs followed by the pairs */
+static void pmap_marshal(void *p, JanetMarshalContext *ctx) {
+    JanetPMap *map = (JanetPMap *) p;
+    janet_marshal_abstract(ctx, p);
+    janet_marshal_int(ctx, map->count);
+    if (NULL != map->root) pmap_marshal_node(map->root, ctx);
+}
+
+static void *pmap_unmarshal(JanetMarshalContext *ctx) {
+    JanetPMap *map = janet_unmarshal_abstract(ctx, sizeof(JanetPMap));
+    map->count = 0;
+    map->hash = 0;
+    map->root = NULL;
+    int32_t count = janet_unmarshal_int(ctx);
+    if (count < 0) janet_panic("invalid persistent map size");
+    for (int32_t i = 0; i < count; i++) {
+        Janet key = janet_unmarshal_janet(ctx);
+        Janet value = janet_unmarshal_janet(ctx);
+        pmap_set(map, key, value);
+    }
+    return map;
+}
+
+static void pmap_tostring(void *p, JanetBuffer *buffer) {
+    JanetPMap *map = (JanetPMap *) p;
+    janet_buffer_push_u8(buffer, '{');
+    const JanetKV *kv = NULL == map->root ? NULL : pmap_first(map->root);
+    int first = 1;
+    while (NULL != kv) {
+        if (!first) janet_buffer_push_u8(buffer, ' ');
+        first = 0;
+        janet_description_b(buffer, kv->key);
+        janet_buffer_push_u8(buffer, ' ');
+        janet_description_b(buffer, kv->value);
+        kv = pmap_after(map->root, 0, kv->key, (uint32_t) janet_hash(kv->key));
+    }
+    janet_buffer_push_u8(buffer, '}');
+}
+
+static Janet pmap_call(void *p, int32_t argc, Janet *argv) {
+    janet_arity(argc, 1, 2);
+    Janet value;
+    if (pmap_get(p, argv[0], &value)) return value;
+    return argc > 1 ? argv[1] : janet_wrap_nil();
+}
+
+static size_t pmap_length(void *p, size_t len) {
+    (void) len;
+    return (size_t)((JanetPMap *) p)->count;
+}
+
+const JanetAbstractType janet_pmap_type = {
+    "core/pmap",
+    NULL,
+    pmap_gcmark,
+    pmap_get,
+    pmap_put,
+    pmap_marshal,
+    pmap_unmarshal,
+    pmap_tostring,
+    pmap_compare,
+    pmap_hash,
+    pmap_next,
+    pmap_call,
+    pmap_length,
+    JANET_ATEND_LENGTH
+};
+
+/*
+ * Persistent vector
+ */
+
+/* Leaves hold up to 32 values, and inner nodes hold up to 32 children. Every
+ * leaf in the tree is full. The last 1 to 32 values live in a separate tail
+ * leaf, so pushing and popping usually copy only the tail. */
+typedef struct {
+    int32_t count;
+    Janet data[];
+} PVecNode;
+
+static int pvec_node_gcmark(void *p, size_t len) {
+    (void) len;
+    PVecNode *node = (PVecNode *) p;
+    for (int32_t i = 0; i < node->count; i++) {
+        janet_mark(node->data[i]);
+    }
+    return 0;
+}
+
+static const JanetAbstractType pvec_node_type = {
+    "core/pvec-node",
+    NULL,
+    pvec_node_gcmark,
+    JANET_ATEND_GCMARK
+};
+
+#define pvec_child(node, i) ((PVecNode *) janet_unwrap_abstract((node)->data[i]))
+
+static PVecNode *pvec_node(int32_t count) {
+    PVecNode *node = janet_abstract(&pvec_node_type, sizeof(PVecNode) + (size_t) count * sizeof(Janet));
+    node->count = count;
+    return node;
+}
+
+static PVecNode *pvec_copy(const PVecNode *node, int32_t count) {
+    PVecNode *copy = pvec_node(count);
+    int32_t n = count < node->count ? count : node->count;
+    memcpy(copy->data, node->data, (size_t) n * sizeof(Janet));
+    return copy;
+}
+
+static uint32_t pvec_entry_hash(int32_t index, Janet x) {
+    return ptrie_mix((uint32_t) janet_hash(x), (uint32_t) index);
+}
+
+static int32_t pvec_tailoff(const JanetPVec *vec) {
+    return vec->count < PTRIE_WIDTH ? 0 : ((vec->count - 1) >> PTRIE_BITS) << PTRIE_BITS;
+}
+
+/* Get the leaf holding index */
+static const PVecNode *pvec_leaf(const JanetPVec *vec, int32_t index) {
+    if (index >= pvec_tailoff(vec)) return vec->tail;
+    const PVecNode *node = vec->root;
+    for (int32_t level = vec->shift; level > 0; level -= PTRIE_BITS) {
+        node = pvec_child(node, (index >> level) & PTRIE_MASK);
+    }
+    return node;
+}
+
+static PVecNode *pvec_assoc(const PVecNode *node, int32_t level, int32_t index, Janet x) {
+    PVecNode *copy = pvec_copy(node, node->count);
+    if (level == 0) {
+        copy->data[index & PTRIE_MASK] = x;
+    } else {
+        int32_t sub = (index >> level) & PTRIE_MASK;
+        copy->data[sub] = janet_wrap_abstract(pvec_assoc(pvec_child(node, sub), level - PTRIE_BITS, index, x));
+    }
+    return copy;
+}
+
+static PVecNode *pvec_new_path(int32_t level, PVecNode *leaf) {
+    if (level == 0) return leaf;
+    PVecNode *node = pvec_node(1);
+    node->data[0] = janet_wrap_abstract(pvec_new_path(level - PTRIE_BITS, leaf));
+    return node;
+}
+
+/* Add a full leaf for the values just before count to the tree */
+static PVecNode *pvec_push_leaf(int32_t count, int32_t level, const PVecNode *parent, PVecNode *leaf) {
+    int32_t sub = ((count - 1) >> level) & PTRIE_MASK;
+    PVecNode *insert;
+    if (level == PTRIE_BITS) {
+        insert = leaf;
+    } else if (sub < parent->count) {
+        insert = pvec_push_leaf(count, level - PTRIE_BITS, pvec_child(parent, sub), leaf);
+    } else {
+        insert = pvec_new_path(level - PTRIE_BITS, leaf);
+    }
+    PVecNode *copy = pvec_copy(parent, sub < parent->count ? parent->count : sub + 1);
+    copy->data[sub] = janet_wrap_abstract(insert);
+    return copy;
+}
+
+static void pvec_tree_push(JanetPVec *vec, int32_t count, PVecNode *leaf) {
+    if ((count >> PTRIE_BITS) > (1 << vec->shift)) {
+        /* The tree is full, so add a level */
+        PVecNode *root = pvec_node(2);
+        root->data[0] = janet_wrap_abstract(vec->root);
+        root->data[1] = janet_wrap_abstract(pvec_new_path(vec->shift, leaf));
+        vec->root = root;
+        vec->shift += PTRIE_BITS;
+    } else {
+        vec->root = pvec_push_leaf(count, vec->shift, vec->root, leaf);
+    }
+}
+
+/* Remove the last leaf from the tree, returning NULL if nothing is left */
+static PVecNode *pvec_pop_leaf(int32_t count, int32_t level, const PVecNode *node) {
+    int32_t sub = ((count - 2) >> level) & PTRIE_MASK;
+    if (level > PTRIE_BITS) {
+        PVecNode *child = pvec_pop_leaf(count, level - PTRIE_BITS, pvec_child(node, sub));
+        if (NULL == child && sub == 0) return NULL;
+        PVecNode *copy = pvec_copy(node, NULL == child ? sub : node->count);
+        if (NULL != child) copy->data[sub] = janet_wrap_abstract(child);
+        return copy;
+    }
+    if (sub == 0) return NULL;
+    return pvec_copy(node, sub);
+}
+
+static JanetPVec *pvec_header(const JanetPVec *from) {
+    JanetPVec *vec = janet_abstract(&janet_pvec_type, sizeof(JanetPVec));
+    if (NULL == from) {
+        vec->count = 0;
+        vec->shift = PTRIE_BITS;
+        vec->hash = 0;
+        vec->root = pvec_node(0);
+        vec->tail = pvec_node(0);
+    } else {
+        *vec = *from;
+    }
+    return vec;
+}
+
+/* Build the tree for a vector that has not been shared yet */
+static void pvec_fill(JanetPVec *vec, const Janet *items, int32_t n) {
+    uint32_t hash = 0;
+    vec->count = n;
+    int32_t tailoff = pvec_tailoff(vec);
+    for (int32_t i = 0; i < tailoff; i += PTRIE_WIDTH) {
+        PVecNode *leaf = pvec_node(PTRIE_WIDTH);
+        memcpy(leaf->data, items + i, PTRIE_WIDTH * sizeof(Janet));
+        pvec_tree_push(vec, i + PTRIE_WIDTH, leaf);
+    }
+    PVecNode *tail = pvec_node(n - tailoff);
+    safe_memcpy(tail->data, items + tailoff, (size_t)(n - tailoff) * sizeof(Janet));
+    vec->tail = tail;
+    for (int32_t i = 0; i < n; i++) {
+        hash += pvec_entry_hash(i, items[i]);
+    }
+    vec->hash = (int32_t) hash;
+}
+
+JanetPVec *janet_pvec(const Janet *items, int32_t n) {
+    JanetPVec *vec = pvec_header(NULL);
+    pvec_fill(vec, items, n);
+    return vec;
+}
+
+JanetPVec *janet_getpvec(const Janet *argv, int32_t n) {
+    return (JanetPVec *) janet_getabstract(argv, n, &janet_pvec_type);
+}
+
+Janet janet_pvec_get(const JanetPVec *vec, int32_t index) {
+    if (index < 0 || index >= vec->count) return janet_wrap_nil();
+    return pvec_leaf(vec, index)->data[index & PTRIE_MASK];
+}
+
+JanetPVec *janet_pvec_push(const JanetPVec *vec, Janet x) {
+    JanetPVec *copy = pvec_header(vec);
+    const PVecNode *tail = vec->tail;
+    if (tail->count < PTRIE_WIDTH) {
+        PVecNode *newtail = pvec_copy(tail, tail->count + 1);
+        newtail->data[tail->count] = x;
+        copy->tail = newtail;
+    } else {
+        pvec_tree_push(copy, vec->count, (PVecNode *) tail);
+        PVecNode *newtail = pvec_node(1);
+        newtail->data[0] = x;
+        copy->tail = newtail;
+    }
+    copy->count++;
+    copy->hash = (int32_t)((uint32_t) vec->hash + pvec_entry_hash(vec->count, x));
+    return copy;
+}
+
+/* Returns a new vector. An index equal to the length appends x. */
+JanetPVec *janet_pvec_put(const JanetPVec *vec, int32_t index, Janet x) {
+    if (index == vec->count) return janet_pvec_push(vec, x);
+    if (index < 0 || index > vec->count) {
+        janet_panicf("index %d out of range [0, %d]", index, vec->count);
+    }
+    JanetPVec *copy = pvec_header(vec);
+    Janet old = janet_pvec_get(vec, index);
+    if (index >= pvec_tailoff(vec)) {
+        PVecNode *tail = pvec_copy(vec->tail, ((const PVecNode *) vec->tail)->count);
+        tail->data[index & PTRIE_MASK] = x;
+        copy->tail = tail;
+    } else {
+        copy->root = pvec_assoc(vec->root, vec->shift, index, x);
+    }
+    copy->hash = (int32_t)((uint32_t) vec->hash - pvec_entry_hash(index, old) + pvec_entry_hash(index, x));
+    return copy;
+}
+
+JanetPVec *janet_pvec_pop(const JanetPVec *vec) {
+    if (vec->count == 0) janet_panic("cannot pop an empty vector");
+    JanetPVec *copy = pvec_header(vec);
+    Janet last = janet_pvec_get(vec, vec->count - 1);
+    const PVecNode *tail = vec->tail;
+    if (tail->count > 1 || vec->count == 1) {
+        copy->tail = pvec_copy(tail, tail->count - 1);
+    } else {
+        /* The tail is now the last leaf in the tree */
+        copy->tail = (void *) pvec_leaf(vec, vec->count - 2);
+        PVecNode *root = pvec_pop_leaf(vec->count, vec->shift, vec->root);
+        if (NULL == root) root = pvec_node(0);
+        if (vec->shift > PTRIE_BITS && root->count == 1) {
+            root = pvec_child(root, 0);
+            copy->shift -= PTRIE_BITS;
+        }
+        copy->root = root;
+    }
+    copy->count--;
+    copy->hash = (int32_t)((uint32_t) vec->hash - pvec_entry_hash(vec->count - 1, last));
+    return copy;
+}
+
+static int pvec_gcmark(void *p, size_t len) {
+    (void) len;
+    JanetPVec *vec = (JanetPVec *) p;
+    janet_mark(janet_wrap_abstract(vec->root));
+    janet_mark(janet_wrap_abstract(vec->tail));
+    return 0;
+}
+
+static int pvec_get(void *p, Janet key, Janet *out) {
+    JanetPVec *vec = (JanetPVec *) p;
+    if (!janet_checkint(key)) return 0;
+    int32_t index = janet_unwrap_integer(key);
+    if (index < 0 || index >= vec->count) return 0;
+    *out = pvec_leaf(vec, index)->data[index & PTRIE_MASK];
+    return 1;
+}
+
+static void pvec_put(void *p, Janet key, Janet value) {
+    (void) p;
+    (void) key;
+    (void) value;
+    janet_panic("persistent vectors are immutable, use pvec/put");
+}
+
+static Janet pvec_next(void *p, Janet key) {
+    JanetPVec *vec = (JanetPVec *) p;
+    int32_t index = 0;
+    if (!janet_checktype(key, JANET_NIL)) {
+        if (!janet_checkint(key)) janet_panicf("expected integer key, got %v", key);
+        index = janet_unwrap_integer(key) + 1;
+    }
+    if (index < 0 || index >= vec->count) return janet_wrap_nil();
+    return janet_wrap_integer(index);
+}
+
+/* Vectors compare element by element like tuples, one leaf at a time */
+static int pvec_compare(void *lhs, void *rhs) {
+    JanetPVec *a = (JanetPVec *) lhs;
+    JanetPVec *b = (JanetPVec *) rhs;
+    int32_t n = a->count < b->count ? a->count : b->count;
+    int result = 0;
+    JanetTraversalState state;
+    janet_traversal_save(&state);
+    for (int32_t i = 0; i < n && !result; i += PTRIE_WIDTH) {
+        const PVecNode *la = pvec_leaf(a, i);
+        const PVecNode *lb = pvec_leaf(b, i);
+        if (la == lb) continue;
+        int32_t m = n - i < PTRIE_WIDTH ? n - i : PTRIE_WIDTH;
+        for (int32_t j = 0; j < m && !result; j++) {
+            result = janet_compare(la->data[j], lb->data[j]);
+        }
+    }
+    janet_traversal_restore(&state);
+    if (result) return result;
+    if (a->count != b->count) return a->count < b->count ? -1 : 1;
+    return 0;
+}
+
+static int32_t pvec_hash(void *p, size_t len) {
+    (void) len;
+    JanetPVec *vec = (JanetPVec *) p;
+    return (int32_t) ptrie_mix((uint32_t) vec->hash, (uint32_t) vec->count);
+}
+
+/* Marshalled as the number of values followed by the values */
+static void pvec_marshal(void *p, JanetMarshalContext *ctx) {
+    JanetPVec *vec = (JanetPVec *) p;
+    janet_marshal_abstract(ctx, p);
+    janet_marshal_int(ctx, vec->count);
+    for (int32_t i = 0; i < vec->count; i += PTRIE_WIDTH) {
+        const PVecNode *leaf = pvec_leaf(vec, i);
+        for (int32_t j = 0; j < leaf->count; j++) {
+            janet_marshal_janet(ctx, leaf->data[j]);
+        }
+    }
+}
+
+static void *pvec_unmarshal(JanetMarshalContext *ctx) {
+    JanetPVec *vec = janet_unmarshal_abstract(ctx, sizeof(JanetPVec));
+    vec->count = 0;
+    vec->shift = PTRIE_BITS;
+    vec->hash = 0;
+    vec->root = pvec_node(0);
+    vec->tail = pvec_node(0);
+    int32_t count = janet_unmarshal_int(ctx);
+    if (count < 0) janet_panic("invalid persistent vector length");
+    Janet *items = janet_smalloc((size_t) count * sizeof(Janet));
+    for (int32_t i = 0; i < count; i++) {
+        items[i] = janet_unmarshal_janet(ctx);
+    }
+    pvec_fill(vec, items, count);
+    janet_sfree(items);
+    return vec;
+}
+
+static void pvec_tostring(void *p, JanetBuffer *buffer) {
+    JanetPVec *vec = (JanetPVec *) p;
+    janet_buffer_push_u8(buffer, '[');
+    for (int32_t i = 0; i < vec->count; i++) {
+        if (i) janet_buffer_push_u8(buffer, ' ');
+        janet_description_b(buffer, janet_pvec_get(vec, i));
+    }
+    janet_buffer_push_u8(buffer, ']');
+}
+
+static Janet pvec_call(void *p, int32_t argc, Janet *argv) {
+    janet_arity(argc, 1, 2);
+    Janet value;
+    if (pvec_get(p, argv[0], &value)) return value;
+    return argc > 1 ? argv[1] : janet_wrap_nil();
+}
+
+static size_t pvec_length(void *p, size_t len) {
+    (void) len;
+    return (size_t)((JanetPVec *) p)->count;
+}
+
+const JanetAbstractType janet_pvec_type = {
+    "core/pvec",
+    NULL,
+    pvec_gcmark,
+    pvec_get,
+    pvec_put,
+    pvec_marshal,
+    pvec_unmarshal,
+    pvec_tostring,
+    pvec_compare,
+    pvec_hash,
+    pvec_next,
+    pvec_call,
+    pvec_length,
+    JANET_ATEND_LENGTH
+};
+
+/*
+ * C Functions
+ */
+
+JANET_CORE_FN(cfun_pmap_new,
+              "(pmap/new & kvs)",
+              "Create a persistent map from key value pairs. Persistent maps are immutable "
+              "like structs, but `pmap/put` and `pmap/remove` return an updated map in time "
+              "proportional to the log of its size, sharing most of its memory with the "
+              "old map. Persistent maps work with `get`, `in`, `length`, `keys`, `pairs`, "
+              "and `each`, and can be called like a function to look up a key.") {
+    if (argc & 1) janet_panic("expected even number of arguments");
+    JanetPMap *map = janet_pmap();
+    for (int32_t i = 0; i < argc; i += 2) {
+        pmap_set(map, argv[i], argv[i + 1]);
+    }
+    return janet_wrap_abstract(map);
+}
+
+JANET_CORE_FN(cfun_pmap_from,
+              "(pmap/from dict)",
+              "Create a persistent map with the key value pairs of a table or struct, "
+              "not including prototypes.") {
+    janet_fixarity(argc, 1);
+    JanetDictView view = janet_getdictionary(argv, 0);
+    JanetPMap *map = janet_pmap();
+    for (int32_t i = 0; i < view.cap; i++) {
+        const JanetKV *kv = view.kvs + i;
+        if (!janet_checktype(kv->key, JANET_NIL)) {
+            pmap_set(map, kv->key, kv->value);
+        }
+    }
+    return janet_wrap_abstract(map);
+}
+
+JANET_CORE_FN(cfun_pmap_put,
+              "(pmap/put m & kvs)",
+              "Return a new persistent map with the key value pairs `kvs` added to `m`. "
+              "Putting a nil value removes the key.") {
+    janet_arity(argc, 1, -1);
+    JanetPMap *old = janet_getpmap(argv, 0);
+    if (!(argc & 1)) janet_panic("expected even number of key value arguments");
+    JanetPMap *map = pmap_header(old);
+    for (int32_t i = 1; i < argc; i += 2) {
+        if (janet_checktype(argv[i], JANET_NIL)) janet_panic("cannot use nil as key");
+        if (janet_checktype(argv[i], JANET_NUMBER) && isnan(janet_unwrap_number(argv[i]))) {
+            janet_panic("cannot use NaN as key");
+        }
+        pmap_set(map, argv[i], argv[i + 1]);
+    }
+    return janet_wrap_abstract(map);
+}
+
+JANET_CORE_FN(cfun_pmap_remove,
+              "(pmap/remove m & ks)",
+              "Return a new persistent map without the keys `ks`.") {
+    janet_arity(argc, 1, -1);
+    JanetPMap *map = pmap_header(janet_getpmap(argv, 0));
+    for (int32_t i = 1; i < argc; i++) {
+        pmap_set(map, argv[i], janet_wrap_nil());
+    }
+    return janet_wrap_abstract(map);
+}
+
+static void pmap_to_table_node(const PMapNode *node, JanetTable *table) {
+    for (int32_t i = 0; i < node->count; i++) {
+        const JanetKV *kv = node->data + i;
+        if (pmap_is_child(kv)) {
+            pmap_to_table_node(pmap_child(kv), table);
+        } else {
+            janet_table_put(table, kv->key, kv->value);
+        }
+    }
+}
+
+JANET_CORE_FN(cfun_pmap_to_table,
+              "(pmap/to-table m)",
+              "Create a new table with the key value pairs of a persistent map.") {
+    janet_fixarity(argc, 1);
+    JanetPMap *map = janet_getpmap(argv, 0);
+    JanetTable *table = janet_table(map->count);
+    if (NULL != map->root) pmap_to_table_node(map->root, table);
+    return janet_wrap_table(table);
+}
+
+JANET_CORE_FN(cfun_pvec_new,
+              "(pvec/new & xs)",
+              "Create a persistent vector of `xs`. Persistent vectors are immutable like "
+              "tuples, but `pvec/put`, `pvec/push`, and `pvec/pop` return an updated vector "
+              "in time proportional to the log of its length, sharing most of its memory "
+              "with the old vector. Persistent vectors work with `get`, `in`, `length`, and "
+              "`each`, and can be called like a function to look up an index.") {
+    return janet_wrap_abstract(janet_pvec(argv, argc));
+}
+
+JANET_CORE_FN(cfun_pvec_from,
+              "(pvec/from xs)",
+              "Create a persistent vector with the elements of an array, tuple, or other "
+              "indexed data structure.") {
+    janet_fixarity(argc, 1);
+    JanetView view = janet_getindexed(argv, 0);
+    return janet_wrap_abstract(janet_pvec(view.items, view.len));
+}
+
+JANET_CORE_FN(cfun_pvec_put,
+              "(pvec/put v index x)",
+              "Return a new persistent vector with the element at `index` set to `x`. An "
+              "index equal to the length of `v` appends `x`.") {
+    janet_fixarity(argc, 3);
+    JanetPVec *vec = janet_getpvec(argv, 0);
+    int32_t index = janet_getinteger(argv, 1);
+    return janet_wrap_abstract(janet_pvec_put(vec, index, argv[2]));
+}
+
+JANET_CORE_FN(cfun_pvec_push,
+              "(pvec/push v & xs)",
+              "Return a new persistent vector with `xs` added to the end of `v`.") {
+    janet_arity(argc, 1, -1);
+    const JanetPVec *vec = janet_getpvec(argv, 0);
+    for (int32_t i = 1; i < argc; i++) {
+        vec = janet_pvec_push(vec, argv[i]);
+    }
+    return janet_wrap_abstract((void *) vec);
+}
+
+JANET_CORE_FN(cfun_pvec_pop,
+              "(pvec/pop v)",
+              "Return a new persistent vector without the last element of `v`. Raises an "
+              "error if `v` is empty.") {
+    janet_fixarity(argc, 1);
+    return janet_wrap_abstract(janet_pvec_pop(janet_getpvec(argv, 0)));
+}
+
+JANET_CORE_FN(cfun_pvec_to_array,
+              "(pvec/to-array v)",
+              "Create a new array with the elements of a persistent vector.") {
+    janet_fixarity(argc, 1);
+    JanetPVec *vec = janet_getpvec(argv, 0);
+    JanetArray *array = janet_array(vec->count);
+    for (int32_t i = 0; i < vec->count; i += PTRIE_WIDTH) {
+        const PVecNode *leaf = pvec_leaf(vec, i);
+        memcpy(array->data + i, leaf->data, (size_t) leaf->count * sizeof(Janet));
+    }
+    array->count = vec->count;
+    return janet_wrap_array(array);
+}
+
+/* Module entry point */
+void janet_lib_persistent(JanetTable *env) {
+    JanetRegExt persistent_cfuns[] = {
+        JANET_CORE_REG("pmap/new", cfun_pmap_new),
+        JANET_CORE_REG("pmap/from", cfun_pmap_from),
+        JANET_CORE_REG("pmap/put", cfun_pmap_put),
+        JANET_CORE_REG("pmap/remove", cfun_pmap_remove),
+        JANET_CORE_REG("pmap/to-table", cfun_pmap_to_table),
+        JANET_CORE_REG("pvec/new", cfun_pvec_new),
+        JANET_CORE_REG("pvec/from", cfun_pvec_from),
+        JANET_CORE_REG("pvec/put", cfun_pvec_put),
+        JANET_CORE_REG("pvec/push", cfun_pvec_push),
+        JANET_CORE_REG("pvec/pop", cfun_pvec_pop),
+        JANET_CORE_REG("pvec/to-array", cfun_pvec_to_array),
+        JANET_REG_END
+    };
+    janet_core_cfuns_ext(env, NULL, persistent_cfuns);
+    janet_register_abstract_type(&janet_pmap_type);
+    janet_register_abstract_type(&janet_pvec_type);
+}
+
+#endif
@@ -45,18 +45,12 @@
 
 static void number_to_string_b(JanetBuffer *buffer, double x) {
     janet_buffer_ensure(buffer, buffer->count + BUFSIZE, 2);
-    const char *fmt = (x == floor(x) &&
-                       x <= JANET_INTMAX_DOUBLE &&
-                       x >= JANET_INTMIN_DOUBLE) ? "%.0f" : ("%." STR(DBL_DIG) "g");
-    int count;
     if (x == 0.0) {
         /* Prevent printing of '-0' */
-        count = 1;
-        buffer->data[buffer->count] = '0';
+        buffer->data[buffer->count++] = '0';
     } else {
-        count = snprintf((char *) buffer->data + buffer->count, BUFSIZE, fmt, x);
+        buffer->count += janet_dtoa(x, buffer->data + buffer->count);
     }
-    buffer->count += count;
 }
 
 /* expects non positive x */
@@ -414,6 +408,7 @@ static int print_jdn_one(struct pretty *S, Janet x, int depth) {
         case JANET_TABLE: {
             janet_table_put(&S->seen, x, janet_wrap_true());
             JanetTable *tab = janet_unwrap_table(x);
+            janet_table_materialize(tab);
             janet_buffer_push_cstring(S->buffer, "@{");
             int isFirst = 1;
             for (int32_t i = 0; i < tab->capacity; i++) {
@@ -103,7 +103,7 @@ int janet_dobytes(JanetTable *env, const uint8_t *bytes, int32_t len, const char
                 if (index >= len) {
                     janet_parser_eof(parser);
                 } else {
-                    janet_parser_consume(parser, bytes[index++]);
+                    index += janet_parser_consume_bytes(parser, bytes + index, len - index);
                 }
                 break;
         }
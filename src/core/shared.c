@@ -0,0 +1,301 @@
+/*
+* Copyright (c) 2025 Calvin Rose & contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/* Immutable values in memory shared between threads. Freezing a value copies
+ * it, along with everything it references, into a region of memory outside
+ * of any heap. The region belongs to a threaded abstract, so handing it to
+ * another thread only passes a pointer. Objects in the region are always marked
+ * and never in a heap's block list, so collectors never write to or free them.
+ * A thread that reads the value roots the region, which keeps it alive until
+ * that thread exits. */
+
+#ifndef JANET_AMALG
+#include "features.h"
+#include <janet.h>
+#include "gc.h"
+#include "util.h"
+#endif
+
+#include <string.h>
+
+#ifdef JANET_EV
+
+#define JANET_SHARED_CHUNK_SIZE 0x10000
+
+typedef struct JanetSharedChunk {
+    struct JanetSharedChunk *next;
+    size_t used;
+    size_t capacity;
+    long long data[];
+} JanetSharedChunk;
+
+typedef struct {
+    Janet value;
+    JanetSharedChunk *chunks;
+    size_t bytes;
+} JanetShared;
+
+typedef struct {
+    JanetShared *shared;
+    JanetTable seen; /* Maps values to their frozen copies, so shared structure stays shared */
+    int depth;
+} JanetFreezeState;
+
+static int shared_gc(void *p, size_t size) {
+    (void) size;
+    JanetShared *shared = (JanetShared *) p;
+    JanetSharedChunk *chunk = shared->chunks;
+    while (NULL != chunk) {
+        JanetSharedChunk *next = chunk->next;
+        janet_free(chunk);
+        chunk = next;
+    }
+    shared->chunks = NULL;
+    return 0;
+}
+
+static int shared_get(void *p, Janet key, Janet *out);
+
+const JanetAbstractType janet_shared_type = {
+    "core/shared",
+    shared_gc,
+    NULL,
+    shared_get,
+    JANET_ATEND_GET
+};
+
+/* Allocate a frozen object. The header is filled in so that the object looks
+ * like an old, marked block to the collector of every thread. */
+static void *shared_alloc(JanetShared *shared, int32_t flags, size_t size) {
+    size = (size + 15) & ~((size_t) 15);
+    JanetSharedChunk *chunk = shared->chunks;
+    if (NULL == chunk || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > JANET_SHARED_CHUNK_SIZE ? size : JANET_SHARED_CHUNK_SIZE;
+        chunk = janet_malloc(sizeof(JanetSharedChunk) + capacity);
+        if (NULL == chunk) {
+            JANET_OUT_OF_MEMORY;
+        }
+        chunk->next = shared->chunks;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        shared->chunks = chunk;
+    }
+    JanetGCObject *mem = (JanetGCObject *)((char *) chunk->data + chunk->used);
+    chunk->used += size;
+    shared->bytes += size;
+    mem->flags = (flags & ~0xFFFF) | (flags & JANET_MEM_TYPEBITS) |
+                 JANET_MEM_REACHABLE | JANET_MEM_REMEMBERED | JANET_MEM_FROZEN;
+    mem->data.next = NULL;
+    return mem;
+}
+
+static Janet shared_freeze_value(JanetFreezeState *st, Janet x);
+
+static Janet shared_freeze_inner(JanetFreezeState *st, Janet x) {
+    switch (janet_type(x)) {
+        default:
+            janet_panicf("cannot freeze value of type %t", x);
+        case JANET_STRING:
+        case JANET_SYMBOL:
+        case JANET_KEYWORD: {
+            JanetStringHead *head = janet_string_head(janet_unwrap_string(x));
+            JanetStringHead *copy = shared_alloc(st->shared, head->gc.flags,
+                                                 sizeof(JanetStringHead) + (size_t) head->length + 1);
+            copy->length = head->length;
+            copy->hash = head->hash;
+            memcpy((uint8_t *) copy->data, head->data, (size_t) head->length + 1);
+            const uint8_t *str = copy->data;
+            if (janet_checktype(x, JANET_STRING)) return janet_wrap_string(str);
+            if (janet_checktype(x, JANET_SYMBOL)) return janet_wrap_symbol(str);
+            return janet_wrap_keyword(str);
+        }
+        case JANET_TUPLE: {
+            JanetTupleHead *head = janet_tuple_head(janet_unwrap_tuple(x));
+            JanetTupleHead *copy = shared_alloc(st->shared, head->gc.flags,
+                                                sizeof(JanetTupleHead) + (size_t) head->length * sizeof(Janet));
+            copy->length = head->length;
+            copy->hash = head->hash;
+            copy->sm_line = head->sm_line;
+            copy->sm_column = head->sm_column;
+            Janet *data = (Janet *) copy->data;
+            for (int32_t i = 0; i < head->length; i++) {
+                data[i] = shared_freeze_value(st, head->data[i]);
+            }
+            return janet_wrap_tuple(copy->data);
+        }
+        case JANET_STRUCT: {
+            JanetStructHead *head = janet_struct_head(janet_unwrap_struct(x));
+            JanetStructHead *copy = shared_alloc(st->shared, head->gc.flags,
+                                                 sizeof(JanetStructHead) + (size_t) head->capacity * sizeof(JanetKV));
+            copy->length = head->length;
+            copy->hash = head->hash;
+            copy->capacity = head->capacity;
+            copy->proto = NULL;
+            if (NULL != head->proto) {
+                copy->proto = janet_unwrap_struct(shared_freeze_value(st, janet_wrap_struct(head->proto)));
+            }
+            /* Keys keep their hashes, so the table layout can be copied as is */
+            JanetKV *data = (JanetKV *) copy->data;
+            for (int32_t i = 0; i < head->capacity; i++) {
+                data[i].key = shared_freeze_value(st, head->data[i].key);
+                data[i].value = shared_freeze_value(st, head->data[i].value);
+            }
+            return janet_wrap_struct(copy->data);
+        }
+    }
+}
+
+static Janet shared_freeze_value(JanetFreezeState *st, Janet x) {
+    switch (janet_type(x)) {
+        case JANET_NIL:
+        case JANET_BOOLEAN:
+        case JANET_NUMBER:
+            return x;
+        default:
+            break;
+    }
+    Janet seen = janet_table_get(&st->seen, x);
+    if (!janet_checktype(seen, JANET_NIL)) return seen;
+    if (--st->depth <= 0) janet_panic("value too deeply nested to freeze");
+    Janet copy = shared_freeze_inner(st, x);
+    st->depth++;
+    janet_table_put(&st->seen, x, copy);
+    return copy;
+}
+
+void *janet_shared_freeze(Janet x) {
+    JanetShared *shared = janet_abstract_threaded(&janet_shared_type, sizeof(JanetShared));
+    shared->value = janet_wrap_nil();
+    shared->chunks = NULL;
+    shared->bytes = 0;
+    JanetFreezeState st;
+    st.shared = shared;
+    st.depth = JANET_RECURSION_GUARD;
+    janet_table_init_raw(&st.seen, 0);
+    JanetTryState tstate;
+    JanetSignal signal = janet_try(&tstate);
+    if (!signal) {
+        shared->value = shared_freeze_value(&st, x);
+    }
+    janet_restore(&tstate);
+    janet_table_deinit(&st.seen);
+    if (signal) {
+        /* The handle is collected with the rest of the heap */
+        shared_gc(shared, sizeof(JanetShared));
+        janet_panicv(tstate.payload);
+    }
+    return shared;
+}
+
+/* Reading the value roots the region in this thread, since the heap may keep
+ * references into it long after the handle is gone. */
+Janet janet_shared_value(void *p) {
+    JanetShared *shared = (JanetShared *) p;
+    Janet handle = janet_wrap_abstract(shared);
+    int pinned = 0;
+    for (size_t i = 0; i < janet_vm.root_count; i++) {
+        if (janet_checktype(janet_vm.roots[i], JANET_ABSTRACT) &&
+                janet_unwrap_abstract(janet_vm.roots[i]) == p) {
+            pinned = 1;
+            break;
+        }
+    }
+    if (!pinned) janet_gcroot(handle);
+    return shared->value;
+}
+
+JANET_CORE_FN(cfun_shared_freeze,
+              "(shared/freeze x)",
+              "Copy `x` into memory shared between threads and return a handle to it. `x` may "
+              "contain nil, booleans, numbers, strings, symbols, keywords, tuples and structs. "
+              "The handle can be given to other threads, for example through a threaded channel "
+              "or as an argument to `ev/thread`, without copying the value again.") {
+    janet_fixarity(argc, 1);
+    return janet_wrap_abstract(janet_shared_freeze(argv[0]));
+}
+
+JANET_CORE_FN(cfun_shared_value,
+              "(shared/value handle)",
+              "Get the frozen value from a handle made by `shared/freeze`. The value is used in "
+              "place, without copying. The memory behind it stays alive until every thread that "
+              "has read it exits.") {
+    janet_fixarity(argc, 1);
+    void *shared = janet_getabstract(argv, 0, &janet_shared_type);
+    return janet_shared_value(shared);
+}
+
+JANET_CORE_FN(cfun_shared_bytes,
+              "(shared/bytes handle)",
+              "Get the number of bytes used by a frozen value.") {
+    janet_fixarity(argc, 1);
+    JanetShared *shared = janet_getabstract(argv, 0, &janet_shared_type);
+    return janet_wrap_number((double) shared->bytes);
+}
+
+JANET_CORE_FN(cfun_shared_frozenp,
+              "(shared/frozen? x)",
+              "Check if `x` lives in memory made by `shared/freeze`.") {
+    janet_fixarity(argc, 1);
+    JanetGCObject *mem;
+    switch (janet_type(argv[0])) {
+        default:
+            return janet_wrap_false();
+        case JANET_STRING:
+        case JANET_SYMBOL:
+        case JANET_KEYWORD:
+            mem = &janet_string_head(janet_unwrap_string(argv[0]))->gc;
+            break;
+        case JANET_TUPLE:
+            mem = &janet_tuple_head(janet_unwrap_tuple(argv[0]))->gc;
+            break;
+        case JANET_STRUCT:
+            mem = &janet_struct_head(janet_unwrap_struct(argv[0]))->gc;
+            break;
+    }
+    return janet_wrap_boolean(mem->flags & JANET_MEM_FROZEN);
+}
+
+static const JanetMethod shared_methods[] = {
+    {"value", cfun_shared_value},
+    {"bytes", cfun_shared_bytes},
+    {NULL, NULL}
+};
+
+static int shared_get(void *p, Janet key, Janet *out) {
+    (void) p;
+    if (!janet_checktype(key, JANET_KEYWORD)) return 0;
+    return janet_getmethod(janet_unwrap_keyword(key), shared_methods, out);
+}
+
+void janet_lib_shared(JanetTable *env) {
+    JanetRegExt shared_cfuns[] = {
+        JANET_CORE_REG("shared/freeze", cfun_shared_freeze),
+        JANET_CORE_REG("shared/value", cfun_shared_value),
+        JANET_CORE_REG("shared/bytes", cfun_shared_bytes),
+        JANET_CORE_REG("shared/frozen?", cfun_shared_frozenp),
+        JANET_REG_END
+    };
+    janet_core_cfuns_ext(env, NULL, shared_cfuns);
+    janet_register_abstract_type(&janet_shared_type);
+}
+
+#endif
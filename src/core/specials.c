@@ -550,6 +550,165 @@ static int janetc_check_nil_form(Janet x, Janet *capture, uint32_t fun_tag) {
     return 0;
 }
 
+/* Minimum number of keys for a chain of equality tests to become a switch */
+#define JANET_SWITCH_MIN 4
+
+/* Check if a form is a literal that can be a key of a switch */
+static int janetc_switch_key(Janet x, Janet *key) {
+    int types = JANET_TFLAG_NUMBER | JANET_TFLAG_BOOLEAN | JANET_TFLAG_STRING | JANET_TFLAG_KEYWORD;
+    if (janet_checktype(x, JANET_TUPLE)) {
+        JanetTuple tup = janet_unwrap_tuple(x);
+        if (janet_tuple_length(tup) != 2 || (janet_tuple_flag(tup) & JANET_TUPLE_FLAG_BRACKETCTOR)) return 0;
+        if (!janet_symeq(tup[0], "quote")) return 0;
+        x = tup[1];
+        types |= JANET_TFLAG_SYMBOL;
+    }
+    if (!janet_checktypes(x, types)) return 0;
+    *key = x;
+    return 1;
+}
+
+/* Check if a form matches the pattern (= sym key) or (= key sym) for a
+ * literal key. The symbol must match sym if sym is not nil. */
+static int janetc_switch_test(Janet x, Janet *sym, Janet *key) {
+    if (!janet_checktype(x, JANET_TUPLE)) return 0;
+    JanetTuple tup = janet_unwrap_tuple(x);
+    if (3 != janet_tuple_length(tup) || (janet_tuple_flag(tup) & JANET_TUPLE_FLAG_BRACKETCTOR)) return 0;
+    if (!janet_checktype(tup[0], JANET_FUNCTION)) return 0;
+    JanetFunction *fun = janet_unwrap_function(tup[0]);
+    if ((fun->def->flags & JANET_FUNCDEF_FLAG_TAG) != JANET_FUN_EQ) return 0;
+    int i;
+    for (i = 1; i < 3; i++) {
+        if (janet_checktype(tup[i], JANET_SYMBOL) && janetc_switch_key(tup[3 - i], key)) break;
+    }
+    if (i == 3) return 0;
+    if (janet_checktype(*sym, JANET_NIL)) {
+        *sym = tup[i];
+    } else if (!janet_equals(*sym, tup[i])) {
+        return 0;
+    }
+    return 1;
+}
+
+/* Check if a form is (if cond then) or (if cond then else) */
+static int janetc_if_form(Janet x, const Janet **argv, int32_t *argn) {
+    if (!janet_checktype(x, JANET_TUPLE)) return 0;
+    JanetTuple tup = janet_unwrap_tuple(x);
+    int32_t len = janet_tuple_length(tup);
+    if (len < 3 || len > 4 || (janet_tuple_flag(tup) & JANET_TUPLE_FLAG_BRACKETCTOR)) return 0;
+    if (!janet_symeq(tup[0], "if")) return 0;
+    *argv = tup + 1;
+    *argn = len - 1;
+    return 1;
+}
+
+/*
+ * A chain of equality tests of one symbol against literal keys, such as
+ * (if (= x k1) a (if (= x k2) b c)) from case, looks up the key in a constant
+ * struct that maps keys to indices in a jump table.
+ *
+ * switch x keys
+ * jump :default
+ * jump :body0
+ * jump :body1
+ * ...
+ * :body0
+ * ...
+ * jump done (only if not tail)
+ * :body1
+ * ...
+ * :default
+ * ...
+ * :done
+ *
+ * Returns 0 if the if form is not such a chain.
+ */
+static int janetc_switch(JanetFopts opts, int32_t argn, const Janet *argv, JanetSlot *ret) {
+    JanetCompiler *c = opts.compiler;
+    JanetScope switchscope, tempscope;
+    JanetSlot x, target, body;
+    JanetFopts bodyopts;
+    Janet sym = janet_wrap_nil();
+    Janet key = janet_wrap_nil();
+    Janet dflt = janet_wrap_nil();
+    Janet *keys = NULL;
+    Janet *bodies = NULL;
+    int32_t *jumps = NULL;
+    const int tail = opts.flags & JANET_FOPTS_TAIL;
+    const int drop = opts.flags & JANET_FOPTS_DROP;
+
+    /* Collect the chain, stopping at the first if that is not an equality test */
+    while (janetc_switch_test(argv[0], &sym, &key)) {
+        janet_v_push(keys, key);
+        janet_v_push(bodies, argv[1]);
+        dflt = argn > 2 ? argv[2] : janet_wrap_nil();
+        if (!janetc_if_form(dflt, &argv, &argn)) break;
+    }
+    int32_t n = janet_v_count(keys);
+    if (n < JANET_SWITCH_MIN) {
+        janet_v_free(keys);
+        janet_v_free(bodies);
+        return 0;
+    }
+
+    janetc_scope(&switchscope, c, 0, "switch");
+    x = janetc_value(janetc_fopts_default(c), sym);
+    if (x.flags & JANET_SLOT_CONSTANT) {
+        /* Let if fold the tests */
+        janetc_popscope(c);
+        janet_v_free(keys);
+        janet_v_free(bodies);
+        return 0;
+    }
+
+    /* Earlier keys win over equal later ones */
+    JanetKV *st = janet_struct_begin(n);
+    for (int32_t i = n - 1; i >= 0; i--) {
+        janet_struct_put(st, keys[i], janet_wrap_integer(i));
+    }
+    int32_t cindex = janetc_const(c, janet_wrap_struct(janet_struct_end(st)));
+
+    target = (drop || tail)
+             ? janetc_cslot(janet_wrap_nil())
+             : janetc_gettarget(opts);
+    bodyopts = opts;
+    bodyopts.flags &= ~JANET_FOPTS_ACCEPT_SPLICE;
+
+    /* Switch and jump table */
+    int32_t labels = janetc_emit_su(c, JOP_SWITCH, x, (uint16_t) cindex, 0);
+    for (int32_t i = 0; i <= n; i++) janetc_emit(c, JOP_JUMP);
+
+    /* Bodies */
+    for (int32_t i = 0; i <= n; i++) {
+        int32_t label = janet_v_count(c->buffer);
+        int32_t jump = labels + 1 + (i == n ? 0 : 1 + i);
+        c->buffer[jump] |= (uint32_t)(label - jump) << 8;
+        janetc_scope(&tempscope, c, 0, i == n ? "switch-default" : "switch-body");
+        body = janetc_value(bodyopts, i == n ? dflt : bodies[i]);
+        if (!drop && !tail) janetc_copy(c, target, body);
+        janetc_popscope(c);
+        if (!tail && i < n) {
+            janet_v_push(jumps, janet_v_count(c->buffer));
+            janetc_emit(c, JOP_JUMP);
+        }
+    }
+
+    janetc_popscope(c);
+
+    /* Jumps to done */
+    int32_t done = janet_v_count(c->buffer);
+    for (int32_t i = 0; i < janet_v_count(jumps); i++) {
+        c->buffer[jumps[i]] |= (uint32_t)(done - jumps[i]) << 8;
+    }
+
+    janet_v_free(keys);
+    janet_v_free(bodies);
+    janet_v_free(jumps);
+    if (tail) target.flags |= JANET_SLOT_RETURNED;
+    *ret = target;
+    return 1;
+}
+
 /*
  * :condition
  * ...
@@ -577,6 +736,8 @@ static JanetSlot janetc_if(JanetFopts opts, int32_t argn, const Janet *argv) {
         return janetc_cslot(janet_wrap_nil());
     }
 
+    if (janetc_switch(opts, argn, argv, &target)) return target;
+
     /* Get the bodies of the if expression */
     truebody = argv[1];
     falsebody = argn > 2 ? argv[2] : janet_wrap_nil();
@@ -618,12 +779,18 @@ static JanetSlot janetc_if(JanetFopts opts, int32_t argn, const Janet *argv) {
         }
         janetc_scope(&tempscope, c, 0, "if-true");
         right = janetc_value(bodyopts, truebody);
-        if (!drop && !tail) janetc_copy(c, target, right);
+        if (!drop && !tail && !(right.flags & JANET_SLOT_CONSTANT)) janetc_copy(c, target, right);
         janetc_popscope(c);
         if (!janet_checktype(falsebody, JANET_NIL)) {
             janetc_throwaway(bodyopts, falsebody);
         }
         janetc_popscope(c);
+        if (!drop && !tail && (right.flags & JANET_SLOT_CONSTANT)) {
+            /* Keep a constant branch constant so it can be folded further */
+            if (!(opts.flags & JANET_FOPTS_HINT) || !janetc_sequal(target, opts.hint))
+                janetc_freeslot(c, target);
+            return right;
+        }
         return target;
     }
 
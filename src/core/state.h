@@ -36,11 +36,25 @@
 
 typedef int64_t JanetTimestamp;
 
+#ifdef JANET_GC_SLAB
+/* Small fixed size objects are carved out of pages, one list of pages per
+ * size class. Size classes are multiples of JANET_SLAB_GRANULE bytes. */
+#define JANET_SLAB_GRANULE 16
+#define JANET_SLAB_CLASSES 16
+#define JANET_SLAB_MAX (JANET_SLAB_GRANULE * JANET_SLAB_CLASSES)
+#define JANET_SLAB_PAGE_SIZE 0x10000
+#endif
+
 typedef struct JanetScratch {
     JanetScratchFinalizer finalize;
     long long mem[]; /* for proper alignment */
 } JanetScratch;
 
+typedef struct {
+    Janet *data;
+    int32_t capacity;
+} JanetFiberStack;
+
 typedef struct {
     JanetGCObject *self;
     JanetGCObject *other;
@@ -69,8 +83,76 @@ typedef struct {
     pthread_t worker;
 #endif
 } JanetTimeout;
+
+#ifdef JANET_EV_TIMER_WHEEL
+#define JANET_TW_BITS 6
+#define JANET_TW_SLOTS (1 << JANET_TW_BITS)
+#define JANET_TW_LEVELS 4
+
+typedef struct {
+    JanetTimeout to; /* to.fiber is NULL for free nodes */
+    int32_t next;
+} JanetTimerNode;
+
+typedef struct {
+    JanetTimerNode *nodes;
+    int32_t capacity;
+    int32_t free;
+    int32_t slots[JANET_TW_LEVELS][JANET_TW_SLOTS]; /* lists of nodes, -1 for empty */
+    uint64_t pending[JANET_TW_LEVELS]; /* bit set for each non-empty slot */
+    int32_t overflow;
+    int32_t *expired; /* timeouts that are due, sorted by time */
+    int32_t expired_head;
+    int32_t expired_count;
+    int32_t expired_capacity;
+    JanetTimestamp now;
+} JanetTimerWheel;
+#endif
+
+/* Bucket i counts durations below 2^i microseconds, the last bucket the rest */
+#define JANET_EV_HIST_BUCKETS 24
+
+typedef struct {
+    uint64_t count;
+    uint64_t total; /* nanoseconds */
+    uint64_t max;
+    uint64_t buckets[JANET_EV_HIST_BUCKETS];
+} JanetEVHistogram;
+
+typedef struct {
+    uint64_t iterations;
+    size_t streams; /* open streams */
+    JanetEVHistogram latency; /* time from the start of an iteration until polling */
+    JanetEVHistogram run; /* time spent running fibers in an iteration */
+    uint64_t slow_threshold; /* nanoseconds */
+    JanetFunction *slow_handler;
+    JanetTable *slow_env;
+} JanetEVStats;
 #endif
 
+/* Allocation accounting for fibers, see fiber/memory-group */
+typedef struct {
+    uint64_t allocated; /* bytes allocated by fibers in the group */
+    uint64_t live; /* estimated from allocations sampled by the heap profiler */
+    uint64_t limit; /* 0 for no limit */
+} JanetMemoryGroup;
+
+/* Counters for one folded stack of the heap profiler, see debug/heap-profile */
+typedef struct {
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t live_samples;
+    uint64_t live_bytes;
+} JanetHeapStack;
+
+/* A sampled block that has not been freed yet */
+typedef struct {
+    void *mem; /* NULL for an empty slot */
+    JanetMemoryGroup *group;
+    int32_t stack; /* index into janet_vm.heap_stacks, or -1 */
+    size_t bytes; /* bytes allocated since the previous sample */
+} JanetHeapSample;
+
 /* Registry table for C functions - contains metadata that can
  * be looked up by cfunction pointer. All strings here are pointing to
  * static memory not managed by Janet. */
@@ -94,6 +176,13 @@ struct JanetVM {
     /* Cache the core environment */
     JanetTable *core_env;
 
+    /* Parts of the core environment that have not been unmarshalled yet */
+    JanetTable *core_lazy_index;
+    JanetArray *core_lazy_chunks;
+    JanetTable *core_lazy_lid;
+    JanetTable *core_lazy_mid;
+    int32_t core_lazy_pending;
+
     /* How many VM stacks have been entered */
     int stackn;
 
@@ -130,14 +219,78 @@ struct JanetVM {
     uint32_t cache_deleted;
     uint8_t gensym_counter[8];
 
+    /* Weak table of interned structs and tuples, see struct/intern */
+    JanetTable *intern_table;
+
+    /* Inline method caches are only valid for the epoch they were filled in */
+    uint32_t method_cache_epoch;
+
+    /* Built in profiler, see debug/profile */
+    int profiling;
+    int32_t profile_interval;
+    int32_t profile_countdown;
+    uint64_t profile_samples;
+    JanetFuncProfile *profile_funcs;
+    JanetTable *profile_stacks;
+#ifdef JANET_PROFILE
+    uint64_t profile_ops[128];
+#endif
+
+    /* Heap profiler, see debug/heap-profile, and memory groups */
+    int heap_profiling;
+    int heap_sampling; /* set while a sample is recorded, to not sample recursively */
+    size_t heap_sample_interval;
+    int64_t heap_countdown;
+    uint64_t heap_sample_total;
+    JanetHeapSample *heap_samples; /* open addressing table of live samples */
+    size_t heap_sample_count;
+    size_t heap_sample_capacity;
+    JanetHeapStack *heap_stacks;
+    int32_t heap_stack_count;
+    int32_t heap_stack_capacity;
+    JanetTable *heap_stack_index; /* folded stack -> index into heap_stacks */
+    JanetMemoryGroup *memory_limit_hit; /* group over its limit, raised at the next safe point */
+
     /* Garbage collection */
     void *blocks;
     void *weak_blocks;
     size_t gc_interval;
+    uint32_t gc_pause;
     size_t next_collection;
     size_t block_count;
     int gc_suspend;
     int gc_mark_phase;
+    int gc_mode;
+    int gc_major_due;
+    size_t gc_major_blocks;
+    void *gc_old_blocks;
+    JanetGCObject **gc_remembered;
+    size_t gc_remembered_count;
+    size_t gc_remembered_capacity;
+    int gc_marking;
+    uint32_t gc_pause_budget;
+    JanetGCObject **gc_gray;
+    size_t gc_gray_count;
+    size_t gc_gray_capacity;
+    JanetGCStats gc_stats;
+    size_t gc_old_live[JANET_GC_MEMORY_TYPES];
+    JanetGCHook gc_hook;
+
+    /* Largest freed deep fiber stack, kept for reuse */
+    Janet *fiber_stack_cache;
+    int32_t fiber_stack_cache_capacity;
+
+    /* Stacks of collected fibers, reused by new fibers */
+    JanetFiberStack *fiber_pool;
+    int32_t fiber_pool_count;
+    int32_t fiber_pool_limit;
+#ifdef JANET_GC_THREADS
+    void *gc_pool;
+#endif
+#ifdef JANET_GC_SLAB
+    void *slab_pages[JANET_SLAB_CLASSES];
+    void *slab_free[JANET_SLAB_CLASSES];
+#endif
 
     /* GC roots */
     Janet *roots;
@@ -168,14 +321,20 @@ struct JanetVM {
     /* Event loop and scheduler globals */
 #ifdef JANET_EV
     size_t tq_count;
-    size_t tq_capacity;
     JanetQueue spawn;
+#ifdef JANET_EV_TIMER_WHEEL
+    JanetTimerWheel tw;
+#else
+    size_t tq_capacity;
     JanetTimeout *tq;
+#endif
     JanetRNG ev_rng;
     volatile JanetAtomicInt listener_count; /* used in signal handler, must be volatile */
     JanetTable threaded_abstracts; /* All abstract types that can be shared between threads (used in this thread) */
     JanetTable active_tasks; /* All possibly live task fibers - used just for tracking */
     JanetTable signal_handlers;
+    void *pool_worker; /* Thread pool worker running on this thread, or NULL */
+    JanetEVStats ev_stats; /* Loop health, see ev/stats */
 #ifdef JANET_WINDOWS
     void **iocp;
 #elif defined(JANET_EV_EPOLL)
@@ -184,6 +343,9 @@ struct JanetVM {
     int epoll;
     int timerfd;
     int timer_enabled;
+#ifdef JANET_EV_IO_URING
+    struct JanetURing *uring; /* NULL if io_uring is not available */
+#endif
 #elif defined(JANET_EV_KQUEUE)
     pthread_attr_t new_thread_attr;
     JanetHandle selfpipe[2];
@@ -41,15 +41,25 @@ uint8_t *janet_string_begin(int32_t length) {
 
 /* Finish building a string */
 const uint8_t *janet_string_end(uint8_t *str) {
-    janet_string_hash(str) = janet_string_calchash(str, janet_string_length(str));
     return str;
 }
 
+/* Get the hash of a string. Strings are hashed on first use rather than when
+ * they are created, since most strings are never used as keys. Symbols and
+ * keywords are always hashed when they are interned. */
+int32_t janet_string_hash(const uint8_t *str) {
+    JanetStringHead *head = janet_string_head(str);
+    if (!(head->gc.flags & JANET_STRING_FLAG_HASHED)) {
+        head->hash = janet_string_calchash(str, head->length);
+        head->gc.flags |= JANET_STRING_FLAG_HASHED;
+    }
+    return head->hash;
+}
+
 /* Load a buffer as a string */
 const uint8_t *janet_string(const uint8_t *buf, int32_t len) {
     JanetStringHead *head = janet_gcalloc(JANET_MEMORY_STRING, sizeof(JanetStringHead) + (size_t) len + 1);
     head->length = len;
-    head->hash = janet_string_calchash(buf, len);
     uint8_t *data = (uint8_t *)head->data;
     safe_memcpy(data, buf, len);
     data[len] = 0;
@@ -67,11 +77,13 @@ int janet_string_compare(const uint8_t *lhs, const uint8_t *rhs) {
     return xlen < ylen ? -1 : 1;
 }
 
-/* Compare a janet string with a piece of memory */
+/* Compare a janet string with a piece of memory. Only compares hashes if
+ * lhs is already hashed, so this never hashes a string itself. */
 int janet_string_equalconst(const uint8_t *lhs, const uint8_t *rhs, int32_t rlen, int32_t rhash) {
-    int32_t lhash = janet_string_hash(lhs);
-    int32_t llen = janet_string_length(lhs);
-    if (lhash != rhash || llen != rlen)
+    JanetStringHead *head = janet_string_head(lhs);
+    if (head->length != rlen)
+        return 0;
+    if ((head->gc.flags & JANET_STRING_FLAG_HASHED) && head->hash != rhash)
         return 0;
     if (lhs == rhs)
         return 1;
@@ -80,8 +92,15 @@ int janet_string_equalconst(const uint8_t *lhs, const uint8_t *rhs, int32_t rlen
 
 /* Check if two strings are equal */
 int janet_string_equal(const uint8_t *lhs, const uint8_t *rhs) {
-    return janet_string_equalconst(lhs, rhs,
-                                   janet_string_length(rhs), janet_string_hash(rhs));
+    JanetStringHead *lhead = janet_string_head(lhs);
+    JanetStringHead *rhead = janet_string_head(rhs);
+    if (lhead->length != rhead->length)
+        return 0;
+    if (lhs == rhs)
+        return 1;
+    if ((lhead->gc.flags & rhead->gc.flags & JANET_STRING_FLAG_HASHED) && lhead->hash != rhead->hash)
+        return 0;
+    return !memcmp(lhs, rhs, lhead->length);
 }
 
 /* Load a c string */
@@ -148,6 +167,12 @@ static int32_t kmp_next(struct kmp_state *state) {
     const uint8_t *pat = state->pat;
     int32_t *lookup = state->lookup;
     while (i < textlen) {
+        if (j == 0) {
+            /* Skip straight to the next byte that could start a match */
+            const uint8_t *next = memchr(text + i, pat[0], (size_t)(textlen - i));
+            if (NULL == next) break;
+            i = (int32_t)(next - text);
+        }
         if (text[i] == pat[j]) {
             if (j == patlen - 1) {
                 state->i = i + 1;
@@ -251,14 +276,7 @@ JANET_CORE_FN(cfun_string_asciilower,
     janet_fixarity(argc, 1);
     JanetByteView view = janet_getbytes(argv, 0);
     uint8_t *buf = janet_string_begin(view.len);
-    for (int32_t i = 0; i < view.len; i++) {
-        uint8_t c = view.bytes[i];
-        if (c >= 65 && c <= 90) {
-            buf[i] = c + 32;
-        } else {
-            buf[i] = c;
-        }
-    }
+    janet_ascii_case(buf, view.bytes, view.len, 0);
     return janet_wrap_string(janet_string_end(buf));
 }
 
@@ -270,14 +288,7 @@ JANET_CORE_FN(cfun_string_asciiupper,
     janet_fixarity(argc, 1);
     JanetByteView view = janet_getbytes(argv, 0);
     uint8_t *buf = janet_string_begin(view.len);
-    for (int32_t i = 0; i < view.len; i++) {
-        uint8_t c = view.bytes[i];
-        if (c >= 97 && c <= 122) {
-            buf[i] = c - 32;
-        } else {
-            buf[i] = c;
-        }
-    }
+    janet_ascii_case(buf, view.bytes, view.len, 1);
     return janet_wrap_string(janet_string_end(buf));
 }
 
@@ -464,30 +475,333 @@ JANET_CORE_FN(cfun_string_split,
     return janet_wrap_array(array);
 }
 
+/*
+ * Multi-pattern search with an Aho-Corasick automaton. The automaton is
+ * stored as a full transition table over byte classes, where bytes that
+ * appear in no pattern share class 0, so matching costs one table lookup per
+ * byte of the text no matter how many patterns there are.
+ */
+
+typedef struct {
+    int32_t nstates;
+    int32_t nclasses;
+    int32_t *delta; /* nstates * nclasses transitions */
+    int32_t *out; /* pattern that ends at each state, or -1 */
+    int32_t *dict; /* next state on the suffix chain with an output, or -1 */
+    int32_t *depth; /* length of the prefix each state stands for */
+    int32_t *lens; /* length of each pattern */
+    Janet patterns; /* tuple */
+    Janet replacements; /* tuple parallel to patterns, or nil */
+    uint16_t classes[256];
+} StringMatcher;
+
+static void matcher_free(StringMatcher *m) {
+    janet_free(m->delta);
+    janet_free(m->out);
+    janet_free(m->dict);
+    janet_free(m->depth);
+    janet_free(m->lens);
+    m->delta = m->out = m->dict = m->depth = m->lens = NULL;
+}
+
+static int matcher_gc(void *p, size_t size) {
+    (void) size;
+    matcher_free((StringMatcher *) p);
+    return 0;
+}
+
+static int matcher_mark(void *p, size_t size) {
+    (void) size;
+    StringMatcher *m = (StringMatcher *) p;
+    janet_mark(m->patterns);
+    janet_mark(m->replacements);
+    return 0;
+}
+
+static int32_t *matcher_alloc(size_t n) {
+    int32_t *mem = janet_malloc((n ? n : 1) * sizeof(int32_t));
+    if (NULL == mem) {
+        JANET_OUT_OF_MEMORY;
+    }
+    return mem;
+}
+
+/* Build the automaton for the patterns of a matcher */
+static void matcher_build(StringMatcher *m) {
+    const Janet *patterns = janet_unwrap_tuple(m->patterns);
+    int32_t npatterns = janet_tuple_length(patterns);
+    size_t capacity = 1;
+    memset(m->classes, 0, sizeof(m->classes));
+    m->nclasses = 1;
+    m->lens = matcher_alloc((size_t) npatterns);
+    for (int32_t i = 0; i < npatterns; i++) {
+        JanetByteView view;
+        if (!janet_bytes_view(patterns[i], &view.bytes, &view.len)) {
+            janet_panicf("expected bytes pattern, got %v", patterns[i]);
+        }
+        if (view.len == 0) janet_panic("expected non-empty pattern");
+        m->lens[i] = view.len;
+        capacity += (size_t) view.len;
+        for (int32_t j = 0; j < view.len; j++) {
+            if (!m->classes[view.bytes[j]]) m->classes[view.bytes[j]] = (uint16_t)(m->nclasses++);
+        }
+    }
+    size_t n = (size_t) m->nclasses;
+    m->delta = matcher_alloc(capacity * n);
+    m->out = matcher_alloc(capacity);
+    m->dict = matcher_alloc(capacity);
+    m->depth = matcher_alloc(capacity);
+    int32_t *fail = matcher_alloc(capacity);
+    for (size_t i = 0; i < capacity * n; i++) m->delta[i] = -1;
+
+    /* Trie of all patterns. The first of several equal patterns wins. */
+    int32_t nstates = 1;
+    m->out[0] = -1;
+    m->depth[0] = 0;
+    for (int32_t i = 0; i < npatterns; i++) {
+        JanetByteView view;
+        janet_bytes_view(patterns[i], &view.bytes, &view.len);
+        int32_t state = 0;
+        for (int32_t j = 0; j < view.len; j++) {
+            int32_t *next = m->delta + (size_t) state * n + m->classes[view.bytes[j]];
+            if (*next < 0) {
+                *next = nstates;
+                m->out[nstates] = -1;
+                m->depth[nstates] = j + 1;
+                nstates++;
+            }
+            state = *next;
+        }
+        if (m->out[state] < 0) m->out[state] = i;
+    }
+
+    /* Breadth first, fill in failure transitions and suffix links. The
+     * failure state of a state is shallower, so it is always done first. */
+    int32_t *queue = matcher_alloc((size_t) nstates);
+    int32_t head = 0, tail = 0;
+    fail[0] = 0;
+    m->dict[0] = -1;
+    for (size_t c = 0; c < n; c++) {
+        int32_t t = m->delta[c];
+        if (t < 0) {
+            m->delta[c] = 0;
+        } else {
+            fail[t] = 0;
+            m->dict[t] = -1;
+            queue[tail++] = t;
+        }
+    }
+    while (head < tail) {
+        int32_t state = queue[head++];
+        int32_t *row = m->delta + (size_t) state * n;
+        int32_t *fail_row = m->delta + (size_t) fail[state] * n;
+        for (size_t c = 0; c < n; c++) {
+            int32_t t = row[c];
+            if (t < 0) {
+                row[c] = fail_row[c];
+            } else {
+                int32_t f = fail_row[c];
+                fail[t] = f;
+                m->dict[t] = m->out[f] >= 0 ? f : m->dict[f];
+                queue[tail++] = t;
+            }
+        }
+    }
+    janet_free(queue);
+    janet_free(fail);
+    m->nstates = nstates;
+}
+
+static void matcher_marshal(void *p, JanetMarshalContext *ctx) {
+    StringMatcher *m = (StringMatcher *) p;
+    janet_marshal_abstract(ctx, p);
+    janet_marshal_janet(ctx, m->patterns);
+    janet_marshal_janet(ctx, m->replacements);
+}
+
+static void *matcher_unmarshal(JanetMarshalContext *ctx) {
+    StringMatcher *m = janet_unmarshal_abstract(ctx, sizeof(StringMatcher));
+    m->delta = m->out = m->dict = m->depth = m->lens = NULL;
+    m->patterns = janet_wrap_nil();
+    m->replacements = janet_wrap_nil();
+    m->patterns = janet_unmarshal_janet(ctx);
+    m->replacements = janet_unmarshal_janet(ctx);
+    if (!janet_checktype(m->patterns, JANET_TUPLE)) janet_panic("invalid string matcher");
+    if (!janet_checktype(m->replacements, JANET_NIL) &&
+            (!janet_checktype(m->replacements, JANET_TUPLE) ||
+             janet_tuple_length(janet_unwrap_tuple(m->replacements)) != janet_tuple_length(janet_unwrap_tuple(m->patterns)))) {
+        janet_panic("invalid string matcher");
+    }
+    matcher_build(m);
+    return m;
+}
+
+static void matcher_tostring(void *p, JanetBuffer *buffer) {
+    StringMatcher *m = (StringMatcher *) p;
+    janet_formatb(buffer, "%d patterns", janet_tuple_length(janet_unwrap_tuple(m->patterns)));
+}
+
+static const JanetAbstractType janet_string_matcher_type = {
+    "core/string-matcher",
+    matcher_gc,
+    matcher_mark,
+    NULL, /* get */
+    NULL, /* put */
+    matcher_marshal,
+    matcher_unmarshal,
+    matcher_tostring,
+    JANET_ATEND_TOSTRING
+};
+
+/* Get a matcher from an argument, compiling patterns if needed */
+static StringMatcher *matcher_arg(Janet *argv, int32_t n) {
+    Janet x = argv[n];
+    if (janet_checkabstract(x, &janet_string_matcher_type)) {
+        return (StringMatcher *) janet_unwrap_abstract(x);
+    }
+    StringMatcher *m = janet_abstract(&janet_string_matcher_type, sizeof(StringMatcher));
+    m->delta = m->out = m->dict = m->depth = m->lens = NULL;
+    m->patterns = janet_wrap_nil();
+    m->replacements = janet_wrap_nil();
+    /* Keep the new matcher reachable while replacement functions run */
+    argv[n] = janet_wrap_abstract(m);
+    const Janet *items;
+    int32_t len;
+    JanetDictView dict;
+    if (janet_indexed_view(x, &items, &len)) {
+        m->patterns = janet_wrap_tuple(janet_tuple_n(items, len));
+    } else if (janet_dictionary_view(x, &dict.kvs, &dict.len, &dict.cap)) {
+        Janet *keys = janet_tuple_begin(dict.len);
+        Janet *values = janet_tuple_begin(dict.len);
+        int32_t j = 0;
+        for (int32_t i = 0; i < dict.cap; i++) {
+            if (janet_checktype(dict.kvs[i].key, JANET_NIL)) continue;
+            keys[j] = dict.kvs[i].key;
+            values[j] = dict.kvs[i].value;
+            j++;
+        }
+        m->patterns = janet_wrap_tuple(janet_tuple_end(keys));
+        m->replacements = janet_wrap_tuple(janet_tuple_end(values));
+    } else {
+        janet_panicf("bad slot #%d, expected indexed type, dictionary or core/string-matcher, got %v", n, x);
+    }
+    matcher_build(m);
+    return m;
+}
+
+static int32_t matcher_start(int32_t argc, Janet *argv, int32_t n, int32_t len) {
+    if (argc <= n) return 0;
+    int32_t start = janet_getinteger(argv, n);
+    if (start < 0) janet_panic("expected non-negative start index");
+    return start > len ? len : start;
+}
+
+JANET_CORE_FN(cfun_string_matcher,
+              "(string/matcher patterns)",
+              "Compile a list of byte sequences to search for, or a dictionary of byte sequences "
+              "to replacements, into a `core/string-matcher` that `string/find-any` and "
+              "`string/replace-many` can reuse. Searching a text for any number of patterns with a "
+              "matcher takes a single pass over the text. Matchers can be marshalled.") {
+    janet_fixarity(argc, 1);
+    return janet_wrap_abstract(matcher_arg(argv, 0));
+}
+
+JANET_CORE_FN(cfun_string_findany,
+              "(string/find-any patterns str &opt start-index)",
+              "Searches for all instances of all `patterns` in string `str` in a single pass. "
+              "`patterns` is a list or dictionary of patterns as for `string/matcher`, or a "
+              "matcher. Returns an array of `[index pattern]` tuples, ordered by where each match "
+              "ends in `str` and then from longest to shortest. Overlapping matches are all "
+              "included, as with `string/find-all`.") {
+    janet_arity(argc, 2, 3);
+    JanetByteView text = janet_getbytes(argv, 1);
+    int32_t start = matcher_start(argc, argv, 2, text.len);
+    StringMatcher *m = matcher_arg(argv, 0);
+    const Janet *patterns = janet_unwrap_tuple(m->patterns);
+    size_t n = (size_t) m->nclasses;
+    JanetArray *array = janet_array(0);
+    int32_t state = 0;
+    for (int32_t i = start; i < text.len; i++) {
+        state = m->delta[(size_t) state * n + m->classes[text.bytes[i]]];
+        int32_t o = m->out[state] >= 0 ? state : m->dict[state];
+        while (o >= 0) {
+            int32_t index = m->out[o];
+            Janet match[2];
+            match[0] = janet_wrap_integer(i + 1 - m->lens[index]);
+            match[1] = patterns[index];
+            janet_array_push(array, janet_wrap_tuple(janet_tuple_n(match, 2)));
+            o = m->dict[o];
+        }
+    }
+    return janet_wrap_array(array);
+}
+
+JANET_CORE_FN(cfun_string_replacemany,
+              "(string/replace-many replacements str &opt start-index)",
+              "Replace every instance of the keys of the dictionary `replacements` in the string "
+              "`str` with the corresponding values, in a single pass. `replacements` can also be a "
+              "matcher compiled from a dictionary with `string/matcher`. Where matches overlap, the "
+              "one that starts first is replaced, and of those the longest. As with "
+              "`string/replace-all`, a replacement that is a function is called with the match "
+              "and should return the replacement text. Returns a new string.") {
+    janet_arity(argc, 2, 3);
+    JanetByteView text = janet_getbytes(argv, 1);
+    int32_t start = matcher_start(argc, argv, 2, text.len);
+    StringMatcher *m = matcher_arg(argv, 0);
+    if (janet_checktype(m->replacements, JANET_NIL)) {
+        janet_panic("expected a matcher compiled from a dictionary of replacements");
+    }
+    size_t n = (size_t) m->nclasses;
+    JanetBuffer b;
+    janet_buffer_init(&b, text.len);
+    int32_t last = 0;
+    int32_t best = -1, best_start = 0;
+    int32_t state = 0;
+    int32_t i = start;
+    for (;;) {
+        /* Commit the best match once no match still in progress can start
+         * at or before it, or at the end of the text */
+        if (best >= 0 && (i >= text.len || best_start < i - m->depth[state])) {
+            Janet subst = janet_unwrap_tuple(m->replacements)[best];
+            JanetByteView view = janet_text_substitution(&subst, text.bytes + best_start, m->lens[best], NULL);
+            janet_buffer_push_bytes(&b, text.bytes + last, best_start - last);
+            janet_buffer_push_bytes(&b, view.bytes, view.len);
+            last = best_start + m->lens[best];
+            i = last;
+            state = 0;
+            best = -1;
+        }
+        if (i >= text.len) break;
+        state = m->delta[(size_t) state * n + m->classes[text.bytes[i++]]];
+        int32_t o = m->out[state] >= 0 ? state : m->dict[state];
+        while (o >= 0) {
+            int32_t index = m->out[o];
+            int32_t match_start = i - m->lens[index];
+            if (best < 0 || match_start < best_start ||
+                    (match_start == best_start && m->lens[index] > m->lens[best])) {
+                best = index;
+                best_start = match_start;
+            }
+            o = m->dict[o];
+        }
+    }
+    janet_buffer_push_bytes(&b, text.bytes + last, text.len - last);
+    const uint8_t *ret = janet_string(b.data, b.count);
+    janet_buffer_deinit(&b);
+    return janet_wrap_string(ret);
+}
+
 JANET_CORE_FN(cfun_string_checkset,
               "(string/check-set set str)",
               "Checks that the string `str` only contains bytes that appear in the string `set`. "
               "Returns true if all bytes in `str` appear in `set`, false if some bytes in `str` do "
               "not appear in `set`.") {
-    uint32_t bitset[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    JanetByteSet byteset;
     janet_fixarity(argc, 2);
     JanetByteView set = janet_getbytes(argv, 0);
     JanetByteView str = janet_getbytes(argv, 1);
-    /* Populate set */
-    for (int32_t i = 0; i < set.len; i++) {
-        int index = set.bytes[i] >> 5;
-        uint32_t mask = 1 << (set.bytes[i] & 0x1F);
-        bitset[index] |= mask;
-    }
-    /* Check set */
-    for (int32_t i = 0; i < str.len; i++) {
-        int index = str.bytes[i] >> 5;
-        uint32_t mask = 1 << (str.bytes[i] & 0x1F);
-        if (!(bitset[index] & mask)) {
-            return janet_wrap_false();
-        }
-    }
-    return janet_wrap_true();
+    janet_byteset_init(&byteset, set.bytes, set.len);
+    return janet_wrap_boolean(janet_byteset_span(&byteset, str.bytes, str.len) == str.len);
 }
 
 JANET_CORE_FN(cfun_string_join,
@@ -567,25 +881,16 @@ JANET_CORE_FN(cfun_string_format,
     return janet_stringv(buffer->data, buffer->count);
 }
 
-static int trim_help_checkset(JanetByteView set, uint8_t x) {
-    for (int32_t j = 0; j < set.len; j++)
-        if (set.bytes[j] == x)
-            return 1;
-    return 0;
-}
-
 static int32_t trim_help_leftedge(JanetByteView str, JanetByteView set) {
-    for (int32_t i = 0; i < str.len; i++)
-        if (!trim_help_checkset(set, str.bytes[i]))
-            return i;
-    return str.len;
+    JanetByteSet byteset;
+    janet_byteset_init(&byteset, set.bytes, set.len);
+    return janet_byteset_span(&byteset, str.bytes, str.len);
 }
 
 static int32_t trim_help_rightedge(JanetByteView str, JanetByteView set) {
-    for (int32_t i = str.len - 1; i >= 0; i--)
-        if (!trim_help_checkset(set, str.bytes[i]))
-            return i + 1;
-    return 0;
+    JanetByteSet byteset;
+    janet_byteset_init(&byteset, set.bytes, set.len);
+    return str.len - janet_byteset_rspan(&byteset, str.bytes, str.len);
 }
 
 static void trim_help_args(int32_t argc, Janet *argv, JanetByteView *str, JanetByteView *set) {
@@ -651,6 +956,9 @@ void janet_lib_string(JanetTable *env) {
         JANET_CORE_REG("string/replace", cfun_string_replace),
         JANET_CORE_REG("string/replace-all", cfun_string_replaceall),
         JANET_CORE_REG("string/split", cfun_string_split),
+        JANET_CORE_REG("string/matcher", cfun_string_matcher),
+        JANET_CORE_REG("string/find-any", cfun_string_findany),
+        JANET_CORE_REG("string/replace-many", cfun_string_replacemany),
         JANET_CORE_REG("string/check-set", cfun_string_checkset),
         JANET_CORE_REG("string/join", cfun_string_join),
         JANET_CORE_REG("string/format", cfun_string_format),
@@ -660,4 +968,5 @@ void janet_lib_string(JanetTable *env) {
         JANET_REG_END
     };
     janet_core_cfuns_ext(env, NULL, string_cfuns);
+    janet_register_abstract_type(&janet_string_matcher_type);
 }
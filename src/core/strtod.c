@@ -103,6 +103,13 @@ static void bignat_append(struct BigNat *mant, uint32_t dig) {
     bignat_extra(mant, 1)[0] = dig;
 }
 
+/* Set a zero mantissa to a 64 bit value */
+static void bignat_set_u64(struct BigNat *mant, uint64_t x) {
+    mant->first_digit = (uint32_t)(x % BIGNAT_BASE);
+    for (x /= BIGNAT_BASE; x; x /= BIGNAT_BASE)
+        bignat_append(mant, (uint32_t)(x % BIGNAT_BASE));
+}
+
 /* Multiply the mantissa mant by a factor and the add a term
  * in one operation. factor will be between 2 and 36^4,
  * term will be between 0 and 36. */
@@ -119,8 +126,9 @@ static void bignat_muladd(struct BigNat *mant, uint32_t factor, uint32_t term) {
     if (carry) bignat_append(mant, (uint32_t) carry);
 }
 
-/* Divide the mantissa mant by a factor. Drop the remainder. */
-static void bignat_div(struct BigNat *mant, uint32_t divisor) {
+/* Divide the mantissa mant by a factor. Drop the remainder, and return
+ * whether it was non-zero. */
+static int bignat_div(struct BigNat *mant, uint32_t divisor) {
     int32_t i;
     uint32_t quotient, remainder;
     uint64_t dividend;
@@ -135,6 +143,7 @@ static void bignat_div(struct BigNat *mant, uint32_t divisor) {
     dividend = ((uint64_t)remainder * BIGNAT_BASE) + mant->first_digit;
     if (mant->n && mant->digits[mant->n - 1] == 0) mant->n--;
     mant->first_digit = (uint32_t)(dividend / divisor);
+    return (dividend % divisor) != 0;
 }
 
 /* Shift left by a multiple of BIGNAT_NBIT */
@@ -162,11 +171,14 @@ static int clz(uint32_t x) {
 }
 #endif
 
-/* Extract double value from mantissa */
-static double bignat_extract(struct BigNat *mant, int32_t exponent2) {
-    uint64_t top53;
+/* Extract double value from mantissa. inexact is set if the mantissa is
+ * slightly less than the real value. Rounds half to even, also when the
+ * result is denormalized. */
+static double bignat_extract(struct BigNat *mant, int32_t exponent2, int inexact) {
+    uint64_t top;
+    int sticky = inexact;
     int32_t n = mant->n;
-    /* Get most significant 53 bits from mant. Bit 52 (0 indexed) should
+    /* Get most significant 54 bits from mant. Bit 53 (0 indexed) should
      * always be 1. This is essentially a large right shift on mant.*/
     if (n) {
         /* Two or more digits */
@@ -175,24 +187,39 @@ static double bignat_extract(struct BigNat *mant, int32_t exponent2) {
         uint64_t d3 = (n > 2) ? mant->digits[n - 3] : (n == 2) ? mant->first_digit : 0;
         int lz = clz((uint32_t) d1);
         int nbits = 32 - lz;
-        /* First get 54 bits */
-        top53 = (d2 << (54 - BIGNAT_NBIT)) + (d3 >> (2 * BIGNAT_NBIT - 54));
-        top53 >>= nbits;
-        top53 |= (d1 << (54 - nbits));
-        /* Rounding based on lowest bit of 54 */
-        if (top53 & 1) top53++;
-        top53 >>= 1;
-        if (top53 > 0x1FffffFFFFffffUL) {
-            top53 >>= 1;
-            exponent2++;
+        top = (d2 << (54 - BIGNAT_NBIT)) + (d3 >> (2 * BIGNAT_NBIT - 54));
+        /* Check if any bits below the 54 are set */
+        sticky = sticky || (top & ((1ULL << nbits) - 1)) ||
+                 (d3 & ((1U << (2 * BIGNAT_NBIT - 54)) - 1));
+        if (n > 2) {
+            sticky = sticky || mant->first_digit;
+            for (int32_t i = 0; i < n - 3 && !sticky; i++) sticky = mant->digits[i] != 0;
         }
+        top >>= nbits;
+        top |= (d1 << (54 - nbits));
         /* Correct exponent - to correct for large right shift to mantissa. */
-        exponent2 += (nbits - 53) + BIGNAT_NBIT * n;
+        exponent2 += (nbits - 54) + BIGNAT_NBIT * n;
     } else {
         /* One digit */
-        top53 = mant->first_digit;
+        top = mant->first_digit;
+    }
+    if (top == 0) return 0.0;
+    /* Keep 53 bits, or fewer if the result is denormalized */
+    int32_t bitlen = 64;
+    while (!(top & (1ULL << (bitlen - 1)))) bitlen--;
+    int32_t keep = 53;
+    int32_t top_exponent = exponent2 + bitlen - 1;
+    if (top_exponent < -1022) keep -= -1022 - top_exponent;
+    int32_t drop = bitlen - keep;
+    if (drop > 0) {
+        if (drop > bitlen) return 0.0;
+        int half = (top >> (drop - 1)) & 1;
+        sticky = sticky || (top & ((1ULL << (drop - 1)) - 1));
+        top = (drop == 64) ? 0 : (top >> drop);
+        exponent2 += drop;
+        if (half && (sticky || (top & 1))) top++;
     }
-    return ldexp((double)top53, exponent2);
+    return ldexp((double)top, exponent2);
 }
 
 /* Read in a mantissa and exponent of a certain base, and give
@@ -205,6 +232,7 @@ static double convert(
     int32_t exponent) {
 
     int32_t exponent2 = 0;
+    int inexact = 0;
 
     /* Approximate exponent in base 2 of mant and exponent. This should get us a good estimate of the final size of the
      * number, within * 2^32 or so. */
@@ -235,14 +263,753 @@ static double convert(
         int32_t shamt = 5 - exponent / 4;
         bignat_lshift_n(mant, shamt);
         exponent2 -= shamt * BIGNAT_NBIT;
-        for (; exponent < -3; exponent += 4) bignat_div(mant, base * base * base * base);
-        for (; exponent < -1; exponent += 2) bignat_div(mant, base * base);
-        for (; exponent <  0; exponent += 1) bignat_div(mant, base);
+        for (; exponent < -3; exponent += 4) inexact |= bignat_div(mant, base * base * base * base);
+        for (; exponent < -1; exponent += 2) inexact |= bignat_div(mant, base * base);
+        for (; exponent <  0; exponent += 1) inexact |= bignat_div(mant, base);
     }
 
     return negative
-           ? -bignat_extract(mant, exponent2)
-           : bignat_extract(mant, exponent2);
+           ? -bignat_extract(mant, exponent2, inexact)
+           : bignat_extract(mant, exponent2, inexact);
+}
+
+/*
+ * Fast path for decimal numbers
+ *
+ * Most decimal numbers have at most 19 significant digits and a moderate
+ * exponent. Those are converted with the Eisel-Lemire algorithm from "Number
+ * Parsing at a Gigabyte per Second" by Daniel Lemire, which needs one or two
+ * 64x64 bit multiplies. When the result is too close to halfway between two
+ * doubles to decide, or would be denormalized or infinite, we fall back to
+ * convert.
+ */
+
+#define SCAN_POW10_MIN (-342)
+#define SCAN_POW10_MAX 308
+
+/* 10^q rounded down to 128 bits with the top bit set, for q from -342 to 308 */
+static const uint64_t scan_pow10[651][2] = {
+    {0x113faa2906a13b3fULL, 0xeef453d6923bd65aULL},
+    {0x4ac7ca59a424c507ULL, 0x9558b4661b6565f8ULL},
+    {0x5d79bcf00d2df649ULL, 0xbaaee17fa23ebf76ULL},
+    {0xf4d82c2c107973dcULL, 0xe95a99df8ace6f53ULL},
+    {0x79071b9b8a4be869ULL, 0x91d8a02bb6c10594ULL},
+    {0x9748e2826cdee284ULL, 0xb64ec836a47146f9ULL},
+    {0xfd1b1b2308169b25ULL, 0xe3e27a444d8d98b7ULL},
+    {0xfe30f0f5e50e20f7ULL, 0x8e6d8c6ab0787f72ULL},
+    {0xbdbd2d335e51a935ULL, 0xb208ef855c969f4fULL},
+    {0xad2c788035e61382ULL, 0xde8b2b66b3bc4723ULL},
+    {0x4c3bcb5021afcc31ULL, 0x8b16fb203055ac76ULL},
+    {0xdf4abe242a1bbf3dULL, 0xaddcb9e83c6b1793ULL},
+    {0xd71d6dad34a2af0dULL, 0xd953e8624b85dd78ULL},
+    {0x8672648c40e5ad68ULL, 0x87d4713d6f33aa6bULL},
+    {0x680efdaf511f18c2ULL, 0xa9c98d8ccb009506ULL},
+    {0x0212bd1b2566def2ULL, 0xd43bf0effdc0ba48ULL},
+    {0x014bb630f7604b57ULL, 0x84a57695fe98746dULL},
+    {0x419ea3bd35385e2dULL, 0xa5ced43b7e3e9188ULL},
+    {0x52064cac828675b9ULL, 0xcf42894a5dce35eaULL},
+    {0x7343efebd1940993ULL, 0x818995ce7aa0e1b2ULL},
+    {0x1014ebe6c5f90bf8ULL, 0xa1ebfb4219491a1fULL},
+    {0xd41a26e077774ef6ULL, 0xca66fa129f9b60a6ULL},
+    {0x8920b098955522b4ULL, 0xfd00b897478238d0ULL},
+    {0x55b46e5f5d5535b0ULL, 0x9e20735e8cb16382ULL},
+    {0xeb2189f734aa831dULL, 0xc5a890362fddbc62ULL},
+    {0xa5e9ec7501d523e4ULL, 0xf712b443bbd52b7bULL},
+    {0x47b233c92125366eULL, 0x9a6bb0aa55653b2dULL},
+    {0x999ec0bb696e840aULL, 0xc1069cd4eabe89f8ULL},
+    {0xc00670ea43ca250dULL, 0xf148440a256e2c76ULL},
+    {0x380406926a5e5728ULL, 0x96cd2a865764dbcaULL},
+    {0xc605083704f5ecf2ULL, 0xbc807527ed3e12bcULL},
+    {0xf7864a44c633682eULL, 0xeba09271e88d976bULL},
+    {0x7ab3ee6afbe0211dULL, 0x93445b8731587ea3ULL},
+    {0x5960ea05bad82964ULL, 0xb8157268fdae9e4cULL},
+    {0x6fb92487298e33bdULL, 0xe61acf033d1a45dfULL},
+    {0xa5d3b6d479f8e056ULL, 0x8fd0c16206306babULL},
+    {0x8f48a4899877186cULL, 0xb3c4f1ba87bc8696ULL},
+    {0x331acdabfe94de87ULL, 0xe0b62e2929aba83cULL},
+    {0x9ff0c08b7f1d0b14ULL, 0x8c71dcd9ba0b4925ULL},
+    {0x07ecf0ae5ee44dd9ULL, 0xaf8e5410288e1b6fULL},
+    {0xc9e82cd9f69d6150ULL, 0xdb71e91432b1a24aULL},
+    {0xbe311c083a225cd2ULL, 0x892731ac9faf056eULL},
+    {0x6dbd630a48aaf406ULL, 0xab70fe17c79ac6caULL},
+    {0x092cbbccdad5b108ULL, 0xd64d3d9db981787dULL},
+    {0x25bbf56008c58ea5ULL, 0x85f0468293f0eb4eULL},
+    {0xaf2af2b80af6f24eULL, 0xa76c582338ed2621ULL},
+    {0x1af5af660db4aee1ULL, 0xd1476e2c07286faaULL},
+    {0x50d98d9fc890ed4dULL, 0x82cca4db847945caULL},
+    {0xe50ff107bab528a0ULL, 0xa37fce126597973cULL},
+    {0x1e53ed49a96272c8ULL, 0xcc5fc196fefd7d0cULL},
+    {0x25e8e89c13bb0f7aULL, 0xff77b1fcbebcdc4fULL},
+    {0x77b191618c54e9acULL, 0x9faacf3df73609b1ULL},
+    {0xd59df5b9ef6a2417ULL, 0xc795830d75038c1dULL},
+    {0x4b0573286b44ad1dULL, 0xf97ae3d0d2446f25ULL},
+    {0x4ee367f9430aec32ULL, 0x9becce62836ac577ULL},
+    {0x229c41f793cda73fULL, 0xc2e801fb244576d5ULL},
+    {0x6b43527578c1110fULL, 0xf3a20279ed56d48aULL},
+    {0x830a13896b78aaa9ULL, 0x9845418c345644d6ULL},
+    {0x23cc986bc656d553ULL, 0xbe5691ef416bd60cULL},
+    {0x2cbfbe86b7ec8aa8ULL, 0xedec366b11c6cb8fULL},
+    {0x7bf7d71432f3d6a9ULL, 0x94b3a202eb1c3f39ULL},
+    {0xdaf5ccd93fb0cc53ULL, 0xb9e08a83a5e34f07ULL},
+    {0xd1b3400f8f9cff68ULL, 0xe858ad248f5c22c9ULL},
+    {0x23100809b9c21fa1ULL, 0x91376c36d99995beULL},
+    {0xabd40a0c2832a78aULL, 0xb58547448ffffb2dULL},
+    {0x16c90c8f323f516cULL, 0xe2e69915b3fff9f9ULL},
+    {0xae3da7d97f6792e3ULL, 0x8dd01fad907ffc3bULL},
+    {0x99cd11cfdf41779cULL, 0xb1442798f49ffb4aULL},
+    {0x40405643d711d583ULL, 0xdd95317f31c7fa1dULL},
+    {0x482835ea666b2572ULL, 0x8a7d3eef7f1cfc52ULL},
+    {0xda3243650005eecfULL, 0xad1c8eab5ee43b66ULL},
+    {0x90bed43e40076a82ULL, 0xd863b256369d4a40ULL},
+    {0x5a7744a6e804a291ULL, 0x873e4f75e2224e68ULL},
+    {0x711515d0a205cb36ULL, 0xa90de3535aaae202ULL},
+    {0x0d5a5b44ca873e03ULL, 0xd3515c2831559a83ULL},
+    {0xe858790afe9486c2ULL, 0x8412d9991ed58091ULL},
+    {0x626e974dbe39a872ULL, 0xa5178fff668ae0b6ULL},
+    {0xfb0a3d212dc8128fULL, 0xce5d73ff402d98e3ULL},
+    {0x7ce66634bc9d0b99ULL, 0x80fa687f881c7f8eULL},
+    {0x1c1fffc1ebc44e80ULL, 0xa139029f6a239f72ULL},
+    {0xa327ffb266b56220ULL, 0xc987434744ac874eULL},
+    {0x4bf1ff9f0062baa8ULL, 0xfbe9141915d7a922ULL},
+    {0x6f773fc3603db4a9ULL, 0x9d71ac8fada6c9b5ULL},
+    {0xcb550fb4384d21d3ULL, 0xc4ce17b399107c22ULL},
+    {0x7e2a53a146606a48ULL, 0xf6019da07f549b2bULL},
+    {0x2eda7444cbfc426dULL, 0x99c102844f94e0fbULL},
+    {0xfa911155fefb5308ULL, 0xc0314325637a1939ULL},
+    {0x793555ab7eba27caULL, 0xf03d93eebc589f88ULL},
+    {0x4bc1558b2f3458deULL, 0x96267c7535b763b5ULL},
+    {0x9eb1aaedfb016f16ULL, 0xbbb01b9283253ca2ULL},
+    {0x465e15a979c1cadcULL, 0xea9c227723ee8bcbULL},
+    {0x0bfacd89ec191ec9ULL, 0x92a1958a7675175fULL},
+    {0xcef980ec671f667bULL, 0xb749faed14125d36ULL},
+    {0x82b7e12780e7401aULL, 0xe51c79a85916f484ULL},
+    {0xd1b2ecb8b0908810ULL, 0x8f31cc0937ae58d2ULL},
+    {0x861fa7e6dcb4aa15ULL, 0xb2fe3f0b8599ef07ULL},
+    {0x67a791e093e1d49aULL, 0xdfbdcece67006ac9ULL},
+    {0xe0c8bb2c5c6d24e0ULL, 0x8bd6a141006042bdULL},
+    {0x58fae9f773886e18ULL, 0xaecc49914078536dULL},
+    {0xaf39a475506a899eULL, 0xda7f5bf590966848ULL},
+    {0x6d8406c952429603ULL, 0x888f99797a5e012dULL},
+    {0xc8e5087ba6d33b83ULL, 0xaab37fd7d8f58178ULL},
+    {0xfb1e4a9a90880a64ULL, 0xd5605fcdcf32e1d6ULL},
+    {0x5cf2eea09a55067fULL, 0x855c3be0a17fcd26ULL},
+    {0xf42faa48c0ea481eULL, 0xa6b34ad8c9dfc06fULL},
+    {0xf13b94daf124da26ULL, 0xd0601d8efc57b08bULL},
+    {0x76c53d08d6b70858ULL, 0x823c12795db6ce57ULL},
+    {0x54768c4b0c64ca6eULL, 0xa2cb1717b52481edULL},
+    {0xa9942f5dcf7dfd09ULL, 0xcb7ddcdda26da268ULL},
+    {0xd3f93b35435d7c4cULL, 0xfe5d54150b090b02ULL},
+    {0xc47bc5014a1a6dafULL, 0x9efa548d26e5a6e1ULL},
+    {0x359ab6419ca1091bULL, 0xc6b8e9b0709f109aULL},
+    {0xc30163d203c94b62ULL, 0xf867241c8cc6d4c0ULL},
+    {0x79e0de63425dcf1dULL, 0x9b407691d7fc44f8ULL},
+    {0x985915fc12f542e4ULL, 0xc21094364dfb5636ULL},
+    {0x3e6f5b7b17b2939dULL, 0xf294b943e17a2bc4ULL},
+    {0xa705992ceecf9c42ULL, 0x979cf3ca6cec5b5aULL},
+    {0x50c6ff782a838353ULL, 0xbd8430bd08277231ULL},
+    {0xa4f8bf5635246428ULL, 0xece53cec4a314ebdULL},
+    {0x871b7795e136be99ULL, 0x940f4613ae5ed136ULL},
+    {0x28e2557b59846e3fULL, 0xb913179899f68584ULL},
+    {0x331aeada2fe589cfULL, 0xe757dd7ec07426e5ULL},
+    {0x3ff0d2c85def7621ULL, 0x9096ea6f3848984fULL},
+    {0x0fed077a756b53a9ULL, 0xb4bca50b065abe63ULL},
+    {0xd3e8495912c62894ULL, 0xe1ebce4dc7f16dfbULL},
+    {0x64712dd7abbbd95cULL, 0x8d3360f09cf6e4bdULL},
+    {0xbd8d794d96aacfb3ULL, 0xb080392cc4349decULL},
+    {0xecf0d7a0fc5583a0ULL, 0xdca04777f541c567ULL},
+    {0xf41686c49db57244ULL, 0x89e42caaf9491b60ULL},
+    {0x311c2875c522ced5ULL, 0xac5d37d5b79b6239ULL},
+    {0x7d633293366b828bULL, 0xd77485cb25823ac7ULL},
+    {0xae5dff9c02033197ULL, 0x86a8d39ef77164bcULL},
+    {0xd9f57f830283fdfcULL, 0xa8530886b54dbdebULL},
+    {0xd072df63c324fd7bULL, 0xd267caa862a12d66ULL},
+    {0x4247cb9e59f71e6dULL, 0x8380dea93da4bc60ULL},
+    {0x52d9be85f074e608ULL, 0xa46116538d0deb78ULL},
+    {0x67902e276c921f8bULL, 0xcd795be870516656ULL},
+    {0x00ba1cd8a3db53b6ULL, 0x806bd9714632dff6ULL},
+    {0x80e8a40eccd228a4ULL, 0xa086cfcd97bf97f3ULL},
+    {0x6122cd128006b2cdULL, 0xc8a883c0fdaf7df0ULL},
+    {0x796b805720085f81ULL, 0xfad2a4b13d1b5d6cULL},
+    {0xcbe3303674053bb0ULL, 0x9cc3a6eec6311a63ULL},
+    {0xbedbfc4411068a9cULL, 0xc3f490aa77bd60fcULL},
+    {0xee92fb5515482d44ULL, 0xf4f1b4d515acb93bULL},
+    {0x751bdd152d4d1c4aULL, 0x991711052d8bf3c5ULL},
+    {0xd262d45a78a0635dULL, 0xbf5cd54678eef0b6ULL},
+    {0x86fb897116c87c34ULL, 0xef340a98172aace4ULL},
+    {0xd45d35e6ae3d4da0ULL, 0x9580869f0e7aac0eULL},
+    {0x8974836059cca109ULL, 0xbae0a846d2195712ULL},
+    {0x2bd1a438703fc94bULL, 0xe998d258869facd7ULL},
+    {0x7b6306a34627ddcfULL, 0x91ff83775423cc06ULL},
+    {0x1a3bc84c17b1d542ULL, 0xb67f6455292cbf08ULL},
+    {0x20caba5f1d9e4a93ULL, 0xe41f3d6a7377eecaULL},
+    {0x547eb47b7282ee9cULL, 0x8e938662882af53eULL},
+    {0xe99e619a4f23aa43ULL, 0xb23867fb2a35b28dULL},
+    {0x6405fa00e2ec94d4ULL, 0xdec681f9f4c31f31ULL},
+    {0xde83bc408dd3dd04ULL, 0x8b3c113c38f9f37eULL},
+    {0x9624ab50b148d445ULL, 0xae0b158b4738705eULL},
+    {0x3badd624dd9b0957ULL, 0xd98ddaee19068c76ULL},
+    {0xe54ca5d70a80e5d6ULL, 0x87f8a8d4cfa417c9ULL},
+    {0x5e9fcf4ccd211f4cULL, 0xa9f6d30a038d1dbcULL},
+    {0x7647c3200069671fULL, 0xd47487cc8470652bULL},
+    {0x29ecd9f40041e073ULL, 0x84c8d4dfd2c63f3bULL},
+    {0xf468107100525890ULL, 0xa5fb0a17c777cf09ULL},
+    {0x7182148d4066eeb4ULL, 0xcf79cc9db955c2ccULL},
+    {0xc6f14cd848405530ULL, 0x81ac1fe293d599bfULL},
+    {0xb8ada00e5a506a7cULL, 0xa21727db38cb002fULL},
+    {0xa6d90811f0e4851cULL, 0xca9cf1d206fdc03bULL},
+    {0x908f4a166d1da663ULL, 0xfd442e4688bd304aULL},
+    {0x9a598e4e043287feULL, 0x9e4a9cec15763e2eULL},
+    {0x40eff1e1853f29fdULL, 0xc5dd44271ad3cdbaULL},
+    {0xd12bee59e68ef47cULL, 0xf7549530e188c128ULL},
+    {0x82bb74f8301958ceULL, 0x9a94dd3e8cf578b9ULL},
+    {0xe36a52363c1faf01ULL, 0xc13a148e3032d6e7ULL},
+    {0xdc44e6c3cb279ac1ULL, 0xf18899b1bc3f8ca1ULL},
+    {0x29ab103a5ef8c0b9ULL, 0x96f5600f15a7b7e5ULL},
+    {0x7415d448f6b6f0e7ULL, 0xbcb2b812db11a5deULL},
+    {0x111b495b3464ad21ULL, 0xebdf661791d60f56ULL},
+    {0xcab10dd900beec34ULL, 0x936b9fcebb25c995ULL},
+    {0x3d5d514f40eea742ULL, 0xb84687c269ef3bfbULL},
+    {0x0cb4a5a3112a5112ULL, 0xe65829b3046b0afaULL},
+    {0x47f0e785eaba72abULL, 0x8ff71a0fe2c2e6dcULL},
+    {0x59ed216765690f56ULL, 0xb3f4e093db73a093ULL},
+    {0x306869c13ec3532cULL, 0xe0f218b8d25088b8ULL},
+    {0x1e414218c73a13fbULL, 0x8c974f7383725573ULL},
+    {0xe5d1929ef90898faULL, 0xafbd2350644eeacfULL},
+    {0xdf45f746b74abf39ULL, 0xdbac6c247d62a583ULL},
+    {0x6b8bba8c328eb783ULL, 0x894bc396ce5da772ULL},
+    {0x066ea92f3f326564ULL, 0xab9eb47c81f5114fULL},
+    {0xc80a537b0efefebdULL, 0xd686619ba27255a2ULL},
+    {0xbd06742ce95f5f36ULL, 0x8613fd0145877585ULL},
+    {0x2c48113823b73704ULL, 0xa798fc4196e952e7ULL},
+    {0xf75a15862ca504c5ULL, 0xd17f3b51fca3a7a0ULL},
+    {0x9a984d73dbe722fbULL, 0x82ef85133de648c4ULL},
+    {0xc13e60d0d2e0ebbaULL, 0xa3ab66580d5fdaf5ULL},
+    {0x318df905079926a8ULL, 0xcc963fee10b7d1b3ULL},
+    {0xfdf17746497f7052ULL, 0xffbbcfe994e5c61fULL},
+    {0xfeb6ea8bedefa633ULL, 0x9fd561f1fd0f9bd3ULL},
+    {0xfe64a52ee96b8fc0ULL, 0xc7caba6e7c5382c8ULL},
+    {0x3dfdce7aa3c673b0ULL, 0xf9bd690a1b68637bULL},
+    {0x06bea10ca65c084eULL, 0x9c1661a651213e2dULL},
+    {0x486e494fcff30a62ULL, 0xc31bfa0fe5698db8ULL},
+    {0x5a89dba3c3efccfaULL, 0xf3e2f893dec3f126ULL},
+    {0xf89629465a75e01cULL, 0x986ddb5c6b3a76b7ULL},
+    {0xf6bbb397f1135823ULL, 0xbe89523386091465ULL},
+    {0x746aa07ded582e2cULL, 0xee2ba6c0678b597fULL},
+    {0xa8c2a44eb4571cdcULL, 0x94db483840b717efULL},
+    {0x92f34d62616ce413ULL, 0xba121a4650e4ddebULL},
+    {0x77b020baf9c81d17ULL, 0xe896a0d7e51e1566ULL},
+    {0x0ace1474dc1d122eULL, 0x915e2486ef32cd60ULL},
+    {0x0d819992132456baULL, 0xb5b5ada8aaff80b8ULL},
+    {0x10e1fff697ed6c69ULL, 0xe3231912d5bf60e6ULL},
+    {0xca8d3ffa1ef463c1ULL, 0x8df5efabc5979c8fULL},
+    {0xbd308ff8a6b17cb2ULL, 0xb1736b96b6fd83b3ULL},
+    {0xac7cb3f6d05ddbdeULL, 0xddd0467c64bce4a0ULL},
+    {0x6bcdf07a423aa96bULL, 0x8aa22c0dbef60ee4ULL},
+    {0x86c16c98d2c953c6ULL, 0xad4ab7112eb3929dULL},
+    {0xe871c7bf077ba8b7ULL, 0xd89d64d57a607744ULL},
+    {0x11471cd764ad4972ULL, 0x87625f056c7c4a8bULL},
+    {0xd598e40d3dd89bcfULL, 0xa93af6c6c79b5d2dULL},
+    {0x4aff1d108d4ec2c3ULL, 0xd389b47879823479ULL},
+    {0xcedf722a585139baULL, 0x843610cb4bf160cbULL},
+    {0xc2974eb4ee658828ULL, 0xa54394fe1eedb8feULL},
+    {0x733d226229feea32ULL, 0xce947a3da6a9273eULL},
+    {0x0806357d5a3f525fULL, 0x811ccc668829b887ULL},
+    {0xca07c2dcb0cf26f7ULL, 0xa163ff802a3426a8ULL},
+    {0xfc89b393dd02f0b5ULL, 0xc9bcff6034c13052ULL},
+    {0xbbac2078d443ace2ULL, 0xfc2c3f3841f17c67ULL},
+    {0xd54b944b84aa4c0dULL, 0x9d9ba7832936edc0ULL},
+    {0x0a9e795e65d4df11ULL, 0xc5029163f384a931ULL},
+    {0x4d4617b5ff4a16d5ULL, 0xf64335bcf065d37dULL},
+    {0x504bced1bf8e4e45ULL, 0x99ea0196163fa42eULL},
+    {0xe45ec2862f71e1d6ULL, 0xc06481fb9bcf8d39ULL},
+    {0x5d767327bb4e5a4cULL, 0xf07da27a82c37088ULL},
+    {0x3a6a07f8d510f86fULL, 0x964e858c91ba2655ULL},
+    {0x890489f70a55368bULL, 0xbbe226efb628afeaULL},
+    {0x2b45ac74ccea842eULL, 0xeadab0aba3b2dbe5ULL},
+    {0x3b0b8bc90012929dULL, 0x92c8ae6b464fc96fULL},
+    {0x09ce6ebb40173744ULL, 0xb77ada0617e3bbcbULL},
+    {0xcc420a6a101d0515ULL, 0xe55990879ddcaabdULL},
+    {0x9fa946824a12232dULL, 0x8f57fa54c2a9eab6ULL},
+    {0x47939822dc96abf9ULL, 0xb32df8e9f3546564ULL},
+    {0x59787e2b93bc56f7ULL, 0xdff9772470297ebdULL},
+    {0x57eb4edb3c55b65aULL, 0x8bfbea76c619ef36ULL},
+    {0xede622920b6b23f1ULL, 0xaefae51477a06b03ULL},
+    {0xe95fab368e45ecedULL, 0xdab99e59958885c4ULL},
+    {0x11dbcb0218ebb414ULL, 0x88b402f7fd75539bULL},
+    {0xd652bdc29f26a119ULL, 0xaae103b5fcd2a881ULL},
+    {0x4be76d3346f0495fULL, 0xd59944a37c0752a2ULL},
+    {0x6f70a4400c562ddbULL, 0x857fcae62d8493a5ULL},
+    {0xcb4ccd500f6bb952ULL, 0xa6dfbd9fb8e5b88eULL},
+    {0x7e2000a41346a7a7ULL, 0xd097ad07a71f26b2ULL},
+    {0x8ed400668c0c28c8ULL, 0x825ecc24c873782fULL},
+    {0x728900802f0f32faULL, 0xa2f67f2dfa90563bULL},
+    {0x4f2b40a03ad2ffb9ULL, 0xcbb41ef979346bcaULL},
+    {0xe2f610c84987bfa8ULL, 0xfea126b7d78186bcULL},
+    {0x0dd9ca7d2df4d7c9ULL, 0x9f24b832e6b0f436ULL},
+    {0x91503d1c79720dbbULL, 0xc6ede63fa05d3143ULL},
+    {0x75a44c6397ce912aULL, 0xf8a95fcf88747d94ULL},
+    {0xc986afbe3ee11abaULL, 0x9b69dbe1b548ce7cULL},
+    {0xfbe85badce996168ULL, 0xc24452da229b021bULL},
+    {0xfae27299423fb9c3ULL, 0xf2d56790ab41c2a2ULL},
+    {0xdccd879fc967d41aULL, 0x97c560ba6b0919a5ULL},
+    {0x5400e987bbc1c920ULL, 0xbdb6b8e905cb600fULL},
+    {0x290123e9aab23b68ULL, 0xed246723473e3813ULL},
+    {0xf9a0b6720aaf6521ULL, 0x9436c0760c86e30bULL},
+    {0xf808e40e8d5b3e69ULL, 0xb94470938fa89bceULL},
+    {0xb60b1d1230b20e04ULL, 0xe7958cb87392c2c2ULL},
+    {0xb1c6f22b5e6f48c2ULL, 0x90bd77f3483bb9b9ULL},
+    {0x1e38aeb6360b1af3ULL, 0xb4ecd5f01a4aa828ULL},
+    {0x25c6da63c38de1b0ULL, 0xe2280b6c20dd5232ULL},
+    {0x579c487e5a38ad0eULL, 0x8d590723948a535fULL},
+    {0x2d835a9df0c6d851ULL, 0xb0af48ec79ace837ULL},
+    {0xf8e431456cf88e65ULL, 0xdcdb1b2798182244ULL},
+    {0x1b8e9ecb641b58ffULL, 0x8a08f0f8bf0f156bULL},
+    {0xe272467e3d222f3fULL, 0xac8b2d36eed2dac5ULL},
+    {0x5b0ed81dcc6abb0fULL, 0xd7adf884aa879177ULL},
+    {0x98e947129fc2b4e9ULL, 0x86ccbb52ea94baeaULL},
+    {0x3f2398d747b36224ULL, 0xa87fea27a539e9a5ULL},
+    {0x8eec7f0d19a03aadULL, 0xd29fe4b18e88640eULL},
+    {0x1953cf68300424acULL, 0x83a3eeeef9153e89ULL},
+    {0x5fa8c3423c052dd7ULL, 0xa48ceaaab75a8e2bULL},
+    {0x3792f412cb06794dULL, 0xcdb02555653131b6ULL},
+    {0xe2bbd88bbee40bd0ULL, 0x808e17555f3ebf11ULL},
+    {0x5b6aceaeae9d0ec4ULL, 0xa0b19d2ab70e6ed6ULL},
+    {0xf245825a5a445275ULL, 0xc8de047564d20a8bULL},
+    {0xeed6e2f0f0d56712ULL, 0xfb158592be068d2eULL},
+    {0x55464dd69685606bULL, 0x9ced737bb6c4183dULL},
+    {0xaa97e14c3c26b886ULL, 0xc428d05aa4751e4cULL},
+    {0xd53dd99f4b3066a8ULL, 0xf53304714d9265dfULL},
+    {0xe546a8038efe4029ULL, 0x993fe2c6d07b7fabULL},
+    {0xde98520472bdd033ULL, 0xbf8fdb78849a5f96ULL},
+    {0x963e66858f6d4440ULL, 0xef73d256a5c0f77cULL},
+    {0xdde7001379a44aa8ULL, 0x95a8637627989aadULL},
+    {0x5560c018580d5d52ULL, 0xbb127c53b17ec159ULL},
+    {0xaab8f01e6e10b4a6ULL, 0xe9d71b689dde71afULL},
+    {0xcab3961304ca70e8ULL, 0x9226712162ab070dULL},
+    {0x3d607b97c5fd0d22ULL, 0xb6b00d69bb55c8d1ULL},
+    {0x8cb89a7db77c506aULL, 0xe45c10c42a2b3b05ULL},
+    {0x77f3608e92adb242ULL, 0x8eb98a7a9a5b04e3ULL},
+    {0x55f038b237591ed3ULL, 0xb267ed1940f1c61cULL},
+    {0x6b6c46dec52f6688ULL, 0xdf01e85f912e37a3ULL},
+    {0x2323ac4b3b3da015ULL, 0x8b61313bbabce2c6ULL},
+    {0xabec975e0a0d081aULL, 0xae397d8aa96c1b77ULL},
+    {0x96e7bd358c904a21ULL, 0xd9c7dced53c72255ULL},
+    {0x7e50d64177da2e54ULL, 0x881cea14545c7575ULL},
+    {0xdde50bd1d5d0b9e9ULL, 0xaa242499697392d2ULL},
+    {0x955e4ec64b44e864ULL, 0xd4ad2dbfc3d07787ULL},
+    {0xbd5af13bef0b113eULL, 0x84ec3c97da624ab4ULL},
+    {0xecb1ad8aeacdd58eULL, 0xa6274bbdd0fadd61ULL},
+    {0x67de18eda5814af2ULL, 0xcfb11ead453994baULL},
+    {0x80eacf948770ced7ULL, 0x81ceb32c4b43fcf4ULL},
+    {0xa1258379a94d028dULL, 0xa2425ff75e14fc31ULL},
+    {0x096ee45813a04330ULL, 0xcad2f7f5359a3b3eULL},
+    {0x8bca9d6e188853fcULL, 0xfd87b5f28300ca0dULL},
+    {0x775ea264cf55347dULL, 0x9e74d1b791e07e48ULL},
+    {0x95364afe032a819dULL, 0xc612062576589ddaULL},
+    {0x3a83ddbd83f52204ULL, 0xf79687aed3eec551ULL},
+    {0xc4926a9672793542ULL, 0x9abe14cd44753b52ULL},
+    {0x75b7053c0f178293ULL, 0xc16d9a0095928a27ULL},
+    {0x5324c68b12dd6338ULL, 0xf1c90080baf72cb1ULL},
+    {0xd3f6fc16ebca5e03ULL, 0x971da05074da7beeULL},
+    {0x88f4bb1ca6bcf584ULL, 0xbce5086492111aeaULL},
+    {0x2b31e9e3d06c32e5ULL, 0xec1e4a7db69561a5ULL},
+    {0x3aff322e62439fcfULL, 0x9392ee8e921d5d07ULL},
+    {0x09befeb9fad487c2ULL, 0xb877aa3236a4b449ULL},
+    {0x4c2ebe687989a9b3ULL, 0xe69594bec44de15bULL},
+    {0x0f9d37014bf60a10ULL, 0x901d7cf73ab0acd9ULL},
+    {0x538484c19ef38c94ULL, 0xb424dc35095cd80fULL},
+    {0x2865a5f206b06fb9ULL, 0xe12e13424bb40e13ULL},
+    {0xf93f87b7442e45d3ULL, 0x8cbccc096f5088cbULL},
+    {0xf78f69a51539d748ULL, 0xafebff0bcb24aafeULL},
+    {0xb573440e5a884d1bULL, 0xdbe6fecebdedd5beULL},
+    {0x31680a88f8953030ULL, 0x89705f4136b4a597ULL},
+    {0xfdc20d2b36ba7c3dULL, 0xabcc77118461cefcULL},
+    {0x3d32907604691b4cULL, 0xd6bf94d5e57a42bcULL},
+    {0xa63f9a49c2c1b10fULL, 0x8637bd05af6c69b5ULL},
+    {0x0fcf80dc33721d53ULL, 0xa7c5ac471b478423ULL},
+    {0xd3c36113404ea4a8ULL, 0xd1b71758e219652bULL},
+    {0x645a1cac083126e9ULL, 0x83126e978d4fdf3bULL},
+    {0x3d70a3d70a3d70a3ULL, 0xa3d70a3d70a3d70aULL},
+    {0xccccccccccccccccULL, 0xccccccccccccccccULL},
+    {0x0000000000000000ULL, 0x8000000000000000ULL},
+    {0x0000000000000000ULL, 0xa000000000000000ULL},
+    {0x0000000000000000ULL, 0xc800000000000000ULL},
+    {0x0000000000000000ULL, 0xfa00000000000000ULL},
+    {0x0000000000000000ULL, 0x9c40000000000000ULL},
+    {0x0000000000000000ULL, 0xc350000000000000ULL},
+    {0x0000000000000000ULL, 0xf424000000000000ULL},
+    {0x0000000000000000ULL, 0x9896800000000000ULL},
+    {0x0000000000000000ULL, 0xbebc200000000000ULL},
+    {0x0000000000000000ULL, 0xee6b280000000000ULL},
+    {0x0000000000000000ULL, 0x9502f90000000000ULL},
+    {0x0000000000000000ULL, 0xba43b74000000000ULL},
+    {0x0000000000000000ULL, 0xe8d4a51000000000ULL},
+    {0x0000000000000000ULL, 0x9184e72a00000000ULL},
+    {0x0000000000000000ULL, 0xb5e620f480000000ULL},
+    {0x0000000000000000ULL, 0xe35fa931a0000000ULL},
+    {0x0000000000000000ULL, 0x8e1bc9bf04000000ULL},
+    {0x0000000000000000ULL, 0xb1a2bc2ec5000000ULL},
+    {0x0000000000000000ULL, 0xde0b6b3a76400000ULL},
+    {0x0000000000000000ULL, 0x8ac7230489e80000ULL},
+    {0x0000000000000000ULL, 0xad78ebc5ac620000ULL},
+    {0x0000000000000000ULL, 0xd8d726b7177a8000ULL},
+    {0x0000000000000000ULL, 0x878678326eac9000ULL},
+    {0x0000000000000000ULL, 0xa968163f0a57b400ULL},
+    {0x0000000000000000ULL, 0xd3c21bcecceda100ULL},
+    {0x0000000000000000ULL, 0x84595161401484a0ULL},
+    {0x0000000000000000ULL, 0xa56fa5b99019a5c8ULL},
+    {0x0000000000000000ULL, 0xcecb8f27f4200f3aULL},
+    {0x4000000000000000ULL, 0x813f3978f8940984ULL},
+    {0x5000000000000000ULL, 0xa18f07d736b90be5ULL},
+    {0xa400000000000000ULL, 0xc9f2c9cd04674edeULL},
+    {0x4d00000000000000ULL, 0xfc6f7c4045812296ULL},
+    {0xf020000000000000ULL, 0x9dc5ada82b70b59dULL},
+    {0x6c28000000000000ULL, 0xc5371912364ce305ULL},
+    {0xc732000000000000ULL, 0xf684df56c3e01bc6ULL},
+    {0x3c7f400000000000ULL, 0x9a130b963a6c115cULL},
+    {0x4b9f100000000000ULL, 0xc097ce7bc90715b3ULL},
+    {0x1e86d40000000000ULL, 0xf0bdc21abb48db20ULL},
+    {0x1314448000000000ULL, 0x96769950b50d88f4ULL},
+    {0x17d955a000000000ULL, 0xbc143fa4e250eb31ULL},
+    {0x5dcfab0800000000ULL, 0xeb194f8e1ae525fdULL},
+    {0x5aa1cae500000000ULL, 0x92efd1b8d0cf37beULL},
+    {0xf14a3d9e40000000ULL, 0xb7abc627050305adULL},
+    {0x6d9ccd05d0000000ULL, 0xe596b7b0c643c719ULL},
+    {0xe4820023a2000000ULL, 0x8f7e32ce7bea5c6fULL},
+    {0xdda2802c8a800000ULL, 0xb35dbf821ae4f38bULL},
+    {0xd50b2037ad200000ULL, 0xe0352f62a19e306eULL},
+    {0x4526f422cc340000ULL, 0x8c213d9da502de45ULL},
+    {0x9670b12b7f410000ULL, 0xaf298d050e4395d6ULL},
+    {0x3c0cdd765f114000ULL, 0xdaf3f04651d47b4cULL},
+    {0xa5880a69fb6ac800ULL, 0x88d8762bf324cd0fULL},
+    {0x8eea0d047a457a00ULL, 0xab0e93b6efee0053ULL},
+    {0x72a4904598d6d880ULL, 0xd5d238a4abe98068ULL},
+    {0x47a6da2b7f864750ULL, 0x85a36366eb71f041ULL},
+    {0x999090b65f67d924ULL, 0xa70c3c40a64e6c51ULL},
+    {0xfff4b4e3f741cf6dULL, 0xd0cf4b50cfe20765ULL},
+    {0xbff8f10e7a8921a4ULL, 0x82818f1281ed449fULL},
+    {0xaff72d52192b6a0dULL, 0xa321f2d7226895c7ULL},
+    {0x9bf4f8a69f764490ULL, 0xcbea6f8ceb02bb39ULL},
+    {0x02f236d04753d5b4ULL, 0xfee50b7025c36a08ULL},
+    {0x01d762422c946590ULL, 0x9f4f2726179a2245ULL},
+    {0x424d3ad2b7b97ef5ULL, 0xc722f0ef9d80aad6ULL},
+    {0xd2e0898765a7deb2ULL, 0xf8ebad2b84e0d58bULL},
+    {0x63cc55f49f88eb2fULL, 0x9b934c3b330c8577ULL},
+    {0x3cbf6b71c76b25fbULL, 0xc2781f49ffcfa6d5ULL},
+    {0x8bef464e3945ef7aULL, 0xf316271c7fc3908aULL},
+    {0x97758bf0e3cbb5acULL, 0x97edd871cfda3a56ULL},
+    {0x3d52eeed1cbea317ULL, 0xbde94e8e43d0c8ecULL},
+    {0x4ca7aaa863ee4bddULL, 0xed63a231d4c4fb27ULL},
+    {0x8fe8caa93e74ef6aULL, 0x945e455f24fb1cf8ULL},
+    {0xb3e2fd538e122b44ULL, 0xb975d6b6ee39e436ULL},
+    {0x60dbbca87196b616ULL, 0xe7d34c64a9c85d44ULL},
+    {0xbc8955e946fe31cdULL, 0x90e40fbeea1d3a4aULL},
+    {0x6babab6398bdbe41ULL, 0xb51d13aea4a488ddULL},
+    {0xc696963c7eed2dd1ULL, 0xe264589a4dcdab14ULL},
+    {0xfc1e1de5cf543ca2ULL, 0x8d7eb76070a08aecULL},
+    {0x3b25a55f43294bcbULL, 0xb0de65388cc8ada8ULL},
+    {0x49ef0eb713f39ebeULL, 0xdd15fe86affad912ULL},
+    {0x6e3569326c784337ULL, 0x8a2dbf142dfcc7abULL},
+    {0x49c2c37f07965404ULL, 0xacb92ed9397bf996ULL},
+    {0xdc33745ec97be906ULL, 0xd7e77a8f87daf7fbULL},
+    {0x69a028bb3ded71a3ULL, 0x86f0ac99b4e8dafdULL},
+    {0xc40832ea0d68ce0cULL, 0xa8acd7c0222311bcULL},
+    {0xf50a3fa490c30190ULL, 0xd2d80db02aabd62bULL},
+    {0x792667c6da79e0faULL, 0x83c7088e1aab65dbULL},
+    {0x577001b891185938ULL, 0xa4b8cab1a1563f52ULL},
+    {0xed4c0226b55e6f86ULL, 0xcde6fd5e09abcf26ULL},
+    {0x544f8158315b05b4ULL, 0x80b05e5ac60b6178ULL},
+    {0x696361ae3db1c721ULL, 0xa0dc75f1778e39d6ULL},
+    {0x03bc3a19cd1e38e9ULL, 0xc913936dd571c84cULL},
+    {0x04ab48a04065c723ULL, 0xfb5878494ace3a5fULL},
+    {0x62eb0d64283f9c76ULL, 0x9d174b2dcec0e47bULL},
+    {0x3ba5d0bd324f8394ULL, 0xc45d1df942711d9aULL},
+    {0xca8f44ec7ee36479ULL, 0xf5746577930d6500ULL},
+    {0x7e998b13cf4e1ecbULL, 0x9968bf6abbe85f20ULL},
+    {0x9e3fedd8c321a67eULL, 0xbfc2ef456ae276e8ULL},
+    {0xc5cfe94ef3ea101eULL, 0xefb3ab16c59b14a2ULL},
+    {0xbba1f1d158724a12ULL, 0x95d04aee3b80ece5ULL},
+    {0x2a8a6e45ae8edc97ULL, 0xbb445da9ca61281fULL},
+    {0xf52d09d71a3293bdULL, 0xea1575143cf97226ULL},
+    {0x593c2626705f9c56ULL, 0x924d692ca61be758ULL},
+    {0x6f8b2fb00c77836cULL, 0xb6e0c377cfa2e12eULL},
+    {0x0b6dfb9c0f956447ULL, 0xe498f455c38b997aULL},
+    {0x4724bd4189bd5eacULL, 0x8edf98b59a373fecULL},
+    {0x58edec91ec2cb657ULL, 0xb2977ee300c50fe7ULL},
+    {0x2f2967b66737e3edULL, 0xdf3d5e9bc0f653e1ULL},
+    {0xbd79e0d20082ee74ULL, 0x8b865b215899f46cULL},
+    {0xecd8590680a3aa11ULL, 0xae67f1e9aec07187ULL},
+    {0xe80e6f4820cc9495ULL, 0xda01ee641a708de9ULL},
+    {0x3109058d147fdcddULL, 0x884134fe908658b2ULL},
+    {0xbd4b46f0599fd415ULL, 0xaa51823e34a7eedeULL},
+    {0x6c9e18ac7007c91aULL, 0xd4e5e2cdc1d1ea96ULL},
+    {0x03e2cf6bc604ddb0ULL, 0x850fadc09923329eULL},
+    {0x84db8346b786151cULL, 0xa6539930bf6bff45ULL},
+    {0xe612641865679a63ULL, 0xcfe87f7cef46ff16ULL},
+    {0x4fcb7e8f3f60c07eULL, 0x81f14fae158c5f6eULL},
+    {0xe3be5e330f38f09dULL, 0xa26da3999aef7749ULL},
+    {0x5cadf5bfd3072cc5ULL, 0xcb090c8001ab551cULL},
+    {0x73d9732fc7c8f7f6ULL, 0xfdcb4fa002162a63ULL},
+    {0x2867e7fddcdd9afaULL, 0x9e9f11c4014dda7eULL},
+    {0xb281e1fd541501b8ULL, 0xc646d63501a1511dULL},
+    {0x1f225a7ca91a4226ULL, 0xf7d88bc24209a565ULL},
+    {0x3375788de9b06958ULL, 0x9ae757596946075fULL},
+    {0x0052d6b1641c83aeULL, 0xc1a12d2fc3978937ULL},
+    {0xc0678c5dbd23a49aULL, 0xf209787bb47d6b84ULL},
+    {0xf840b7ba963646e0ULL, 0x9745eb4d50ce6332ULL},
+    {0xb650e5a93bc3d898ULL, 0xbd176620a501fbffULL},
+    {0xa3e51f138ab4cebeULL, 0xec5d3fa8ce427affULL},
+    {0xc66f336c36b10137ULL, 0x93ba47c980e98cdfULL},
+    {0xb80b0047445d4184ULL, 0xb8a8d9bbe123f017ULL},
+    {0xa60dc059157491e5ULL, 0xe6d3102ad96cec1dULL},
+    {0x87c89837ad68db2fULL, 0x9043ea1ac7e41392ULL},
+    {0x29babe4598c311fbULL, 0xb454e4a179dd1877ULL},
+    {0xf4296dd6fef3d67aULL, 0xe16a1dc9d8545e94ULL},
+    {0x1899e4a65f58660cULL, 0x8ce2529e2734bb1dULL},
+    {0x5ec05dcff72e7f8fULL, 0xb01ae745b101e9e4ULL},
+    {0x76707543f4fa1f73ULL, 0xdc21a1171d42645dULL},
+    {0x6a06494a791c53a8ULL, 0x899504ae72497ebaULL},
+    {0x0487db9d17636892ULL, 0xabfa45da0edbde69ULL},
+    {0x45a9d2845d3c42b6ULL, 0xd6f8d7509292d603ULL},
+    {0x0b8a2392ba45a9b2ULL, 0x865b86925b9bc5c2ULL},
+    {0x8e6cac7768d7141eULL, 0xa7f26836f282b732ULL},
+    {0x3207d795430cd926ULL, 0xd1ef0244af2364ffULL},
+    {0x7f44e6bd49e807b8ULL, 0x8335616aed761f1fULL},
+    {0x5f16206c9c6209a6ULL, 0xa402b9c5a8d3a6e7ULL},
+    {0x36dba887c37a8c0fULL, 0xcd036837130890a1ULL},
+    {0xc2494954da2c9789ULL, 0x802221226be55a64ULL},
+    {0xf2db9baa10b7bd6cULL, 0xa02aa96b06deb0fdULL},
+    {0x6f92829494e5acc7ULL, 0xc83553c5c8965d3dULL},
+    {0xcb772339ba1f17f9ULL, 0xfa42a8b73abbf48cULL},
+    {0xff2a760414536efbULL, 0x9c69a97284b578d7ULL},
+    {0xfef5138519684abaULL, 0xc38413cf25e2d70dULL},
+    {0x7eb258665fc25d69ULL, 0xf46518c2ef5b8cd1ULL},
+    {0xef2f773ffbd97a61ULL, 0x98bf2f79d5993802ULL},
+    {0xaafb550ffacfd8faULL, 0xbeeefb584aff8603ULL},
+    {0x95ba2a53f983cf38ULL, 0xeeaaba2e5dbf6784ULL},
+    {0xdd945a747bf26183ULL, 0x952ab45cfa97a0b2ULL},
+    {0x94f971119aeef9e4ULL, 0xba756174393d88dfULL},
+    {0x7a37cd5601aab85dULL, 0xe912b9d1478ceb17ULL},
+    {0xac62e055c10ab33aULL, 0x91abb422ccb812eeULL},
+    {0x577b986b314d6009ULL, 0xb616a12b7fe617aaULL},
+    {0xed5a7e85fda0b80bULL, 0xe39c49765fdf9d94ULL},
+    {0x14588f13be847307ULL, 0x8e41ade9fbebc27dULL},
+    {0x596eb2d8ae258fc8ULL, 0xb1d219647ae6b31cULL},
+    {0x6fca5f8ed9aef3bbULL, 0xde469fbd99a05fe3ULL},
+    {0x25de7bb9480d5854ULL, 0x8aec23d680043beeULL},
+    {0xaf561aa79a10ae6aULL, 0xada72ccc20054ae9ULL},
+    {0x1b2ba1518094da04ULL, 0xd910f7ff28069da4ULL},
+    {0x90fb44d2f05d0842ULL, 0x87aa9aff79042286ULL},
+    {0x353a1607ac744a53ULL, 0xa99541bf57452b28ULL},
+    {0x42889b8997915ce8ULL, 0xd3fa922f2d1675f2ULL},
+    {0x69956135febada11ULL, 0x847c9b5d7c2e09b7ULL},
+    {0x43fab9837e699095ULL, 0xa59bc234db398c25ULL},
+    {0x94f967e45e03f4bbULL, 0xcf02b2c21207ef2eULL},
+    {0x1d1be0eebac278f5ULL, 0x8161afb94b44f57dULL},
+    {0x6462d92a69731732ULL, 0xa1ba1ba79e1632dcULL},
+    {0x7d7b8f7503cfdcfeULL, 0xca28a291859bbf93ULL},
+    {0x5cda735244c3d43eULL, 0xfcb2cb35e702af78ULL},
+    {0x3a0888136afa64a7ULL, 0x9defbf01b061adabULL},
+    {0x088aaa1845b8fdd0ULL, 0xc56baec21c7a1916ULL},
+    {0x8aad549e57273d45ULL, 0xf6c69a72a3989f5bULL},
+    {0x36ac54e2f678864bULL, 0x9a3c2087a63f6399ULL},
+    {0x84576a1bb416a7ddULL, 0xc0cb28a98fcf3c7fULL},
+    {0x656d44a2a11c51d5ULL, 0xf0fdf2d3f3c30b9fULL},
+    {0x9f644ae5a4b1b325ULL, 0x969eb7c47859e743ULL},
+    {0x873d5d9f0dde1feeULL, 0xbc4665b596706114ULL},
+    {0xa90cb506d155a7eaULL, 0xeb57ff22fc0c7959ULL},
+    {0x09a7f12442d588f2ULL, 0x9316ff75dd87cbd8ULL},
+    {0x0c11ed6d538aeb2fULL, 0xb7dcbf5354e9beceULL},
+    {0x8f1668c8a86da5faULL, 0xe5d3ef282a242e81ULL},
+    {0xf96e017d694487bcULL, 0x8fa475791a569d10ULL},
+    {0x37c981dcc395a9acULL, 0xb38d92d760ec4455ULL},
+    {0x85bbe253f47b1417ULL, 0xe070f78d3927556aULL},
+    {0x93956d7478ccec8eULL, 0x8c469ab843b89562ULL},
+    {0x387ac8d1970027b2ULL, 0xaf58416654a6babbULL},
+    {0x06997b05fcc0319eULL, 0xdb2e51bfe9d0696aULL},
+    {0x441fece3bdf81f03ULL, 0x88fcf317f22241e2ULL},
+    {0xd527e81cad7626c3ULL, 0xab3c2fddeeaad25aULL},
+    {0x8a71e223d8d3b074ULL, 0xd60b3bd56a5586f1ULL},
+    {0xf6872d5667844e49ULL, 0x85c7056562757456ULL},
+    {0xb428f8ac016561dbULL, 0xa738c6bebb12d16cULL},
+    {0xe13336d701beba52ULL, 0xd106f86e69d785c7ULL},
+    {0xecc0024661173473ULL, 0x82a45b450226b39cULL},
+    {0x27f002d7f95d0190ULL, 0xa34d721642b06084ULL},
+    {0x31ec038df7b441f4ULL, 0xcc20ce9bd35c78a5ULL},
+    {0x7e67047175a15271ULL, 0xff290242c83396ceULL},
+    {0x0f0062c6e984d386ULL, 0x9f79a169bd203e41ULL},
+    {0x52c07b78a3e60868ULL, 0xc75809c42c684dd1ULL},
+    {0xa7709a56ccdf8a82ULL, 0xf92e0c3537826145ULL},
+    {0x88a66076400bb691ULL, 0x9bbcc7a142b17ccbULL},
+    {0x6acff893d00ea435ULL, 0xc2abf989935ddbfeULL},
+    {0x0583f6b8c4124d43ULL, 0xf356f7ebf83552feULL},
+    {0xc3727a337a8b704aULL, 0x98165af37b2153deULL},
+    {0x744f18c0592e4c5cULL, 0xbe1bf1b059e9a8d6ULL},
+    {0x1162def06f79df73ULL, 0xeda2ee1c7064130cULL},
+    {0x8addcb5645ac2ba8ULL, 0x9485d4d1c63e8be7ULL},
+    {0x6d953e2bd7173692ULL, 0xb9a74a0637ce2ee1ULL},
+    {0xc8fa8db6ccdd0437ULL, 0xe8111c87c5c1ba99ULL},
+    {0x1d9c9892400a22a2ULL, 0x910ab1d4db9914a0ULL},
+    {0x2503beb6d00cab4bULL, 0xb54d5e4a127f59c8ULL},
+    {0x2e44ae64840fd61dULL, 0xe2a0b5dc971f303aULL},
+    {0x5ceaecfed289e5d2ULL, 0x8da471a9de737e24ULL},
+    {0x7425a83e872c5f47ULL, 0xb10d8e1456105dadULL},
+    {0xd12f124e28f77719ULL, 0xdd50f1996b947518ULL},
+    {0x82bd6b70d99aaa6fULL, 0x8a5296ffe33cc92fULL},
+    {0x636cc64d1001550bULL, 0xace73cbfdc0bfb7bULL},
+    {0x3c47f7e05401aa4eULL, 0xd8210befd30efa5aULL},
+    {0x65acfaec34810a71ULL, 0x8714a775e3e95c78ULL},
+    {0x7f1839a741a14d0dULL, 0xa8d9d1535ce3b396ULL},
+    {0x1ede48111209a050ULL, 0xd31045a8341ca07cULL},
+    {0x934aed0aab460432ULL, 0x83ea2b892091e44dULL},
+    {0xf81da84d5617853fULL, 0xa4e4b66b68b65d60ULL},
+    {0x36251260ab9d668eULL, 0xce1de40642e3f4b9ULL},
+    {0xc1d72b7c6b426019ULL, 0x80d2ae83e9ce78f3ULL},
+    {0xb24cf65b8612f81fULL, 0xa1075a24e4421730ULL},
+    {0xdee033f26797b627ULL, 0xc94930ae1d529cfcULL},
+    {0x169840ef017da3b1ULL, 0xfb9b7cd9a4a7443cULL},
+    {0x8e1f289560ee864eULL, 0x9d412e0806e88aa5ULL},
+    {0xf1a6f2bab92a27e2ULL, 0xc491798a08a2ad4eULL},
+    {0xae10af696774b1dbULL, 0xf5b5d7ec8acb58a2ULL},
+    {0xacca6da1e0a8ef29ULL, 0x9991a6f3d6bf1765ULL},
+    {0x17fd090a58d32af3ULL, 0xbff610b0cc6edd3fULL},
+    {0xddfc4b4cef07f5b0ULL, 0xeff394dcff8a948eULL},
+    {0x4abdaf101564f98eULL, 0x95f83d0a1fb69cd9ULL},
+    {0x9d6d1ad41abe37f1ULL, 0xbb764c4ca7a4440fULL},
+    {0x84c86189216dc5edULL, 0xea53df5fd18d5513ULL},
+    {0x32fd3cf5b4e49bb4ULL, 0x92746b9be2f8552cULL},
+    {0x3fbc8c33221dc2a1ULL, 0xb7118682dbb66a77ULL},
+    {0x0fabaf3feaa5334aULL, 0xe4d5e82392a40515ULL},
+    {0x29cb4d87f2a7400eULL, 0x8f05b1163ba6832dULL},
+    {0x743e20e9ef511012ULL, 0xb2c71d5bca9023f8ULL},
+    {0x914da9246b255416ULL, 0xdf78e4b2bd342cf6ULL},
+    {0x1ad089b6c2f7548eULL, 0x8bab8eefb6409c1aULL},
+    {0xa184ac2473b529b1ULL, 0xae9672aba3d0c320ULL},
+    {0xc9e5d72d90a2741eULL, 0xda3c0f568cc4f3e8ULL},
+    {0x7e2fa67c7a658892ULL, 0x8865899617fb1871ULL},
+    {0xddbb901b98feeab7ULL, 0xaa7eebfb9df9de8dULL},
+    {0x552a74227f3ea565ULL, 0xd51ea6fa85785631ULL},
+    {0xd53a88958f87275fULL, 0x8533285c936b35deULL},
+    {0x8a892abaf368f137ULL, 0xa67ff273b8460356ULL},
+    {0x2d2b7569b0432d85ULL, 0xd01fef10a657842cULL},
+    {0x9c3b29620e29fc73ULL, 0x8213f56a67f6b29bULL},
+    {0x8349f3ba91b47b8fULL, 0xa298f2c501f45f42ULL},
+    {0x241c70a936219a73ULL, 0xcb3f2f7642717713ULL},
+    {0xed238cd383aa0110ULL, 0xfe0efb53d30dd4d7ULL},
+    {0xf4363804324a40aaULL, 0x9ec95d1463e8a506ULL},
+    {0xb143c6053edcd0d5ULL, 0xc67bb4597ce2ce48ULL},
+    {0xdd94b7868e94050aULL, 0xf81aa16fdc1b81daULL},
+    {0xca7cf2b4191c8326ULL, 0x9b10a4e5e9913128ULL},
+    {0xfd1c2f611f63a3f0ULL, 0xc1d4ce1f63f57d72ULL},
+    {0xbc633b39673c8cecULL, 0xf24a01a73cf2dccfULL},
+    {0xd5be0503e085d813ULL, 0x976e41088617ca01ULL},
+    {0x4b2d8644d8a74e18ULL, 0xbd49d14aa79dbc82ULL},
+    {0xddf8e7d60ed1219eULL, 0xec9c459d51852ba2ULL},
+    {0xcabb90e5c942b503ULL, 0x93e1ab8252f33b45ULL},
+    {0x3d6a751f3b936243ULL, 0xb8da1662e7b00a17ULL},
+    {0x0cc512670a783ad4ULL, 0xe7109bfba19c0c9dULL},
+    {0x27fb2b80668b24c5ULL, 0x906a617d450187e2ULL},
+    {0xb1f9f660802dedf6ULL, 0xb484f9dc9641e9daULL},
+    {0x5e7873f8a0396973ULL, 0xe1a63853bbd26451ULL},
+    {0xdb0b487b6423e1e8ULL, 0x8d07e33455637eb2ULL},
+    {0x91ce1a9a3d2cda62ULL, 0xb049dc016abc5e5fULL},
+    {0x7641a140cc7810fbULL, 0xdc5c5301c56b75f7ULL},
+    {0xa9e904c87fcb0a9dULL, 0x89b9b3e11b6329baULL},
+    {0x546345fa9fbdcd44ULL, 0xac2820d9623bf429ULL},
+    {0xa97c177947ad4095ULL, 0xd732290fbacaf133ULL},
+    {0x49ed8eabcccc485dULL, 0x867f59a9d4bed6c0ULL},
+    {0x5c68f256bfff5a74ULL, 0xa81f301449ee8c70ULL},
+    {0x73832eec6fff3111ULL, 0xd226fc195c6a2f8cULL},
+    {0xc831fd53c5ff7eabULL, 0x83585d8fd9c25db7ULL},
+    {0xba3e7ca8b77f5e55ULL, 0xa42e74f3d032f525ULL},
+    {0x28ce1bd2e55f35ebULL, 0xcd3a1230c43fb26fULL},
+    {0x7980d163cf5b81b3ULL, 0x80444b5e7aa7cf85ULL},
+    {0xd7e105bcc332621fULL, 0xa0555e361951c366ULL},
+    {0x8dd9472bf3fefaa7ULL, 0xc86ab5c39fa63440ULL},
+    {0xb14f98f6f0feb951ULL, 0xfa856334878fc150ULL},
+    {0x6ed1bf9a569f33d3ULL, 0x9c935e00d4b9d8d2ULL},
+    {0x0a862f80ec4700c8ULL, 0xc3b8358109e84f07ULL},
+    {0xcd27bb612758c0faULL, 0xf4a642e14c6262c8ULL},
+    {0x8038d51cb897789cULL, 0x98e7e9cccfbd7dbdULL},
+    {0xe0470a63e6bd56c3ULL, 0xbf21e44003acdd2cULL},
+    {0x1858ccfce06cac74ULL, 0xeeea5d5004981478ULL},
+    {0x0f37801e0c43ebc8ULL, 0x95527a5202df0ccbULL},
+    {0xd30560258f54e6baULL, 0xbaa718e68396cffdULL},
+    {0x47c6b82ef32a2069ULL, 0xe950df20247c83fdULL},
+    {0x4cdc331d57fa5441ULL, 0x91d28b7416cdd27eULL},
+    {0xe0133fe4adf8e952ULL, 0xb6472e511c81471dULL},
+    {0x58180fddd97723a6ULL, 0xe3d8f9e563a198e5ULL},
+    {0x570f09eaa7ea7648ULL, 0x8e679c2f5e44ff8fULL}
+};
+
+/* 64x64 -> 128 bit multiply. Returns the high half, stores the low half in lo. */
+static uint64_t umul128(uint64_t a, uint64_t b, uint64_t *lo) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128) a * b;
+    *lo = (uint64_t) r;
+    return (uint64_t)(r >> 64);
+#else
+    uint64_t al = a & 0xFFFFFFFFULL, ah = a >> 32;
+    uint64_t bl = b & 0xFFFFFFFFULL, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFULL) + (hl & 0xFFFFFFFFULL);
+    *lo = (mid << 32) | (ll & 0xFFFFFFFFULL);
+    return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/* Convert w * 10^exponent to a double. Returns 0 if the fast path can't
+ * decide. w must not be 0. */
+static int eisel_lemire(uint64_t w, int32_t exponent, int negative, double *out) {
+    if (exponent < SCAN_POW10_MIN || exponent > SCAN_POW10_MAX) return 0;
+    const uint64_t *p = scan_pow10[exponent - SCAN_POW10_MIN];
+
+    /* Normalize w so its top bit is set */
+    int lz = 0;
+    while (!(w & (1ULL << 63))) {
+        w <<= 1;
+        lz++;
+    }
+    /* floor(log2(10^exponent)) + 64 + 1023 - lz */
+    uint64_t exponent2 = (uint64_t)(((217706 * exponent) >> 16) + 64 + 1023 - lz);
+
+    /* Multiply by the top 64 bits of the power of ten, and by the bottom 64
+     * bits too if the truncated product could be off */
+    uint64_t lo;
+    uint64_t hi = umul128(w, p[1], &lo);
+    if ((hi & 0x1FF) == 0x1FF && lo + w < w) {
+        uint64_t lo2;
+        uint64_t hi2 = umul128(w, p[0], &lo2);
+        uint64_t mlo = lo + hi2;
+        uint64_t mhi = hi + (mlo < lo);
+        if ((mhi & 0x1FF) == 0x1FF && mlo + 1 == 0 && lo2 + w < w) return 0;
+        hi = mhi;
+        lo = mlo;
+    }
+
+    /* Shift to 54 bits */
+    uint64_t msb = hi >> 63;
+    uint64_t mantissa = hi >> (msb + 9);
+    exponent2 -= 1 ^ msb;
+
+    /* Possibly exactly halfway between two doubles */
+    if (lo == 0 && (hi & 0x1FF) == 0 && (mantissa & 3) == 1) return 0;
+
+    /* Round to 53 bits, ties to even */
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >> 53) {
+        mantissa >>= 1;
+        exponent2++;
+    }
+
+    /* Denormalized or out of range */
+    if (exponent2 - 1 >= 0x7FF - 1) return 0;
+
+    uint64_t bits = (exponent2 << 52) | (mantissa & 0xFFFFFFFFFFFFFULL);
+    if (negative) bits |= 1ULL << 63;
+    memcpy(out, &bits, sizeof(bits));
+    return 1;
 }
 
 /* Scan a real (double) from a string. If the string cannot be converted into
@@ -258,6 +1025,8 @@ int janet_scan_number_base(
     int seenpoint = 0;
     int foundexp = 0;
     int neg = 0;
+    int big = 0;
+    uint64_t w = 0;
     struct BigNat mant;
     bignat_zero(&mant);
 
@@ -338,7 +1107,16 @@ int janet_scan_number_base(
             int digit = digit_lookup[*str & 0x7F];
             if (*str > 127 || digit >= base) goto error;
             if (seenpoint) ex--;
-            bignat_muladd(&mant, base, digit);
+            /* Digits go into w until it would overflow, then into mant */
+            if (!big && w <= (UINT64_MAX - 35) / 36) {
+                w = w * base + digit;
+            } else {
+                if (!big) {
+                    bignat_set_u64(&mant, w);
+                    big = 1;
+                }
+                bignat_muladd(&mant, base, digit);
+            }
             seenadigit = 1;
         }
         str++;
@@ -381,6 +1159,15 @@ int janet_scan_number_base(
     if (!seenadigit)
         goto error;
 
+    if (!big) {
+        if (w == 0) {
+            *out = neg ? -0.0 : 0.0;
+            return 0;
+        }
+        if (base == 10 && eisel_lemire(w, ex, neg, out)) return 0;
+        bignat_set_u64(&mant, w);
+    }
+
     *out = convert(neg, &mant, base, ex);
     janet_free(mant.digits);
     return 0;
@@ -532,17 +1319,920 @@ int janet_scan_numeric(
 
 #endif
 
-void janet_buffer_dtostr(JanetBuffer *buffer, double x) {
-#define BUFSIZE 32
-    janet_buffer_extra(buffer, BUFSIZE);
-    int count = snprintf((char *) buffer->data + buffer->count, BUFSIZE, "%.17g", x);
-#undef BUFSIZE
-    /* fix locale issues with commas */
-    for (int i = 0; i < count; i++) {
-        char c = buffer->data[buffer->count + i];
-        if (c == ',') {
-            buffer->data[buffer->count + i] = '.';
+/*
+ * Printing doubles
+ *
+ * Doubles are printed with the fewest digits that read back as the same
+ * number, using the Ryu algorithm from "Ryu: Fast Float-to-String Conversion"
+ * by Ulf Adams. Of the shortest candidates, the one closest to the exact
+ * value is picked. Integers below 2^53 take a faster path. The layout
+ * matches printf's %.17g, so numbers with a decimal exponent from -4 to 16
+ * are printed without an exponent.
+ */
+
+/* 5^i as 125 bit fixed point numbers, for i from 0 to 325 */
+static const uint64_t dtoa_pow5[326][2] = {
+    {0ULL, 1152921504606846976ULL},
+    {0ULL, 1441151880758558720ULL},
+    {0ULL, 1801439850948198400ULL},
+    {0ULL, 2251799813685248000ULL},
+    {0ULL, 1407374883553280000ULL},
+    {0ULL, 1759218604441600000ULL},
+    {0ULL, 2199023255552000000ULL},
+    {0ULL, 1374389534720000000ULL},
+    {0ULL, 1717986918400000000ULL},
+    {0ULL, 2147483648000000000ULL},
+    {0ULL, 1342177280000000000ULL},
+    {0ULL, 1677721600000000000ULL},
+    {0ULL, 2097152000000000000ULL},
+    {0ULL, 1310720000000000000ULL},
+    {0ULL, 1638400000000000000ULL},
+    {0ULL, 2048000000000000000ULL},
+    {0ULL, 1280000000000000000ULL},
+    {0ULL, 1600000000000000000ULL},
+    {0ULL, 2000000000000000000ULL},
+    {0ULL, 1250000000000000000ULL},
+    {0ULL, 1562500000000000000ULL},
+    {0ULL, 1953125000000000000ULL},
+    {0ULL, 1220703125000000000ULL},
+    {0ULL, 1525878906250000000ULL},
+    {0ULL, 1907348632812500000ULL},
+    {0ULL, 1192092895507812500ULL},
+    {0ULL, 1490116119384765625ULL},
+    {4611686018427387904ULL, 1862645149230957031ULL},
+    {9799832789158199296ULL, 1164153218269348144ULL},
+    {12249790986447749120ULL, 1455191522836685180ULL},
+    {15312238733059686400ULL, 1818989403545856475ULL},
+    {14528612397897220096ULL, 2273736754432320594ULL},
+    {13692068767113150464ULL, 1421085471520200371ULL},
+    {12503399940464050176ULL, 1776356839400250464ULL},
+    {15629249925580062720ULL, 2220446049250313080ULL},
+    {9768281203487539200ULL, 1387778780781445675ULL},
+    {7598665485932036096ULL, 1734723475976807094ULL},
+    {274959820560269312ULL, 2168404344971008868ULL},
+    {9395221924704944128ULL, 1355252715606880542ULL},
+    {2520655369026404352ULL, 1694065894508600678ULL},
+    {12374191248137781248ULL, 2117582368135750847ULL},
+    {14651398557727195136ULL, 1323488980084844279ULL},
+    {13702562178731606016ULL, 1654361225106055349ULL},
+    {3293144668132343808ULL, 2067951531382569187ULL},
+    {18199116482078572544ULL, 1292469707114105741ULL},
+    {8913837547316051968ULL, 1615587133892632177ULL},
+    {15753982952572452864ULL, 2019483917365790221ULL},
+    {12152082354571476992ULL, 1262177448353618888ULL},
+    {15190102943214346240ULL, 1577721810442023610ULL},
+    {9764256642163156992ULL, 1972152263052529513ULL},
+    {17631875447420442880ULL, 1232595164407830945ULL},
+    {8204786253993389888ULL, 1540743955509788682ULL},
+    {1032610780636961552ULL, 1925929944387235853ULL},
+    {2951224747111794922ULL, 1203706215242022408ULL},
+    {3689030933889743652ULL, 1504632769052528010ULL},
+    {13834660704216955373ULL, 1880790961315660012ULL},
+    {17870034976990372916ULL, 1175494350822287507ULL},
+    {17725857702810578241ULL, 1469367938527859384ULL},
+    {3710578054803671186ULL, 1836709923159824231ULL},
+    {26536550077201078ULL, 2295887403949780289ULL},
+    {11545800389866720434ULL, 1434929627468612680ULL},
+    {14432250487333400542ULL, 1793662034335765850ULL},
+    {8816941072311974870ULL, 2242077542919707313ULL},
+    {17039803216263454053ULL, 1401298464324817070ULL},
+    {12076381983474541759ULL, 1751623080406021338ULL},
+    {5872105442488401391ULL, 2189528850507526673ULL},
+    {15199280947623720629ULL, 1368455531567204170ULL},
+    {9775729147674874978ULL, 1710569414459005213ULL},
+    {16831347453020981627ULL, 2138211768073756516ULL},
+    {1296220121283337709ULL, 1336382355046097823ULL},
+    {15455333206886335848ULL, 1670477943807622278ULL},
+    {10095794471753144002ULL, 2088097429759527848ULL},
+    {6309871544845715001ULL, 1305060893599704905ULL},
+    {12499025449484531656ULL, 1631326116999631131ULL},
+    {11012095793428276666ULL, 2039157646249538914ULL},
+    {11494245889320060820ULL, 1274473528905961821ULL},
+    {532749306367912313ULL, 1593091911132452277ULL},
+    {5277622651387278295ULL, 1991364888915565346ULL},
+    {7910200175544436838ULL, 1244603055572228341ULL},
+    {14499436237857933952ULL, 1555753819465285426ULL},
+    {8900923260467641632ULL, 1944692274331606783ULL},
+    {12480606065433357876ULL, 1215432671457254239ULL},
+    {10989071563364309441ULL, 1519290839321567799ULL},
+    {9124653435777998898ULL, 1899113549151959749ULL},
+    {8008751406574943263ULL, 1186945968219974843ULL},
+    {5399253239791291175ULL, 1483682460274968554ULL},
+    {15972438586593889776ULL, 1854603075343710692ULL},
+    {759402079766405302ULL, 1159126922089819183ULL},
+    {14784310654990170340ULL, 1448908652612273978ULL},
+    {9257016281882937117ULL, 1811135815765342473ULL},
+    {16182956370781059300ULL, 2263919769706678091ULL},
+    {7808504722524468110ULL, 1414949856066673807ULL},
+    {5148944884728197234ULL, 1768687320083342259ULL},
+    {1824495087482858639ULL, 2210859150104177824ULL},
+    {1140309429676786649ULL, 1381786968815111140ULL},
+    {1425386787095983311ULL, 1727233711018888925ULL},
+    {6393419502297367043ULL, 2159042138773611156ULL},
+    {13219259225790630210ULL, 1349401336733506972ULL},
+    {16524074032238287762ULL, 1686751670916883715ULL},
+    {16043406521870471799ULL, 2108439588646104644ULL},
+    {803757039314269066ULL, 1317774742903815403ULL},
+    {14839754354425000045ULL, 1647218428629769253ULL},
+    {4714634887749086344ULL, 2059023035787211567ULL},
+    {9864175832484260821ULL, 1286889397367007229ULL},
+    {16941905809032713930ULL, 1608611746708759036ULL},
+    {2730638187581340797ULL, 2010764683385948796ULL},
+    {10930020904093113806ULL, 1256727927116217997ULL},
+    {18274212148543780162ULL, 1570909908895272496ULL},
+    {4396021111970173586ULL, 1963637386119090621ULL},
+    {5053356204195052443ULL, 1227273366324431638ULL},
+    {15540067292098591362ULL, 1534091707905539547ULL},
+    {14813398096695851299ULL, 1917614634881924434ULL},
+    {13870059828862294966ULL, 1198509146801202771ULL},
+    {12725888767650480803ULL, 1498136433501503464ULL},
+    {15907360959563101004ULL, 1872670541876879330ULL},
+    {14553786618154326031ULL, 1170419088673049581ULL},
+    {4357175217410743827ULL, 1463023860841311977ULL},
+    {10058155040190817688ULL, 1828779826051639971ULL},
+    {7961007781811134206ULL, 2285974782564549964ULL},
+    {14199001900486734687ULL, 1428734239102843727ULL},
+    {13137066357181030455ULL, 1785917798878554659ULL},
+    {11809646928048900164ULL, 2232397248598193324ULL},
+    {16604401366885338411ULL, 1395248280373870827ULL},
+    {16143815690179285109ULL, 1744060350467338534ULL},
+    {10956397575869330579ULL, 2180075438084173168ULL},
+    {6847748484918331612ULL, 1362547148802608230ULL},
+    {17783057643002690323ULL, 1703183936003260287ULL},
+    {17617136035325974999ULL, 2128979920004075359ULL},
+    {17928239049719816230ULL, 1330612450002547099ULL},
+    {17798612793722382384ULL, 1663265562503183874ULL},
+    {13024893955298202172ULL, 2079081953128979843ULL},
+    {5834715712847682405ULL, 1299426220705612402ULL},
+    {16516766677914378815ULL, 1624282775882015502ULL},
+    {11422586310538197711ULL, 2030353469852519378ULL},
+    {11750802462513761473ULL, 1268970918657824611ULL},
+    {10076817059714813937ULL, 1586213648322280764ULL},
+    {12596021324643517422ULL, 1982767060402850955ULL},
+    {5566670318688504437ULL, 1239229412751781847ULL},
+    {2346651879933242642ULL, 1549036765939727309ULL},
+    {7545000868343941206ULL, 1936295957424659136ULL},
+    {4715625542714963254ULL, 1210184973390411960ULL},
+    {5894531928393704067ULL, 1512731216738014950ULL},
+    {16591536947346905892ULL, 1890914020922518687ULL},
+    {17287239619732898039ULL, 1181821263076574179ULL},
+    {16997363506238734644ULL, 1477276578845717724ULL},
+    {2799960309088866689ULL, 1846595723557147156ULL},
+    {10973347230035317489ULL, 1154122327223216972ULL},
+    {13716684037544146861ULL, 1442652909029021215ULL},
+    {12534169028502795672ULL, 1803316136286276519ULL},
+    {11056025267201106687ULL, 2254145170357845649ULL},
+    {18439230838069161439ULL, 1408840731473653530ULL},
+    {13825666510731675991ULL, 1761050914342066913ULL},
+    {3447025083132431277ULL, 2201313642927583642ULL},
+    {6766076695385157452ULL, 1375821026829739776ULL},
+    {8457595869231446815ULL, 1719776283537174720ULL},
+    {10571994836539308519ULL, 2149720354421468400ULL},
+    {6607496772837067824ULL, 1343575221513417750ULL},
+    {17482743002901110588ULL, 1679469026891772187ULL},
+    {17241742735199000331ULL, 2099336283614715234ULL},
+    {15387775227926763111ULL, 1312085177259197021ULL},
+    {5399660979626290177ULL, 1640106471573996277ULL},
+    {11361262242960250625ULL, 2050133089467495346ULL},
+    {11712474920277544544ULL, 1281333180917184591ULL},
+    {10028907631919542777ULL, 1601666476146480739ULL},
+    {7924448521472040567ULL, 2002083095183100924ULL},
+    {14176152362774801162ULL, 1251301934489438077ULL},
+    {3885132398186337741ULL, 1564127418111797597ULL},
+    {9468101516160310080ULL, 1955159272639746996ULL},
+    {15140935484454969608ULL, 1221974545399841872ULL},
+    {479425281859160394ULL, 1527468181749802341ULL},
+    {5210967620751338397ULL, 1909335227187252926ULL},
+    {17091912818251750210ULL, 1193334516992033078ULL},
+    {12141518985959911954ULL, 1491668146240041348ULL},
+    {15176898732449889943ULL, 1864585182800051685ULL},
+    {11791404716994875166ULL, 1165365739250032303ULL},
+    {10127569877816206054ULL, 1456707174062540379ULL},
+    {8047776328842869663ULL, 1820883967578175474ULL},
+    {836348374198811271ULL, 2276104959472719343ULL},
+    {7440246761515338900ULL, 1422565599670449589ULL},
+    {13911994470321561530ULL, 1778206999588061986ULL},
+    {8166621051047176104ULL, 2222758749485077483ULL},
+    {2798295147690791113ULL, 1389224218428173427ULL},
+    {17332926989895652603ULL, 1736530273035216783ULL},
+    {17054472718942177850ULL, 2170662841294020979ULL},
+    {8353202440125167204ULL, 1356664275808763112ULL},
+    {10441503050156459005ULL, 1695830344760953890ULL},
+    {3828506775840797949ULL, 2119787930951192363ULL},
+    {86973725686804766ULL, 1324867456844495227ULL},
+    {13943775212390669669ULL, 1656084321055619033ULL},
+    {3594660960206173375ULL, 2070105401319523792ULL},
+    {2246663100128858359ULL, 1293815875824702370ULL},
+    {12031700912015848757ULL, 1617269844780877962ULL},
+    {5816254103165035138ULL, 2021587305976097453ULL},
+    {5941001823691840913ULL, 1263492066235060908ULL},
+    {7426252279614801142ULL, 1579365082793826135ULL},
+    {4671129331091113523ULL, 1974206353492282669ULL},
+    {5225298841145639904ULL, 1233878970932676668ULL},
+    {6531623551432049880ULL, 1542348713665845835ULL},
+    {3552843420862674446ULL, 1927935892082307294ULL},
+    {16055585193321335241ULL, 1204959932551442058ULL},
+    {10846109454796893243ULL, 1506199915689302573ULL},
+    {18169322836923504458ULL, 1882749894611628216ULL},
+    {11355826773077190286ULL, 1176718684132267635ULL},
+    {9583097447919099954ULL, 1470898355165334544ULL},
+    {11978871809898874942ULL, 1838622943956668180ULL},
+    {14973589762373593678ULL, 2298278679945835225ULL},
+    {2440964573842414192ULL, 1436424174966147016ULL},
+    {3051205717303017741ULL, 1795530218707683770ULL},
+    {13037379183483547984ULL, 2244412773384604712ULL},
+    {8148361989677217490ULL, 1402757983365377945ULL},
+    {14797138505523909766ULL, 1753447479206722431ULL},
+    {13884737113477499304ULL, 2191809349008403039ULL},
+    {15595489723564518921ULL, 1369880843130251899ULL},
+    {14882676136028260747ULL, 1712351053912814874ULL},
+    {9379973133180550126ULL, 2140438817391018593ULL},
+    {17391698254306313589ULL, 1337774260869386620ULL},
+    {3292878744173340370ULL, 1672217826086733276ULL},
+    {4116098430216675462ULL, 2090272282608416595ULL},
+    {266718509671728212ULL, 1306420176630260372ULL},
+    {333398137089660265ULL, 1633025220787825465ULL},
+    {5028433689789463235ULL, 2041281525984781831ULL},
+    {10060300083759496378ULL, 1275800953740488644ULL},
+    {12575375104699370472ULL, 1594751192175610805ULL},
+    {1884160825592049379ULL, 1993438990219513507ULL},
+    {17318501580490888525ULL, 1245899368887195941ULL},
+    {7813068920331446945ULL, 1557374211108994927ULL},
+    {5154650131986920777ULL, 1946717763886243659ULL},
+    {915813323278131534ULL, 1216698602428902287ULL},
+    {14979824709379828129ULL, 1520873253036127858ULL},
+    {9501408849870009354ULL, 1901091566295159823ULL},
+    {12855909558809837702ULL, 1188182228934474889ULL},
+    {2234828893230133415ULL, 1485227786168093612ULL},
+    {2793536116537666769ULL, 1856534732710117015ULL},
+    {8663489100477123587ULL, 1160334207943823134ULL},
+    {1605989338741628675ULL, 1450417759929778918ULL},
+    {11230858710281811652ULL, 1813022199912223647ULL},
+    {9426887369424876662ULL, 2266277749890279559ULL},
+    {12809333633531629769ULL, 1416423593681424724ULL},
+    {16011667041914537212ULL, 1770529492101780905ULL},
+    {6179525747111007803ULL, 2213161865127226132ULL},
+    {13085575628799155685ULL, 1383226165704516332ULL},
+    {16356969535998944606ULL, 1729032707130645415ULL},
+    {15834525901571292854ULL, 2161290883913306769ULL},
+    {2979049660840976177ULL, 1350806802445816731ULL},
+    {17558870131333383934ULL, 1688508503057270913ULL},
+    {8113529608884566205ULL, 2110635628821588642ULL},
+    {9682642023980241782ULL, 1319147268013492901ULL},
+    {16714988548402690132ULL, 1648934085016866126ULL},
+    {11670363648648586857ULL, 2061167606271082658ULL},
+    {11905663298832754689ULL, 1288229753919426661ULL},
+    {1047021068258779650ULL, 1610287192399283327ULL},
+    {15143834390605638274ULL, 2012858990499104158ULL},
+    {4853210475701136017ULL, 1258036869061940099ULL},
+    {1454827076199032118ULL, 1572546086327425124ULL},
+    {1818533845248790147ULL, 1965682607909281405ULL},
+    {3442426662494187794ULL, 1228551629943300878ULL},
+    {13526405364972510550ULL, 1535689537429126097ULL},
+    {3072948650933474476ULL, 1919611921786407622ULL},
+    {15755650962115585259ULL, 1199757451116504763ULL},
+    {15082877684217093670ULL, 1499696813895630954ULL},
+    {9630225068416591280ULL, 1874621017369538693ULL},
+    {8324733676974063502ULL, 1171638135855961683ULL},
+    {5794231077790191473ULL, 1464547669819952104ULL},
+    {7242788847237739342ULL, 1830684587274940130ULL},
+    {18276858095901949986ULL, 2288355734093675162ULL},
+    {16034722328366106645ULL, 1430222333808546976ULL},
+    {1596658836748081690ULL, 1787777917260683721ULL},
+    {6607509564362490017ULL, 2234722396575854651ULL},
+    {1823850468512862308ULL, 1396701497859909157ULL},
+    {6891499104068465790ULL, 1745876872324886446ULL},
+    {17837745916940358045ULL, 2182346090406108057ULL},
+    {4231062170446641922ULL, 1363966306503817536ULL},
+    {5288827713058302403ULL, 1704957883129771920ULL},
+    {6611034641322878003ULL, 2131197353912214900ULL},
+    {13355268687681574560ULL, 1331998346195134312ULL},
+    {16694085859601968200ULL, 1664997932743917890ULL},
+    {11644235287647684442ULL, 2081247415929897363ULL},
+    {4971804045566108824ULL, 1300779634956185852ULL},
+    {6214755056957636030ULL, 1625974543695232315ULL},
+    {3156757802769657134ULL, 2032468179619040394ULL},
+    {6584659645158423613ULL, 1270292612261900246ULL},
+    {17454196593302805324ULL, 1587865765327375307ULL},
+    {17206059723201118751ULL, 1984832206659219134ULL},
+    {6142101308573311315ULL, 1240520129162011959ULL},
+    {3065940617289251240ULL, 1550650161452514949ULL},
+    {8444111790038951954ULL, 1938312701815643686ULL},
+    {665883850346957067ULL, 1211445438634777304ULL},
+    {832354812933696334ULL, 1514306798293471630ULL},
+    {10263815553021896226ULL, 1892883497866839537ULL},
+    {17944099766707154901ULL, 1183052186166774710ULL},
+    {13206752671529167818ULL, 1478815232708468388ULL},
+    {16508440839411459773ULL, 1848519040885585485ULL},
+    {12623618533845856310ULL, 1155324400553490928ULL},
+    {15779523167307320387ULL, 1444155500691863660ULL},
+    {1277659885424598868ULL, 1805194375864829576ULL},
+    {1597074856780748586ULL, 2256492969831036970ULL},
+    {5609857803915355770ULL, 1410308106144398106ULL},
+    {16235694291748970521ULL, 1762885132680497632ULL},
+    {1847873790976661535ULL, 2203606415850622041ULL},
+    {12684136165428883219ULL, 1377254009906638775ULL},
+    {11243484188358716120ULL, 1721567512383298469ULL},
+    {219297180166231438ULL, 2151959390479123087ULL},
+    {7054589765244976505ULL, 1344974619049451929ULL},
+    {13429923224983608535ULL, 1681218273811814911ULL},
+    {12175718012802122765ULL, 2101522842264768639ULL},
+    {14527352785642408584ULL, 1313451776415480399ULL},
+    {13547504963625622826ULL, 1641814720519350499ULL},
+    {12322695186104640628ULL, 2052268400649188124ULL},
+    {16925056528170176201ULL, 1282667750405742577ULL},
+    {7321262604930556539ULL, 1603334688007178222ULL},
+    {18374950293017971482ULL, 2004168360008972777ULL},
+    {4566814905495150320ULL, 1252605225005607986ULL},
+    {14931890668723713708ULL, 1565756531257009982ULL},
+    {9441491299049866327ULL, 1957195664071262478ULL},
+    {1289246043478778550ULL, 1223247290044539049ULL},
+    {6223243572775861092ULL, 1529059112555673811ULL},
+    {3167368447542438461ULL, 1911323890694592264ULL},
+    {1979605279714024038ULL, 1194577431684120165ULL},
+    {7086192618069917952ULL, 1493221789605150206ULL},
+    {18081112809442173248ULL, 1866527237006437757ULL},
+    {13606538515115052232ULL, 1166579523129023598ULL},
+    {7784801107039039482ULL, 1458224403911279498ULL},
+    {507629346944023544ULL, 1822780504889099373ULL},
+    {5246222702107417334ULL, 2278475631111374216ULL},
+    {3278889188817135834ULL, 1424047269444608885ULL},
+    {8710297504448807696ULL, 1780059086805761106ULL}
+};
+/* Inverses of 5^i as 125 bit fixed point numbers, for i from 0 to 341 */
+static const uint64_t dtoa_pow5_inv[342][2] = {
+    {1ULL, 2305843009213693952ULL},
+    {11068046444225730970ULL, 1844674407370955161ULL},
+    {5165088340638674453ULL, 1475739525896764129ULL},
+    {7821419487252849886ULL, 1180591620717411303ULL},
+    {8824922364862649494ULL, 1888946593147858085ULL},
+    {7059937891890119595ULL, 1511157274518286468ULL},
+    {13026647942995916322ULL, 1208925819614629174ULL},
+    {9774590264567735146ULL, 1934281311383406679ULL},
+    {11509021026396098440ULL, 1547425049106725343ULL},
+    {16585914450600699399ULL, 1237940039285380274ULL},
+    {15469416676735388068ULL, 1980704062856608439ULL},
+    {16064882156130220778ULL, 1584563250285286751ULL},
+    {9162556910162266299ULL, 1267650600228229401ULL},
+    {7281393426775805432ULL, 2028240960365167042ULL},
+    {16893161185646375315ULL, 1622592768292133633ULL},
+    {2446482504291369283ULL, 1298074214633706907ULL},
+    {7603720821608101175ULL, 2076918743413931051ULL},
+    {2393627842544570617ULL, 1661534994731144841ULL},
+    {16672297533003297786ULL, 1329227995784915872ULL},
+    {11918280793837635165ULL, 2126764793255865396ULL},
+    {5845275820328197809ULL, 1701411834604692317ULL},
+    {15744267100488289217ULL, 1361129467683753853ULL},
+    {3054734472329800808ULL, 2177807148294006166ULL},
+    {17201182836831481939ULL, 1742245718635204932ULL},
+    {6382248639981364905ULL, 1393796574908163946ULL},
+    {2832900194486363201ULL, 2230074519853062314ULL},
+    {5955668970331000884ULL, 1784059615882449851ULL},
+    {1075186361522890384ULL, 1427247692705959881ULL},
+    {12788344622662355584ULL, 2283596308329535809ULL},
+    {13920024512871794791ULL, 1826877046663628647ULL},
+    {3757321980813615186ULL, 1461501637330902918ULL},
+    {10384555214134712795ULL, 1169201309864722334ULL},
+    {5547241898389809503ULL, 1870722095783555735ULL},
+    {4437793518711847602ULL, 1496577676626844588ULL},
+    {10928932444453298728ULL, 1197262141301475670ULL},
+    {17486291911125277965ULL, 1915619426082361072ULL},
+    {6610335899416401726ULL, 1532495540865888858ULL},
+    {12666966349016942027ULL, 1225996432692711086ULL},
+    {12888448528943286597ULL, 1961594292308337738ULL},
+    {17689456452638449924ULL, 1569275433846670190ULL},
+    {14151565162110759939ULL, 1255420347077336152ULL},
+    {7885109000409574610ULL, 2008672555323737844ULL},
+    {9997436015069570011ULL, 1606938044258990275ULL},
+    {7997948812055656009ULL, 1285550435407192220ULL},
+    {12796718099289049614ULL, 2056880696651507552ULL},
+    {2858676849947419045ULL, 1645504557321206042ULL},
+    {13354987924183666206ULL, 1316403645856964833ULL},
+    {17678631863951955605ULL, 2106245833371143733ULL},
+    {3074859046935833515ULL, 1684996666696914987ULL},
+    {13527933681774397782ULL, 1347997333357531989ULL},
+    {10576647446613305481ULL, 2156795733372051183ULL},
+    {15840015586774465031ULL, 1725436586697640946ULL},
+    {8982663654677661702ULL, 1380349269358112757ULL},
+    {18061610662226169046ULL, 2208558830972980411ULL},
+    {10759939715039024913ULL, 1766847064778384329ULL},
+    {12297300586773130254ULL, 1413477651822707463ULL},
+    {15986332124095098083ULL, 2261564242916331941ULL},
+    {9099716884534168143ULL, 1809251394333065553ULL},
+    {14658471137111155161ULL, 1447401115466452442ULL},
+    {4348079280205103483ULL, 1157920892373161954ULL},
+    {14335624477811986218ULL, 1852673427797059126ULL},
+    {7779150767507678651ULL, 1482138742237647301ULL},
+    {2533971799264232598ULL, 1185710993790117841ULL},
+    {15122401323048503126ULL, 1897137590064188545ULL},
+    {12097921058438802501ULL, 1517710072051350836ULL},
+    {5988988032009131678ULL, 1214168057641080669ULL},
+    {16961078480698431330ULL, 1942668892225729070ULL},
+    {13568862784558745064ULL, 1554135113780583256ULL},
+    {7165741412905085728ULL, 1243308091024466605ULL},
+    {11465186260648137165ULL, 1989292945639146568ULL},
+    {16550846638002330379ULL, 1591434356511317254ULL},
+    {16930026125143774626ULL, 1273147485209053803ULL},
+    {4951948911778577463ULL, 2037035976334486086ULL},
+    {272210314680951647ULL, 1629628781067588869ULL},
+    {3907117066486671641ULL, 1303703024854071095ULL},
+    {6251387306378674625ULL, 2085924839766513752ULL},
+    {16069156289328670670ULL, 1668739871813211001ULL},
+    {9165976216721026213ULL, 1334991897450568801ULL},
+    {7286864317269821294ULL, 2135987035920910082ULL},
+    {16897537898041588005ULL, 1708789628736728065ULL},
+    {13518030318433270404ULL, 1367031702989382452ULL},
+    {6871453250525591353ULL, 2187250724783011924ULL},
+    {9186511415162383406ULL, 1749800579826409539ULL},
+    {11038557946871817048ULL, 1399840463861127631ULL},
+    {10282995085511086630ULL, 2239744742177804210ULL},
+    {8226396068408869304ULL, 1791795793742243368ULL},
+    {13959814484210916090ULL, 1433436634993794694ULL},
+    {11267656730511734774ULL, 2293498615990071511ULL},
+    {5324776569667477496ULL, 1834798892792057209ULL},
+    {7949170070475892320ULL, 1467839114233645767ULL},
+    {17427382500606444826ULL, 1174271291386916613ULL},
+    {5747719112518849781ULL, 1878834066219066582ULL},
+    {15666221734240810795ULL, 1503067252975253265ULL},
+    {12532977387392648636ULL, 1202453802380202612ULL},
+    {5295368560860596524ULL, 1923926083808324180ULL},
+    {4236294848688477220ULL, 1539140867046659344ULL},
+    {7078384693692692099ULL, 1231312693637327475ULL},
+    {11325415509908307358ULL, 1970100309819723960ULL},
+    {9060332407926645887ULL, 1576080247855779168ULL},
+    {14626963555825137356ULL, 1260864198284623334ULL},
+    {12335095245094488799ULL, 2017382717255397335ULL},
+    {9868076196075591040ULL, 1613906173804317868ULL},
+    {15273158586344293478ULL, 1291124939043454294ULL},
+    {13369007293925138595ULL, 2065799902469526871ULL},
+    {7005857020398200553ULL, 1652639921975621497ULL},
+    {16672732060544291412ULL, 1322111937580497197ULL},
+    {11918976037903224966ULL, 2115379100128795516ULL},
+    {5845832015580669650ULL, 1692303280103036413ULL},
+    {12055363241948356366ULL, 1353842624082429130ULL},
+    {841837113407818570ULL, 2166148198531886609ULL},
+    {4362818505468165179ULL, 1732918558825509287ULL},
+    {14558301248600263113ULL, 1386334847060407429ULL},
+    {12225235553534690011ULL, 2218135755296651887ULL},
+    {2401490813343931363ULL, 1774508604237321510ULL},
+    {1921192650675145090ULL, 1419606883389857208ULL},
+    {17831303500047873437ULL, 2271371013423771532ULL},
+    {6886345170554478103ULL, 1817096810739017226ULL},
+    {1819727321701672159ULL, 1453677448591213781ULL},
+    {16213177116328979020ULL, 1162941958872971024ULL},
+    {14873036941900635463ULL, 1860707134196753639ULL},
+    {15587778368262418694ULL, 1488565707357402911ULL},
+    {8780873879868024632ULL, 1190852565885922329ULL},
+    {2981351763563108441ULL, 1905364105417475727ULL},
+    {13453127855076217722ULL, 1524291284333980581ULL},
+    {7073153469319063855ULL, 1219433027467184465ULL},
+    {11317045550910502167ULL, 1951092843947495144ULL},
+    {12742985255470312057ULL, 1560874275157996115ULL},
+    {10194388204376249646ULL, 1248699420126396892ULL},
+    {1553625868034358140ULL, 1997919072202235028ULL},
+    {8621598323911307159ULL, 1598335257761788022ULL},
+    {17965325103354776697ULL, 1278668206209430417ULL},
+    {13987124906400001422ULL, 2045869129935088668ULL},
+    {121653480894270168ULL, 1636695303948070935ULL},
+    {97322784715416134ULL, 1309356243158456748ULL},
+    {14913111714512307107ULL, 2094969989053530796ULL},
+    {8241140556867935363ULL, 1675975991242824637ULL},
+    {17660958889720079260ULL, 1340780792994259709ULL},
+    {17189487779326395846ULL, 2145249268790815535ULL},
+    {13751590223461116677ULL, 1716199415032652428ULL},
+    {18379969808252713988ULL, 1372959532026121942ULL},
+    {14650556434236701088ULL, 2196735251241795108ULL},
+    {652398703163629901ULL, 1757388200993436087ULL},
+    {11589965406756634890ULL, 1405910560794748869ULL},
+    {7475898206584884855ULL, 2249456897271598191ULL},
+    {2291369750525997561ULL, 1799565517817278553ULL},
+    {9211793429904618695ULL, 1439652414253822842ULL},
+    {18428218302589300235ULL, 2303443862806116547ULL},
+    {7363877012587619542ULL, 1842755090244893238ULL},
+    {13269799239553916280ULL, 1474204072195914590ULL},
+    {10615839391643133024ULL, 1179363257756731672ULL},
+    {2227947767661371545ULL, 1886981212410770676ULL},
+    {16539753473096738529ULL, 1509584969928616540ULL},
+    {13231802778477390823ULL, 1207667975942893232ULL},
+    {6413489186596184024ULL, 1932268761508629172ULL},
+    {16198837793502678189ULL, 1545815009206903337ULL},
+    {5580372605318321905ULL, 1236652007365522670ULL},
+    {8928596168509315048ULL, 1978643211784836272ULL},
+    {18210923379033183008ULL, 1582914569427869017ULL},
+    {7190041073742725760ULL, 1266331655542295214ULL},
+    {436019273762630246ULL, 2026130648867672343ULL},
+    {7727513048493924843ULL, 1620904519094137874ULL},
+    {9871359253537050198ULL, 1296723615275310299ULL},
+    {4726128361433549347ULL, 2074757784440496479ULL},
+    {7470251503888749801ULL, 1659806227552397183ULL},
+    {13354898832594820487ULL, 1327844982041917746ULL},
+    {13989140502667892133ULL, 2124551971267068394ULL},
+    {14880661216876224029ULL, 1699641577013654715ULL},
+    {11904528973500979224ULL, 1359713261610923772ULL},
+    {4289851098633925465ULL, 2175541218577478036ULL},
+    {18189276137874781665ULL, 1740432974861982428ULL},
+    {3483374466074094362ULL, 1392346379889585943ULL},
+    {1884050330976640656ULL, 2227754207823337509ULL},
+    {5196589079523222848ULL, 1782203366258670007ULL},
+    {15225317707844309248ULL, 1425762693006936005ULL},
+    {5913764258841343181ULL, 2281220308811097609ULL},
+    {8420360221814984868ULL, 1824976247048878087ULL},
+    {17804334621677718864ULL, 1459980997639102469ULL},
+    {17932816512084085415ULL, 1167984798111281975ULL},
+    {10245762345624985047ULL, 1868775676978051161ULL},
+    {4507261061758077715ULL, 1495020541582440929ULL},
+    {7295157664148372495ULL, 1196016433265952743ULL},
+    {7982903447895485668ULL, 1913626293225524389ULL},
+    {10075671573058298858ULL, 1530901034580419511ULL},
+    {4371188443704728763ULL, 1224720827664335609ULL},
+    {14372599139411386667ULL, 1959553324262936974ULL},
+    {15187428126271019657ULL, 1567642659410349579ULL},
+    {15839291315758726049ULL, 1254114127528279663ULL},
+    {3206773216762499739ULL, 2006582604045247462ULL},
+    {13633465017635730761ULL, 1605266083236197969ULL},
+    {14596120828850494932ULL, 1284212866588958375ULL},
+    {4907049252451240275ULL, 2054740586542333401ULL},
+    {236290587219081897ULL, 1643792469233866721ULL},
+    {14946427728742906810ULL, 1315033975387093376ULL},
+    {16535586736504830250ULL, 2104054360619349402ULL},
+    {5849771759720043554ULL, 1683243488495479522ULL},
+    {15747863852001765813ULL, 1346594790796383617ULL},
+    {10439186904235184007ULL, 2154551665274213788ULL},
+    {15730047152871967852ULL, 1723641332219371030ULL},
+    {12584037722297574282ULL, 1378913065775496824ULL},
+    {9066413911450387881ULL, 2206260905240794919ULL},
+    {10942479943902220628ULL, 1765008724192635935ULL},
+    {8753983955121776503ULL, 1412006979354108748ULL},
+    {10317025513452932081ULL, 2259211166966573997ULL},
+    {874922781278525018ULL, 1807368933573259198ULL},
+    {8078635854506640661ULL, 1445895146858607358ULL},
+    {13841606313089133175ULL, 1156716117486885886ULL},
+    {14767872471458792434ULL, 1850745787979017418ULL},
+    {746251532941302978ULL, 1480596630383213935ULL},
+    {597001226353042382ULL, 1184477304306571148ULL},
+    {15712597221132509104ULL, 1895163686890513836ULL},
+    {8880728962164096960ULL, 1516130949512411069ULL},
+    {10793931984473187891ULL, 1212904759609928855ULL},
+    {17270291175157100626ULL, 1940647615375886168ULL},
+    {2748186495899949531ULL, 1552518092300708935ULL},
+    {2198549196719959625ULL, 1242014473840567148ULL},
+    {18275073973719576693ULL, 1987223158144907436ULL},
+    {10930710364233751031ULL, 1589778526515925949ULL},
+    {12433917106128911148ULL, 1271822821212740759ULL},
+    {8826220925580526867ULL, 2034916513940385215ULL},
+    {7060976740464421494ULL, 1627933211152308172ULL},
+    {16716827836597268165ULL, 1302346568921846537ULL},
+    {11989529279587987770ULL, 2083754510274954460ULL},
+    {9591623423670390216ULL, 1667003608219963568ULL},
+    {15051996368420132820ULL, 1333602886575970854ULL},
+    {13015147745246481542ULL, 2133764618521553367ULL},
+    {3033420566713364587ULL, 1707011694817242694ULL},
+    {6116085268112601993ULL, 1365609355853794155ULL},
+    {9785736428980163188ULL, 2184974969366070648ULL},
+    {15207286772667951197ULL, 1747979975492856518ULL},
+    {1097782973908629988ULL, 1398383980394285215ULL},
+    {1756452758253807981ULL, 2237414368630856344ULL},
+    {5094511021344956708ULL, 1789931494904685075ULL},
+    {4075608817075965366ULL, 1431945195923748060ULL},
+    {6520974107321544586ULL, 2291112313477996896ULL},
+    {1527430471115325346ULL, 1832889850782397517ULL},
+    {12289990821117991246ULL, 1466311880625918013ULL},
+    {17210690286378213644ULL, 1173049504500734410ULL},
+    {9090360384495590213ULL, 1876879207201175057ULL},
+    {18340334751822203140ULL, 1501503365760940045ULL},
+    {14672267801457762512ULL, 1201202692608752036ULL},
+    {16096930852848599373ULL, 1921924308174003258ULL},
+    {1809498238053148529ULL, 1537539446539202607ULL},
+    {12515645034668249793ULL, 1230031557231362085ULL},
+    {1578287981759648052ULL, 1968050491570179337ULL},
+    {12330676829633449412ULL, 1574440393256143469ULL},
+    {13553890278448669853ULL, 1259552314604914775ULL},
+    {3239480371808320148ULL, 2015283703367863641ULL},
+    {17348979556414297411ULL, 1612226962694290912ULL},
+    {6500486015647617283ULL, 1289781570155432730ULL},
+    {10400777625036187652ULL, 2063650512248692368ULL},
+    {15699319729512770768ULL, 1650920409798953894ULL},
+    {16248804598352126938ULL, 1320736327839163115ULL},
+    {7551343283653851484ULL, 2113178124542660985ULL},
+    {6041074626923081187ULL, 1690542499634128788ULL},
+    {12211557331022285596ULL, 1352433999707303030ULL},
+    {1091747655926105338ULL, 2163894399531684849ULL},
+    {4562746939482794594ULL, 1731115519625347879ULL},
+    {7339546366328145998ULL, 1384892415700278303ULL},
+    {8053925371383123274ULL, 2215827865120445285ULL},
+    {6443140297106498619ULL, 1772662292096356228ULL},
+    {12533209867169019542ULL, 1418129833677084982ULL},
+    {5295740528502789974ULL, 2269007733883335972ULL},
+    {15304638867027962949ULL, 1815206187106668777ULL},
+    {4865013464138549713ULL, 1452164949685335022ULL},
+    {14960057215536570740ULL, 1161731959748268017ULL},
+    {9178696285890871890ULL, 1858771135597228828ULL},
+    {14721654658196518159ULL, 1487016908477783062ULL},
+    {4398626097073393881ULL, 1189613526782226450ULL},
+    {7037801755317430209ULL, 1903381642851562320ULL},
+    {5630241404253944167ULL, 1522705314281249856ULL},
+    {814844308661245011ULL, 1218164251424999885ULL},
+    {1303750893857992017ULL, 1949062802279999816ULL},
+    {15800395974054034906ULL, 1559250241823999852ULL},
+    {5261619149759407279ULL, 1247400193459199882ULL},
+    {12107939454356961969ULL, 1995840309534719811ULL},
+    {5997002748743659252ULL, 1596672247627775849ULL},
+    {8486951013736837725ULL, 1277337798102220679ULL},
+    {2511075177753209390ULL, 2043740476963553087ULL},
+    {13076906586428298482ULL, 1634992381570842469ULL},
+    {14150874083884549109ULL, 1307993905256673975ULL},
+    {4194654460505726958ULL, 2092790248410678361ULL},
+    {18113118827372222859ULL, 1674232198728542688ULL},
+    {3422448617672047318ULL, 1339385758982834151ULL},
+    {16543964232501006678ULL, 2143017214372534641ULL},
+    {9545822571258895019ULL, 1714413771498027713ULL},
+    {15015355686490936662ULL, 1371531017198422170ULL},
+    {5577825024675947042ULL, 2194449627517475473ULL},
+    {11840957649224578280ULL, 1755559702013980378ULL},
+    {16851463748863483271ULL, 1404447761611184302ULL},
+    {12204946739213931940ULL, 2247116418577894884ULL},
+    {13453306206113055875ULL, 1797693134862315907ULL},
+    {3383947335406624054ULL, 1438154507889852726ULL},
+    {16482362180876329456ULL, 2301047212623764361ULL},
+    {9496540929959153242ULL, 1840837770099011489ULL},
+    {11286581558709232917ULL, 1472670216079209191ULL},
+    {5339916432225476010ULL, 1178136172863367353ULL},
+    {4854517476818851293ULL, 1885017876581387765ULL},
+    {3883613981455081034ULL, 1508014301265110212ULL},
+    {14174937629389795797ULL, 1206411441012088169ULL},
+    {11611853762797942306ULL, 1930258305619341071ULL},
+    {5600134195496443521ULL, 1544206644495472857ULL},
+    {15548153800622885787ULL, 1235365315596378285ULL},
+    {6430302007287065643ULL, 1976584504954205257ULL},
+    {16212288050055383484ULL, 1581267603963364205ULL},
+    {12969830440044306787ULL, 1265014083170691364ULL},
+    {9683682259845159889ULL, 2024022533073106183ULL},
+    {15125643437359948558ULL, 1619218026458484946ULL},
+    {8411165935146048523ULL, 1295374421166787957ULL},
+    {17147214310975587960ULL, 2072599073866860731ULL},
+    {10028422634038560045ULL, 1658079259093488585ULL},
+    {8022738107230848036ULL, 1326463407274790868ULL},
+    {9147032156827446534ULL, 2122341451639665389ULL},
+    {11006974540203867551ULL, 1697873161311732311ULL},
+    {5116230817421183718ULL, 1358298529049385849ULL},
+    {15564666937357714594ULL, 2173277646479017358ULL},
+    {1383687105660440706ULL, 1738622117183213887ULL},
+    {12174996128754083534ULL, 1390897693746571109ULL},
+    {8411947361780802685ULL, 2225436309994513775ULL},
+    {6729557889424642148ULL, 1780349047995611020ULL},
+    {5383646311539713719ULL, 1424279238396488816ULL},
+    {1235136468979721303ULL, 2278846781434382106ULL},
+    {15745504434151418335ULL, 1823077425147505684ULL},
+    {16285752362063044992ULL, 1458461940118004547ULL},
+    {5649904260166615347ULL, 1166769552094403638ULL},
+    {5350498001524674232ULL, 1866831283351045821ULL},
+    {591049586477829062ULL, 1493465026680836657ULL},
+    {11540886113407994219ULL, 1194772021344669325ULL},
+    {18673707743239135ULL, 1911635234151470921ULL},
+    {14772334225162232601ULL, 1529308187321176736ULL},
+    {8128518565387875758ULL, 1223446549856941389ULL},
+    {1937583260394870242ULL, 1957514479771106223ULL},
+    {8928764237799716840ULL, 1566011583816884978ULL},
+    {14521709019723594119ULL, 1252809267053507982ULL},
+    {8477339172590109297ULL, 2004494827285612772ULL},
+    {17849917782297818407ULL, 1603595861828490217ULL},
+    {6901236596354434079ULL, 1282876689462792174ULL},
+    {18420676183650915173ULL, 2052602703140467478ULL},
+    {3668494502695001169ULL, 1642082162512373983ULL},
+    {10313493231639821582ULL, 1313665730009899186ULL},
+    {9122891541139893884ULL, 2101865168015838698ULL},
+    {14677010862395735754ULL, 1681492134412670958ULL},
+    {673562245690857633ULL, 1345193707530136767ULL}
+};
+
+/* Number of bits in 5^e, for e > 0 */
+static int32_t dtoa_pow5bits(int32_t e) {
+    return (int32_t)(((uint32_t) e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) */
+static int32_t dtoa_log10_pow2(int32_t e) {
+    return (int32_t)(((uint32_t) e * 78913) >> 18);
+}
+
+/* floor(log10(5^e)) */
+static int32_t dtoa_log10_pow5(int32_t e) {
+    return (int32_t)(((uint32_t) e * 732923) >> 20);
+}
+
+static int dtoa_multiple_of_pow5(uint64_t x, int32_t p) {
+    int32_t count = 0;
+    while (x % 5 == 0) {
+        x /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static int dtoa_multiple_of_pow2(uint64_t x, int32_t p) {
+    return (x & ((1ULL << p) - 1)) == 0;
+}
+
+/* (m * mul) >> j, where mul is a 128 bit number and j >= 64 */
+static uint64_t dtoa_mul_shift(uint64_t m, const uint64_t *mul, int32_t j) {
+    uint64_t lo0, lo2;
+    uint64_t hi0 = umul128(m, mul[0], &lo0);
+    uint64_t hi2 = umul128(m, mul[1], &lo2);
+    uint64_t sum = hi0 + lo2;
+    if (sum < hi0) hi2++;
+    int32_t shift = j - 64;
+    return shift ? ((hi2 << (64 - shift)) | (sum >> shift)) : sum;
+}
+
+/* Get the shortest digits of a positive, finite double. The value is
+ * digits * 10^exponent. */
+static uint64_t dtoa_ryu(double x, int32_t *exponent) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    uint64_t mantissa = bits & 0x000FFFFFFFFFFFFFULL;
+    uint32_t biased = (uint32_t)((bits >> 52) & 0x7FF);
+    int32_t e2;
+    uint64_t m2;
+    if (biased == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = mantissa;
+    } else {
+        e2 = (int32_t) biased - 1023 - 52 - 2;
+        m2 = (1ULL << 52) | mantissa;
+    }
+    int accept_bounds = (m2 & 1) == 0;
+
+    /* The interval of decimals that read back as x is (mm, mp) * 2^e2 */
+    uint64_t mv = 4 * m2;
+    uint32_t mm_shift = mantissa != 0 || biased <= 1;
+
+    /* Convert the interval to base 10 */
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    int vm_trailing_zeros = 0;
+    int vr_trailing_zeros = 0;
+    if (e2 >= 0) {
+        int32_t q = dtoa_log10_pow2(e2) - (e2 > 3);
+        e10 = q;
+        int32_t k = 125 + dtoa_pow5bits(q) - 1;
+        int32_t i = -e2 + q + k;
+        vr = dtoa_mul_shift(4 * m2, dtoa_pow5_inv[q], i);
+        vp = dtoa_mul_shift(4 * m2 + 2, dtoa_pow5_inv[q], i);
+        vm = dtoa_mul_shift(4 * m2 - 1 - mm_shift, dtoa_pow5_inv[q], i);
+        if (q <= 21) {
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = dtoa_multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = dtoa_multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= dtoa_multiple_of_pow5(mv + 2, q);
+            }
+        }
+    } else {
+        int32_t q = dtoa_log10_pow5(-e2) - (-e2 > 1);
+        e10 = q + e2;
+        int32_t i = -e2 - q;
+        int32_t k = dtoa_pow5bits(i) - 125;
+        int32_t j = q - k;
+        vr = dtoa_mul_shift(4 * m2, dtoa_pow5[i], j);
+        vp = dtoa_mul_shift(4 * m2 + 2, dtoa_pow5[i], j);
+        vm = dtoa_mul_shift(4 * m2 - 1 - mm_shift, dtoa_pow5[i], j);
+        if (q <= 1) {
+            vr_trailing_zeros = 1;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = dtoa_multiple_of_pow2(mv, q);
         }
     }
-    buffer->count += count;
+
+    /* Remove digits while the interval still has a member with fewer digits */
+    int32_t removed = 0;
+    uint8_t last_removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        /* Round half to even */
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) last_removed = 4;
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        int round_up = 0;
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    *exponent = e10 + removed;
+    return output;
+}
+
+/* Write the digits of an unsigned integer, returning the count */
+static int dtoa_u64(uint64_t x, char *out) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + x % 10);
+        x /= 10;
+    } while (x);
+    for (int i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    return n;
+}
+
+/* Print a double to out, which must have room for JANET_DTOA_SIZE bytes.
+ * Returns the number of bytes written. */
+int janet_dtoa(double x, uint8_t *out) {
+    char *p = (char *) out;
+    if (isnan(x)) {
+        if (signbit(x)) *p++ = '-';
+        memcpy(p, "nan", 3);
+        return (int)(p + 3 - (char *) out);
+    }
+    if (signbit(x)) {
+        *p++ = '-';
+        x = -x;
+    }
+    if (isinf(x)) {
+        memcpy(p, "inf", 3);
+        return (int)(p + 3 - (char *) out);
+    }
+    if (x == 0.0) {
+        *p++ = '0';
+        return (int)(p - (char *) out);
+    }
+    if (x < 9007199254740992.0 && x == (double)(uint64_t) x) {
+        p += dtoa_u64((uint64_t) x, p);
+        return (int)(p - (char *) out);
+    }
+    char digits[24];
+    int32_t k = 0;
+    int len = dtoa_u64(dtoa_ryu(x, &k), digits);
+    /* Position of the decimal point relative to the first digit */
+    int point = len + k;
+    int exponent = point - 1;
+    if (exponent >= -4 && exponent < 17) {
+        if (point >= len) {
+            memcpy(p, digits, len);
+            p += len;
+            for (int i = len; i < point; i++) *p++ = '0';
+        } else if (point > 0) {
+            memcpy(p, digits, point);
+            p += point;
+            *p++ = '.';
+            memcpy(p, digits + point, len - point);
+            p += len - point;
+        } else {
+            *p++ = '0';
+            *p++ = '.';
+            for (int i = point; i < 0; i++) *p++ = '0';
+            memcpy(p, digits, len);
+            p += len;
+        }
+    } else {
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        if (exponent < 0) {
+            *p++ = '-';
+            exponent = -exponent;
+        } else {
+            *p++ = '+';
+        }
+        if (exponent < 10) *p++ = '0';
+        p += dtoa_u64((uint64_t) exponent, p);
+    }
+    return (int)(p - (char *) out);
+}
+
+void janet_buffer_dtostr(JanetBuffer *buffer, double x) {
+    janet_buffer_extra(buffer, JANET_DTOA_SIZE);
+    buffer->count += janet_dtoa(x, buffer->data + buffer->count);
 }
@@ -202,6 +202,11 @@ JanetTable *janet_struct_to_table(const JanetKV *st) {
     return table;
 }
 
+/* Get the canonical copy of a struct, see struct/intern */
+JanetStruct janet_struct_intern(JanetStruct st) {
+    return janet_unwrap_struct(janet_intern(janet_wrap_struct(st)));
+}
+
 /* C Functions */
 
 JANET_CORE_FN(cfun_struct_with_proto,
@@ -220,6 +225,17 @@ JANET_CORE_FN(cfun_struct_with_proto,
     return janet_wrap_struct(janet_struct_end(st));
 }
 
+JANET_CORE_FN(cfun_struct_intern,
+              "(struct/intern st)",
+              "Return a struct equal to `st` that is shared by all calls to `struct/intern` "
+              "with equal structs. If there is no such struct yet, `st` itself becomes the "
+              "shared copy. Interning many equal structs keeps only one of them alive, and "
+              "interned structs compare equal by identity. Nested structs and tuples are not "
+              "interned. The shared copy is forgotten once nothing else references it.") {
+    janet_fixarity(argc, 1);
+    return janet_wrap_struct(janet_struct_intern(janet_getstruct(argv, 0)));
+}
+
 JANET_CORE_FN(cfun_struct_getproto,
               "(struct/getproto st)",
               "Return the prototype of a struct, or nil if it doesn't have one.") {
@@ -309,6 +325,7 @@ void janet_lib_struct(JanetTable *env) {
     JanetRegExt struct_cfuns[] = {
         JANET_CORE_REG("struct/with-proto", cfun_struct_with_proto),
         JANET_CORE_REG("struct/getproto", cfun_struct_getproto),
+        JANET_CORE_REG("struct/intern", cfun_struct_intern),
         JANET_CORE_REG("struct/proto-flatten", cfun_struct_flatten),
         JANET_CORE_REG("struct/to-table", cfun_struct_to_table),
         JANET_CORE_REG("struct/rawget", cfun_struct_rawget),
@@ -36,9 +36,12 @@
 
 #include <string.h>
 
+/* The cache never shrinks below its initial size */
+#define JANET_SYMCACHE_MIN_CAPACITY 1024
+
 /* Initialize the cache (allocate cache memory) */
 void janet_symcache_init() {
-    janet_vm.cache_capacity = 1024;
+    janet_vm.cache_capacity = JANET_SYMCACHE_MIN_CAPACITY;
     janet_vm.cache = janet_calloc(1, (size_t) janet_vm.cache_capacity * sizeof(const uint8_t *));
     if (NULL == janet_vm.cache) {
         JANET_OUT_OF_MEMORY;
@@ -145,6 +148,40 @@ static void janet_cache_resize(uint32_t newCapacity) {
     janet_free((void *)oldCache);
 }
 
+/* Called after each sweep. Shrink the cache once it is less than 1/8 full,
+ * and rehash it in place once a quarter of it is tombstones, so that freed
+ * gensyms and keywords don't keep the cache large or slow forever. */
+void janet_symcache_compact(void) {
+    uint32_t capacity = janet_vm.cache_capacity;
+    uint32_t target = (uint32_t) janet_tablen((int32_t)(4 * janet_vm.cache_count + 1));
+    if (target < JANET_SYMCACHE_MIN_CAPACITY) target = JANET_SYMCACHE_MIN_CAPACITY;
+    if (target < capacity) {
+        janet_cache_resize(target);
+    } else if (janet_vm.cache_deleted * 4 > capacity) {
+        janet_cache_resize(capacity);
+    }
+}
+
+/* Get statistics for the cache. The cache belongs to the current thread, so
+ * this does not need any locking. */
+void janet_symcache_stats(JanetSymcacheStats *stats) {
+    uint32_t mask = janet_vm.cache_capacity - 1;
+    uint64_t total = 0;
+    uint32_t max_probe = 0;
+    for (uint32_t i = 0; i < janet_vm.cache_capacity; i++) {
+        const uint8_t *x = janet_vm.cache[i];
+        if (x == NULL || x == JANET_SYMCACHE_DELETED) continue;
+        uint32_t probe = ((i - ((uint32_t) janet_string_hash(x) & mask)) & mask) + 1;
+        total += probe;
+        if (probe > max_probe) max_probe = probe;
+    }
+    stats->capacity = janet_vm.cache_capacity;
+    stats->count = janet_vm.cache_count;
+    stats->deleted = janet_vm.cache_deleted;
+    stats->max_probe = max_probe;
+    stats->average_probe = janet_vm.cache_count ? (double) total / janet_vm.cache_count : 0.0;
+}
+
 /* Add an item to the cache */
 static void janet_symcache_put(const uint8_t *x, const uint8_t **bucket) {
     if ((janet_vm.cache_count + janet_vm.cache_deleted) * 2 > janet_vm.cache_capacity) {
@@ -178,6 +215,7 @@ const uint8_t *janet_symbol(const uint8_t *str, int32_t len) {
         return *bucket;
     JanetStringHead *head = janet_gcalloc(JANET_MEMORY_SYMBOL, sizeof(JanetStringHead) + (size_t) len + 1);
     head->hash = hash;
+    head->gc.flags |= JANET_STRING_FLAG_HASHED;
     head->length = len;
     newstr = (uint8_t *)(head->data);
     safe_memcpy(newstr, str, len);
@@ -232,9 +270,13 @@ const uint8_t *janet_symbol_gen(void) {
     JanetStringHead *head = janet_gcalloc(JANET_MEMORY_SYMBOL, sizeof(JanetStringHead) + sizeof(janet_vm.gensym_counter));
     head->length = sizeof(janet_vm.gensym_counter) - 1;
     head->hash = hash;
+    head->gc.flags |= JANET_STRING_FLAG_HASHED;
     sym = (uint8_t *)(head->data);
     memcpy(sym, janet_vm.gensym_counter, sizeof(janet_vm.gensym_counter));
     sym[head->length] = 0;
     janet_symcache_put((const uint8_t *)sym, bucket);
+    /* Move on even if the symbol is collected later, so the names generated
+     * do not depend on when the garbage collector runs. */
+    inc_gensym();
     return (const uint8_t *)sym;
 }
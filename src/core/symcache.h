@@ -32,5 +32,6 @@
 void janet_symcache_init(void);
 void janet_symcache_deinit(void);
 void janet_symbol_deinit(const uint8_t *sym);
+void janet_symcache_compact(void);
 
 #endif
@@ -28,34 +28,108 @@
 #include <math.h>
 #endif
 
+#include <string.h>
+
+#if defined(JANET_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(JANET_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 #define JANET_TABLE_FLAG_STACK 0x10000
 
-static void *janet_memalloc_empty_local(int32_t count) {
-    int32_t i;
-    void *mem = janet_smalloc((size_t) count * sizeof(JanetKV));
-    JanetKV *mmem = (JanetKV *)mem;
-    for (i = 0; i < count; i++) {
-        JanetKV *kv = mmem + i;
-        kv->key = janet_wrap_nil();
-        kv->value = janet_wrap_nil();
+/* Tables are open addressed with linear probing, and the buckets keep the same
+ * layout as structs: an empty bucket has a nil key and a nil value, and a
+ * deleted bucket has a nil key and a false value. janet_dict_find and code that
+ * walks t->data therefore see an ordinary dictionary.
+ *
+ * The bucket array is followed by one control byte per bucket, holding
+ * JANET_CTRL_EMPTY, JANET_CTRL_DELETED, or the top 7 bits of the key's hash.
+ * Lookups compare a group of 16 control bytes at once, and only call
+ * janet_equals on buckets whose hash bits match. The first
+ * JANET_TABLE_GROUP - 1 control bytes are mirrored after the last one, so a
+ * group that starts near the end of the table can be loaded without wrapping. */
+
+#define JANET_TABLE_GROUP 16
+#define JANET_TABLE_DIRECT 4
+#define JANET_CTRL_EMPTY 0x80
+#define JANET_CTRL_DELETED 0xFE
+#define janet_table_ctrl(t) ((uint8_t *)((t)->data + (t)->capacity))
+#define janet_ctrl_hash(hash) ((uint8_t)((uint32_t)(hash) >> 25))
+
+#if defined(JANET_SIMD_SSE2)
+typedef uint32_t JanetGroupMask;
+#define JANET_GROUP_LANE 1
+static JanetGroupMask janet_group_match(const uint8_t *ctrl, uint8_t c) {
+    __m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+    return (JanetGroupMask) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) c)));
+}
+#elif defined(JANET_SIMD_NEON)
+/* NEON has no movemask, so narrow each lane of the comparison to 4 bits and
+ * keep one bit per lane */
+typedef uint64_t JanetGroupMask;
+#define JANET_GROUP_LANE 4
+static JanetGroupMask janet_group_match(const uint8_t *ctrl, uint8_t c) {
+    uint8x16_t eq = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(c));
+    uint8x8_t narrow = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrow), 0) & 0x8888888888888888ULL;
+}
+#endif
+
+#ifdef JANET_GROUP_LANE
+static int32_t janet_group_first(JanetGroupMask mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (int32_t)(__builtin_ctzll((unsigned long long) mask) / JANET_GROUP_LANE);
+#else
+    int32_t i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
     }
-    return mem;
+    return i / JANET_GROUP_LANE;
+#endif
 }
+#endif
 
-static JanetTable *janet_table_init_impl(JanetTable *table, int32_t capacity, int stackalloc) {
+/* Tables grow once three quarters of the buckets are used or deleted. The
+ * control bytes keep the longer probe sequences cheap. */
+#define janet_table_full(t) ((t)->count + (t)->deleted + 1 > (t)->capacity - ((t)->capacity >> 2))
+
+static size_t janet_table_bytes(int32_t capacity) {
+    return (size_t) capacity * sizeof(JanetKV) + (size_t) capacity + JANET_TABLE_GROUP - 1;
+}
+
+static JanetKV *janet_table_alloc(int32_t capacity, int stackalloc) {
+    size_t size = janet_table_bytes(capacity);
     JanetKV *data;
+    if (stackalloc) {
+        data = janet_smalloc(size);
+    } else {
+        data = janet_malloc(size);
+        if (NULL == data) {
+            JANET_OUT_OF_MEMORY;
+        }
+        janet_vm.next_collection += size;
+    }
+    janet_memempty(data, capacity);
+    memset(data + capacity, JANET_CTRL_EMPTY, (size_t) capacity + JANET_TABLE_GROUP - 1);
+    return data;
+}
+
+/* Set the control byte of a bucket and all of its mirrors */
+static void janet_table_setctrl(JanetTable *t, int32_t index, uint8_t c) {
+    uint8_t *ctrl = janet_table_ctrl(t);
+    int32_t end = t->capacity + JANET_TABLE_GROUP - 1;
+    for (int32_t i = index; i < end; i += t->capacity) {
+        ctrl[i] = c;
+    }
+}
+
+static JanetTable *janet_table_init_impl(JanetTable *table, int32_t capacity, int stackalloc) {
     capacity = janet_tablen(capacity);
     if (stackalloc) table->gc.flags = JANET_TABLE_FLAG_STACK;
     if (capacity) {
-        if (stackalloc) {
-            data = janet_memalloc_empty_local(capacity);
-        } else {
-            data = (JanetKV *) janet_memalloc_empty(capacity);
-            if (NULL == data) {
-                JANET_OUT_OF_MEMORY;
-            }
-        }
-        table->data = data;
+        table->data = janet_table_alloc(capacity, stackalloc);
         table->capacity = capacity;
     } else {
         table->data = NULL;
@@ -63,6 +137,7 @@ static JanetTable *janet_table_init_impl(JanetTable *table, int32_t capacity, in
     }
     table->count = 0;
     table->deleted = 0;
+    table->version = 0;
     table->proto = NULL;
     return table;
 }
@@ -74,11 +149,14 @@ JanetTable *janet_table_init(JanetTable *table, int32_t capacity) {
 
 /* Initialize a table without using scratch memory */
 JanetTable *janet_table_init_raw(JanetTable *table, int32_t capacity) {
+    table->gc.flags = 0;
     return janet_table_init_impl(table, capacity, 0);
 }
 
 /* Deinitialize a table */
 void janet_table_deinit(JanetTable *table) {
+    /* The address may be reused by another table, so drop cached lookups */
+    janet_vm.method_cache_epoch++;
     if (table->gc.flags & JANET_TABLE_FLAG_STACK) {
         janet_sfree(table->data);
     } else {
@@ -108,33 +186,138 @@ JanetTable *janet_table_weakkv(int32_t capacity) {
     return janet_table_init_impl(table, capacity, 0);
 }
 
+/* Find the bucket that contains a key with the given hash. If the key is not
+ * in the table, returns the first deleted bucket on the probe path, or else
+ * the empty bucket that ended it. */
+static JanetKV *janet_table_find_hashed(JanetTable *t, Janet key, int32_t hash) {
+    int32_t cap = t->capacity;
+    if (cap == 0) return NULL;
+    uint32_t mask = (uint32_t) cap - 1;
+    uint32_t index = janet_maphash(cap, hash);
+    uint8_t tag = janet_ctrl_hash(hash);
+    const uint8_t *ctrl = janet_table_ctrl(t);
+    JanetKV *data = t->data;
+    JanetKV *first_deleted = NULL;
+    /* Most lookups end within a few buckets of the home bucket. Checking
+     * those directly stays within one cache line and avoids touching the
+     * control bytes at all. */
+    int32_t direct = cap < JANET_TABLE_DIRECT ? cap : JANET_TABLE_DIRECT;
+    for (int32_t i = 0; i < direct; i++) {
+        JanetKV *kv = data + index;
+        if (janet_checktype(kv->key, JANET_NIL)) {
+            if (janet_checktype(kv->value, JANET_NIL)) {
+                return first_deleted ? first_deleted : kv;
+            } else if (NULL == first_deleted) {
+                first_deleted = kv;
+            }
+        } else if (janet_equals(kv->key, key)) {
+            return kv;
+        }
+        index = (index + 1) & mask;
+    }
+    if (direct == cap) return first_deleted;
+#ifdef JANET_GROUP_LANE
+    for (int32_t probed = direct; probed < cap; probed += JANET_TABLE_GROUP) {
+        const uint8_t *group = ctrl + index;
+        JanetGroupMask empty = janet_group_match(group, JANET_CTRL_EMPTY);
+        /* Probing stops at the first empty bucket, so ignore anything after it */
+        JanetGroupMask live = empty ? (empty & (0 - empty)) - 1 : ~(JanetGroupMask) 0;
+        JanetGroupMask match = janet_group_match(group, tag) & live;
+        while (match) {
+            JanetKV *kv = data + ((index + janet_group_first(match)) & mask);
+            if (janet_equals(kv->key, key)) return kv;
+            match &= match - 1;
+        }
+        if (NULL == first_deleted) {
+            JanetGroupMask deleted = janet_group_match(group, JANET_CTRL_DELETED) & live;
+            if (deleted) first_deleted = data + ((index + janet_group_first(deleted)) & mask);
+        }
+        if (empty) {
+            return first_deleted ? first_deleted : data + ((index + janet_group_first(empty)) & mask);
+        }
+        index = (index + JANET_TABLE_GROUP) & mask;
+    }
+#else
+    for (int32_t probed = direct; probed < cap; probed++) {
+        uint8_t c = ctrl[index];
+        if (c == JANET_CTRL_EMPTY) {
+            return first_deleted ? first_deleted : data + index;
+        } else if (c == JANET_CTRL_DELETED) {
+            if (NULL == first_deleted) first_deleted = data + index;
+        } else if (c == tag && janet_equals(data[index].key, key)) {
+            return data + index;
+        }
+        index = (index + 1) & mask;
+    }
+#endif
+    return first_deleted;
+}
+
 /* Find the bucket that contains the given key. Will also return
  * bucket where key should go if not in the table. */
 JanetKV *janet_table_find(JanetTable *t, Janet key) {
-    return (JanetKV *) janet_dict_find(t->data, t->capacity, key);
+    int32_t hash = janet_hash(key);
+    JanetKV *bucket = janet_table_find_hashed(t, key, hash);
+#ifndef JANET_BOOTSTRAP
+    if ((t->gc.flags & JANET_TABLE_FLAG_LAZY) &&
+            (NULL == bucket || janet_checktype(bucket->key, JANET_NIL)) &&
+            janet_core_lazy_load(t, key)) {
+        bucket = janet_table_find_hashed(t, key, hash);
+    }
+#endif
+    return bucket;
+}
+
+/* Fill a bucket returned by janet_table_find_hashed for a missing key */
+static void janet_table_fill(JanetTable *t, JanetKV *bucket, Janet key, Janet value, int32_t hash) {
+    int32_t index = (int32_t)(bucket - t->data);
+    if (janet_table_ctrl(t)[index] == JANET_CTRL_DELETED) --t->deleted;
+    janet_table_setctrl(t, index, janet_ctrl_hash(hash));
+    bucket->key = key;
+    bucket->value = value;
+    ++t->count;
+    ++t->version;
+}
+
+/* Empty a bucket without searching for it. If the next bucket is empty, no
+ * probe can pass through this one, so it becomes empty too along with any
+ * deleted buckets just before it. Otherwise it is marked as deleted. */
+void janet_table_erase(JanetTable *t, JanetKV *bucket) {
+    uint32_t mask = (uint32_t) t->capacity - 1;
+    uint32_t index = (uint32_t)(bucket - t->data);
+    uint8_t *ctrl = janet_table_ctrl(t);
+    t->count--;
+    if (ctrl[(index + 1) & mask] == JANET_CTRL_EMPTY) {
+        janet_table_setctrl(t, (int32_t) index, JANET_CTRL_EMPTY);
+        bucket->key = janet_wrap_nil();
+        bucket->value = janet_wrap_nil();
+        for (index = (index - 1) & mask; ctrl[index] == JANET_CTRL_DELETED; index = (index - 1) & mask) {
+            janet_table_setctrl(t, (int32_t) index, JANET_CTRL_EMPTY);
+            t->data[index].value = janet_wrap_nil();
+            t->deleted--;
+        }
+    } else {
+        janet_table_setctrl(t, (int32_t) index, JANET_CTRL_DELETED);
+        bucket->key = janet_wrap_nil();
+        bucket->value = janet_wrap_false();
+        t->deleted++;
+    }
 }
 
 /* Resize the dictionary table. */
 static void janet_table_rehash(JanetTable *t, int32_t size) {
     JanetKV *olddata = t->data;
-    JanetKV *newdata;
     int islocal = t->gc.flags & JANET_TABLE_FLAG_STACK;
-    if (islocal) {
-        newdata = (JanetKV *) janet_memalloc_empty_local(size);
-    } else {
-        newdata = (JanetKV *) janet_memalloc_empty(size);
-        if (NULL == newdata) {
-            JANET_OUT_OF_MEMORY;
-        }
-    }
     int32_t oldcapacity = t->capacity;
-    t->data = newdata;
+    t->data = janet_table_alloc(size, islocal);
     t->capacity = size;
     t->deleted = 0;
     for (int32_t i = 0; i < oldcapacity; i++) {
         JanetKV *kv = olddata + i;
         if (!janet_checktype(kv->key, JANET_NIL)) {
-            JanetKV *newkv = janet_table_find(t, kv->key);
+            int32_t hash = janet_hash(kv->key);
+            JanetKV *newkv = janet_table_find_hashed(t, kv->key, hash);
+            janet_table_setctrl(t, (int32_t)(newkv - t->data), janet_ctrl_hash(hash));
             *newkv = *kv;
         }
     }
@@ -182,10 +365,8 @@ Janet janet_table_remove(JanetTable *t, Janet key) {
     JanetKV *bucket = janet_table_find(t, key);
     if (NULL != bucket && !janet_checktype(bucket->key, JANET_NIL)) {
         Janet ret = bucket->value;
-        t->count--;
-        t->deleted++;
-        bucket->key = janet_wrap_nil();
-        bucket->value = janet_wrap_false();
+        t->version++;
+        janet_table_erase(t, bucket);
         return ret;
     } else {
         return janet_wrap_nil();
@@ -199,61 +380,63 @@ void janet_table_put(JanetTable *t, Janet key, Janet value) {
     if (janet_checktype(value, JANET_NIL)) {
         janet_table_remove(t, key);
     } else {
-        JanetKV *bucket = janet_table_find(t, key);
+        int32_t hash = janet_hash(key);
+        JanetKV *bucket = janet_table_find_hashed(t, key, hash);
         if (NULL != bucket && !janet_checktype(bucket->key, JANET_NIL)) {
             bucket->value = value;
+            t->version++;
         } else {
-            if (NULL == bucket || 2 * (t->count + t->deleted + 1) > t->capacity) {
+            if (NULL == bucket || janet_table_full(t)) {
                 janet_table_rehash(t, janet_tablen(2 * t->count + 2));
+                bucket = janet_table_find_hashed(t, key, hash);
             }
-            bucket = janet_table_find(t, key);
-            if (janet_checktype(bucket->value, JANET_BOOLEAN))
-                --t->deleted;
-            bucket->key = key;
-            bucket->value = value;
-            ++t->count;
+            janet_table_fill(t, bucket, key, value, hash);
         }
+        janet_gc_barrier(t);
     }
 }
 
 /* Used internally so don't check arguments
  * Put into a table, but if the key already exists do nothing. */
 static void janet_table_put_no_overwrite(JanetTable *t, Janet key, Janet value) {
-    JanetKV *bucket = janet_table_find(t, key);
+    int32_t hash = janet_hash(key);
+    JanetKV *bucket = janet_table_find_hashed(t, key, hash);
     if (NULL != bucket && !janet_checktype(bucket->key, JANET_NIL))
         return;
-    if (NULL == bucket || 2 * (t->count + t->deleted + 1) > t->capacity) {
+    if (NULL == bucket || janet_table_full(t)) {
         janet_table_rehash(t, janet_tablen(2 * t->count + 2));
+        bucket = janet_table_find_hashed(t, key, hash);
     }
-    bucket = janet_table_find(t, key);
-    if (janet_checktype(bucket->value, JANET_BOOLEAN))
-        --t->deleted;
-    bucket->key = key;
-    bucket->value = value;
-    ++t->count;
+    janet_table_fill(t, bucket, key, value, hash);
+    janet_gc_barrier(t);
 }
 
 /* Clear a table */
 void janet_table_clear(JanetTable *t) {
+    janet_table_materialize(t);
     int32_t capacity = t->capacity;
     JanetKV *data = t->data;
     janet_memempty(data, capacity);
+    if (data) memset(data + capacity, JANET_CTRL_EMPTY, (size_t) capacity + JANET_TABLE_GROUP - 1);
     t->count = 0;
     t->deleted = 0;
+    t->version++;
 }
 
 /* Clone a table. */
 JanetTable *janet_table_clone(JanetTable *table) {
+    janet_table_materialize(table);
     JanetTable *newTable = janet_gcalloc(JANET_MEMORY_TABLE, sizeof(JanetTable));
     newTable->count = table->count;
     newTable->capacity = table->capacity;
     newTable->deleted = table->deleted;
+    newTable->version = 0;
     newTable->proto = table->proto;
-    newTable->data = janet_malloc(newTable->capacity * sizeof(JanetKV));
+    newTable->data = janet_malloc(janet_table_bytes(table->capacity));
     if (NULL == newTable->data) {
         JANET_OUT_OF_MEMORY;
     }
-    memcpy(newTable->data, table->data, (size_t) table->capacity * sizeof(JanetKV));
+    if (table->data) memcpy(newTable->data, table->data, janet_table_bytes(table->capacity));
     return newTable;
 }
 
@@ -270,6 +453,7 @@ static void janet_table_mergekv(JanetTable *table, const JanetKV *kvs, int32_t c
 
 /* Merge a table into another table */
 void janet_table_merge_table(JanetTable *table, JanetTable *other) {
+    janet_table_materialize(other);
     janet_table_mergekv(table, other->data, other->capacity);
 }
 
@@ -280,6 +464,7 @@ void janet_table_merge_struct(JanetTable *table, const JanetKV *other) {
 
 /* Convert table to struct */
 const JanetKV *janet_table_to_struct(JanetTable *t) {
+    janet_table_materialize(t);
     JanetKV *st = janet_struct_begin(t->count);
     JanetKV *kv = t->data;
     JanetKV *end = t->data + t->capacity;
@@ -294,6 +479,7 @@ const JanetKV *janet_table_to_struct(JanetTable *t) {
 JanetTable *janet_table_proto_flatten(JanetTable *t) {
     JanetTable *newTable = janet_table(0);
     while (t) {
+        janet_table_materialize(t);
         JanetKV *kv = t->data;
         JanetKV *end = t->data + t->capacity;
         while (kv < end) {
@@ -368,6 +554,8 @@ JANET_CORE_FN(cfun_table_setproto,
         proto = janet_gettable(argv, 1);
     }
     table->proto = proto;
+    table->version++;
+    janet_gc_barrier(table);
     return argv[0];
 }
 
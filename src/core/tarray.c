@@ -0,0 +1,307 @@
+/*
+* Copyright (c) 2025 Calvin Rose & contributors
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef JANET_AMALG
+#include "features.h"
+#include <janet.h>
+#include "util.h"
+#endif
+
+#include <string.h>
+
+/* Conditional compilation */
+#ifdef JANET_TYPED_ARRAY
+
+static const char *const tarray_type_names[] = {
+    "u8", "s8", "u16", "s16", "u32", "s32", "f32", "f64"
+};
+
+static const size_t tarray_type_sizes[] = {
+    1, 1, 2, 2, 4, 4, 4, 8
+};
+
+#define TARRAY_NTYPES ((int32_t)(sizeof(tarray_type_sizes) / sizeof(size_t)))
+
+static size_t tarray_bytes(JanetTArrayType type, int32_t count) {
+    size_t elsize = tarray_type_sizes[type];
+    if ((size_t) count > (SIZE_MAX - sizeof(JanetTArray)) / elsize) {
+        janet_panic("typed array too large");
+    }
+    return elsize * (size_t) count;
+}
+
+/* Elements are stored right after the header */
+static void tarray_init(JanetTArray *ta, JanetTArrayType type, int32_t count) {
+    ta->type = type;
+    ta->count = count;
+    ta->as.pointer = (uint8_t *) ta + sizeof(JanetTArray);
+}
+
+JanetTArray *janet_tarray(JanetTArrayType type, int32_t count) {
+    size_t size = tarray_bytes(type, count);
+    JanetTArray *ta = janet_abstract(&janet_tarray_type, sizeof(JanetTArray) + size);
+    tarray_init(ta, type, count);
+    memset(ta->as.pointer, 0, size);
+    return ta;
+}
+
+JanetTArray *janet_gettarray(const Janet *argv, int32_t n) {
+    return (JanetTArray *) janet_getabstract(argv, n, &janet_tarray_type);
+}
+
+Janet janet_tarray_get(JanetTArray *ta, int32_t index) {
+    switch (ta->type) {
+        default:
+        case JANET_TARRAY_U8:
+            return janet_wrap_number(ta->as.u8[index]);
+        case JANET_TARRAY_S8:
+            return janet_wrap_number(ta->as.s8[index]);
+        case JANET_TARRAY_U16:
+            return janet_wrap_number(ta->as.u16[index]);
+        case JANET_TARRAY_S16:
+            return janet_wrap_number(ta->as.s16[index]);
+        case JANET_TARRAY_U32:
+            return janet_wrap_number(ta->as.u32[index]);
+        case JANET_TARRAY_S32:
+            return janet_wrap_number(ta->as.s32[index]);
+        case JANET_TARRAY_F32:
+            return janet_wrap_number(ta->as.f32[index]);
+        case JANET_TARRAY_F64:
+            return janet_wrap_number(ta->as.f64[index]);
+    }
+}
+
+/* Integer types wrap around like C unsigned conversion. Values that do not fit in
+ * an int64, including NaN, store 0 rather than invoking undefined behavior. */
+void janet_tarray_set(JanetTArray *ta, int32_t index, double x) {
+    int64_t i = 0;
+    if (ta->type == JANET_TARRAY_F64) {
+        ta->as.f64[index] = x;
+        return;
+    }
+    if (ta->type == JANET_TARRAY_F32) {
+        ta->as.f32[index] = (float) x;
+        return;
+    }
+    if (x > -9223372036854775808.0 && x < 9223372036854775808.0) {
+        i = (int64_t) x;
+    }
+    switch (ta->type) {
+        default:
+        case JANET_TARRAY_U8:
+        case JANET_TARRAY_S8:
+            ta->as.u8[index] = (uint8_t) i;
+            break;
+        case JANET_TARRAY_U16:
+        case JANET_TARRAY_S16:
+            ta->as.u16[index] = (uint16_t) i;
+            break;
+        case JANET_TARRAY_U32:
+        case JANET_TARRAY_S32:
+            ta->as.u32[index] = (uint32_t) i;
+            break;
+    }
+}
+
+static int ta_get(void *p, Janet key, Janet *out) {
+    JanetTArray *ta = (JanetTArray *) p;
+    if (!janet_checkint(key)) return 0;
+    int32_t index = janet_unwrap_integer(key);
+    if (index < 0 || index >= ta->count) return 0;
+    *out = janet_tarray_get(ta, index);
+    return 1;
+}
+
+static void ta_put(void *p, Janet key, Janet value) {
+    JanetTArray *ta = (JanetTArray *) p;
+    if (!janet_checkint(key)) janet_panicf("expected integer key, got %v", key);
+    int32_t index = janet_unwrap_integer(key);
+    if (index < 0 || index >= ta->count) janet_panicf("index %d out of range [0, %d)", index, ta->count);
+    if (!janet_checktype(value, JANET_NUMBER)) janet_panicf("expected number value, got %v", value);
+    janet_tarray_set(ta, index, janet_unwrap_number(value));
+}
+
+/* Marshalled as the element type, the count, and then the raw elements in native byte order */
+static void ta_marshal(void *p, JanetMarshalContext *ctx) {
+    JanetTArray *ta = (JanetTArray *) p;
+    janet_marshal_abstract(ctx, p);
+    janet_marshal_int(ctx, (int32_t) ta->type);
+    janet_marshal_int(ctx, ta->count);
+    janet_marshal_bytes(ctx, ta->as.u8, tarray_bytes(ta->type, ta->count));
+}
+
+static void *ta_unmarshal(JanetMarshalContext *ctx) {
+    int32_t type = janet_unmarshal_int(ctx);
+    if (type < 0 || type >= TARRAY_NTYPES) janet_panic("invalid typed array type");
+    int32_t count = janet_unmarshal_int(ctx);
+    if (count < 0) janet_panic("invalid typed array length");
+    size_t size = tarray_bytes((JanetTArrayType) type, count);
+    janet_unmarshal_ensure(ctx, size);
+    JanetTArray *ta = janet_unmarshal_abstract(ctx, sizeof(JanetTArray) + size);
+    tarray_init(ta, (JanetTArrayType) type, count);
+    janet_unmarshal_bytes(ctx, ta->as.u8, size);
+    return ta;
+}
+
+static void ta_tostring(void *p, JanetBuffer *buffer) {
+    JanetTArray *ta = (JanetTArray *) p;
+    janet_formatb(buffer, "%s [", tarray_type_names[ta->type]);
+    int32_t n = ta->count > 8 ? 8 : ta->count;
+    for (int32_t i = 0; i < n; i++) {
+        if (i) janet_buffer_push_u8(buffer, ' ');
+        janet_formatb(buffer, "%.17g", janet_unwrap_number(janet_tarray_get(ta, i)));
+    }
+    if (n < ta->count) janet_buffer_push_cstring(buffer, " ...");
+    janet_buffer_push_u8(buffer, ']');
+}
+
+static Janet ta_next(void *p, Janet key) {
+    JanetTArray *ta = (JanetTArray *) p;
+    int32_t index = 0;
+    if (!janet_checktype(key, JANET_NIL)) {
+        if (!janet_checkint(key)) janet_panicf("expected integer key, got %v", key);
+        index = janet_unwrap_integer(key) + 1;
+    }
+    if (index < 0 || index >= ta->count) return janet_wrap_nil();
+    return janet_wrap_integer(index);
+}
+
+static size_t ta_length(void *p, size_t len) {
+    (void) len;
+    return (size_t)((JanetTArray *) p)->count;
+}
+
+static JanetByteView ta_bytes(void *p, size_t len) {
+    (void) len;
+    JanetTArray *ta = (JanetTArray *) p;
+    JanetByteView view;
+    view.bytes = ta->as.u8;
+    view.len = (int32_t) tarray_bytes(ta->type, ta->count);
+    return view;
+}
+
+const JanetAbstractType janet_tarray_type = {
+    "core/tarray",
+    NULL,
+    NULL,
+    ta_get,
+    ta_put,
+    ta_marshal,
+    ta_unmarshal,
+    ta_tostring,
+    NULL,
+    NULL,
+    ta_next,
+    NULL,
+    ta_length,
+    ta_bytes,
+    JANET_ATEND_BYTES
+};
+
+static JanetTArrayType tarray_gettype(const Janet *argv, int32_t n) {
+    JanetKeyword name = janet_getkeyword(argv, n);
+    for (int32_t i = 0; i < TARRAY_NTYPES; i++) {
+        if (!janet_cstrcmp(name, tarray_type_names[i])) return (JanetTArrayType) i;
+    }
+    janet_panicf("expected typed array type, got %v", argv[n]);
+}
+
+JANET_CORE_FN(cfun_tarray_new,
+              "(tarray/new type count)",
+              "Create a typed array of `count` zeros. A typed array stores numbers unboxed, "
+              "as one of the element types :u8, :s8, :u16, :s16, :u32, :s32, :f32, or :f64. "
+              "Typed arrays work with `get`, `put`, `in`, `length`, and `each` like other indexed "
+              "types, but their length is fixed. Storing a number in an integer typed array "
+              "truncates it and wraps it to the range of the element type.") {
+    janet_fixarity(argc, 2);
+    JanetTArrayType type = tarray_gettype(argv, 0);
+    int32_t count = janet_getnat(argv, 1);
+    return janet_wrap_abstract(janet_tarray(type, count));
+}
+
+JANET_CORE_FN(cfun_tarray_from,
+              "(tarray/from type xs)",
+              "Create a typed array with the elements of the indexed data structure `xs`, "
+              "which must all be numbers.") {
+    janet_fixarity(argc, 2);
+    JanetTArrayType type = tarray_gettype(argv, 0);
+    JanetView view = janet_getindexed(argv, 1);
+    JanetTArray *ta = janet_tarray(type, view.len);
+    for (int32_t i = 0; i < view.len; i++) {
+        if (!janet_checktype(view.items[i], JANET_NUMBER)) {
+            janet_panicf("expected number, got %v", view.items[i]);
+        }
+        janet_tarray_set(ta, i, janet_unwrap_number(view.items[i]));
+    }
+    return janet_wrap_abstract(ta);
+}
+
+JANET_CORE_FN(cfun_tarray_type,
+              "(tarray/type tarr)",
+              "Get the element type of a typed array as a keyword.") {
+    janet_fixarity(argc, 1);
+    JanetTArray *ta = janet_gettarray(argv, 0);
+    return janet_ckeywordv(tarray_type_names[ta->type]);
+}
+
+JANET_CORE_FN(cfun_tarray_slice,
+              "(tarray/slice tarr &opt start end)",
+              "Copy part of a typed array into a new typed array of the same type. `start` "
+              "and `end` work as they do for `array/slice`.") {
+    JanetRange range = janet_getslice(argc, argv);
+    JanetTArray *ta = janet_gettarray(argv, 0);
+    if (range.end > ta->count) range.end = ta->count;
+    int32_t count = range.end > range.start ? range.end - range.start : 0;
+    JanetTArray *out = janet_tarray(ta->type, count);
+    size_t elsize = tarray_type_sizes[ta->type];
+    memcpy(out->as.u8, ta->as.u8 + elsize * (size_t) range.start, elsize * (size_t) count);
+    return janet_wrap_abstract(out);
+}
+
+JANET_CORE_FN(cfun_tarray_to_array,
+              "(tarray/to-array tarr)",
+              "Create a new array with the elements of a typed array.") {
+    janet_fixarity(argc, 1);
+    JanetTArray *ta = janet_gettarray(argv, 0);
+    JanetArray *array = janet_array(ta->count);
+    for (int32_t i = 0; i < ta->count; i++) {
+        array->data[i] = janet_tarray_get(ta, i);
+    }
+    array->count = ta->count;
+    return janet_wrap_array(array);
+}
+
+/* Module entry point */
+void janet_lib_tarray(JanetTable *env) {
+    JanetRegExt tarray_cfuns[] = {
+        JANET_CORE_REG("tarray/new", cfun_tarray_new),
+        JANET_CORE_REG("tarray/from", cfun_tarray_from),
+        JANET_CORE_REG("tarray/type", cfun_tarray_type),
+        JANET_CORE_REG("tarray/slice", cfun_tarray_slice),
+        JANET_CORE_REG("tarray/to-array", cfun_tarray_to_array),
+        JANET_REG_END
+    };
+    janet_core_cfuns_ext(env, NULL, tarray_cfuns);
+    janet_register_abstract_type(&janet_tarray_type);
+}
+
+#endif
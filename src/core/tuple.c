@@ -53,6 +53,11 @@ const Janet *janet_tuple_n(const Janet *values, int32_t n) {
     return janet_tuple_end(t);
 }
 
+/* Get the canonical copy of a tuple, see tuple/intern */
+const Janet *janet_tuple_intern(const Janet *tuple) {
+    return janet_unwrap_tuple(janet_intern(janet_wrap_tuple(tuple)));
+}
+
 /* C Functions */
 
 JANET_CORE_FN(cfun_tuple_brackets,
@@ -77,6 +82,16 @@ JANET_CORE_FN(cfun_tuple_slice,
     return janet_wrap_tuple(janet_tuple_n(view.items + range.start, range.end - range.start));
 }
 
+JANET_CORE_FN(cfun_tuple_intern,
+              "(tuple/intern tup)",
+              "Return a tuple equal to `tup` that is shared by all calls to `tuple/intern` "
+              "with equal tuples, like `struct/intern`. Bracketed and non-bracketed tuples "
+              "are never equal, so they are interned separately. Interned tuples share a "
+              "single source mapping.") {
+    janet_fixarity(argc, 1);
+    return janet_wrap_tuple(janet_tuple_intern(janet_gettuple(argv, 0)));
+}
+
 JANET_CORE_FN(cfun_tuple_type,
               "(tuple/type tup)",
               "Checks how the tuple was constructed. Will return the keyword "
@@ -149,6 +164,7 @@ void janet_lib_tuple(JanetTable *env) {
     JanetRegExt tuple_cfuns[] = {
         JANET_CORE_REG("tuple/brackets", cfun_tuple_brackets),
         JANET_CORE_REG("tuple/slice", cfun_tuple_slice),
+        JANET_CORE_REG("tuple/intern", cfun_tuple_intern),
         JANET_CORE_REG("tuple/type", cfun_tuple_type),
         JANET_CORE_REG("tuple/sourcemap", cfun_tuple_sourcemap),
         JANET_CORE_REG("tuple/setmap", cfun_tuple_setmap),
@@ -49,6 +49,18 @@
 #include <AvailabilityMacros.h>
 #endif
 
+#if defined(JANET_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(JANET_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(JANET_FFI_JIT) || defined(JANET_JIT)
+#ifndef JANET_WINDOWS
+#include <sys/mman.h>
+#endif
+#endif
+
 #include <inttypes.h>
 
 /* Base 64 lookup table for digits */
@@ -124,14 +136,103 @@ uint32_t janet_hash_mix(uint32_t input, uint32_t more) {
 
 #ifndef JANET_PRF
 
+/*
+  Public domain wyhash implementation sourced from:
+
+  https://github.com/wangyi-fudan/wyhash (final version 4)
+
+  We have made a few alterations, such as fixing the seed and secret,
+  folding the output to 32 bits, and removing the configuration options.
+  Strings are read 8 bytes at a time, and strings over 48 bytes are mixed in
+  three independent lanes.
+*/
+
+static void wymum(uint64_t *a, uint64_t *b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)(*a), lb = (uint32_t)(*b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t wymix(uint64_t a, uint64_t b) {
+    wymum(&a, &b);
+    return a ^ b;
+}
+
+static uint64_t wyr8(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static uint64_t wyr4(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint64_t wyr3(const uint8_t *p, size_t k) {
+    return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+static const uint64_t wyp[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+    0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+static uint64_t wyhash(const uint8_t *p, size_t len) {
+    uint64_t seed = wymix(wyp[0], wyp[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+            b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wyr3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+                see1 = wymix(wyr8(p + 16) ^ wyp[2], wyr8(p + 24) ^ see1);
+                see2 = wymix(wyr8(p + 32) ^ wyp[3], wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyr8(p + i - 16);
+        b = wyr8(p + i - 8);
+    }
+    a ^= wyp[1];
+    b ^= seed;
+    wymum(&a, &b);
+    return wymix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
 int32_t janet_string_calchash(const uint8_t *str, int32_t len) {
-    if (NULL == str || len == 0) return 5381;
-    const uint8_t *end = str + len;
-    uint32_t hash = 5381;
-    while (str < end)
-        hash = (hash << 5) + hash + *str++;
-    hash = janet_hash_mix(hash, (uint32_t) len);
-    return (int32_t) hash;
+    uint64_t hash = wyhash(str, (NULL == str || len < 0) ? 0 : (size_t) len);
+    return (int32_t)(uint32_t)(hash ^ (hash >> 32));
 }
 
 #else
@@ -788,6 +889,7 @@ int janet_bytes_view(Janet str, const uint8_t **data, int32_t *len) {
  * 0 if the type is invalid. */
 int janet_dictionary_view(Janet tab, const JanetKV **data, int32_t *len, int32_t *cap) {
     if (janet_checktype(tab, JANET_TABLE)) {
+        janet_table_materialize(janet_unwrap_table(tab));
         *data = janet_unwrap_table(tab)->data;
         *cap = janet_unwrap_table(tab)->capacity;
         *len = janet_unwrap_table(tab)->count;
@@ -896,6 +998,143 @@ int32_t janet_sorted_keys(const JanetKV *dict, int32_t cap, int32_t *index_buffe
 
 }
 
+/* Byte sets. Small sets are also kept as a list so that spans can compare
+ * 16 bytes at a time against every member. */
+void janet_byteset_init(JanetByteSet *set, const uint8_t *bytes, int32_t len) {
+    memset(set->bits, 0, sizeof(set->bits));
+    set->count = 0;
+    for (int32_t i = 0; i < len; i++) {
+        uint8_t c = bytes[i];
+        if (janet_byteset_has(set, c)) continue;
+        set->bits[c >> 5] |= (uint32_t) 1 << (c & 0x1F);
+        if (set->count < (int32_t) sizeof(set->bytes)) set->bytes[set->count] = c;
+        set->count++;
+    }
+}
+
+/* Get the length of the longest prefix of bytes that are all in the set */
+int32_t janet_byteset_span(const JanetByteSet *set, const uint8_t *bytes, int32_t len) {
+    int32_t i = 0;
+#if defined(JANET_SIMD_SSE2)
+    if (set->count > 0 && set->count <= (int32_t) sizeof(set->bytes)) {
+        __m128i members[sizeof(set->bytes)];
+        for (int32_t k = 0; k < set->count; k++) {
+            members[k] = _mm_set1_epi8((char) set->bytes[k]);
+        }
+        for (; i + 16 <= len; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(bytes + i));
+            __m128i hit = _mm_cmpeq_epi8(x, members[0]);
+            for (int32_t k = 1; k < set->count; k++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(x, members[k]));
+            }
+            if (_mm_movemask_epi8(hit) != 0xFFFF) break;
+        }
+    }
+#elif defined(JANET_SIMD_NEON)
+    if (set->count > 0 && set->count <= (int32_t) sizeof(set->bytes)) {
+        uint8x16_t members[sizeof(set->bytes)];
+        for (int32_t k = 0; k < set->count; k++) {
+            members[k] = vdupq_n_u8(set->bytes[k]);
+        }
+        for (; i + 16 <= len; i += 16) {
+            uint8x16_t x = vld1q_u8(bytes + i);
+            uint8x16_t hit = vceqq_u8(x, members[0]);
+            for (int32_t k = 1; k < set->count; k++) {
+                hit = vorrq_u8(hit, vceqq_u8(x, members[k]));
+            }
+            if (vminvq_u8(hit) != 0xFF) break;
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (!janet_byteset_has(set, bytes[i])) return i;
+    }
+    return len;
+}
+
+/* Get the length of the longest suffix of bytes that are all in the set */
+int32_t janet_byteset_rspan(const JanetByteSet *set, const uint8_t *bytes, int32_t len) {
+    int32_t i = len;
+    while (i > 0 && janet_byteset_has(set, bytes[i - 1])) i--;
+    return len - i;
+}
+
+/* Get the length of the longest prefix of bytes that has no bytes in the set */
+int32_t janet_byteset_cspan(const JanetByteSet *set, const uint8_t *bytes, int32_t len) {
+    int32_t i = 0;
+    if (set->count == 1) {
+        const uint8_t *hit = memchr(bytes, set->bytes[0], (size_t) len);
+        return hit ? (int32_t)(hit - bytes) : len;
+    }
+#if defined(JANET_SIMD_SSE2)
+    if (set->count > 0 && set->count <= (int32_t) sizeof(set->bytes)) {
+        __m128i members[sizeof(set->bytes)];
+        for (int32_t k = 0; k < set->count; k++) {
+            members[k] = _mm_set1_epi8((char) set->bytes[k]);
+        }
+        for (; i + 16 <= len; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(bytes + i));
+            __m128i hit = _mm_cmpeq_epi8(x, members[0]);
+            for (int32_t k = 1; k < set->count; k++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(x, members[k]));
+            }
+            if (_mm_movemask_epi8(hit) != 0) break;
+        }
+    }
+#elif defined(JANET_SIMD_NEON)
+    if (set->count > 0 && set->count <= (int32_t) sizeof(set->bytes)) {
+        uint8x16_t members[sizeof(set->bytes)];
+        for (int32_t k = 0; k < set->count; k++) {
+            members[k] = vdupq_n_u8(set->bytes[k]);
+        }
+        for (; i + 16 <= len; i += 16) {
+            uint8x16_t x = vld1q_u8(bytes + i);
+            uint8x16_t hit = vceqq_u8(x, members[0]);
+            for (int32_t k = 1; k < set->count; k++) {
+                hit = vorrq_u8(hit, vceqq_u8(x, members[k]));
+            }
+            if (vmaxvq_u8(hit) != 0) break;
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (janet_byteset_has(set, bytes[i])) return i;
+    }
+    return len;
+}
+
+/* Convert ASCII letters to upper or lower case. Other bytes are copied as is. */
+void janet_ascii_case(uint8_t *dest, const uint8_t *src, int32_t len, int upper) {
+    uint8_t first = upper ? 'a' : 'A';
+    int32_t i = 0;
+#if defined(JANET_SIMD_SSE2)
+    /* Move the letters to the bottom of the signed range with one add, so
+     * that a single signed compare finds them. */
+    const __m128i shift = _mm_set1_epi8((char)(0x80 - first));
+    const __m128i limit = _mm_set1_epi8((char)(-128 + 26));
+    const __m128i flip = _mm_set1_epi8(0x20);
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i letters = _mm_cmplt_epi8(_mm_add_epi8(x, shift), limit);
+        x = _mm_xor_si128(x, _mm_and_si128(letters, flip));
+        _mm_storeu_si128((__m128i *)(dest + i), x);
+    }
+#elif defined(JANET_SIMD_NEON)
+    const uint8x16_t base = vdupq_n_u8(first);
+    const uint8x16_t limit = vdupq_n_u8(26);
+    const uint8x16_t flip = vdupq_n_u8(0x20);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t x = vld1q_u8(src + i);
+        uint8x16_t letters = vcltq_u8(vsubq_u8(x, base), limit);
+        vst1q_u8(dest + i, veorq_u8(x, vandq_u8(letters, flip)));
+    }
+#endif
+    for (; i < len; i++) {
+        uint8_t c = src[i];
+        dest[i] = ((uint8_t)(c - first) < 26) ? (c ^ 0x20) : c;
+    }
+}
+
 /* Clock shims for various platforms */
 #ifdef JANET_GETTIME
 #ifdef JANET_WINDOWS
@@ -1109,6 +1348,58 @@ void *symbol_clib(HINSTANCE clib, const char *sym) {
 #endif
 #endif
 
+#if defined(JANET_FFI_JIT) || defined(JANET_JIT)
+
+/* Copy machine code into freshly mapped, read-only executable pages. Returns
+ * NULL on failure. Ideally we would keep an allocator around so that multiple
+ * allocations would share a region, but it isn't really worth it. */
+void *janet_exec_map(const void *code, size_t len, size_t *alloc_size) {
+    /* Quick hack to align to page boundary, we should query OS. FIXME */
+    size_t size = (len + 0xFFF) & ~((size_t) 0xFFF);
+#ifdef JANET_WINDOWS
+    void *ptr = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (NULL == ptr) return NULL;
+#else
+#if defined(MAP_ANONYMOUS)
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#elif defined(MAP_ANON)
+    /* macos doesn't have MAP_ANONYMOUS */
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+#else
+    /* -std=c99 gets in the way */
+    /* #define MAP_ANONYMOUS 0x20 should work, though. */
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, -1, 0);
+#endif
+    if (MAP_FAILED == ptr) return NULL;
+#endif
+    memcpy(ptr, code, len);
+#ifdef JANET_WINDOWS
+    DWORD old = 0;
+    if (!VirtualProtect(ptr, size, PAGE_EXECUTE_READ, &old)) {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+        return NULL;
+    }
+#else
+    if (mprotect(ptr, size, PROT_READ | PROT_EXEC) == -1) {
+        munmap(ptr, size);
+        return NULL;
+    }
+#endif
+    *alloc_size = size;
+    return ptr;
+}
+
+void janet_exec_unmap(void *ptr, size_t alloc_size) {
+#ifdef JANET_WINDOWS
+    (void) alloc_size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, alloc_size);
+#endif
+}
+
+#endif
+
 /* Alloc function macro fills */
 void *(janet_malloc)(size_t size) {
     return janet_malloc(size);
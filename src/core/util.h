@@ -79,8 +79,12 @@ void janet_buffer_push_types(JanetBuffer *buffer, int types);
 const JanetKV *janet_dict_find(const JanetKV *buckets, int32_t cap, Janet key);
 void janet_memempty(JanetKV *mem, int32_t count);
 void *janet_memalloc_empty(int32_t count);
+void janet_table_erase(JanetTable *t, JanetKV *bucket);
 JanetTable *janet_get_core_table(const char *name);
 void janet_def_addflags(JanetFuncDef *def);
+int32_t janet_switch_length(JanetFuncDef *def, uint32_t instr);
+#define JANET_DTOA_SIZE 32
+int janet_dtoa(double x, uint8_t *out);
 void janet_buffer_dtostr(JanetBuffer *buffer, double x);
 const char *janet_strerror(int e);
 const void *janet_strbinsearch(
@@ -95,6 +99,16 @@ void janet_buffer_format(
     int32_t argc,
     Janet *argv);
 Janet janet_next_impl(Janet ds, Janet key, int is_interpreter);
+Janet janet_intern(Janet x);
+
+/* janet_equals and janet_compare keep pending work in janet_vm.traversal.
+ * Abstract compare functions that call them save and restore it. */
+typedef struct {
+    JanetTraversalNode *nodes;
+    size_t depth;
+} JanetTraversalState;
+void janet_traversal_save(JanetTraversalState *state);
+void janet_traversal_restore(JanetTraversalState *state);
 JanetBinding janet_binding_from_entry(Janet entry);
 JanetByteView janet_text_substitution(
     Janet *subst,
@@ -127,6 +141,21 @@ void janet_core_def_sm(JanetTable *env, const char *name, Janet x, const void *p
 void janet_core_cfuns_ext(JanetTable *env, const char *regprefix, const JanetRegExt *cfuns);
 #endif
 
+/* Tables of the core environment that are filled in from the core image on
+ * demand. Anything that walks the buckets of a table, or reads its count,
+ * should call janet_table_materialize first. (table.c uses 0x10000 for
+ * tables in scratch memory.) */
+#define JANET_TABLE_FLAG_LAZY 0x20000
+#ifdef JANET_BOOTSTRAP
+#define janet_table_materialize(t) ((void) (t))
+#else
+int janet_core_lazy_load(JanetTable *t, Janet key);
+void janet_core_lazy_load_all(void);
+#define janet_table_materialize(t) do { \
+    if ((t)->gc.flags & JANET_TABLE_FLAG_LAZY) janet_core_lazy_load_all(); \
+} while (0)
+#endif
+
 /* Clock gettime */
 #ifdef JANET_GETTIME
 enum JanetTimeSource {
@@ -169,6 +198,27 @@ char *get_processed_name(const char *name);
 
 #define RETRY_EINTR(RC, CALL) do { (RC) = CALL; } while((RC) < 0 && errno == EINTR)
 
+/* Byte kernels for the string and buffer modules. Every x86-64 and aarch64
+ * target has SSE2 or NEON, so these are chosen at compile time. */
+#ifndef JANET_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JANET_SIMD_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define JANET_SIMD_NEON
+#endif
+#endif
+typedef struct {
+    uint32_t bits[8];
+    int32_t count; /* Number of distinct bytes in the set */
+    uint8_t bytes[8]; /* The distinct bytes, if there are at most 8 */
+} JanetByteSet;
+void janet_byteset_init(JanetByteSet *set, const uint8_t *bytes, int32_t len);
+#define janet_byteset_has(set, c) ((set)->bits[(c) >> 5] & ((uint32_t) 1 << ((c) & 0x1F)))
+int32_t janet_byteset_span(const JanetByteSet *set, const uint8_t *bytes, int32_t len);
+int32_t janet_byteset_rspan(const JanetByteSet *set, const uint8_t *bytes, int32_t len);
+int32_t janet_byteset_cspan(const JanetByteSet *set, const uint8_t *bytes, int32_t len);
+void janet_ascii_case(uint8_t *dest, const uint8_t *src, int32_t len, int upper);
+
 /* Initialize builtin libraries */
 void janet_lib_io(JanetTable *env);
 void janet_lib_math(JanetTable *env);
@@ -192,16 +242,32 @@ void janet_lib_peg(JanetTable *env);
 #endif
 #ifdef JANET_INT_TYPES
 void janet_lib_inttypes(JanetTable *env);
+int janet_int64_binop(int op, Janet lhs, Janet rhs, Janet *out);
+#endif
+#ifdef JANET_TYPED_ARRAY
+void janet_lib_tarray(JanetTable *env);
+#endif
+#ifdef JANET_PERSISTENT
+void janet_lib_persistent(JanetTable *env);
+#endif
+#ifdef JANET_JSON
+void janet_lib_json(JanetTable *env);
 #endif
 #ifdef JANET_NET
 void janet_lib_net(JanetTable *env);
 extern const JanetAbstractType janet_address_type;
 #endif
+#ifdef JANET_MMAP
+extern const JanetAbstractType janet_mmap_type;
+void janet_mmap_pin(Janet x);
+#endif
 #ifdef JANET_EV
 void janet_lib_ev(JanetTable *env);
+void janet_lib_shared(JanetTable *env);
 void janet_ev_mark(void);
 void janet_async_start_fiber(JanetFiber *fiber, JanetStream *stream, JanetAsyncMode mode, JanetEVCallback callback, void *state);
 int janet_make_pipe(JanetHandle handles[2], int mode);
+void janet_getwritable(const Janet *argv, int32_t n);
 #ifdef JANET_FILEWATCH
 void janet_lib_filewatch(JanetTable *env);
 #endif
@@ -210,4 +276,50 @@ void janet_lib_filewatch(JanetTable *env);
 void janet_lib_ffi(JanetTable *env);
 #endif
 
+/* Executable memory for ffi/jitfn and the baseline JIT */
+#if defined(JANET_FFI_JIT) || defined(JANET_JIT)
+void *janet_exec_map(const void *code, size_t len, size_t *alloc_size);
+void janet_exec_unmap(void *ptr, size_t alloc_size);
+#endif
+
+/* Built in profiler */
+struct JanetFuncProfile {
+    JanetFuncDef *def; /* NULL once the funcdef has been collected */
+    JanetFuncProfile *next;
+    char *name;
+    char *source;
+    int32_t line;
+    uint64_t calls;
+    uint64_t instructions;
+};
+void janet_profile_call(JanetFiber *fiber, JanetFuncDef *def);
+#ifdef JANET_PROFILE
+void janet_profile_step(JanetFiber *fiber, JanetFuncDef *def, uint32_t instr);
+#endif
+void janet_profile_clear(void);
+Janet janet_profile_stack(JanetFiber *fiber);
+
+/* Heap profiler and memory groups */
+#define JANET_HEAP_SAMPLE_INTERVAL (512 * 1024)
+extern const JanetAbstractType janet_memory_group_type;
+void janet_heap_profile_clear(void);
+void janet_heap_profile_deinit(void);
+void janet_memory_limit_check(JanetFiber *fiber);
+#ifdef JANET_ASSEMBLER
+const char *janet_opcode_name(uint32_t opcode);
+#endif
+
+/* Call any callable value the way the VM would */
+Janet janet_method_invoke(Janet method, int32_t argc, Janet *argv);
+
+/* Baseline JIT */
+#ifdef JANET_JIT
+#ifndef JANET_JIT_THRESHOLD
+#define JANET_JIT_THRESHOLD 1000
+#endif
+typedef uint32_t *(*JanetJitFunction)(JanetFiber *fiber, volatile JanetAtomicInt *suspend);
+void janet_jit_compile(JanetFuncDef *def);
+void janet_jit_free(JanetFuncDef *def);
+#endif
+
 #endif
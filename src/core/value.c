@@ -30,6 +30,7 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 static void push_traversal_node(void *lhs, void *rhs, int32_t index2) {
     JanetTraversalNode node;
@@ -55,6 +56,25 @@ static void push_traversal_node(void *lhs, void *rhs, int32_t index2) {
     *(++janet_vm.traversal) = node;
 }
 
+/* Save the nodes pending in an outer janet_equals or janet_compare */
+void janet_traversal_save(JanetTraversalState *state) {
+    state->depth = janet_vm.traversal_base ? (size_t)(janet_vm.traversal - janet_vm.traversal_base) : 0;
+    state->nodes = NULL;
+    if (state->depth) {
+        state->nodes = janet_smalloc(state->depth * sizeof(JanetTraversalNode));
+        memcpy(state->nodes, janet_vm.traversal_base + 1, state->depth * sizeof(JanetTraversalNode));
+    }
+}
+
+/* The traversal stack never shrinks, so the saved nodes always fit back */
+void janet_traversal_restore(JanetTraversalState *state) {
+    if (state->depth) {
+        memcpy(janet_vm.traversal_base + 1, state->nodes, state->depth * sizeof(JanetTraversalNode));
+        janet_vm.traversal = janet_vm.traversal_base + state->depth;
+        janet_sfree(state->nodes);
+    }
+}
+
 /*
  * Used for travsersing structs and tuples without recursion
  * Returns:
@@ -135,20 +155,23 @@ Janet janet_next_impl(Janet ds, Janet key, int is_interpreter) {
         case JANET_TABLE:
         case JANET_STRUCT: {
             const JanetKV *start;
+            const JanetKV *kv;
             int32_t cap;
             if (t == JANET_TABLE) {
                 JanetTable *tab = janet_unwrap_table(ds);
+                janet_table_materialize(tab);
                 cap = tab->capacity;
                 start = tab->data;
+                kv = janet_checktype(key, JANET_NIL) ? start : janet_table_find(tab, key);
             } else {
                 JanetStruct st = janet_unwrap_struct(ds);
                 cap = janet_struct_capacity(st);
                 start = st;
+                kv = janet_checktype(key, JANET_NIL) ? start : janet_dict_find(start, cap, key);
             }
+            if (NULL == kv) break;
+            if (!janet_checktype(key, JANET_NIL)) kv++;
             const JanetKV *end = start + cap;
-            const JanetKV *kv = janet_checktype(key, JANET_NIL)
-                                ? start
-                                : janet_dict_find(start, cap, key) + 1;
             while (kv < end) {
                 if (!janet_checktype(kv->key, JANET_NIL)) return kv->key;
                 kv++;
@@ -268,6 +291,16 @@ int janet_equals(Janet x, Janet y) {
             default:
                 if (janet_unwrap_pointer(x) != janet_unwrap_pointer(y)) return 0;
                 break;
+            case JANET_SYMBOL:
+            case JANET_KEYWORD: {
+                /* Interned, except for frozen copies shared between threads */
+                const uint8_t *s1 = janet_unwrap_string(x);
+                const uint8_t *s2 = janet_unwrap_string(y);
+                if (s1 == s2) break;
+                if (!((janet_string_head(s1)->gc.flags | janet_string_head(s2)->gc.flags) & JANET_MEM_FROZEN)) return 0;
+                if (!janet_string_equal(s1, s2)) return 0;
+                break;
+            }
             case JANET_TUPLE: {
                 const Janet *t1 = janet_unwrap_tuple(x);
                 const Janet *t2 = janet_unwrap_tuple(y);
@@ -305,6 +338,20 @@ static uint64_t murmur64(uint64_t h) {
     return h;
 }
 
+/* Get the canonical copy of an immutable value, adding x as the canonical
+ * copy if there is none yet. The intern table holds its entries weakly, so
+ * values are dropped from it once nothing else references them. */
+Janet janet_intern(Janet x) {
+    if (NULL == janet_vm.intern_table) {
+        janet_vm.intern_table = janet_table_weakkv(0);
+        janet_gcroot(janet_wrap_table(janet_vm.intern_table));
+    }
+    Janet canonical = janet_table_get(janet_vm.intern_table, x);
+    if (!janet_checktype(canonical, JANET_NIL)) return canonical;
+    janet_table_put(janet_vm.intern_table, x, x);
+    return x;
+}
+
 /* Computes a hash value for a function */
 int32_t janet_hash(Janet x) {
     int32_t hash = 0;
@@ -316,9 +363,12 @@ int32_t janet_hash(Janet x) {
             hash = janet_unwrap_boolean(x);
             break;
         case JANET_STRING:
+            hash = janet_string_hash(janet_unwrap_string(x));
+            break;
         case JANET_SYMBOL:
         case JANET_KEYWORD:
-            hash = janet_string_hash(janet_unwrap_string(x));
+            /* Always hashed when interned */
+            hash = janet_string_head(janet_unwrap_string(x))->hash;
             break;
         case JANET_TUPLE:
             hash = janet_tuple_hash(janet_unwrap_tuple(x));
@@ -336,8 +386,16 @@ int32_t janet_hash(Janet x) {
             as.d += 0.0; /* normalize negative 0 */
             uint32_t lo = (uint32_t)(as.u & 0xFFFFFFFF);
             uint32_t hi = (uint32_t)(as.u >> 32);
-            uint32_t hilo = (hi ^ lo) * 2654435769u;
-            hash = (int32_t)((hilo << 16) | (hilo >> 16));
+            /* Small integers only set the high word, so mix every bit into
+             * both the low bits (bucket index) and the high bits (table
+             * control tag). This is the murmur3 finalizer. */
+            uint32_t hilo = hi ^ lo;
+            hilo ^= hilo >> 16;
+            hilo *= 0x85ebca6bu;
+            hilo ^= hilo >> 13;
+            hilo *= 0xc2b2ae35u;
+            hilo ^= hilo >> 16;
+            hash = (int32_t) hilo;
             break;
         }
         case JANET_ABSTRACT: {
@@ -654,8 +712,11 @@ int32_t janet_length(Janet x) {
             return janet_tuple_length(janet_unwrap_tuple(x));
         case JANET_STRUCT:
             return janet_struct_length(janet_unwrap_struct(x));
-        case JANET_TABLE:
-            return janet_unwrap_table(x)->count;
+        case JANET_TABLE: {
+            JanetTable *t = janet_unwrap_table(x);
+            janet_table_materialize(t);
+            return t->count;
+        }
         case JANET_ABSTRACT: {
             void *abst = janet_unwrap_abstract(x);
             const JanetAbstractType *type = janet_abstract_type(abst);
@@ -691,8 +752,11 @@ Janet janet_lengthv(Janet x) {
             return janet_wrap_integer(janet_tuple_length(janet_unwrap_tuple(x)));
         case JANET_STRUCT:
             return janet_wrap_integer(janet_struct_length(janet_unwrap_struct(x)));
-        case JANET_TABLE:
-            return janet_wrap_integer(janet_unwrap_table(x)->count);
+        case JANET_TABLE: {
+            JanetTable *t = janet_unwrap_table(x);
+            janet_table_materialize(t);
+            return janet_wrap_integer(t->count);
+        }
         case JANET_ABSTRACT: {
             void *abst = janet_unwrap_abstract(x);
             const JanetAbstractType *type = janet_abstract_type(abst);
@@ -727,6 +791,7 @@ void janet_putindex(Janet ds, int32_t index, Janet value) {
                 array->count = index + 1;
             }
             array->data[index] = value;
+            janet_gc_barrier(array);
             break;
         }
         case JANET_BUFFER: {
@@ -770,6 +835,7 @@ void janet_put(Janet ds, Janet key, Janet value) {
                 janet_array_setcount(array, index + 1);
             }
             array->data[index] = value;
+            janet_gc_barrier(array);
             break;
         }
         case JANET_BUFFER: {
@@ -62,14 +62,65 @@
 #define VM_END() }
 #define VM_OP(op) label_##op :
 #define VM_DEFAULT() label_unknown_op:
-#define vm_next() goto *op_lookup[*pc & 0xFF]
+#define vm_next() vm_profile(); goto *op_lookup[*pc & 0xFF]
 #define opcode (*pc & 0xFF)
 #else
 #define VM_START() uint8_t opcode = first_opcode; for (;;) {switch(opcode) {
 #define VM_END() }}
 #define VM_OP(op) case op :
 #define VM_DEFAULT() default:
-#define vm_next() opcode = *pc & 0xFF; continue
+#define vm_next() vm_profile(); opcode = *pc & 0xFF; continue
+#endif
+
+/* Count instructions for debug/profile. This costs a check on every
+ * instruction, so it is only compiled in when asked for. */
+#ifdef JANET_PROFILE
+#define vm_profile() do { \
+    if (janet_vm.profiling) janet_profile_step(fiber, func->def, *pc); \
+} while (0)
+#else
+#define vm_profile()
+#endif
+
+/* Typed arrays are indexed directly rather than through their abstract type */
+#ifdef JANET_TYPED_ARRAY
+static JanetTArray *vm_tarray(Janet x) {
+    if (!janet_checktype(x, JANET_ABSTRACT)) return NULL;
+    void *abst = janet_unwrap_abstract(x);
+    return janet_abstract_type(abst) == &janet_tarray_type ? (JanetTArray *) abst : NULL;
+}
+static int vm_tarray_index(JanetTArray *ta, Janet key, int32_t *index) {
+    if (!janet_checkint(key)) return 0;
+    *index = janet_unwrap_integer(key);
+    return *index >= 0 && *index < ta->count;
+}
+#define vm_tarray_get(DS, KEY) { \
+    JanetTArray *_ta = vm_tarray(DS); \
+    int32_t _index; \
+    if (NULL != _ta && vm_tarray_index(_ta, (KEY), &_index)) { \
+        stack[A] = janet_tarray_get(_ta, _index); \
+        vm_pcnext(); \
+    } \
+}
+#define vm_tarray_put(DS, KEY, VALUE) { \
+    JanetTArray *_ta = vm_tarray(DS); \
+    int32_t _index; \
+    if (NULL != _ta && janet_checktype((VALUE), JANET_NUMBER) && vm_tarray_index(_ta, (KEY), &_index)) { \
+        janet_tarray_set(_ta, _index, janet_unwrap_number(VALUE)); \
+        vm_pcnext(); \
+    } \
+}
+#define vm_tarray_length(DS) { \
+    JanetTArray *_ta = vm_tarray(DS); \
+    if (NULL != _ta) { \
+        stack[A] = janet_wrap_integer(_ta->count); \
+        vm_pcnext(); \
+    } \
+}
+#else
+#define vm_tarray_get(DS, KEY)
+#define vm_tarray_put(DS, KEY, VALUE)
+#define vm_tarray_length(DS)
 #endif
 
 /* Commit and restore VM state before possible longjmp */
@@ -96,6 +147,21 @@
 #define vm_pcnext() pc++; vm_next()
 #define vm_checkgc_pcnext() maybe_collect(); vm_pcnext()
 
+/* Enter compiled code for the current function, or count the call towards compiling it */
+#ifdef JANET_JIT
+#define vm_jit_enter() do { \
+    JanetFuncDef *_def = func->def; \
+    if (NULL != _def->jit) { \
+        pc = ((JanetJitFunction) _def->jit)(fiber, &janet_vm.auto_suspend); \
+        stack = fiber->data + fiber->frame; \
+    } else if (_def->jit_calls > 0 && --_def->jit_calls == 0) { \
+        janet_jit_compile(_def); \
+    } \
+} while (0)
+#else
+#define vm_jit_enter()
+#endif
+
 /* Handle certain errors in main vm loop */
 #define vm_throw(e) do { vm_commit(); janet_panic(e); } while (0)
 #define vm_assert(cond, e) do {if (!(cond)) vm_throw((e)); } while (0)
@@ -116,12 +182,25 @@
 #else
 #define vm_maybe_auto_suspend(COND) do { \
     if ((COND) && janet_atomic_load_relaxed(&janet_vm.auto_suspend)) { \
-        fiber->flags |= (JANET_FIBER_RESUME_NO_USEVAL | JANET_FIBER_RESUME_NO_SKIP); \
-        vm_return(JANET_SIGNAL_INTERRUPT, janet_wrap_nil()); \
+        if (NULL != janet_vm.memory_limit_hit) { \
+            vm_commit(); \
+            janet_memory_limit_check(fiber); \
+        } \
+        if (janet_atomic_load_relaxed(&janet_vm.auto_suspend)) { \
+            fiber->flags |= (JANET_FIBER_RESUME_NO_USEVAL | JANET_FIBER_RESUME_NO_SKIP); \
+            vm_return(JANET_SIGNAL_INTERRUPT, janet_wrap_nil()); \
+        } \
     } \
 } while (0)
 #endif
 
+/* Arithmetic and bitwise operators on int/s64 and int/u64 skip method dispatch */
+#ifdef JANET_INT_TYPES
+#define vm_int64_binop(op, lhs, rhs, out) janet_int64_binop((#op)[0], (lhs), (rhs), (out))
+#else
+#define vm_int64_binop(op, lhs, rhs, out) 0
+#endif
+
 /* Templates for certain patterns in opcodes */
 #define vm_binop_immediate(op)\
     {\
@@ -129,7 +208,8 @@
         if (!janet_checktype(op1, JANET_NUMBER)) {\
             vm_commit();\
             Janet _argv[2] = { op1, janet_wrap_number(CS) };\
-            stack[A] = janet_mcall(#op, 2, _argv);\
+            if (!vm_int64_binop(op, op1, _argv[1], &stack[A]))\
+                stack[A] = janet_mcall(#op, 2, _argv);\
             vm_checkgc_pcnext();\
         } else {\
             double x1 = janet_unwrap_number(op1);\
@@ -143,7 +223,8 @@
         if (!janet_checktype(op1, JANET_NUMBER)) {\
             vm_commit();\
             Janet _argv[2] = { op1, janet_wrap_number(CS) };\
-            stack[A] = janet_mcall(#op, 2, _argv);\
+            if (!vm_int64_binop(op, op1, _argv[1], &stack[A]))\
+                stack[A] = janet_mcall(#op, 2, _argv);\
             vm_checkgc_pcnext();\
         } else {\
             double y1 = janet_unwrap_number(op1);\
@@ -166,7 +247,8 @@
             vm_pcnext();\
         } else {\
             vm_commit();\
-            stack[A] = janet_binop_call(#op, "r" #op, op1, op2);\
+            if (!vm_int64_binop(op, op1, op2, &stack[A]))\
+                stack[A] = janet_binop_call(#op, "r" #op, op1, op2);\
             vm_checkgc_pcnext();\
         }\
     }
@@ -186,7 +268,8 @@
             vm_pcnext();\
         } else {\
             vm_commit();\
-            stack[A] = janet_binop_call(#op, "r" #op, op1, op2);\
+            if (!vm_int64_binop(op, op1, op2, &stack[A]))\
+                stack[A] = janet_binop_call(#op, "r" #op, op1, op2);\
             vm_checkgc_pcnext();\
         }\
     }
@@ -222,6 +305,50 @@
         }\
     }
 
+/* Superinstructions run the first half of their pair, then continue with the
+ * second instruction without going through dispatch. If the second instruction
+ * has a breakpoint, dispatch to it normally instead. */
+#define vm_fuse_next() pc++; if (*pc & 0x80) { vm_next(); }
+#define vm_jump_if_not() \
+    if (janet_truthy(stack[A])) {\
+        pc++;\
+    } else {\
+        vm_maybe_auto_suspend(ES <= 0);\
+        pc += ES;\
+    }\
+    vm_next()
+#define vm_compop_jump(op) \
+    {\
+        Janet op1 = stack[B];\
+        Janet op2 = stack[C];\
+        if (janet_checktype(op1, JANET_NUMBER) && janet_checktype(op2, JANET_NUMBER)) {\
+            double x1 = janet_unwrap_number(op1);\
+            double x2 = janet_unwrap_number(op2);\
+            stack[A] = janet_wrap_boolean(x1 op x2);\
+        } else {\
+            vm_commit();\
+            stack[A] = janet_wrap_boolean(janet_compare(op1, op2) op 0);\
+            maybe_collect();\
+        }\
+        vm_fuse_next();\
+        vm_jump_if_not();\
+    }
+#define vm_compop_imm_jump(op) \
+    {\
+        Janet op1 = stack[B];\
+        if (janet_checktype(op1, JANET_NUMBER)) {\
+            double x1 = janet_unwrap_number(op1);\
+            double x2 = (double) CS; \
+            stack[A] = janet_wrap_boolean(x1 op x2);\
+        } else {\
+            vm_commit();\
+            stack[A] = janet_wrap_boolean(janet_compare(op1, janet_wrap_integer(CS)) op 0);\
+            maybe_collect();\
+        }\
+        vm_fuse_next();\
+        vm_jump_if_not();\
+    }
+
 /* Trace a function call */
 static void vm_do_trace(JanetFunction *func, int32_t argc, const Janet *argv) {
     if (func->def->name) {
@@ -236,7 +363,7 @@ static void vm_do_trace(JanetFunction *func, int32_t argc, const Janet *argv) {
 }
 
 /* Invoke a method once we have looked it up */
-static Janet janet_method_invoke(Janet method, int32_t argc, Janet *argv) {
+Janet janet_method_invoke(Janet method, int32_t argc, Janet *argv) {
     switch (janet_type(method)) {
         case JANET_CFUNCTION:
             return (janet_unwrap_cfunction(method))(argc, argv);
@@ -285,11 +412,121 @@ static Janet method_to_fun(Janet method, Janet obj) {
     return janet_get(obj, method);
 }
 
+/* Inline caches for keyword lookups on tables and structs. Every JOP_CALL,
+ * JOP_TAILCALL, and JOP_GET instruction in a funcdef gets one monomorphic
+ * entry, keyed on the identity of the receiver and the versions of each
+ * table on the prototype chain up to the table that held the key. Entries
+ * do not keep anything alive, so they are only trusted for the gc epoch in
+ * which they were filled. */
+#define JANET_METHOD_CACHE_DEPTH 4
+
+typedef struct {
+    const void *receiver;
+    const uint8_t *name;
+    Janet value;
+    uint32_t epoch;
+    int32_t depth;
+    uint32_t versions[JANET_METHOD_CACHE_DEPTH];
+} JanetMethodCacheEntry;
+
+struct JanetMethodCache {
+    JanetMethodCacheEntry *entries;
+    int32_t *slots; /* Entry index for each instruction, or -1 */
+};
+
+static int janet_method_cache_site(uint32_t instr) {
+    uint32_t op = instr & 0x7F;
+    return op == JOP_CALL || op == JOP_TAILCALL || op == JOP_GET;
+}
+
+static JanetMethodCache *janet_method_cache_init(JanetFuncDef *def) {
+    int32_t count = 0;
+    for (int32_t i = 0; i < def->bytecode_length; i++) {
+        count += janet_method_cache_site(def->bytecode[i]);
+    }
+    JanetMethodCache *cache = janet_malloc(sizeof(JanetMethodCache)
+                                           + count * sizeof(JanetMethodCacheEntry)
+                                           + def->bytecode_length * sizeof(int32_t));
+    if (NULL == cache) {
+        JANET_OUT_OF_MEMORY;
+    }
+    cache->entries = (JanetMethodCacheEntry *)(cache + 1);
+    cache->slots = (int32_t *)(cache->entries + count);
+    memset(cache->entries, 0, count * sizeof(JanetMethodCacheEntry));
+    count = 0;
+    for (int32_t i = 0; i < def->bytecode_length; i++) {
+        cache->slots[i] = janet_method_cache_site(def->bytecode[i]) ? count++ : -1;
+    }
+    def->method_cache = cache;
+    return cache;
+}
+
+/* Same as janet_get(ds, key) for a keyword key, but consults the inline
+ * cache for the instruction at pc first. Hits do no hashing at all. */
+static Janet janet_method_cache_get(JanetFuncDef *def, const uint32_t *pc, Janet ds, Janet key) {
+    JanetMethodCache *cache = def->method_cache;
+    const uint8_t *name = janet_unwrap_keyword(key);
+    const void *receiver;
+    if (janet_checktype(ds, JANET_TABLE)) {
+        receiver = janet_unwrap_table(ds);
+    } else if (janet_checktype(ds, JANET_STRUCT)) {
+        receiver = janet_unwrap_struct(ds);
+    } else {
+        return janet_get(ds, key);
+    }
+    if (NULL == cache) cache = janet_method_cache_init(def);
+    int32_t slot = cache->slots[pc - def->bytecode];
+    if (slot < 0) return janet_get(ds, key);
+    JanetMethodCacheEntry *entry = cache->entries + slot;
+
+    /* Check for a hit */
+    if (entry->receiver == receiver &&
+            entry->name == name &&
+            entry->epoch == janet_vm.method_cache_epoch) {
+        const JanetTable *t = receiver;
+        int32_t i;
+        for (i = 0; i < entry->depth; i++, t = t->proto) {
+            if (NULL == t || t->version != entry->versions[i]) break;
+        }
+        if (i == entry->depth) return entry->value;
+    }
+
+    /* Miss - do a normal lookup while recording the prototype chain */
+    Janet value;
+    int32_t depth = 0;
+    if (janet_checktype(ds, JANET_TABLE)) {
+        value = janet_wrap_nil();
+        JanetTable *t = janet_unwrap_table(ds);
+        for (int i = JANET_MAX_PROTO_DEPTH; t && i; t = t->proto, --i) {
+            if (depth < JANET_METHOD_CACHE_DEPTH) entry->versions[depth] = t->version;
+            depth++;
+            JanetKV *bucket = janet_table_find(t, key);
+            if (NULL != bucket && !janet_checktype(bucket->key, JANET_NIL)) {
+                value = bucket->value;
+                break;
+            }
+        }
+    } else {
+        /* Structs and their prototypes are immutable */
+        value = janet_struct_get(janet_unwrap_struct(ds), key);
+    }
+    if (depth <= JANET_METHOD_CACHE_DEPTH) {
+        entry->receiver = receiver;
+        entry->name = name;
+        entry->value = value;
+        entry->epoch = janet_vm.method_cache_epoch;
+        entry->depth = depth;
+    } else {
+        entry->receiver = NULL;
+    }
+    return value;
+}
+
 /* Get a callable from a keyword method name and ensure that it is valid. */
-static Janet resolve_method(Janet name, JanetFiber *fiber) {
+static Janet resolve_method(Janet name, JanetFiber *fiber, JanetFuncDef *def, const uint32_t *pc) {
     int32_t argc = fiber->stacktop - fiber->stackstart;
     if (argc < 1) janet_panicf("method call (%v) takes at least 1 argument, got 0", name);
-    Janet callee = method_to_fun(name, fiber->data[fiber->stackstart]);
+    Janet callee = janet_method_cache_get(def, pc, fiber->data[fiber->stackstart], name);
     if (janet_checktype(callee, JANET_NIL))
         janet_panicf("unknown method %v invoked on %v", name, fiber->data[fiber->stackstart]);
     return callee;
@@ -333,6 +570,15 @@ static Janet janet_binop_call(const char *lmethod, const char *rmethod, Janet lh
 static JanetSignal janet_check_can_resume(JanetFiber *fiber, Janet *out, int is_cancel);
 static JanetSignal janet_continue_no_check(JanetFiber *fiber, Janet in, Janet *out);
 
+/* Get how far a switch instruction moves the pc for the value x. Keys found
+ * in the constant struct go to their jump in the table after the default
+ * jump, and everything else goes to the default jump. */
+static int32_t vm_switch_offset(JanetFuncDef *def, uint32_t instr, Janet x) {
+    JanetStruct st = janet_unwrap_struct(def->constants[instr >> 16]);
+    Janet index = janet_struct_get(st, x);
+    return janet_checktype(index, JANET_NIL) ? 1 : 2 + janet_unwrap_integer(index);
+}
+
 /* Interpreter main loop */
 static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
 
@@ -416,20 +662,20 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
         &&label_JOP_NOT_EQUALS,
         &&label_JOP_NOT_EQUALS_IMMEDIATE,
         &&label_JOP_CANCEL,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
-        &&label_unknown_op,
+        &&label_JOP_LESS_THAN_JUMP_IF_NOT,
+        &&label_JOP_LESS_THAN_EQUAL_JUMP_IF_NOT,
+        &&label_JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT,
+        &&label_JOP_GREATER_THAN_JUMP_IF_NOT,
+        &&label_JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT,
+        &&label_JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT,
+        &&label_JOP_EQUALS_JUMP_IF_NOT,
+        &&label_JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT,
+        &&label_JOP_NOT_EQUALS_JUMP_IF_NOT,
+        &&label_JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT,
+        &&label_JOP_LOAD_CONSTANT_PUSH,
+        &&label_JOP_LOAD_INTEGER_GET,
+        &&label_JOP_LOAD_INTEGER_IN,
+        &&label_JOP_SWITCH,
         &&label_unknown_op,
         &&label_unknown_op,
         &&label_unknown_op,
@@ -812,13 +1058,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
     vm_next();
 
     VM_OP(JOP_JUMP_IF_NOT)
-    if (janet_truthy(stack[A])) {
-        pc++;
-    } else {
-        vm_maybe_auto_suspend(ES <= 0);
-        pc += ES;
-    }
-    vm_next();
+    vm_jump_if_not();
 
     VM_OP(JOP_JUMP_IF_NIL)
     if (janet_checktype(stack[A], JANET_NIL)) {
@@ -872,6 +1112,44 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
     stack[A] = janet_wrap_boolean(!janet_checktype(stack[B], JANET_NUMBER) || (janet_unwrap_number(stack[B]) != (double) CS));
     vm_pcnext();
 
+    VM_OP(JOP_LESS_THAN_JUMP_IF_NOT)
+    vm_compop_jump( <);
+
+    VM_OP(JOP_LESS_THAN_EQUAL_JUMP_IF_NOT)
+    vm_compop_jump( <=);
+
+    VM_OP(JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT)
+    vm_compop_imm_jump( <);
+
+    VM_OP(JOP_GREATER_THAN_JUMP_IF_NOT)
+    vm_compop_jump( >);
+
+    VM_OP(JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT)
+    vm_compop_jump( >=);
+
+    VM_OP(JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT)
+    vm_compop_imm_jump( >);
+
+    VM_OP(JOP_EQUALS_JUMP_IF_NOT)
+    stack[A] = janet_wrap_boolean(janet_equals(stack[B], stack[C]));
+    vm_fuse_next();
+    vm_jump_if_not();
+
+    VM_OP(JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT)
+    stack[A] = janet_wrap_boolean(janet_checktype(stack[B], JANET_NUMBER) && (janet_unwrap_number(stack[B]) == (double) CS));
+    vm_fuse_next();
+    vm_jump_if_not();
+
+    VM_OP(JOP_NOT_EQUALS_JUMP_IF_NOT)
+    stack[A] = janet_wrap_boolean(!janet_equals(stack[B], stack[C]));
+    vm_fuse_next();
+    vm_jump_if_not();
+
+    VM_OP(JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT)
+    stack[A] = janet_wrap_boolean(!janet_checktype(stack[B], JANET_NUMBER) || (janet_unwrap_number(stack[B]) != (double) CS));
+    vm_fuse_next();
+    vm_jump_if_not();
+
     VM_OP(JOP_COMPARE)
     stack[A] = janet_wrap_integer(janet_compare(stack[B], stack[C]));
     vm_pcnext();
@@ -912,6 +1190,36 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
     stack[D] = janet_wrap_function(func);
     vm_pcnext();
 
+    VM_OP(JOP_LOAD_CONSTANT_PUSH) {
+        int32_t cindex = (int32_t)E;
+        vm_assert(cindex < func->def->constants_length, "invalid constant");
+        stack[A] = func->def->constants[cindex];
+        vm_fuse_next();
+        janet_fiber_push(fiber, stack[D]);
+        stack = fiber->data + fiber->frame;
+        vm_checkgc_pcnext();
+    }
+
+    VM_OP(JOP_LOAD_INTEGER_GET)
+    stack[A] = janet_wrap_integer(ES);
+    vm_fuse_next();
+    vm_tarray_get(stack[B], stack[C]);
+    vm_commit();
+    stack[A] = janet_get(stack[B], stack[C]);
+    vm_pcnext();
+
+    VM_OP(JOP_LOAD_INTEGER_IN)
+    stack[A] = janet_wrap_integer(ES);
+    vm_fuse_next();
+    vm_tarray_get(stack[B], stack[C]);
+    vm_commit();
+    stack[A] = janet_in(stack[B], stack[C]);
+    vm_pcnext();
+
+    VM_OP(JOP_SWITCH)
+    pc += vm_switch_offset(func->def, *pc, stack[A]);
+    vm_next();
+
     VM_OP(JOP_LOAD_UPVALUE) {
         int32_t eindex = B;
         int32_t vindex = C;
@@ -940,8 +1248,10 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
         vm_assert(janet_env_valid(env), "invalid upvalue environment");
         if (env->offset > 0) {
             env->as.fiber->data[env->offset + vindex] = stack[A];
+            janet_gc_barrier(env->as.fiber);
         } else {
             env->as.values[vindex] = stack[A];
+            janet_gc_barrier(env);
         }
         vm_pcnext();
     }
@@ -1015,7 +1325,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
         }
         if (janet_checktype(callee, JANET_KEYWORD)) {
             vm_commit();
-            callee = resolve_method(callee, fiber);
+            callee = resolve_method(callee, fiber, func->def, pc);
         }
         if (janet_checktype(callee, JANET_FUNCTION)) {
             func = janet_unwrap_function(callee);
@@ -1030,6 +1340,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
             }
             stack = fiber->data + fiber->frame;
             pc = func->def->bytecode;
+            vm_jit_enter();
             vm_checkgc_next();
         } else if (janet_checktype(callee, JANET_CFUNCTION)) {
             vm_commit();
@@ -1055,7 +1366,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
         }
         if (janet_checktype(callee, JANET_KEYWORD)) {
             vm_commit();
-            callee = resolve_method(callee, fiber);
+            callee = resolve_method(callee, fiber, func->def, pc);
         }
         if (janet_checktype(callee, JANET_FUNCTION)) {
             func = janet_unwrap_function(callee);
@@ -1070,6 +1381,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
             }
             stack = fiber->data + fiber->frame;
             pc = func->def->bytecode;
+            vm_jit_enter();
             vm_checkgc_next();
         } else {
             Janet retreg;
@@ -1154,6 +1466,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
     }
 
     VM_OP(JOP_PUT)
+    vm_tarray_put(stack[A], stack[B], stack[C]);
     vm_commit();
     fiber->flags |= JANET_FIBER_RESUME_NO_USEVAL;
     janet_put(stack[A], stack[B], stack[C]);
@@ -1161,6 +1474,7 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
     vm_checkgc_pcnext();
 
     VM_OP(JOP_PUT_INDEX)
+    vm_tarray_put(stack[A], janet_wrap_integer(C), stack[B]);
     vm_commit();
     fiber->flags |= JANET_FIBER_RESUME_NO_USEVAL;
     janet_putindex(stack[A], C, stack[B]);
@@ -1168,21 +1482,29 @@ static JanetSignal run_vm(JanetFiber *fiber, Janet in) {
     vm_checkgc_pcnext();
 
     VM_OP(JOP_IN)
+    vm_tarray_get(stack[B], stack[C]);
     vm_commit();
     stack[A] = janet_in(stack[B], stack[C]);
     vm_pcnext();
 
     VM_OP(JOP_GET)
+    vm_tarray_get(stack[B], stack[C]);
     vm_commit();
-    stack[A] = janet_get(stack[B], stack[C]);
+    if (janet_checktype(stack[C], JANET_KEYWORD)) {
+        stack[A] = janet_method_cache_get(func->def, pc, stack[B], stack[C]);
+    } else {
+        stack[A] = janet_get(stack[B], stack[C]);
+    }
     vm_pcnext();
 
     VM_OP(JOP_GET_INDEX)
+    vm_tarray_get(stack[B], janet_wrap_integer(C));
     vm_commit();
     stack[A] = janet_getindex(stack[B], C);
     vm_pcnext();
 
     VM_OP(JOP_LENGTH)
+    vm_tarray_length(stack[E]);
     vm_commit();
     stack[A] = janet_lengthv(stack[E]);
     vm_pcnext();
@@ -1307,6 +1629,30 @@ JanetSignal janet_step(JanetFiber *fiber, Janet in, Janet *out) {
             nexta = pc + 1;
             nextb = pc + ES;
             break;
+        /* Superinstructions step over the whole pair */
+        case JOP_LESS_THAN_JUMP_IF_NOT:
+        case JOP_LESS_THAN_EQUAL_JUMP_IF_NOT:
+        case JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT:
+        case JOP_GREATER_THAN_JUMP_IF_NOT:
+        case JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT:
+        case JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT:
+        case JOP_EQUALS_JUMP_IF_NOT:
+        case JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT:
+        case JOP_NOT_EQUALS_JUMP_IF_NOT:
+        case JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT:
+            nexta = pc + 2;
+            nextb = pc + 1 + (((int32_t) pc[1]) >> 16);
+            break;
+        case JOP_LOAD_CONSTANT_PUSH:
+        case JOP_LOAD_INTEGER_GET:
+        case JOP_LOAD_INTEGER_IN:
+            nexta = pc + 2;
+            break;
+        case JOP_SWITCH: {
+            Janet *stack = fiber->data + fiber->frame;
+            nexta = pc + vm_switch_offset(janet_stack_frame(stack)->func->def, *pc, stack[(*pc >> 8) & 0xFF]);
+            break;
+        }
     }
     if (nexta) {
         olda = *nexta;
@@ -1529,6 +1875,15 @@ static JanetSignal janet_continue_no_check(JanetFiber *fiber, Janet in, Janet *o
         sig = run_vm(fiber, in);
     }
 
+#ifndef JANET_NO_INTERPRETER_INTERRUPT
+    /* A memory limit that was not reached at a safe point is noticed again
+     * on the next allocation */
+    if (NULL != janet_vm.memory_limit_hit) {
+        janet_vm.memory_limit_hit = NULL;
+        janet_interpreter_interrupt_handled(NULL);
+    }
+#endif
+
     /* Restore */
     if (janet_vm.root_fiber == fiber) janet_vm.root_fiber = NULL;
     janet_fiber_set_status(fiber, sig);
@@ -1603,8 +1958,56 @@ int janet_init(void) {
     janet_vm.weak_blocks = NULL;
     janet_vm.next_collection = 0;
     janet_vm.gc_interval = 0x400000;
+    janet_vm.gc_pause = 0;
     janet_vm.block_count = 0;
     janet_vm.gc_mark_phase = 0;
+    janet_vm.gc_mode = JANET_GC_MODE_FULL;
+    janet_vm.gc_major_due = 0;
+    janet_vm.gc_major_blocks = 0;
+    janet_vm.gc_old_blocks = NULL;
+    janet_vm.gc_remembered = NULL;
+    janet_vm.gc_remembered_count = 0;
+    janet_vm.gc_remembered_capacity = 0;
+    janet_vm.gc_marking = 0;
+    janet_vm.gc_pause_budget = 1000;
+    janet_vm.gc_gray = NULL;
+    janet_vm.gc_gray_count = 0;
+    janet_vm.gc_gray_capacity = 0;
+    memset(&janet_vm.gc_stats, 0, sizeof(janet_vm.gc_stats));
+    memset(janet_vm.gc_old_live, 0, sizeof(janet_vm.gc_old_live));
+    janet_vm.gc_hook = NULL;
+    janet_vm.fiber_stack_cache = NULL;
+    janet_vm.fiber_stack_cache_capacity = 0;
+    janet_vm.fiber_pool = NULL;
+    janet_vm.fiber_pool_count = 0;
+    janet_vm.fiber_pool_limit = JANET_FIBER_POOL_MAX;
+    janet_vm.method_cache_epoch = 1;
+    janet_vm.profiling = 0;
+    janet_vm.profile_funcs = NULL;
+    janet_vm.profile_stacks = NULL;
+    janet_vm.heap_profiling = 0;
+    janet_vm.heap_sampling = 0;
+    janet_vm.heap_sample_interval = JANET_HEAP_SAMPLE_INTERVAL;
+    janet_vm.heap_countdown = JANET_HEAP_SAMPLE_INTERVAL;
+    janet_vm.heap_sample_total = 0;
+    janet_vm.heap_samples = NULL;
+    janet_vm.heap_sample_count = 0;
+    janet_vm.heap_sample_capacity = 0;
+    janet_vm.heap_stacks = NULL;
+    janet_vm.heap_stack_count = 0;
+    janet_vm.heap_stack_capacity = 0;
+    janet_vm.heap_stack_index = NULL;
+    janet_vm.memory_limit_hit = NULL;
+    janet_vm.intern_table = NULL;
+#ifdef JANET_GC_THREADS
+    janet_vm.gc_pool = NULL;
+#endif
+#ifdef JANET_GC_SLAB
+    for (int i = 0; i < JANET_SLAB_CLASSES; i++) {
+        janet_vm.slab_pages[i] = NULL;
+        janet_vm.slab_free[i] = NULL;
+    }
+#endif
 
     janet_symcache_init();
 
@@ -1639,6 +2042,11 @@ int janet_init(void) {
 
     /* Core env */
     janet_vm.core_env = NULL;
+    janet_vm.core_lazy_index = NULL;
+    janet_vm.core_lazy_chunks = NULL;
+    janet_vm.core_lazy_lid = NULL;
+    janet_vm.core_lazy_mid = NULL;
+    janet_vm.core_lazy_pending = 0;
 
     /* Auto suspension */
     janet_vm.auto_suspend = 0;
@@ -1677,14 +2085,24 @@ void janet_sandbox_assert(uint32_t forbidden_flags) {
 
 /* Clear all memory associated with the VM */
 void janet_deinit(void) {
+    janet_vm.profiling = 0;
+    janet_profile_clear();
+    janet_heap_profile_deinit();
     janet_clear_memory();
+    janet_fiber_data_flush();
     janet_symcache_deinit();
     janet_free(janet_vm.roots);
     janet_vm.roots = NULL;
     janet_vm.root_count = 0;
     janet_vm.root_capacity = 0;
     janet_vm.abstract_registry = NULL;
+    janet_vm.intern_table = NULL;
     janet_vm.core_env = NULL;
+    janet_vm.core_lazy_index = NULL;
+    janet_vm.core_lazy_chunks = NULL;
+    janet_vm.core_lazy_lid = NULL;
+    janet_vm.core_lazy_mid = NULL;
+    janet_vm.core_lazy_pending = 0;
     janet_vm.top_dyns = NULL;
     janet_vm.user = NULL;
     janet_free(janet_vm.traversal_base);
@@ -228,16 +228,46 @@ extern "C" {
 #define JANET_NET
 #endif
 
+/* Parallel marking uses the same threads support as the event loop */
+#if defined(JANET_GC_THREADS) && !defined(JANET_EV)
+#undef JANET_GC_THREADS
+#endif
+
 /* Enable or disable large int types (for now 64 bit, maybe 128 / 256 bit integer types) */
 #ifndef JANET_NO_INT_TYPES
 #define JANET_INT_TYPES
 #endif
 
+/* Enable or disable typed arrays */
+#ifndef JANET_NO_TYPED_ARRAY
+#define JANET_TYPED_ARRAY
+#endif
+
+/* Enable or disable memory mapped files */
+#if !defined(JANET_NO_MMAP) && !defined(__EMSCRIPTEN__)
+#define JANET_MMAP
+#endif
+
+/* Enable or disable persistent maps and vectors */
+#ifndef JANET_NO_PERSISTENT
+#define JANET_PERSISTENT
+#endif
+
+/* Enable or disable the json module */
+#ifndef JANET_NO_JSON
+#define JANET_JSON
+#endif
+
 /* Enable or disable epoll on Linux */
 #if defined(JANET_LINUX) && !defined(JANET_EV_NO_EPOLL)
 #define JANET_EV_EPOLL
 #endif
 
+/* io_uring reads and writes are layered on top of epoll */
+#if defined(JANET_EV_IO_URING) && !defined(JANET_EV_EPOLL)
+#undef JANET_EV_IO_URING
+#endif
+
 /* Enable or disable kqueue on BSD */
 #if defined(JANET_BSD) && !defined(JANET_EV_NO_KQUEUE)
 #define JANET_EV_KQUEUE
@@ -321,6 +351,12 @@ extern "C" {
 #endif
 #endif
 
+/* The baseline JIT only has a backend for x86-64 with the System V calling
+ * convention, and generates code for the 64 bit nanboxed value layout. */
+#if defined(JANET_JIT) && !(defined(__x86_64__) && defined(JANET_NANBOX_64) && !defined(JANET_WINDOWS))
+#undef JANET_JIT
+#endif
+
 /* Runtime config constants */
 #ifdef JANET_NO_NANBOX
 #define JANET_NANBOX_BIT 0
@@ -451,6 +487,36 @@ typedef enum {
     JANET_STATUS_ALIVE
 } JanetFiberStatus;
 
+/* Garbage collection strategies */
+typedef enum {
+    JANET_GC_MODE_FULL,
+    JANET_GC_MODE_GENERATIONAL,
+    JANET_GC_MODE_INCREMENTAL
+} JanetGCMode;
+
+/* Number of internal gc memory types, for indexing JanetGCStats.live_bytes */
+#define JANET_GC_MEMORY_TYPES 18
+
+/* Garbage collection statistics for one or more collections. Times are in seconds. */
+typedef struct {
+    double mark_time;
+    double sweep_time;
+    size_t bytes_freed;
+    size_t blocks_freed;
+    size_t weak_cleared;
+    size_t threaded_decrefs;
+} JanetGCCycleStats;
+
+typedef struct {
+    size_t collections;
+    JanetGCCycleStats last;
+    JanetGCCycleStats total;
+    /* Approximate bytes owned by live blocks of each memory type after the last sweep */
+    size_t live_bytes[JANET_GC_MEMORY_TYPES];
+} JanetGCStats;
+
+typedef void (*JanetGCHook)(const JanetGCStats *stats);
+
 /* For encapsulating all thread-local Janet state (except natives) */
 typedef struct JanetVM JanetVM;
 
@@ -481,6 +547,8 @@ typedef struct JanetRegExt JanetRegExt;
 typedef struct JanetMethod JanetMethod;
 typedef struct JanetSourceMapping JanetSourceMapping;
 typedef struct JanetSymbolMap JanetSymbolMap;
+typedef struct JanetMethodCache JanetMethodCache;
+typedef struct JanetFuncProfile JanetFuncProfile;
 typedef struct JanetView JanetView;
 typedef struct JanetByteView JanetByteView;
 typedef struct JanetDictView JanetDictView;
@@ -970,6 +1038,7 @@ struct JanetFiber {
     void *ev_state; /* Extra data for ev callback state. On windows, first element must be OVERLAPPED. */
     void *supervisor_channel; /* Channel to push self to when complete */
 #endif
+    void *memory_group; /* Allocations are charged to this group, see fiber/memory-group */
 };
 
 /* Mark if a stack frame is a tail call for debugging */
@@ -1013,6 +1082,7 @@ struct JanetTable {
     int32_t count;
     int32_t capacity;
     int32_t deleted;
+    uint32_t version; /* Bumped whenever a key or the prototype changes */
     JanetKV *data;
     JanetTable *proto;
 };
@@ -1070,6 +1140,8 @@ struct JanetAbstractHead {
 #define JANET_FUNCDEF_FLAG_HASSOURCEMAP 0x800000
 #define JANET_FUNCDEF_FLAG_STRUCTARG 0x1000000
 #define JANET_FUNCDEF_FLAG_HASCLOBITSET 0x2000000
+#define JANET_FUNCDEF_FLAG_MAPPED 0x4000000
+#define JANET_FUNCDEF_FLAG_INLINE 0x8000000
 #define JANET_FUNCDEF_FLAG_TAG 0xFFFF
 
 /* Source mapping structure for a bytecode instruction */
@@ -1101,6 +1173,18 @@ struct JanetFuncDef {
     JanetString name;
     JanetSymbolMap *symbolmap;
 
+    /* Lazily allocated inline caches for method call sites */
+    JanetMethodCache *method_cache;
+
+    /* Counters for debug/profile, or NULL */
+    JanetFuncProfile *profile;
+
+#ifdef JANET_JIT
+    void *jit; /* Native code for this funcdef, or NULL */
+    size_t jit_size;
+    int32_t jit_calls; /* Calls left until compiled, or negative if not compilable */
+#endif
+
     int32_t flags;
     int32_t slotcount; /* The amount of stack space required for the function */
     int32_t arity; /* Not including varargs */
@@ -1389,6 +1473,20 @@ enum JanetOpCode {
     JOP_NOT_EQUALS,
     JOP_NOT_EQUALS_IMMEDIATE,
     JOP_CANCEL,
+    JOP_LESS_THAN_JUMP_IF_NOT,
+    JOP_LESS_THAN_EQUAL_JUMP_IF_NOT,
+    JOP_LESS_THAN_IMMEDIATE_JUMP_IF_NOT,
+    JOP_GREATER_THAN_JUMP_IF_NOT,
+    JOP_GREATER_THAN_EQUAL_JUMP_IF_NOT,
+    JOP_GREATER_THAN_IMMEDIATE_JUMP_IF_NOT,
+    JOP_EQUALS_JUMP_IF_NOT,
+    JOP_EQUALS_IMMEDIATE_JUMP_IF_NOT,
+    JOP_NOT_EQUALS_JUMP_IF_NOT,
+    JOP_NOT_EQUALS_IMMEDIATE_JUMP_IF_NOT,
+    JOP_LOAD_CONSTANT_PUSH,
+    JOP_LOAD_INTEGER_GET,
+    JOP_LOAD_INTEGER_IN,
+    JOP_SWITCH,
     JOP_INSTRUCTION_COUNT
 };
 
@@ -1403,6 +1501,13 @@ extern enum JanetInstructionType janet_instructions[JOP_INSTRUCTION_COUNT];
 
 extern JANET_API const JanetAbstractType janet_stream_type;
 extern JANET_API const JanetAbstractType janet_channel_type;
+extern JANET_API const JanetAbstractType janet_ring_channel_type;
+extern JANET_API const JanetAbstractType janet_stream_reader_type;
+extern JANET_API const JanetAbstractType janet_shared_type;
+
+/* Copy an immutable value into memory that can be shared between threads */
+JANET_API void *janet_shared_freeze(Janet x);
+JANET_API Janet janet_shared_value(void *shared);
 
 /* Run the event loop */
 JANET_API void janet_loop(void);
@@ -1533,6 +1638,7 @@ typedef void (*JanetThreadedCallback)(JanetEVGenericMessage return_value);
 
 /* API calls for quickly offloading some work in C to a new thread or thread pool. */
 JANET_API void janet_ev_threaded_call(JanetThreadedSubroutine fp, JanetEVGenericMessage arguments, JanetThreadedCallback cb);
+JANET_API void janet_ev_threaded_pool_size(int32_t max_threads);
 JANET_NO_RETURN JANET_API void janet_ev_threaded_await(JanetThreadedSubroutine fp, int tag, int argi, void *argp);
 
 /* Post callback + userdata to an event loop. Takes the vm parameter to allow posting from other
@@ -1554,11 +1660,19 @@ JANET_NO_RETURN JANET_API void janet_ev_recvfrom(JanetStream *stream, JanetBuffe
 /* Write async to a stream */
 JANET_NO_RETURN JANET_API void janet_ev_write_buffer(JanetStream *stream, JanetBuffer *buf);
 JANET_NO_RETURN JANET_API void janet_ev_write_string(JanetStream *stream, JanetString str);
+JANET_NO_RETURN JANET_API void janet_ev_write_bytes(JanetStream *stream, Janet bytes);
+
+/* Move bytes from a file at an offset, or from a stream, with as little copying as possible.
+ * A count of -1 moves everything up to the end of the source. */
+JANET_NO_RETURN JANET_API void janet_ev_sendfile(JanetStream *stream, JanetHandle file, int64_t offset, int64_t count);
+JANET_NO_RETURN JANET_API void janet_ev_splice(JanetStream *dest, JanetStream *src, int64_t count);
 #ifdef JANET_NET
 JANET_NO_RETURN JANET_API void janet_ev_send_buffer(JanetStream *stream, JanetBuffer *buf, int flags);
 JANET_NO_RETURN JANET_API void janet_ev_send_string(JanetStream *stream, JanetString str, int flags);
+JANET_NO_RETURN JANET_API void janet_ev_send_bytes(JanetStream *stream, Janet bytes, int flags);
 JANET_NO_RETURN JANET_API void janet_ev_sendto_buffer(JanetStream *stream, JanetBuffer *buf, void *dest, int flags);
 JANET_NO_RETURN JANET_API void janet_ev_sendto_string(JanetStream *stream, JanetString str, void *dest, int flags);
+JANET_NO_RETURN JANET_API void janet_ev_sendto_bytes(JanetStream *stream, Janet bytes, void *dest, int flags);
 #endif
 
 #endif
@@ -1568,6 +1682,7 @@ extern JANET_API const JanetAbstractType janet_parser_type;
 JANET_API void janet_parser_init(JanetParser *parser);
 JANET_API void janet_parser_deinit(JanetParser *parser);
 JANET_API void janet_parser_consume(JanetParser *parser, uint8_t c);
+JANET_API int32_t janet_parser_consume_bytes(JanetParser *parser, const uint8_t *bytes, int32_t len);
 JANET_API enum JanetParserStatus janet_parser_status(JanetParser *parser);
 JANET_API Janet janet_parser_produce(JanetParser *parser);
 JANET_API Janet janet_parser_produce_wrapped(JanetParser *parser);
@@ -1678,6 +1793,15 @@ JANET_API void janet_buffer_push_u16(JanetBuffer *buffer, uint16_t x);
 JANET_API void janet_buffer_push_u32(JanetBuffer *buffer, uint32_t x);
 JANET_API void janet_buffer_push_u64(JanetBuffer *buffer, uint64_t x);
 
+/* Byte slices */
+typedef struct {
+    Janet parent;
+    int32_t offset;
+    int32_t length;
+} JanetByteSlice;
+extern JANET_API const JanetAbstractType janet_byteslice_type;
+JANET_API JanetByteSlice *janet_byteslice(Janet parent, int32_t offset, int32_t length);
+
 /* Tuple */
 
 #define JANET_TUPLE_FLAG_BRACKETCTOR 0x10000
@@ -1692,11 +1816,13 @@ JANET_API void janet_buffer_push_u64(JanetBuffer *buffer, uint64_t x);
 JANET_API Janet *janet_tuple_begin(int32_t length);
 JANET_API JanetTuple janet_tuple_end(Janet *tuple);
 JANET_API JanetTuple janet_tuple_n(const Janet *values, int32_t n);
+JANET_API JanetTuple janet_tuple_intern(JanetTuple tuple);
 
 /* String/Symbol functions */
 #define janet_string_head(s) ((JanetStringHead *)((char *)s - offsetof(JanetStringHead, data)))
 #define janet_string_length(s) (janet_string_head(s)->length)
-#define janet_string_hash(s) (janet_string_head(s)->hash)
+#define JANET_STRING_FLAG_HASHED 0x10000
+JANET_API int32_t janet_string_hash(JanetString s);
 JANET_API uint8_t *janet_string_begin(int32_t length);
 JANET_API JanetString janet_string_end(uint8_t *str);
 JANET_API JanetString janet_string(const uint8_t *buf, int32_t len);
@@ -1721,6 +1847,16 @@ JANET_API JanetSymbol janet_symbol_gen(void);
 #define janet_symbolv(str, len) janet_wrap_symbol(janet_symbol((str), (len)))
 #define janet_csymbolv(cstr) janet_wrap_symbol(janet_csymbol(cstr))
 
+/* Statistics for the symbol cache of the current thread */
+typedef struct {
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t deleted;
+    uint32_t max_probe;
+    double average_probe;
+} JanetSymcacheStats;
+JANET_API void janet_symcache_stats(JanetSymcacheStats *stats);
+
 /* Keyword functions */
 #define janet_keyword janet_symbol
 #define janet_ckeyword janet_csymbol
@@ -1741,6 +1877,7 @@ JANET_API Janet janet_struct_get(JanetStruct st, Janet key);
 JANET_API Janet janet_struct_rawget(JanetStruct st, Janet key);
 JANET_API Janet janet_struct_get_ex(JanetStruct st, Janet key, JanetStruct *which);
 JANET_API JanetTable *janet_struct_to_table(JanetStruct st);
+JANET_API JanetStruct janet_struct_intern(JanetStruct st);
 JANET_API const JanetKV *janet_struct_find(JanetStruct st, Janet key);
 
 /* Table functions */
@@ -1795,6 +1932,10 @@ JANET_API JanetModule janet_native(const char *name, JanetString *error);
 /* Marshaling */
 #define JANET_MARSHAL_UNSAFE 0x20000
 #define JANET_MARSHAL_NO_CYCLES 0x40000
+/* When marshalling, lay out strings and bytecode so they can be used in place.
+ * When unmarshalling, let values point into the source bytes, which must then
+ * stay valid and unchanged for as long as the values are alive. */
+#define JANET_MARSHAL_ZEROCOPY 0x80000
 
 JANET_API void janet_marshal(
     JanetBuffer *buf,
@@ -1807,6 +1948,20 @@ JANET_API Janet janet_unmarshal(
     int flags,
     JanetTable *reg,
     const uint8_t **next);
+typedef void (*JanetMarshalWriter)(void *udata, const uint8_t *bytes, size_t len);
+typedef size_t (*JanetUnmarshalReader)(void *udata, uint8_t *dest, size_t len);
+JANET_API size_t janet_marshal_stream(
+    Janet x,
+    JanetTable *rreg,
+    int flags,
+    JanetMarshalWriter writer,
+    void *udata);
+JANET_API Janet janet_unmarshal_stream(
+    JanetUnmarshalReader reader,
+    void *udata,
+    int flags,
+    JanetTable *reg,
+    size_t *unused);
 JANET_API JanetTable *janet_env_lookup(JanetTable *env);
 JANET_API void janet_env_lookup_into(JanetTable *renv, JanetTable *env, const char *prefix, int recurse);
 
@@ -1821,6 +1976,11 @@ JANET_API int janet_gcunrootall(Janet root);
 JANET_API int janet_gclock(void);
 JANET_API void janet_gcunlock(int handle);
 JANET_API void janet_gcpressure(size_t s);
+JANET_API void janet_gcbarrier(void *mem);
+JANET_API void janet_gcsetmode(JanetGCMode mode);
+JANET_API JanetGCMode janet_gcmode(void);
+JANET_API const JanetGCStats *janet_gcstats(void);
+JANET_API JanetGCHook janet_gcsethook(JanetGCHook hook);
 
 /* Functions */
 JANET_API JanetFuncDef *janet_funcdef_alloc(void);
@@ -2201,6 +2361,8 @@ typedef enum {
     RULE_SPLIT,        /* [rule, rule] */
     RULE_NTH,          /* [nth, rule, tag] */
     RULE_ONLY_TAGS,    /* [rule] */
+    RULE_MEMO,         /* [rule, slot] */
+    RULE_SPAN,         /* [lo, hi, rule] (RULE_BETWEEN over a single byte or literal rule) */
 } JanetPegOpcod;
 
 typedef struct {
@@ -2209,6 +2371,8 @@ typedef struct {
     size_t bytecode_len;
     uint32_t num_constants;
     int has_backref;
+    int needs_captures; /* some rule looks at captures while matching */
+    uint32_t *first; /* first-byte sets of rules, see peg.c */
 } JanetPeg;
 
 #endif
@@ -2234,6 +2398,79 @@ JANET_API int janet_scan_uint64(const uint8_t *str, int32_t len, uint64_t *out);
 
 #endif
 
+#ifdef JANET_TYPED_ARRAY
+
+extern JANET_API const JanetAbstractType janet_tarray_type;
+
+typedef enum {
+    JANET_TARRAY_U8,
+    JANET_TARRAY_S8,
+    JANET_TARRAY_U16,
+    JANET_TARRAY_S16,
+    JANET_TARRAY_U32,
+    JANET_TARRAY_S32,
+    JANET_TARRAY_F32,
+    JANET_TARRAY_F64
+} JanetTArrayType;
+
+typedef struct {
+    JanetTArrayType type;
+    int32_t count;
+    union {
+        void *pointer;
+        uint8_t *u8;
+        int8_t *s8;
+        uint16_t *u16;
+        int16_t *s16;
+        uint32_t *u32;
+        int32_t *s32;
+        float *f32;
+        double *f64;
+    } as;
+} JanetTArray;
+
+JANET_API JanetTArray *janet_tarray(JanetTArrayType type, int32_t count);
+JANET_API JanetTArray *janet_gettarray(const Janet *argv, int32_t n);
+JANET_API Janet janet_tarray_get(JanetTArray *ta, int32_t index);
+JANET_API void janet_tarray_set(JanetTArray *ta, int32_t index, double x);
+
+#endif
+
+#ifdef JANET_PERSISTENT
+
+extern JANET_API const JanetAbstractType janet_pmap_type;
+extern JANET_API const JanetAbstractType janet_pvec_type;
+
+/* Persistent hash map. Updates return a new map. */
+typedef struct {
+    int32_t count;
+    int32_t hash;
+    void *root;
+} JanetPMap;
+
+/* Persistent vector. Updates return a new vector. */
+typedef struct {
+    int32_t count;
+    int32_t shift;
+    int32_t hash;
+    void *root;
+    void *tail;
+} JanetPVec;
+
+JANET_API JanetPMap *janet_pmap(void);
+JANET_API JanetPMap *janet_getpmap(const Janet *argv, int32_t n);
+JANET_API Janet janet_pmap_get(const JanetPMap *map, Janet key);
+JANET_API JanetPMap *janet_pmap_put(const JanetPMap *map, Janet key, Janet value);
+JANET_API JanetPMap *janet_pmap_remove(const JanetPMap *map, Janet key);
+JANET_API JanetPVec *janet_pvec(const Janet *items, int32_t n);
+JANET_API JanetPVec *janet_getpvec(const Janet *argv, int32_t n);
+JANET_API Janet janet_pvec_get(const JanetPVec *vec, int32_t index);
+JANET_API JanetPVec *janet_pvec_put(const JanetPVec *vec, int32_t index, Janet x);
+JANET_API JanetPVec *janet_pvec_push(const JanetPVec *vec, Janet x);
+JANET_API JanetPVec *janet_pvec_pop(const JanetPVec *vec);
+
+#endif
+
 /* Custom allocator support */
 JANET_API void *(janet_malloc)(size_t);
 JANET_API void *(janet_realloc)(void *, size_t);